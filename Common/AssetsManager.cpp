@@ -1,14 +1,17 @@
 #include "AssetsManager.h"
+#include "CpuProfiler.h"
 #define STB_IMAGE_IMPLEMENTATION
 #include <stb_image.h>
+#define STB_IMAGE_WRITE_IMPLEMENTATION
+#include <stb_image_write.h>
 
 #define OUTPUT_PARSE_FAILED_RESULT  std::string message = std::system_category().message(hr);\
-            Log::Error("Failed to parse the image: %s, ", path.string().c_str());\
-            Log::Error(message.c_str());\
+            LOG_ERROR("Failed to parse the image: %s, ", path.string().c_str());\
+            LOG_ERROR("%s", message.c_str());\
 
 #define OUTPUT_LOAD_FAILED_RESULT  std::string message = std::system_category().message(hr);\
-            Log::Error("Failed to load the image: %s, ", path.string().c_str());\
-            Log::Error(message.c_str());\
+            LOG_ERROR("Failed to load the image: %s, ", path.string().c_str());\
+            LOG_ERROR("%s", message.c_str());\
 
 namespace AssetsManager
 {
@@ -21,7 +24,7 @@ namespace AssetsManager
         std::ifstream file(path, std::ios::binary);
         if(!file.is_open())
         {
-            Log::Error("File %s dose not exits or is locked", path.string().c_str());
+            LOG_ERROR("File %s dose not exits or is locked", path.string().c_str());
             return nullptr;
         }
 
@@ -32,7 +35,7 @@ namespace AssetsManager
         m_Data = static_cast<uint8_t*>(malloc(m_Size));
         if (m_Data == nullptr)
         {
-            Log::Error("Failed to malloc memory for the file %s", path.string().c_str());
+            LOG_ERROR("Failed to malloc memory for the file %s", path.string().c_str());
             m_Data = nullptr;
             m_Size = 0;
             return false;
@@ -42,7 +45,7 @@ namespace AssetsManager
 
         if (!file.good())
         {
-            Log::Error("Read file %s error", path.string().c_str());
+            LOG_ERROR("Read file %s error", path.string().c_str());
             m_Data = nullptr;
             m_Size = 0;
             return false;
@@ -70,7 +73,7 @@ namespace AssetsManager
         const aiScene* scene = m_Importer.ReadFileFromMemory(blob->GetData(), blob->GetSize(), aiProcess_Triangulate | aiProcess_FlipUVs | aiProcess_GenNormals | aiProcess_CalcTangentSpace | aiProcess_GenBoundingBoxes);
         if(!scene || scene->mFlags & AI_SCENE_FLAGS_INCOMPLETE || !scene->mRootNode)
         {
-            Log::Error("Failed to load model %s", inPath.string().c_str());
+            LOG_ERROR("Failed to load model %s", inPath.string().c_str());
             return false;
         }
 
@@ -106,7 +109,7 @@ namespace AssetsManager
     {
         if(m_Mesh == nullptr || m_Mesh->mNumVertices == 0 || m_Mesh->mNumFaces == 0)
         {
-            Log::Error("Mesh is empty");
+            LOG_ERROR("Mesh is empty");
             return false;
         }
         
@@ -137,7 +140,7 @@ namespace AssetsManager
 
         if(FAILED(hr))
         {
-            Log::Error("Failed to compute meshlets");
+            LOG_ERROR("Failed to compute meshlets");
             return false;
         }
 
@@ -151,7 +154,7 @@ namespace AssetsManager
     {
         if(m_Mesh == nullptr || m_Mesh->mNumVertices == 0 || m_Mesh->mNumFaces == 0)
         {
-            Log::Error("Mesh is empty");
+            LOG_ERROR("Mesh is empty");
             return false;
         }
         
@@ -182,7 +185,7 @@ namespace AssetsManager
 
         if(FAILED(hr))
         {
-            Log::Error("Failed to compute meshlets");
+            LOG_ERROR("Failed to compute meshlets");
             return false;
         }
 
@@ -200,13 +203,53 @@ namespace AssetsManager
 
         if(FAILED(hr))
         {
-            Log::Error("Failed to compute meshlets cull data");
+            LOG_ERROR("Failed to compute meshlets cull data");
             return false;
         }
         
         return true;
     }
 
+    bool Mesh::ComputeLods(uint32_t inLodCount
+                            , float inRatio
+                            , std::vector<uint32_t>& outIndices
+                            , std::vector<MeshLod>& outLods) const
+    {
+        if(m_Mesh == nullptr || m_Mesh->mNumVertices == 0 || m_Indices.empty())
+        {
+            LOG_ERROR("Mesh is empty");
+            return false;
+        }
+
+        std::vector<glm::vec3> positions(m_Mesh->mNumVertices);
+        for(uint32_t i = 0; i < m_Mesh->mNumVertices; i++)
+        {
+            positions[i] = glm::vec3(m_Mesh->mVertices[i].x, m_Mesh->mVertices[i].y, m_Mesh->mVertices[i].z);
+        }
+
+        MeshSimplifier::BuildLodChain(positions, m_Indices, inLodCount, inRatio, outIndices, outLods);
+        if(outLods.size() < inLodCount)
+            LOG_WARNING("Mesh stopped simplifying after %zu of %u levels of detail", outLods.size(), inLodCount);
+        return true;
+    }
+
+    bool Mesh::ComputeClusterDag(ClusterDag& outDag) const
+    {
+        if(m_Mesh == nullptr || m_Mesh->mNumVertices == 0 || m_Indices.empty())
+        {
+            LOG_ERROR("Mesh is empty");
+            return false;
+        }
+
+        std::vector<glm::vec3> positions(m_Mesh->mNumVertices);
+        for(uint32_t i = 0; i < m_Mesh->mNumVertices; i++)
+        {
+            positions[i] = glm::vec3(m_Mesh->mVertices[i].x, m_Mesh->mVertices[i].y, m_Mesh->mVertices[i].z);
+        }
+
+        return outDag.Build(positions, m_Indices);
+    }
+
     void Mesh::GetPositionData(std::vector<glm::vec4> &outPositions) const
     {
         if(m_Mesh == nullptr)
@@ -311,7 +354,7 @@ namespace AssetsManager
                 , &height
                 , &originalChannels))
             {
-                Log::Error("Failed to parse the image: %s, ", path.string().c_str());
+                LOG_ERROR("Failed to parse the image: %s, ", path.string().c_str());
                 return false;
             }
             m_Metadata.width = width;
@@ -334,7 +377,7 @@ namespace AssetsManager
 
             if(bitmap == nullptr)
             {
-                Log::Error("Failed to load the image: %s, ", path.string().c_str());
+                LOG_ERROR("Failed to load the image: %s, ", path.string().c_str());
                 return false;
             }
             
@@ -350,7 +393,7 @@ namespace AssetsManager
         }
         else
         {
-            Log::Error("Texture format %s is not supported", extension.string().c_str());
+            LOG_ERROR("Texture format %s is not supported", extension.string().c_str());
             return false;
         }
         
@@ -364,6 +407,7 @@ namespace AssetsManager
     
     std::shared_ptr<Blob> LoadShaderImmediately(const char* inShaderName)
     {
+        PROFILE_ZONE("LoadShader");
         const std::filesystem::path path = s_ShaderPath / inShaderName;
         std::shared_ptr<Blob> blob = std::make_shared<Blob>();
         if(!blob->ReadBinaryFile(path))
@@ -375,6 +419,7 @@ namespace AssetsManager
 
     std::shared_ptr<Mesh> LoadMeshImmediately(const char* inMeshName)
     {
+        PROFILE_ZONE("LoadMesh");
         const std::filesystem::path path = s_ModelPath / inMeshName;
         std::shared_ptr<Mesh> mesh = std::make_shared<Mesh>();
         if(!mesh->ReadMesh(path))
@@ -386,6 +431,7 @@ namespace AssetsManager
 
     std::shared_ptr<Texture> LoadTextureImmediately(const char* inTextureName, bool sRGB)
     {
+        PROFILE_ZONE("LoadTexture");
         const std::filesystem::path path = s_TexturePath / inTextureName;
         std::shared_ptr<Texture> texture = std::make_shared<Texture>(sRGB);
         if(!texture->ReadTexture(path))
@@ -395,6 +441,26 @@ namespace AssetsManager
         return texture;
     }
 
+    std::shared_ptr<ClusterDag> LoadClusterDagImmediately(const char* inMeshName, const Mesh& inMesh)
+    {
+        PROFILE_ZONE("LoadClusterDag");
+        const std::filesystem::path meshPath = s_ModelPath / inMeshName;
+        const std::filesystem::path bakedPath = std::filesystem::path(meshPath).replace_extension(".cdag");
+        std::shared_ptr<ClusterDag> dag = std::make_shared<ClusterDag>();
+
+        std::error_code error;
+        const bool bakeIsCurrent = std::filesystem::exists(bakedPath, error)
+            && std::filesystem::last_write_time(bakedPath, error) >= std::filesystem::last_write_time(meshPath, error);
+        if(bakeIsCurrent && dag->Load(bakedPath, inMesh.GetVerticesCount(), inMesh.GetIndicesCount()))
+            return dag;
+
+        if(!inMesh.ComputeClusterDag(*dag))
+            return nullptr;
+        // The DAG is still usable when the model folder is read only
+        dag->Save(bakedPath);
+        return dag;
+    }
+
     void ChangeShaderPath(const char* inPath)
     {
         s_ShaderPath = std::filesystem::path(inPath);
@@ -404,4 +470,14 @@ namespace AssetsManager
     {
         return s_ShaderPath;
     }
+
+    bool SaveImagePng(const std::filesystem::path& inPath, uint32_t inWidth, uint32_t inHeight, const void* inData, uint32_t inRowPitch)
+    {
+        if(stbi_write_png(inPath.string().c_str(), (int)inWidth, (int)inHeight, 4, inData, (int)inRowPitch) == 0)
+        {
+            LOG_ERROR("Failed to write the image: %s", inPath.string().c_str());
+            return false;
+        }
+        return true;
+    }
 }
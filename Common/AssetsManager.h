@@ -10,7 +10,9 @@
 
 #include "DirectXMesh.h"
 #include "DirectXTex.h"
+#include "ClusterDag.h"
 #include "Log.h"
+#include "MeshSimplifier.h"
 
 namespace AssetsManager
 {
@@ -58,6 +60,15 @@ namespace AssetsManager
                             , std::vector<DirectX::MeshletTriangle>& outPackedPrimitiveIndices
                             , std::vector<DirectX::CullData>& outMeshletCullData) const;
 
+        // Quadric simplified levels of detail over the vertices of the mesh, each keeping inRatio of the triangles of
+        // the previous one, level 0 is the mesh itself
+        bool            ComputeLods(uint32_t inLodCount
+                            , float inRatio
+                            , std::vector<uint32_t>& outIndices
+                            , std::vector<MeshLod>& outLods) const;
+
+        bool            ComputeClusterDag(ClusterDag& outDag) const;
+
         void            GetPositionData(std::vector<glm::vec4> &outPositions) const;
         
         void            GetTexCoord0Data(std::vector<glm::vec2> &outTexCoords) const;
@@ -109,7 +120,11 @@ namespace AssetsManager
     std::shared_ptr<Blob>           LoadShaderImmediately(const char* inShaderName);
     std::shared_ptr<Mesh>           LoadMeshImmediately(const char* inMeshName);
     std::shared_ptr<Texture>        LoadTextureImmediately(const char* inTextureName, bool sRGB = false);
+    // Reads the DAG baked next to the mesh, or builds and bakes it when the bake is missing or older than the mesh
+    std::shared_ptr<ClusterDag>     LoadClusterDagImmediately(const char* inMeshName, const Mesh& inMesh);
     
     void                            ChangeShaderPath(const char* inPath);
     const std::filesystem::path&    GetShaderPath();
+    // inData holds 8 bit RGBA pixels
+    bool                            SaveImagePng(const std::filesystem::path& inPath, uint32_t inWidth, uint32_t inHeight, const void* inData, uint32_t inRowPitch);
 }
@@ -0,0 +1,33 @@
+#pragma once
+#include <cstdint>
+#include <functional>
+
+// Per-frame counters reported by the resource state trackers of AppBaseDx and AppBaseVk
+struct BarrierStats
+{
+    uint32_t Requested      = 0; // transitions / accesses declared by the passes
+    uint32_t Elided         = 0; // requests already satisfied by the tracked state
+    uint32_t Merged         = 0; // requests folded into a barrier still pending on the same resource
+    uint32_t SplitBarriers  = 0; // begin-only barriers, the end half is counted in Emitted
+    uint32_t Emitted        = 0; // barriers actually recorded into the command list
+    uint32_t Batches        = 0; // ResourceBarrier / vkCmdPipelineBarrier calls
+
+    // Issued one at a time, every request would have been its own barrier call and potential pipeline drain
+    uint32_t GetStallsAvoided() const
+    {
+        return Requested > Batches ? Requested - Batches : 0;
+    }
+
+    bool operator==(const BarrierStats& inOther) const
+    {
+        return Requested == inOther.Requested
+            && Elided == inOther.Elided
+            && Merged == inOther.Merged
+            && SplitBarriers == inOther.SplitBarriers
+            && Emitted == inOther.Emitted
+            && Batches == inOther.Batches;
+    }
+    bool operator!=(const BarrierStats& inOther) const { return !(*this == inOther); }
+};
+
+typedef std::function<void(const BarrierStats&)> BarrierStatsHook;
@@ -0,0 +1,240 @@
+#include "Benchmark.h"
+#include "Log.h"
+#include <algorithm>
+#include <cmath>
+#include <cstdlib>
+#include <fstream>
+
+static std::string EscapeJson(const std::string& inText)
+{
+    std::string escaped;
+    for(char c : inText)
+    {
+        if(c == '"' || c == '\\')
+            escaped.push_back('\\');
+        escaped.push_back(c);
+    }
+    return escaped;
+}
+
+// Reads "inKey": <number> from a line written by WriteJson
+static bool ReadJsonNumber(const std::string& inLine, const char* inKey, double& outValue)
+{
+    const std::string pattern = std::string("\"") + inKey + "\":";
+    const size_t pos = inLine.find(pattern);
+    if(pos == std::string::npos)
+        return false;
+    outValue = strtod(inLine.c_str() + pos + pattern.size(), nullptr);
+    return true;
+}
+
+static bool ReadJsonString(const std::string& inLine, const char* inKey, std::string& outValue)
+{
+    const std::string pattern = std::string("\"") + inKey + "\": \"";
+    size_t pos = inLine.find(pattern);
+    if(pos == std::string::npos)
+        return false;
+    outValue.clear();
+    for(pos += pattern.size(); pos < inLine.size() && inLine[pos] != '"'; ++pos)
+    {
+        if(inLine[pos] == '\\' && pos + 1 < inLine.size())
+            ++pos;
+        outValue.push_back(inLine[pos]);
+    }
+    return true;
+}
+
+void Benchmark::Reset()
+{
+    m_Metrics.clear();
+    m_Samples.clear();
+}
+
+void Benchmark::AddSample(const std::string& inMetric, double inMilliseconds)
+{
+    auto iter = m_Samples.find(inMetric);
+    if(iter == m_Samples.end())
+    {
+        m_Metrics.push_back(inMetric);
+        iter = m_Samples.emplace(inMetric, std::vector<double>()).first;
+    }
+    iter->second.push_back(inMilliseconds);
+}
+
+BenchmarkStatistics Benchmark::ComputeStatistics(std::vector<double> inSamples)
+{
+    BenchmarkStatistics stats;
+    if(inSamples.empty())
+        return stats;
+
+    std::sort(inSamples.begin(), inSamples.end());
+    const auto percentile = [&inSamples](double inPercent)
+    {
+        const size_t rank = static_cast<size_t>(std::ceil(inPercent / 100.0 * static_cast<double>(inSamples.size())));
+        return inSamples[std::min(std::max<size_t>(rank, 1), inSamples.size()) - 1];
+    };
+
+    double sum = 0.0;
+    for(double sample : inSamples)
+        sum += sample;
+
+    stats.Count = static_cast<uint32_t>(inSamples.size());
+    stats.Min = inSamples.front();
+    stats.Max = inSamples.back();
+    stats.Mean = sum / static_cast<double>(inSamples.size());
+    stats.Median = percentile(50.0);
+    stats.P95 = percentile(95.0);
+    stats.P99 = percentile(99.0);
+    return stats;
+}
+
+std::vector<std::pair<std::string, BenchmarkStatistics>> Benchmark::GetStatistics() const
+{
+    std::vector<std::pair<std::string, BenchmarkStatistics>> statistics;
+    for(const std::string& metric : m_Metrics)
+        statistics.emplace_back(metric, ComputeStatistics(m_Samples.at(metric)));
+    return statistics;
+}
+
+// Reports call Log::Info directly, LOG_INFO is compiled out of Release builds
+void Benchmark::LogReport() const
+{
+    for(const auto& [metric, stats] : GetStatistics())
+    {
+        Log::Info("[Benchmark] %-24s n %u, min %.3f ms, median %.3f ms, p95 %.3f ms, p99 %.3f ms, max %.3f ms"
+            , metric.c_str(), stats.Count, stats.Min, stats.Median, stats.P95, stats.P99, stats.Max);
+    }
+}
+
+bool Benchmark::WriteReport(const std::string& inPath, const std::string& inName, uint32_t inWarmupFrames) const
+{
+    const size_t extension = inPath.rfind('.');
+    const bool csv = extension != std::string::npos && inPath.compare(extension, std::string::npos, ".csv") == 0;
+    const bool written = csv ? WriteCsv(inPath) : WriteJson(inPath, inName, inWarmupFrames);
+    if(written)
+        Log::Info("[Benchmark] Report written to %s", inPath.c_str());
+    return written;
+}
+
+bool Benchmark::WriteJson(const std::string& inPath, const std::string& inName, uint32_t inWarmupFrames) const
+{
+    std::ofstream file(inPath, std::ios::out | std::ios::trunc);
+    if(!file.is_open())
+    {
+        LOG_ERROR("[Benchmark] Failed to open %s", inPath.c_str());
+        return false;
+    }
+
+    const auto statistics = GetStatistics();
+    file << "{\n";
+    file << "  \"name\": \"" << EscapeJson(inName) << "\",\n";
+    file << "  \"warmup\": " << inWarmupFrames << ",\n";
+    file << "  \"metrics\": [\n";
+    for(size_t i = 0; i < statistics.size(); ++i)
+    {
+        // One metric per line, ReadJson relies on it
+        const BenchmarkStatistics& stats = statistics[i].second;
+        file << "    {\"metric\": \"" << EscapeJson(statistics[i].first) << "\""
+            << ", \"count\": " << stats.Count
+            << ", \"min\": " << stats.Min
+            << ", \"mean\": " << stats.Mean
+            << ", \"median\": " << stats.Median
+            << ", \"p95\": " << stats.P95
+            << ", \"p99\": " << stats.P99
+            << ", \"max\": " << stats.Max
+            << "}" << (i + 1 < statistics.size() ? "," : "") << "\n";
+    }
+    file << "  ]\n";
+    file << "}\n";
+    return true;
+}
+
+bool Benchmark::WriteCsv(const std::string& inPath) const
+{
+    std::ofstream file(inPath, std::ios::out | std::ios::trunc);
+    if(!file.is_open())
+    {
+        LOG_ERROR("[Benchmark] Failed to open %s", inPath.c_str());
+        return false;
+    }
+
+    file << "metric,count,min,mean,median,p95,p99,max\n";
+    for(const auto& [metric, stats] : GetStatistics())
+    {
+        file << metric << "," << stats.Count << "," << stats.Min << "," << stats.Mean << "," << stats.Median
+            << "," << stats.P95 << "," << stats.P99 << "," << stats.Max << "\n";
+    }
+    return true;
+}
+
+bool Benchmark::ReadJson(const std::string& inPath, std::unordered_map<std::string, BenchmarkStatistics>& outStatistics)
+{
+    std::ifstream file(inPath);
+    if(!file.is_open())
+    {
+        LOG_ERROR("[Benchmark] Failed to open the baseline %s", inPath.c_str());
+        return false;
+    }
+
+    std::string line;
+    while(std::getline(file, line))
+    {
+        std::string metric;
+        if(!ReadJsonString(line, "metric", metric))
+            continue;
+
+        BenchmarkStatistics stats;
+        double count = 0.0;
+        ReadJsonNumber(line, "count", count);
+        stats.Count = static_cast<uint32_t>(count);
+        ReadJsonNumber(line, "min", stats.Min);
+        ReadJsonNumber(line, "mean", stats.Mean);
+        ReadJsonNumber(line, "median", stats.Median);
+        ReadJsonNumber(line, "p95", stats.P95);
+        ReadJsonNumber(line, "p99", stats.P99);
+        ReadJsonNumber(line, "max", stats.Max);
+        outStatistics[metric] = stats;
+    }
+    return true;
+}
+
+bool Benchmark::CompareWithBaseline(const std::string& inBaselinePath, double inTolerancePercent) const
+{
+    std::unordered_map<std::string, BenchmarkStatistics> baseline;
+    if(!ReadJson(inBaselinePath, baseline))
+        return false;
+
+    const double limit = 1.0 + inTolerancePercent / 100.0;
+    bool passed = true;
+    for(const auto& [metric, stats] : GetStatistics())
+    {
+        auto iter = baseline.find(metric);
+        if(iter == baseline.end())
+        {
+            LOG_WARNING("[Benchmark] %s is not in the baseline", metric.c_str());
+            continue;
+        }
+
+        const BenchmarkStatistics& base = iter->second;
+        const bool regressed = stats.Median > base.Median * limit || stats.P95 > base.P95 * limit;
+        const double medianChange = base.Median > 0.0 ? (stats.Median / base.Median - 1.0) * 100.0 : 0.0;
+        const double p95Change = base.P95 > 0.0 ? (stats.P95 / base.P95 - 1.0) * 100.0 : 0.0;
+        if(regressed)
+        {
+            LOG_ERROR("[Benchmark] %s regressed: median %.3f -> %.3f ms (%+.1f%%), p95 %.3f -> %.3f ms (%+.1f%%)"
+                , metric.c_str(), base.Median, stats.Median, medianChange, base.P95, stats.P95, p95Change);
+            passed = false;
+        }
+        else
+        {
+            Log::Info("[Benchmark] %s ok: median %+.1f%%, p95 %+.1f%%", metric.c_str(), medianChange, p95Change);
+        }
+        baseline.erase(iter);
+    }
+
+    for(const auto& [metric, stats] : baseline)
+        LOG_WARNING("[Benchmark] %s is in the baseline but was not measured", metric.c_str());
+
+    Log::Info("[Benchmark] Baseline comparison %s (tolerance %.1f%%)", passed ? "passed" : "failed", inTolerancePercent);
+    return passed;
+}
@@ -0,0 +1,48 @@
+#pragma once
+#include <cstdint>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+// Collects per frame samples of named metrics (CPU frame time, GPU pass times, ...) during the measured frames of a
+// benchmark run, reduces them to order statistics and exports or compares them. All times are in milliseconds.
+
+struct BenchmarkStatistics
+{
+    uint32_t    Count = 0;
+    double      Min = 0.0;
+    double      Mean = 0.0;
+    double      Median = 0.0;
+    double      P95 = 0.0;
+    double      P99 = 0.0;
+    double      Max = 0.0;
+};
+
+class Benchmark
+{
+public:
+    static constexpr const char* s_CpuFrameMetric = "CPU Frame";
+
+    void Reset();
+    void AddSample(const std::string& inMetric, double inMilliseconds);
+    bool IsEmpty() const { return m_Metrics.empty(); }
+
+    // Nearest rank percentiles over the sorted samples
+    static BenchmarkStatistics ComputeStatistics(std::vector<double> inSamples);
+    std::vector<std::pair<std::string, BenchmarkStatistics>> GetStatistics() const;
+
+    void LogReport() const;
+    // Picks CSV or JSON from the extension, only JSON reports can be used as a baseline
+    bool WriteReport(const std::string& inPath, const std::string& inName, uint32_t inWarmupFrames) const;
+    // Fails when the median or p95 of a metric grew by more than inTolerancePercent over the baseline. Metrics that
+    // exist on one side only are reported but do not fail the comparison.
+    bool CompareWithBaseline(const std::string& inBaselinePath, double inTolerancePercent) const;
+
+private:
+    bool WriteJson(const std::string& inPath, const std::string& inName, uint32_t inWarmupFrames) const;
+    bool WriteCsv(const std::string& inPath) const;
+    static bool ReadJson(const std::string& inPath, std::unordered_map<std::string, BenchmarkStatistics>& outStatistics);
+
+    std::vector<std::string>                                m_Metrics;  // in order of the first sample
+    std::unordered_map<std::string, std::vector<double>>    m_Samples;
+};
@@ -168,3 +168,19 @@ void CameraOrthographic::GetViewFrustum(ViewFrustum& outFrustum) const
     outFrustum.Corners[6] = glm::vec3(farPlaneHalfWidth, farPlaneHalfHeight, Far); // far top right
     outFrustum.Corners[7] = glm::vec3(-farPlaneHalfWidth, farPlaneHalfHeight, Far); // far top left
 }
+
+void CameraOrbitPath::Begin(const CameraBase& inCamera, const glm::vec3& inTarget)
+{
+    m_Target = inTarget;
+    m_StartOffset = inCamera.Transform.GetWorldPosition() - inTarget;
+}
+
+void CameraOrbitPath::Apply(CameraBase& outCamera, float inTime) const
+{
+    const float angle = glm::two_pi<float>() * inTime / Period;
+    const glm::vec3 offset = glm::angleAxis(angle, glm::vec3(0, 1, 0)) * m_StartOffset;
+    // LookAt works relative to the current rotation, start from identity so every frame only depends on inTime
+    outCamera.Transform.SetLocalRotation(glm::quat(1.0f, 0.0f, 0.0f, 0.0f));
+    outCamera.Transform.SetWorldPosition(m_Target + offset);
+    outCamera.Transform.LookAt(m_Target);
+}
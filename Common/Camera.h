@@ -60,7 +60,7 @@ public:
     glm::mat4 GetViewMatrix() const ;  // world To view space matrix
     glm::mat4 GetViewProjectionMatrix() const; // world to clip space matrix
     
-    Transform Transform;
+    ::Transform Transform;
     float AspectRatio {16.0f / 9.0f};
     float Near{0.1f};
     float Far{1000.f};
@@ -80,4 +80,19 @@ public:
     glm::mat4 GetProjectionMatrix() const override;
     void GetViewFrustum(ViewFrustum& outFrustum) const override;
     float Size{1};
-};
\ No newline at end of file
+};
+
+// Deterministic camera motion for benchmark runs: orbits the target around the world up axis, keeping the distance
+// and height the camera had when Begin() was called
+class CameraOrbitPath
+{
+public:
+    void Begin(const CameraBase& inCamera, const glm::vec3& inTarget);
+    void Apply(CameraBase& outCamera, float inTime) const;
+
+    float Period{20.0f}; // seconds per revolution
+
+private:
+    glm::vec3 m_Target{0.0f};
+    glm::vec3 m_StartOffset{0.0f};
+};
@@ -0,0 +1,596 @@
+#include "ClusterDag.h"
+#include "Log.h"
+#include "MeshSimplifier.h"
+#include <algorithm>
+#include <fstream>
+#include <numeric>
+
+static constexpr uint32_t s_BakedMagic = 0x47414443; // "CDAG"
+static constexpr uint32_t s_BakedVersion = 3;
+static constexpr uint32_t s_ConeRefineSteps = 32;
+
+struct BakedHeader
+{
+    uint32_t Magic;
+    uint32_t Version;
+    uint32_t SourceVertexCount;
+    uint32_t SourceIndexCount;
+    uint32_t ClusterCount;
+    uint32_t VertexIndexCount;
+    uint32_t PrimitiveCount;
+    uint32_t LevelCount;
+};
+
+// Ritter's approximate bounding sphere, from the two far apart points then grown over the ones left outside
+static glm::vec4 ComputeSphere(const std::vector<glm::vec3>& inPositions, const uint32_t* inVertices, uint32_t inCount)
+{
+    auto farthest = [&](const glm::vec3& inFrom)
+    {
+        uint32_t result = inVertices[0];
+        float distance = -1.0f;
+        for(uint32_t i = 0; i < inCount; ++i)
+        {
+            const glm::vec3 offset = inPositions[inVertices[i]] - inFrom;
+            if(glm::dot(offset, offset) > distance)
+            {
+                distance = glm::dot(offset, offset);
+                result = inVertices[i];
+            }
+        }
+        return inPositions[result];
+    };
+    const glm::vec3 a = farthest(inPositions[inVertices[0]]);
+    const glm::vec3 b = farthest(a);
+    glm::vec3 center = (a + b) * 0.5f;
+    float radius = glm::length(b - a) * 0.5f;
+    for(uint32_t i = 0; i < inCount; ++i)
+    {
+        const glm::vec3& position = inPositions[inVertices[i]];
+        const float distance = glm::length(position - center);
+        if(distance > radius)
+        {
+            const float grownRadius = (radius + distance) * 0.5f;
+            center += (position - center) * ((grownRadius - radius) / distance);
+            radius = grownRadius;
+        }
+    }
+    return glm::vec4(center, radius);
+}
+
+// Smallest cosine of a normal to inAxis, outNormal is that normal
+static float WidestNormal(const std::vector<glm::vec3>& inNormals, const glm::vec3& inAxis, glm::vec3& outNormal)
+{
+    float cutoff = 1.0f;
+    outNormal = inAxis;
+    for(const glm::vec3& normal : inNormals)
+    {
+        const float cosine = glm::dot(normal, inAxis);
+        if(cosine < cutoff)
+        {
+            cutoff = cosine;
+            outNormal = normal;
+        }
+    }
+    return cutoff;
+}
+
+// Starts from the normalized mean of the unit normals of the triangles, then steps toward the widest normal with a
+// shrinking step (Badoiu-Clarkson) and keeps the axis with the largest cutoff, the mean is pulled toward where most
+// normals are rather than the middle of their extent. Zero area triangles never rasterize and are left out, a cone of
+// 90 degrees or more cannot face away from any point.
+static glm::vec4 ComputeNormalCone(const std::vector<glm::vec3>& inNormals)
+{
+    glm::vec3 axis(0.0f);
+    for(const glm::vec3& normal : inNormals)
+        axis += normal;
+    const float length = glm::length(axis);
+    if(inNormals.empty() || length < 1e-6f)
+        return glm::vec4(0.0f);
+    axis /= length;
+
+    glm::vec3 widestNormal;
+    float cutoff = WidestNormal(inNormals, axis, widestNormal);
+    glm::vec3 candidate = axis;
+    for(uint32_t i = 1; i <= s_ConeRefineSteps; ++i)
+    {
+        // Opposite normals, no cone under 90 degrees holds both
+        const glm::vec3 step = candidate + (widestNormal - candidate) / static_cast<float>(i + 1);
+        if(glm::length(step) < 1e-6f)
+            break;
+        candidate = glm::normalize(step);
+        const float candidateCutoff = WidestNormal(inNormals, candidate, widestNormal);
+        if(candidateCutoff > cutoff)
+        {
+            cutoff = candidateCutoff;
+            axis = candidate;
+        }
+    }
+    return cutoff > 0.0f ? glm::vec4(axis, cutoff) : glm::vec4(0.0f);
+}
+
+static glm::vec4 MergeSpheres(const glm::vec4& inA, const glm::vec4& inB)
+{
+    const glm::vec3 offset = glm::vec3(inB) - glm::vec3(inA);
+    const float distance = glm::length(offset);
+    if(distance + inB.w <= inA.w)
+        return inA;
+    if(distance + inA.w <= inB.w)
+        return inB;
+    const float radius = (distance + inA.w + inB.w) * 0.5f;
+    return glm::vec4(glm::vec3(inA) + offset * ((radius - inA.w) / distance), radius);
+}
+
+void ClusterDag::Clear()
+{
+    m_Clusters.clear();
+    m_VertexIndices.clear();
+    m_Primitives.clear();
+    m_CullData.clear();
+    m_Lods.clear();
+    m_LevelCount = 0;
+    m_SourceVertexCount = 0;
+    m_SourceIndexCount = 0;
+}
+
+void ClusterDag::AppendTriangles(uint32_t inCluster, std::vector<uint32_t>& outIndices) const
+{
+    const Cluster& cluster = m_Clusters[inCluster];
+    for(uint32_t p = 0; p < cluster.PrimCount; ++p)
+    {
+        const uint32_t primitive = m_Primitives[cluster.PrimOffset + p];
+        outIndices.push_back(m_VertexIndices[cluster.VertOffset + (primitive & 0x3FF)]);
+        outIndices.push_back(m_VertexIndices[cluster.VertOffset + ((primitive >> 10) & 0x3FF)]);
+        outIndices.push_back(m_VertexIndices[cluster.VertOffset + ((primitive >> 20) & 0x3FF)]);
+    }
+}
+
+glm::vec4 ClusterDag::ComputeBoundingSphere() const
+{
+    if(m_CullData.empty())
+        return glm::vec4(0.0f);
+    glm::vec4 sphere = m_CullData[0].BoundingSphere;
+    for(const CullData& cullData : m_CullData)
+        sphere = MergeSpheres(sphere, cullData.BoundingSphere);
+    return sphere;
+}
+
+uint32_t ClusterDag::AddClusters(const std::vector<glm::vec3>& inPositions, const std::vector<uint32_t>& inIndices)
+{
+    const uint32_t firstCluster = static_cast<uint32_t>(m_Clusters.size());
+    const uint32_t triangleCount = static_cast<uint32_t>(inIndices.size() / 3);
+
+    // Triangles around every vertex, over the vertices the triangles use only
+    std::vector<uint32_t> vertices(inIndices);
+    std::sort(vertices.begin(), vertices.end());
+    vertices.erase(std::unique(vertices.begin(), vertices.end()), vertices.end());
+    std::vector<uint32_t> localIndices(inIndices.size());
+    for(size_t i = 0; i < inIndices.size(); ++i)
+    {
+        localIndices[i] = static_cast<uint32_t>(std::lower_bound(vertices.begin(), vertices.end(), inIndices[i]) - vertices.begin());
+    }
+    const uint32_t vertexCount = static_cast<uint32_t>(vertices.size());
+    std::vector<uint32_t> triangleOffsets(vertexCount + 1, 0);
+    for(uint32_t index : localIndices)
+    {
+        ++triangleOffsets[index + 1];
+    }
+    std::partial_sum(triangleOffsets.begin(), triangleOffsets.end(), triangleOffsets.begin());
+    std::vector<uint32_t> vertexTriangles(localIndices.size());
+    std::vector<uint32_t> cursors(triangleOffsets.begin(), triangleOffsets.end() - 1);
+    for(uint32_t i = 0; i < localIndices.size(); ++i)
+    {
+        vertexTriangles[cursors[localIndices[i]]++] = i / 3;
+    }
+
+    auto centroid = [&](uint32_t inTriangle)
+    {
+        return (inPositions[inIndices[inTriangle * 3]] + inPositions[inIndices[inTriangle * 3 + 1]] + inPositions[inIndices[inTriangle * 3 + 2]]) / 3.0f;
+    };
+
+    std::vector<uint8_t> emitted(triangleCount, 0);
+    std::vector<uint32_t> candidateStamps(triangleCount, UINT32_MAX);
+    std::vector<int32_t> slots(vertexCount, -1);
+    std::vector<uint32_t> clusterVertices;
+    std::vector<uint32_t> clusterTriangles;
+    std::vector<uint32_t> candidates;
+    std::vector<glm::vec3> normals;
+    uint32_t seed = 0;
+    for(uint32_t stamp = 0; ; ++stamp)
+    {
+        while(seed < triangleCount && emitted[seed])
+            ++seed;
+        if(seed == triangleCount)
+            break;
+
+        // Grows from the seed over adjacent triangles, preferring the ones that add the fewest vertices then the ones
+        // closest to the seed, so clusters stay connected and round
+        clusterVertices.clear();
+        clusterTriangles.clear();
+        candidates.clear();
+        const glm::vec3 center = centroid(seed);
+        uint32_t next = seed;
+        while(next != UINT32_MAX)
+        {
+            emitted[next] = 1;
+            clusterTriangles.push_back(next);
+            for(uint32_t k = 0; k < 3; ++k)
+            {
+                const uint32_t vertex = localIndices[next * 3 + k];
+                if(slots[vertex] >= 0)
+                    continue;
+                slots[vertex] = static_cast<int32_t>(clusterVertices.size());
+                clusterVertices.push_back(vertex);
+                for(uint32_t t = triangleOffsets[vertex]; t < triangleOffsets[vertex + 1]; ++t)
+                {
+                    const uint32_t triangle = vertexTriangles[t];
+                    if(!emitted[triangle] && candidateStamps[triangle] != stamp)
+                    {
+                        candidateStamps[triangle] = stamp;
+                        candidates.push_back(triangle);
+                    }
+                }
+            }
+            if(clusterTriangles.size() == s_MaxPrimitives)
+                break;
+
+            next = UINT32_MAX;
+            uint32_t bestNewVertices = 4;
+            float bestDistance = FLT_MAX;
+            for(size_t c = 0; c < candidates.size();)
+            {
+                const uint32_t triangle = candidates[c];
+                if(emitted[triangle])
+                {
+                    candidates[c] = candidates.back();
+                    candidates.pop_back();
+                    continue;
+                }
+                ++c;
+                uint32_t newVertices = 0;
+                for(uint32_t k = 0; k < 3; ++k)
+                {
+                    newVertices += slots[localIndices[triangle * 3 + k]] < 0 ? 1 : 0;
+                }
+                if(clusterVertices.size() + newVertices > s_MaxVertices || newVertices > bestNewVertices)
+                    continue;
+                const glm::vec3 offset = centroid(triangle) - center;
+                const float distance = glm::dot(offset, offset);
+                if(newVertices < bestNewVertices || distance < bestDistance)
+                {
+                    next = triangle;
+                    bestNewVertices = newVertices;
+                    bestDistance = distance;
+                }
+            }
+        }
+
+        Cluster cluster;
+        cluster.VertCount = static_cast<uint32_t>(clusterVertices.size());
+        cluster.VertOffset = static_cast<uint32_t>(m_VertexIndices.size());
+        cluster.PrimCount = static_cast<uint32_t>(clusterTriangles.size());
+        cluster.PrimOffset = static_cast<uint32_t>(m_Primitives.size());
+        for(uint32_t vertex : clusterVertices)
+        {
+            m_VertexIndices.push_back(vertices[vertex]);
+        }
+        normals.clear();
+        for(uint32_t triangle : clusterTriangles)
+        {
+            const uint32_t* tri = &localIndices[triangle * 3];
+            m_Primitives.push_back(static_cast<uint32_t>(slots[tri[0]]) | static_cast<uint32_t>(slots[tri[1]]) << 10 | static_cast<uint32_t>(slots[tri[2]]) << 20);
+            const glm::vec3& a = inPositions[vertices[tri[0]]];
+            const glm::vec3 normal = glm::cross(inPositions[vertices[tri[1]]] - a, inPositions[vertices[tri[2]]] - a);
+            const float area = glm::length(normal);
+            if(area > 0.0f)
+                normals.push_back(normal / area);
+        }
+        m_CullData.push_back(CullData{ComputeSphere(inPositions, &m_VertexIndices[cluster.VertOffset], cluster.VertCount)
+            , ComputeNormalCone(normals)});
+        m_Clusters.push_back(cluster);
+        m_Lods.push_back(ClusterLod{});
+        for(uint32_t vertex : clusterVertices)
+        {
+            slots[vertex] = -1;
+        }
+    }
+    return firstCluster;
+}
+
+std::vector<std::vector<uint32_t>> ClusterDag::GroupClusters(const std::vector<uint32_t>& inClusters, const std::vector<uint32_t>& inWeldedVertices) const
+{
+    // Clusters sharing a position are neighbours, weighted by how many they share
+    std::vector<std::pair<uint32_t, uint32_t>> vertexClusters;
+    for(uint32_t c = 0; c < inClusters.size(); ++c)
+    {
+        const Cluster& cluster = m_Clusters[inClusters[c]];
+        for(uint32_t v = 0; v < cluster.VertCount; ++v)
+        {
+            vertexClusters.emplace_back(inWeldedVertices[m_VertexIndices[cluster.VertOffset + v]], c);
+        }
+    }
+    std::sort(vertexClusters.begin(), vertexClusters.end());
+    vertexClusters.erase(std::unique(vertexClusters.begin(), vertexClusters.end()), vertexClusters.end());
+
+    std::vector<uint64_t> pairs;
+    for(size_t first = 0, last = 0; first < vertexClusters.size(); first = last)
+    {
+        while(last < vertexClusters.size() && vertexClusters[last].first == vertexClusters[first].first)
+            ++last;
+        for(size_t a = first; a < last; ++a)
+        {
+            for(size_t b = a + 1; b < last; ++b)
+            {
+                pairs.push_back(static_cast<uint64_t>(vertexClusters[a].second) << 32 | vertexClusters[b].second);
+            }
+        }
+    }
+    std::sort(pairs.begin(), pairs.end());
+
+    std::vector<std::vector<std::pair<uint32_t, uint32_t>>> neighbours(inClusters.size());
+    for(size_t first = 0, last = 0; first < pairs.size(); first = last)
+    {
+        while(last < pairs.size() && pairs[last] == pairs[first])
+            ++last;
+        const uint32_t a = static_cast<uint32_t>(pairs[first] >> 32);
+        const uint32_t b = static_cast<uint32_t>(pairs[first]);
+        const uint32_t shared = static_cast<uint32_t>(last - first);
+        neighbours[a].emplace_back(b, shared);
+        neighbours[b].emplace_back(a, shared);
+    }
+
+    // Clusters come out of AddClusters in spatial order, each group grows from the first free one over the neighbours
+    // sharing the most with it so groups stay compact and their borders short
+    std::vector<std::vector<uint32_t>> groups;
+    std::vector<uint8_t> grouped(inClusters.size(), 0);
+    std::vector<std::pair<uint32_t, uint32_t>> weights;
+    for(uint32_t seed = 0; seed < inClusters.size(); ++seed)
+    {
+        if(grouped[seed])
+            continue;
+        std::vector<uint32_t> group = {seed};
+        grouped[seed] = 1;
+        while(group.size() < s_GroupSize)
+        {
+            weights.clear();
+            for(uint32_t member : group)
+            {
+                for(const std::pair<uint32_t, uint32_t>& neighbour : neighbours[member])
+                {
+                    if(grouped[neighbour.first])
+                        continue;
+                    auto it = std::find_if(weights.begin(), weights.end(), [&](const auto& inWeight) { return inWeight.first == neighbour.first; });
+                    if(it == weights.end())
+                        weights.push_back(neighbour);
+                    else
+                        it->second += neighbour.second;
+                }
+            }
+            if(weights.empty())
+                break;
+            const auto best = std::max_element(weights.begin(), weights.end(), [](const auto& inLhs, const auto& inRhs) { return inLhs.second < inRhs.second; });
+            group.push_back(best->first);
+            grouped[best->first] = 1;
+        }
+        for(uint32_t& member : group)
+        {
+            member = inClusters[member];
+        }
+        groups.push_back(std::move(group));
+    }
+    return groups;
+}
+
+bool ClusterDag::Build(const std::vector<glm::vec3>& inPositions, const std::vector<uint32_t>& inIndices)
+{
+    Clear();
+    if(inIndices.empty() || inIndices.size() % 3 != 0)
+    {
+        LOG_ERROR("[ClusterDag] The mesh has no triangle list");
+        return false;
+    }
+    m_SourceVertexCount = static_cast<uint32_t>(inPositions.size());
+    m_SourceIndexCount = static_cast<uint32_t>(inIndices.size());
+
+    // Vertices split at attribute seams share a position, they still make the clusters on both sides neighbours
+    std::vector<uint32_t> weldedVertices(inPositions.size());
+    std::vector<uint32_t> order(inPositions.size());
+    std::iota(order.begin(), order.end(), 0u);
+    auto less = [&](uint32_t inLhs, uint32_t inRhs)
+    {
+        const glm::vec3& a = inPositions[inLhs];
+        const glm::vec3& b = inPositions[inRhs];
+        return a.x != b.x ? a.x < b.x : a.y != b.y ? a.y < b.y : a.z < b.z;
+    };
+    std::sort(order.begin(), order.end(), less);
+    for(size_t i = 0; i < order.size(); ++i)
+    {
+        weldedVertices[order[i]] = i > 0 && !less(order[i - 1], order[i]) ? weldedVertices[order[i - 1]] : order[i];
+    }
+
+    AddClusters(inPositions, inIndices);
+    std::vector<uint32_t> pending(m_Clusters.size());
+    std::iota(pending.begin(), pending.end(), 0u);
+    for(uint32_t c : pending)
+    {
+        m_Lods[c] = ClusterLod{m_CullData[c].BoundingSphere, m_CullData[c].BoundingSphere, 0.0f, s_RootError, 0, 0};
+    }
+
+    uint32_t level = 0;
+    std::vector<uint32_t> groupIndices, groupVertices, localIndices, simplified;
+    std::vector<glm::vec3> localPositions;
+    while(pending.size() > 1)
+    {
+        std::vector<uint32_t> next;
+        bool simplifiedAny = false;
+        for(const std::vector<uint32_t>& group : GroupClusters(pending, weldedVertices))
+        {
+            groupIndices.clear();
+            for(uint32_t c : group)
+            {
+                AppendTriangles(c, groupIndices);
+            }
+            groupVertices = groupIndices;
+            std::sort(groupVertices.begin(), groupVertices.end());
+            groupVertices.erase(std::unique(groupVertices.begin(), groupVertices.end()), groupVertices.end());
+            localPositions.resize(groupVertices.size());
+            for(size_t v = 0; v < groupVertices.size(); ++v)
+            {
+                localPositions[v] = inPositions[groupVertices[v]];
+            }
+            localIndices.resize(groupIndices.size());
+            for(size_t i = 0; i < groupIndices.size(); ++i)
+            {
+                localIndices[i] = static_cast<uint32_t>(std::lower_bound(groupVertices.begin(), groupVertices.end(), groupIndices[i]) - groupVertices.begin());
+            }
+
+            // The border of the group is made of open edges of its triangles, the simplifier keeps them in place so
+            // the new clusters still match the neighbouring groups of any level
+            const uint32_t targetIndexCount = static_cast<uint32_t>(groupIndices.size() / 6 * 3);
+            simplified.clear();
+            float error = 0.0f;
+            if(group.size() > 1 && targetIndexCount > 0)
+                MeshSimplifier::Simplify(localPositions, localIndices, targetIndexCount, simplified);
+
+            // A group that barely simplifies, mostly border, waits to be grouped with other neighbours next level
+            if(simplified.empty() || simplified.size() > groupIndices.size() * 85 / 100)
+            {
+                next.insert(next.end(), group.begin(), group.end());
+                continue;
+            }
+            simplifiedAny = true;
+
+            // The quadric error sums squared distances to many planes, the distance of the group's vertices to the
+            // simplified triangles is much tighter
+            float meanError;
+            MeshSimplifier::MeasureError(localPositions, localIndices, simplified.data(), static_cast<uint32_t>(simplified.size()), error, meanError);
+
+            glm::vec4 sphere = m_Lods[group[0]].LodSphere;
+            float childError = 0.0f;
+            for(uint32_t c : group)
+            {
+                sphere = MergeSpheres(sphere, m_Lods[c].LodSphere);
+                childError = std::max(childError, m_Lods[c].LodError);
+            }
+            // Errors add up along the DAG, so a parent is never more accurate than its children
+            const float groupError = childError + error;
+            for(uint32_t c : group)
+            {
+                m_Lods[c].ParentSphere = sphere;
+                m_Lods[c].ParentError = groupError;
+            }
+
+            for(uint32_t& index : simplified)
+            {
+                index = groupVertices[index];
+            }
+            for(uint32_t c = AddClusters(inPositions, simplified); c < m_Clusters.size(); ++c)
+            {
+                m_Lods[c] = ClusterLod{sphere, sphere, groupError, s_RootError, level + 1, 0};
+                next.push_back(c);
+            }
+        }
+        if(!simplifiedAny)
+            break;
+        pending.swap(next);
+        ++level;
+    }
+    m_LevelCount = level + 1;
+    return true;
+}
+
+float ClusterDag::ProjectError(const glm::vec4& inSphere, float inError, const glm::vec3& inCameraPosition, float inErrorScale)
+{
+    if(inError == 0.0f)
+        return 0.0f;
+    if(inError == s_RootError)
+        return FLT_MAX;
+    // Inside the bounds the error could be right in front of the camera
+    const float distance = glm::length(glm::vec3(inSphere) - inCameraPosition) - inSphere.w;
+    return distance > 0.0f ? inError * inErrorScale / distance : FLT_MAX;
+}
+
+bool ClusterDag::IsInCut(const ClusterLod& inLod, const glm::vec3& inCameraPosition, float inErrorScale)
+{
+    return ProjectError(inLod.LodSphere, inLod.LodError, inCameraPosition, inErrorScale) <= 1.0f
+        && ProjectError(inLod.ParentSphere, inLod.ParentError, inCameraPosition, inErrorScale) > 1.0f;
+}
+
+bool ClusterDag::IsBackFacing(const CullData& inCullData, const glm::vec3& inCameraPosition)
+{
+    const glm::vec4& cone = inCullData.NormalCone;
+    const glm::vec4& sphere = inCullData.BoundingSphere;
+    const glm::vec3 offset = glm::vec3(sphere) - inCameraPosition;
+    const float distance = glm::length(offset);
+    if(cone.w <= 0.0f || distance <= sphere.w)
+        return false;
+    // A normal is at most the cone angle from the axis and a direction from the camera into the sphere at most
+    // asin(radius / distance) from the one to its center, both add up to less than 90 degrees when the cosine of the
+    // angle of the center direction to the axis plus the cone angle is over radius / distance
+    const float cosCenter = glm::dot(offset, glm::vec3(cone)) / distance;
+    const float sinCenter = std::sqrt(std::max(0.0f, 1.0f - cosCenter * cosCenter));
+    const float sinCone = std::sqrt(std::max(0.0f, 1.0f - cone.w * cone.w));
+    return distance * (cosCenter * cone.w - sinCenter * sinCone) > sphere.w;
+}
+
+bool ClusterDag::Save(const std::filesystem::path& inPath) const
+{
+    std::ofstream file(inPath, std::ios::binary);
+    if(!file.is_open())
+    {
+        LOG_WARNING("[ClusterDag] Failed to open %s for writing", inPath.string().c_str());
+        return false;
+    }
+
+    const BakedHeader header = {s_BakedMagic, s_BakedVersion, m_SourceVertexCount, m_SourceIndexCount, GetClusterCount()
+        , static_cast<uint32_t>(m_VertexIndices.size()), static_cast<uint32_t>(m_Primitives.size()), m_LevelCount};
+    file.write(reinterpret_cast<const char*>(&header), sizeof(header));
+    file.write(reinterpret_cast<const char*>(m_Clusters.data()), m_Clusters.size() * sizeof(Cluster));
+    file.write(reinterpret_cast<const char*>(m_VertexIndices.data()), m_VertexIndices.size() * sizeof(uint32_t));
+    file.write(reinterpret_cast<const char*>(m_Primitives.data()), m_Primitives.size() * sizeof(uint32_t));
+    file.write(reinterpret_cast<const char*>(m_CullData.data()), m_CullData.size() * sizeof(CullData));
+    file.write(reinterpret_cast<const char*>(m_Lods.data()), m_Lods.size() * sizeof(ClusterLod));
+    if(!file.good())
+    {
+        LOG_WARNING("[ClusterDag] Failed to write %s", inPath.string().c_str());
+        return false;
+    }
+    return true;
+}
+
+bool ClusterDag::Load(const std::filesystem::path& inPath, uint32_t inSourceVertexCount, uint32_t inSourceIndexCount)
+{
+    Clear();
+    std::ifstream file(inPath, std::ios::binary);
+    if(!file.is_open())
+        return false;
+
+    BakedHeader header;
+    file.read(reinterpret_cast<char*>(&header), sizeof(header));
+    if(!file.good() || header.Magic != s_BakedMagic || header.Version != s_BakedVersion
+        || header.SourceVertexCount != inSourceVertexCount || header.SourceIndexCount != inSourceIndexCount)
+    {
+        LOG_INFO("[ClusterDag] %s is out of date", inPath.string().c_str());
+        return false;
+    }
+
+    m_Clusters.resize(header.ClusterCount);
+    m_VertexIndices.resize(header.VertexIndexCount);
+    m_Primitives.resize(header.PrimitiveCount);
+    m_CullData.resize(header.ClusterCount);
+    m_Lods.resize(header.ClusterCount);
+    file.read(reinterpret_cast<char*>(m_Clusters.data()), m_Clusters.size() * sizeof(Cluster));
+    file.read(reinterpret_cast<char*>(m_VertexIndices.data()), m_VertexIndices.size() * sizeof(uint32_t));
+    file.read(reinterpret_cast<char*>(m_Primitives.data()), m_Primitives.size() * sizeof(uint32_t));
+    file.read(reinterpret_cast<char*>(m_CullData.data()), m_CullData.size() * sizeof(CullData));
+    file.read(reinterpret_cast<char*>(m_Lods.data()), m_Lods.size() * sizeof(ClusterLod));
+    if(!file.good())
+    {
+        LOG_WARNING("[ClusterDag] %s is truncated", inPath.string().c_str());
+        Clear();
+        return false;
+    }
+    m_LevelCount = header.LevelCount;
+    m_SourceVertexCount = header.SourceVertexCount;
+    m_SourceIndexCount = header.SourceIndexCount;
+    return true;
+}
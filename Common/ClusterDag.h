@@ -0,0 +1,93 @@
+#pragma once
+#include <cfloat>
+#include <cstdint>
+#include <filesystem>
+#include <vector>
+#include <glm/glm.hpp>
+
+// Hierarchical cluster LOD. The full mesh is split into clusters, neighbouring clusters are grouped, every group is
+// simplified to half its triangles with its border locked and split into new clusters, and so on up to a few roots.
+// The clusters of every level form a DAG: the clusters of a group are the children of the ones built from it, and
+// as borders never move any mix of levels whose groups agree is a crack free surface.
+//
+// A cluster is drawn when its own error is small enough on screen and the one of the group it was simplified into is
+// not. Both tests read the same group bounds and errors from the two sides of an edge of the DAG, and parent bounds
+// contain child bounds with an error at least as large, so every view selects exactly one cut. All arrays are laid
+// out as the mesh shader pipeline reads them, clusters index the vertices of the source mesh.
+class ClusterDag
+{
+public:
+    static constexpr uint32_t   s_MaxVertices = 64;
+    static constexpr uint32_t   s_MaxPrimitives = 124;
+    static constexpr uint32_t   s_GroupSize = 4;
+    static constexpr float      s_RootError = FLT_MAX;
+
+    // Meshlet of Meshlet.hlsli, primitives pack three 10 bit local vertex indices
+    struct Cluster
+    {
+        uint32_t VertCount;
+        uint32_t VertOffset;
+        uint32_t PrimCount;
+        uint32_t PrimOffset;
+    };
+
+    // ClusterLod of Meshlet.hlsli, spheres are xyz center and w radius in the space of the mesh
+    struct ClusterLod
+    {
+        glm::vec4 LodSphere;        // bounds of the group this cluster was built from, its own for level 0
+        glm::vec4 ParentSphere;     // bounds of the group this cluster was simplified in
+        float     LodError;         // object space error of this cluster against the full mesh, 0 for level 0
+        float     ParentError;      // error of the clusters built from its group, s_RootError for roots
+        uint32_t  Level;
+        uint32_t  Padding;
+    };
+
+    // MeshletCullData of Meshlet.hlsli, in the space of the mesh
+    struct CullData
+    {
+        glm::vec4 BoundingSphere;   // bounds of the triangles of the cluster, for frustum culling
+        glm::vec4 NormalCone;       // xyz mean triangle normal, w cosine of the widest angle of a normal to it, 0 never culls
+    };
+
+    bool                    Build(const std::vector<glm::vec3>& inPositions, const std::vector<uint32_t>& inIndices);
+
+    // The baked file remembers the vertex and index counts of its source, Load fails when they differ
+    bool                    Save(const std::filesystem::path& inPath) const;
+    bool                    Load(const std::filesystem::path& inPath, uint32_t inSourceVertexCount, uint32_t inSourceIndexCount);
+
+    // inErrorScale turns an object space error at distance 1 into pixels over the threshold, the CPU side of the cut
+    // test of the amplification shader
+    static float            ProjectError(const glm::vec4& inSphere, float inError, const glm::vec3& inCameraPosition, float inErrorScale);
+    static bool             IsInCut(const ClusterLod& inLod, const glm::vec3& inCameraPosition, float inErrorScale);
+    // Every triangle of the cluster faces away from the camera wherever it is in the bounding sphere, the CPU side of
+    // the normal cone test of the amplification shader
+    static bool             IsBackFacing(const CullData& inCullData, const glm::vec3& inCameraPosition);
+
+    uint32_t                GetClusterCount() const { return static_cast<uint32_t>(m_Clusters.size()); }
+    uint32_t                GetLevelCount() const { return m_LevelCount; }
+    const std::vector<Cluster>&     GetClusters() const { return m_Clusters; }
+    const std::vector<uint32_t>&    GetVertexIndices() const { return m_VertexIndices; }
+    const std::vector<uint32_t>&    GetPrimitives() const { return m_Primitives; }
+    const std::vector<CullData>&    GetCullData() const { return m_CullData; }
+    const std::vector<ClusterLod>&  GetLods() const { return m_Lods; }
+
+    // Triangles of a cluster as indices into the source vertices
+    void                    AppendTriangles(uint32_t inCluster, std::vector<uint32_t>& outIndices) const;
+    // Bounds of the clusters of every level, whatever cut a view selects lies inside
+    glm::vec4               ComputeBoundingSphere() const;
+
+private:
+    void                    Clear();
+    // Splits the triangles into clusters of adjacent triangles, appends them and returns the index of the first one
+    uint32_t                AddClusters(const std::vector<glm::vec3>& inPositions, const std::vector<uint32_t>& inIndices);
+    std::vector<std::vector<uint32_t>> GroupClusters(const std::vector<uint32_t>& inClusters, const std::vector<uint32_t>& inWeldedVertices) const;
+
+    std::vector<Cluster>    m_Clusters;
+    std::vector<uint32_t>   m_VertexIndices;
+    std::vector<uint32_t>   m_Primitives;
+    std::vector<CullData>   m_CullData;
+    std::vector<ClusterLod> m_Lods;
+    uint32_t                m_LevelCount = 0;
+    uint32_t                m_SourceVertexCount = 0;
+    uint32_t                m_SourceIndexCount = 0;
+};
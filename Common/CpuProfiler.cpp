@@ -0,0 +1,124 @@
+#include "CpuProfiler.h"
+#include <cstring>
+#include <thread>
+
+std::mutex CpuProfiler::s_BuffersMutex;
+std::vector<std::unique_ptr<CpuProfiler::ThreadBuffer>> CpuProfiler::s_Buffers;
+
+CpuProfiler::ThreadBuffer& CpuProfiler::GetThreadBuffer()
+{
+    // Buffers stay registered after their thread exits so that its events can still be collected
+    thread_local ThreadBuffer* buffer = nullptr;
+    if(buffer == nullptr)
+    {
+        std::unique_ptr<ThreadBuffer> newBuffer = std::make_unique<ThreadBuffer>();
+        newBuffer->Events.resize(s_EventsPerThread);
+        std::lock_guard<std::mutex> lock(s_BuffersMutex);
+        newBuffer->ThreadId = static_cast<uint32_t>(s_Buffers.size()) + 1; // 0 is used by the GPU scope events
+        buffer = newBuffer.get();
+        s_Buffers.push_back(std::move(newBuffer));
+    }
+    return *buffer;
+}
+
+void CpuProfiler::Record(const char* inName, uint64_t inStartNs, uint64_t inPayload, EEventType inType)
+{
+    ThreadBuffer& buffer = GetThreadBuffer();
+    const uint64_t index = buffer.WriteCount.load(std::memory_order_relaxed);
+    Event& event = buffer.Events[index % s_EventsPerThread];
+    event.Name = inName;
+    event.StartNs = inStartNs;
+    event.Payload = inPayload;
+    event.Type = inType;
+    // Publishes the event to CollectTraceEvents
+    buffer.WriteCount.store(index + 1, std::memory_order_release);
+}
+
+void CpuProfiler::RecordZone(const char* inName, uint64_t inStartNs, uint64_t inEndNs)
+{
+    Record(inName, inStartNs, inEndNs - inStartNs, EEventType::Zone);
+}
+
+void CpuProfiler::RecordCounter(const char* inName, double inValue)
+{
+    uint64_t bits;
+    memcpy(&bits, &inValue, sizeof(bits));
+    Record(inName, GetTraceTimeNs(), bits, EEventType::Counter);
+}
+
+void CpuProfiler::RecordMarker(const char* inName)
+{
+    Record(inName, GetTraceTimeNs(), 0, EEventType::Marker);
+}
+
+void CpuProfiler::SetThreadName(const char* inName)
+{
+    GetThreadBuffer().Name.store(inName, std::memory_order_release);
+}
+
+void CpuProfiler::CollectTraceEvents(std::vector<TraceEvent>& outEvents)
+{
+    std::lock_guard<std::mutex> lock(s_BuffersMutex);
+    for(const std::unique_ptr<ThreadBuffer>& buffer : s_Buffers)
+    {
+        const uint64_t writeCount = buffer->WriteCount.load(std::memory_order_acquire);
+        if(writeCount == 0)
+            continue;
+
+        const char* threadName = buffer->Name.load(std::memory_order_acquire);
+        if(threadName != nullptr)
+        {
+            TraceEvent nameEvent;
+            nameEvent.Name = threadName;
+            nameEvent.Phase = ETracePhase::ThreadName;
+            nameEvent.ThreadId = buffer->ThreadId;
+            outEvents.push_back(std::move(nameEvent));
+        }
+
+        const uint64_t first = writeCount > s_EventsPerThread ? writeCount - s_EventsPerThread : 0;
+        for(uint64_t i = first; i < writeCount; ++i)
+        {
+            const Event& event = buffer->Events[i % s_EventsPerThread];
+            TraceEvent traceEvent;
+            traceEvent.Name = event.Name;
+            traceEvent.ThreadId = buffer->ThreadId;
+            traceEvent.StartNs = event.StartNs;
+            switch(event.Type)
+            {
+            case EEventType::Zone:
+                traceEvent.Phase = ETracePhase::Complete;
+                traceEvent.DurationNs = event.Payload;
+                break;
+            case EEventType::Counter:
+                traceEvent.Phase = ETracePhase::Counter;
+                memcpy(&traceEvent.Value, &event.Payload, sizeof(traceEvent.Value));
+                break;
+            case EEventType::Marker:
+                traceEvent.Phase = ETracePhase::Instant;
+                break;
+            }
+            outEvents.push_back(std::move(traceEvent));
+        }
+    }
+}
+
+double CpuProfiler::MeasureZoneOverheadNs(uint32_t inIterations)
+{
+    if(inIterations == 0)
+        return 0.0;
+
+    double overheadNs = 0.0;
+    std::thread measureThread([inIterations, &overheadNs]()
+    {
+        const uint64_t startNs = GetTraceTimeNs();
+        for(uint32_t i = 0; i < inIterations; ++i)
+        {
+            CpuProfileZone zone("Overhead");
+        }
+        const uint64_t endNs = GetTraceTimeNs();
+        overheadNs = static_cast<double>(endNs - startNs) / static_cast<double>(inIterations);
+        GetThreadBuffer().WriteCount.store(0, std::memory_order_release);
+    });
+    measureThread.join();
+    return overheadNs;
+}
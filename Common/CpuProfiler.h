@@ -0,0 +1,93 @@
+#pragma once
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+#include "TraceEvent.h"
+
+// Scoped CPU zones, counters and markers. Every thread records into its own ring buffer without locks, the events
+// are turned into trace events on demand. Names are stored by pointer and have to outlive the recording, pass string
+// literals. Compiled in when CPU_PROFILER_ENABLED is 1, see the ENABLE_CPU_PROFILER CMake option.
+#ifndef CPU_PROFILER_ENABLED
+#define CPU_PROFILER_ENABLED 0
+#endif
+
+#define CPU_PROFILER_CONCAT_INNER(a, b) a##b
+#define CPU_PROFILER_CONCAT(a, b) CPU_PROFILER_CONCAT_INNER(a, b)
+
+#if CPU_PROFILER_ENABLED
+#define PROFILE_ZONE(name)              CpuProfileZone CPU_PROFILER_CONCAT(profileZone, __LINE__)(name)
+#define PROFILE_FUNCTION()              PROFILE_ZONE(__FUNCTION__)
+#define PROFILE_COUNTER(name, value)    CpuProfiler::RecordCounter(name, static_cast<double>(value))
+#define PROFILE_MARKER(name)            CpuProfiler::RecordMarker(name)
+#define PROFILE_THREAD(name)            CpuProfiler::SetThreadName(name)
+#else
+#define PROFILE_ZONE(name)              ((void)0)
+#define PROFILE_FUNCTION()              ((void)0)
+#define PROFILE_COUNTER(name, value)    ((void)0)
+#define PROFILE_MARKER(name)            ((void)0)
+#define PROFILE_THREAD(name)            ((void)0)
+#endif
+
+class CpuProfiler
+{
+public:
+    static constexpr uint32_t s_EventsPerThread = 1 << 16; // the oldest events of a thread are overwritten beyond that
+
+    static void RecordZone(const char* inName, uint64_t inStartNs, uint64_t inEndNs);
+    static void RecordCounter(const char* inName, double inValue);
+    static void RecordMarker(const char* inName);
+    static void SetThreadName(const char* inName);
+
+    // Copies what every thread recorded so far. Threads still recording may overwrite the oldest events while they
+    // are copied, call it when the frame loop is idle for an exact trace.
+    static void CollectTraceEvents(std::vector<TraceEvent>& outEvents);
+    // Average cost of an empty zone, measured on a short-lived thread whose events are dropped
+    static double MeasureZoneOverheadNs(uint32_t inIterations = 100000);
+
+private:
+    enum class EEventType : uint32_t
+    {
+        Zone,
+        Counter,
+        Marker,
+    };
+
+    struct Event
+    {
+        const char* Name;
+        uint64_t    StartNs;
+        uint64_t    Payload;    // duration of zones, the bits of the double of counters
+        EEventType  Type;
+    };
+
+    struct ThreadBuffer
+    {
+        std::vector<Event>          Events;
+        std::atomic<uint64_t>       WriteCount {0}; // only written by the owning thread
+        std::atomic<const char*>    Name {nullptr};
+        uint32_t                    ThreadId = 0;
+    };
+
+    static ThreadBuffer& GetThreadBuffer();
+    static void Record(const char* inName, uint64_t inStartNs, uint64_t inPayload, EEventType inType);
+
+    // Registration only, recording never takes the lock
+    static std::mutex                                   s_BuffersMutex;
+    static std::vector<std::unique_ptr<ThreadBuffer>>   s_Buffers;
+};
+
+class CpuProfileZone
+{
+public:
+    explicit CpuProfileZone(const char* inName) : m_Name(inName), m_StartNs(GetTraceTimeNs()) { }
+    ~CpuProfileZone() { CpuProfiler::RecordZone(m_Name, m_StartNs, GetTraceTimeNs()); }
+    CpuProfileZone(const CpuProfileZone&) = delete;
+    CpuProfileZone& operator=(const CpuProfileZone&) = delete;
+
+private:
+    const char* m_Name;
+    uint64_t    m_StartNs;
+};
@@ -0,0 +1,128 @@
+#include "DrawSort.h"
+#include <algorithm>
+#include <cstring>
+#include <future>
+#include <thread>
+
+static constexpr uint32_t s_RadixBits = 8;
+static constexpr uint32_t s_RadixSize = 1u << s_RadixBits;
+
+uint32_t DrawKey::DepthBits(float inDepth)
+{
+    inDepth = std::max(inDepth, 0.0f);
+    uint32_t bits;
+    memcpy(&bits, &inDepth, sizeof(bits));
+    return bits;
+}
+
+static uint64_t PackHeader(uint32_t inPass, uint32_t inPipeline)
+{
+    return (static_cast<uint64_t>(inPass & ((1u << DrawKey::s_PassBits) - 1)) << 60)
+        | (static_cast<uint64_t>(inPipeline & ((1u << DrawKey::s_PipelineBits) - 1)) << 48);
+}
+
+uint64_t DrawKey::Opaque(uint32_t inPass, uint32_t inPipeline, uint32_t inMaterial, float inDepth)
+{
+    return PackHeader(inPass, inPipeline)
+        | (static_cast<uint64_t>(inMaterial & ((1u << s_MaterialBits) - 1)) << 32)
+        | DepthBits(inDepth);
+}
+
+uint64_t DrawKey::Transparent(uint32_t inPass, uint32_t inPipeline, uint32_t inMaterial, float inDepth)
+{
+    return PackHeader(inPass, inPipeline)
+        | (static_cast<uint64_t>(~DepthBits(inDepth)) << 16)
+        | (inMaterial & ((1u << s_MaterialBits) - 1));
+}
+
+// Runs inTask(thread, begin, end) over inThreadCount slices of [0, inCount), the calling thread takes the first
+template<typename Task>
+static void ParallelSlices(uint32_t inCount, uint32_t inThreadCount, const Task& inTask)
+{
+    const uint32_t sliceSize = (inCount + inThreadCount - 1) / inThreadCount;
+    std::vector<std::future<void>> futures;
+    futures.reserve(inThreadCount);
+    for(uint32_t t = 1; t < inThreadCount; ++t)
+    {
+        const uint32_t begin = std::min(t * sliceSize, inCount);
+        const uint32_t end = std::min(begin + sliceSize, inCount);
+        futures.push_back(std::async(std::launch::async, [&inTask, t, begin, end]() { inTask(t, begin, end); }));
+    }
+    inTask(0, 0, std::min(sliceSize, inCount));
+    for(auto& future : futures)
+        future.get();
+}
+
+void DrawSorter::Sort(std::vector<uint64_t>& ioKeys, std::vector<uint32_t>& ioValues, uint32_t inThreadCount)
+{
+    const uint32_t count = static_cast<uint32_t>(ioKeys.size());
+    ioValues.resize(count);
+    m_LastPassCount = 0;
+    if(count < 2)
+        return;
+
+    if(inThreadCount == 0)
+        inThreadCount = std::max(std::thread::hardware_concurrency(), 1u);
+    inThreadCount = std::max(std::min(inThreadCount, count / s_MinKeysPerThread), 1u);
+
+    m_ScratchKeys.resize(count);
+    m_ScratchValues.resize(count);
+    m_Histograms.resize(inThreadCount * s_RadixSize);
+
+    // Digits that do not vary are skipped, found once from the bits that differ from the first key
+    uint64_t varying = 0;
+    for(uint64_t key : ioKeys)
+        varying |= key ^ ioKeys[0];
+
+    uint64_t* srcKeys = ioKeys.data();
+    uint32_t* srcValues = ioValues.data();
+    uint64_t* dstKeys = m_ScratchKeys.data();
+    uint32_t* dstValues = m_ScratchValues.data();
+    for(uint32_t shift = 0; shift < 64; shift += s_RadixBits)
+    {
+        if(((varying >> shift) & (s_RadixSize - 1)) == 0)
+            continue;
+
+        std::fill(m_Histograms.begin(), m_Histograms.end(), 0u);
+        ParallelSlices(count, inThreadCount, [&](uint32_t inThread, uint32_t inBegin, uint32_t inEnd)
+        {
+            uint32_t* histogram = &m_Histograms[inThread * s_RadixSize];
+            for(uint32_t i = inBegin; i < inEnd; ++i)
+                ++histogram[(srcKeys[i] >> shift) & (s_RadixSize - 1)];
+        });
+
+        // Exclusive prefix over (digit, thread), slices of a digit keep the order of the threads for stability
+        uint32_t offset = 0;
+        for(uint32_t digit = 0; digit < s_RadixSize; ++digit)
+        {
+            for(uint32_t t = 0; t < inThreadCount; ++t)
+            {
+                const uint32_t digitCount = m_Histograms[t * s_RadixSize + digit];
+                m_Histograms[t * s_RadixSize + digit] = offset;
+                offset += digitCount;
+            }
+        }
+
+        ParallelSlices(count, inThreadCount, [&](uint32_t inThread, uint32_t inBegin, uint32_t inEnd)
+        {
+            uint32_t* offsets = &m_Histograms[inThread * s_RadixSize];
+            for(uint32_t i = inBegin; i < inEnd; ++i)
+            {
+                const uint32_t slot = offsets[(srcKeys[i] >> shift) & (s_RadixSize - 1)]++;
+                dstKeys[slot] = srcKeys[i];
+                dstValues[slot] = srcValues[i];
+            }
+        });
+
+        std::swap(srcKeys, dstKeys);
+        std::swap(srcValues, dstValues);
+        ++m_LastPassCount;
+    }
+
+    // An odd number of passes leaves the result in the scratch buffers
+    if(srcKeys != ioKeys.data())
+    {
+        ioKeys.swap(m_ScratchKeys);
+        ioValues.swap(m_ScratchValues);
+    }
+}
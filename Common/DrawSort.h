@@ -0,0 +1,46 @@
+#pragma once
+#include <cstdint>
+#include <vector>
+
+// 64-bit sort keys of draws, most significant field first, so that sorting the keys orders the draws by render pass,
+// then pipeline, then either material and front to back depth for opaque draws or back to front depth and material
+// for transparent ones:
+//
+//   opaque       pass:4 | pipeline:12 | material:16 | depth:32
+//   transparent  pass:4 | pipeline:12 | ~depth:32   | material:16
+//
+// Depth is the view space distance, positive floats compare like their bits.
+struct DrawKey
+{
+    static constexpr uint32_t s_PassBits = 4;
+    static constexpr uint32_t s_PipelineBits = 12;
+    static constexpr uint32_t s_MaterialBits = 16;
+
+    static uint64_t Opaque(uint32_t inPass, uint32_t inPipeline, uint32_t inMaterial, float inDepth);
+    static uint64_t Transparent(uint32_t inPass, uint32_t inPipeline, uint32_t inMaterial, float inDepth);
+    // Negative depths, behind the camera, clamp to 0
+    static uint32_t DepthBits(float inDepth);
+
+    static uint32_t GetPass(uint64_t inKey) { return static_cast<uint32_t>(inKey >> 60); }
+    static uint32_t GetPipeline(uint64_t inKey) { return static_cast<uint32_t>(inKey >> 48) & ((1u << s_PipelineBits) - 1); }
+};
+
+// LSD radix sort of draw keys carrying a 32-bit payload, usually the index of the draw, 8 bits per pass. Each pass
+// histograms and scatters inThreadCount slices of the keys in parallel and is skipped when every key has the same
+// digit, so keys leaving their high fields at 0 cost fewer passes. The sort is stable.
+class DrawSorter
+{
+public:
+    // 0 picks the hardware concurrency, inputs below s_MinKeysPerThread per thread use fewer threads
+    void Sort(std::vector<uint64_t>& ioKeys, std::vector<uint32_t>& ioValues, uint32_t inThreadCount = 0);
+
+    uint32_t GetLastPassCount() const { return m_LastPassCount; }
+
+    static constexpr uint32_t s_MinKeysPerThread = 16 * 1024;
+
+private:
+    std::vector<uint64_t>   m_ScratchKeys;
+    std::vector<uint32_t>   m_ScratchValues;
+    std::vector<uint32_t>   m_Histograms;       // 256 counters per thread
+    uint32_t                m_LastPassCount = 0;
+};
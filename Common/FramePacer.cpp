@@ -0,0 +1,80 @@
+#include "FramePacer.h"
+#include "CpuProfiler.h"
+#include <thread>
+#ifdef _WIN32
+#include <Windows.h>
+#endif
+
+#ifndef CREATE_WAITABLE_TIMER_HIGH_RESOLUTION
+#define CREATE_WAITABLE_TIMER_HIGH_RESOLUTION 0x00000002
+#endif
+
+FramePacer::FramePacer(double inTargetFrameRate)
+{
+#ifdef _WIN32
+    // Windows 10 1803 and later, the default timer resolution of 15.6 ms is useless for pacing
+    m_WaitableTimer = CreateWaitableTimerExW(nullptr, nullptr, CREATE_WAITABLE_TIMER_HIGH_RESOLUTION, TIMER_ALL_ACCESS);
+    m_SpinThreshold = std::chrono::microseconds(m_WaitableTimer != nullptr ? 500 : 2000);
+#else
+    m_SpinThreshold = std::chrono::microseconds(200);
+#endif
+    SetTargetFrameRate(inTargetFrameRate);
+}
+
+FramePacer::~FramePacer()
+{
+#ifdef _WIN32
+    if(m_WaitableTimer != nullptr)
+        CloseHandle(m_WaitableTimer);
+#endif
+}
+
+void FramePacer::SetTargetFrameRate(double inTargetFrameRate)
+{
+    m_TargetFrameRate = inTargetFrameRate > 0.0 ? inTargetFrameRate : 0.0;
+    m_FrameInterval = m_TargetFrameRate > 0.0
+        ? std::chrono::duration_cast<Clock::duration>(std::chrono::duration<double>(1.0 / m_TargetFrameRate))
+        : Clock::duration(0);
+    m_NextFrame = Clock::now();
+}
+
+void FramePacer::SleepFor(Clock::duration inDuration)
+{
+#ifdef _WIN32
+    if(m_WaitableTimer != nullptr)
+    {
+        // Relative due times are negative, in 100 ns units
+        LARGE_INTEGER dueTime;
+        dueTime.QuadPart = -static_cast<LONGLONG>(std::chrono::duration_cast<std::chrono::nanoseconds>(inDuration).count() / 100);
+        if(SetWaitableTimerEx(m_WaitableTimer, &dueTime, 0, nullptr, nullptr, nullptr, 0))
+        {
+            WaitForSingleObject(m_WaitableTimer, INFINITE);
+            return;
+        }
+    }
+#endif
+    std::this_thread::sleep_for(inDuration);
+}
+
+void FramePacer::WaitForNextFrame()
+{
+    if(m_FrameInterval.count() == 0)
+        return;
+
+    PROFILE_ZONE("FramePacing");
+    Clock::time_point now = Clock::now();
+    if(now >= m_NextFrame)
+    {
+        m_NextFrame = now + m_FrameInterval;
+        return;
+    }
+
+    if(m_NextFrame - now > m_SpinThreshold)
+        SleepFor(m_NextFrame - now - m_SpinThreshold);
+    while((now = Clock::now()) < m_NextFrame)
+        std::this_thread::yield();
+    // An oversleeping timer counts as a late frame as well
+    m_NextFrame += m_FrameInterval;
+    if(m_NextFrame <= now)
+        m_NextFrame = now + m_FrameInterval;
+}
@@ -0,0 +1,33 @@
+#pragma once
+#include <chrono>
+#include <cstdint>
+
+// Holds the frame loop to a target frame rate. Sleeps on a high resolution waitable timer where available and spins
+// the last stretch, so frames start on time without keeping a core busy for the whole interval.
+class FramePacer
+{
+public:
+    explicit FramePacer(double inTargetFrameRate = 0.0);
+    ~FramePacer();
+    FramePacer(const FramePacer&) = delete;
+    FramePacer& operator=(const FramePacer&) = delete;
+
+    // 0 or less runs unlimited
+    void SetTargetFrameRate(double inTargetFrameRate);
+    double GetTargetFrameRate() const { return m_TargetFrameRate; }
+
+    // Blocks until the next frame is due. A frame that ran late starts the schedule over instead of rushing the
+    // following frames to catch up.
+    void WaitForNextFrame();
+
+private:
+    typedef std::chrono::steady_clock Clock;
+
+    void SleepFor(Clock::duration inDuration);
+
+    double              m_TargetFrameRate = 0.0;
+    Clock::duration     m_FrameInterval {0};
+    Clock::time_point   m_NextFrame;
+    Clock::duration     m_SpinThreshold {0};    // left to spin after sleeping, covers the timer granularity
+    void*               m_WaitableTimer = nullptr;
+};
@@ -0,0 +1,221 @@
+#include "GeometryPool.h"
+#include "Log.h"
+#include <algorithm>
+#include <numeric>
+
+void GeometryPool::Init(uint32_t inVertexCapacity, uint32_t inIndexCapacity)
+{
+    m_VertexCapacity = inVertexCapacity;
+    m_IndexCapacity = inIndexCapacity;
+    m_UsedVertices = 0;
+    m_UsedIndices = 0;
+    m_MeshCount = 0;
+    m_FreeVertices.clear();
+    m_FreeIndices.clear();
+    if(inVertexCapacity > 0)
+        m_FreeVertices.push_back({0, inVertexCapacity});
+    if(inIndexCapacity > 0)
+        m_FreeIndices.push_back({0, inIndexCapacity});
+    m_Meshes.clear();
+    m_Alive.clear();
+    m_FreeMeshes.clear();
+}
+
+uint32_t GeometryPool::AllocateRange(std::vector<Range>& ioFree, uint32_t inCount)
+{
+    if(inCount == 0)
+        return 0;
+    for(auto it = ioFree.begin(); it != ioFree.end(); ++it)
+    {
+        if(it->Count < inCount)
+            continue;
+        const uint32_t offset = it->Offset;
+        it->Offset += inCount;
+        it->Count -= inCount;
+        if(it->Count == 0)
+            ioFree.erase(it);
+        return offset;
+    }
+    return UINT32_MAX;
+}
+
+void GeometryPool::FreeRange(std::vector<Range>& ioFree, uint32_t inOffset, uint32_t inCount)
+{
+    if(inCount == 0)
+        return;
+    auto next = std::lower_bound(ioFree.begin(), ioFree.end(), inOffset, [](const Range& inRange, uint32_t inValue) { return inRange.Offset < inValue; });
+    const bool mergePrev = next != ioFree.begin() && (next - 1)->Offset + (next - 1)->Count == inOffset;
+    const bool mergeNext = next != ioFree.end() && inOffset + inCount == next->Offset;
+    if(mergePrev && mergeNext)
+    {
+        (next - 1)->Count += inCount + next->Count;
+        ioFree.erase(next);
+    }
+    else if(mergePrev)
+    {
+        (next - 1)->Count += inCount;
+    }
+    else if(mergeNext)
+    {
+        next->Offset = inOffset;
+        next->Count += inCount;
+    }
+    else
+    {
+        ioFree.insert(next, {inOffset, inCount});
+    }
+}
+
+uint32_t GeometryPool::LargestFree(const std::vector<Range>& inFree)
+{
+    uint32_t largest = 0;
+    for(const Range& range : inFree)
+        largest = std::max(largest, range.Count);
+    return largest;
+}
+
+uint32_t GeometryPool::AddMesh(uint32_t inVertexCount, uint32_t inIndexCount)
+{
+    const uint32_t firstVertex = AllocateRange(m_FreeVertices, inVertexCount);
+    if(firstVertex == UINT32_MAX)
+    {
+        LOG_WARNING("Geometry pool has no free range of %u vertices, %u of %u used", inVertexCount, m_UsedVertices, m_VertexCapacity);
+        return s_InvalidMesh;
+    }
+    const uint32_t firstIndex = AllocateRange(m_FreeIndices, inIndexCount);
+    if(firstIndex == UINT32_MAX)
+    {
+        FreeRange(m_FreeVertices, firstVertex, inVertexCount);
+        LOG_WARNING("Geometry pool has no free range of %u indices, %u of %u used", inIndexCount, m_UsedIndices, m_IndexCapacity);
+        return s_InvalidMesh;
+    }
+
+    uint32_t mesh;
+    if(!m_FreeMeshes.empty())
+    {
+        mesh = m_FreeMeshes.back();
+        m_FreeMeshes.pop_back();
+    }
+    else
+    {
+        mesh = static_cast<uint32_t>(m_Meshes.size());
+        m_Meshes.emplace_back();
+        m_Alive.push_back(0);
+    }
+    m_Meshes[mesh] = {firstVertex, inVertexCount, firstIndex, inIndexCount};
+    m_Alive[mesh] = 1;
+    m_UsedVertices += inVertexCount;
+    m_UsedIndices += inIndexCount;
+    ++m_MeshCount;
+    return mesh;
+}
+
+void GeometryPool::RemoveMesh(uint32_t inMesh)
+{
+    if(!IsValid(inMesh))
+    {
+        LOG_WARNING("Geometry pool has no mesh %u", inMesh);
+        return;
+    }
+    const MeshRange& range = m_Meshes[inMesh];
+    FreeRange(m_FreeVertices, range.FirstVertex, range.VertexCount);
+    FreeRange(m_FreeIndices, range.FirstIndex, range.IndexCount);
+    m_UsedVertices -= range.VertexCount;
+    m_UsedIndices -= range.IndexCount;
+    m_Alive[inMesh] = 0;
+    m_FreeMeshes.push_back(inMesh);
+    --m_MeshCount;
+}
+
+void GeometryPool::Compact(std::vector<Move>& outVertexMoves, std::vector<Move>& outIndexMoves)
+{
+    outVertexMoves.clear();
+    outIndexMoves.clear();
+
+    std::vector<uint32_t> live;
+    live.reserve(m_MeshCount);
+    for(uint32_t i = 0; i < m_Meshes.size(); ++i)
+    {
+        if(m_Alive[i] != 0)
+            live.push_back(i);
+    }
+
+    // Vertices and indices of a mesh may sit in a different order in each buffer, both keep their own
+    auto pack = [&](uint32_t MeshRange::* inFirst, uint32_t MeshRange::* inCount, std::vector<Move>& outMoves)
+    {
+        std::sort(live.begin(), live.end(), [&](uint32_t inLhs, uint32_t inRhs) { return m_Meshes[inLhs].*inFirst < m_Meshes[inRhs].*inFirst; });
+        uint32_t offset = 0;
+        for(uint32_t mesh : live)
+        {
+            MeshRange& range = m_Meshes[mesh];
+            const uint32_t count = range.*inCount;
+            if(count == 0)
+            {
+                range.*inFirst = 0;
+                continue;
+            }
+            Move* last = outMoves.empty() ? nullptr : &outMoves.back();
+            if(last != nullptr && last->SrcOffset + last->Count == range.*inFirst && last->DstOffset + last->Count == offset)
+                last->Count += count;
+            else
+                outMoves.push_back({range.*inFirst, offset, count});
+            range.*inFirst = offset;
+            offset += count;
+        }
+        return offset;
+    };
+    const uint32_t vertexEnd = pack(&MeshRange::FirstVertex, &MeshRange::VertexCount, outVertexMoves);
+    const uint32_t indexEnd = pack(&MeshRange::FirstIndex, &MeshRange::IndexCount, outIndexMoves);
+
+    m_FreeVertices.clear();
+    m_FreeIndices.clear();
+    if(vertexEnd < m_VertexCapacity)
+        m_FreeVertices.push_back({vertexEnd, m_VertexCapacity - vertexEnd});
+    if(indexEnd < m_IndexCapacity)
+        m_FreeIndices.push_back({indexEnd, m_IndexCapacity - indexEnd});
+}
+
+bool GeometryPool::Validate() const
+{
+    auto check = [&](const char* inName, uint32_t MeshRange::* inFirst, uint32_t MeshRange::* inCount, const std::vector<Range>& inFree, uint32_t inCapacity, uint32_t inUsed)
+    {
+        std::vector<Range> ranges(inFree);
+        uint32_t used = 0;
+        for(uint32_t i = 0; i < m_Meshes.size(); ++i)
+        {
+            if(m_Alive[i] != 0 && m_Meshes[i].*inCount > 0)
+            {
+                ranges.push_back({m_Meshes[i].*inFirst, m_Meshes[i].*inCount});
+                used += m_Meshes[i].*inCount;
+            }
+        }
+        std::sort(ranges.begin(), ranges.end(), [](const Range& inLhs, const Range& inRhs) { return inLhs.Offset < inRhs.Offset; });
+
+        // Live and free ranges must tile the buffer exactly
+        uint32_t end = 0;
+        for(const Range& range : ranges)
+        {
+            if(range.Offset != end)
+            {
+                LOG_ERROR("Geometry pool %s range at %u, expected %u", inName, range.Offset, end);
+                return false;
+            }
+            end += range.Count;
+        }
+        if(end != inCapacity || used != inUsed)
+        {
+            LOG_ERROR("Geometry pool %s ranges end at %u with %u used, capacity %u with %u used", inName, end, used, inCapacity, inUsed);
+            return false;
+        }
+        return true;
+    };
+
+    const uint32_t alive = std::accumulate(m_Alive.begin(), m_Alive.end(), 0u);
+    if(alive != m_MeshCount)
+    {
+        LOG_ERROR("Geometry pool has %u live meshes, expected %u", alive, m_MeshCount);
+        return false;
+    }
+    return check("vertex", &MeshRange::FirstVertex, &MeshRange::VertexCount, m_FreeVertices, m_VertexCapacity, m_UsedVertices)
+        && check("index", &MeshRange::FirstIndex, &MeshRange::IndexCount, m_FreeIndices, m_IndexCapacity, m_UsedIndices);
+}
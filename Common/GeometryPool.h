@@ -0,0 +1,79 @@
+#pragma once
+#include <cstdint>
+#include <vector>
+
+// Suballocates the vertices and indices of many meshes from one shared vertex buffer and one shared index buffer, so a
+// single indirect draw can cover different meshes: a command for mesh m uses firstIndex = GetMesh(m).FirstIndex and
+// vertexOffset = GetMesh(m).FirstVertex with the mesh local indices. Only the bookkeeping lives here, in elements of
+// each buffer. The owner creates the buffers with the pool capacities and uploads every mesh to the ranges it gets
+// back, which keeps allocation and compaction checkable without a device.
+class GeometryPool
+{
+public:
+    static constexpr uint32_t s_InvalidMesh = UINT32_MAX;
+
+    struct MeshRange
+    {
+        uint32_t FirstVertex;
+        uint32_t VertexCount;
+        uint32_t FirstIndex;
+        uint32_t IndexCount;
+    };
+
+    // One copy of a compaction, in elements of the buffer it applies to
+    struct Move
+    {
+        uint32_t SrcOffset;
+        uint32_t DstOffset;
+        uint32_t Count;
+    };
+
+    void Init(uint32_t inVertexCapacity, uint32_t inIndexCapacity);
+
+    // First fit in both buffers, s_InvalidMesh when either has no free range large enough. The id stays valid until
+    // RemoveMesh, across compactions.
+    uint32_t AddMesh(uint32_t inVertexCount, uint32_t inIndexCount);
+    void RemoveMesh(uint32_t inMesh);
+
+    // Packs the live meshes at the front of both buffers keeping their order and frees a single range at the end.
+    // The moves copy from the old buffers into new ones, a source and its destination may overlap within one buffer.
+    // Contiguous meshes are merged into one move. The ranges of GetMesh change, commands must be rebuilt.
+    void Compact(std::vector<Move>& outVertexMoves, std::vector<Move>& outIndexMoves);
+
+    // Live ranges inside the capacities without overlap, and live plus free elements adding up to the capacities
+    bool Validate() const;
+
+    bool IsValid(uint32_t inMesh) const { return inMesh < m_Meshes.size() && m_Alive[inMesh] != 0; }
+    const MeshRange& GetMesh(uint32_t inMesh) const { return m_Meshes[inMesh]; }
+    uint32_t GetMeshCount() const { return m_MeshCount; }
+    uint32_t GetVertexCapacity() const { return m_VertexCapacity; }
+    uint32_t GetIndexCapacity() const { return m_IndexCapacity; }
+    uint32_t GetUsedVertices() const { return m_UsedVertices; }
+    uint32_t GetUsedIndices() const { return m_UsedIndices; }
+    // Largest mesh a new AddMesh could fit without compaction
+    uint32_t GetLargestFreeVertices() const { return LargestFree(m_FreeVertices); }
+    uint32_t GetLargestFreeIndices() const { return LargestFree(m_FreeIndices); }
+
+private:
+    struct Range
+    {
+        uint32_t Offset;
+        uint32_t Count;
+    };
+
+    // Free lists are sorted by offset, neighbours are always merged
+    static uint32_t AllocateRange(std::vector<Range>& ioFree, uint32_t inCount);
+    static void FreeRange(std::vector<Range>& ioFree, uint32_t inOffset, uint32_t inCount);
+    static uint32_t LargestFree(const std::vector<Range>& inFree);
+
+    uint32_t                m_VertexCapacity = 0;
+    uint32_t                m_IndexCapacity = 0;
+    uint32_t                m_UsedVertices = 0;
+    uint32_t                m_UsedIndices = 0;
+    uint32_t                m_MeshCount = 0;
+    std::vector<Range>      m_FreeVertices;
+    std::vector<Range>      m_FreeIndices;
+    std::vector<MeshRange>  m_Meshes;
+    std::vector<uint8_t>    m_Alive;
+    std::vector<uint32_t>   m_FreeMeshes;   // ids of removed meshes, reused first
+};
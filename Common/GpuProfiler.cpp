@@ -0,0 +1,146 @@
+#include "GpuProfiler.h"
+#include "Log.h"
+
+void GpuProfiler::Init(double inTicksPerMs, uint64_t inCalibrationTicks, uint64_t inCalibrationNs)
+{
+    m_TicksPerMs = inTicksPerMs;
+    m_CalibrationTicks = inCalibrationTicks;
+    m_CalibrationNs = inCalibrationNs;
+    m_Slots = {};
+    m_FrameIndex = 0;
+    m_FrameOpen = false;
+    m_OverflowReported = false;
+    m_TraceEvents.clear();
+}
+
+void GpuProfiler::BeginFrame()
+{
+    m_CurrentSlot = GetNextSlot();
+    FrameSlot& slot = m_Slots[m_CurrentSlot];
+    if(slot.Pending)
+        LOG_WARNING("[GpuProfiler] Frame %llu was overwritten before it was read back", static_cast<unsigned long long>(slot.FrameIndex));
+
+    slot.Scopes.clear();
+    slot.OpenScopes.clear();
+    slot.QueryCount = 0;
+    slot.FrameIndex = m_FrameIndex;
+    slot.Pending = false;
+    m_FrameOpen = true;
+}
+
+void GpuProfiler::EndFrame()
+{
+    if(!m_FrameOpen)
+        return;
+
+    FrameSlot& slot = m_Slots[m_CurrentSlot];
+    if(!slot.OpenScopes.empty())
+        LOG_WARNING("[GpuProfiler] %zu scopes still open at the end of the frame", slot.OpenScopes.size());
+    slot.Pending = slot.QueryCount > 0;
+    m_FrameOpen = false;
+    ++m_FrameIndex;
+}
+
+uint32_t GpuProfiler::BeginScope(const char* inName)
+{
+    if(!m_FrameOpen)
+        return s_InvalidQuery;
+
+    FrameSlot& slot = m_Slots[m_CurrentSlot];
+    // Keep room for the end timestamp of every scope that is already open
+    if(slot.QueryCount + slot.OpenScopes.size() + 2 > s_QueriesPerFrame)
+    {
+        if(!m_OverflowReported)
+            LOG_WARNING("[GpuProfiler] More than %u scopes in a frame, the rest is not measured", s_MaxScopesPerFrame);
+        m_OverflowReported = true;
+        // Still pushed so that the matching EndScope() pops the right entry
+        slot.OpenScopes.push_back(s_InvalidQuery);
+        return s_InvalidQuery;
+    }
+
+    Scope scope;
+    scope.Name = inName;
+    scope.BeginQuery = slot.QueryCount++;
+    scope.CpuBeginNs = GetTraceTimeNs();
+    slot.OpenScopes.push_back(static_cast<uint32_t>(slot.Scopes.size()));
+    slot.Scopes.push_back(std::move(scope));
+    return GetSlotFirstQuery(m_CurrentSlot) + slot.Scopes.back().BeginQuery;
+}
+
+uint32_t GpuProfiler::EndScope()
+{
+    if(!m_FrameOpen)
+        return s_InvalidQuery;
+
+    FrameSlot& slot = m_Slots[m_CurrentSlot];
+    if(slot.OpenScopes.empty())
+    {
+        LOG_ERROR("[GpuProfiler] EndScope without a matching BeginScope");
+        return s_InvalidQuery;
+    }
+
+    const uint32_t scopeIndex = slot.OpenScopes.back();
+    slot.OpenScopes.pop_back();
+    if(scopeIndex == s_InvalidQuery)
+        return s_InvalidQuery;
+
+    Scope& scope = slot.Scopes[scopeIndex];
+    scope.EndQuery = slot.QueryCount++;
+    scope.CpuEndNs = GetTraceTimeNs();
+    return GetSlotFirstQuery(m_CurrentSlot) + scope.EndQuery;
+}
+
+uint64_t GpuProfiler::TicksToTraceNs(uint64_t inTicks) const
+{
+    const double deltaNs = (static_cast<double>(inTicks) - static_cast<double>(m_CalibrationTicks)) / m_TicksPerMs * 1e6;
+    return static_cast<uint64_t>(static_cast<double>(m_CalibrationNs) + deltaNs);
+}
+
+void GpuProfiler::AddTraceEvent(TraceEvent&& inEvent)
+{
+    if(m_TraceEvents.size() >= s_MaxTraceEvents)
+        m_TraceEvents.erase(m_TraceEvents.begin(), m_TraceEvents.begin() + s_MaxTraceEvents / 2);
+    m_TraceEvents.push_back(std::move(inEvent));
+}
+
+void GpuProfiler::ResolveSlot(uint32_t inSlot, const uint64_t* inTicks)
+{
+    FrameSlot& slot = m_Slots[inSlot];
+    for(const Scope& scope : slot.Scopes)
+    {
+        if(scope.EndQuery == s_InvalidQuery)
+            continue;
+
+        const uint64_t beginTicks = inTicks[scope.BeginQuery];
+        const uint64_t endTicks = inTicks[scope.EndQuery];
+        const uint64_t durationTicks = endTicks > beginTicks ? endTicks - beginTicks : 0;
+        const double durationMs = static_cast<double>(durationTicks) / m_TicksPerMs;
+        if(m_ScopeHook)
+            m_ScopeHook(scope.Name, durationMs);
+
+        TraceEvent cpuEvent;
+        cpuEvent.Name = scope.Name;
+        cpuEvent.ProcessId = TraceEvent::s_CpuProcess;
+        cpuEvent.StartNs = scope.CpuBeginNs;
+        cpuEvent.DurationNs = scope.CpuEndNs - scope.CpuBeginNs;
+        AddTraceEvent(std::move(cpuEvent));
+
+        TraceEvent gpuEvent;
+        gpuEvent.Name = scope.Name;
+        gpuEvent.ProcessId = TraceEvent::s_GpuProcess;
+        gpuEvent.StartNs = TicksToTraceNs(beginTicks);
+        gpuEvent.DurationNs = static_cast<uint64_t>(durationMs * 1e6);
+        AddTraceEvent(std::move(gpuEvent));
+    }
+    slot.Pending = false;
+}
+
+void GpuProfiler::DiscardSlot(uint32_t inSlot)
+{
+    m_Slots[inSlot].Pending = false;
+}
+
+void GpuProfiler::AppendTraceEvents(std::vector<TraceEvent>& outEvents) const
+{
+    outEvents.insert(outEvents.end(), m_TraceEvents.begin(), m_TraceEvents.end());
+}
@@ -0,0 +1,99 @@
+#pragma once
+#include <array>
+#include <cstdint>
+#include <functional>
+#include <string>
+#include <vector>
+
+#include "TraceEvent.h"
+
+// API agnostic half of the GPU profilers in AppBaseDx / AppBaseVk. Hands out timestamp query indices for nested
+// named scopes, keeps s_FrameLatency frames in flight so results are read back without waiting, and converts the
+// resolved ticks into events on the CPU trace clock. The backends own the query pool, which holds
+// s_FrameLatency * s_QueriesPerFrame timestamps, and the readback.
+class GpuProfiler
+{
+public:
+    static constexpr uint32_t s_FrameLatency = 3;           // a frame is read back when its slot comes around again
+    static constexpr uint32_t s_MaxScopesPerFrame = 128;
+    static constexpr uint32_t s_QueriesPerFrame = s_MaxScopesPerFrame * 2;
+    static constexpr uint32_t s_InvalidQuery = UINT32_MAX;
+    static constexpr size_t   s_MaxTraceEvents = 1 << 16;   // the oldest half is dropped beyond that
+
+    // Called for every resolved scope with its GPU time in milliseconds
+    typedef std::function<void(const std::string&, double)> ScopeHook;
+
+    // inTicksPerMs converts timestamps, the calibration pair maps a GPU timestamp onto GetTraceTimeNs()
+    void Init(double inTicksPerMs, uint64_t inCalibrationTicks, uint64_t inCalibrationNs);
+    void SetScopeHook(ScopeHook inHook) { m_ScopeHook = std::move(inHook); }
+    bool IsInitialized() const { return m_TicksPerMs > 0.0; }
+
+    // The slot the next BeginFrame() records into, resolve or discard it first when IsSlotPending()
+    uint32_t GetNextSlot() const { return static_cast<uint32_t>(m_FrameIndex % s_FrameLatency); }
+    bool IsSlotPending(uint32_t inSlot) const { return m_Slots[inSlot].Pending; }
+    uint32_t GetSlotQueryCount(uint32_t inSlot) const { return m_Slots[inSlot].QueryCount; }
+    static uint32_t GetSlotFirstQuery(uint32_t inSlot) { return inSlot * s_QueriesPerFrame; }
+
+    void BeginFrame();
+    void EndFrame();
+    bool IsFrameOpen() const { return m_FrameOpen; }
+    uint32_t GetCurrentSlot() const { return m_CurrentSlot; }
+
+    // Return the pool index to write the timestamp to, s_InvalidQuery outside of a frame or when the slot is full
+    uint32_t BeginScope(const char* inName);
+    uint32_t EndScope();
+
+    // inTicks holds GetSlotQueryCount(inSlot) timestamps, starting at GetSlotFirstQuery(inSlot)
+    void ResolveSlot(uint32_t inSlot, const uint64_t* inTicks);
+    void DiscardSlot(uint32_t inSlot);
+
+    // Every resolved scope twice: when the CPU recorded it and when the GPU executed it
+    void AppendTraceEvents(std::vector<TraceEvent>& outEvents) const;
+
+private:
+    struct Scope
+    {
+        std::string Name;
+        uint32_t    BeginQuery = 0;             // relative to the first query of the slot
+        uint32_t    EndQuery = s_InvalidQuery;
+        uint64_t    CpuBeginNs = 0;
+        uint64_t    CpuEndNs = 0;
+    };
+
+    struct FrameSlot
+    {
+        std::vector<Scope>      Scopes;
+        std::vector<uint32_t>   OpenScopes;     // stack of indices into Scopes
+        uint32_t                QueryCount = 0;
+        uint64_t                FrameIndex = 0;
+        bool                    Pending = false;
+    };
+
+    uint64_t TicksToTraceNs(uint64_t inTicks) const;
+    void AddTraceEvent(TraceEvent&& inEvent);
+
+    double                                  m_TicksPerMs = 0.0;
+    uint64_t                                m_CalibrationTicks = 0;
+    uint64_t                                m_CalibrationNs = 0;
+    std::array<FrameSlot, s_FrameLatency>   m_Slots;
+    uint64_t                                m_FrameIndex = 0;
+    uint32_t                                m_CurrentSlot = 0;
+    bool                                    m_FrameOpen = false;
+    bool                                    m_OverflowReported = false;
+    std::vector<TraceEvent>                 m_TraceEvents;
+    ScopeHook                               m_ScopeHook;
+};
+
+// Opens a GPU scope on an AppBaseDx or AppBaseVk for the lifetime of the object
+template<typename TApp>
+class ScopedGpuProfile
+{
+public:
+    ScopedGpuProfile(TApp& inApp, const char* inName) : m_App(inApp) { m_App.BeginGpuScope(inName); }
+    ~ScopedGpuProfile() { m_App.EndGpuScope(); }
+    ScopedGpuProfile(const ScopedGpuProfile&) = delete;
+    ScopedGpuProfile& operator=(const ScopedGpuProfile&) = delete;
+
+private:
+    TApp& m_App;
+};
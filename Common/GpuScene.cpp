@@ -0,0 +1,81 @@
+#include "GpuScene.h"
+#include "Log.h"
+#include <algorithm>
+#include <cstring>
+#include <functional>
+
+void GpuScene::Init(uint32_t inCapacity, uint32_t inRecordByteSize)
+{
+    if(inRecordByteSize % sizeof(uint32_t) != 0)
+        LOG_WARNING("[GpuScene] Records of %u bytes are padded to whole words", inRecordByteSize);
+    m_Capacity = inCapacity;
+    m_RecordWords = (inRecordByteSize + sizeof(uint32_t) - 1) / sizeof(uint32_t);
+    m_SlotCount = 0;
+    m_Records.assign(static_cast<size_t>(inCapacity) * m_RecordWords, 0);
+    m_Alive.assign(inCapacity, 0);
+    m_Dirty.assign(inCapacity, 0);
+    m_DirtySlots.clear();
+    m_FreeSlots.resize(inCapacity);
+    for(uint32_t i = 0; i < inCapacity; ++i)
+    {
+        m_FreeSlots[i] = inCapacity - 1 - i;
+    }
+}
+
+uint32_t GpuScene::Allocate()
+{
+    if(m_FreeSlots.empty())
+        return s_InvalidSlot;
+    const uint32_t slot = m_FreeSlots.back();
+    m_FreeSlots.pop_back();
+    m_Alive[slot] = 1;
+    m_SlotCount = std::max(m_SlotCount, slot + 1);
+    return slot;
+}
+
+void GpuScene::Free(uint32_t inSlot)
+{
+    if(!IsValid(inSlot))
+    {
+        LOG_WARNING("[GpuScene] Slot %u is not allocated", inSlot);
+        return;
+    }
+    m_Alive[inSlot] = 0;
+    m_FreeSlots.insert(std::lower_bound(m_FreeSlots.begin(), m_FreeSlots.end(), inSlot, std::greater<uint32_t>()), inSlot);
+}
+
+void GpuScene::Update(uint32_t inSlot, const void* inRecord)
+{
+    if(!IsValid(inSlot))
+    {
+        LOG_WARNING("[GpuScene] Slot %u is not allocated", inSlot);
+        return;
+    }
+    memcpy(&m_Records[inSlot * m_RecordWords], inRecord, m_RecordWords * sizeof(uint32_t));
+    if(m_Dirty[inSlot] == 0)
+    {
+        m_Dirty[inSlot] = 1;
+        m_DirtySlots.push_back(inSlot);
+    }
+}
+
+uint32_t GpuScene::GatherUpdates(std::vector<uint32_t>& outUpload)
+{
+    outUpload.clear();
+    const uint32_t updateCount = static_cast<uint32_t>(m_DirtySlots.size());
+    if(updateCount == 0)
+        return 0;
+
+    outUpload.reserve(2 + updateCount * (1 + m_RecordWords));
+    outUpload.push_back(updateCount);
+    outUpload.push_back(m_RecordWords);
+    outUpload.insert(outUpload.end(), m_DirtySlots.begin(), m_DirtySlots.end());
+    for(uint32_t slot : m_DirtySlots)
+    {
+        const uint32_t* record = &m_Records[slot * m_RecordWords];
+        outUpload.insert(outUpload.end(), record, record + m_RecordWords);
+        m_Dirty[slot] = 0;
+    }
+    m_DirtySlots.clear();
+    return updateCount;
+}
@@ -0,0 +1,50 @@
+#pragma once
+#include <cstdint>
+#include <vector>
+
+// Persistent instance records on the GPU, addressed by slots. Slots come from a free list and keep their record until
+// freed, a record only goes up again when it changed: Update copies it into the CPU mirror and puts its slot on the
+// dirty list once, and GatherUpdates packs the dirty records once per frame for the scatter pass of
+// Shaders/SceneScatter.cs.hlsl, so the bytes uploaded follow the changes and not the instance count. Records are
+// opaque whole 32 bit words, the owner decides their layout. Only the bookkeeping lives here, the owner creates a
+// record buffer of GetCapacity() records and an upload buffer of GetMaxUploadWords() words.
+class GpuScene
+{
+public:
+    static constexpr uint32_t s_InvalidSlot = UINT32_MAX;
+    static constexpr uint32_t s_ScatterGroupSize = 64;     // SCENE_SCATTER_GROUP_SIZE of SceneScatter.cs.hlsl
+
+    void Init(uint32_t inCapacity, uint32_t inRecordByteSize);
+
+    // Lowest free slot, s_InvalidSlot when the scene is full. A new slot has no record until its first Update.
+    uint32_t Allocate();
+    // The record stays on the GPU, the owner stops reading the slot
+    void Free(uint32_t inSlot);
+    void Update(uint32_t inSlot, const void* inRecord);
+
+    // Writes the update count, the record size in words, the slots then their records, and clears the dirty list.
+    // Returns the update count, outUpload stays empty when nothing changed.
+    uint32_t GatherUpdates(std::vector<uint32_t>& outUpload);
+
+    // Groups of the scatter pass for an upload of inUpdateCount records
+    uint32_t GetScatterGroupCount(uint32_t inUpdateCount) const { return (inUpdateCount * m_RecordWords + s_ScatterGroupSize - 1) / s_ScatterGroupSize; }
+    uint32_t GetMaxUploadWords() const { return 2 + m_Capacity * (1 + m_RecordWords); }
+
+    bool IsValid(uint32_t inSlot) const { return inSlot < m_Capacity && m_Alive[inSlot] != 0; }
+    const void* GetRecord(uint32_t inSlot) const { return &m_Records[inSlot * m_RecordWords]; }
+    uint32_t GetCapacity() const { return m_Capacity; }
+    uint32_t GetRecordByteSize() const { return m_RecordWords * sizeof(uint32_t); }
+    // One past the highest slot ever allocated, the range a pass over every instance covers
+    uint32_t GetSlotCount() const { return m_SlotCount; }
+    uint32_t GetDirtyCount() const { return static_cast<uint32_t>(m_DirtySlots.size()); }
+
+private:
+    uint32_t                m_Capacity = 0;
+    uint32_t                m_RecordWords = 0;
+    uint32_t                m_SlotCount = 0;
+    std::vector<uint32_t>   m_Records;      // CPU mirror, several updates of a slot in one frame upload the last one
+    std::vector<uint8_t>    m_Alive;
+    std::vector<uint8_t>    m_Dirty;
+    std::vector<uint32_t>   m_DirtySlots;
+    std::vector<uint32_t>   m_FreeSlots;    // sorted from the highest to the lowest, the lowest is reused first
+};
@@ -0,0 +1,103 @@
+#include "HiZPyramid.h"
+#include <algorithm>
+
+// Clip space w below which a corner counts as crossing the near plane
+static constexpr float s_MinClipW = 1e-5f;
+
+uint32_t HiZPyramid::ComputeMipCount(uint32_t inWidth, uint32_t inHeight)
+{
+    uint32_t count = 1;
+    glm::uvec2 size = GetMipSize(inWidth, inHeight, 0);
+    while((size.x > 1 || size.y > 1) && count < s_MaxMipCount)
+    {
+        size = (size + 1u) / 2u;
+        ++count;
+    }
+    return count;
+}
+
+glm::uvec2 HiZPyramid::GetMipSize(uint32_t inWidth, uint32_t inHeight, uint32_t inLevel)
+{
+    glm::uvec2 size(std::max(inWidth, 1u), std::max(inHeight, 1u));
+    for(uint32_t i = 0; i <= inLevel; ++i)
+        size = (size + 1u) / 2u;
+    return size;
+}
+
+void HiZPyramid::Build(const float* inDepth, uint32_t inWidth, uint32_t inHeight, uint32_t inRowPitch)
+{
+    m_Width = inWidth;
+    m_Height = inHeight;
+    m_Mips.resize(ComputeMipCount(inWidth, inHeight));
+
+    glm::uvec2 srcSize(inWidth, inHeight);
+    for(uint32_t level = 0; level < m_Mips.size(); ++level)
+    {
+        const glm::uvec2 dstSize = GetMipSize(inWidth, inHeight, level);
+        const std::vector<float>* src = level > 0 ? &m_Mips[level - 1] : nullptr;
+        auto load = [&](uint32_t inX, uint32_t inY)
+        {
+            inX = std::min(inX, srcSize.x - 1);
+            inY = std::min(inY, srcSize.y - 1);
+            return src != nullptr ? (*src)[inY * srcSize.x + inX] : inDepth[inY * inRowPitch + inX];
+        };
+
+        std::vector<float>& dst = m_Mips[level];
+        dst.resize(dstSize.x * dstSize.y);
+        for(uint32_t y = 0; y < dstSize.y; ++y)
+        {
+            for(uint32_t x = 0; x < dstSize.x; ++x)
+            {
+                dst[y * dstSize.x + x] = std::max(std::max(load(x * 2, y * 2), load(x * 2 + 1, y * 2))
+                    , std::max(load(x * 2, y * 2 + 1), load(x * 2 + 1, y * 2 + 1)));
+            }
+        }
+        srcSize = dstSize;
+    }
+}
+
+float HiZPyramid::GetDepth(uint32_t inLevel, uint32_t inX, uint32_t inY) const
+{
+    const glm::uvec2 size = GetMipSize(m_Width, m_Height, inLevel);
+    return m_Mips[inLevel][std::min(inY, size.y - 1) * size.x + std::min(inX, size.x - 1)];
+}
+
+bool HiZPyramid::IsVisible(const glm::mat4& inLocalToClip, const glm::vec3& inMin, const glm::vec3& inMax) const
+{
+    if(m_Mips.empty())
+        return true;
+
+    glm::vec2 minNdc(1e30f), maxNdc(-1e30f);
+    float minZ = 1.0f;
+    for(uint32_t i = 0; i < 8; ++i)
+    {
+        const glm::vec3 corner((i & 1) ? inMax.x : inMin.x, (i & 2) ? inMax.y : inMin.y, (i & 4) ? inMax.z : inMin.z);
+        const glm::vec4 clip = inLocalToClip * glm::vec4(corner, 1.0f);
+        if(clip.w <= s_MinClipW)
+            return true;
+        const glm::vec3 ndc = glm::vec3(clip) / clip.w;
+        minNdc = glm::min(minNdc, glm::vec2(ndc));
+        maxNdc = glm::max(maxNdc, glm::vec2(ndc));
+        minZ = std::min(minZ, ndc.z);
+    }
+
+    // Pixels of the depth buffer, y points down
+    const glm::vec2 screenSize(static_cast<float>(m_Width), static_cast<float>(m_Height));
+    const glm::vec2 minUv = glm::clamp(glm::vec2(minNdc.x, -maxNdc.y) * 0.5f + 0.5f, 0.0f, 1.0f);
+    const glm::vec2 maxUv = glm::clamp(glm::vec2(maxNdc.x, -minNdc.y) * 0.5f + 0.5f, 0.0f, 1.0f);
+    const glm::ivec2 minPixel = glm::ivec2(minUv * screenSize);
+    const glm::ivec2 maxPixel = glm::min(glm::ivec2(maxUv * screenSize), glm::ivec2(m_Width, m_Height) - 1);
+
+    // The finest level where the rectangle covers at most 2x2 texels
+    uint32_t level = 0;
+    while(level + 1 < m_Mips.size()
+        && ((maxPixel.x >> (level + 1)) - (minPixel.x >> (level + 1)) > 1 || (maxPixel.y >> (level + 1)) - (minPixel.y >> (level + 1)) > 1))
+    {
+        ++level;
+    }
+    const glm::uvec2 texelMin = glm::uvec2(minPixel >> static_cast<int>(level + 1));
+    const glm::uvec2 texelMax = glm::uvec2(maxPixel >> static_cast<int>(level + 1));
+    const float maxDepth = std::max(std::max(GetDepth(level, texelMin.x, texelMin.y), GetDepth(level, texelMax.x, texelMin.y))
+        , std::max(GetDepth(level, texelMin.x, texelMax.y), GetDepth(level, texelMax.x, texelMax.y)));
+    return minZ <= maxDepth;
+}
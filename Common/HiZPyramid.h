@@ -0,0 +1,32 @@
+#pragma once
+#include <cstdint>
+#include <vector>
+#include <glm/glm.hpp>
+
+// CPU reference of the Hi-Z occlusion test in Shaders/Include/HiZ.hlsli and of the pyramid HiZBuild.cs.hlsl builds,
+// used to validate the GPU culling results. Level 0 is half the depth buffer resolution rounded up, every texel holds
+// the farthest depth of the 2x2 texels below it, so texel (x, y) of level L covers the depth buffer pixels
+// [x, x + 1) * 2^(L + 1). Depth grows with distance, as in the D3D12 examples.
+class HiZPyramid
+{
+public:
+    static constexpr uint32_t s_MaxMipCount = 16;
+
+    static uint32_t ComputeMipCount(uint32_t inWidth, uint32_t inHeight);
+    static glm::uvec2 GetMipSize(uint32_t inWidth, uint32_t inHeight, uint32_t inLevel);
+
+    // inRowPitch in floats, as read back from a texture
+    void Build(const float* inDepth, uint32_t inWidth, uint32_t inHeight, uint32_t inRowPitch);
+
+    // False when the box is hidden behind the depth of the pyramid. Boxes crossing the near plane are visible, the
+    // frustum test is left to the caller.
+    bool IsVisible(const glm::mat4& inLocalToClip, const glm::vec3& inMin, const glm::vec3& inMax) const;
+
+    uint32_t GetMipCount() const { return static_cast<uint32_t>(m_Mips.size()); }
+    float GetDepth(uint32_t inLevel, uint32_t inX, uint32_t inY) const;
+
+private:
+    uint32_t                        m_Width = 0;
+    uint32_t                        m_Height = 0;
+    std::vector<std::vector<float>> m_Mips;
+};
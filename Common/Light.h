@@ -18,7 +18,7 @@ struct DirectionalLightData
 
 struct Light
 {
-    Transform Transform;
+    ::Transform Transform;
     float Intensity;
     glm::vec3 Color;
 };
@@ -1,26 +1,44 @@
 #include "Log.h"
-#include <cstdint>
+#include <atomic>
+#include <cctype>
+#include <chrono>
+#include <condition_variable>
 #include <cstdarg>
 #include <cstdio>
+#include <cstdlib>
+#include <cstring>
 #include <mutex>
+#include <string>
+#include <thread>
 #if _WIN32
 #include <Windows.h>
 #endif
 
 namespace Log
 {
-    
-    static ELogLevel gMinLogLevel = ELogLevel::Info;
-    static std::mutex gLogMutex;
-    
-    static constexpr size_t gMessageBufferSize = 4096;
+    std::atomic<int> gEnabledLevel {static_cast<int>(ELogLevel::Info)};
+    static std::atomic<ELogLevel> gMinLogLevel {ELogLevel::Info};
+    static std::atomic<bool> gHasCallback {true};
+    static std::atomic<bool> gBinaryCapture {true};
+
     static constexpr size_t gOutputBufferSize = 4112;
-    static void* gMessageBuffer = nullptr;
     static void* gOutputBuffer = nullptr;
 
+    static void UpdateEnabledLevel()
+    {
+        const ELogLevel level = gHasCallback.load(std::memory_order_relaxed) ? gMinLogLevel.load(std::memory_order_relaxed) : ELogLevel::None;
+        gEnabledLevel.store(static_cast<int>(level), std::memory_order_relaxed);
+    }
+
     void SetLogLevel(ELogLevel inLevel)
     {
-        gMinLogLevel = inLevel;
+        gMinLogLevel.store(inLevel, std::memory_order_relaxed);
+        UpdateEnabledLevel();
+    }
+
+    void SetBinaryCapture(bool inEnabled)
+    {
+        gBinaryCapture.store(inEnabled, std::memory_order_relaxed);
     }
 
     void DefaultCallback(ELogLevel inLevel, const char* message)
@@ -41,7 +59,7 @@ namespace Log
         {
             gOutputBuffer = malloc(gOutputBufferSize);
         }
-            
+
         char* output = new (gOutputBuffer) char[gOutputBufferSize];
         snprintf(output, gOutputBufferSize, "%s %s", severityText, message);
 #if _WIN32
@@ -51,182 +69,663 @@ namespace Log
         if (inLevel == ELogLevel::Fatal)
         {
             MessageBoxA(0, output, "Error", MB_ICONERROR);
-        }      
-#elif
+        }
+#else
         fprintf(stderr, "%s\n", output);
 #endif
         if (inLevel == ELogLevel::Fatal)
             abort();
     }
 
-    static Callback gCallBack = &DefaultCallback;
+    // Both are leaked so messages logged from static destructors still reach the callback
+    static Callback& gCallBack = *new Callback(&DefaultCallback);
+    // Serializes the callback between the logging thread and the synchronous paths, Message() never takes it
+    static std::mutex& gCallbackMutex = *new std::mutex();
 
-    void SetCallback(Callback inFunc)
+    static void Deliver(ELogLevel inLevel, const char* inMessage)
     {
-        gCallBack = inFunc;
+        std::lock_guard<std::mutex> lock(gCallbackMutex);
+        if(gCallBack)
+            gCallBack(inLevel, inMessage);
     }
-    
-    Callback GetCallback()
+
+    // Printf conversion specifications, parsed once to capture the arguments and again to format them
+    enum class EArgKind : uint8_t
     {
-        return gCallBack;    
-    }
-    
-    void ResetCallback()
+        Literal,    // "%%"
+        Signed,
+        Unsigned,
+        Char,
+        Double,
+        String,
+        Pointer,
+        Unsupported,
+    };
+
+    struct FormatSpec
     {
-        gCallBack = &DefaultCallback;
-    }
+        const char* End = nullptr;          // one past the conversion character
+        char        Flags[8] = {};
+        int         Width = -1;
+        bool        WidthStar = false;
+        int         Precision = -1;
+        bool        PrecisionStar = false;
+        char        Length[3] = {};
+        EArgKind    Kind = EArgKind::Unsupported;
+        char        Conversion = 0;
+    };
 
-    void Message(ELogLevel inLevel, const char* inFormat, ...)
+    // inFormat points after the '%'
+    static FormatSpec ParseSpec(const char* inFormat)
     {
-        if (static_cast<int>(gMinLogLevel) > static_cast<int>(inLevel))
-            return;
+        FormatSpec spec;
+        const char* p = inFormat;
+        size_t flagCount = 0;
+        while(*p != '\0' && strchr("-+ #0", *p) != nullptr)
+        {
+            if(flagCount < sizeof(spec.Flags) - 1)
+                spec.Flags[flagCount++] = *p;
+            ++p;
+        }
+        if(*p == '*')
+        {
+            spec.WidthStar = true;
+            ++p;
+        }
+        else if(isdigit(static_cast<unsigned char>(*p)))
+        {
+            spec.Width = 0;
+            while(isdigit(static_cast<unsigned char>(*p)))
+                spec.Width = spec.Width * 10 + (*p++ - '0');
+        }
+        if(*p == '.')
+        {
+            ++p;
+            if(*p == '*')
+            {
+                spec.PrecisionStar = true;
+                ++p;
+            }
+            else
+            {
+                spec.Precision = 0;
+                while(isdigit(static_cast<unsigned char>(*p)))
+                    spec.Precision = spec.Precision * 10 + (*p++ - '0');
+            }
+        }
+        size_t lengthCount = 0;
+        while(*p != '\0' && strchr("hljztL", *p) != nullptr && lengthCount < 2)
+            spec.Length[lengthCount++] = *p++;
 
-        std::lock_guard lock(gLogMutex);
-        
+        spec.Conversion = *p;
+        spec.End = *p != '\0' ? p + 1 : p;
 
-        if(gMessageBuffer == nullptr)
+        const bool noLength = spec.Length[0] == '\0';
+        const bool integerLength = noLength || strcmp(spec.Length, "hh") == 0 || strcmp(spec.Length, "h") == 0 || strcmp(spec.Length, "l") == 0
+            || strcmp(spec.Length, "ll") == 0 || strcmp(spec.Length, "j") == 0 || strcmp(spec.Length, "z") == 0 || strcmp(spec.Length, "t") == 0;
+        switch(spec.Conversion)
         {
-            gMessageBuffer = malloc(gMessageBufferSize);
+        case '%': spec.Kind = EArgKind::Literal; break;
+        case 'd': case 'i': spec.Kind = integerLength ? EArgKind::Signed : EArgKind::Unsupported; break;
+        case 'u': case 'o': case 'x': case 'X': spec.Kind = integerLength ? EArgKind::Unsigned : EArgKind::Unsupported; break;
+        case 'c': spec.Kind = noLength ? EArgKind::Char : EArgKind::Unsupported; break;
+        case 'f': case 'F': case 'e': case 'E': case 'g': case 'G': case 'a': case 'A':
+            spec.Kind = noLength || strcmp(spec.Length, "l") == 0 ? EArgKind::Double : EArgKind::Unsupported;
+            break;
+        case 's': spec.Kind = noLength ? EArgKind::String : EArgKind::Unsupported; break;
+        case 'p': spec.Kind = noLength ? EArgKind::Pointer : EArgKind::Unsupported; break;
+        default: spec.Kind = EArgKind::Unsupported; break;
         }
+        return spec;
+    }
 
-        va_list args;
-        va_start(args, inFormat);
-        uint32_t strSize = _vscprintf(inFormat, args) + 1;
-        if(strSize < gMessageBufferSize)
+    // Wrapped so it can be passed around by reference whatever the platform defines va_list as
+    struct ArgList
+    {
+        va_list Args;
+    };
+
+    static int64_t ReadSigned(const char* inLength, ArgList& inArgs)
+    {
+        if(strcmp(inLength, "hh") == 0) return static_cast<signed char>(va_arg(inArgs.Args, int));
+        if(strcmp(inLength, "h") == 0)  return static_cast<short>(va_arg(inArgs.Args, int));
+        if(strcmp(inLength, "l") == 0)  return va_arg(inArgs.Args, long);
+        if(strcmp(inLength, "ll") == 0) return va_arg(inArgs.Args, long long);
+        if(strcmp(inLength, "j") == 0)  return va_arg(inArgs.Args, intmax_t);
+        if(strcmp(inLength, "z") == 0 || strcmp(inLength, "t") == 0) return va_arg(inArgs.Args, ptrdiff_t);
+        return va_arg(inArgs.Args, int);
+    }
+
+    static uint64_t ReadUnsigned(const char* inLength, ArgList& inArgs)
+    {
+        if(strcmp(inLength, "hh") == 0) return static_cast<unsigned char>(va_arg(inArgs.Args, unsigned int));
+        if(strcmp(inLength, "h") == 0)  return static_cast<unsigned short>(va_arg(inArgs.Args, unsigned int));
+        if(strcmp(inLength, "l") == 0)  return va_arg(inArgs.Args, unsigned long);
+        if(strcmp(inLength, "ll") == 0) return va_arg(inArgs.Args, unsigned long long);
+        if(strcmp(inLength, "j") == 0)  return va_arg(inArgs.Args, uintmax_t);
+        if(strcmp(inLength, "z") == 0 || strcmp(inLength, "t") == 0) return va_arg(inArgs.Args, size_t);
+        return va_arg(inArgs.Args, unsigned int);
+    }
+
+    static constexpr uint32_t gQueueSize = 1024;    // power of two, messages are dropped when it is full
+    static constexpr uint32_t gMaxArgs = 16;
+    static constexpr uint32_t gRecordTextSize = 512;
+
+    struct Record
+    {
+        ELogLevel   Level = ELogLevel::Info;
+        bool        Captured = false;               // Text holds the format and the copied strings, else the message
+        uint32_t    ArgCount = 0;
+        uint64_t    Args[gMaxArgs] = {};            // integer, double or pointer bits, the offset in Text of strings
+        char        Text[gRecordTextSize] = {};
+    };
+
+    // False when the message has to be formatted on the calling thread instead
+    static bool CaptureArgs(Record& outRecord, const char* inFormat, ArgList& inArgs)
+    {
+        size_t textSize = strlen(inFormat) + 1;
+        if(textSize > gRecordTextSize)
+            return false;
+        memcpy(outRecord.Text, inFormat, textSize);
+
+        uint32_t argCount = 0;
+        for(const char* p = inFormat; *p != '\0';)
         {
-            char* message = new (gMessageBuffer) char[strSize];
-            vsnprintf(message, strSize, inFormat, args);
-            if(gCallBack)
-                gCallBack(inLevel, message);
+            if(*p++ != '%')
+                continue;
+
+            const FormatSpec spec = ParseSpec(p);
+            p = spec.End;
+            if(spec.Kind == EArgKind::Literal)
+                continue;
+            if(spec.Kind == EArgKind::Unsupported)
+                return false;
+
+            const uint32_t starCount = (spec.WidthStar ? 1 : 0) + (spec.PrecisionStar ? 1 : 0);
+            if(argCount + starCount + 1 > gMaxArgs)
+                return false;
+
+            int precision = spec.Precision;
+            if(spec.WidthStar)
+                outRecord.Args[argCount++] = static_cast<uint64_t>(static_cast<int64_t>(va_arg(inArgs.Args, int)));
+            if(spec.PrecisionStar)
+            {
+                precision = va_arg(inArgs.Args, int);
+                outRecord.Args[argCount++] = static_cast<uint64_t>(static_cast<int64_t>(precision));
+            }
+
+            uint64_t value = 0;
+            switch(spec.Kind)
+            {
+            case EArgKind::Signed: value = static_cast<uint64_t>(ReadSigned(spec.Length, inArgs)); break;
+            case EArgKind::Unsigned: value = ReadUnsigned(spec.Length, inArgs); break;
+            case EArgKind::Char: value = static_cast<uint64_t>(va_arg(inArgs.Args, int)); break;
+            case EArgKind::Double:
+            {
+                const double number = va_arg(inArgs.Args, double);
+                memcpy(&value, &number, sizeof(value));
+                break;
+            }
+            case EArgKind::Pointer: value = reinterpret_cast<uintptr_t>(va_arg(inArgs.Args, void*)); break;
+            case EArgKind::String:
+            {
+                const char* text = va_arg(inArgs.Args, const char*);
+                if(text == nullptr)
+                    text = "(null)";
+                // The precision bounds the read, the string does not have to be terminated then
+                const size_t length = precision >= 0 ? strnlen(text, static_cast<size_t>(precision)) : strlen(text);
+                if(textSize + length + 1 > gRecordTextSize)
+                    return false;
+                memcpy(outRecord.Text + textSize, text, length);
+                outRecord.Text[textSize + length] = '\0';
+                value = textSize;
+                textSize += length + 1;
+                break;
+            }
+            default:
+                break;
+            }
+            outRecord.Args[argCount++] = value;
         }
-        va_end(args);
+        outRecord.ArgCount = argCount;
+        return true;
     }
 
-    void Debug(const char* inFormat, ...)
+    template<typename T>
+    static void AppendFormatted(std::string& outMessage, const char* inSpec, T inValue)
     {
-        if (static_cast<int>(gMinLogLevel) > static_cast<int>(ELogLevel::Debug))
+        const int size = snprintf(nullptr, 0, inSpec, inValue);
+        if(size <= 0)
             return;
+        const size_t offset = outMessage.size();
+        outMessage.resize(offset + size + 1);
+        snprintf(&outMessage[offset], size + 1, inSpec, inValue);
+        outMessage.resize(offset + size);
+    }
 
-        std::lock_guard lock(gLogMutex);
-
-        if(gMessageBuffer == nullptr)
+    static void FormatRecord(const Record& inRecord, std::string& outMessage)
+    {
+        outMessage.clear();
+        if(!inRecord.Captured)
         {
-            gMessageBuffer = malloc(gMessageBufferSize);
+            outMessage = inRecord.Text;
+            return;
         }
 
-        va_list args;
-        va_start(args, inFormat);
-        uint32_t strSize = _vscprintf(inFormat, args) + 1;
-        if(strSize < gMessageBufferSize)
+        uint32_t argIndex = 0;
+        for(const char* p = inRecord.Text; *p != '\0';)
         {
-            char* message = new (gMessageBuffer) char[strSize];
-            vsnprintf(message, strSize, inFormat, args);
-            if(gCallBack)
-                gCallBack(ELogLevel::Debug, message);
+            if(*p != '%')
+            {
+                outMessage.push_back(*p++);
+                continue;
+            }
+
+            const FormatSpec spec = ParseSpec(++p);
+            p = spec.End;
+            if(spec.Kind == EArgKind::Literal)
+            {
+                outMessage.push_back('%');
+                continue;
+            }
+
+            // Star arguments are written into the specification so every conversion takes a single argument
+            std::string specText = "%";
+            specText += spec.Flags;
+            int width = spec.Width;
+            if(spec.WidthStar)
+            {
+                width = static_cast<int>(static_cast<int64_t>(inRecord.Args[argIndex++]));
+                if(width < 0)
+                {
+                    specText += '-';
+                    width = -width;
+                }
+            }
+            int precision = spec.Precision;
+            if(spec.PrecisionStar)
+                precision = static_cast<int>(static_cast<int64_t>(inRecord.Args[argIndex++]));
+            if(width >= 0)
+                specText += std::to_string(width);
+            if(precision >= 0)
+                specText += "." + std::to_string(precision);
+
+            const uint64_t value = inRecord.Args[argIndex++];
+            switch(spec.Kind)
+            {
+            case EArgKind::Signed:
+                specText += "ll";
+                specText += spec.Conversion;
+                AppendFormatted(outMessage, specText.c_str(), static_cast<long long>(value));
+                break;
+            case EArgKind::Unsigned:
+                specText += "ll";
+                specText += spec.Conversion;
+                AppendFormatted(outMessage, specText.c_str(), static_cast<unsigned long long>(value));
+                break;
+            case EArgKind::Char:
+                specText += 'c';
+                AppendFormatted(outMessage, specText.c_str(), static_cast<int>(value));
+                break;
+            case EArgKind::Double:
+            {
+                double number;
+                memcpy(&number, &value, sizeof(number));
+                specText += spec.Conversion;
+                AppendFormatted(outMessage, specText.c_str(), number);
+                break;
+            }
+            case EArgKind::String:
+                specText += 's';
+                AppendFormatted(outMessage, specText.c_str(), inRecord.Text + value);
+                break;
+            case EArgKind::Pointer:
+                specText += 'p';
+                AppendFormatted(outMessage, specText.c_str(), reinterpret_cast<void*>(static_cast<uintptr_t>(value)));
+                break;
+            default:
+                break;
+            }
         }
-        va_end(args);
     }
-    
-    void Info(const char* inFormat, ...)
+
+    // Bounded multi-producer queue (sequence numbered slots) drained by a single logging thread
+    class AsyncLogger
     {
-        if (static_cast<int>(gMinLogLevel) > static_cast<int>(ELogLevel::Info))
-            return;
+    public:
+        AsyncLogger()
+        {
+            for(uint32_t i = 0; i < gQueueSize; ++i)
+                m_Slots[i].Sequence.store(i, std::memory_order_relaxed);
+            m_Thread = std::thread(&AsyncLogger::Run, this);
+        }
 
-        std::lock_guard lock(gLogMutex);
+        // Delivers what is queued and joins the logging thread, later messages go the synchronous way
+        void Stop()
+        {
+            m_Stop.store(true, std::memory_order_release);
+            m_Wake.notify_one();
+            if(m_Thread.joinable())
+                m_Thread.join();
+            // Messages published while the thread was leaving the loop
+            while(ProcessNext()) {}
+        }
 
-        if(gMessageBuffer == nullptr)
+        // Null when the queue is full, the slot has to be published with Push()
+        Record* Acquire(uint64_t& outPosition)
         {
-            gMessageBuffer = malloc(gMessageBufferSize);
+            uint64_t position = m_EnqueuePosition.load(std::memory_order_relaxed);
+            for(;;)
+            {
+                Slot& slot = m_Slots[position & (gQueueSize - 1)];
+                const uint64_t sequence = slot.Sequence.load(std::memory_order_acquire);
+                const int64_t difference = static_cast<int64_t>(sequence) - static_cast<int64_t>(position);
+                if(difference == 0)
+                {
+                    if(m_EnqueuePosition.compare_exchange_weak(position, position + 1, std::memory_order_relaxed))
+                    {
+                        outPosition = position;
+                        return &slot.Data;
+                    }
+                }
+                else if(difference < 0)
+                {
+                    m_Dropped.fetch_add(1, std::memory_order_relaxed);
+                    return nullptr;
+                }
+                else
+                {
+                    position = m_EnqueuePosition.load(std::memory_order_relaxed);
+                }
+            }
         }
 
-        va_list args;
-        va_start(args, inFormat);
-        uint32_t strSize = _vscprintf(inFormat, args) + 1;
-        if(strSize < gMessageBufferSize)
+        void Push(uint64_t inPosition)
         {
-            char* message = new (gMessageBuffer) char[strSize];
-            vsnprintf(message, strSize, inFormat, args);
-            if(gCallBack)
-                gCallBack(ELogLevel::Info, message);
+            m_Slots[inPosition & (gQueueSize - 1)].Sequence.store(inPosition + 1, std::memory_order_release);
+            if(m_Sleeping.load(std::memory_order_relaxed))
+                m_Wake.notify_one();
         }
-        va_end(args);
-    }
-    
-    void Warning(const char* inFormat, ...)
-    {
-        if (static_cast<int>(gMinLogLevel) > static_cast<int>(ELogLevel::Warning))
-            return;
 
-        std::lock_guard lock(gLogMutex);
+        void Flush()
+        {
+            // The callback logging from the logging thread would wait for itself
+            if(std::this_thread::get_id() == m_Thread.get_id())
+                return;
+
+            const uint64_t target = m_EnqueuePosition.load(std::memory_order_acquire);
+            m_FlushWaiters.fetch_add(1);
+            m_Wake.notify_one();
+            {
+                std::unique_lock<std::mutex> lock(m_FlushMutex);
+                m_Flushed.wait(lock, [this, target]()
+                {
+                    return m_Processed.load() >= target || m_Stopped.load();
+                });
+            }
+            m_FlushWaiters.fetch_sub(1);
+        }
+
+        uint64_t GetDroppedCount() const { return m_Dropped.load(std::memory_order_relaxed); }
+        bool IsStopped() const { return m_Stopped.load(std::memory_order_acquire); }
 
-        if(gMessageBuffer == nullptr)
+    private:
+        struct Slot
         {
-            gMessageBuffer = malloc(gMessageBufferSize);
+            std::atomic<uint64_t>   Sequence {0};
+            Record                  Data;
+        };
+
+        bool ProcessNext()
+        {
+            Slot& slot = m_Slots[m_DequeuePosition & (gQueueSize - 1)];
+            if(slot.Sequence.load(std::memory_order_acquire) != m_DequeuePosition + 1)
+                return false;
+
+            FormatRecord(slot.Data, m_Message);
+            const ELogLevel level = slot.Data.Level;
+            slot.Sequence.store(m_DequeuePosition + gQueueSize, std::memory_order_release);
+            ++m_DequeuePosition;
+            if(level != ELogLevel::None)
+                Deliver(level, m_Message.c_str());
+            // Sequentially consistent with the waiter count, a Flush() either sees the position or gets notified
+            m_Processed.store(m_DequeuePosition);
+            if(m_FlushWaiters.load() != 0)
+                NotifyFlushed();
+            return true;
         }
 
-        va_list args;
-        va_start(args, inFormat);
-        uint32_t strSize = _vscprintf(inFormat, args) + 1;
-        if(strSize < gMessageBufferSize)
+        void NotifyFlushed()
         {
-            char* message = new (gMessageBuffer) char[strSize];
-            vsnprintf(message, strSize, inFormat, args);
-            if(gCallBack)
-                gCallBack(ELogLevel::Warning, message);
+            // Taking the mutex orders the notify after a waiter that checked the predicate went to sleep
+            {
+                std::lock_guard<std::mutex> lock(m_FlushMutex);
+            }
+            m_Flushed.notify_all();
         }
-        va_end(args);
-    }
-    
-    void Error(const char* inFormat, ...)
-    {
-        if (static_cast<int>(gMinLogLevel) > static_cast<int>(ELogLevel::Error))
-            return;
 
-        std::lock_guard lock(gLogMutex);
+        void ReportDrops()
+        {
+            const uint64_t dropped = m_Dropped.load(std::memory_order_relaxed);
+            if(dropped == m_ReportedDrops)
+                return;
+            char message[128];
+            snprintf(message, sizeof(message), "[Log] %llu messages dropped, the queue was full", static_cast<unsigned long long>(dropped - m_ReportedDrops));
+            m_ReportedDrops = dropped;
+            Deliver(ELogLevel::Warning, message);
+        }
 
-        if(gMessageBuffer == nullptr)
+        void Run()
         {
-            gMessageBuffer = malloc(gMessageBufferSize);
+            for(;;)
+            {
+                if(ProcessNext())
+                    continue;
+                ReportDrops();
+                if(m_Stop.load(std::memory_order_acquire))
+                    break;
+
+                // Producers only notify while the flag is set, the timeout covers a notify racing with the flag
+                std::unique_lock<std::mutex> lock(m_WakeMutex);
+                m_Sleeping.store(true, std::memory_order_relaxed);
+                m_Wake.wait_for(lock, std::chrono::milliseconds(5));
+                m_Sleeping.store(false, std::memory_order_relaxed);
+            }
+            m_Stopped.store(true);
+            NotifyFlushed();
         }
 
-        va_list args;
-        va_start(args, inFormat);
-        uint32_t strSize = _vscprintf(inFormat, args) + 1;
-        if(strSize < gMessageBufferSize)
+        Slot                        m_Slots[gQueueSize];
+        std::atomic<uint64_t>       m_EnqueuePosition {0};
+        std::atomic<uint64_t>       m_Processed {0};
+        std::atomic<uint64_t>       m_Dropped {0};
+        std::atomic<uint32_t>       m_FlushWaiters {0};
+        std::atomic<bool>           m_Sleeping {false};
+        std::atomic<bool>           m_Stop {false};
+        std::atomic<bool>           m_Stopped {false};
+        uint64_t                    m_DequeuePosition = 0;      // logging thread only
+        uint64_t                    m_ReportedDrops = 0;        // logging thread only
+        std::string                 m_Message;                  // logging thread only
+        std::mutex                  m_WakeMutex;
+        std::condition_variable     m_Wake;
+        std::mutex                  m_FlushMutex;
+        std::condition_variable     m_Flushed;
+        std::thread                 m_Thread;
+    };
+
+    // Leaked so LOG_* from static destructors never reaches a destroyed queue. The thread is stopped by an atexit
+    // handler registered after the callback was constructed, so it runs while the callback is still alive.
+    static AsyncLogger& GetLogger()
+    {
+        static AsyncLogger* logger = []()
         {
-            char* message = new (gMessageBuffer) char[strSize];
-            vsnprintf(message, strSize, inFormat, args);
-            if(gCallBack)
-                gCallBack(ELogLevel::Error, message);
+            AsyncLogger* newLogger = new AsyncLogger();
+            std::atexit([]() { GetLogger().Stop(); });
+            return newLogger;
+        }();
+        return *logger;
+    }
+
+    void SetCallback(Callback inFunc)
+    {
+        Flush();
+        std::lock_guard<std::mutex> lock(gCallbackMutex);
+        gCallBack = inFunc;
+        gHasCallback.store(static_cast<bool>(gCallBack), std::memory_order_relaxed);
+        UpdateEnabledLevel();
+    }
+
+    Callback GetCallback()
+    {
+        std::lock_guard<std::mutex> lock(gCallbackMutex);
+        return gCallBack;
+    }
+
+    void ResetCallback()
+    {
+        SetCallback(&DefaultCallback);
+    }
+
+    void Flush()
+    {
+        GetLogger().Flush();
+    }
+
+    uint64_t GetDroppedCount()
+    {
+        return GetLogger().GetDroppedCount();
+    }
+
+    double MeasureFilteredCallNs(uint32_t inIterations)
+    {
+        const auto start = std::chrono::steady_clock::now();
+        // What LOG_DEBUG expands to when it is not compiled out
+        for(uint32_t i = 0; i < inIterations; ++i)
+        {
+            if(IsEnabled(ELogLevel::Debug))
+                Debug("[Log] %u", i);
         }
-        va_end(args);
+        const auto end = std::chrono::steady_clock::now();
+        return std::chrono::duration<double, std::nano>(end - start).count() / static_cast<double>(inIterations);
     }
-    
-    void Fatal(const char* inFormat, ...)
+
+    // Formats on the calling thread and waits for the callback, after everything queued before
+    static void PostSynchronous(ELogLevel inLevel, const char* inFormat, ArgList& inArgs)
     {
-        if (static_cast<int>(gMinLogLevel) > static_cast<int>(ELogLevel::Fatal))
+        ArgList sizeArgs;
+        va_copy(sizeArgs.Args, inArgs.Args);
+        const int size = vsnprintf(nullptr, 0, inFormat, sizeArgs.Args);
+        va_end(sizeArgs.Args);
+        if(size < 0)
             return;
 
-        std::lock_guard lock(gLogMutex);
+        std::string message(static_cast<size_t>(size) + 1, '\0');
+        vsnprintf(&message[0], message.size(), inFormat, inArgs.Args);
+        message.resize(static_cast<size_t>(size));
+        Flush();
+        Deliver(inLevel, message.c_str());
+    }
+
+    static void Post(ELogLevel inLevel, const char* inFormat, va_list inArgs)
+    {
+        if (!IsEnabled(inLevel))
+            return;
 
-        if(gMessageBuffer == nullptr)
+        ArgList args;
+        va_copy(args.Args, inArgs);
+        AsyncLogger& logger = GetLogger();
+        // Fatal aborts in the callback, which has to happen on the calling thread
+        if(inLevel == ELogLevel::Fatal || logger.IsStopped())
         {
-            gMessageBuffer = malloc(gMessageBufferSize);
+            PostSynchronous(inLevel, inFormat, args);
+            va_end(args.Args);
+            return;
         }
 
-        va_list args;
-        va_start(args, inFormat);
-        uint32_t strSize = _vscprintf(inFormat, args) + 1;
-        if(strSize < gMessageBufferSize)
+        uint64_t position = 0;
+        Record* record = logger.Acquire(position);
+        if(record == nullptr)
         {
-            char* message = new (gMessageBuffer) char[strSize];
-            vsnprintf(message, strSize, inFormat, args);
-            if(gCallBack)
-                gCallBack(ELogLevel::Fatal, message);
+            va_end(args.Args);
+            return;
         }
+
+        record->Level = inLevel;
+        bool queued = false;
+        if(gBinaryCapture.load(std::memory_order_relaxed))
+        {
+            ArgList captureArgs;
+            va_copy(captureArgs.Args, args.Args);
+            record->Captured = CaptureArgs(*record, inFormat, captureArgs);
+            va_end(captureArgs.Args);
+            queued = record->Captured;
+        }
+        if(!queued)
+        {
+            ArgList formatArgs;
+            va_copy(formatArgs.Args, args.Args);
+            const int size = vsnprintf(record->Text, gRecordTextSize, inFormat, formatArgs.Args);
+            va_end(formatArgs.Args);
+            record->Captured = false;
+            queued = size >= 0 && static_cast<uint32_t>(size) < gRecordTextSize;
+            // The slot is already claimed, it is published as a placeholder when the text goes the slow way
+            if(!queued)
+                record->Level = ELogLevel::None;
+        }
+        logger.Push(position);
+
+        if(!queued)
+            PostSynchronous(inLevel, inFormat, args);
+        else if(inLevel == ELogLevel::Error)
+            Flush();
+        va_end(args.Args);
+    }
+
+    void Message(ELogLevel inLevel, LOG_FORMAT_STRING const char* inFormat, ...)
+    {
+        va_list args;
+        va_start(args, inFormat);
+        Post(inLevel, inFormat, args);
+        va_end(args);
+    }
+
+    void Debug(LOG_FORMAT_STRING const char* inFormat, ...)
+    {
+        va_list args;
+        va_start(args, inFormat);
+        Post(ELogLevel::Debug, inFormat, args);
+        va_end(args);
+    }
+
+    void Info(LOG_FORMAT_STRING const char* inFormat, ...)
+    {
+        va_list args;
+        va_start(args, inFormat);
+        Post(ELogLevel::Info, inFormat, args);
         va_end(args);
     }
-}
 
+    void Warning(LOG_FORMAT_STRING const char* inFormat, ...)
+    {
+        va_list args;
+        va_start(args, inFormat);
+        Post(ELogLevel::Warning, inFormat, args);
+        va_end(args);
+    }
 
+    void Error(LOG_FORMAT_STRING const char* inFormat, ...)
+    {
+        va_list args;
+        va_start(args, inFormat);
+        Post(ELogLevel::Error, inFormat, args);
+        va_end(args);
+    }
 
+    void Fatal(LOG_FORMAT_STRING const char* inFormat, ...)
+    {
+        va_list args;
+        va_start(args, inFormat);
+        Post(ELogLevel::Fatal, inFormat, args);
+        va_end(args);
+    }
+}
@@ -1,5 +1,60 @@
 #pragma once
+#include <atomic>
+#include <cstdint>
+#include <cstdio>
 #include <functional>
+
+// Messages are queued into a bounded lock-free ring and formatted and handed to the callback on a background thread.
+// Printf arguments are captured in binary form, strings by copy, so the caller only pays for the capture. Messages
+// that do not fit a queue entry are formatted right away, Error and Fatal wait until the callback received them.
+// The logging thread stops at exit, messages logged after that (e.g. from static destructors) are delivered synchronously.
+//
+// Prefer the LOG_* macros below over calling the functions directly: levels under LOG_COMPILE_LEVEL are compiled
+// out with their arguments, the others skip the call when the level is filtered or no callback is set.
+#define LOG_LEVEL_DEBUG     0
+#define LOG_LEVEL_INFO      1
+#define LOG_LEVEL_WARNING   2
+#define LOG_LEVEL_ERROR     3
+#define LOG_LEVEL_FATAL     4
+
+#ifndef LOG_COMPILE_LEVEL
+#define LOG_COMPILE_LEVEL   LOG_LEVEL_DEBUG
+#endif
+
+// GCC and Clang check calls to the Log functions with -Wformat, MSVC only checks the SAL annotation under /analyze
+#if defined(__GNUC__) || defined(__clang__)
+#define LOG_PRINTF_FORMAT(formatIndex, firstArg) __attribute__((format(printf, formatIndex, firstArg)))
+#else
+#define LOG_PRINTF_FORMAT(formatIndex, firstArg)
+#endif
+
+#if defined(_MSC_VER)
+#include <sal.h>
+#define LOG_FORMAT_STRING _Printf_format_string_
+#else
+#define LOG_FORMAT_STRING
+#endif
+
+// The printf call is never evaluated, it only has the compiler check the arguments against the format wherever it
+// checks printf itself (GCC and Clang with -Wformat)
+#define LOG_CHECK_FORMAT(...) ((void)(false && printf(__VA_ARGS__)))
+
+#define LOG_AT_LEVEL(level, function, ...) \
+    do { \
+        if constexpr (static_cast<int>(level) >= LOG_COMPILE_LEVEL) \
+        { \
+            LOG_CHECK_FORMAT(__VA_ARGS__); \
+            if(Log::IsEnabled(level)) \
+                function(__VA_ARGS__); \
+        } \
+    } while(0)
+
+#define LOG_DEBUG(...)      LOG_AT_LEVEL(Log::ELogLevel::Debug, Log::Debug, __VA_ARGS__)
+#define LOG_INFO(...)       LOG_AT_LEVEL(Log::ELogLevel::Info, Log::Info, __VA_ARGS__)
+#define LOG_WARNING(...)    LOG_AT_LEVEL(Log::ELogLevel::Warning, Log::Warning, __VA_ARGS__)
+#define LOG_ERROR(...)      LOG_AT_LEVEL(Log::ELogLevel::Error, Log::Error, __VA_ARGS__)
+#define LOG_FATAL(...)      LOG_AT_LEVEL(Log::ELogLevel::Fatal, Log::Fatal, __VA_ARGS__)
+
 namespace Log
 {
     enum class ELogLevel
@@ -14,14 +69,30 @@ namespace Log
 
     typedef std::function<void(ELogLevel, char const*)> Callback;
 
+    // Lowest level that reaches the callback, None while no callback is set
+    extern std::atomic<int> gEnabledLevel;
+
+    inline bool IsEnabled(ELogLevel inLevel)
+    {
+        return static_cast<int>(inLevel) >= gEnabledLevel.load(std::memory_order_relaxed);
+    }
+
     void        SetLogLevel(ELogLevel inLevel);
     void        SetCallback(Callback inFunc);
     Callback    GetCallback();
     void        ResetCallback();
-    void        Message(ELogLevel inLevel, const char* inFormat, ...);
-    void        Debug(const char* inFormat, ...);
-    void        Info(const char* inFormat, ...);
-    void        Warning(const char* inFormat, ...);
-    void        Error(const char* inFormat, ...);
-    void        Fatal(const char* inFormat, ...);
+    // When disabled the arguments are formatted on the calling thread, the message is still delivered asynchronously
+    void        SetBinaryCapture(bool inEnabled);
+    // Blocks until every message queued before the call was handed to the callback
+    void        Flush();
+    // Messages lost because the queue was full
+    uint64_t    GetDroppedCount();
+    // Average cost of a LOG_DEBUG that is filtered at runtime, only meaningful while Debug is disabled
+    double      MeasureFilteredCallNs(uint32_t inIterations = 1000000);
+    void        Message(ELogLevel inLevel, LOG_FORMAT_STRING const char* inFormat, ...) LOG_PRINTF_FORMAT(2, 3);
+    void        Debug(LOG_FORMAT_STRING const char* inFormat, ...) LOG_PRINTF_FORMAT(1, 2);
+    void        Info(LOG_FORMAT_STRING const char* inFormat, ...) LOG_PRINTF_FORMAT(1, 2);
+    void        Warning(LOG_FORMAT_STRING const char* inFormat, ...) LOG_PRINTF_FORMAT(1, 2);
+    void        Error(LOG_FORMAT_STRING const char* inFormat, ...) LOG_PRINTF_FORMAT(1, 2);
+    void        Fatal(LOG_FORMAT_STRING const char* inFormat, ...) LOG_PRINTF_FORMAT(1, 2);
 }
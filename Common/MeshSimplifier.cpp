@@ -0,0 +1,393 @@
+#include "MeshSimplifier.h"
+#include <algorithm>
+#include <cfloat>
+#include <cmath>
+#include <iterator>
+#include <queue>
+#include <unordered_map>
+
+// Symmetric 4x4 matrix of a sum of planes, v^T Q v is the sum of the squared distances of v to them
+struct Quadric
+{
+    double A00 = 0, A01 = 0, A02 = 0, A11 = 0, A12 = 0, A22 = 0;
+    double B0 = 0, B1 = 0, B2 = 0;
+    double C = 0;
+
+    static Quadric FromPlane(const glm::dvec3& inNormal, double inDistance)
+    {
+        Quadric q;
+        q.A00 = inNormal.x * inNormal.x; q.A01 = inNormal.x * inNormal.y; q.A02 = inNormal.x * inNormal.z;
+        q.A11 = inNormal.y * inNormal.y; q.A12 = inNormal.y * inNormal.z; q.A22 = inNormal.z * inNormal.z;
+        q.B0 = inNormal.x * inDistance; q.B1 = inNormal.y * inDistance; q.B2 = inNormal.z * inDistance;
+        q.C = inDistance * inDistance;
+        return q;
+    }
+
+    Quadric& operator+=(const Quadric& inOther)
+    {
+        A00 += inOther.A00; A01 += inOther.A01; A02 += inOther.A02;
+        A11 += inOther.A11; A12 += inOther.A12; A22 += inOther.A22;
+        B0 += inOther.B0; B1 += inOther.B1; B2 += inOther.B2;
+        C += inOther.C;
+        return *this;
+    }
+
+    double Evaluate(const glm::dvec3& inPoint) const
+    {
+        const double x = inPoint.x, y = inPoint.y, z = inPoint.z;
+        return x * x * A00 + 2 * x * y * A01 + 2 * x * z * A02 + y * y * A11 + 2 * y * z * A12 + z * z * A22
+            + 2 * (x * B0 + y * B1 + z * B2) + C;
+    }
+};
+
+struct Collapse
+{
+    double   Cost;
+    uint32_t From;
+    uint32_t To;
+    uint32_t FromVersion;
+    uint32_t ToVersion;
+
+    bool operator>(const Collapse& inOther) const { return Cost > inOther.Cost; }
+};
+
+// Collapses of one mesh, successive calls to Run continue from where the previous one stopped so the levels of a
+// chain nest into each other
+class CollapseState
+{
+public:
+    CollapseState(const std::vector<glm::vec3>& inPositions, const std::vector<uint32_t>& inIndices)
+        : m_Positions(inPositions)
+        , m_Indices(inIndices)
+    {
+        const uint32_t vertexCount = static_cast<uint32_t>(inPositions.size());
+        const uint32_t triangleCount = static_cast<uint32_t>(inIndices.size() / 3);
+        m_Indices.resize(triangleCount * 3);
+        m_Quadrics.resize(vertexCount);
+        m_Triangles.resize(vertexCount);
+        m_Versions.assign(vertexCount, 0);
+        m_Locked.assign(vertexCount, 0);
+        m_Alive.assign(triangleCount, 1);
+        m_AliveCount = triangleCount;
+
+        // Open edges are used by one triangle, non manifold ones by more than two, their vertices stay in place
+        std::unordered_map<uint64_t, uint32_t> edgeUses;
+        for(uint32_t t = 0; t < triangleCount; ++t)
+        {
+            const uint32_t* tri = &m_Indices[t * 3];
+            const glm::dvec3 p0(inPositions[tri[0]]), p1(inPositions[tri[1]]), p2(inPositions[tri[2]]);
+            glm::dvec3 normal = glm::cross(p1 - p0, p2 - p0);
+            const double length = glm::length(normal);
+            if(length > 0.0)
+            {
+                normal /= length;
+                const Quadric plane = Quadric::FromPlane(normal, -glm::dot(normal, p0));
+                for(uint32_t i = 0; i < 3; ++i)
+                    m_Quadrics[tri[i]] += plane;
+            }
+            for(uint32_t i = 0; i < 3; ++i)
+            {
+                m_Triangles[tri[i]].push_back(t);
+                ++edgeUses[EdgeKey(tri[i], tri[(i + 1) % 3])];
+            }
+        }
+        for(const auto& edge : edgeUses)
+        {
+            if(edge.second != 2)
+            {
+                m_Locked[static_cast<uint32_t>(edge.first >> 32)] = 1;
+                m_Locked[static_cast<uint32_t>(edge.first)] = 1;
+            }
+        }
+
+        for(uint32_t t = 0; t < triangleCount; ++t)
+        {
+            for(uint32_t i = 0; i < 3; ++i)
+            {
+                PushCollapse(m_Indices[t * 3 + i], m_Indices[t * 3 + (i + 1) % 3]);
+                PushCollapse(m_Indices[t * 3 + (i + 1) % 3], m_Indices[t * 3 + i]);
+            }
+        }
+    }
+
+    void Run(uint32_t inTargetTriangleCount)
+    {
+        while(m_AliveCount > inTargetTriangleCount && !m_Queue.empty())
+        {
+            const Collapse collapse = m_Queue.top();
+            m_Queue.pop();
+            if(collapse.FromVersion != m_Versions[collapse.From] || collapse.ToVersion != m_Versions[collapse.To])
+                continue;
+            if(!CanCollapse(collapse.From, collapse.To))
+                continue;
+            Apply(collapse.From, collapse.To);
+            m_Error = std::max(m_Error, static_cast<float>(std::sqrt(std::max(collapse.Cost, 0.0))));
+        }
+    }
+
+    uint32_t GetAliveCount() const { return m_AliveCount; }
+    float GetError() const { return m_Error; }
+
+    void AppendIndices(std::vector<uint32_t>& outIndices) const
+    {
+        for(uint32_t t = 0; t < m_Alive.size(); ++t)
+        {
+            if(m_Alive[t] != 0)
+                outIndices.insert(outIndices.end(), &m_Indices[t * 3], &m_Indices[t * 3] + 3);
+        }
+    }
+
+private:
+    static uint64_t EdgeKey(uint32_t inA, uint32_t inB)
+    {
+        return inA < inB ? (static_cast<uint64_t>(inA) << 32) | inB : (static_cast<uint64_t>(inB) << 32) | inA;
+    }
+
+    void PushCollapse(uint32_t inFrom, uint32_t inTo)
+    {
+        if(m_Locked[inFrom] != 0 || inFrom == inTo)
+            return;
+        Quadric quadric = m_Quadrics[inFrom];
+        quadric += m_Quadrics[inTo];
+        m_Queue.push({quadric.Evaluate(glm::dvec3(m_Positions[inTo])), inFrom, inTo, m_Versions[inFrom], m_Versions[inTo]});
+    }
+
+    void GatherNeighbors(uint32_t inVertex, std::vector<uint32_t>& outNeighbors) const
+    {
+        outNeighbors.clear();
+        for(uint32_t t : m_Triangles[inVertex])
+        {
+            if(m_Alive[t] == 0)
+                continue;
+            for(uint32_t i = 0; i < 3; ++i)
+            {
+                const uint32_t vertex = m_Indices[t * 3 + i];
+                if(vertex != inVertex)
+                    outNeighbors.push_back(vertex);
+            }
+        }
+        std::sort(outNeighbors.begin(), outNeighbors.end());
+        outNeighbors.erase(std::unique(outNeighbors.begin(), outNeighbors.end()), outNeighbors.end());
+    }
+
+    bool CanCollapse(uint32_t inFrom, uint32_t inTo)
+    {
+        // The vertices next to both must be the tips of the triangles of the edge, otherwise the collapse pinches
+        uint32_t sharedTriangles = 0;
+        for(uint32_t t : m_Triangles[inFrom])
+        {
+            if(m_Alive[t] != 0 && (m_Indices[t * 3] == inTo || m_Indices[t * 3 + 1] == inTo || m_Indices[t * 3 + 2] == inTo))
+                ++sharedTriangles;
+        }
+        if(sharedTriangles == 0)
+            return false;
+        GatherNeighbors(inFrom, m_FromNeighbors);
+        GatherNeighbors(inTo, m_ToNeighbors);
+        m_SharedNeighbors.clear();
+        std::set_intersection(m_FromNeighbors.begin(), m_FromNeighbors.end(), m_ToNeighbors.begin(), m_ToNeighbors.end(), std::back_inserter(m_SharedNeighbors));
+        if(m_SharedNeighbors.size() != sharedTriangles)
+            return false;
+
+        // The triangles that stay must keep facing the same way
+        const glm::vec3 to = m_Positions[inTo];
+        for(uint32_t t : m_Triangles[inFrom])
+        {
+            const uint32_t* tri = &m_Indices[t * 3];
+            if(m_Alive[t] == 0 || tri[0] == inTo || tri[1] == inTo || tri[2] == inTo)
+                continue;
+            // A triangle spanning locked vertices only can close a notch of the border over the triangles on its other
+            // side, a fold the normals of such slivers do not show
+            if(m_Locked[inTo] != 0 && m_Locked[tri[0] == inFrom ? tri[1] : tri[0]] != 0 && m_Locked[tri[2] == inFrom ? tri[1] : tri[2]] != 0)
+                return false;
+            glm::vec3 before[3], after[3];
+            for(uint32_t i = 0; i < 3; ++i)
+            {
+                before[i] = m_Positions[tri[i]];
+                after[i] = tri[i] == inFrom ? to : before[i];
+            }
+            const glm::vec3 normalBefore = glm::cross(before[1] - before[0], before[2] - before[0]);
+            const glm::vec3 normalAfter = glm::cross(after[1] - after[0], after[2] - after[0]);
+            if(glm::dot(normalBefore, normalAfter) <= 0.25f * glm::length(normalBefore) * glm::length(normalAfter))
+                return false;
+        }
+        return true;
+    }
+
+    void Apply(uint32_t inFrom, uint32_t inTo)
+    {
+        for(uint32_t t : m_Triangles[inFrom])
+        {
+            if(m_Alive[t] == 0)
+                continue;
+            uint32_t* tri = &m_Indices[t * 3];
+            if(tri[0] == inTo || tri[1] == inTo || tri[2] == inTo)
+            {
+                m_Alive[t] = 0;
+                --m_AliveCount;
+                continue;
+            }
+            for(uint32_t i = 0; i < 3; ++i)
+            {
+                if(tri[i] == inFrom)
+                    tri[i] = inTo;
+            }
+            m_Triangles[inTo].push_back(t);
+        }
+        m_Triangles[inFrom].clear();
+        m_Quadrics[inTo] += m_Quadrics[inFrom];
+        ++m_Versions[inFrom];
+        ++m_Versions[inTo];
+
+        GatherNeighbors(inTo, m_ToNeighbors);
+        for(uint32_t neighbor : m_ToNeighbors)
+        {
+            PushCollapse(neighbor, inTo);
+            PushCollapse(inTo, neighbor);
+        }
+    }
+
+    const std::vector<glm::vec3>&       m_Positions;
+    std::vector<uint32_t>               m_Indices;
+    std::vector<Quadric>                m_Quadrics;
+    std::vector<std::vector<uint32_t>>  m_Triangles;    // per vertex, dead ones are skipped
+    std::vector<uint32_t>               m_Versions;     // bumped when a vertex moves or its quadric grows
+    std::vector<uint8_t>                m_Locked;
+    std::vector<uint8_t>                m_Alive;
+    uint32_t                            m_AliveCount = 0;
+    float                               m_Error = 0.0f;
+    std::priority_queue<Collapse, std::vector<Collapse>, std::greater<Collapse>> m_Queue;
+    std::vector<uint32_t>               m_FromNeighbors;
+    std::vector<uint32_t>               m_ToNeighbors;
+    std::vector<uint32_t>               m_SharedNeighbors;
+};
+
+float MeshSimplifier::Simplify(const std::vector<glm::vec3>& inPositions, const std::vector<uint32_t>& inIndices
+    , uint32_t inTargetIndexCount, std::vector<uint32_t>& outIndices)
+{
+    CollapseState state(inPositions, inIndices);
+    state.Run(inTargetIndexCount / 3);
+    outIndices.clear();
+    state.AppendIndices(outIndices);
+    return state.GetError();
+}
+
+void MeshSimplifier::BuildLodChain(const std::vector<glm::vec3>& inPositions, const std::vector<uint32_t>& inIndices
+    , uint32_t inLodCount, float inRatio, std::vector<uint32_t>& outIndices, std::vector<MeshLod>& outLods)
+{
+    outIndices.assign(inIndices.begin(), inIndices.end() - inIndices.size() % 3);
+    outLods.clear();
+    outLods.push_back({0, static_cast<uint32_t>(outIndices.size()), 0.0f});
+
+    CollapseState state(inPositions, inIndices);
+    for(uint32_t lod = 1; lod < inLodCount; ++lod)
+    {
+        const uint32_t previousCount = state.GetAliveCount();
+        state.Run(static_cast<uint32_t>(previousCount * inRatio));
+        if(state.GetAliveCount() > previousCount * 0.9f)
+            break;
+        const uint32_t firstIndex = static_cast<uint32_t>(outIndices.size());
+        state.AppendIndices(outIndices);
+        outLods.push_back({firstIndex, static_cast<uint32_t>(outIndices.size()) - firstIndex, state.GetError()});
+    }
+}
+
+static float PointTriangleDistance(const glm::vec3& inPoint, const glm::vec3& inA, const glm::vec3& inB, const glm::vec3& inC)
+{
+    // Closest point by Voronoi regions, Real-Time Collision Detection 5.1.5
+    const glm::vec3 ab = inB - inA, ac = inC - inA, ap = inPoint - inA;
+    const float d1 = glm::dot(ab, ap), d2 = glm::dot(ac, ap);
+    if(d1 <= 0.0f && d2 <= 0.0f)
+        return glm::length(ap);
+    const glm::vec3 bp = inPoint - inB;
+    const float d3 = glm::dot(ab, bp), d4 = glm::dot(ac, bp);
+    if(d3 >= 0.0f && d4 <= d3)
+        return glm::length(bp);
+    const float vc = d1 * d4 - d3 * d2;
+    if(vc <= 0.0f && d1 >= 0.0f && d3 <= 0.0f)
+        return glm::length(inPoint - (inA + ab * (d1 / (d1 - d3))));
+    const glm::vec3 cp = inPoint - inC;
+    const float d5 = glm::dot(ab, cp), d6 = glm::dot(ac, cp);
+    if(d6 >= 0.0f && d5 <= d6)
+        return glm::length(cp);
+    const float vb = d5 * d2 - d1 * d6;
+    if(vb <= 0.0f && d2 >= 0.0f && d6 <= 0.0f)
+        return glm::length(inPoint - (inA + ac * (d2 / (d2 - d6))));
+    const float va = d3 * d6 - d5 * d4;
+    if(va <= 0.0f && (d4 - d3) >= 0.0f && (d5 - d6) >= 0.0f)
+        return glm::length(inPoint - (inB + (inC - inB) * ((d4 - d3) / ((d4 - d3) + (d5 - d6)))));
+    const float denom = 1.0f / (va + vb + vc);
+    return glm::length(inPoint - (inA + ab * (vb * denom) + ac * (vc * denom)));
+}
+
+void MeshSimplifier::MeasureError(const std::vector<glm::vec3>& inPositions, const std::vector<uint32_t>& inReferenceIndices
+    , const uint32_t* inIndices, uint32_t inIndexCount, float& outMaxError, float& outMeanError)
+{
+    outMaxError = 0.0f;
+    outMeanError = 0.0f;
+    const uint32_t triangleCount = inIndexCount / 3;
+    if(triangleCount == 0)
+        return;
+
+    // Uniform grid of the triangles by bounds, about one triangle per cell
+    glm::vec3 boundsMin(FLT_MAX), boundsMax(-FLT_MAX);
+    for(uint32_t i = 0; i < triangleCount * 3; ++i)
+    {
+        boundsMin = glm::min(boundsMin, inPositions[inIndices[i]]);
+        boundsMax = glm::max(boundsMax, inPositions[inIndices[i]]);
+    }
+    const int resolution = std::clamp(static_cast<int>(std::cbrt(static_cast<float>(triangleCount))), 1, 64);
+    const glm::vec3 cellSize = glm::max((boundsMax - boundsMin) / static_cast<float>(resolution), glm::vec3(1e-6f));
+    auto cellOf = [&](const glm::vec3& inPoint) { return glm::clamp(glm::ivec3((inPoint - boundsMin) / cellSize), glm::ivec3(0), glm::ivec3(resolution - 1)); };
+    std::vector<std::vector<uint32_t>> cells(resolution * resolution * resolution);
+    for(uint32_t t = 0; t < triangleCount; ++t)
+    {
+        const glm::vec3& a = inPositions[inIndices[t * 3]];
+        const glm::vec3& b = inPositions[inIndices[t * 3 + 1]];
+        const glm::vec3& c = inPositions[inIndices[t * 3 + 2]];
+        const glm::ivec3 first = cellOf(glm::min(glm::min(a, b), c)), last = cellOf(glm::max(glm::max(a, b), c));
+        for(int z = first.z; z <= last.z; ++z)
+            for(int y = first.y; y <= last.y; ++y)
+                for(int x = first.x; x <= last.x; ++x)
+                    cells[(z * resolution + y) * resolution + x].push_back(t);
+    }
+    const float cellMin = std::min(std::min(cellSize.x, cellSize.y), cellSize.z);
+
+    std::vector<uint8_t> referenced(inPositions.size(), 0);
+    for(uint32_t index : inReferenceIndices)
+        referenced[index] = 1;
+
+    double sum = 0.0;
+    uint32_t count = 0;
+    for(uint32_t v = 0; v < inPositions.size(); ++v)
+    {
+        if(referenced[v] == 0)
+            continue;
+        // Rings of cells around the one of the vertex until the next ring cannot be closer than the best triangle
+        const glm::vec3& point = inPositions[v];
+        const glm::ivec3 center = cellOf(point);
+        float distance = FLT_MAX;
+        for(int ring = 0; ring < resolution && distance > (ring - 1) * cellMin; ++ring)
+        {
+            for(int z = std::max(center.z - ring, 0); z <= std::min(center.z + ring, resolution - 1); ++z)
+            {
+                for(int y = std::max(center.y - ring, 0); y <= std::min(center.y + ring, resolution - 1); ++y)
+                {
+                    for(int x = std::max(center.x - ring, 0); x <= std::min(center.x + ring, resolution - 1); ++x)
+                    {
+                        if(std::max(std::max(std::abs(x - center.x), std::abs(y - center.y)), std::abs(z - center.z)) != ring)
+                            continue;
+                        for(uint32_t t : cells[(z * resolution + y) * resolution + x])
+                        {
+                            distance = std::min(distance, PointTriangleDistance(point
+                                , inPositions[inIndices[t * 3]], inPositions[inIndices[t * 3 + 1]], inPositions[inIndices[t * 3 + 2]]));
+                        }
+                    }
+                }
+            }
+        }
+        outMaxError = std::max(outMaxError, distance);
+        sum += distance;
+        ++count;
+    }
+    outMeanError = count > 0 ? static_cast<float>(sum / count) : 0.0f;
+}
@@ -0,0 +1,36 @@
+#pragma once
+#include <cstdint>
+#include <vector>
+#include <glm/glm.hpp>
+
+// One level of detail of a chain, a range of the concatenated indices of every level. All levels index the vertices
+// of the full mesh, simplification only drops triangles and moves their corners onto kept vertices.
+struct MeshLod
+{
+    uint32_t FirstIndex;
+    uint32_t IndexCount;
+    float    Error;         // object space, bounds how far the surface moved from the full mesh
+};
+
+// Quadric error edge collapse (Garland and Heckbert). Every vertex accumulates the planes of its triangles, edges are
+// collapsed onto one of their endpoints in order of the squared distance of that endpoint to the planes of both, so
+// the kept vertices and their attributes are the original ones. Vertices on open edges, including the attribute
+// seams of split vertices, never move, and collapses that would fold a triangle over or pinch the surface are
+// skipped.
+class MeshSimplifier
+{
+public:
+    // Collapses until at most inTargetIndexCount indices are left or no collapse is possible, returns the error
+    static float Simplify(const std::vector<glm::vec3>& inPositions, const std::vector<uint32_t>& inIndices
+        , uint32_t inTargetIndexCount, std::vector<uint32_t>& outIndices);
+
+    // Level 0 is inIndices, every next level keeps inRatio of the triangles of the previous one. The chain stops
+    // early when a level cannot go below 90% of the previous one.
+    static void BuildLodChain(const std::vector<glm::vec3>& inPositions, const std::vector<uint32_t>& inIndices
+        , uint32_t inLodCount, float inRatio, std::vector<uint32_t>& outIndices, std::vector<MeshLod>& outLods);
+
+    // Distance from every vertex referenced by inReferenceIndices to the closest triangle of inIndices, one sided
+    // Hausdorff distance of the original surface to the simplified one, over a uniform grid of the triangles
+    static void MeasureError(const std::vector<glm::vec3>& inPositions, const std::vector<uint32_t>& inReferenceIndices
+        , const uint32_t* inIndices, uint32_t inIndexCount, float& outMaxError, float& outMeanError);
+};
@@ -0,0 +1,94 @@
+#include "OcclusionQueryGroups.h"
+#include "Log.h"
+#include <algorithm>
+#include <cfloat>
+#include <numeric>
+
+// Interleaves the low 10 bits of inValue with two zero bits each
+static uint32_t SpreadBits(uint32_t inValue)
+{
+    inValue &= 0x3ff;
+    inValue = (inValue | (inValue << 16)) & 0x030000ff;
+    inValue = (inValue | (inValue << 8)) & 0x0300f00f;
+    inValue = (inValue | (inValue << 4)) & 0x030c30c3;
+    inValue = (inValue | (inValue << 2)) & 0x09249249;
+    return inValue;
+}
+
+void OcclusionQueryGroups::Build(const OcclusionBox* inBounds, uint32_t inCount, uint32_t inGroupSize, std::vector<uint32_t>& outOrder)
+{
+    glm::vec3 sceneMin(FLT_MAX), sceneMax(-FLT_MAX);
+    for(uint32_t i = 0; i < inCount; ++i)
+    {
+        sceneMin = glm::min(sceneMin, inBounds[i].Min);
+        sceneMax = glm::max(sceneMax, inBounds[i].Max);
+    }
+    const glm::vec3 scale = 1023.0f / glm::max(sceneMax - sceneMin, glm::vec3(1e-6f));
+
+    std::vector<uint32_t> codes(inCount);
+    for(uint32_t i = 0; i < inCount; ++i)
+    {
+        const glm::uvec3 cell = glm::uvec3(((inBounds[i].Min + inBounds[i].Max) * 0.5f - sceneMin) * scale);
+        codes[i] = SpreadBits(cell.x) | (SpreadBits(cell.y) << 1) | (SpreadBits(cell.z) << 2);
+    }
+    outOrder.resize(inCount);
+    std::iota(outOrder.begin(), outOrder.end(), 0u);
+    std::stable_sort(outOrder.begin(), outOrder.end(), [&](uint32_t inLhs, uint32_t inRhs) { return codes[inLhs] < codes[inRhs]; });
+
+    inGroupSize = std::max(inGroupSize, 1u);
+    m_Groups.clear();
+    for(uint32_t first = 0; first < inCount; first += inGroupSize)
+    {
+        Group group;
+        group.FirstInstance = first;
+        group.InstanceCount = std::min(inGroupSize, inCount - first);
+        group.Bounds.Min = glm::vec3(FLT_MAX);
+        group.Bounds.Max = glm::vec3(-FLT_MAX);
+        for(uint32_t i = first; i < first + group.InstanceCount; ++i)
+        {
+            group.Bounds.Min = glm::min(group.Bounds.Min, inBounds[outOrder[i]].Min);
+            group.Bounds.Max = glm::max(group.Bounds.Max, inBounds[outOrder[i]].Max);
+        }
+        m_Groups.push_back(group);
+    }
+
+    // Everything is drawn until the first results come back
+    m_Passed.assign(m_Groups.size(), 1);
+    m_OccludedFrames.assign(m_Groups.size(), 0);
+    m_FrameCount = 0;
+    m_SkippedGroups = 0;
+    m_SkippedInstances = 0;
+}
+
+void OcclusionQueryGroups::UpdateVisibility(const uint64_t* inQueryResults)
+{
+    for(uint32_t i = 0; i < m_Groups.size(); ++i)
+    {
+        m_Passed[i] = inQueryResults[i] != 0 ? 1 : 0;
+        m_OccludedFrames[i] = m_Passed[i] ? 0 : std::min(m_OccludedFrames[i] + 1, s_HiddenFrames);
+    }
+}
+
+bool OcclusionQueryGroups::IsCameraInside(const OcclusionBox& inBounds, const glm::vec3& inCameraPosition, float inNearPlane)
+{
+    // The corners of the near plane are a bit farther than inNearPlane, twice is enough for any usual field of view
+    const glm::vec3 margin(inNearPlane * 2.0f);
+    return glm::all(glm::greaterThanEqual(inCameraPosition, inBounds.Min - margin))
+        && glm::all(glm::lessThanEqual(inCameraPosition, inBounds.Max + margin));
+}
+
+void OcclusionQueryGroups::AddFrameStats(uint32_t inSkippedGroups, uint32_t inSkippedInstances)
+{
+    ++m_FrameCount;
+    m_SkippedGroups += inSkippedGroups;
+    m_SkippedInstances += inSkippedInstances;
+}
+
+void OcclusionQueryGroups::LogReport(const char* inMode) const
+{
+    if(m_FrameCount == 0)
+        return;
+    LOG_INFO("[Occlusion] %s: %.1f of %u group draws and %.1f instances skipped per frame over %llu frames", inMode
+        , static_cast<double>(m_SkippedGroups) / m_FrameCount, GetGroupCount()
+        , static_cast<double>(m_SkippedInstances) / m_FrameCount, static_cast<unsigned long long>(m_FrameCount));
+}
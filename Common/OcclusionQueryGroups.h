@@ -0,0 +1,51 @@
+#pragma once
+#include <cstdint>
+#include <vector>
+#include <glm/glm.hpp>
+
+#include "SoftwareOcclusion.h"
+
+// CPU side of hardware occlusion queries shared by the D3D12 and Vulkan examples. Instances are split into spatially
+// coherent groups, every frame draws the bounding box of each group with a query around it after the scene, and the
+// results decide what the next frame draws, either on the GPU through predication or on the CPU once they are read
+// back. A group is hidden only after its query failed s_HiddenFrames frames in a row and shown again as soon as one
+// passes, so objects at the edge of an occluder do not flicker.
+class OcclusionQueryGroups
+{
+public:
+    static constexpr uint32_t s_HiddenFrames = 3;
+
+    struct Group
+    {
+        uint32_t     FirstInstance;
+        uint32_t     InstanceCount;
+        OcclusionBox Bounds;
+    };
+
+    // Sorts the instances along a Morton curve of their centers and cuts that order into groups of inGroupSize.
+    // outOrder[i] is the instance to upload at position i, groups index into that order.
+    void Build(const OcclusionBox* inBounds, uint32_t inCount, uint32_t inGroupSize, std::vector<uint32_t>& outOrder);
+
+    // One binary query result per group, zero when no sample of its box passed the depth test
+    void UpdateVisibility(const uint64_t* inQueryResults);
+    bool HasPassed(uint32_t inGroup) const { return m_Passed[inGroup] != 0; }
+    // With hysteresis, what the CPU driven mode draws
+    bool IsVisible(uint32_t inGroup) const { return m_OccludedFrames[inGroup] < s_HiddenFrames; }
+    // The near plane may cut the box of the group, its query cannot be trusted and the group is always drawn
+    static bool IsCameraInside(const OcclusionBox& inBounds, const glm::vec3& inCameraPosition, float inNearPlane);
+
+    void AddFrameStats(uint32_t inSkippedGroups, uint32_t inSkippedInstances);
+    // Average draws skipped per frame since the last Build
+    void LogReport(const char* inMode) const;
+
+    const std::vector<Group>& GetGroups() const { return m_Groups; }
+    uint32_t GetGroupCount() const { return static_cast<uint32_t>(m_Groups.size()); }
+
+private:
+    std::vector<Group>      m_Groups;
+    std::vector<uint8_t>    m_Passed;
+    std::vector<uint32_t>   m_OccludedFrames;
+    uint64_t                m_FrameCount = 0;
+    uint64_t                m_SkippedGroups = 0;
+    uint64_t                m_SkippedInstances = 0;
+};
@@ -0,0 +1,459 @@
+#include "RenderGraph.h"
+#include "Log.h"
+#include <algorithm>
+
+static uint64_t AlignUp(uint64_t inValue, uint64_t inAlignment)
+{
+    return inAlignment > 1 ? (inValue + inAlignment - 1) / inAlignment * inAlignment : inValue;
+}
+
+bool RenderGraph::IsWriteAccess(ERenderGraphAccess inAccess)
+{
+    switch (inAccess)
+    {
+    case ERenderGraphAccess::UnorderedAccess:
+    case ERenderGraphAccess::RenderTarget:
+    case ERenderGraphAccess::DepthWrite:
+    case ERenderGraphAccess::CopyDst:
+        return true;
+    default:
+        return false;
+    }
+}
+
+void RenderGraph::Reset()
+{
+    m_Resources.clear();
+    m_Passes.clear();
+    m_Schedule.clear();
+    m_PassTransitions.clear();
+    m_FinalTransitions.clear();
+    m_MemoryReport = {};
+    m_Compiled = false;
+}
+
+RenderGraphHandle RenderGraph::CreateResource(const std::string& inName, const RenderGraphResourceDesc& inDesc)
+{
+    ResourceNode resource;
+    resource.Name = inName;
+    resource.Desc = inDesc;
+    m_Resources.push_back(resource);
+    m_Compiled = false;
+    return static_cast<RenderGraphHandle>(m_Resources.size() - 1);
+}
+
+RenderGraphHandle RenderGraph::ImportResource(const std::string& inName, const RenderGraphResourceDesc& inDesc, bool inPreserveContents)
+{
+    const RenderGraphHandle handle = CreateResource(inName, inDesc);
+    m_Resources[handle].Imported = true;
+    m_Resources[handle].PreserveContents = inPreserveContents;
+    return handle;
+}
+
+void RenderGraph::SetFinalAccess(RenderGraphHandle inResource, ERenderGraphAccess inAccess)
+{
+    if(inResource >= m_Resources.size())
+    {
+        LOG_ERROR("[RenderGraph] Invalid resource handle %u", inResource);
+        return;
+    }
+    m_Resources[inResource].FinalAccess = inAccess;
+    m_Compiled = false;
+}
+
+uint32_t RenderGraph::AddPass(const std::string& inName, ERenderGraphPassType inType, ExecuteFunc inExecute)
+{
+    PassNode pass;
+    pass.Name = inName;
+    pass.Type = inType;
+    pass.Execute = std::move(inExecute);
+    m_Passes.push_back(std::move(pass));
+    m_Compiled = false;
+    return static_cast<uint32_t>(m_Passes.size() - 1);
+}
+
+void RenderGraph::AddAccess(uint32_t inPass, RenderGraphHandle inResource, ERenderGraphAccess inAccess, bool inWrite)
+{
+    if(inPass >= m_Passes.size() || inResource >= m_Resources.size())
+    {
+        LOG_ERROR("[RenderGraph] Invalid pass %u or resource handle %u", inPass, inResource);
+        return;
+    }
+    m_Passes[inPass].Accesses.push_back({inResource, inAccess, inWrite});
+    m_Compiled = false;
+}
+
+void RenderGraph::Read(uint32_t inPass, RenderGraphHandle inResource, ERenderGraphAccess inAccess)
+{
+    AddAccess(inPass, inResource, inAccess, false);
+}
+
+void RenderGraph::Write(uint32_t inPass, RenderGraphHandle inResource, ERenderGraphAccess inAccess)
+{
+    AddAccess(inPass, inResource, inAccess, true);
+}
+
+void RenderGraph::SetSideEffects(uint32_t inPass)
+{
+    if(inPass < m_Passes.size())
+    {
+        m_Passes[inPass].SideEffects = true;
+        m_Compiled = false;
+    }
+}
+
+bool RenderGraph::BuildSchedule(std::vector<std::vector<uint32_t>>& outProducers)
+{
+    // Every access is ordered against the accesses declared before it: read after write, write after write and
+    // write after read. Only the first two carry data, those are the edges pass culling follows.
+    const uint32_t passCount = static_cast<uint32_t>(m_Passes.size());
+    std::vector<std::vector<uint32_t>> predecessors(passCount);
+    outProducers.assign(passCount, {});
+    std::vector<uint32_t> lastWriter(m_Resources.size(), UINT32_MAX);
+    std::vector<std::vector<uint32_t>> readers(m_Resources.size());
+
+    auto addEdge = [](std::vector<uint32_t>& outList, uint32_t inPass)
+    {
+        if(std::find(outList.begin(), outList.end(), inPass) == outList.end())
+            outList.push_back(inPass);
+    };
+
+    for(uint32_t pass = 0; pass < passCount; ++pass)
+    {
+        for(const PassNode::Access& access : m_Passes[pass].Accesses)
+        {
+            if(access.Write || lastWriter[access.Resource] == UINT32_MAX)
+                continue;
+            addEdge(predecessors[pass], lastWriter[access.Resource]);
+            addEdge(outProducers[pass], lastWriter[access.Resource]);
+        }
+        for(const PassNode::Access& access : m_Passes[pass].Accesses)
+        {
+            if(!access.Write)
+                continue;
+            const uint32_t writer = lastWriter[access.Resource];
+            if(writer != UINT32_MAX && writer != pass)
+            {
+                addEdge(predecessors[pass], writer);
+                addEdge(outProducers[pass], writer);
+            }
+            for(uint32_t reader : readers[access.Resource])
+            {
+                if(reader != pass)
+                    addEdge(predecessors[pass], reader);
+            }
+            lastWriter[access.Resource] = pass;
+            readers[access.Resource].clear();
+        }
+        for(const PassNode::Access& access : m_Passes[pass].Accesses)
+        {
+            if(!access.Write && lastWriter[access.Resource] != pass)
+                addEdge(readers[access.Resource], pass);
+        }
+    }
+
+    CullPasses(outProducers);
+
+    // Kahn's algorithm over the alive passes, ties go to the pass declared first so the order stays predictable
+    std::vector<uint32_t> inDegrees(passCount, 0);
+    std::vector<std::vector<uint32_t>> successors(passCount);
+    for(uint32_t pass = 0; pass < passCount; ++pass)
+    {
+        if(!m_Passes[pass].Alive)
+            continue;
+        for(uint32_t predecessor : predecessors[pass])
+        {
+            if(!m_Passes[predecessor].Alive)
+                continue;
+            successors[predecessor].push_back(pass);
+            ++inDegrees[pass];
+        }
+    }
+
+    std::vector<uint32_t> ready;
+    for(uint32_t pass = 0; pass < passCount; ++pass)
+    {
+        if(m_Passes[pass].Alive && inDegrees[pass] == 0)
+            ready.push_back(pass);
+    }
+
+    m_Schedule.clear();
+    while(!ready.empty())
+    {
+        auto next = std::min_element(ready.begin(), ready.end());
+        const uint32_t pass = *next;
+        ready.erase(next);
+        m_Schedule.push_back(pass);
+        for(uint32_t successor : successors[pass])
+        {
+            if(--inDegrees[successor] == 0)
+                ready.push_back(successor);
+        }
+    }
+
+    const uint32_t aliveCount = static_cast<uint32_t>(std::count_if(m_Passes.begin(), m_Passes.end(), [](const PassNode& inPass) { return inPass.Alive; }));
+    if(m_Schedule.size() != aliveCount)
+    {
+        LOG_ERROR("[RenderGraph] The pass dependencies contain a cycle");
+        return false;
+    }
+    return true;
+}
+
+void RenderGraph::CullPasses(const std::vector<std::vector<uint32_t>>& inProducers)
+{
+    // A pass survives if it has side effects, writes something that outlives the graph or feeds a pass that survives
+    std::vector<uint32_t> stack;
+    for(uint32_t pass = 0; pass < m_Passes.size(); ++pass)
+    {
+        PassNode& node = m_Passes[pass];
+        node.Alive = node.SideEffects;
+        for(const PassNode::Access& access : node.Accesses)
+        {
+            const ResourceNode& resource = m_Resources[access.Resource];
+            if(access.Write && (resource.Imported || resource.FinalAccess != ERenderGraphAccess::None))
+                node.Alive = true;
+        }
+        if(node.Alive)
+            stack.push_back(pass);
+    }
+
+    while(!stack.empty())
+    {
+        const uint32_t pass = stack.back();
+        stack.pop_back();
+        for(uint32_t producer : inProducers[pass])
+        {
+            if(!m_Passes[producer].Alive)
+            {
+                m_Passes[producer].Alive = true;
+                stack.push_back(producer);
+            }
+        }
+    }
+}
+
+bool RenderGraph::AllocateTransients(const MemoryQueryFunc& inMemoryQuery)
+{
+    struct Allocation
+    {
+        RenderGraphHandle   Resource;
+        uint64_t            Alignment;
+    };
+
+    std::vector<Allocation> transients;
+    for(RenderGraphHandle handle = 0; handle < m_Resources.size(); ++handle)
+    {
+        ResourceNode& resource = m_Resources[handle];
+        if(resource.Imported || resource.FirstUse == UINT32_MAX)
+            continue;
+
+        uint64_t alignment = 1;
+        if(!inMemoryQuery(handle, resource.Desc, resource.Size, alignment))
+        {
+            LOG_ERROR("[RenderGraph] Failed to query the memory requirements of %s", resource.Name.c_str());
+            return false;
+        }
+        transients.push_back({handle, alignment});
+        m_MemoryReport.TransientBytes += AlignUp(resource.Size, alignment);
+    }
+    m_MemoryReport.TransientResources = static_cast<uint32_t>(transients.size());
+
+    // Biggest first, each resource takes the lowest offset that does not overlap a placed resource alive at the same time
+    std::sort(transients.begin(), transients.end(), [this](const Allocation& inLeft, const Allocation& inRight)
+    {
+        const uint64_t leftSize = m_Resources[inLeft.Resource].Size;
+        const uint64_t rightSize = m_Resources[inRight.Resource].Size;
+        return leftSize != rightSize ? leftSize > rightSize : inLeft.Resource < inRight.Resource;
+    });
+
+    std::vector<RenderGraphHandle> placed;
+    std::vector<const ResourceNode*> conflicts;
+    for(const Allocation& allocation : transients)
+    {
+        ResourceNode& resource = m_Resources[allocation.Resource];
+        conflicts.clear();
+        for(RenderGraphHandle other : placed)
+        {
+            const ResourceNode& otherResource = m_Resources[other];
+            if(resource.FirstUse <= otherResource.LastUse && otherResource.FirstUse <= resource.LastUse)
+                conflicts.push_back(&otherResource);
+        }
+        std::sort(conflicts.begin(), conflicts.end(), [](const ResourceNode* inLeft, const ResourceNode* inRight) { return inLeft->Offset < inRight->Offset; });
+
+        uint64_t offset = 0;
+        for(const ResourceNode* conflict : conflicts)
+        {
+            if(AlignUp(offset, allocation.Alignment) + resource.Size <= conflict->Offset)
+                break;
+            offset = std::max(offset, conflict->Offset + conflict->Size);
+        }
+        resource.Offset = AlignUp(offset, allocation.Alignment);
+        m_MemoryReport.AliasedBytes = std::max(m_MemoryReport.AliasedBytes, resource.Offset + resource.Size);
+        placed.push_back(allocation.Resource);
+    }
+
+    // The first use of an aliased resource has to wait for the last use of whatever occupied its memory before
+    for(RenderGraphHandle handle : placed)
+    {
+        ResourceNode& resource = m_Resources[handle];
+        for(RenderGraphHandle other : placed)
+        {
+            const ResourceNode& otherResource = m_Resources[other];
+            const bool memoryOverlaps = resource.Offset < otherResource.Offset + otherResource.Size && otherResource.Offset < resource.Offset + resource.Size;
+            if(other != handle && memoryOverlaps && otherResource.LastUse < resource.FirstUse)
+                resource.AliasPredecessors.push_back(other);
+        }
+    }
+    return true;
+}
+
+void RenderGraph::BuildTransitions()
+{
+    std::vector<ERenderGraphAccess> current(m_Resources.size(), ERenderGraphAccess::None);
+    std::vector<bool> touched(m_Resources.size(), false);
+    m_PassTransitions.assign(m_Schedule.size(), {});
+    m_FinalTransitions.clear();
+
+    for(uint32_t order = 0; order < m_Schedule.size(); ++order)
+    {
+        const PassNode& pass = m_Passes[m_Schedule[order]];
+        // One access per resource and pass, a write wins over a read of the same resource
+        std::vector<PassNode::Access> accesses;
+        for(const PassNode::Access& access : pass.Accesses)
+        {
+            auto iter = std::find_if(accesses.begin(), accesses.end(), [&access](const PassNode::Access& inOther) { return inOther.Resource == access.Resource; });
+            if(iter == accesses.end())
+                accesses.push_back(access);
+            else if(access.Write && !iter->Write)
+                *iter = access;
+        }
+
+        for(const PassNode::Access& access : accesses)
+        {
+            const ResourceNode& resource = m_Resources[access.Resource];
+            const bool firstUse = !touched[access.Resource];
+            touched[access.Resource] = true;
+            if(!firstUse && current[access.Resource] == access.Access && !IsWriteAccess(access.Access))
+                continue;
+
+            RenderGraphTransition transition;
+            transition.Resource = access.Resource;
+            transition.Before = current[access.Resource];
+            transition.After = access.Access;
+            transition.PassType = pass.Type;
+            transition.Discard = firstUse && (!resource.Imported || !resource.PreserveContents);
+            m_PassTransitions[order].push_back(transition);
+            current[access.Resource] = access.Access;
+        }
+
+        for(const PassNode::Access& access : accesses)
+        {
+            m_Resources[access.Resource].LastAccess = access.Access;
+            m_Resources[access.Resource].LastPassType = pass.Type;
+        }
+    }
+
+    for(RenderGraphHandle handle = 0; handle < m_Resources.size(); ++handle)
+    {
+        const ResourceNode& resource = m_Resources[handle];
+        if(!touched[handle] || resource.FinalAccess == ERenderGraphAccess::None || resource.FinalAccess == current[handle])
+            continue;
+        m_FinalTransitions.push_back({handle, current[handle], resource.FinalAccess, ERenderGraphPassType::Graphics, false});
+    }
+}
+
+bool RenderGraph::Compile(const MemoryQueryFunc& inMemoryQuery)
+{
+    m_Compiled = false;
+    m_MemoryReport = {};
+    m_MemoryReport.DeclaredPasses = static_cast<uint32_t>(m_Passes.size());
+
+    std::vector<std::vector<uint32_t>> producers;
+    if(!BuildSchedule(producers))
+        return false;
+    m_MemoryReport.CulledPasses = m_MemoryReport.DeclaredPasses - static_cast<uint32_t>(m_Schedule.size());
+
+    for(ResourceNode& resource : m_Resources)
+    {
+        resource.AccessMask = 0;
+        resource.FirstUse = UINT32_MAX;
+        resource.LastUse = 0;
+        resource.Size = 0;
+        resource.Offset = 0;
+        resource.LastAccess = ERenderGraphAccess::None;
+        resource.AliasPredecessors.clear();
+    }
+    for(uint32_t order = 0; order < m_Schedule.size(); ++order)
+    {
+        for(const PassNode::Access& access : m_Passes[m_Schedule[order]].Accesses)
+        {
+            ResourceNode& resource = m_Resources[access.Resource];
+            resource.AccessMask |= 1u << static_cast<uint32_t>(access.Access);
+            resource.FirstUse = std::min(resource.FirstUse, order);
+            resource.LastUse = std::max(resource.LastUse, order);
+        }
+    }
+    for(ResourceNode& resource : m_Resources)
+    {
+        if(resource.FinalAccess != ERenderGraphAccess::None && resource.FirstUse != UINT32_MAX)
+            resource.AccessMask |= 1u << static_cast<uint32_t>(resource.FinalAccess);
+    }
+
+    if(!AllocateTransients(inMemoryQuery))
+        return false;
+
+    BuildTransitions();
+    m_Compiled = true;
+    return true;
+}
+
+void RenderGraph::Execute(const BarrierFunc& inBarriers) const
+{
+    if(!m_Compiled)
+    {
+        LOG_ERROR("[RenderGraph] Execute called before Compile");
+        return;
+    }
+
+    for(uint32_t order = 0; order < m_Schedule.size(); ++order)
+    {
+        if(!m_PassTransitions[order].empty())
+            inBarriers(m_PassTransitions[order]);
+        const PassNode& pass = m_Passes[m_Schedule[order]];
+        if(pass.Execute)
+            pass.Execute();
+    }
+
+    if(!m_FinalTransitions.empty())
+        inBarriers(m_FinalTransitions);
+}
+
+void RenderGraph::LogReport() const
+{
+    LOG_INFO("[RenderGraph] %u of %u passes scheduled, %u transient resource(s) aliased from %llu KB into %llu KB, %.1f%% saved"
+        , static_cast<uint32_t>(m_Schedule.size())
+        , m_MemoryReport.DeclaredPasses
+        , m_MemoryReport.TransientResources
+        , static_cast<unsigned long long>(m_MemoryReport.TransientBytes / 1024)
+        , static_cast<unsigned long long>(m_MemoryReport.AliasedBytes / 1024)
+        , m_MemoryReport.GetSavedPercent());
+
+    for(uint32_t pass = 0; pass < m_Passes.size(); ++pass)
+    {
+        if(!m_Passes[pass].Alive)
+            LOG_INFO("[RenderGraph] Culled pass %s", m_Passes[pass].Name.c_str());
+    }
+
+    for(const ResourceNode& resource : m_Resources)
+    {
+        if(resource.Imported || resource.FirstUse == UINT32_MAX)
+            continue;
+        LOG_DEBUG("[RenderGraph] %s: passes [%u, %u], %llu bytes at offset %llu"
+            , resource.Name.c_str()
+            , resource.FirstUse
+            , resource.LastUse
+            , static_cast<unsigned long long>(resource.Size)
+            , static_cast<unsigned long long>(resource.Offset));
+    }
+}
@@ -0,0 +1,160 @@
+#pragma once
+#include <cstdint>
+#include <functional>
+#include <string>
+#include <vector>
+
+// API agnostic render graph. Passes declare which resources they read and write, Compile() orders and culls the
+// passes, computes the lifetime of every transient resource, packs them into one aliased allocation and works out
+// the access changes between passes. The backends (AppBaseVk / AppBaseDx) create the actual resources and turn the
+// access changes into barriers, so everything in here runs on the CPU alone.
+
+typedef uint32_t RenderGraphHandle;
+static constexpr RenderGraphHandle s_InvalidRenderGraphHandle = UINT32_MAX;
+
+enum class ERenderGraphResourceType : uint8_t
+{
+    Texture,
+    Buffer
+};
+
+enum class ERenderGraphPassType : uint8_t
+{
+    Graphics,
+    Compute,
+    RayTracing,
+    Copy
+};
+
+enum class ERenderGraphAccess : uint8_t
+{
+    None,
+    ShaderRead,
+    UnorderedAccess,
+    RenderTarget,
+    DepthWrite,
+    DepthRead,
+    CopySrc,
+    CopyDst,
+    IndirectArgument,
+    Present
+};
+
+struct RenderGraphResourceDesc
+{
+    ERenderGraphResourceType    Type = ERenderGraphResourceType::Texture;
+    uint32_t                    Width = 0;      // texture width, or byte size of a buffer
+    uint32_t                    Height = 1;
+    uint32_t                    MipLevels = 1;
+    uint32_t                    Format = 0;     // VkFormat or DXGI_FORMAT, only the backend interprets it
+};
+
+struct RenderGraphTransition
+{
+    RenderGraphHandle       Resource;
+    ERenderGraphAccess      Before;
+    ERenderGraphAccess      After;
+    ERenderGraphPassType    PassType;   // type of the pass the resource is transitioned for
+    bool                    Discard;    // previous contents are not needed, first use of a transient or a discarded import
+};
+
+struct RenderGraphMemoryReport
+{
+    uint32_t DeclaredPasses = 0;
+    uint32_t CulledPasses = 0;
+    uint32_t TransientResources = 0;
+    uint64_t TransientBytes = 0;   // every transient in its own allocation, each size aligned up to its alignment
+    uint64_t AliasedBytes = 0;     // size of the aliased allocation actually needed, alignment padding can make it the larger one
+
+    // Negative when the padding between aliased resources costs more than the aliasing saves
+    int64_t GetSavedBytes() const { return static_cast<int64_t>(TransientBytes) - static_cast<int64_t>(AliasedBytes); }
+    float GetSavedPercent() const { return TransientBytes > 0 ? 100.0f * static_cast<float>(GetSavedBytes()) / static_cast<float>(TransientBytes) : 0.0f; }
+};
+
+class RenderGraph
+{
+public:
+    typedef std::function<void()> ExecuteFunc;
+    typedef std::function<void(const std::vector<RenderGraphTransition>&)> BarrierFunc;
+    // Fills the size and alignment the resource needs in the aliased allocation, returns false when it can not be created
+    typedef std::function<bool(RenderGraphHandle, const RenderGraphResourceDesc&, uint64_t&, uint64_t&)> MemoryQueryFunc;
+
+    struct ResourceNode
+    {
+        std::string                 Name;
+        RenderGraphResourceDesc     Desc;
+        bool                        Imported = false;
+        bool                        PreserveContents = true;       // imported only
+        ERenderGraphAccess          FinalAccess = ERenderGraphAccess::None;
+        uint32_t                    AccessMask = 0;                 // bit per ERenderGraphAccess used by the alive passes
+        uint32_t                    FirstUse = UINT32_MAX;          // index in the schedule
+        uint32_t                    LastUse = 0;
+        uint64_t                    Size = 0;
+        uint64_t                    Offset = 0;                     // in the aliased allocation, transient only
+        ERenderGraphAccess          LastAccess = ERenderGraphAccess::None;
+        ERenderGraphPassType        LastPassType = ERenderGraphPassType::Graphics;
+        std::vector<RenderGraphHandle> AliasPredecessors;           // transients that used the same memory earlier in the frame
+    };
+
+    struct PassNode
+    {
+        struct Access
+        {
+            RenderGraphHandle   Resource;
+            ERenderGraphAccess  Access;
+            bool                Write;
+        };
+
+        std::string             Name;
+        ERenderGraphPassType    Type;
+        ExecuteFunc             Execute;
+        std::vector<Access>     Accesses;
+        bool                    SideEffects = false;
+        bool                    Alive = false;
+    };
+
+    void Reset();
+
+    RenderGraphHandle CreateResource(const std::string& inName, const RenderGraphResourceDesc& inDesc);
+    // Resources owned outside of the graph are never aliased, inPreserveContents = false discards them at first use
+    RenderGraphHandle ImportResource(const std::string& inName, const RenderGraphResourceDesc& inDesc, bool inPreserveContents = true);
+    // Access the resource is left in after the last pass, e.g. Present for a back buffer
+    void SetFinalAccess(RenderGraphHandle inResource, ERenderGraphAccess inAccess);
+
+    uint32_t AddPass(const std::string& inName, ERenderGraphPassType inType, ExecuteFunc inExecute);
+    void Read(uint32_t inPass, RenderGraphHandle inResource, ERenderGraphAccess inAccess);
+    void Write(uint32_t inPass, RenderGraphHandle inResource, ERenderGraphAccess inAccess);
+    // Keeps a pass alive even if nothing reads what it writes, e.g. it writes to a readback buffer
+    void SetSideEffects(uint32_t inPass);
+
+    bool Compile(const MemoryQueryFunc& inMemoryQuery);
+    // Calls inBarriers before each scheduled pass that needs access changes and once more for the final accesses
+    void Execute(const BarrierFunc& inBarriers) const;
+
+    bool IsCompiled() const { return m_Compiled; }
+    uint32_t GetResourceCount() const { return static_cast<uint32_t>(m_Resources.size()); }
+    const ResourceNode& GetResource(RenderGraphHandle inResource) const { return m_Resources[inResource]; }
+    bool IsResourceUsed(RenderGraphHandle inResource) const { return m_Resources[inResource].FirstUse != UINT32_MAX; }
+    const std::vector<uint32_t>& GetSchedule() const { return m_Schedule; }
+    const PassNode& GetPass(uint32_t inPass) const { return m_Passes[inPass]; }
+    const RenderGraphMemoryReport& GetMemoryReport() const { return m_MemoryReport; }
+    uint64_t GetAliasedAllocationSize() const { return m_MemoryReport.AliasedBytes; }
+    void LogReport() const;
+
+    static bool IsWriteAccess(ERenderGraphAccess inAccess);
+
+private:
+    void AddAccess(uint32_t inPass, RenderGraphHandle inResource, ERenderGraphAccess inAccess, bool inWrite);
+    bool BuildSchedule(std::vector<std::vector<uint32_t>>& outProducers);
+    void CullPasses(const std::vector<std::vector<uint32_t>>& inProducers);
+    bool AllocateTransients(const MemoryQueryFunc& inMemoryQuery);
+    void BuildTransitions();
+
+    std::vector<ResourceNode>                           m_Resources;
+    std::vector<PassNode>                               m_Passes;
+    std::vector<uint32_t>                               m_Schedule;
+    std::vector<std::vector<RenderGraphTransition>>     m_PassTransitions;  // indexed like m_Schedule
+    std::vector<RenderGraphTransition>                  m_FinalTransitions;
+    RenderGraphMemoryReport                             m_MemoryReport;
+    bool                                                m_Compiled = false;
+};
@@ -0,0 +1,380 @@
+#include "SoftwareOcclusion.h"
+#include "CpuProfiler.h"
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#if defined(_MSC_VER)
+#include <intrin.h>
+#endif
+
+// Cleared depth, farther than anything a projection produces
+static constexpr float s_FarDepth = 1e30f;
+// Vertices closer to the eye plane are not projected
+static constexpr float s_MinClipW = 1e-4f;
+
+bool SoftwareOcclusion::IsAvx2Supported()
+{
+    static const bool supported = []()
+    {
+        if(!IsOcclusionAvx2Compiled())
+            return false;
+#if defined(_MSC_VER)
+        int info[4];
+        __cpuid(info, 1);
+        const bool fma = (info[2] & (1 << 12)) != 0;
+        const bool osxsave = (info[2] & (1 << 27)) != 0;
+        if(!fma || !osxsave || (_xgetbv(0) & 0x6) != 0x6)
+            return false;
+        __cpuidex(info, 7, 0);
+        return (info[1] & (1 << 5)) != 0;
+#elif defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+        return __builtin_cpu_supports("avx2") && __builtin_cpu_supports("fma");
+#else
+        return false;
+#endif
+    }();
+    return supported;
+}
+
+void SoftwareOcclusion::Init(uint32_t inWidth, uint32_t inHeight)
+{
+    m_TilesX = std::max(1u, (inWidth + s_TileWidth - 1) / s_TileWidth);
+    m_TilesY = std::max(1u, (inHeight + s_TileHeight - 1) / s_TileHeight);
+    m_ZMax0.resize(m_TilesX * m_TilesY);
+    m_ZMax1.resize(m_TilesX * m_TilesY);
+    m_Mask.resize(m_TilesX * m_TilesY * s_TileHeight);
+    m_UseAvx2 = IsAvx2Supported();
+    Clear();
+}
+
+void SoftwareOcclusion::Clear()
+{
+    std::fill(m_ZMax0.begin(), m_ZMax0.end(), s_FarDepth);
+    std::fill(m_ZMax1.begin(), m_ZMax1.end(), 0.0f);
+    std::fill(m_Mask.begin(), m_Mask.end(), 0u);
+    m_Stats = Stats();
+}
+
+OcclusionTileBuffer SoftwareOcclusion::GetTileBuffer()
+{
+    OcclusionTileBuffer tiles;
+    tiles.ZMax0 = m_ZMax0.data();
+    tiles.ZMax1 = m_ZMax1.data();
+    tiles.Mask = m_Mask.data();
+    tiles.TilesX = m_TilesX;
+    tiles.TilesY = m_TilesY;
+    return tiles;
+}
+
+void SoftwareOcclusion::RenderOccluder(const float* inPositions, uint32_t inStride, const uint32_t* inIndices, uint32_t inIndexCount
+    , const glm::mat4& inLocalToClip, bool inCullBackFaces)
+{
+    PROFILE_ZONE("RenderOccluder");
+    if(m_TilesX == 0 || inIndexCount < 3)
+        return;
+
+    // Every vertex is projected once, the index list is usually far longer than the vertex list
+    uint32_t vertexCount = 0;
+    for(uint32_t i = 0; i < inIndexCount; ++i)
+        vertexCount = std::max(vertexCount, inIndices[i] + 1);
+
+    const float width = static_cast<float>(GetWidth());
+    const float height = static_cast<float>(GetHeight());
+    m_ScreenPositions.resize(vertexCount);
+    const uint8_t* position = reinterpret_cast<const uint8_t*>(inPositions);
+    for(uint32_t i = 0; i < vertexCount; ++i, position += inStride)
+    {
+        const float* xyz = reinterpret_cast<const float*>(position);
+        const glm::vec4 clip = inLocalToClip * glm::vec4(xyz[0], xyz[1], xyz[2], 1.0f);
+        if(clip.w < s_MinClipW)
+        {
+            m_ScreenPositions[i] = glm::vec4(0.0f, 0.0f, 0.0f, -1.0f);
+            continue;
+        }
+        const float invW = 1.0f / clip.w;
+        m_ScreenPositions[i] = glm::vec4((clip.x * invW * 0.5f + 0.5f) * width, (0.5f - clip.y * invW * 0.5f) * height, clip.z * invW, clip.w);
+    }
+
+    m_Triangles.clear();
+    for(uint32_t i = 0; i + 2 < inIndexCount; i += 3)
+    {
+        glm::vec4 v0 = m_ScreenPositions[inIndices[i]];
+        glm::vec4 v1 = m_ScreenPositions[inIndices[i + 1]];
+        glm::vec4 v2 = m_ScreenPositions[inIndices[i + 2]];
+        ++m_Stats.OccluderTriangles;
+        if(v0.w < 0.0f || v1.w < 0.0f || v2.w < 0.0f)
+            continue;
+
+        // Positive for clockwise triangles with y pointing down
+        float area = (v1.x - v0.x) * (v2.y - v0.y) - (v2.x - v0.x) * (v1.y - v0.y);
+        if(area <= 0.0f)
+        {
+            if(inCullBackFaces || area == 0.0f)
+                continue;
+            std::swap(v1, v2);
+            area = -area;
+        }
+
+        const float minX = std::min({v0.x, v1.x, v2.x});
+        const float maxX = std::max({v0.x, v1.x, v2.x});
+        const float minY = std::min({v0.y, v1.y, v2.y});
+        const float maxY = std::max({v0.y, v1.y, v2.y});
+        if(maxX < 0.0f || maxY < 0.0f || minX >= width || minY >= height)
+            continue;
+
+        OcclusionTriangle triangle;
+        triangle.TileMinX = static_cast<uint32_t>(std::max(minX, 0.0f)) / s_TileWidth;
+        triangle.TileMinY = static_cast<uint32_t>(std::max(minY, 0.0f)) / s_TileHeight;
+        triangle.TileMaxX = std::min(static_cast<uint32_t>(std::min(maxX, width - 1.0f)) / s_TileWidth, m_TilesX - 1);
+        triangle.TileMaxY = std::min(static_cast<uint32_t>(std::min(maxY, height - 1.0f)) / s_TileHeight, m_TilesY - 1);
+
+        // Edge a -> b is (a.y - b.y) * x + (b.x - a.x) * y + C, positive inside for a positive area
+        const glm::vec4* vertices[3] = { &v0, &v1, &v2 };
+        triangle.LeftEdges = 0;
+        triangle.RightEdges = 0;
+        for(uint32_t edge = 0; edge < 3; ++edge)
+        {
+            const glm::vec4& a = *vertices[edge];
+            const glm::vec4& b = *vertices[(edge + 1) % 3];
+            const float edgeA = a.y - b.y;
+            const float edgeB = b.x - a.x;
+            triangle.EdgeB[edge] = edgeB;
+            triangle.EdgeC[edge] = -(edgeA * a.x + edgeB * a.y);
+            triangle.InvA[edge] = edgeA != 0.0f ? -1.0f / edgeA : 0.0f;
+            if(edgeA > 0.0f)
+                triangle.LeftEdges |= 1u << edge;
+            else if(edgeA < 0.0f)
+                triangle.RightEdges |= 1u << edge;
+        }
+
+        const float invArea = 1.0f / area;
+        triangle.ZPlane[0] = ((v1.z - v0.z) * (v2.y - v0.y) - (v2.z - v0.z) * (v1.y - v0.y)) * invArea;
+        triangle.ZPlane[1] = ((v2.z - v0.z) * (v1.x - v0.x) - (v1.z - v0.z) * (v2.x - v0.x)) * invArea;
+        triangle.ZPlane[2] = v0.z - triangle.ZPlane[0] * v0.x - triangle.ZPlane[1] * v0.y;
+        triangle.ZMax = std::max({v0.z, v1.z, v2.z});
+        m_Triangles.push_back(triangle);
+    }
+
+    const OcclusionTileBuffer tiles = GetTileBuffer();
+    const uint32_t triangleCount = static_cast<uint32_t>(m_Triangles.size());
+    m_Stats.RasterizedTriangles += m_UseAvx2
+        ? RasterizeOcclusionTrianglesAvx2(m_Triangles.data(), triangleCount, tiles)
+        : RasterizeOcclusionTrianglesScalar(m_Triangles.data(), triangleCount, tiles);
+}
+
+OcclusionTestTarget SoftwareOcclusion::GetTestTarget(const glm::mat4& inToClip) const
+{
+    OcclusionTestTarget target;
+    target.ZMax0 = m_ZMax0.data();
+    target.TilesX = m_TilesX;
+    target.TilesY = m_TilesY;
+    memcpy(target.ToClip, &inToClip[0][0], sizeof(target.ToClip));
+    return target;
+}
+
+bool SoftwareOcclusion::IsVisible(const OcclusionBox& inBox, const glm::mat4& inToClip) const
+{
+    uint32_t index;
+    return m_TilesX > 0 && TestOcclusionBoxesScalar(&inBox.Min.x, 1, GetTestTarget(inToClip), &index) == 1;
+}
+
+void SoftwareOcclusion::TestBoxes(const OcclusionBox* inBoxes, uint32_t inCount, const glm::mat4& inWorldToClip, std::vector<uint32_t>& outVisible)
+{
+    static_assert(sizeof(OcclusionBox) == 6 * sizeof(float), "The kernels read boxes as 6 floats");
+    PROFILE_ZONE("TestOccludees");
+    if(m_TilesX == 0 || inCount == 0)
+        return;
+
+    const size_t first = outVisible.size();
+    outVisible.resize(first + inCount);
+    const OcclusionTestTarget target = GetTestTarget(inWorldToClip);
+    const uint32_t visible = m_UseAvx2
+        ? TestOcclusionBoxesAvx2(&inBoxes[0].Min.x, inCount, target, outVisible.data() + first)
+        : TestOcclusionBoxesScalar(&inBoxes[0].Min.x, inCount, target, outVisible.data() + first);
+    outVisible.resize(first + visible);
+    m_Stats.TestedBoxes += inCount;
+    m_Stats.VisibleBoxes += visible;
+}
+
+void UpdateOcclusionTile(const OcclusionTileBuffer& inTiles, uint32_t inTile, const uint32_t inRowMasks[8], float inZ)
+{
+    float& zMax0 = inTiles.ZMax0[inTile];
+    // Behind what already hides the whole tile
+    if(inZ >= zMax0)
+        return;
+
+    float& zMax1 = inTiles.ZMax1[inTile];
+    uint32_t* mask = inTiles.Mask + inTile * SoftwareOcclusion::s_TileHeight;
+    uint32_t triangleFull = ~0u;
+    uint32_t mergedFull = ~0u;
+    uint32_t workingAny = 0;
+    for(uint32_t row = 0; row < SoftwareOcclusion::s_TileHeight; ++row)
+    {
+        triangleFull &= inRowMasks[row];
+        mergedFull &= mask[row] | inRowMasks[row];
+        workingAny |= mask[row];
+    }
+
+    if(triangleFull == ~0u)
+    {
+        zMax0 = inZ;
+        if(zMax1 >= inZ)
+        {
+            std::fill(mask, mask + SoftwareOcclusion::s_TileHeight, 0u);
+            zMax1 = 0.0f;
+        }
+        return;
+    }
+
+    if(workingAny == 0)
+    {
+        std::copy(inRowMasks, inRowMasks + SoftwareOcclusion::s_TileHeight, mask);
+        zMax1 = inZ;
+        return;
+    }
+
+    const float mergedZ = std::max(zMax1, inZ);
+    if(mergedFull == ~0u)
+    {
+        zMax0 = std::min(zMax0, mergedZ);
+        std::fill(mask, mask + SoftwareOcclusion::s_TileHeight, 0u);
+        zMax1 = 0.0f;
+        return;
+    }
+
+    // A triangle closer to the conservative depth than to the working layer would push the layer back until it is
+    // of no use, it is left out instead
+    if(inZ - zMax1 > zMax0 - inZ)
+        return;
+    for(uint32_t row = 0; row < SoftwareOcclusion::s_TileHeight; ++row)
+        mask[row] |= inRowMasks[row];
+    zMax1 = mergedZ;
+}
+
+uint32_t RasterizeOcclusionTrianglesScalar(const OcclusionTriangle* inTriangles, uint32_t inCount, const OcclusionTileBuffer& inTiles)
+{
+    uint32_t rasterized = 0;
+    for(uint32_t i = 0; i < inCount; ++i)
+    {
+        const OcclusionTriangle& triangle = inTriangles[i];
+        bool touched = false;
+        for(uint32_t tileY = triangle.TileMinY; tileY <= triangle.TileMaxY; ++tileY)
+        {
+            const float rowY = static_cast<float>(tileY * SoftwareOcclusion::s_TileHeight);
+            float left[SoftwareOcclusion::s_TileHeight];
+            float right[SoftwareOcclusion::s_TileHeight];
+            for(uint32_t row = 0; row < SoftwareOcclusion::s_TileHeight; ++row)
+            {
+                const float y = rowY + static_cast<float>(row) + 0.5f;
+                left[row] = -s_FarDepth;
+                right[row] = s_FarDepth;
+                for(uint32_t edge = 0; edge < 3; ++edge)
+                {
+                    const float distance = triangle.EdgeB[edge] * y + triangle.EdgeC[edge];
+                    if(triangle.LeftEdges & (1u << edge))
+                        left[row] = std::max(left[row], distance * triangle.InvA[edge]);
+                    else if(triangle.RightEdges & (1u << edge))
+                        right[row] = std::min(right[row], distance * triangle.InvA[edge]);
+                    else if(distance < 0.0f)
+                        left[row] = s_FarDepth;
+                }
+            }
+
+            const float zRowTerm = triangle.ZPlane[1] > 0.0f ? triangle.ZPlane[1] * (rowY + 8.0f) : triangle.ZPlane[1] * rowY;
+            for(uint32_t tileX = triangle.TileMinX; tileX <= triangle.TileMaxX; ++tileX)
+            {
+                const float columnX = static_cast<float>(tileX * SoftwareOcclusion::s_TileWidth);
+                uint32_t masks[SoftwareOcclusion::s_TileHeight];
+                uint32_t any = 0;
+                for(uint32_t row = 0; row < SoftwareOcclusion::s_TileHeight; ++row)
+                {
+                    const float start = std::min(std::max(std::ceil(left[row] - columnX - 0.5f), 0.0f), 32.0f);
+                    const float end = std::min(std::max(std::floor(right[row] - columnX - 0.5f) + 1.0f, 0.0f), 32.0f);
+                    const uint32_t startBit = static_cast<uint32_t>(start);
+                    const uint32_t endBit = static_cast<uint32_t>(end);
+                    const uint32_t startBits = startBit < 32 ? ~0u << startBit : 0u;
+                    const uint32_t endBits = endBit < 32 ? ~0u << endBit : 0u;
+                    masks[row] = startBits & ~endBits;
+                    any |= masks[row];
+                }
+                if(any == 0)
+                    continue;
+
+                const float zColumnTerm = triangle.ZPlane[0] > 0.0f ? triangle.ZPlane[0] * (columnX + 32.0f) : triangle.ZPlane[0] * columnX;
+                const float z = std::min(triangle.ZPlane[2] + zColumnTerm + zRowTerm, triangle.ZMax);
+                UpdateOcclusionTile(inTiles, tileY * inTiles.TilesX + tileX, masks, z);
+                touched = true;
+            }
+        }
+        rasterized += touched ? 1 : 0;
+    }
+    return rasterized;
+}
+
+bool TestOcclusionRect(const OcclusionTestTarget& inTarget, float inMinX, float inMinY, float inMaxX, float inMaxY, float inZMin)
+{
+    const float width = static_cast<float>(inTarget.TilesX * SoftwareOcclusion::s_TileWidth);
+    const float height = static_cast<float>(inTarget.TilesY * SoftwareOcclusion::s_TileHeight);
+    const float left = std::max((inMinX * 0.5f + 0.5f) * width, 0.0f);
+    const float right = std::min((inMaxX * 0.5f + 0.5f) * width, width - 1.0f);
+    const float top = std::max((0.5f - inMaxY * 0.5f) * height, 0.0f);
+    const float bottom = std::min((0.5f - inMinY * 0.5f) * height, height - 1.0f);
+    const uint32_t tileMinX = static_cast<uint32_t>(left) / SoftwareOcclusion::s_TileWidth;
+    const uint32_t tileMaxX = static_cast<uint32_t>(right) / SoftwareOcclusion::s_TileWidth;
+    const uint32_t tileMinY = static_cast<uint32_t>(top) / SoftwareOcclusion::s_TileHeight;
+    const uint32_t tileMaxY = static_cast<uint32_t>(bottom) / SoftwareOcclusion::s_TileHeight;
+    for(uint32_t y = tileMinY; y <= tileMaxY; ++y)
+    {
+        const float* row = inTarget.ZMax0 + y * inTarget.TilesX;
+        for(uint32_t x = tileMinX; x <= tileMaxX; ++x)
+        {
+            if(inZMin < row[x])
+                return true;
+        }
+    }
+    return false;
+}
+
+uint32_t TestOcclusionBoxesScalar(const float* inBoxes, uint32_t inCount, const OcclusionTestTarget& inTarget, uint32_t* outVisible)
+{
+    const float* m = inTarget.ToClip;
+    uint32_t visible = 0;
+    for(uint32_t i = 0; i < inCount; ++i)
+    {
+        const float* box = inBoxes + i * 6;
+        float minX = s_FarDepth, minY = s_FarDepth, minZ = s_FarDepth, maxX = -s_FarDepth, maxY = -s_FarDepth;
+        uint32_t behind = 0;
+        for(uint32_t corner = 0; corner < 8; ++corner)
+        {
+            const float x = (corner & 1) ? box[3] : box[0];
+            const float y = (corner & 2) ? box[4] : box[1];
+            const float z = (corner & 4) ? box[5] : box[2];
+            const float clipW = m[3] * x + m[7] * y + m[11] * z + m[15];
+            if(clipW < s_MinClipW)
+            {
+                ++behind;
+                continue;
+            }
+            const float invW = 1.0f / clipW;
+            const float ndcX = (m[0] * x + m[4] * y + m[8] * z + m[12]) * invW;
+            const float ndcY = (m[1] * x + m[5] * y + m[9] * z + m[13]) * invW;
+            minX = std::min(minX, ndcX);
+            maxX = std::max(maxX, ndcX);
+            minY = std::min(minY, ndcY);
+            maxY = std::max(maxY, ndcY);
+            minZ = std::min(minZ, (m[2] * x + m[6] * y + m[10] * z + m[14]) * invW);
+        }
+
+        bool isVisible;
+        // Reaching behind the camera, nothing is known about the box unless all of it is back there
+        if(behind > 0)
+            isVisible = behind < 8;
+        else if(maxX < -1.0f || minX > 1.0f || maxY < -1.0f || minY > 1.0f)
+            isVisible = false;
+        else
+            isVisible = TestOcclusionRect(inTarget, minX, minY, maxX, maxY, minZ);
+        if(isVisible)
+            outVisible[visible++] = i;
+    }
+    return visible;
+}
@@ -0,0 +1,71 @@
+#pragma once
+#include <cstdint>
+#include <vector>
+#include <glm/glm.hpp>
+
+#include "SoftwareOcclusionKernels.h"
+
+struct OcclusionBox
+{
+    glm::vec3 Min;
+    glm::vec3 Max;
+};
+
+// CPU occlusion culling after masked occlusion culling (Hasselgren et al. 2016). Occluders are rasterized into a low
+// resolution buffer of 32x8 pixel tiles. Every tile keeps a conservative depth for all of its pixels plus a working
+// layer, a coverage mask and the depth of the triangles merged into it so far, which replaces the conservative depth
+// once it covers the tile. Occludees are tested as screen rectangles against the conservative depth. The row masks
+// of a tile are computed 8 at a time with AVX2 when the CPU supports it.
+//
+// Depth is z / w of the clip space the matrices map to, whatever the projection convention is, smaller is nearer.
+class SoftwareOcclusion
+{
+public:
+    static constexpr uint32_t s_TileWidth = 32;
+    static constexpr uint32_t s_TileHeight = 8;
+
+    struct Stats
+    {
+        uint32_t OccluderTriangles = 0;     // submitted since the last Clear()
+        uint32_t RasterizedTriangles = 0;   // of those, the ones that covered a pixel center
+        uint32_t TestedBoxes = 0;
+        uint32_t VisibleBoxes = 0;
+    };
+
+    // Rounded up to whole tiles, a few hundred pixels wide is enough for culling
+    void Init(uint32_t inWidth, uint32_t inHeight);
+    void Clear();
+
+    // Indexed triangle list, positions are 3 floats inStride bytes apart. Triangles reaching behind the camera are
+    // skipped, which only makes the occluder smaller. Culled back faces are counterclockwise on screen, as in D3D12.
+    void RenderOccluder(const float* inPositions, uint32_t inStride, const uint32_t* inIndices, uint32_t inIndexCount
+        , const glm::mat4& inLocalToClip, bool inCullBackFaces = true);
+
+    // Boxes outside of the frustum count as hidden
+    bool IsVisible(const OcclusionBox& inBox, const glm::mat4& inToClip) const;
+    // Appends the index of every visible box
+    void TestBoxes(const OcclusionBox* inBoxes, uint32_t inCount, const glm::mat4& inWorldToClip, std::vector<uint32_t>& outVisible);
+
+    // Enabled by Init() when supported, switching it off is meant for comparisons
+    void SetAvx2Enabled(bool inEnabled) { m_UseAvx2 = inEnabled && IsAvx2Supported(); }
+    bool IsAvx2Enabled() const { return m_UseAvx2; }
+    static bool IsAvx2Supported();
+
+    uint32_t GetWidth() const { return m_TilesX * s_TileWidth; }
+    uint32_t GetHeight() const { return m_TilesY * s_TileHeight; }
+    const Stats& GetStats() const { return m_Stats; }
+
+private:
+    OcclusionTileBuffer GetTileBuffer();
+    OcclusionTestTarget GetTestTarget(const glm::mat4& inToClip) const;
+
+    uint32_t                        m_TilesX = 0;
+    uint32_t                        m_TilesY = 0;
+    std::vector<float>              m_ZMax0;
+    std::vector<float>              m_ZMax1;
+    std::vector<uint32_t>           m_Mask;
+    std::vector<glm::vec4>          m_ScreenPositions;  // x, y in pixels, z / w, w, reused between occluders
+    std::vector<OcclusionTriangle>  m_Triangles;
+    bool                            m_UseAvx2 = false;
+    Stats                           m_Stats;
+};
@@ -0,0 +1,184 @@
+#include "SoftwareOcclusionKernels.h"
+
+#if defined(__AVX2__)
+#include <immintrin.h>
+
+bool IsOcclusionAvx2Compiled()
+{
+    return true;
+}
+
+// The 8 lanes are the 8 pixel rows of a tile: the span of every row is intersected from the edges, then turned into
+// the 32 bit coverage mask of the row with variable shifts
+uint32_t RasterizeOcclusionTrianglesAvx2(const OcclusionTriangle* inTriangles, uint32_t inCount, const OcclusionTileBuffer& inTiles)
+{
+    const __m256 rowCenters = _mm256_setr_ps(0.5f, 1.5f, 2.5f, 3.5f, 4.5f, 5.5f, 6.5f, 7.5f);
+    const __m256 zero = _mm256_setzero_ps();
+    const __m256 one = _mm256_set1_ps(1.0f);
+    const __m256 tileWidth = _mm256_set1_ps(32.0f);
+    const __m256 farLeft = _mm256_set1_ps(-1e30f);
+    const __m256 farRight = _mm256_set1_ps(1e30f);
+    const __m256i allOnes = _mm256_set1_epi32(-1);
+
+    uint32_t rasterized = 0;
+    for(uint32_t i = 0; i < inCount; ++i)
+    {
+        const OcclusionTriangle& triangle = inTriangles[i];
+        bool touched = false;
+        for(uint32_t tileY = triangle.TileMinY; tileY <= triangle.TileMaxY; ++tileY)
+        {
+            const float rowY = static_cast<float>(tileY * 8);
+            const __m256 y = _mm256_add_ps(_mm256_set1_ps(rowY), rowCenters);
+
+            // The spans do not depend on the tile column
+            __m256 left = farLeft;
+            __m256 right = farRight;
+            for(uint32_t edge = 0; edge < 3; ++edge)
+            {
+                const __m256 distance = _mm256_fmadd_ps(_mm256_set1_ps(triangle.EdgeB[edge]), y, _mm256_set1_ps(triangle.EdgeC[edge]));
+                if(triangle.LeftEdges & (1u << edge))
+                    left = _mm256_max_ps(left, _mm256_mul_ps(distance, _mm256_set1_ps(triangle.InvA[edge])));
+                else if(triangle.RightEdges & (1u << edge))
+                    right = _mm256_min_ps(right, _mm256_mul_ps(distance, _mm256_set1_ps(triangle.InvA[edge])));
+                else
+                    left = _mm256_blendv_ps(left, farRight, _mm256_cmp_ps(distance, zero, _CMP_LT_OQ));
+            }
+
+            const float zRowTerm = triangle.ZPlane[1] > 0.0f ? triangle.ZPlane[1] * (rowY + 8.0f) : triangle.ZPlane[1] * rowY;
+            for(uint32_t tileX = triangle.TileMinX; tileX <= triangle.TileMaxX; ++tileX)
+            {
+                // Pixel j is covered when left <= x0 + j <= right, x0 being the center of the first pixel
+                const float columnX = static_cast<float>(tileX * 32);
+                const __m256 x0 = _mm256_set1_ps(columnX + 0.5f);
+                __m256 start = _mm256_ceil_ps(_mm256_sub_ps(left, x0));
+                __m256 end = _mm256_add_ps(_mm256_floor_ps(_mm256_sub_ps(right, x0)), one);
+                start = _mm256_min_ps(_mm256_max_ps(start, zero), tileWidth);
+                end = _mm256_min_ps(_mm256_max_ps(end, zero), tileWidth);
+                // Shifts of 32 yield 0, which covers empty and full spans
+                const __m256i startBits = _mm256_sllv_epi32(allOnes, _mm256_cvttps_epi32(start));
+                const __m256i endBits = _mm256_sllv_epi32(allOnes, _mm256_cvttps_epi32(end));
+                const __m256i rowMasks = _mm256_andnot_si256(endBits, startBits);
+                if(_mm256_testz_si256(rowMasks, rowMasks))
+                    continue;
+
+                // The plane at the farthest tile corner, never farther than the farthest vertex
+                const float zColumnTerm = triangle.ZPlane[0] > 0.0f ? triangle.ZPlane[0] * (columnX + 32.0f) : triangle.ZPlane[0] * columnX;
+                float z = triangle.ZPlane[2] + zColumnTerm + zRowTerm;
+                z = z < triangle.ZMax ? z : triangle.ZMax;
+
+                alignas(32) uint32_t masks[8];
+                _mm256_store_si256(reinterpret_cast<__m256i*>(masks), rowMasks);
+                UpdateOcclusionTile(inTiles, tileY * inTiles.TilesX + tileX, masks, z);
+                touched = true;
+            }
+        }
+        rasterized += touched ? 1 : 0;
+    }
+    return rasterized;
+}
+
+// One box per lane, the 8 corners are projected one after the other and reduced to a rectangle, only the tiles are
+// then looked up per box
+uint32_t TestOcclusionBoxesAvx2(const float* inBoxes, uint32_t inCount, const OcclusionTestTarget& inTarget, uint32_t* outVisible)
+{
+    __m256 matrix[16];
+    for(uint32_t i = 0; i < 16; ++i)
+        matrix[i] = _mm256_set1_ps(inTarget.ToClip[i]);
+    const __m256i boxOffsets = _mm256_setr_epi32(0, 6, 12, 18, 24, 30, 36, 42);
+    const __m256 minClipW = _mm256_set1_ps(1e-4f);
+    const __m256 one = _mm256_set1_ps(1.0f);
+    const __m256 minusOne = _mm256_set1_ps(-1.0f);
+
+    uint32_t visible = 0;
+    uint32_t first = 0;
+    for(; first + 8 <= inCount; first += 8)
+    {
+        const float* boxes = inBoxes + first * 6;
+        __m256 bounds[6];
+        for(uint32_t i = 0; i < 6; ++i)
+            bounds[i] = _mm256_i32gather_ps(boxes + i, boxOffsets, 4);
+
+        __m256 minX = _mm256_set1_ps(1e30f);
+        __m256 minY = minX;
+        __m256 minZ = minX;
+        __m256 maxX = _mm256_set1_ps(-1e30f);
+        __m256 maxY = maxX;
+        __m256 anyBehind = _mm256_setzero_ps();
+        __m256 allBehind = _mm256_castsi256_ps(_mm256_set1_epi32(-1));
+        for(uint32_t corner = 0; corner < 8; ++corner)
+        {
+            const __m256 x = (corner & 1) ? bounds[3] : bounds[0];
+            const __m256 y = (corner & 2) ? bounds[4] : bounds[1];
+            const __m256 z = (corner & 4) ? bounds[5] : bounds[2];
+            const __m256 clipX = _mm256_fmadd_ps(matrix[0], x, _mm256_fmadd_ps(matrix[4], y, _mm256_fmadd_ps(matrix[8], z, matrix[12])));
+            const __m256 clipY = _mm256_fmadd_ps(matrix[1], x, _mm256_fmadd_ps(matrix[5], y, _mm256_fmadd_ps(matrix[9], z, matrix[13])));
+            const __m256 clipZ = _mm256_fmadd_ps(matrix[2], x, _mm256_fmadd_ps(matrix[6], y, _mm256_fmadd_ps(matrix[10], z, matrix[14])));
+            const __m256 clipW = _mm256_fmadd_ps(matrix[3], x, _mm256_fmadd_ps(matrix[7], y, _mm256_fmadd_ps(matrix[11], z, matrix[15])));
+            const __m256 behind = _mm256_cmp_ps(clipW, minClipW, _CMP_LT_OQ);
+            anyBehind = _mm256_or_ps(anyBehind, behind);
+            allBehind = _mm256_and_ps(allBehind, behind);
+
+            // Lanes with a corner behind the camera are decided without the rectangle
+            const __m256 invW = _mm256_div_ps(one, clipW);
+            const __m256 ndcX = _mm256_mul_ps(clipX, invW);
+            const __m256 ndcY = _mm256_mul_ps(clipY, invW);
+            minX = _mm256_min_ps(minX, ndcX);
+            maxX = _mm256_max_ps(maxX, ndcX);
+            minY = _mm256_min_ps(minY, ndcY);
+            maxY = _mm256_max_ps(maxY, ndcY);
+            minZ = _mm256_min_ps(minZ, _mm256_mul_ps(clipZ, invW));
+        }
+
+        const __m256 outside = _mm256_or_ps(_mm256_or_ps(_mm256_cmp_ps(maxX, minusOne, _CMP_LT_OQ), _mm256_cmp_ps(minX, one, _CMP_GT_OQ))
+            , _mm256_or_ps(_mm256_cmp_ps(maxY, minusOne, _CMP_LT_OQ), _mm256_cmp_ps(minY, one, _CMP_GT_OQ)));
+        const int anyBehindMask = _mm256_movemask_ps(anyBehind);
+        const int allBehindMask = _mm256_movemask_ps(allBehind);
+        const int outsideMask = _mm256_movemask_ps(outside);
+
+        alignas(32) float rectMinX[8], rectMinY[8], rectMaxX[8], rectMaxY[8], rectMinZ[8];
+        _mm256_store_ps(rectMinX, minX);
+        _mm256_store_ps(rectMinY, minY);
+        _mm256_store_ps(rectMaxX, maxX);
+        _mm256_store_ps(rectMaxY, maxY);
+        _mm256_store_ps(rectMinZ, minZ);
+        for(uint32_t lane = 0; lane < 8; ++lane)
+        {
+            bool isVisible;
+            if(anyBehindMask & (1 << lane))
+                isVisible = (allBehindMask & (1 << lane)) == 0;
+            else if(outsideMask & (1 << lane))
+                isVisible = false;
+            else
+                isVisible = TestOcclusionRect(inTarget, rectMinX[lane], rectMinY[lane], rectMaxX[lane], rectMaxY[lane], rectMinZ[lane]);
+            if(isVisible)
+                outVisible[visible++] = first + lane;
+        }
+    }
+
+    if(first < inCount)
+    {
+        const uint32_t tailVisible = TestOcclusionBoxesScalar(inBoxes + first * 6, inCount - first, inTarget, outVisible + visible);
+        for(uint32_t i = 0; i < tailVisible; ++i)
+            outVisible[visible + i] += first;
+        visible += tailVisible;
+    }
+    return visible;
+}
+
+#else
+
+bool IsOcclusionAvx2Compiled()
+{
+    return false;
+}
+
+uint32_t RasterizeOcclusionTrianglesAvx2(const OcclusionTriangle* inTriangles, uint32_t inCount, const OcclusionTileBuffer& inTiles)
+{
+    return RasterizeOcclusionTrianglesScalar(inTriangles, inCount, inTiles);
+}
+
+uint32_t TestOcclusionBoxesAvx2(const float* inBoxes, uint32_t inCount, const OcclusionTestTarget& inTarget, uint32_t* outVisible)
+{
+    return TestOcclusionBoxesScalar(inBoxes, inCount, inTarget, outVisible);
+}
+#endif
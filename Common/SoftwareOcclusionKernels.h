@@ -0,0 +1,58 @@
+#pragma once
+#include <cstdint>
+
+// Inner loops of SoftwareOcclusion. SoftwareOcclusionAvx2.cpp is compiled with AVX2 enabled and must not share inline
+// code with the rest of the program (glm, the standard library), the linker could otherwise keep its AVX2 copy for
+// every caller. Only plain data crosses this header.
+
+struct OcclusionTileBuffer
+{
+    float*      ZMax0;          // per tile, the conservative depth of the whole tile
+    float*      ZMax1;          // per tile, the depth of the working layer
+    uint32_t*   Mask;           // 8 rows of 32 bits per tile, the pixels covered by the working layer
+    uint32_t    TilesX;
+    uint32_t    TilesY;
+};
+
+// Screen space triangle in pixels, set up by SoftwareOcclusion
+struct OcclusionTriangle
+{
+    // Edge i is A * x + B * y + C >= 0 inside, so a row at y is bounded at x = (B * y + C) * InvA
+    float       EdgeB[3];
+    float       EdgeC[3];
+    float       InvA[3];        // -1 / A, 0 for horizontal edges
+    float       ZPlane[3];      // depth = ZPlane[0] * x + ZPlane[1] * y + ZPlane[2]
+    float       ZMax;           // farthest vertex
+    uint32_t    TileMinX;
+    uint32_t    TileMinY;
+    uint32_t    TileMaxX;       // inclusive
+    uint32_t    TileMaxY;
+    uint32_t    LeftEdges;      // bit i set when edge i bounds the spans from the left (A > 0)
+    uint32_t    RightEdges;     // A < 0, edges in neither mask are horizontal and only reject whole rows
+};
+
+// Applies the coverage of one triangle to a tile. inZ is the farthest depth of the triangle inside the tile.
+void UpdateOcclusionTile(const OcclusionTileBuffer& inTiles, uint32_t inTile, const uint32_t inRowMasks[8], float inZ);
+
+// False when SoftwareOcclusionAvx2.cpp was built without AVX2, its functions then forward to the scalar ones
+bool IsOcclusionAvx2Compiled();
+
+// Return how many triangles touched at least one tile
+uint32_t RasterizeOcclusionTrianglesScalar(const OcclusionTriangle* inTriangles, uint32_t inCount, const OcclusionTileBuffer& inTiles);
+uint32_t RasterizeOcclusionTrianglesAvx2(const OcclusionTriangle* inTriangles, uint32_t inCount, const OcclusionTileBuffer& inTiles);
+
+struct OcclusionTestTarget
+{
+    const float*    ZMax0;
+    uint32_t        TilesX;
+    uint32_t        TilesY;
+    float           ToClip[16];     // column major, as glm stores it
+};
+
+// Boxes are 6 floats each, the min then the max corner. Writes the index of every visible box to outVisible and
+// returns how many there are. Boxes reaching behind the camera are visible, boxes outside of the frustum are not.
+uint32_t TestOcclusionBoxesScalar(const float* inBoxes, uint32_t inCount, const OcclusionTestTarget& inTarget, uint32_t* outVisible);
+uint32_t TestOcclusionBoxesAvx2(const float* inBoxes, uint32_t inCount, const OcclusionTestTarget& inTarget, uint32_t* outVisible);
+
+// True when any tile under the normalized device rectangle, which overlaps the screen, is not hidden at inZMin
+bool TestOcclusionRect(const OcclusionTestTarget& inTarget, float inMinX, float inMinY, float inMaxX, float inMaxY, float inZMin);
@@ -0,0 +1,73 @@
+#include "TraceEvent.h"
+#include "Log.h"
+#include <chrono>
+#include <fstream>
+
+uint64_t GetTraceTimeNs()
+{
+    return static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now().time_since_epoch()).count());
+}
+
+static void WriteJsonString(std::ofstream& inFile, const std::string& inText)
+{
+    inFile << '"';
+    for(char c : inText)
+    {
+        if(c == '"' || c == '\\')
+            inFile << '\\';
+        inFile << c;
+    }
+    inFile << '"';
+}
+
+bool WriteChromeTrace(const std::string& inPath, const std::vector<TraceEvent>& inEvents)
+{
+    std::ofstream file(inPath, std::ios::out | std::ios::trunc);
+    if(!file.is_open())
+    {
+        LOG_ERROR("[Trace] Failed to open %s", inPath.c_str());
+        return false;
+    }
+
+    // Timestamps are relative to the first event so the viewer does not start hours into the clock
+    uint64_t origin = UINT64_MAX;
+    for(const TraceEvent& event : inEvents)
+    {
+        if(event.Phase != ETracePhase::ThreadName)
+            origin = event.StartNs < origin ? event.StartNs : origin;
+    }
+
+    file << "{\"displayTimeUnit\": \"ns\", \"traceEvents\": [\n";
+    file << "{\"ph\": \"M\", \"name\": \"process_name\", \"pid\": " << TraceEvent::s_CpuProcess << ", \"args\": {\"name\": \"CPU\"}},\n";
+    file << "{\"ph\": \"M\", \"name\": \"process_name\", \"pid\": " << TraceEvent::s_GpuProcess << ", \"args\": {\"name\": \"GPU\"}}";
+    file.precision(3);
+    file << std::fixed;
+    for(const TraceEvent& event : inEvents)
+    {
+        if(event.Phase == ETracePhase::ThreadName)
+        {
+            file << ",\n{\"ph\": \"M\", \"name\": \"thread_name\", \"pid\": " << event.ProcessId << ", \"tid\": " << event.ThreadId << ", \"args\": {\"name\": ";
+            WriteJsonString(file, event.Name);
+            file << "}}";
+            continue;
+        }
+
+        static const char* const phases[] = { "X", "C", "i" };
+        file << ",\n{\"ph\": \"" << phases[static_cast<uint8_t>(event.Phase)] << "\", \"name\": ";
+        WriteJsonString(file, event.Name);
+        file << ", \"pid\": " << event.ProcessId
+            << ", \"tid\": " << event.ThreadId
+            << ", \"ts\": " << static_cast<double>(event.StartNs - origin) / 1000.0;
+        if(event.Phase == ETracePhase::Complete)
+            file << ", \"dur\": " << static_cast<double>(event.DurationNs) / 1000.0;
+        else if(event.Phase == ETracePhase::Counter)
+            file << ", \"args\": {\"value\": " << event.Value << "}";
+        else
+            file << ", \"s\": \"t\"";
+        file << "}";
+    }
+    file << "\n]}\n";
+
+    LOG_INFO("[Trace] %zu events written to %s", inEvents.size(), inPath.c_str());
+    return true;
+}
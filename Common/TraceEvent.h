@@ -0,0 +1,31 @@
+#pragma once
+#include <cstdint>
+#include <string>
+#include <vector>
+
+enum class ETracePhase : uint8_t
+{
+    Complete,   // "X", a zone with a duration
+    Counter,    // "C", Value at StartNs
+    Instant,    // "i", a marker at StartNs
+    ThreadName, // "M", names ThreadId of ProcessId after Name
+};
+
+// Events of the Chrome trace format, loads in chrome://tracing and ui.perfetto.dev
+struct TraceEvent
+{
+    static constexpr uint32_t s_CpuProcess = 0;
+    static constexpr uint32_t s_GpuProcess = 1;
+
+    std::string Name;
+    ETracePhase Phase = ETracePhase::Complete;
+    uint32_t    ProcessId = s_CpuProcess;
+    uint32_t    ThreadId = 0;
+    uint64_t    StartNs = 0;        // on the GetTraceTimeNs() clock
+    uint64_t    DurationNs = 0;
+    double      Value = 0.0;        // counters only
+};
+
+// Monotonic clock shared by every trace source, GPU timestamps are calibrated against it
+uint64_t GetTraceTimeNs();
+bool WriteChromeTrace(const std::string& inPath, const std::vector<TraceEvent>& inEvents);
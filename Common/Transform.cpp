@@ -1,4 +1,6 @@
 #include "Transform.h"
+#include "CpuProfiler.h"
+#include <algorithm>
 
 Transform::Transform()
     : m_Parent(nullptr)
@@ -200,6 +202,7 @@ void Transform::Reset()
 
 void Transform::GetTransformData(TransformData& outData) const
 {
+    PROFILE_ZONE("Transform::GetTransformData");
     GetLocalToWorldMatrix(outData.LocalToWorld);
     outData.WorldToLocal = glm::inverse(outData.LocalToWorld);
 }
@@ -233,6 +236,7 @@ void Transform::GetParentToLocalMatrix(glm::mat4& outMatrix) const
 
 glm::mat4 Transform::GetLocalToWorldMatrix() const
 {
+    PROFILE_ZONE("Transform::GetLocalToWorldMatrix");
     glm::mat4 localToWorld = GetLocalToParentMatrix();
     Transform* parent = m_Parent;
     while(parent != nullptr)
@@ -245,6 +249,7 @@ glm::mat4 Transform::GetLocalToWorldMatrix() const
 
 void Transform::GetLocalToWorldMatrix(glm::mat4& outMatrix) const
 {
+    PROFILE_ZONE("Transform::GetLocalToWorldMatrix");
     GetLocalToParentMatrix(outMatrix);
     Transform* parent = m_Parent;
     while(parent != nullptr)
@@ -263,6 +268,7 @@ glm::mat4 Transform::GetWorldToLocalMatrix() const
 
 void Transform::GetWorldToLocalMatrix(glm::mat4& outMatrix) const
 {
+    PROFILE_ZONE("Transform::GetWorldToLocalMatrix");
     outMatrix = GetWorldToLocalMatrix();
 }
 
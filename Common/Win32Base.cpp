@@ -1,15 +1,76 @@
 #include "Win32Base.h"
+#ifdef _WIN32
 #include <WindowsX.h>
+#endif
 #include <stdexcept>
 #include <chrono>
+#include <cmath>
+#include <algorithm>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
 
 #include "Log.h"
+#include "Camera.h"
+#include "CpuProfiler.h"
+#include "FramePacer.h"
 
-Win32Base::Win32Base(uint32_t inWidth, uint32_t inHeight, HINSTANCE inHInstance, const char* inTitle)
+RunOptions RunOptions::FromCommandLine(int argc, char** argv)
+{
+    RunOptions options;
+    for(int i = 1; i < argc; ++i)
+    {
+        const bool hasValue = i + 1 < argc;
+        if(strcmp(argv[i], "--headless") == 0)
+            options.Headless = true;
+        else if(strcmp(argv[i], "--benchmark") == 0)
+            options.Benchmark = true;
+        else if(strcmp(argv[i], "--frames") == 0 && hasValue)
+            options.FrameCount = static_cast<uint32_t>(std::max(1, atoi(argv[++i])));
+        else if(strcmp(argv[i], "--warmup") == 0 && hasValue)
+            options.WarmupFrames = static_cast<uint32_t>(std::max(0, atoi(argv[++i])));
+        else if(strcmp(argv[i], "--report") == 0 && hasValue)
+            options.ReportPath = argv[++i];
+        else if(strcmp(argv[i], "--baseline") == 0 && hasValue)
+            options.BaselinePath = argv[++i];
+        else if(strcmp(argv[i], "--tolerance") == 0 && hasValue)
+            options.TolerancePercent = std::max(0.0, atof(argv[++i]));
+        else if(strcmp(argv[i], "--timings") == 0 && hasValue)
+            options.TimingsPath = argv[++i];
+        else if(strcmp(argv[i], "--screenshot") == 0 && hasValue)
+            options.ScreenshotPath = argv[++i];
+        else if(strcmp(argv[i], "--trace") == 0 && hasValue)
+            options.TracePath = argv[++i];
+        else if(strcmp(argv[i], "--fps") == 0 && hasValue)
+            options.TargetFrameRate = std::max(0.0, atof(argv[++i]));
+        else if(strcmp(argv[i], "--validate-culling") == 0)
+            options.ValidateCulling = true;
+        else if(strcmp(argv[i], "--occlusion") == 0 && hasValue)
+            options.OcclusionMode = argv[++i];
+        else
+            LOG_WARNING("Unknown command line argument: %s", argv[i]);
+    }
+
+    const bool warmupGiven = std::find_if(argv, argv + argc, [](const char* arg) { return strcmp(arg, "--warmup") == 0; }) != argv + argc;
+    if(options.Benchmark && !warmupGiven)
+        options.WarmupFrames = 60;
+    return options;
+}
+
+Win32Base::Win32Base(uint32_t inWidth, uint32_t inHeight, HINSTANCE inHInstance, const char* inTitle, const RunOptions& inOptions)
         : m_Width(inWidth)
         , m_Height(inHeight)
         , m_hInstance(inHInstance)
+        , m_Options(inOptions)
+        , m_Title(inTitle)
 {
+#ifdef _WIN32
+    if(m_Options.Headless)
+    {
+        s_Listeners.push_back(this);
+        return;
+    }
+
     WNDCLASS wc;
     wc.style = CS_HREDRAW | CS_VREDRAW;
     wc.lpfnWndProc = MsgProc;
@@ -44,6 +105,12 @@ Win32Base::Win32Base(uint32_t inWidth, uint32_t inHeight, HINSTANCE inHInstance,
     {
         throw std::runtime_error("Failed to create window");
     }
+#else
+    if(!m_Options.Headless)
+    {
+        throw std::runtime_error("Only the headless mode is available on this platform, run with --headless");
+    }
+#endif
     
     s_Listeners.push_back(this);
 }
@@ -55,44 +122,236 @@ Win32Base::~Win32Base()
 
 void Win32Base::Run()
 {
-    if(!Init())
+    PROFILE_THREAD("Main");
+#if CPU_PROFILER_ENABLED
+    if(!m_Options.TracePath.empty())
+        LOG_INFO("[Trace] A CPU zone costs %.1f ns", CpuProfiler::MeasureZoneOverheadNs());
+#endif
+    if(m_Options.Benchmark && !Log::IsEnabled(Log::ELogLevel::Debug))
+        Log::Info("[Benchmark] A filtered log call costs %.2f ns", Log::MeasureFilteredCallNs());
+
+    bool initialized;
+    {
+        PROFILE_ZONE("Init");
+        initialized = Init();
+    }
+    if(!initialized)
     {
         Shutdown();
-        Log::Fatal("Failed to initialize application");
+        LOG_FATAL("Failed to initialize application");
         return;
     }
 
+    if(m_Options.IsFixedFrameCount())
+        RunFixedFrames();
+    else
+        RunWindowed();
+
+    if(!m_Options.TracePath.empty())
+        WriteTrace();
+    
+    Shutdown();
+}
+
+void Win32Base::RunWindowed()
+{
+#ifdef _WIN32
     ShowWindow(m_hWnd, SW_NORMAL);
     UpdateWindow(m_hWnd);
 
     // Main Loop
+    FramePacer pacer(m_Options.TargetFrameRate);
     auto lastTime = std::chrono::high_resolution_clock::now();
     auto startTime = std::chrono::high_resolution_clock::now();
-    MSG Msg = { 0 };
+    float accumulator = 0.0f;
+    uint64_t frameCount = 0;
     while (true)
     {
-        if (PeekMessage(&Msg, NULL, 0, 0, PM_REMOVE))
-        {
-            if (Msg.message == WM_QUIT)
-            {
-                m_IsRunning = false;
-                break;
-            }
-            TranslateMessage(&Msg);
-            DispatchMessageW(&Msg);
-        }
+        // Input is read after the wait so that it is as fresh as possible when the frame starts
+        pacer.WaitForNextFrame();
+        if(!PumpMessages())
+            break;
+        PROFILE_MARKER("Input");
         auto currentTime = std::chrono::high_resolution_clock::now();
         m_Timer.DeltaTime = std::chrono::duration<float, std::chrono::seconds::period>(currentTime - lastTime).count();
         m_Timer.TotalTimeSinceStart = std::chrono::duration<float, std::chrono::seconds::period>(currentTime - startTime).count();
         lastTime = currentTime;
+        if(frameCount++ > 0)
+            m_Timer.AddFrameTime(m_Timer.DeltaTime * 1000.0f);
+
+        PROFILE_ZONE("Frame");
+        accumulator += std::min(m_Timer.DeltaTime, s_MaxFrameDeltaTime);
+        while(accumulator >= s_FixedDeltaTime)
+        {
+            FixedUpdate(s_FixedDeltaTime);
+            accumulator -= s_FixedDeltaTime;
+        }
+        m_Timer.InterpolationAlpha = accumulator / s_FixedDeltaTime;
         Tick();
+
+        m_Timer.InputLatencyMs = std::chrono::duration<float, std::chrono::milliseconds::period>(std::chrono::high_resolution_clock::now() - currentTime).count();
+        PROFILE_COUNTER("Frame jitter (ms)", m_Timer.FrameJitterMs);
+        PROFILE_COUNTER("Input latency (ms)", m_Timer.InputLatencyMs);
     }
-    
-    Shutdown();
+
+    if(frameCount > 1)
+        Log::Info("[Run] %llu frames, average %.3f ms, jitter %.3f ms, input latency %.3f ms"
+            , static_cast<unsigned long long>(frameCount), m_Timer.AverageFrameTimeMs, m_Timer.FrameJitterMs, m_Timer.InputLatencyMs);
+#endif
+}
+
+void Win32Base::Timer::AddFrameTime(float inFrameTimeMs)
+{
+    constexpr float weight = 1.0f / 32.0f;
+    FrameTimeMs = inFrameTimeMs;
+    if(AverageFrameTimeMs == 0.0f)
+    {
+        AverageFrameTimeMs = inFrameTimeMs;
+        return;
+    }
+    AverageFrameTimeMs += (inFrameTimeMs - AverageFrameTimeMs) * weight;
+    FrameJitterMs += (std::abs(inFrameTimeMs - AverageFrameTimeMs) - FrameJitterMs) * weight;
+}
+
+bool Win32Base::PumpMessages()
+{
+#ifdef _WIN32
+    MSG Msg = { 0 };
+    while (PeekMessage(&Msg, NULL, 0, 0, PM_REMOVE))
+    {
+        if (Msg.message == WM_QUIT)
+        {
+            m_IsRunning = false;
+            return false;
+        }
+        TranslateMessage(&Msg);
+        DispatchMessageW(&Msg);
+    }
+#endif
+    return true;
+}
+
+void Win32Base::RunFixedFrames()
+{
+#ifdef _WIN32
+    if(m_hWnd != nullptr)
+    {
+        ShowWindow(m_hWnd, SW_NORMAL);
+        UpdateWindow(m_hWnd);
+    }
+#endif
+
+    // All examples look at the world origin
+    CameraOrbitPath cameraPath;
+    CameraBase* camera = m_Options.Benchmark ? GetBenchmarkCamera() : nullptr;
+    if(camera != nullptr)
+        cameraPath.Begin(*camera, glm::vec3(0.0f));
+
+    m_Benchmark.Reset();
+    std::vector<float> frameTimes;
+    frameTimes.reserve(m_Options.FrameCount);
+    const uint32_t totalFrames = m_Options.WarmupFrames + m_Options.FrameCount;
+    for(uint32_t i = 0; i < totalFrames; ++i)
+    {
+        if(!PumpMessages())
+        {
+            LOG_WARNING("[Run] The window was closed after %u of %u frames", i, totalFrames);
+            break;
+        }
+
+        m_Timer.DeltaTime = s_FixedDeltaTime;
+        m_Timer.TotalTimeSinceStart = s_FixedDeltaTime * static_cast<float>(i);
+        m_Timer.InterpolationAlpha = 0.0f;
+        if(camera != nullptr)
+            cameraPath.Apply(*camera, m_Timer.TotalTimeSinceStart);
+
+        // Tick waits for the GPU at the end of every frame, so this covers the whole frame
+        m_RecordingSamples = i >= m_Options.WarmupFrames;
+        if(i == m_Options.WarmupFrames && i > 0)
+            PROFILE_MARKER("Warmup done");
+        PROFILE_ZONE("Frame");
+        auto startTime = std::chrono::high_resolution_clock::now();
+        // One update per frame keeps the simulation identical across machines
+        FixedUpdate(s_FixedDeltaTime);
+        Tick();
+        auto endTime = std::chrono::high_resolution_clock::now();
+        if(m_RecordingSamples)
+        {
+            const float frameTime = std::chrono::duration<float, std::chrono::milliseconds::period>(endTime - startTime).count();
+            m_Timer.AddFrameTime(frameTime);
+            frameTimes.push_back(frameTime);
+            m_Benchmark.AddSample(Benchmark::s_CpuFrameMetric, frameTime);
+        }
+    }
+    m_RecordingSamples = false;
+    m_IsRunning = false;
+
+    if(frameTimes.empty())
+        return;
+
+    float totalTime = 0.0f;
+    for(float frameTime : frameTimes)
+        totalTime += frameTime;
+    Log::Info("[Run] %u frames, average %.3f ms, min %.3f ms, max %.3f ms, jitter %.3f ms"
+        , static_cast<uint32_t>(frameTimes.size())
+        , totalTime / static_cast<float>(frameTimes.size())
+        , *std::min_element(frameTimes.begin(), frameTimes.end())
+        , *std::max_element(frameTimes.begin(), frameTimes.end())
+        , m_Timer.FrameJitterMs);
+
+    if(!m_Options.TimingsPath.empty())
+        WriteFrameTimings(frameTimes);
+
+    if(!m_Options.ScreenshotPath.empty() && !SaveScreenshot(m_Options.ScreenshotPath))
+        LOG_ERROR("[Run] Failed to save the screenshot to %s", m_Options.ScreenshotPath.c_str());
+
+    if(m_Options.Benchmark)
+        FinishBenchmark();
+}
+
+void Win32Base::FinishBenchmark()
+{
+    m_Benchmark.LogReport();
+    if(!m_Options.ReportPath.empty())
+        m_Benchmark.WriteReport(m_Options.ReportPath, m_Title, m_Options.WarmupFrames);
+    if(!m_Options.BaselinePath.empty() && !m_Benchmark.CompareWithBaseline(m_Options.BaselinePath, m_Options.TolerancePercent))
+        m_ExitCode = 1;
+}
+
+void Win32Base::WriteTrace()
+{
+    std::vector<TraceEvent> events;
+    CpuProfiler::CollectTraceEvents(events);
+    CollectTraceEvents(events);
+    if(events.empty())
+        LOG_WARNING("[Trace] Nothing was profiled, %s only holds the process names", m_Options.TracePath.c_str());
+    WriteChromeTrace(m_Options.TracePath, events);
+}
+
+void Win32Base::AddGpuSample(const std::string& inPass, double inMilliseconds)
+{
+    if(m_RecordingSamples)
+        m_Benchmark.AddSample("GPU " + inPass, inMilliseconds);
+}
+
+void Win32Base::WriteFrameTimings(const std::vector<float>& inFrameTimes) const
+{
+    std::ofstream file(m_Options.TimingsPath, std::ios::out | std::ios::trunc);
+    if(!file.is_open())
+    {
+        LOG_ERROR("[Run] Failed to open %s", m_Options.TimingsPath.c_str());
+        return;
+    }
+
+    file << "frame,cpu_ms\n";
+    for(size_t i = 0; i < inFrameTimes.size(); ++i)
+        file << i << "," << inFrameTimes[i] << "\n";
+    Log::Info("[Run] Frame timings written to %s", m_Options.TimingsPath.c_str());
 }
 
 std::list<Win32Base*> Win32Base::s_Listeners;
 
+#ifdef _WIN32
 LRESULT CALLBACK Win32Base::MsgProc(HWND HWnd, UINT Msg, WPARAM WParam, LPARAM LParam)
 {
     switch (Msg)
@@ -163,4 +422,5 @@ LRESULT CALLBACK Win32Base::MsgProc(HWND HWnd, UINT Msg, WPARAM WParam, LPARAM L
         return DefWindowProc(HWnd, Msg, WParam, LParam);
     }
     return 0;
-}
\ No newline at end of file
+}
+#endif
@@ -1,20 +1,63 @@
 #pragma once
 
+#ifdef _WIN32
 #include <Windows.h>
+#else
+typedef void* HINSTANCE;
+typedef void* HWND;
+#ifndef TEXT
+#define TEXT(text) text
+#endif
+#endif
 #include <list>
 #include <cstdint>
+#include <string>
+#include <vector>
 
+#include "Benchmark.h"
+#include "TraceEvent.h"
 
+class CameraBase;
+
+// Selected on the command line:
+//   [--fps <rate>] in the windowed mode, 0 runs unlimited
+//   --headless [--frames <count>] [--timings <file.csv>] [--screenshot <file.png>]
+//   --benchmark [--warmup <count>] [--frames <count>] [--report <file.json|file.csv>] [--baseline <file.json>] [--tolerance <percent>]
+//   --trace <file.json> in any mode
+struct RunOptions
+{
+    bool        Headless = false;       // no window, renders offscreen for a fixed number of frames
+    bool        Benchmark = false;      // fixed number of frames on a fixed camera path, windowed or headless
+    uint32_t    FrameCount = 300;       // measured frames, after the warmup
+    uint32_t    WarmupFrames = 0;       // 60 by default in benchmark mode
+    std::string TimingsPath;            // per frame CPU times, written after the last frame
+    std::string ScreenshotPath;         // the last frame as PNG
+    std::string ReportPath;
+    std::string BaselinePath;           // a JSON report of an earlier run, the run fails when it regressed
+    double      TolerancePercent = 5.0;
+    std::string TracePath;              // Chrome trace JSON of the profiled scopes, written on exit
+    double      TargetFrameRate = 60.0; // windowed mode only, fixed frame counts always run unlimited
+    bool        ValidateCulling = false; // examples with occlusion culling check the GPU results against the CPU every frame
+    std::string OcclusionMode;          // examples with several occlusion culling paths pick one by name
+
+    bool IsFixedFrameCount() const { return Headless || Benchmark; }
+    static RunOptions FromCommandLine(int argc, char** argv);
+};
 
 class Win32Base
 {
 public:
-    Win32Base(uint32_t inWidth, uint32_t inHeight, HINSTANCE inHInstance, const char* inTitle);
+    Win32Base(uint32_t inWidth, uint32_t inHeight, HINSTANCE inHInstance, const char* inTitle, const RunOptions& inOptions = RunOptions());
     void Run();
     virtual ~Win32Base();
+    // Non-zero when a benchmark regressed against its baseline
+    int GetExitCode() const { return m_ExitCode; }
 
 protected:
     virtual bool Init() = 0;
+    // Called zero or more times before every Tick, always with the same step. Tick renders the state in between
+    // the last two updates at GetInterpolationAlpha().
+    virtual void FixedUpdate(float inDeltaTime) { }
     virtual void Tick() = 0;
     virtual void Shutdown() = 0;
     
@@ -27,25 +70,65 @@ protected:
     virtual void OnMouseMidBtnUp(int x, int y)  { }
     virtual void OnMouseMove(int x, int y){ }
     virtual void OnMouseWheeling(int x, int y, int delta) { }
+    // Called in headless mode after the last frame, returns false when the backend can not read back its output
+    virtual bool SaveScreenshot(const std::string& inPath) { return false; }
+    // The camera benchmark mode moves along a fixed orbit around the world origin, nullptr leaves the scene as it is
+    virtual CameraBase* GetBenchmarkCamera() { return nullptr; }
+    // Called before Shutdown when a trace was requested, the device is still alive
+    virtual void CollectTraceEvents(std::vector<TraceEvent>& outEvents) { }
 
     uint32_t m_Width;
     uint32_t m_Height;
     HINSTANCE const m_hInstance;
-    HWND m_hWnd;
+    HWND m_hWnd {nullptr}; // stays null in headless mode
     bool m_IsRunning = true;
+    const RunOptions m_Options;
+    const std::string m_Title;
+
+    bool IsHeadless() const { return m_Options.Headless; }
 
     float GetDeltaTime() const { return m_Timer.DeltaTime; }
     float GetTotalTimeSinceStart() const { return m_Timer.TotalTimeSinceStart; }
+    float GetInterpolationAlpha() const { return m_Timer.InterpolationAlpha; }
+    float GetFrameJitterMs() const { return m_Timer.FrameJitterMs; }
+    float GetInputLatencyMs() const { return m_Timer.InputLatencyMs; }
+    // GPU time of a pass in the current frame, only kept during the measured frames of a benchmark
+    void AddGpuSample(const std::string& inPass, double inMilliseconds);
 
 private:
+    // Fixed step so that headless and benchmark runs animate the same way on every machine
+    static constexpr float s_FixedDeltaTime = 1.0f / 60.0f;
+    // Longer frames (a breakpoint, dragging the window) are clamped instead of running a burst of catch-up updates
+    static constexpr float s_MaxFrameDeltaTime = 0.25f;
+
+    void RunWindowed();
+    void RunFixedFrames();
+    // Dispatches every pending message, returns false once the window has been closed
+    bool PumpMessages();
+    void WriteFrameTimings(const std::vector<float>& inFrameTimes) const;
+    void FinishBenchmark();
+    void WriteTrace();
+
     static std::list<Win32Base*> s_Listeners;
+#ifdef _WIN32
     static LRESULT CALLBACK MsgProc(HWND HWnd, UINT Msg, WPARAM WParam, LPARAM LParam);
+#endif
 
     struct Timer
     {
         float DeltaTime {0};
         float TotalTimeSinceStart {0};
+        float InterpolationAlpha {0};   // progress from the last fixed update towards the next one
+        float FrameTimeMs {0};
+        float AverageFrameTimeMs {0};   // moving averages over roughly the last 32 frames
+        float FrameJitterMs {0};        // mean deviation of the frame time from the average
+        float InputLatencyMs {0};       // from draining the messages to the end of Tick, which waits for the GPU
+
+        void AddFrameTime(float inFrameTimeMs);
     };
 
     Timer m_Timer;
+    Benchmark m_Benchmark;
+    bool m_RecordingSamples = false;
+    int m_ExitCode = 0;
 };
\ No newline at end of file
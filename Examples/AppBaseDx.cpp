@@ -1,11 +1,17 @@
 #include "AppBaseDx.h"
+#include "CpuProfiler.h"
 #include "DirectXTex.h"
+#include "AssetsManager.h"
+#include <algorithm>
+#include <chrono>
+#include <future>
+#include <fstream>
 
 void WriteBufferData(ID3D12Resource* inBuffer, const void* inData, size_t inSize, size_t inOffset)
 {
     if(inBuffer == nullptr)
     {
-        Log::Error("[D3D12] Invalid buffer");
+        LOG_ERROR("[D3D12] Invalid buffer");
         return;
     }
     uint8_t* mappedData = nullptr;
@@ -19,12 +25,12 @@ void AppBaseDx::LogAdapterDesc(const DXGI_ADAPTER_DESC1& inDesc)
 {
     std::wstring adapterDesc(inDesc.Description);
     std::string name(adapterDesc.begin(), adapterDesc.end());
-    Log::Info("----------------------------------------------------------------", name.c_str());
-    Log::Info("[D3D12] Adapter Description: %s", name.c_str());
-    Log::Info("[D3D12] Adapter Dedicated Video Memory: %d MB", inDesc.DedicatedVideoMemory >> 20);
-    Log::Info("[D3D12] Adapter Dedicated System Memory: %d MB", inDesc.DedicatedSystemMemory >> 20);
-    Log::Info("[D3D12] Adapter Shared System Memory: %d MB", inDesc.SharedSystemMemory >> 20);
-    Log::Info("----------------------------------------------------------------", name.c_str());
+    LOG_INFO("----------------------------------------------------------------", name.c_str());
+    LOG_INFO("[D3D12] Adapter Description: %s", name.c_str());
+    LOG_INFO("[D3D12] Adapter Dedicated Video Memory: %d MB", inDesc.DedicatedVideoMemory >> 20);
+    LOG_INFO("[D3D12] Adapter Dedicated System Memory: %d MB", inDesc.DedicatedSystemMemory >> 20);
+    LOG_INFO("[D3D12] Adapter Shared System Memory: %d MB", inDesc.SharedSystemMemory >> 20);
+    LOG_INFO("----------------------------------------------------------------", name.c_str());
 }
 
 bool AppBaseDx::CreateCommandQueue()
@@ -38,7 +44,7 @@ bool AppBaseDx::CreateCommandQueue()
     if(FAILED(hr))
     {
         OUTPUT_D3D12_FAILED_RESULT(hr)
-        Log::Error("[D3D12] Failed to create the command queue");
+        LOG_ERROR("[D3D12] Failed to create the command queue");
         return false;
     }
     
@@ -46,7 +52,7 @@ bool AppBaseDx::CreateCommandQueue()
     if(FAILED(hr))
     {
         OUTPUT_D3D12_FAILED_RESULT(hr)
-        Log::Error("[D3D12] Failed to create the fence");
+        LOG_ERROR("[D3D12] Failed to create the fence");
         return false;
     }
     return true;
@@ -58,7 +64,7 @@ bool AppBaseDx::CreateCommandList()
     if(FAILED(hr))
     {
         OUTPUT_D3D12_FAILED_RESULT(hr)
-        Log::Error("[D3D12] Failed to create the command allocator");
+        LOG_ERROR("[D3D12] Failed to create the command allocator");
         return false;
     }
 
@@ -66,14 +72,14 @@ bool AppBaseDx::CreateCommandList()
     if(FAILED(hr))
     {
         OUTPUT_D3D12_FAILED_RESULT(hr)
-        Log::Error("[D3D12] Failed to create the command list");
+        LOG_ERROR("[D3D12] Failed to create the command list");
         return false;
     }
     m_CommandListIsClosed = false;
     return true;
 }
 
-bool AppBaseDx::CreateDescriptorHeaps()
+bool AppBaseDx::CreateDescriptorHeaps(uint32_t inShaderBoundViewCount)
 {
     D3D12_DESCRIPTOR_HEAP_DESC rtvHeapDesc{};
     rtvHeapDesc.Type = D3D12_DESCRIPTOR_HEAP_TYPE_RTV;
@@ -84,7 +90,7 @@ bool AppBaseDx::CreateDescriptorHeaps()
     if(FAILED(hr))
     {
         OUTPUT_D3D12_FAILED_RESULT(hr)
-        Log::Error("[D3D12] Failed to create the RTV descriptor heap");
+        LOG_ERROR("[D3D12] Failed to create the RTV descriptor heap");
         return false;
     }
 
@@ -97,20 +103,20 @@ bool AppBaseDx::CreateDescriptorHeaps()
     if(FAILED(hr))
     {
         OUTPUT_D3D12_FAILED_RESULT(hr)
-        Log::Error("[D3D12] Failed to create the DSV descriptor heap");
+        LOG_ERROR("[D3D12] Failed to create the DSV descriptor heap");
         return false;
     }
 
     D3D12_DESCRIPTOR_HEAP_DESC shaderBoundViewHeapDesc{};
     shaderBoundViewHeapDesc.Type = D3D12_DESCRIPTOR_HEAP_TYPE_CBV_SRV_UAV;
-    shaderBoundViewHeapDesc.NumDescriptors = 8;
+    shaderBoundViewHeapDesc.NumDescriptors = inShaderBoundViewCount;
     shaderBoundViewHeapDesc.NodeMask = GetNodeMask();
     shaderBoundViewHeapDesc.Flags = D3D12_DESCRIPTOR_HEAP_FLAG_SHADER_VISIBLE;
     hr = m_DeviceHandle->CreateDescriptorHeap(&shaderBoundViewHeapDesc, IID_PPV_ARGS(&m_ShaderBoundViewHeap));
     if(FAILED(hr))
     {
         OUTPUT_D3D12_FAILED_RESULT(hr)
-        Log::Error("[D3D12] Failed to create the CBV, SRV, UAV descriptor heap");
+        LOG_ERROR("[D3D12] Failed to create the CBV, SRV, UAV descriptor heap");
         return false;
     }
 
@@ -123,7 +129,7 @@ bool AppBaseDx::CreateDescriptorHeaps()
     if(FAILED(hr))
     {
         OUTPUT_D3D12_FAILED_RESULT(hr)
-        Log::Error("[D3D12] Failed to create the sampler descriptor heap");
+        LOG_ERROR("[D3D12] Failed to create the sampler descriptor heap");
         return false;
     }
 
@@ -132,6 +138,12 @@ bool AppBaseDx::CreateDescriptorHeaps()
 
 bool AppBaseDx::CreateSwapChain()
 {
+    if(IsHeadless())
+    {
+        LOG_ERROR("[D3D12] The headless mode is only implemented for Vulkan, run with --benchmark alone");
+        return false;
+    }
+
     DXGI_SWAP_CHAIN_DESC1 swapChainDesc{};
     swapChainDesc.Width = m_Width;
     swapChainDesc.Height = m_Height;
@@ -155,7 +167,7 @@ bool AppBaseDx::CreateSwapChain()
     if(FAILED(hr))
     {
         OUTPUT_D3D12_FAILED_RESULT(hr)
-        Log::Error("[D3D12] Failed to create the swap chain");
+        LOG_ERROR("[D3D12] Failed to create the swap chain");
         return false;
     }
 
@@ -177,10 +189,11 @@ bool AppBaseDx::CreateSwapChain()
         if(FAILED(hr))
         {
             OUTPUT_D3D12_FAILED_RESULT(hr)
-            Log::Error("[D3D12] Failed to get the swap chain buffer");
+            LOG_ERROR("[D3D12] Failed to get the swap chain buffer");
             return false;
         }
         m_BackBuffers[i] = backBuffer;
+        m_StateTracker.TrackResource(backBuffer.Get(), D3D12_RESOURCE_STATE_PRESENT);
         m_RtvHandles[i] = m_RtvHeap->GetCPUDescriptorHandleForHeapStart();
         m_RtvHandles[i].ptr += i * incrementSize;
         m_DeviceHandle->CreateRenderTargetView(backBuffer.Get(), &rtvDesc, m_RtvHandles[i]);
@@ -198,6 +211,15 @@ void AppBaseDx::BeginCommandList()
         m_CommandAllocator->Reset();
         m_CommandList->Reset(m_CommandAllocator.Get(), nullptr);
         m_CommandListIsClosed = false;
+
+        if(m_GpuProfiler.IsInitialized())
+        {
+            // The slot was resolved s_FrameLatency command lists ago, read it before this frame resolves over it
+            const uint32_t slot = m_GpuProfiler.GetNextSlot();
+            if(m_GpuProfiler.IsSlotPending(slot))
+                ReadBackGpuProfiler(slot);
+            m_GpuProfiler.BeginFrame();
+        }
     }
 }
 
@@ -205,6 +227,16 @@ void AppBaseDx::EndCommandList()
 {
     if(!m_CommandListIsClosed)
     {
+        m_StateTracker.Flush(m_CommandList.Get());
+        if(m_GpuProfiler.IsFrameOpen())
+        {
+            const uint32_t slot = m_GpuProfiler.GetCurrentSlot();
+            const uint32_t firstQuery = GpuProfiler::GetSlotFirstQuery(slot);
+            const uint32_t queryCount = m_GpuProfiler.GetSlotQueryCount(slot);
+            if(queryCount > 0)
+                m_CommandList->ResolveQueryData(m_TimestampQueryHeap.Get(), D3D12_QUERY_TYPE_TIMESTAMP, firstQuery, queryCount, m_TimestampReadback.Get(), sizeof(uint64_t) * firstQuery);
+            m_GpuProfiler.EndFrame();
+        }
         m_CommandList->Close();
         m_CommandListIsClosed = true;
     }
@@ -212,6 +244,7 @@ void AppBaseDx::EndCommandList()
 
 void AppBaseDx::FlushCommandQueue()
 {
+    PROFILE_ZONE("WaitForGpu");
     if(m_CommandQueueHandle.Get())
     {
         m_Fence->Signal(0);
@@ -230,16 +263,279 @@ void AppBaseDx::FlushCommandQueue()
     }
 }
 
+bool AppBaseDx::CreateGpuProfiler()
+{
+    uint64_t frequency = 0;
+    if(FAILED(m_CommandQueueHandle->GetTimestampFrequency(&frequency)) || frequency == 0)
+    {
+        LOG_WARNING("[D3D12] The command queue has no timestamps, GPU scopes are not measured");
+        return true;
+    }
+
+    D3D12_QUERY_HEAP_DESC queryHeapDesc{};
+    queryHeapDesc.NodeMask = GetNodeMask();
+    queryHeapDesc.Count = GpuProfiler::s_FrameLatency * GpuProfiler::s_QueriesPerFrame;
+    queryHeapDesc.Type = D3D12_QUERY_HEAP_TYPE_TIMESTAMP;
+    HRESULT hr = m_DeviceHandle->CreateQueryHeap(&queryHeapDesc, IID_PPV_ARGS(&m_TimestampQueryHeap));
+    if(FAILED(hr))
+    {
+        OUTPUT_D3D12_FAILED_RESULT(hr)
+        LOG_ERROR("[D3D12] Failed to create the timestamp query heap");
+        return false;
+    }
+
+    m_TimestampReadback = CreateBuffer(sizeof(uint64_t) * queryHeapDesc.Count
+        , D3D12_RESOURCE_STATE_COPY_DEST
+        , D3D12_HEAP_TYPE_READBACK
+        , D3D12_RESOURCE_FLAG_NONE);
+    if(m_TimestampReadback == nullptr)
+        return false;
+
+    uint64_t gpuTimestamp = 0;
+    uint64_t cpuTimestamp = 0;
+    hr = m_CommandQueueHandle->GetClockCalibration(&gpuTimestamp, &cpuTimestamp);
+    if(FAILED(hr))
+    {
+        OUTPUT_D3D12_FAILED_RESULT(hr)
+        LOG_ERROR("[D3D12] Failed to calibrate the timestamps");
+        return false;
+    }
+
+    // The CPU side of the calibration is a QueryPerformanceCounter value, move it onto the trace clock
+    LARGE_INTEGER performanceCounter;
+    LARGE_INTEGER performanceFrequency;
+    const uint64_t traceNs = GetTraceTimeNs();
+    QueryPerformanceCounter(&performanceCounter);
+    QueryPerformanceFrequency(&performanceFrequency);
+    const double elapsedNs = static_cast<double>(performanceCounter.QuadPart - static_cast<LONGLONG>(cpuTimestamp)) * 1e9 / static_cast<double>(performanceFrequency.QuadPart);
+
+    m_GpuProfiler.Init(static_cast<double>(frequency) / 1000.0, gpuTimestamp, traceNs - static_cast<uint64_t>(elapsedNs));
+    m_GpuProfiler.SetScopeHook([this](const std::string& inName, double inMilliseconds) { AddGpuSample(inName, inMilliseconds); });
+    return true;
+}
+
+void AppBaseDx::DestroyGpuProfiler()
+{
+    m_TimestampReadback.Reset();
+    m_TimestampQueryHeap.Reset();
+    m_GpuProfiler = GpuProfiler();
+}
+
+void AppBaseDx::ReadBackGpuProfiler(uint32_t inSlot)
+{
+    // Every example waits for the GPU at the end of a frame, the resolve of this slot finished long ago
+    const uint32_t firstQuery = GpuProfiler::GetSlotFirstQuery(inSlot);
+    const D3D12_RANGE readRange = {sizeof(uint64_t) * firstQuery, sizeof(uint64_t) * (firstQuery + m_GpuProfiler.GetSlotQueryCount(inSlot))};
+    uint64_t* ticks = nullptr;
+    if(FAILED(m_TimestampReadback->Map(0, &readRange, reinterpret_cast<void**>(&ticks))))
+    {
+        LOG_WARNING("[D3D12] Failed to read back the GPU timestamps");
+        m_GpuProfiler.DiscardSlot(inSlot);
+        return;
+    }
+    m_GpuProfiler.ResolveSlot(inSlot, ticks + firstQuery);
+    const D3D12_RANGE writeRange = {0, 0};
+    m_TimestampReadback->Unmap(0, &writeRange);
+}
+
+void AppBaseDx::CollectTraceEvents(std::vector<TraceEvent>& outEvents)
+{
+    if(m_TimestampReadback != nullptr)
+    {
+        // The last frames never had their slot come around again
+        FlushCommandQueue();
+        for(uint32_t slot = 0; slot < GpuProfiler::s_FrameLatency; ++slot)
+        {
+            if(m_GpuProfiler.IsSlotPending(slot))
+                ReadBackGpuProfiler(slot);
+        }
+    }
+    m_GpuProfiler.AppendTraceEvents(outEvents);
+}
+
+void AppBaseDx::BeginGpuScope(const char* inName)
+{
+    const uint32_t query = m_GpuProfiler.BeginScope(inName);
+    if(query != GpuProfiler::s_InvalidQuery)
+        m_CommandList->EndQuery(m_TimestampQueryHeap.Get(), D3D12_QUERY_TYPE_TIMESTAMP, query);
+}
+
+void AppBaseDx::EndGpuScope()
+{
+    const uint32_t query = m_GpuProfiler.EndScope();
+    if(query != GpuProfiler::s_InvalidQuery)
+        m_CommandList->EndQuery(m_TimestampQueryHeap.Get(), D3D12_QUERY_TYPE_TIMESTAMP, query);
+}
+
+bool AppBaseDx::CreateHiZPyramid(ID3D12Resource* inDepthBuffer, uint32_t inFirstSlot)
+{
+    const D3D12_RESOURCE_DESC depthDesc = inDepthBuffer->GetDesc();
+    const uint32_t width = static_cast<uint32_t>(depthDesc.Width);
+    const uint32_t height = depthDesc.Height;
+    m_HiZMipCount = HiZPyramid::ComputeMipCount(width, height);
+    m_HiZFirstSlot = inFirstSlot;
+    m_HiZDepthBuffer = inDepthBuffer;
+
+    const glm::uvec2 size = HiZPyramid::GetMipSize(width, height, 0);
+    m_HiZPyramid = CreateTexture(DXGI_FORMAT_R32_FLOAT
+        , size.x
+        , size.y
+        , D3D12_RESOURCE_STATE_NON_PIXEL_SHADER_RESOURCE
+        , D3D12_HEAP_TYPE_DEFAULT
+        , D3D12_RESOURCE_FLAG_ALLOW_UNORDERED_ACCESS
+        , nullptr
+        , static_cast<uint16_t>(m_HiZMipCount));
+    if(m_HiZPyramid == nullptr)
+        return false;
+    m_StateTracker.TrackResource(m_HiZPyramid.Get(), D3D12_RESOURCE_STATE_NON_PIXEL_SHADER_RESOURCE);
+    m_StateTracker.TrackResource(m_HiZDepthBuffer, D3D12_RESOURCE_STATE_DEPTH_WRITE);
+
+    const uint32_t descriptorSize = m_DeviceHandle->GetDescriptorHandleIncrementSize(D3D12_DESCRIPTOR_HEAP_TYPE_CBV_SRV_UAV);
+    auto cpuHandle = [&](uint32_t inSlot)
+    {
+        D3D12_CPU_DESCRIPTOR_HANDLE handle = m_ShaderBoundViewHeap->GetCPUDescriptorHandleForHeapStart();
+        handle.ptr += (m_HiZFirstSlot + inSlot) * descriptorSize;
+        return handle;
+    };
+
+    D3D12_SHADER_RESOURCE_VIEW_DESC depthSrv{};
+    depthSrv.Format = DXGI_FORMAT_R32_FLOAT;
+    depthSrv.ViewDimension = D3D12_SRV_DIMENSION_TEXTURE2D;
+    depthSrv.Shader4ComponentMapping = D3D12_DEFAULT_SHADER_4_COMPONENT_MAPPING;
+    depthSrv.Texture2D.MipLevels = 1;
+    m_DeviceHandle->CreateShaderResourceView(m_HiZDepthBuffer, &depthSrv, cpuHandle(0));
+
+    // Every level of the shader's UAV array gets a descriptor, the unused ones stay null
+    for(uint32_t level = 0; level < HiZPyramid::s_MaxMipCount; ++level)
+    {
+        D3D12_UNORDERED_ACCESS_VIEW_DESC mipUav{};
+        mipUav.Format = DXGI_FORMAT_R32_FLOAT;
+        mipUav.ViewDimension = D3D12_UAV_DIMENSION_TEXTURE2D;
+        mipUav.Texture2D.MipSlice = std::min(level, m_HiZMipCount - 1);
+        m_DeviceHandle->CreateUnorderedAccessView(level < m_HiZMipCount ? m_HiZPyramid.Get() : nullptr, nullptr, &mipUav, cpuHandle(1 + level));
+    }
+
+    D3D12_SHADER_RESOURCE_VIEW_DESC pyramidSrv = depthSrv;
+    pyramidSrv.Texture2D.MipLevels = m_HiZMipCount;
+    m_DeviceHandle->CreateShaderResourceView(m_HiZPyramid.Get(), &pyramidSrv, cpuHandle(GetHiZDescriptorCount() - 1));
+
+    std::array<CD3DX12_ROOT_PARAMETER1, 3> rootParameters;
+    rootParameters[0].InitAsConstants(5, 0); // _Constants
+    CD3DX12_DESCRIPTOR_RANGE1 depthRange(D3D12_DESCRIPTOR_RANGE_TYPE_SRV, 1, 0, 0, D3D12_DESCRIPTOR_RANGE_FLAG_DESCRIPTORS_VOLATILE);
+    rootParameters[1].InitAsDescriptorTable(1, &depthRange); // _Depth
+    CD3DX12_DESCRIPTOR_RANGE1 mipsRange(D3D12_DESCRIPTOR_RANGE_TYPE_UAV, HiZPyramid::s_MaxMipCount, 0, 0, D3D12_DESCRIPTOR_RANGE_FLAG_DESCRIPTORS_VOLATILE);
+    rootParameters[2].InitAsDescriptorTable(1, &mipsRange); // _HiZMips[]
+
+    CD3DX12_VERSIONED_ROOT_SIGNATURE_DESC rootSignatureDesc;
+    rootSignatureDesc.Init_1_1(static_cast<uint32_t>(rootParameters.size()), rootParameters.data());
+    Microsoft::WRL::ComPtr<ID3DBlob> signatureBlob;
+    Microsoft::WRL::ComPtr<ID3DBlob> errorBlob;
+    HRESULT hr = D3DX12SerializeVersionedRootSignature(&rootSignatureDesc, D3D_ROOT_SIGNATURE_VERSION_1_1, &signatureBlob, &errorBlob);
+    if(FAILED(hr))
+    {
+        OUTPUT_D3D12_FAILED_RESULT(hr)
+        LOG_ERROR("[D3D12] Failed to serialize the Hi-Z root signature: %s", static_cast<const char*>(errorBlob->GetBufferPointer()));
+        return false;
+    }
+
+    hr = m_DeviceHandle->CreateRootSignature(GetNodeMask()
+        , signatureBlob->GetBufferPointer()
+        , signatureBlob->GetBufferSize()
+        , IID_PPV_ARGS(&m_HiZRootSignature));
+    if(FAILED(hr))
+    {
+        OUTPUT_D3D12_FAILED_RESULT(hr)
+        LOG_ERROR("[D3D12] Failed to create the Hi-Z root signature");
+        return false;
+    }
+
+    std::shared_ptr<AssetsManager::Blob> shaderBlob = AssetsManager::LoadShaderImmediately("HiZBuild.cs.bin");
+    if(!shaderBlob || shaderBlob->IsEmpty())
+    {
+        LOG_ERROR("Failed to load the Hi-Z build shader");
+        return false;
+    }
+
+    D3D12_COMPUTE_PIPELINE_STATE_DESC computePsoDesc{};
+    computePsoDesc.pRootSignature = m_HiZRootSignature.Get();
+    computePsoDesc.NodeMask = GetNodeMask();
+    computePsoDesc.CS = CD3DX12_SHADER_BYTECODE(shaderBlob->GetData(), shaderBlob->GetSize());
+    m_HiZPipelineState = LoadComputePipeline(L"HiZBuild", computePsoDesc);
+    if(m_HiZPipelineState == nullptr)
+    {
+        LOG_ERROR("[D3D12] Failed to create the Hi-Z pipeline state");
+        return false;
+    }
+    return true;
+}
+
+void AppBaseDx::BuildHiZPyramid()
+{
+    PROFILE_ZONE("BuildHiZPyramid");
+    BeginGpuScope("HiZ");
+    m_StateTracker.Transition(m_HiZDepthBuffer, D3D12_RESOURCE_STATE_NON_PIXEL_SHADER_RESOURCE);
+    m_StateTracker.Transition(m_HiZPyramid.Get(), D3D12_RESOURCE_STATE_UNORDERED_ACCESS);
+    m_StateTracker.Flush(m_CommandList.Get());
+
+    m_CommandList->SetPipelineState(m_HiZPipelineState.Get());
+    m_CommandList->SetComputeRootSignature(m_HiZRootSignature.Get());
+    const uint32_t descriptorSize = m_DeviceHandle->GetDescriptorHandleIncrementSize(D3D12_DESCRIPTOR_HEAP_TYPE_CBV_SRV_UAV);
+    D3D12_GPU_DESCRIPTOR_HANDLE handle = m_ShaderBoundViewHeap->GetGPUDescriptorHandleForHeapStart();
+    handle.ptr += m_HiZFirstSlot * descriptorSize;
+    m_CommandList->SetComputeRootDescriptorTable(1, handle);
+    handle.ptr += descriptorSize;
+    m_CommandList->SetComputeRootDescriptorTable(2, handle);
+
+    const D3D12_RESOURCE_DESC depthDesc = m_HiZDepthBuffer->GetDesc();
+    glm::uvec2 srcSize(static_cast<uint32_t>(depthDesc.Width), depthDesc.Height);
+    for(uint32_t level = 0; level < m_HiZMipCount; ++level)
+    {
+        const glm::uvec2 dstSize = HiZPyramid::GetMipSize(static_cast<uint32_t>(depthDesc.Width), depthDesc.Height, level);
+        const uint32_t constants[5] = { srcSize.x, srcSize.y, dstSize.x, dstSize.y, level };
+        m_CommandList->SetComputeRoot32BitConstants(0, 5, constants, 0);
+        m_CommandList->Dispatch((dstSize.x + 7) / 8, (dstSize.y + 7) / 8, 1);
+        // The next level reads this one
+        m_StateTracker.UAVBarrier(m_HiZPyramid.Get());
+        m_StateTracker.Flush(m_CommandList.Get());
+        srcSize = dstSize;
+    }
+
+    m_StateTracker.Transition(m_HiZDepthBuffer, D3D12_RESOURCE_STATE_DEPTH_WRITE);
+    m_StateTracker.Transition(m_HiZPyramid.Get(), D3D12_RESOURCE_STATE_NON_PIXEL_SHADER_RESOURCE);
+    m_StateTracker.Flush(m_CommandList.Get());
+    EndGpuScope();
+}
+
+D3D12_GPU_DESCRIPTOR_HANDLE AppBaseDx::GetHiZPyramidSrv() const
+{
+    D3D12_GPU_DESCRIPTOR_HANDLE handle = m_ShaderBoundViewHeap->GetGPUDescriptorHandleForHeapStart();
+    handle.ptr += (m_HiZFirstSlot + GetHiZDescriptorCount() - 1) * m_DeviceHandle->GetDescriptorHandleIncrementSize(D3D12_DESCRIPTOR_HEAP_TYPE_CBV_SRV_UAV);
+    return handle;
+}
+
+HiZCullingConstants AppBaseDx::GetHiZCullingConstants(uint32_t inPhase, uint32_t inObjectCount) const
+{
+    const D3D12_RESOURCE_DESC depthDesc = m_HiZDepthBuffer->GetDesc();
+    HiZCullingConstants constants;
+    constants.Phase = inPhase;
+    constants.HiZMipCount = m_HiZMipCount;
+    constants.ScreenWidth = static_cast<uint32_t>(depthDesc.Width);
+    constants.ScreenHeight = depthDesc.Height;
+    constants.ObjectCount = inObjectCount;
+    return constants;
+}
+
 Microsoft::WRL::ComPtr<ID3D12Resource> AppBaseDx::CreateTexture(DXGI_FORMAT inFormat
     , uint32_t inWidth
     , uint32_t inHeight
     , D3D12_RESOURCE_STATES initState
     , D3D12_HEAP_TYPE inHeapType
     , D3D12_RESOURCE_FLAGS inFlags
-    , const D3D12_CLEAR_VALUE* inClearValue)
+    , const D3D12_CLEAR_VALUE* inClearValue
+    , uint16_t inMipLevels)
 {
     D3D12_RESOURCE_DESC textureDesc = {};
-    textureDesc.MipLevels = 1;
+    textureDesc.MipLevels = inMipLevels;
     textureDesc.Format = inFormat;
     textureDesc.Width = inWidth;
     textureDesc.Height = inHeight;
@@ -262,7 +558,7 @@ Microsoft::WRL::ComPtr<ID3D12Resource> AppBaseDx::CreateTexture(DXGI_FORMAT inFo
     if(FAILED(hr))
     {
         OUTPUT_D3D12_FAILED_RESULT(hr)
-        Log::Error("[D3D12] Failed to create texture");
+        LOG_ERROR("[D3D12] Failed to create texture");
         return nullptr;
     }
 
@@ -299,7 +595,7 @@ Microsoft::WRL::ComPtr<ID3D12Resource> AppBaseDx::CreateBuffer(size_t inSize
     if(FAILED(hr))
     {
         OUTPUT_D3D12_FAILED_RESULT(hr)
-        Log::Error("[D3D12] Failed to create buffer");
+        LOG_ERROR("[D3D12] Failed to create buffer");
         return nullptr;
     }
     
@@ -343,4 +639,475 @@ Microsoft::WRL::ComPtr<ID3D12Resource> AppBaseDx::UploadTexture(ID3D12Resource*
     constexpr uint32_t maxSubresourceNum = 16;
     UpdateSubresources<maxSubresourceNum>(m_CommandList.Get(), dstTexture, stagingBuffer.Get(), 0, 0, subresources.size(), subresources.data());
     return stagingBuffer;
+}
+
+// ID3D12PipelineLibrary rejects blobs from other drivers by itself, the header lets us skip reading them at all
+struct PipelineLibraryFileHeader
+{
+    static constexpr uint32_t s_Magic = 0x4C505844; // "DXPL"
+
+    uint32_t Magic;
+    uint32_t DataSize;
+    uint32_t VendorId;
+    uint32_t DeviceId;
+    uint32_t SubSysId;
+    uint32_t Revision;
+    int64_t  DriverVersion;
+};
+
+static void FillPipelineLibraryHeader(IDXGIAdapter1* inAdapter, PipelineLibraryFileHeader& outHeader)
+{
+    outHeader = {};
+    outHeader.Magic = PipelineLibraryFileHeader::s_Magic;
+    DXGI_ADAPTER_DESC1 desc{};
+    if(SUCCEEDED(inAdapter->GetDesc1(&desc)))
+    {
+        outHeader.VendorId = desc.VendorId;
+        outHeader.DeviceId = desc.DeviceId;
+        outHeader.SubSysId = desc.SubSysId;
+        outHeader.Revision = desc.Revision;
+    }
+    LARGE_INTEGER umdVersion{};
+    if(SUCCEEDED(inAdapter->CheckInterfaceSupport(__uuidof(IDXGIDevice), &umdVersion)))
+    {
+        outHeader.DriverVersion = umdVersion.QuadPart;
+    }
+}
+
+bool AppBaseDx::CreatePipelineLibrary(const char* inLibraryName)
+{
+    m_PipelineLibraryPath = AssetsManager::GetShaderPath() / (std::string(inLibraryName) + ".d3d12cache");
+    m_PipelineLibraryIsWarm = false;
+    m_PipelineLibraryIsDirty = false;
+    m_PipelineLibraryData.clear();
+
+    PipelineLibraryFileHeader expectedHeader;
+    FillPipelineLibraryHeader(m_AdapterHandle.Get(), expectedHeader);
+
+    std::ifstream file(m_PipelineLibraryPath, std::ios::binary);
+    if(file.is_open())
+    {
+        PipelineLibraryFileHeader header{};
+        file.read(reinterpret_cast<char*>(&header), sizeof(header));
+        if(file.good()
+            && header.Magic == expectedHeader.Magic
+            && header.VendorId == expectedHeader.VendorId
+            && header.DeviceId == expectedHeader.DeviceId
+            && header.SubSysId == expectedHeader.SubSysId
+            && header.Revision == expectedHeader.Revision
+            && header.DriverVersion == expectedHeader.DriverVersion)
+        {
+            m_PipelineLibraryData.resize(header.DataSize);
+            file.read(reinterpret_cast<char*>(m_PipelineLibraryData.data()), header.DataSize);
+            if(!file.good())
+            {
+                LOG_WARNING("[D3D12] Pipeline library %s is truncated, ignore it", m_PipelineLibraryPath.string().c_str());
+                m_PipelineLibraryData.clear();
+            }
+        }
+        else
+        {
+            LOG_WARNING("[D3D12] Pipeline library %s was created by another adapter or driver, ignore it", m_PipelineLibraryPath.string().c_str());
+        }
+    }
+
+    HRESULT hr = E_FAIL;
+    if(!m_PipelineLibraryData.empty())
+    {
+        hr = m_DeviceHandle->CreatePipelineLibrary(m_PipelineLibraryData.data(), m_PipelineLibraryData.size(), IID_PPV_ARGS(&m_PipelineLibrary));
+        if(FAILED(hr))
+        {
+            // D3D12_ERROR_DRIVER_VERSION_MISMATCH / D3D12_ERROR_ADAPTER_NOT_FOUND / corrupted blob
+            LOG_WARNING("[D3D12] Failed to create pipeline library from %s, start with an empty library", m_PipelineLibraryPath.string().c_str());
+            m_PipelineLibraryData.clear();
+        }
+    }
+
+    if(m_PipelineLibraryData.empty())
+    {
+        hr = m_DeviceHandle->CreatePipelineLibrary(nullptr, 0, IID_PPV_ARGS(&m_PipelineLibrary));
+    }
+
+    if(FAILED(hr))
+    {
+        // Pipeline libraries are optional, every Load* call falls back to plain creation
+        OUTPUT_D3D12_FAILED_RESULT(hr)
+        LOG_WARNING("[D3D12] Pipeline library is not supported, pipelines will not be cached");
+        m_PipelineLibrary.Reset();
+        return true;
+    }
+
+    m_PipelineLibraryIsWarm = !m_PipelineLibraryData.empty();
+    LOG_INFO("[D3D12] Pipeline library: %s start, %zu bytes loaded from %s"
+        , m_PipelineLibraryIsWarm ? "warm" : "cold"
+        , m_PipelineLibraryData.size()
+        , m_PipelineLibraryPath.string().c_str());
+    return true;
+}
+
+void AppBaseDx::DestroyPipelineLibrary()
+{
+    if(m_PipelineLibrary == nullptr)
+        return;
+
+    if(m_PipelineLibraryNeedsRebuild)
+    {
+        // Entries can't be replaced or removed, a fresh library with the pipelines of this run drops the stale ones
+        Microsoft::WRL::ComPtr<ID3D12PipelineLibrary1> library;
+        HRESULT hr = m_DeviceHandle->CreatePipelineLibrary(nullptr, 0, IID_PPV_ARGS(&library));
+        for(size_t i = 0; SUCCEEDED(hr) && i < m_PipelineLibraryEntries.size(); ++i)
+        {
+            hr = library->StorePipeline(m_PipelineLibraryEntries[i].first.c_str(), m_PipelineLibraryEntries[i].second.Get());
+        }
+        if(SUCCEEDED(hr))
+        {
+            LOG_INFO("[D3D12] Rebuilt the pipeline library with %zu pipeline(s)", m_PipelineLibraryEntries.size());
+            m_PipelineLibrary = library;
+        }
+        else
+        {
+            OUTPUT_D3D12_FAILED_RESULT(hr)
+            LOG_WARNING("[D3D12] Failed to rebuild the pipeline library, keep the stale entries");
+        }
+    }
+
+    if(m_PipelineLibraryIsDirty)
+    {
+        const size_t dataSize = m_PipelineLibrary->GetSerializedSize();
+        std::vector<uint8_t> data(dataSize);
+        const HRESULT hr = m_PipelineLibrary->Serialize(data.data(), dataSize);
+        if(SUCCEEDED(hr))
+        {
+            PipelineLibraryFileHeader header;
+            FillPipelineLibraryHeader(m_AdapterHandle.Get(), header);
+            header.DataSize = static_cast<uint32_t>(dataSize);
+
+            // Write to a temporary file first so an interrupted save never leaves a corrupted library behind
+            std::filesystem::path tempPath = m_PipelineLibraryPath;
+            tempPath += ".tmp";
+            std::ofstream file(tempPath, std::ios::binary | std::ios::trunc);
+            if(file.is_open())
+            {
+                file.write(reinterpret_cast<const char*>(&header), sizeof(header));
+                file.write(reinterpret_cast<const char*>(data.data()), static_cast<std::streamsize>(dataSize));
+                file.close();
+                std::error_code ec;
+                std::filesystem::rename(tempPath, m_PipelineLibraryPath, ec);
+                if(ec)
+                    LOG_WARNING("[D3D12] Failed to save pipeline library to %s", m_PipelineLibraryPath.string().c_str());
+            }
+            else
+            {
+                LOG_WARNING("[D3D12] Failed to open %s for writing", tempPath.string().c_str());
+            }
+        }
+        else
+        {
+            OUTPUT_D3D12_FAILED_RESULT(hr)
+        }
+    }
+
+    m_PipelineLibraryEntries.clear();
+    m_PipelineLibrary.Reset();
+    m_PipelineLibraryData.clear();
+    m_PipelineLibraryIsDirty = false;
+    m_PipelineLibraryNeedsRebuild = false;
+}
+
+void AppBaseDx::AddPipelineLibraryEntry(const wchar_t* inName, ID3D12PipelineState* inPipeline, bool inIsLoaded)
+{
+    std::lock_guard<std::mutex> lock(m_PipelineLibraryMutex);
+    // A second pipeline under the same name would make the rebuild fail and drop the whole library, only the first is kept
+    for(const auto& entry : m_PipelineLibraryEntries)
+    {
+        if(entry.first == inName)
+        {
+            LOG_WARNING("[D3D12] Pipeline name %ls is used twice, only the first pipeline is kept in the pipeline library", inName);
+            return;
+        }
+    }
+    m_PipelineLibraryEntries.emplace_back(inName, inPipeline);
+    if(inIsLoaded)
+        return;
+
+    // A miss on a name the library already holds means its shaders or desc changed. StorePipeline refuses to
+    // overwrite it, so the library is rebuilt without the stale entry when it is saved.
+    const HRESULT hr = m_PipelineLibrary->StorePipeline(inName, inPipeline);
+    if(FAILED(hr))
+    {
+        LOG_WARNING("[D3D12] Pipeline %ls is stale in the pipeline library, it is rebuilt on exit", inName);
+        m_PipelineLibraryNeedsRebuild = true;
+    }
+    m_PipelineLibraryIsDirty = true;
+}
+
+Microsoft::WRL::ComPtr<ID3D12PipelineState> AppBaseDx::LoadGraphicsPipeline(const wchar_t* inName, const D3D12_GRAPHICS_PIPELINE_STATE_DESC& inDesc)
+{
+    Microsoft::WRL::ComPtr<ID3D12PipelineState> pipeline;
+    if(m_PipelineLibrary != nullptr && SUCCEEDED(m_PipelineLibrary->LoadGraphicsPipeline(inName, &inDesc, IID_PPV_ARGS(&pipeline))))
+    {
+        AddPipelineLibraryEntry(inName, pipeline.Get(), true);
+        return pipeline;
+    }
+
+    const HRESULT hr = m_DeviceHandle->CreateGraphicsPipelineState(&inDesc, IID_PPV_ARGS(&pipeline));
+    if(FAILED(hr))
+    {
+        OUTPUT_D3D12_FAILED_RESULT(hr)
+        return nullptr;
+    }
+
+    if(m_PipelineLibrary != nullptr)
+        AddPipelineLibraryEntry(inName, pipeline.Get(), false);
+    return pipeline;
+}
+
+Microsoft::WRL::ComPtr<ID3D12PipelineState> AppBaseDx::LoadComputePipeline(const wchar_t* inName, const D3D12_COMPUTE_PIPELINE_STATE_DESC& inDesc)
+{
+    Microsoft::WRL::ComPtr<ID3D12PipelineState> pipeline;
+    if(m_PipelineLibrary != nullptr && SUCCEEDED(m_PipelineLibrary->LoadComputePipeline(inName, &inDesc, IID_PPV_ARGS(&pipeline))))
+    {
+        AddPipelineLibraryEntry(inName, pipeline.Get(), true);
+        return pipeline;
+    }
+
+    const HRESULT hr = m_DeviceHandle->CreateComputePipelineState(&inDesc, IID_PPV_ARGS(&pipeline));
+    if(FAILED(hr))
+    {
+        OUTPUT_D3D12_FAILED_RESULT(hr)
+        return nullptr;
+    }
+
+    if(m_PipelineLibrary != nullptr)
+        AddPipelineLibraryEntry(inName, pipeline.Get(), false);
+    return pipeline;
+}
+
+Microsoft::WRL::ComPtr<ID3D12PipelineState> AppBaseDx::LoadPipeline(const wchar_t* inName, const D3D12_PIPELINE_STATE_STREAM_DESC& inDesc)
+{
+    Microsoft::WRL::ComPtr<ID3D12PipelineState> pipeline;
+    if(m_PipelineLibrary != nullptr && SUCCEEDED(m_PipelineLibrary->LoadPipeline(inName, &inDesc, IID_PPV_ARGS(&pipeline))))
+    {
+        AddPipelineLibraryEntry(inName, pipeline.Get(), true);
+        return pipeline;
+    }
+
+    const HRESULT hr = m_DeviceHandle->CreatePipelineState(&inDesc, IID_PPV_ARGS(&pipeline));
+    if(FAILED(hr))
+    {
+        OUTPUT_D3D12_FAILED_RESULT(hr)
+        return nullptr;
+    }
+
+    if(m_PipelineLibrary != nullptr)
+        AddPipelineLibraryEntry(inName, pipeline.Get(), false);
+    return pipeline;
+}
+
+bool AppBaseDx::CreatePipelinesParallel(const std::vector<std::function<bool()>>& inTasks)
+{
+    const auto startTime = std::chrono::high_resolution_clock::now();
+
+    // The calling thread runs the last task, a single pipeline is created without spawning a thread
+    std::vector<std::future<bool>> futures;
+    futures.reserve(inTasks.size());
+    for(size_t i = 0; i + 1 < inTasks.size(); ++i)
+    {
+        futures.push_back(std::async(std::launch::async, inTasks[i]));
+    }
+
+    bool succeeded = inTasks.empty() || inTasks.back()();
+    for(auto& future : futures)
+    {
+        succeeded = future.get() && succeeded;
+    }
+
+    const auto endTime = std::chrono::high_resolution_clock::now();
+    const float milliseconds = std::chrono::duration<float, std::chrono::milliseconds::period>(endTime - startTime).count();
+    // Not LOG_INFO, the cold and warm library timings are compared in Release builds
+    Log::Info("[D3D12] Created %zu pipeline(s) in %.3f ms (%s pipeline library)"
+        , inTasks.size()
+        , milliseconds
+        , m_PipelineLibraryIsWarm ? "warm" : "cold");
+
+    return succeeded;
+}
+
+void ResourceStateTracker::TrackResource(ID3D12Resource* inResource, D3D12_RESOURCE_STATES inState)
+{
+    ResourceState& state = m_States[inResource];
+    state = ResourceState();
+    state.State = inState;
+}
+
+void ResourceStateTracker::ForgetResource(ID3D12Resource* inResource)
+{
+    m_States.erase(inResource);
+}
+
+uint32_t ResourceStateTracker::GetSubresourceCount(ID3D12Resource* inResource)
+{
+    // Planar formats (depth stencil with stencil, video formats) are not tracked per plane
+    const D3D12_RESOURCE_DESC desc = inResource->GetDesc();
+    if(desc.Dimension == D3D12_RESOURCE_DIMENSION_BUFFER)
+        return 1;
+    const uint32_t arraySize = desc.Dimension == D3D12_RESOURCE_DIMENSION_TEXTURE3D ? 1 : desc.DepthOrArraySize;
+    return desc.MipLevels * arraySize;
+}
+
+bool ResourceStateTracker::IsReadOnlyState(D3D12_RESOURCE_STATES inState)
+{
+    constexpr D3D12_RESOURCE_STATES writeStates = D3D12_RESOURCE_STATE_RENDER_TARGET
+        | D3D12_RESOURCE_STATE_UNORDERED_ACCESS
+        | D3D12_RESOURCE_STATE_DEPTH_WRITE
+        | D3D12_RESOURCE_STATE_STREAM_OUT
+        | D3D12_RESOURCE_STATE_COPY_DEST
+        | D3D12_RESOURCE_STATE_RESOLVE_DEST;
+    return inState != D3D12_RESOURCE_STATE_COMMON && (inState & writeStates) == 0;
+}
+
+void ResourceStateTracker::QueueTransition(ID3D12Resource* inResource, uint32_t inSubresource, D3D12_RESOURCE_STATES inBefore, D3D12_RESOURCE_STATES inAfter)
+{
+    // Fold into a transition of the same subresource that has not been recorded yet
+    for(auto iter = m_PendingBarriers.begin(); iter != m_PendingBarriers.end(); ++iter)
+    {
+        if(iter->Type == D3D12_RESOURCE_BARRIER_TYPE_TRANSITION
+            && iter->Flags == D3D12_RESOURCE_BARRIER_FLAG_NONE
+            && iter->Transition.pResource == inResource
+            && iter->Transition.Subresource == inSubresource)
+        {
+            ++m_Stats.Merged;
+            iter->Transition.StateAfter = inAfter;
+            if(iter->Transition.StateBefore == inAfter)
+            {
+                m_PendingBarriers.erase(iter);
+            }
+            return;
+        }
+    }
+    m_PendingBarriers.push_back(CD3DX12_RESOURCE_BARRIER::Transition(inResource, inBefore, inAfter, inSubresource));
+}
+
+void ResourceStateTracker::Transition(ID3D12Resource* inResource, D3D12_RESOURCE_STATES inState, uint32_t inSubresource)
+{
+    ++m_Stats.Requested;
+    ResourceState& state = m_States[inResource];
+
+    if(state.SplitInFlight)
+    {
+        // Close the split barrier started by BeginSplitTransition, State already holds its target.
+        // If the begin half has not been flushed yet there is no work to overlap, turn it into a regular barrier.
+        auto beginIter = std::find_if(m_PendingBarriers.begin(), m_PendingBarriers.end(), [inResource](const D3D12_RESOURCE_BARRIER& inBarrier)
+        {
+            return inBarrier.Flags == D3D12_RESOURCE_BARRIER_FLAG_BEGIN_ONLY && inBarrier.Transition.pResource == inResource;
+        });
+        if(beginIter != m_PendingBarriers.end())
+        {
+            beginIter->Flags = D3D12_RESOURCE_BARRIER_FLAG_NONE;
+            --m_Stats.SplitBarriers;
+        }
+        else
+        {
+            m_PendingBarriers.push_back(CD3DX12_RESOURCE_BARRIER::Transition(inResource
+                , state.SplitBefore
+                , state.State
+                , D3D12_RESOURCE_BARRIER_ALL_SUBRESOURCES
+                , D3D12_RESOURCE_BARRIER_FLAG_END_ONLY));
+        }
+        state.SplitInFlight = false;
+    }
+
+    if(inSubresource == D3D12_RESOURCE_BARRIER_ALL_SUBRESOURCES && state.Subresources.empty())
+    {
+        // A read state that already contains the requested bits needs no barrier, e.g. GENERIC_READ -> PIXEL_SHADER_RESOURCE
+        if(state.State == inState || (IsReadOnlyState(state.State) && (state.State & inState) == inState))
+        {
+            ++m_Stats.Elided;
+            return;
+        }
+        QueueTransition(inResource, inSubresource, state.State, inState);
+        state.State = inState;
+        return;
+    }
+
+    if(state.Subresources.empty())
+        state.Subresources.assign(GetSubresourceCount(inResource), state.State);
+
+    const uint32_t begin = inSubresource == D3D12_RESOURCE_BARRIER_ALL_SUBRESOURCES ? 0 : inSubresource;
+    const uint32_t end = inSubresource == D3D12_RESOURCE_BARRIER_ALL_SUBRESOURCES ? static_cast<uint32_t>(state.Subresources.size()) : inSubresource + 1;
+    bool anyTransition = false;
+    for(uint32_t i = begin; i < end && i < state.Subresources.size(); ++i)
+    {
+        if(state.Subresources[i] != inState)
+        {
+            QueueTransition(inResource, i, state.Subresources[i], inState);
+            state.Subresources[i] = inState;
+            anyTransition = true;
+        }
+    }
+    if(!anyTransition)
+        ++m_Stats.Elided;
+
+    // Back to a single state for the whole resource
+    const D3D12_RESOURCE_STATES first = state.Subresources.front();
+    if(std::all_of(state.Subresources.begin(), state.Subresources.end(), [first](D3D12_RESOURCE_STATES inSubState) { return inSubState == first; }))
+    {
+        state.State = first;
+        state.Subresources.clear();
+    }
+}
+
+void ResourceStateTracker::BeginSplitTransition(ID3D12Resource* inResource, D3D12_RESOURCE_STATES inState)
+{
+    ++m_Stats.Requested;
+    ResourceState& state = m_States[inResource];
+    if(state.SplitInFlight || !state.Subresources.empty() || state.State == inState)
+    {
+        // Not worth splitting, let the next Transition handle it
+        ++m_Stats.Elided;
+        return;
+    }
+
+    m_PendingBarriers.push_back(CD3DX12_RESOURCE_BARRIER::Transition(inResource
+        , state.State
+        , inState
+        , D3D12_RESOURCE_BARRIER_ALL_SUBRESOURCES
+        , D3D12_RESOURCE_BARRIER_FLAG_BEGIN_ONLY));
+    ++m_Stats.SplitBarriers;
+    state.SplitInFlight = true;
+    state.SplitBefore = state.State;
+    state.State = inState;
+}
+
+void ResourceStateTracker::UAVBarrier(ID3D12Resource* inResource)
+{
+    ++m_Stats.Requested;
+    for(const D3D12_RESOURCE_BARRIER& barrier : m_PendingBarriers)
+    {
+        if(barrier.Type == D3D12_RESOURCE_BARRIER_TYPE_UAV && barrier.UAV.pResource == inResource)
+        {
+            ++m_Stats.Merged;
+            return;
+        }
+    }
+    m_PendingBarriers.push_back(CD3DX12_RESOURCE_BARRIER::UAV(inResource));
+}
+
+void ResourceStateTracker::Flush(ID3D12GraphicsCommandList* inCommandList)
+{
+    if(m_PendingBarriers.empty())
+        return;
+
+    inCommandList->ResourceBarrier(static_cast<uint32_t>(m_PendingBarriers.size()), m_PendingBarriers.data());
+    m_Stats.Emitted += static_cast<uint32_t>(m_PendingBarriers.size());
+    ++m_Stats.Batches;
+    m_PendingBarriers.clear();
+}
+
+void ResourceStateTracker::EndFrame()
+{
+    PROFILE_COUNTER("Barriers emitted", m_Stats.Emitted);
+    if(m_StatsHook)
+        m_StatsHook(m_Stats);
+    m_Stats = {};
 }
\ No newline at end of file
@@ -2,6 +2,9 @@
 
 #include "Win32Base.h"
 #include "Log.h"
+#include "BarrierStats.h"
+#include "GpuProfiler.h"
+#include "HiZPyramid.h"
 #include <d3dx12.h>
 #include <dxgi1_6.h>
 #include <d3dcompiler.h>
@@ -9,11 +12,15 @@
 #include <string>
 #include <iostream>
 #include <array>
+#include <filesystem>
+#include <functional>
+#include <mutex>
+#include <unordered_map>
 
 #define OUTPUT_D3D12_FAILED_RESULT(Re)  if(FAILED(Re))\
     {\
         std::string message = std::system_category().message(Re);\
-        Log::Error("[D3D12] Error: %s, In File: %s line %d", message.c_str(), __FILE__, __LINE__);\
+        LOG_ERROR("[D3D12] Error: %s, In File: %s line %d", message.c_str(), __FILE__, __LINE__);\
     }
 
 namespace DirectX
@@ -23,6 +30,54 @@ namespace DirectX
 
 void WriteBufferData(ID3D12Resource* inBuffer, const void* inData, size_t inSize, size_t inOffset = 0);
 
+// Root constants of the culling shaders that test against the Hi-Z pyramid, matches Shaders/Include/HiZ.hlsli
+struct HiZCullingConstants
+{
+    uint32_t Phase;         // 0 draws the objects visible last frame, 1 tests against the pyramid and draws the rest
+    uint32_t HiZMipCount;
+    uint32_t ScreenWidth;
+    uint32_t ScreenHeight;
+    uint32_t ObjectCount;
+};
+
+// Remembers the last known state of every tracked resource and subresource, turns requested transitions into the
+// minimal set of barriers and records them as one ResourceBarrier batch per Flush(). Transitions requested between
+// two Flush() calls are assumed to belong to the same pass, so A->B->C collapses into A->C and A->B->A disappears.
+class ResourceStateTracker
+{
+public:
+    void SetStatsHook(BarrierStatsHook inHook) { m_StatsHook = std::move(inHook); }
+    const BarrierStats& GetStats() const { return m_Stats; }
+
+    void TrackResource(ID3D12Resource* inResource, D3D12_RESOURCE_STATES inState);
+    void ForgetResource(ID3D12Resource* inResource);
+    void Transition(ID3D12Resource* inResource, D3D12_RESOURCE_STATES inState, uint32_t inSubresource = D3D12_RESOURCE_BARRIER_ALL_SUBRESOURCES);
+    // Starts a split barrier, the matching end barrier is queued by the next Transition of the resource
+    void BeginSplitTransition(ID3D12Resource* inResource, D3D12_RESOURCE_STATES inState);
+    void UAVBarrier(ID3D12Resource* inResource);
+    void Flush(ID3D12GraphicsCommandList* inCommandList);
+    // Reports the stats of the frame to the hook and starts counting again
+    void EndFrame();
+
+private:
+    struct ResourceState
+    {
+        D3D12_RESOURCE_STATES               State {D3D12_RESOURCE_STATE_COMMON};
+        std::vector<D3D12_RESOURCE_STATES>  Subresources; // empty while every subresource is in State
+        bool                                SplitInFlight = false;
+        D3D12_RESOURCE_STATES               SplitBefore {D3D12_RESOURCE_STATE_COMMON};
+    };
+
+    void QueueTransition(ID3D12Resource* inResource, uint32_t inSubresource, D3D12_RESOURCE_STATES inBefore, D3D12_RESOURCE_STATES inAfter);
+    static uint32_t GetSubresourceCount(ID3D12Resource* inResource);
+    static bool IsReadOnlyState(D3D12_RESOURCE_STATES inState);
+
+    std::unordered_map<ID3D12Resource*, ResourceState>  m_States;
+    std::vector<D3D12_RESOURCE_BARRIER>                 m_PendingBarriers;
+    BarrierStats                                        m_Stats;
+    BarrierStatsHook                                    m_StatsHook;
+};
+
 class AppBaseDx : public Win32Base
 {
 public:
@@ -45,7 +100,8 @@ public:
         , D3D12_RESOURCE_STATES initState
         , D3D12_HEAP_TYPE inHeapType
         , D3D12_RESOURCE_FLAGS inFlags
-        , const D3D12_CLEAR_VALUE* inClearValue);
+        , const D3D12_CLEAR_VALUE* inClearValue
+        , uint16_t inMipLevels = 1);
 
     Microsoft::WRL::ComPtr<ID3D12Resource> UploadBuffer(ID3D12Resource* dstBuffer
         , const void* inData
@@ -61,12 +117,47 @@ public:
 
     static void LogAdapterDesc(const DXGI_ADAPTER_DESC1& inDesc);
 
+    // Look up the pipeline by name in the pipeline library, create and store it on a miss
+    Microsoft::WRL::ComPtr<ID3D12PipelineState> LoadGraphicsPipeline(const wchar_t* inName, const D3D12_GRAPHICS_PIPELINE_STATE_DESC& inDesc);
+    Microsoft::WRL::ComPtr<ID3D12PipelineState> LoadComputePipeline(const wchar_t* inName, const D3D12_COMPUTE_PIPELINE_STATE_DESC& inDesc);
+    Microsoft::WRL::ComPtr<ID3D12PipelineState> LoadPipeline(const wchar_t* inName, const D3D12_PIPELINE_STATE_STREAM_DESC& inDesc);
+
+    // Runs the pipeline creation tasks on worker threads and the calling one, ID3D12Device and ID3D12PipelineLibrary
+    // are free-threaded
+    bool CreatePipelinesParallel(const std::vector<std::function<bool()>>& inTasks);
+
+    // Timestamps around the commands recorded in between on m_CommandList, scopes nest. Does nothing until
+    // CreateGpuProfiler succeeded, the results arrive GpuProfiler::s_FrameLatency command lists later.
+    void BeginGpuScope(const char* inName);
+    void EndGpuScope();
+
 protected:
     bool CreateCommandQueue();
     bool CreateCommandList();
-    bool CreateDescriptorHeaps();
+    bool CreateDescriptorHeaps(uint32_t inShaderBoundViewCount = 8);
     bool CreateSwapChain();
     void FlushCommandQueue();
+    bool CreatePipelineLibrary(const char* inLibraryName);
+    // Saves the library when a pipeline was added, rebuilt from the pipelines of this run when an entry went stale
+    void DestroyPipelineLibrary();
+    // Names must be unique, a duplicate is not stored and logs a warning
+    void AddPipelineLibraryEntry(const wchar_t* inName, ID3D12PipelineState* inPipeline, bool inIsLoaded);
+    // Every BeginCommandList starts a profiler frame, EndCommandList resolves its timestamps into the readback buffer.
+    // Call after CreateCommandQueue, succeeds without profiling when the queue has no timestamps.
+    bool CreateGpuProfiler();
+    void DestroyGpuProfiler();
+    void ReadBackGpuProfiler(uint32_t inSlot);
+    void CollectTraceEvents(std::vector<TraceEvent>& outEvents) override;
+    // Hi-Z pyramid of a depth buffer created as R32_TYPELESS, see HiZPyramid for the layout. Takes
+    // GetHiZDescriptorCount() descriptors of m_ShaderBoundViewHeap from inFirstSlot on, the last one is the SRV of the
+    // whole pyramid. Call after CreatePipelineLibrary.
+    bool CreateHiZPyramid(ID3D12Resource* inDepthBuffer, uint32_t inFirstSlot);
+    // Records the build on m_CommandList with the descriptor heaps set. The depth buffer goes back to DEPTH_WRITE, the
+    // pyramid is left readable by non pixel shaders.
+    void BuildHiZPyramid();
+    D3D12_GPU_DESCRIPTOR_HANDLE GetHiZPyramidSrv() const;
+    HiZCullingConstants GetHiZCullingConstants(uint32_t inPhase, uint32_t inObjectCount) const;
+    static uint32_t GetHiZDescriptorCount() { return HiZPyramid::s_MaxMipCount + 2; }
     
     Microsoft::WRL::ComPtr<IDXGIFactory2>               m_FactoryHandle;
     Microsoft::WRL::ComPtr<IDXGIAdapter1>               m_AdapterHandle;
@@ -76,6 +167,10 @@ protected:
     Microsoft::WRL::ComPtr<ID3D12CommandAllocator>      m_CommandAllocator;
     Microsoft::WRL::ComPtr<ID3D12GraphicsCommandList6>  m_CommandList;
     bool                                                m_CommandListIsClosed = false;         
+    ResourceStateTracker                                m_StateTracker;
+    GpuProfiler                                         m_GpuProfiler;
+    Microsoft::WRL::ComPtr<ID3D12QueryHeap>             m_TimestampQueryHeap; // GpuProfiler::s_QueriesPerFrame per frame slot
+    Microsoft::WRL::ComPtr<ID3D12Resource>              m_TimestampReadback;
 
     Microsoft::WRL::ComPtr<ID3D12DescriptorHeap>        m_RtvHeap;
     Microsoft::WRL::ComPtr<ID3D12DescriptorHeap>        m_DsvHeap;
@@ -86,5 +181,20 @@ protected:
     std::vector<D3D12_CPU_DESCRIPTOR_HANDLE>            m_RtvHandles;
     std::vector<Microsoft::WRL::ComPtr<ID3D12Resource>> m_BackBuffers;
     uint32_t                                            m_CurrentIndex{0};
-    
+
+    std::vector<uint8_t>                                m_PipelineLibraryData; // must outlive m_PipelineLibrary
+    Microsoft::WRL::ComPtr<ID3D12PipelineLibrary1>      m_PipelineLibrary;
+    std::vector<std::pair<std::wstring, Microsoft::WRL::ComPtr<ID3D12PipelineState>>> m_PipelineLibraryEntries; // loaded or created this run
+    std::filesystem::path                               m_PipelineLibraryPath;
+    std::mutex                                          m_PipelineLibraryMutex;
+    bool                                                m_PipelineLibraryIsWarm = false;
+    bool                                                m_PipelineLibraryIsDirty = false;
+    bool                                                m_PipelineLibraryNeedsRebuild = false;
+
+    Microsoft::WRL::ComPtr<ID3D12RootSignature>         m_HiZRootSignature;
+    Microsoft::WRL::ComPtr<ID3D12PipelineState>         m_HiZPipelineState;
+    Microsoft::WRL::ComPtr<ID3D12Resource>              m_HiZPyramid;
+    ID3D12Resource*                                     m_HiZDepthBuffer = nullptr;
+    uint32_t                                            m_HiZFirstSlot = 0;     // the depth SRV, then one UAV per level
+    uint32_t                                            m_HiZMipCount = 0;
 };
\ No newline at end of file
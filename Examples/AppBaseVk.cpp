@@ -1,5 +1,10 @@
 #include "AppBaseVk.h"
+#include "CpuProfiler.h"
 #include <array>
+#include <algorithm>
+#include <chrono>
+#include <future>
+#include <fstream>
 
 void WriteBufferData(VkDevice inDevice, VkDeviceMemory inBuffer, const void* inData, size_t inSize, size_t inOffset)
 {
@@ -77,7 +82,7 @@ bool AppBaseVk::CreateCommandList()
     VkResult result = vkCreateCommandPool(m_DeviceHandle, &cmdPoolCreateInfo, nullptr, &m_CmdPoolHandle);
     if(result != VK_SUCCESS)
     {
-        Log::Error("Failed to create command pool");
+        LOG_ERROR("Failed to create command pool");
         return false;
     }
 
@@ -90,7 +95,7 @@ bool AppBaseVk::CreateCommandList()
     result = vkAllocateCommandBuffers(m_DeviceHandle, &cmdBufferAllocInfo, &m_CmdBufferHandle);
     if(result != VK_SUCCESS)
     {
-        Log::Error("Failed to allocate command buffer");
+        LOG_ERROR("Failed to allocate command buffer");
         return false;
     }
     
@@ -122,6 +127,18 @@ void AppBaseVk::BeginCommandList()
         beginInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO;
         vkBeginCommandBuffer(m_CmdBufferHandle, &beginInfo);
         m_CmdBufferIsClosed = false;
+        // The command pool reset above already requires the last submission to be done, so are its descriptor sets
+        m_FrameDescriptorAllocator.Reset();
+
+        if(m_TimestampQueryPool != VK_NULL_HANDLE && m_GpuProfiler.IsInitialized())
+        {
+            // The slot was recorded s_FrameLatency command lists ago, read it back before its queries are reset
+            const uint32_t slot = m_GpuProfiler.GetNextSlot();
+            if(m_GpuProfiler.IsSlotPending(slot))
+                ReadBackGpuProfiler(slot, false);
+            vkCmdResetQueryPool(m_CmdBufferHandle, m_TimestampQueryPool, GpuProfiler::GetSlotFirstQuery(slot), GpuProfiler::s_QueriesPerFrame);
+            m_GpuProfiler.BeginFrame();
+        }
     }
 }
 
@@ -129,6 +146,8 @@ void AppBaseVk::EndCommandList()
 {
     if (!m_CmdBufferIsClosed)
     {
+        m_StateTracker.Flush(m_CmdBufferHandle);
+        m_GpuProfiler.EndFrame();
         vkEndCommandBuffer(m_CmdBufferHandle);
         m_CmdBufferIsClosed = true;
     }
@@ -178,15 +197,24 @@ bool AppBaseVk::CreateDescriptorSetPool()
 
     if(result != VK_SUCCESS)
     {
-        Log::Error("Failed to create descriptor pool");
+        LOG_ERROR("Failed to create descriptor pool");
         return false;
     }
+
+    m_DescriptorLayoutCache.Init(m_DeviceHandle);
+    m_PersistentDescriptorAllocator.Init(m_DeviceHandle, VK_DESCRIPTOR_POOL_CREATE_FREE_DESCRIPTOR_SET_BIT);
+    m_FrameDescriptorAllocator.Init(m_DeviceHandle);
     
     return true;
 }
 
 void AppBaseVk::DestroyDescriptorSetPool()
 {
+    DestroyBindlessDescriptorSet();
+    m_PersistentDescriptorAllocator.Destroy();
+    m_FrameDescriptorAllocator.Destroy();
+    m_DescriptorLayoutCache.Destroy();
+    
     if(m_DescriptorPoolHandle != VK_NULL_HANDLE)
     {
         vkDestroyDescriptorPool(m_DeviceHandle, m_DescriptorPoolHandle, nullptr);
@@ -194,21 +222,360 @@ void AppBaseVk::DestroyDescriptorSetPool()
     }
 }
 
+VkDescriptorSetLayout AppBaseVk::GetDescriptorSetLayout(const std::vector<VkDescriptorSetLayoutBinding>& inBindings
+    , const std::vector<VkDescriptorBindingFlags>& inBindingFlags
+    , VkDescriptorSetLayoutCreateFlags inFlags)
+{
+    return m_DescriptorLayoutCache.GetLayout(inBindings, inBindingFlags, inFlags);
+}
+
+bool AppBaseVk::AllocatePersistentDescriptorSet(VkDescriptorSetLayout inLayout, VkDescriptorSet& outSet, uint32_t inVariableDescriptorCount)
+{
+    return m_PersistentDescriptorAllocator.Allocate(inLayout, outSet, inVariableDescriptorCount);
+}
+
+bool AppBaseVk::AllocateFrameDescriptorSet(VkDescriptorSetLayout inLayout, VkDescriptorSet& outSet, uint32_t inVariableDescriptorCount)
+{
+    return m_FrameDescriptorAllocator.Allocate(inLayout, outSet, inVariableDescriptorCount);
+}
+
+bool AppBaseVk::CreateBindlessDescriptorSet(uint32_t inMaxTextures)
+{
+    VkPhysicalDeviceDescriptorIndexingProperties indexingProperties{};
+    indexingProperties.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_DESCRIPTOR_INDEXING_PROPERTIES;
+    VkPhysicalDeviceProperties2 properties2{};
+    properties2.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_PROPERTIES_2;
+    properties2.pNext = &indexingProperties;
+    vkGetPhysicalDeviceProperties2(m_GpuHandle, &properties2);
+
+    // The table is visible to every stage, so the per stage limit applies as well as the per set one
+    m_BindlessCapacity = std::min({inMaxTextures
+        , indexingProperties.maxDescriptorSetUpdateAfterBindSampledImages
+        , indexingProperties.maxPerStageDescriptorUpdateAfterBindSampledImages});
+    m_BindlessTextureCount = 0;
+    if(m_BindlessCapacity == 0)
+    {
+        LOG_ERROR("[Vulkan] The device does not support update after bind sampled images");
+        return false;
+    }
+
+    // _MainTex[] : register(t0, space1)
+    std::vector<VkDescriptorSetLayoutBinding> bindings;
+    bindings.push_back({GetBindingSlot(ERegisterType::ShaderResource, 0), VK_DESCRIPTOR_TYPE_SAMPLED_IMAGE, m_BindlessCapacity, VK_SHADER_STAGE_ALL, nullptr});
+    std::vector<VkDescriptorBindingFlags> bindingFlags = {
+        VK_DESCRIPTOR_BINDING_UPDATE_AFTER_BIND_BIT
+        | VK_DESCRIPTOR_BINDING_PARTIALLY_BOUND_BIT
+        | VK_DESCRIPTOR_BINDING_VARIABLE_DESCRIPTOR_COUNT_BIT
+    };
+    m_BindlessLayout = GetDescriptorSetLayout(bindings, bindingFlags, VK_DESCRIPTOR_SET_LAYOUT_CREATE_UPDATE_AFTER_BIND_POOL_BIT);
+    if(m_BindlessLayout == VK_NULL_HANDLE)
+    {
+        LOG_ERROR("[Vulkan] Failed to create bindless descriptor set layout");
+        return false;
+    }
+
+    VkDescriptorPoolSize poolSize{VK_DESCRIPTOR_TYPE_SAMPLED_IMAGE, m_BindlessCapacity};
+    VkDescriptorPoolCreateInfo poolInfo{};
+    poolInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_POOL_CREATE_INFO;
+    poolInfo.flags = VK_DESCRIPTOR_POOL_CREATE_UPDATE_AFTER_BIND_BIT;
+    poolInfo.maxSets = 1;
+    poolInfo.poolSizeCount = 1;
+    poolInfo.pPoolSizes = &poolSize;
+    if(vkCreateDescriptorPool(m_DeviceHandle, &poolInfo, nullptr, &m_BindlessPoolHandle) != VK_SUCCESS)
+    {
+        LOG_ERROR("[Vulkan] Failed to create bindless descriptor pool");
+        return false;
+    }
+
+    VkDescriptorSetVariableDescriptorCountAllocateInfo variableCountInfo{};
+    variableCountInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_VARIABLE_DESCRIPTOR_COUNT_ALLOCATE_INFO;
+    variableCountInfo.descriptorSetCount = 1;
+    variableCountInfo.pDescriptorCounts = &m_BindlessCapacity;
+
+    VkDescriptorSetAllocateInfo allocInfo{};
+    allocInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_ALLOCATE_INFO;
+    allocInfo.pNext = &variableCountInfo;
+    allocInfo.descriptorPool = m_BindlessPoolHandle;
+    allocInfo.descriptorSetCount = 1;
+    allocInfo.pSetLayouts = &m_BindlessLayout;
+    if(vkAllocateDescriptorSets(m_DeviceHandle, &allocInfo, &m_BindlessSet) != VK_SUCCESS)
+    {
+        LOG_ERROR("[Vulkan] Failed to allocate bindless descriptor set");
+        return false;
+    }
+
+    LOG_INFO("[Vulkan] Bindless texture table: %u slots", m_BindlessCapacity);
+    return true;
+}
+
+void AppBaseVk::DestroyBindlessDescriptorSet()
+{
+    // The set is freed with its pool, the layout belongs to m_DescriptorLayoutCache
+    if(m_BindlessPoolHandle != VK_NULL_HANDLE)
+    {
+        vkDestroyDescriptorPool(m_DeviceHandle, m_BindlessPoolHandle, nullptr);
+        m_BindlessPoolHandle = VK_NULL_HANDLE;
+    }
+    m_BindlessSet = VK_NULL_HANDLE;
+    m_BindlessLayout = VK_NULL_HANDLE;
+    m_BindlessCapacity = 0;
+    m_BindlessTextureCount = 0;
+}
+
+uint32_t AppBaseVk::RegisterBindlessTexture(VkImageView inImageView)
+{
+    if(m_BindlessSet == VK_NULL_HANDLE || m_BindlessTextureCount >= m_BindlessCapacity)
+    {
+        LOG_ERROR("[Vulkan] Bindless texture table is full (%u slots)", m_BindlessCapacity);
+        return UINT32_MAX;
+    }
+
+    const uint32_t index = m_BindlessTextureCount++;
+    VkDescriptorImageInfo imageInfo = CreateDescriptorImageInfo(inImageView, VK_NULL_HANDLE);
+    VkWriteDescriptorSet write{};
+    UpdateImageDescriptor(write, m_BindlessSet, VK_DESCRIPTOR_TYPE_SAMPLED_IMAGE, &imageInfo, 1, GetBindingSlot(ERegisterType::ShaderResource, 0));
+    write.dstArrayElement = index;
+    // UPDATE_AFTER_BIND allows writing while the set is bound in a pending command buffer
+    vkUpdateDescriptorSets(m_DeviceHandle, 1, &write, 0, nullptr);
+    return index;
+}
+
+void DescriptorAllocator::Init(VkDevice inDevice, VkDescriptorPoolCreateFlags inFlags)
+{
+    m_Device = inDevice;
+    m_Flags = inFlags;
+}
+
+void DescriptorAllocator::Destroy()
+{
+    for(VkDescriptorPool pool : m_UsedPools)
+        vkDestroyDescriptorPool(m_Device, pool, nullptr);
+    for(VkDescriptorPool pool : m_FreePools)
+        vkDestroyDescriptorPool(m_Device, pool, nullptr);
+    m_UsedPools.clear();
+    m_FreePools.clear();
+    m_CurrentPool = VK_NULL_HANDLE;
+}
+
+void DescriptorAllocator::Reset()
+{
+    for(VkDescriptorPool pool : m_UsedPools)
+    {
+        vkResetDescriptorPool(m_Device, pool, 0);
+        m_FreePools.push_back(pool);
+    }
+    m_UsedPools.clear();
+    m_CurrentPool = VK_NULL_HANDLE;
+}
+
+VkDescriptorPool DescriptorAllocator::GrabPool()
+{
+    if(!m_FreePools.empty())
+    {
+        VkDescriptorPool pool = m_FreePools.back();
+        m_FreePools.pop_back();
+        return pool;
+    }
+
+    // Relative weights of each descriptor type per set, scaled by s_SetsPerPool
+    static constexpr std::array<std::pair<VkDescriptorType, float>, 7> s_PoolRatios = {{
+        {VK_DESCRIPTOR_TYPE_SAMPLER, 0.5f},
+        {VK_DESCRIPTOR_TYPE_SAMPLED_IMAGE, 4.0f},
+        {VK_DESCRIPTOR_TYPE_STORAGE_IMAGE, 1.0f},
+        {VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER, 2.0f},
+        {VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, 2.0f},
+        {VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER_DYNAMIC, 1.0f},
+        {VK_DESCRIPTOR_TYPE_STORAGE_BUFFER_DYNAMIC, 1.0f}
+    }};
+
+    std::array<VkDescriptorPoolSize, s_PoolRatios.size()> poolSizes{};
+    for(size_t i = 0; i < s_PoolRatios.size(); ++i)
+    {
+        poolSizes[i].type = s_PoolRatios[i].first;
+        poolSizes[i].descriptorCount = static_cast<uint32_t>(s_PoolRatios[i].second * s_SetsPerPool);
+    }
+
+    VkDescriptorPoolCreateInfo poolInfo{};
+    poolInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_POOL_CREATE_INFO;
+    poolInfo.flags = m_Flags;
+    poolInfo.maxSets = s_SetsPerPool;
+    poolInfo.poolSizeCount = static_cast<uint32_t>(poolSizes.size());
+    poolInfo.pPoolSizes = poolSizes.data();
+
+    VkDescriptorPool pool = VK_NULL_HANDLE;
+    if(vkCreateDescriptorPool(m_Device, &poolInfo, nullptr, &pool) != VK_SUCCESS)
+    {
+        LOG_ERROR("[Vulkan] Failed to create descriptor pool");
+        return VK_NULL_HANDLE;
+    }
+    return pool;
+}
+
+bool DescriptorAllocator::Allocate(VkDescriptorSetLayout inLayout, VkDescriptorSet& outSet, uint32_t inVariableDescriptorCount)
+{
+    if(m_CurrentPool == VK_NULL_HANDLE)
+    {
+        m_CurrentPool = GrabPool();
+        if(m_CurrentPool == VK_NULL_HANDLE)
+            return false;
+        m_UsedPools.push_back(m_CurrentPool);
+    }
+
+    VkDescriptorSetVariableDescriptorCountAllocateInfo variableCountInfo{};
+    variableCountInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_VARIABLE_DESCRIPTOR_COUNT_ALLOCATE_INFO;
+    variableCountInfo.descriptorSetCount = 1;
+    variableCountInfo.pDescriptorCounts = &inVariableDescriptorCount;
+
+    VkDescriptorSetAllocateInfo allocInfo{};
+    allocInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_ALLOCATE_INFO;
+    allocInfo.pNext = inVariableDescriptorCount > 0 ? &variableCountInfo : nullptr;
+    allocInfo.descriptorPool = m_CurrentPool;
+    allocInfo.descriptorSetCount = 1;
+    allocInfo.pSetLayouts = &inLayout;
+
+    VkResult result = vkAllocateDescriptorSets(m_Device, &allocInfo, &outSet);
+    if(result == VK_ERROR_OUT_OF_POOL_MEMORY || result == VK_ERROR_FRAGMENTED_POOL)
+    {
+        // The current pool is exhausted, retry once with a fresh one
+        m_CurrentPool = GrabPool();
+        if(m_CurrentPool == VK_NULL_HANDLE)
+            return false;
+        m_UsedPools.push_back(m_CurrentPool);
+        allocInfo.descriptorPool = m_CurrentPool;
+        result = vkAllocateDescriptorSets(m_Device, &allocInfo, &outSet);
+    }
+
+    if(result != VK_SUCCESS)
+    {
+        LOG_ERROR("[Vulkan] Failed to allocate descriptor set");
+        return false;
+    }
+    return true;
+}
+
+bool DescriptorSetLayoutCache::LayoutKey::operator==(const LayoutKey& inOther) const
+{
+    if(Flags != inOther.Flags || Bindings.size() != inOther.Bindings.size() || BindingFlags != inOther.BindingFlags)
+        return false;
+    for(size_t i = 0; i < Bindings.size(); ++i)
+    {
+        const VkDescriptorSetLayoutBinding& a = Bindings[i];
+        const VkDescriptorSetLayoutBinding& b = inOther.Bindings[i];
+        if(a.binding != b.binding
+            || a.descriptorType != b.descriptorType
+            || a.descriptorCount != b.descriptorCount
+            || a.stageFlags != b.stageFlags
+            || a.pImmutableSamplers != b.pImmutableSamplers)
+            return false;
+    }
+    return true;
+}
+
+size_t DescriptorSetLayoutCache::LayoutKeyHash::operator()(const LayoutKey& inKey) const
+{
+    size_t hash = std::hash<uint32_t>()(inKey.Flags);
+    auto combine = [&hash](size_t inValue) { hash ^= inValue + 0x9e3779b9 + (hash << 6) + (hash >> 2); };
+    for(const VkDescriptorSetLayoutBinding& binding : inKey.Bindings)
+    {
+        combine(binding.binding);
+        combine(binding.descriptorType);
+        combine(binding.descriptorCount);
+        combine(binding.stageFlags);
+    }
+    for(VkDescriptorBindingFlags flags : inKey.BindingFlags)
+        combine(flags);
+    return hash;
+}
+
+void DescriptorSetLayoutCache::Init(VkDevice inDevice)
+{
+    m_Device = inDevice;
+}
+
+void DescriptorSetLayoutCache::Destroy()
+{
+    for(auto& pair : m_Layouts)
+        vkDestroyDescriptorSetLayout(m_Device, pair.second, nullptr);
+    m_Layouts.clear();
+}
+
+VkDescriptorSetLayout DescriptorSetLayoutCache::GetLayout(const std::vector<VkDescriptorSetLayoutBinding>& inBindings
+    , const std::vector<VkDescriptorBindingFlags>& inBindingFlags
+    , VkDescriptorSetLayoutCreateFlags inFlags)
+{
+    // Sort by binding slot so the same layout declared in a different order hits the cache
+    LayoutKey key{inBindings, inBindingFlags, inFlags};
+    std::vector<uint32_t> order(key.Bindings.size());
+    for(uint32_t i = 0; i < order.size(); ++i)
+        order[i] = i;
+    std::sort(order.begin(), order.end(), [&inBindings](uint32_t a, uint32_t b) { return inBindings[a].binding < inBindings[b].binding; });
+    for(size_t i = 0; i < order.size(); ++i)
+    {
+        key.Bindings[i] = inBindings[order[i]];
+        if(!inBindingFlags.empty())
+            key.BindingFlags[i] = inBindingFlags[order[i]];
+    }
+
+    auto iter = m_Layouts.find(key);
+    if(iter != m_Layouts.end())
+        return iter->second;
+
+    VkDescriptorSetLayoutBindingFlagsCreateInfo bindingFlagsInfo{};
+    bindingFlagsInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_LAYOUT_BINDING_FLAGS_CREATE_INFO;
+    bindingFlagsInfo.bindingCount = static_cast<uint32_t>(key.BindingFlags.size());
+    bindingFlagsInfo.pBindingFlags = key.BindingFlags.data();
+
+    VkDescriptorSetLayoutCreateInfo layoutInfo{};
+    layoutInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_LAYOUT_CREATE_INFO;
+    layoutInfo.pNext = key.BindingFlags.empty() ? nullptr : &bindingFlagsInfo;
+    layoutInfo.flags = inFlags;
+    layoutInfo.bindingCount = static_cast<uint32_t>(key.Bindings.size());
+    layoutInfo.pBindings = key.Bindings.data();
+
+    VkDescriptorSetLayout layout = VK_NULL_HANDLE;
+    if(vkCreateDescriptorSetLayout(m_Device, &layoutInfo, nullptr, &layout) != VK_SUCCESS)
+    {
+        LOG_ERROR("[Vulkan] Failed to create descriptor set layout");
+        return VK_NULL_HANDLE;
+    }
+
+    m_Layouts.emplace(std::move(key), layout);
+    return layout;
+}
+
 bool AppBaseVk::CreateBuffer(size_t inSize
     , VkBufferUsageFlags inUsage
     , VkMemoryPropertyFlags inProperties
     , VkBuffer& outBuffer
-    , VkDeviceMemory& outBufferMemory)
+    , VkDeviceMemory& outBufferMemory
+    , bool inShareWithAsyncQueues)
 {
     VkBufferCreateInfo bufferInfo{};
     bufferInfo.sType = VK_STRUCTURE_TYPE_BUFFER_CREATE_INFO;
     bufferInfo.size = inSize;
     bufferInfo.sharingMode = VK_SHARING_MODE_EXCLUSIVE;
     bufferInfo.usage = inUsage;
+
+    // Concurrent sharing saves the queue family ownership transfers, only needed when the families differ
+    std::vector<uint32_t> queueFamilies = { static_cast<uint32_t>(m_QueueIndex) };
+    if(inShareWithAsyncQueues)
+    {
+        for(int family : { m_ComputeQueueIndex, m_TransferQueueIndex })
+        {
+            if(family >= 0 && family != m_QueueIndex)
+                queueFamilies.push_back(static_cast<uint32_t>(family));
+        }
+    }
+    if(queueFamilies.size() > 1)
+    {
+        bufferInfo.sharingMode = VK_SHARING_MODE_CONCURRENT;
+        bufferInfo.queueFamilyIndexCount = static_cast<uint32_t>(queueFamilies.size());
+        bufferInfo.pQueueFamilyIndices = queueFamilies.data();
+    }
     VkResult result = vkCreateBuffer(m_DeviceHandle, &bufferInfo, nullptr, &outBuffer);
     if(result != VK_SUCCESS)
     {
-        Log::Error("Failed to create buffer");
+        LOG_ERROR("Failed to create buffer");
         return false;
     }
 
@@ -230,14 +597,14 @@ bool AppBaseVk::CreateBuffer(size_t inSize
     result = vkAllocateMemory(m_DeviceHandle, &allocInfo, nullptr, &outBufferMemory);
     if(result != VK_SUCCESS)
     {
-        Log::Error("Failed to allocate memory for buffer");
+        LOG_ERROR("Failed to allocate memory for buffer");
         return false;
     }
     
     result = vkBindBufferMemory(m_DeviceHandle, outBuffer, outBufferMemory, 0);
     if(result != VK_SUCCESS)
     {
-        Log::Error("Failed to bind buffer memory");
+        LOG_ERROR("Failed to bind buffer memory");
         return false;
     }
     
@@ -272,7 +639,7 @@ bool AppBaseVk::CreateTexture(size_t inWidth
 
     if(result != VK_SUCCESS)
     {
-        Log::Error("Failed to create texture 2d");
+        LOG_ERROR("Failed to create texture 2d");
         return false;
     }
     
@@ -287,14 +654,14 @@ bool AppBaseVk::CreateTexture(size_t inWidth
     result = vkAllocateMemory(m_DeviceHandle, &allocInfo, nullptr, &outImageMemory);
     if(result != VK_SUCCESS)
     {
-        Log::Error("Failed to allocate memory for texture 2d");
+        LOG_ERROR("Failed to allocate memory for texture 2d");
         return false;
     }
 
     result = vkBindImageMemory(m_DeviceHandle, outImage, outImageMemory, 0);
     if(result != VK_SUCCESS)
     {
-        Log::Error("Failed to bind image memory");
+        LOG_ERROR("Failed to bind image memory");
         return false;
     }
     
@@ -331,7 +698,7 @@ std::shared_ptr<StagingBuffer> AppBaseVk::CreateStagingBuffer(size_t inSize)
     VkDeviceMemory memory;
     if(!CreateBuffer(inSize, VK_BUFFER_USAGE_TRANSFER_SRC_BIT, VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT, buffer, memory))
     {
-        Log::Error("Failed to create staging buffer");
+        LOG_ERROR("Failed to create staging buffer");
         return nullptr;
     }
     return std::make_shared<StagingBuffer>(m_DeviceHandle, buffer, memory);
@@ -380,7 +747,7 @@ bool AppBaseVk::CreateSampler(VkSampler& outSampler)
 	
     if(vkCreateSampler(m_DeviceHandle, &samplerInfo, nullptr, &outSampler) != VK_SUCCESS)
     {
-        Log::Error("Failed to create sampler");
+        LOG_ERROR("Failed to create sampler");
         return false;
     }
 
@@ -402,6 +769,8 @@ std::shared_ptr<StagingBuffer> AppBaseVk::UploadBuffer(VkBuffer dstBuffer, const
     copyRegion.srcOffset = 0;
     copyRegion.dstOffset = dstOffset;
     vkCmdCopyBuffer(m_CmdBufferHandle, stagingBuffer->m_Buffer, dstBuffer, 1, &copyRegion);
+    // Lets the first pass that declares a read of dstBuffer wait for the copy
+    m_StateTracker.BufferAccess(dstBuffer, VK_PIPELINE_STAGE_2_TRANSFER_BIT, VK_ACCESS_2_TRANSFER_WRITE_BIT);
 
     return stagingBuffer;
 }
@@ -417,21 +786,10 @@ std::shared_ptr<StagingBuffer> AppBaseVk::UploadTexture(VkImage dstTexture, cons
 
     WriteBufferData(m_DeviceHandle, stagingBuffer->m_Memory, srcData, size, 0);
 
-    VkImageMemoryBarrier barrier = ImageMemoryBarrier(dstTexture
-        , VK_IMAGE_LAYOUT_UNDEFINED
-        , VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL
-        , VK_ACCESS_NONE
-        , VK_ACCESS_TRANSFER_WRITE_BIT
-        , VK_IMAGE_ASPECT_COLOR_BIT);
-    
-    vkCmdPipelineBarrier(
-        m_CmdBufferHandle,
-        VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT, VK_PIPELINE_STAGE_TRANSFER_BIT,
-        0,
-        0, nullptr,
-        0, nullptr,
-        1, &barrier
-    );
+    // The copy needs the barrier right away, the transition to shader read is batched with the next pass
+    m_StateTracker.TrackImage(dstTexture, VK_IMAGE_ASPECT_COLOR_BIT, VK_IMAGE_LAYOUT_UNDEFINED);
+    m_StateTracker.TransitionImage(dstTexture, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, VK_PIPELINE_STAGE_2_TRANSFER_BIT, VK_ACCESS_2_TRANSFER_WRITE_BIT, true);
+    m_StateTracker.Flush(m_CmdBufferHandle);
     
     VkBufferImageCopy region{};
     region.bufferOffset = 0;
@@ -446,27 +804,87 @@ std::shared_ptr<StagingBuffer> AppBaseVk::UploadTexture(VkImage dstTexture, cons
 
     vkCmdCopyBufferToImage(m_CmdBufferHandle, stagingBuffer->m_Buffer, dstTexture, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, 1, &region);
 
-    barrier = ImageMemoryBarrier(dstTexture
-        , VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL
+    m_StateTracker.TransitionImage(dstTexture
         , VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL
-        , VK_ACCESS_TRANSFER_WRITE_BIT
-        , VK_ACCESS_SHADER_READ_BIT
-        , VK_IMAGE_ASPECT_COLOR_BIT);
-    
-    vkCmdPipelineBarrier(
-        m_CmdBufferHandle,
-        VK_PIPELINE_STAGE_TRANSFER_BIT, VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT,
-        0,
-        0, nullptr,
-        0, nullptr,
-        1, &barrier
-    );
+        , VK_PIPELINE_STAGE_2_FRAGMENT_SHADER_BIT | VK_PIPELINE_STAGE_2_COMPUTE_SHADER_BIT
+        , VK_ACCESS_2_SHADER_READ_BIT);
 
     return stagingBuffer;
 }
 
+void AppBaseVk::AddSurfaceExtensions(std::vector<const char*>& inOutExtensions) const
+{
+    if(IsHeadless())
+        return;
+
+    inOutExtensions.push_back(VK_KHR_SURFACE_EXTENSION_NAME);
+#ifdef _WIN32
+    inOutExtensions.push_back(VK_KHR_WIN32_SURFACE_EXTENSION_NAME);
+#endif
+}
+
+bool AppBaseVk::CreateSurface()
+{
+    if(IsHeadless())
+        return true;
+
+#ifdef _WIN32
+    VkWin32SurfaceCreateInfoKHR surfaceCreateInfo{};
+    surfaceCreateInfo.sType = VK_STRUCTURE_TYPE_WIN32_SURFACE_CREATE_INFO_KHR;
+    surfaceCreateInfo.hwnd = m_hWnd;
+    surfaceCreateInfo.hinstance = m_hInstance;
+    if(vkCreateWin32SurfaceKHR(m_InstanceHandle, &surfaceCreateInfo, nullptr, &m_SurfaceHandle) != VK_SUCCESS)
+    {
+        LOG_ERROR("[Vulkan] Failed to create the window surface");
+        return false;
+    }
+    return true;
+#else
+    LOG_ERROR("[Vulkan] No window surface on this platform");
+    return false;
+#endif
+}
+
+bool AppBaseVk::IsPresentSupported(uint32_t inQueueFamily) const
+{
+    if(IsHeadless())
+        return true;
+
+    VkBool32 presentSupport = VK_FALSE;
+    vkGetPhysicalDeviceSurfaceSupportKHR(m_GpuHandle, inQueueFamily, m_SurfaceHandle, &presentSupport);
+    return presentSupport == VK_TRUE;
+}
+
 bool AppBaseVk::CreateSwapChain()
 {
+    if(IsHeadless())
+    {
+        // Same usage as the swap chain images plus TRANSFER_SRC for the screenshot
+        m_Capabilities.currentExtent = { m_Width, m_Height };
+        m_BackBuffers.resize(s_BackBufferCount, VK_NULL_HANDLE);
+        m_BackBufferViews.resize(s_BackBufferCount, VK_NULL_HANDLE);
+        m_OffscreenBackBufferMemories.resize(s_BackBufferCount, VK_NULL_HANDLE);
+        for(uint32_t i = 0; i < s_BackBufferCount; ++i)
+        {
+            if(!CreateTexture(m_Width
+                , m_Height
+                , s_BackBufferFormat
+                , VK_IMAGE_USAGE_COLOR_ATTACHMENT_BIT | VK_IMAGE_USAGE_TRANSFER_SRC_BIT | VK_IMAGE_USAGE_TRANSFER_DST_BIT | VK_IMAGE_USAGE_SAMPLED_BIT | VK_IMAGE_USAGE_STORAGE_BIT
+                , VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT
+                , VK_IMAGE_LAYOUT_UNDEFINED
+                , m_BackBuffers[i]
+                , m_OffscreenBackBufferMemories[i]))
+            {
+                LOG_ERROR("[Vulkan] Failed to create the offscreen back buffers");
+                return false;
+            }
+            CreateImageView(m_BackBuffers[i], s_BackBufferFormat, VK_IMAGE_ASPECT_COLOR_BIT, m_BackBufferViews[i]);
+            m_StateTracker.TrackImage(m_BackBuffers[i], VK_IMAGE_ASPECT_COLOR_BIT, VK_IMAGE_LAYOUT_UNDEFINED);
+        }
+        m_CurrentIndex = 0;
+        return true;
+    }
+
     uint32_t formatCount;
     vkGetPhysicalDeviceSurfaceFormatsKHR(m_GpuHandle, m_SurfaceHandle, &formatCount, nullptr);
     std::vector<VkSurfaceFormatKHR> availableSurfaceformats;
@@ -520,7 +938,7 @@ bool AppBaseVk::CreateSwapChain()
     VkResult result = vkCreateSwapchainKHR(m_DeviceHandle, &swapChainCreateInfo, nullptr, &m_SwapChainHandle);
     if(result != VK_SUCCESS)
     {
-        Log::Error("Failed to create swap chain");
+        LOG_ERROR("Failed to create swap chain");
         return false;
     }
     uint32_t imageCount;
@@ -531,9 +949,12 @@ bool AppBaseVk::CreateSwapChain()
     for(uint32_t i = 0; i < imageCount; ++i)
     {
         CreateImageView(m_BackBuffers[i], s_BackBufferFormat, VK_IMAGE_ASPECT_COLOR_BIT, m_BackBufferViews[i]);
+        m_StateTracker.TrackImage(m_BackBuffers[i], VK_IMAGE_ASPECT_COLOR_BIT, VK_IMAGE_LAYOUT_UNDEFINED);
     }
 
     vkAcquireNextImageKHR(m_DeviceHandle, m_SwapChainHandle, UINT64_MAX, m_ImageAvailableSemaphore, VK_NULL_HANDLE, &m_CurrentIndex);
+    // The submit waits for the acquire at the color output stage, the first barrier on the image has to start there
+    m_StateTracker.DiscardImage(m_BackBuffers[m_CurrentIndex], VK_PIPELINE_STAGE_2_COLOR_ATTACHMENT_OUTPUT_BIT);
     
     return true;
 }
@@ -546,12 +967,73 @@ void AppBaseVk::DestroySwapChain()
             vkDestroyImageView(m_DeviceHandle, view, nullptr);
     }
     m_BackBufferViews.clear();
+
+    for(size_t i = 0; i < m_OffscreenBackBufferMemories.size(); ++i)
+    {
+        m_StateTracker.ForgetImage(m_BackBuffers[i]);
+        if(m_BackBuffers[i] != VK_NULL_HANDLE)
+            vkDestroyImage(m_DeviceHandle, m_BackBuffers[i], nullptr);
+        if(m_OffscreenBackBufferMemories[i] != VK_NULL_HANDLE)
+            vkFreeMemory(m_DeviceHandle, m_OffscreenBackBufferMemories[i], nullptr);
+    }
+    m_OffscreenBackBufferMemories.clear();
     
     if(m_SwapChainHandle != VK_NULL_HANDLE)
     {
         vkDestroySwapchainKHR(m_DeviceHandle, m_SwapChainHandle, nullptr);
         m_SwapChainHandle = VK_NULL_HANDLE;
     }
+    m_BackBuffers.clear();
+}
+
+bool AppBaseVk::SaveScreenshot(const std::string& inPath)
+{
+    if(m_BackBuffers.empty())
+        return false;
+
+    const uint32_t width = m_Capabilities.currentExtent.width;
+    const uint32_t height = m_Capabilities.currentExtent.height;
+    const size_t byteSize = static_cast<size_t>(width) * height * 4;
+    VkBuffer readbackBuffer = VK_NULL_HANDLE;
+    VkDeviceMemory readbackMemory = VK_NULL_HANDLE;
+    if(!CreateBuffer(byteSize, VK_BUFFER_USAGE_TRANSFER_DST_BIT, VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT, readbackBuffer, readbackMemory))
+        return false;
+
+    const VkImage image = m_BackBuffers[m_PresentedIndex];
+    BeginCommandList();
+    m_StateTracker.TransitionImage(image, VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL, VK_PIPELINE_STAGE_2_TRANSFER_BIT, VK_ACCESS_2_TRANSFER_READ_BIT);
+    m_StateTracker.Flush(m_CmdBufferHandle);
+
+    VkBufferImageCopy region{};
+    region.imageSubresource = { VK_IMAGE_ASPECT_COLOR_BIT, 0, 0, 1 };
+    region.imageExtent = { width, height, 1 };
+    vkCmdCopyImageToBuffer(m_CmdBufferHandle, image, VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL, readbackBuffer, 1, &region);
+    // The readback buffer is short lived, keep it out of the state tracker
+    VkBufferMemoryBarrier hostReadBarrier{};
+    hostReadBarrier.sType = VK_STRUCTURE_TYPE_BUFFER_MEMORY_BARRIER;
+    hostReadBarrier.srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+    hostReadBarrier.dstAccessMask = VK_ACCESS_HOST_READ_BIT;
+    hostReadBarrier.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+    hostReadBarrier.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+    hostReadBarrier.buffer = readbackBuffer;
+    hostReadBarrier.size = VK_WHOLE_SIZE;
+    vkCmdPipelineBarrier(m_CmdBufferHandle, VK_PIPELINE_STAGE_TRANSFER_BIT, VK_PIPELINE_STAGE_HOST_BIT, 0, 0, nullptr, 1, &hostReadBarrier, 0, nullptr);
+    ExecuteCommandBuffer();
+
+    void* mappedData = nullptr;
+    bool saved = false;
+    if(vkMapMemory(m_DeviceHandle, readbackMemory, 0, byteSize, 0, &mappedData) == VK_SUCCESS)
+    {
+        // s_BackBufferFormat is R8G8B8A8, the bytes go to the file as they are
+        saved = AssetsManager::SaveImagePng(inPath, width, height, mappedData, width * 4);
+        vkUnmapMemory(m_DeviceHandle, readbackMemory);
+    }
+
+    vkDestroyBuffer(m_DeviceHandle, readbackBuffer, nullptr);
+    vkFreeMemory(m_DeviceHandle, readbackMemory, nullptr);
+    if(saved)
+        LOG_INFO("[Vulkan] Screenshot written to %s", inPath.c_str());
+    return saved;
 }
 
 bool AppBaseVk::CreateFence()
@@ -562,7 +1044,7 @@ bool AppBaseVk::CreateFence()
     
     if(vkCreateFence(m_DeviceHandle, &fenceInfo, nullptr, &m_FenceHandle) != VK_SUCCESS)
     {
-        Log::Error("Failed to create fence");
+        LOG_ERROR("Failed to create fence");
         return false;
     }
     
@@ -571,7 +1053,7 @@ bool AppBaseVk::CreateFence()
     semaphoreInfo.flags = 0;
     if(vkCreateSemaphore(m_DeviceHandle, &semaphoreInfo, nullptr, &m_ImageAvailableSemaphore) != VK_SUCCESS)
     {
-        Log::Error("Failed to create semaphore");
+        LOG_ERROR("Failed to create semaphore");
         return false;
     }
     
@@ -594,25 +1076,357 @@ void AppBaseVk::DestroyFence()
 }
 
 void AppBaseVk::ExecuteCommandBuffer(VkSemaphore inWaitSemaphore)
+{
+    SubmitCommandBuffer(inWaitSemaphore);
+    WaitForCommandBuffer();
+}
+
+void AppBaseVk::SubmitCommandBuffer(VkSemaphore inWaitSemaphore, uint64_t inWaitComputeValue)
 {
     EndCommandList();
     vkResetFences(m_DeviceHandle, 1, &m_FenceHandle);
 
-    VkPipelineStageFlags waitStages[] = { VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT };
+    VkSemaphore waitSemaphores[2];
+    VkPipelineStageFlags waitStages[2];
+    uint64_t waitValues[2];
+    uint32_t waitCount = 0;
+    // Nothing acquires images in headless mode, the image available semaphore is never signaled
+    if(IsHeadless() && inWaitSemaphore == m_ImageAvailableSemaphore)
+        inWaitSemaphore = VK_NULL_HANDLE;
+    if(inWaitSemaphore != VK_NULL_HANDLE)
+    {
+        waitSemaphores[waitCount] = inWaitSemaphore;
+        waitStages[waitCount] = VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT;
+        waitValues[waitCount] = 0; // binary semaphore, ignored
+        ++waitCount;
+    }
+    if(inWaitComputeValue > 0 && m_ComputeTimeline != VK_NULL_HANDLE)
+    {
+        waitSemaphores[waitCount] = m_ComputeTimeline;
+        waitStages[waitCount] = VK_PIPELINE_STAGE_DRAW_INDIRECT_BIT | VK_PIPELINE_STAGE_VERTEX_SHADER_BIT | VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT;
+        waitValues[waitCount] = inWaitComputeValue;
+        ++waitCount;
+    }
+
+    VkTimelineSemaphoreSubmitInfo timelineInfo{};
+    timelineInfo.sType = VK_STRUCTURE_TYPE_TIMELINE_SEMAPHORE_SUBMIT_INFO;
+    timelineInfo.waitSemaphoreValueCount = waitCount;
+    timelineInfo.pWaitSemaphoreValues = waitValues;
     
     VkSubmitInfo submitInfo{};
     submitInfo.sType = VK_STRUCTURE_TYPE_SUBMIT_INFO;
+    submitInfo.pNext = m_ComputeTimeline != VK_NULL_HANDLE ? &timelineInfo : nullptr;
     submitInfo.commandBufferCount = 1;
     submitInfo.pCommandBuffers = &m_CmdBufferHandle;
-    submitInfo.waitSemaphoreCount = inWaitSemaphore != VK_NULL_HANDLE ? 1 : 0;
-    submitInfo.pWaitSemaphores = &inWaitSemaphore;
-    submitInfo.pWaitDstStageMask = inWaitSemaphore != VK_NULL_HANDLE ? waitStages : nullptr;
+    submitInfo.waitSemaphoreCount = waitCount;
+    submitInfo.pWaitSemaphores = waitSemaphores;
+    submitInfo.pWaitDstStageMask = waitCount > 0 ? waitStages : nullptr;
     vkQueueSubmit(m_QueueHandle, 1, &submitInfo, m_FenceHandle);
+}
+
+void AppBaseVk::WaitForCommandBuffer()
+{
+    PROFILE_ZONE("WaitForGpu");
     vkWaitForFences(m_DeviceHandle, 1, &m_FenceHandle, VK_TRUE, UINT64_MAX);
 }
 
+void AppBaseVk::FindAsyncQueueFamilies(const std::vector<VkQueueFamilyProperties>& inQueueFamilies)
+{
+    m_ComputeQueueIndex = -1;
+    m_TransferQueueIndex = -1;
+    for(uint32_t i = 0; i < inQueueFamilies.size(); ++i)
+    {
+        const VkQueueFlags flags = inQueueFamilies[i].queueFlags;
+        if(m_ComputeQueueIndex < 0 && (flags & VK_QUEUE_COMPUTE_BIT) && !(flags & VK_QUEUE_GRAPHICS_BIT))
+            m_ComputeQueueIndex = static_cast<int>(i);
+        // Compute and graphics queues can copy too, a family that can do nothing else is usually a DMA engine
+        if(m_TransferQueueIndex < 0 && (flags & VK_QUEUE_TRANSFER_BIT) && !(flags & (VK_QUEUE_GRAPHICS_BIT | VK_QUEUE_COMPUTE_BIT)))
+            m_TransferQueueIndex = static_cast<int>(i);
+    }
+
+    LOG_INFO("[Vulkan] Queue families: graphics %d, async compute %d, transfer %d", m_QueueIndex, m_ComputeQueueIndex, m_TransferQueueIndex);
+}
+
+void AppBaseVk::GetQueueCreateInfos(std::vector<VkDeviceQueueCreateInfo>& outCreateInfos) const
+{
+    static const float s_QueuePriority = 1.0f;
+    outCreateInfos.clear();
+    for(int family : { m_QueueIndex, m_ComputeQueueIndex, m_TransferQueueIndex })
+    {
+        if(family < 0)
+            continue;
+        
+        bool exists = false;
+        for(const VkDeviceQueueCreateInfo& createInfo : outCreateInfos)
+            exists |= createInfo.queueFamilyIndex == static_cast<uint32_t>(family);
+        if(exists)
+            continue;
+
+        VkDeviceQueueCreateInfo queueCreateInfo{};
+        queueCreateInfo.sType = VK_STRUCTURE_TYPE_DEVICE_QUEUE_CREATE_INFO;
+        queueCreateInfo.queueFamilyIndex = static_cast<uint32_t>(family);
+        queueCreateInfo.queueCount = 1;
+        queueCreateInfo.pQueuePriorities = &s_QueuePriority;
+        outCreateInfos.push_back(queueCreateInfo);
+    }
+}
+
+void AppBaseVk::GetAsyncQueues()
+{
+    m_ComputeQueueHandle = m_QueueHandle;
+    m_TransferQueueHandle = m_QueueHandle;
+    if(m_ComputeQueueIndex >= 0)
+        vkGetDeviceQueue(m_DeviceHandle, m_ComputeQueueIndex, 0, &m_ComputeQueueHandle);
+    if(m_TransferQueueIndex >= 0)
+        vkGetDeviceQueue(m_DeviceHandle, m_TransferQueueIndex, 0, &m_TransferQueueHandle);
+}
+
+bool AppBaseVk::CreateAsyncCompute()
+{
+    m_AsyncComputeEnabled = false;
+    if(!m_TimelineSemaphoreSupported)
+    {
+        LOG_WARNING("[Vulkan] Timeline semaphores are not supported, compute work stays on the graphics queue");
+        return true;
+    }
+    if(m_ComputeQueueIndex < 0)
+    {
+        // A second submission to the graphics queue would only add a submit and a wait per frame, nothing overlaps
+        LOG_INFO("[Vulkan] No dedicated compute queue family, compute work stays on the graphics queue");
+        return true;
+    }
+
+    VkCommandPoolCreateInfo cmdPoolCreateInfo{};
+    cmdPoolCreateInfo.sType = VK_STRUCTURE_TYPE_COMMAND_POOL_CREATE_INFO;
+    cmdPoolCreateInfo.flags = VK_COMMAND_POOL_CREATE_RESET_COMMAND_BUFFER_BIT;
+    cmdPoolCreateInfo.queueFamilyIndex = m_ComputeQueueIndex;
+    if(vkCreateCommandPool(m_DeviceHandle, &cmdPoolCreateInfo, nullptr, &m_ComputeCmdPoolHandle) != VK_SUCCESS)
+    {
+        LOG_ERROR("[Vulkan] Failed to create the async compute command pool");
+        return false;
+    }
+
+    VkCommandBufferAllocateInfo cmdBufferAllocInfo{};
+    cmdBufferAllocInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_ALLOCATE_INFO;
+    cmdBufferAllocInfo.commandPool = m_ComputeCmdPoolHandle;
+    cmdBufferAllocInfo.level = VK_COMMAND_BUFFER_LEVEL_PRIMARY;
+    cmdBufferAllocInfo.commandBufferCount = s_AsyncComputeSlotCount;
+    if(vkAllocateCommandBuffers(m_DeviceHandle, &cmdBufferAllocInfo, m_ComputeCmdBuffers.data()) != VK_SUCCESS)
+    {
+        LOG_ERROR("[Vulkan] Failed to allocate the async compute command buffers");
+        return false;
+    }
+
+    VkSemaphoreTypeCreateInfo timelineCreateInfo{};
+    timelineCreateInfo.sType = VK_STRUCTURE_TYPE_SEMAPHORE_TYPE_CREATE_INFO;
+    timelineCreateInfo.semaphoreType = VK_SEMAPHORE_TYPE_TIMELINE;
+    timelineCreateInfo.initialValue = 0;
+    VkSemaphoreCreateInfo semaphoreInfo{};
+    semaphoreInfo.sType = VK_STRUCTURE_TYPE_SEMAPHORE_CREATE_INFO;
+    semaphoreInfo.pNext = &timelineCreateInfo;
+    if(vkCreateSemaphore(m_DeviceHandle, &semaphoreInfo, nullptr, &m_ComputeTimeline) != VK_SUCCESS)
+    {
+        LOG_ERROR("[Vulkan] Failed to create the compute timeline semaphore");
+        return false;
+    }
+
+    m_ComputeTimelineValue = 0;
+    m_AsyncComputeEnabled = true;
+    return true;
+}
+
+void AppBaseVk::DestroyAsyncCompute()
+{
+    if(m_ComputeTimeline != VK_NULL_HANDLE)
+    {
+        // Nothing may still wait on or signal the timeline
+        VkSemaphoreWaitInfo waitInfo{};
+        waitInfo.sType = VK_STRUCTURE_TYPE_SEMAPHORE_WAIT_INFO;
+        waitInfo.semaphoreCount = 1;
+        waitInfo.pSemaphores = &m_ComputeTimeline;
+        waitInfo.pValues = &m_ComputeTimelineValue;
+        vkWaitSemaphores(m_DeviceHandle, &waitInfo, UINT64_MAX);
+        vkDestroySemaphore(m_DeviceHandle, m_ComputeTimeline, nullptr);
+        m_ComputeTimeline = VK_NULL_HANDLE;
+    }
+
+    if(m_ComputeCmdPoolHandle != VK_NULL_HANDLE)
+    {
+        vkFreeCommandBuffers(m_DeviceHandle, m_ComputeCmdPoolHandle, s_AsyncComputeSlotCount, m_ComputeCmdBuffers.data());
+        vkDestroyCommandPool(m_DeviceHandle, m_ComputeCmdPoolHandle, nullptr);
+        m_ComputeCmdPoolHandle = VK_NULL_HANDLE;
+        m_ComputeCmdBuffers.fill(VK_NULL_HANDLE);
+    }
+    m_AsyncComputeEnabled = false;
+}
+
+VkCommandBuffer AppBaseVk::BeginComputeCommandList(uint32_t inSlot)
+{
+    // The caller guarantees the previous submission of this slot is complete, e.g. a later graphics submit waited on it
+    VkCommandBuffer cmdBuffer = m_ComputeCmdBuffers[inSlot % s_AsyncComputeSlotCount];
+    vkResetCommandBuffer(cmdBuffer, 0);
+    VkCommandBufferBeginInfo beginInfo{};
+    beginInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO;
+    beginInfo.flags = VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT;
+    vkBeginCommandBuffer(cmdBuffer, &beginInfo);
+    return cmdBuffer;
+}
+
+uint64_t AppBaseVk::SubmitComputeCommandList(uint32_t inSlot)
+{
+    VkCommandBuffer cmdBuffer = m_ComputeCmdBuffers[inSlot % s_AsyncComputeSlotCount];
+    vkEndCommandBuffer(cmdBuffer);
+
+    const uint64_t signalValue = ++m_ComputeTimelineValue;
+    VkTimelineSemaphoreSubmitInfo timelineInfo{};
+    timelineInfo.sType = VK_STRUCTURE_TYPE_TIMELINE_SEMAPHORE_SUBMIT_INFO;
+    timelineInfo.signalSemaphoreValueCount = 1;
+    timelineInfo.pSignalSemaphoreValues = &signalValue;
+
+    VkSubmitInfo submitInfo{};
+    submitInfo.sType = VK_STRUCTURE_TYPE_SUBMIT_INFO;
+    submitInfo.pNext = &timelineInfo;
+    submitInfo.commandBufferCount = 1;
+    submitInfo.pCommandBuffers = &cmdBuffer;
+    submitInfo.signalSemaphoreCount = 1;
+    submitInfo.pSignalSemaphores = &m_ComputeTimeline;
+    if(vkQueueSubmit(m_ComputeQueueHandle, 1, &submitInfo, VK_NULL_HANDLE) != VK_SUCCESS)
+    {
+        // Nothing will signal the value, do not let the graphics queue wait for it
+        LOG_ERROR("[Vulkan] Failed to submit the async compute command buffer");
+        --m_ComputeTimelineValue;
+        return 0;
+    }
+    return signalValue;
+}
+
+bool AppBaseVk::CreateGpuProfiler()
+{
+    uint32_t queueFamilyCount = 0;
+    vkGetPhysicalDeviceQueueFamilyProperties(m_GpuHandle, &queueFamilyCount, nullptr);
+    std::vector<VkQueueFamilyProperties> queueFamilies(queueFamilyCount);
+    vkGetPhysicalDeviceQueueFamilyProperties(m_GpuHandle, &queueFamilyCount, queueFamilies.data());
+    const uint32_t validBits = m_QueueIndex >= 0 ? queueFamilies[m_QueueIndex].timestampValidBits : 0;
+    if(validBits == 0 || m_GpuProperties.limits.timestampPeriod <= 0.0f)
+    {
+        LOG_WARNING("[Vulkan] The graphics queue has no timestamps, GPU scopes are not measured");
+        return true;
+    }
+    m_TimestampMask = validBits >= 64 ? UINT64_MAX : (1ull << validBits) - 1;
+
+    VkQueryPoolCreateInfo queryPoolInfo{};
+    queryPoolInfo.sType = VK_STRUCTURE_TYPE_QUERY_POOL_CREATE_INFO;
+    queryPoolInfo.queryType = VK_QUERY_TYPE_TIMESTAMP;
+    queryPoolInfo.queryCount = GpuProfiler::s_FrameLatency * GpuProfiler::s_QueriesPerFrame;
+    if(vkCreateQueryPool(m_DeviceHandle, &queryPoolInfo, nullptr, &m_TimestampQueryPool) != VK_SUCCESS)
+    {
+        LOG_ERROR("[Vulkan] Failed to create the timestamp query pool");
+        return false;
+    }
+
+    // Without VK_EXT_calibrated_timestamps the timestamp is only known to lie between the submit and the fence,
+    // the GPU track can be off by half of that in the trace. Durations are not affected.
+    BeginCommandList();
+    vkCmdResetQueryPool(m_CmdBufferHandle, m_TimestampQueryPool, 0, 1);
+    vkCmdWriteTimestamp(m_CmdBufferHandle, VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT, m_TimestampQueryPool, 0);
+    EndCommandList();
+    const uint64_t submitNs = GetTraceTimeNs();
+    ExecuteCommandBuffer();
+    const uint64_t completeNs = GetTraceTimeNs();
+
+    uint64_t calibrationTicks = 0;
+    if(vkGetQueryPoolResults(m_DeviceHandle, m_TimestampQueryPool, 0, 1, sizeof(uint64_t), &calibrationTicks, sizeof(uint64_t)
+        , VK_QUERY_RESULT_64_BIT | VK_QUERY_RESULT_WAIT_BIT) != VK_SUCCESS)
+    {
+        LOG_ERROR("[Vulkan] Failed to read the calibration timestamp");
+        return false;
+    }
+
+    // timestampPeriod is in nanoseconds per tick
+    m_GpuProfiler.Init(1e6 / static_cast<double>(m_GpuProperties.limits.timestampPeriod)
+        , calibrationTicks & m_TimestampMask
+        , submitNs + (completeNs - submitNs) / 2);
+    m_GpuProfiler.SetScopeHook([this](const std::string& inName, double inMilliseconds) { AddGpuSample(inName, inMilliseconds); });
+    return true;
+}
+
+void AppBaseVk::DestroyGpuProfiler()
+{
+    if(m_TimestampQueryPool != VK_NULL_HANDLE)
+    {
+        vkDestroyQueryPool(m_DeviceHandle, m_TimestampQueryPool, nullptr);
+        m_TimestampQueryPool = VK_NULL_HANDLE;
+    }
+    m_GpuProfiler = GpuProfiler();
+}
+
+void AppBaseVk::ReadBackGpuProfiler(uint32_t inSlot, bool inWait)
+{
+    std::array<uint64_t, GpuProfiler::s_QueriesPerFrame> ticks;
+    const uint32_t queryCount = m_GpuProfiler.GetSlotQueryCount(inSlot);
+    const VkQueryResultFlags flags = VK_QUERY_RESULT_64_BIT | (inWait ? VK_QUERY_RESULT_WAIT_BIT : 0);
+    const VkResult result = vkGetQueryPoolResults(m_DeviceHandle
+        , m_TimestampQueryPool
+        , GpuProfiler::GetSlotFirstQuery(inSlot)
+        , queryCount
+        , sizeof(uint64_t) * queryCount
+        , ticks.data()
+        , sizeof(uint64_t)
+        , flags);
+    if(result != VK_SUCCESS)
+    {
+        if(result != VK_NOT_READY)
+            LOG_WARNING("[Vulkan] Failed to read back the GPU timestamps");
+        m_GpuProfiler.DiscardSlot(inSlot);
+        return;
+    }
+
+    for(uint32_t i = 0; i < queryCount; ++i)
+        ticks[i] &= m_TimestampMask;
+    m_GpuProfiler.ResolveSlot(inSlot, ticks.data());
+}
+
+void AppBaseVk::CollectTraceEvents(std::vector<TraceEvent>& outEvents)
+{
+    if(m_TimestampQueryPool != VK_NULL_HANDLE)
+    {
+        // The last frames never had their slot come around again
+        for(uint32_t slot = 0; slot < GpuProfiler::s_FrameLatency; ++slot)
+        {
+            if(m_GpuProfiler.IsSlotPending(slot))
+                ReadBackGpuProfiler(slot, true);
+        }
+    }
+    m_GpuProfiler.AppendTraceEvents(outEvents);
+}
+
+void AppBaseVk::BeginGpuScope(const char* inName)
+{
+    const uint32_t query = m_GpuProfiler.BeginScope(inName);
+    if(query != GpuProfiler::s_InvalidQuery)
+        vkCmdWriteTimestamp(m_CmdBufferHandle, VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT, m_TimestampQueryPool, query);
+}
+
+void AppBaseVk::EndGpuScope()
+{
+    const uint32_t query = m_GpuProfiler.EndScope();
+    if(query != GpuProfiler::s_InvalidQuery)
+        vkCmdWriteTimestamp(m_CmdBufferHandle, VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT, m_TimestampQueryPool, query);
+}
+
 void AppBaseVk::Present()
 {
+    PROFILE_ZONE("Present");
+    m_PresentedIndex = m_CurrentIndex;
+    if(IsHeadless())
+    {
+        // The fence wait in ExecuteCommandBuffer already finished every use of the next image
+        m_StateTracker.EndFrame();
+        m_CurrentIndex = (m_CurrentIndex + 1) % static_cast<uint32_t>(m_BackBuffers.size());
+        m_StateTracker.DiscardImage(m_BackBuffers[m_CurrentIndex], VK_PIPELINE_STAGE_2_COLOR_ATTACHMENT_OUTPUT_BIT);
+        return;
+    }
+
     VkPresentInfoKHR presentInfo{};
     presentInfo.sType = VK_STRUCTURE_TYPE_PRESENT_INFO_KHR;
 
@@ -621,7 +1435,828 @@ void AppBaseVk::Present()
     presentInfo.pSwapchains = swapChains;
     presentInfo.pImageIndices = &m_CurrentIndex;
     vkQueuePresentKHR(m_QueueHandle, &presentInfo);
+    m_StateTracker.EndFrame();
 
     // move to next frame
     vkAcquireNextImageKHR(m_DeviceHandle, m_SwapChainHandle, UINT64_MAX, m_ImageAvailableSemaphore, VK_NULL_HANDLE, &m_CurrentIndex);
+    // The submit waits for the acquire at the color output stage, the first barrier on the image has to start there
+    m_StateTracker.DiscardImage(m_BackBuffers[m_CurrentIndex], VK_PIPELINE_STAGE_2_COLOR_ATTACHMENT_OUTPUT_BIT);
+}
+
+// Prefixed to the blob returned by vkGetPipelineCacheData, VkPipelineCacheHeaderVersionOne has no driver version
+struct PipelineCacheFileHeader
+{
+    static constexpr uint32_t s_Magic = 0x43504B56; // "VKPC"
+    
+    uint32_t Magic;
+    uint32_t DataSize;
+    uint32_t VendorID;
+    uint32_t DeviceID;
+    uint32_t DriverVersion;
+    uint8_t  PipelineCacheUUID[VK_UUID_SIZE];
+};
+
+static bool IsPipelineCacheCompatible(const PipelineCacheFileHeader& inHeader, const VkPhysicalDeviceProperties& inProperties)
+{
+    return inHeader.Magic == PipelineCacheFileHeader::s_Magic
+        && inHeader.VendorID == inProperties.vendorID
+        && inHeader.DeviceID == inProperties.deviceID
+        && inHeader.DriverVersion == inProperties.driverVersion
+        && memcmp(inHeader.PipelineCacheUUID, inProperties.pipelineCacheUUID, VK_UUID_SIZE) == 0;
+}
+
+bool AppBaseVk::CreatePipelineCache(const char* inCacheName)
+{
+    m_PipelineCachePath = AssetsManager::GetShaderPath() / (std::string(inCacheName) + ".vkcache");
+    m_PipelineCacheIsWarm = false;
+
+    std::vector<uint8_t> initialData;
+    std::ifstream file(m_PipelineCachePath, std::ios::binary);
+    if(file.is_open())
+    {
+        PipelineCacheFileHeader header{};
+        file.read(reinterpret_cast<char*>(&header), sizeof(header));
+        if(file.good() && IsPipelineCacheCompatible(header, m_GpuProperties))
+        {
+            initialData.resize(header.DataSize);
+            file.read(reinterpret_cast<char*>(initialData.data()), header.DataSize);
+            if(!file.good())
+            {
+                LOG_WARNING("[Vulkan] Pipeline cache %s is truncated, ignore it", m_PipelineCachePath.string().c_str());
+                initialData.clear();
+            }
+        }
+        else
+        {
+            LOG_WARNING("[Vulkan] Pipeline cache %s was created by another device or driver, ignore it", m_PipelineCachePath.string().c_str());
+        }
+    }
+
+    // The driver validates its own header as well, but a stale blob from another driver would only be discarded silently
+    if(initialData.size() >= sizeof(VkPipelineCacheHeaderVersionOne))
+    {
+        VkPipelineCacheHeaderVersionOne driverHeader;
+        memcpy(&driverHeader, initialData.data(), sizeof(driverHeader));
+        if(driverHeader.headerVersion != VK_PIPELINE_CACHE_HEADER_VERSION_ONE
+            || driverHeader.vendorID != m_GpuProperties.vendorID
+            || driverHeader.deviceID != m_GpuProperties.deviceID
+            || memcmp(driverHeader.pipelineCacheUUID, m_GpuProperties.pipelineCacheUUID, VK_UUID_SIZE) != 0)
+        {
+            initialData.clear();
+        }
+    }
+    else
+    {
+        initialData.clear();
+    }
+
+    VkPipelineCacheCreateInfo cacheInfo{};
+    cacheInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_CACHE_CREATE_INFO;
+    cacheInfo.initialDataSize = initialData.size();
+    cacheInfo.pInitialData = initialData.empty() ? nullptr : initialData.data();
+
+    VkResult result = vkCreatePipelineCache(m_DeviceHandle, &cacheInfo, nullptr, &m_PipelineCacheHandle);
+    if(result != VK_SUCCESS && !initialData.empty())
+    {
+        LOG_WARNING("[Vulkan] Failed to create pipeline cache from %s, start with an empty cache", m_PipelineCachePath.string().c_str());
+        cacheInfo.initialDataSize = 0;
+        cacheInfo.pInitialData = nullptr;
+        initialData.clear();
+        result = vkCreatePipelineCache(m_DeviceHandle, &cacheInfo, nullptr, &m_PipelineCacheHandle);
+    }
+
+    if(result != VK_SUCCESS)
+    {
+        LOG_ERROR("Failed to create pipeline cache");
+        return false;
+    }
+
+    m_PipelineCacheIsWarm = !initialData.empty();
+    LOG_INFO("[Vulkan] Pipeline cache: %s start, %zu bytes loaded from %s"
+        , m_PipelineCacheIsWarm ? "warm" : "cold"
+        , initialData.size()
+        , m_PipelineCachePath.string().c_str());
+    return true;
+}
+
+void AppBaseVk::DestroyPipelineCache()
+{
+    if(m_PipelineCacheHandle == VK_NULL_HANDLE)
+        return;
+
+    size_t dataSize = 0;
+    VkResult result = vkGetPipelineCacheData(m_DeviceHandle, m_PipelineCacheHandle, &dataSize, nullptr);
+    if(result == VK_SUCCESS && dataSize > 0)
+    {
+        std::vector<uint8_t> data(dataSize);
+        result = vkGetPipelineCacheData(m_DeviceHandle, m_PipelineCacheHandle, &dataSize, data.data());
+        if(result == VK_SUCCESS)
+        {
+            PipelineCacheFileHeader header{};
+            header.Magic = PipelineCacheFileHeader::s_Magic;
+            header.DataSize = static_cast<uint32_t>(dataSize);
+            header.VendorID = m_GpuProperties.vendorID;
+            header.DeviceID = m_GpuProperties.deviceID;
+            header.DriverVersion = m_GpuProperties.driverVersion;
+            memcpy(header.PipelineCacheUUID, m_GpuProperties.pipelineCacheUUID, VK_UUID_SIZE);
+
+            // Write to a temporary file first so an interrupted save never leaves a corrupted cache behind
+            std::filesystem::path tempPath = m_PipelineCachePath;
+            tempPath += ".tmp";
+            std::ofstream file(tempPath, std::ios::binary | std::ios::trunc);
+            if(file.is_open())
+            {
+                file.write(reinterpret_cast<const char*>(&header), sizeof(header));
+                file.write(reinterpret_cast<const char*>(data.data()), static_cast<std::streamsize>(dataSize));
+                file.close();
+                std::error_code ec;
+                std::filesystem::rename(tempPath, m_PipelineCachePath, ec);
+                if(ec)
+                    LOG_WARNING("[Vulkan] Failed to save pipeline cache to %s", m_PipelineCachePath.string().c_str());
+            }
+            else
+            {
+                LOG_WARNING("[Vulkan] Failed to open %s for writing", tempPath.string().c_str());
+            }
+        }
+    }
+
+    vkDestroyPipelineCache(m_DeviceHandle, m_PipelineCacheHandle, nullptr);
+    m_PipelineCacheHandle = VK_NULL_HANDLE;
+}
+
+bool AppBaseVk::CreatePipelinesParallel(const std::vector<std::function<bool()>>& inTasks)
+{
+    const auto startTime = std::chrono::high_resolution_clock::now();
+    
+    // The calling thread runs the last task, a single pipeline is created without spawning a thread
+    std::vector<std::future<bool>> futures;
+    futures.reserve(inTasks.size());
+    for(size_t i = 0; i + 1 < inTasks.size(); ++i)
+    {
+        futures.push_back(std::async(std::launch::async, inTasks[i]));
+    }
+
+    bool succeeded = inTasks.empty() || inTasks.back()();
+    for(auto& future : futures)
+    {
+        succeeded = future.get() && succeeded;
+    }
+
+    const auto endTime = std::chrono::high_resolution_clock::now();
+    const float milliseconds = std::chrono::duration<float, std::chrono::milliseconds::period>(endTime - startTime).count();
+    // Log::Info rather than LOG_INFO, startup times are compared in Release builds
+    Log::Info("[Vulkan] Created %zu pipeline(s) in %.3f ms (%s pipeline cache)"
+        , inTasks.size()
+        , milliseconds
+        , m_PipelineCacheIsWarm ? "warm" : "cold");
+    
+    return succeeded;
+}
+
+void ResourceStateTracker::TrackImage(VkImage inImage, VkImageAspectFlags inAspect, VkImageLayout inLayout, uint32_t inMipCount, uint32_t inLayerCount)
+{
+    ImageState& state = m_Images[inImage];
+    state.Aspect = inAspect;
+    state.LayerCount = inLayerCount;
+    state.Mips.assign(inMipCount, AccessState{inLayout, VK_PIPELINE_STAGE_2_NONE, VK_ACCESS_2_NONE, VK_PIPELINE_STAGE_2_NONE, VK_ACCESS_2_NONE});
+}
+
+void ResourceStateTracker::ForgetImage(VkImage inImage)
+{
+    m_Images.erase(inImage);
+}
+
+void ResourceStateTracker::DiscardImage(VkImage inImage, VkPipelineStageFlags2 inWaitStage)
+{
+    auto iter = m_Images.find(inImage);
+    if(iter == m_Images.end())
+        return;
+    for(AccessState& state : iter->second.Mips)
+    {
+        state = AccessState{VK_IMAGE_LAYOUT_UNDEFINED, inWaitStage, VK_ACCESS_2_NONE, VK_PIPELINE_STAGE_2_NONE, VK_ACCESS_2_NONE};
+    }
+}
+
+void ResourceStateTracker::DiscardBuffer(VkBuffer inBuffer, VkPipelineStageFlags2 inWaitStage)
+{
+    m_Buffers[inBuffer] = AccessState{VK_IMAGE_LAYOUT_UNDEFINED, inWaitStage, VK_ACCESS_2_NONE, VK_PIPELINE_STAGE_2_NONE, VK_ACCESS_2_NONE};
+}
+
+void ResourceStateTracker::SetImageState(VkImage inImage, VkImageLayout inLayout, VkPipelineStageFlags2 inStage, VkAccessFlags2 inAccess)
+{
+    auto iter = m_Images.find(inImage);
+    if(iter == m_Images.end())
+        return;
+    for(AccessState& state : iter->second.Mips)
+    {
+        state = AccessState{inLayout, inStage, inAccess, VK_PIPELINE_STAGE_2_NONE, VK_ACCESS_2_NONE};
+    }
+}
+
+bool ResourceStateTracker::IsVisible(const AccessState& inState, VkPipelineStageFlags2 inStage, VkAccessFlags2 inAccess)
+{
+    // Nothing accessed the resource since it was tracked, there is no write to wait for
+    if(inState.Stage == VK_PIPELINE_STAGE_2_NONE)
+        return true;
+    return (inStage & ~inState.VisibleStage) == 0 && (inAccess & ~inState.VisibleAccess) == 0;
+}
+
+bool ResourceStateTracker::IsWriteAccess(VkAccessFlags2 inAccess)
+{
+    constexpr VkAccessFlags2 writeAccess = VK_ACCESS_2_SHADER_WRITE_BIT
+        | VK_ACCESS_2_COLOR_ATTACHMENT_WRITE_BIT
+        | VK_ACCESS_2_DEPTH_STENCIL_ATTACHMENT_WRITE_BIT
+        | VK_ACCESS_2_TRANSFER_WRITE_BIT
+        | VK_ACCESS_2_HOST_WRITE_BIT
+        | VK_ACCESS_2_MEMORY_WRITE_BIT
+        | VK_ACCESS_2_SHADER_STORAGE_WRITE_BIT
+        | VK_ACCESS_2_ACCELERATION_STRUCTURE_WRITE_BIT_KHR;
+    return (inAccess & writeAccess) != 0;
+}
+
+void ResourceStateTracker::TransitionImage(VkImage inImage
+    , VkImageLayout inLayout
+    , VkPipelineStageFlags2 inStage
+    , VkAccessFlags2 inAccess
+    , bool inDiscard
+    , uint32_t inBaseMip
+    , uint32_t inMipCount)
+{
+    auto iter = m_Images.find(inImage);
+    if(iter == m_Images.end())
+    {
+        LOG_WARNING("[Vulkan] Transition of an untracked image, call TrackImage first");
+        return;
+    }
+
+    ImageState& image = iter->second;
+    const uint32_t mipEnd = inMipCount == VK_REMAINING_MIP_LEVELS
+        ? static_cast<uint32_t>(image.Mips.size())
+        : std::min(inBaseMip + inMipCount, static_cast<uint32_t>(image.Mips.size()));
+    
+    for(uint32_t mip = inBaseMip; mip < mipEnd; ++mip)
+    {
+        ++m_Stats.Requested;
+        AccessState& state = image.Mips[mip];
+        
+        // Read after read in the same layout, remember every reader so a later write waits on all of them
+        const bool isReadAfterRead = state.Layout == inLayout && !inDiscard && !IsWriteAccess(state.Access) && !IsWriteAccess(inAccess);
+        if(isReadAfterRead && IsVisible(state, inStage, inAccess))
+        {
+            state.Stage |= inStage;
+            state.Access |= inAccess;
+            state.VisibleStage |= inStage;
+            state.VisibleAccess |= inAccess;
+            ++m_Stats.Elided;
+            continue;
+        }
+
+        const VkImageLayout oldLayout = inDiscard ? VK_IMAGE_LAYOUT_UNDEFINED : state.Layout;
+        // Only writes have to be made available, a write after read hazard needs the execution dependency alone. A
+        // reader in a new stage chains after the barrier that made the last write visible to the earlier readers.
+        const VkPipelineStageFlags2 srcStage = isReadAfterRead && state.VisibleStage != VK_PIPELINE_STAGE_2_NONE ? state.VisibleStage : state.Stage;
+        const VkAccessFlags2 srcAccess = IsWriteAccess(state.Access) ? state.Access : VK_ACCESS_2_NONE;
+
+        // Grow a pending barrier of the previous mip with identical parameters instead of adding a new one
+        bool merged = false;
+        for(VkImageMemoryBarrier2& pending : m_PendingImageBarriers)
+        {
+            if(pending.image == inImage
+                && pending.oldLayout == oldLayout
+                && pending.newLayout == inLayout
+                && pending.srcStageMask == srcStage
+                && pending.srcAccessMask == srcAccess
+                && pending.dstStageMask == inStage
+                && pending.dstAccessMask == inAccess
+                && pending.subresourceRange.baseMipLevel + pending.subresourceRange.levelCount == mip)
+            {
+                ++pending.subresourceRange.levelCount;
+                ++m_Stats.Merged;
+                merged = true;
+                break;
+            }
+        }
+
+        if(!merged)
+        {
+            VkImageMemoryBarrier2 barrier{};
+            barrier.sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER_2;
+            barrier.srcStageMask = srcStage;
+            barrier.srcAccessMask = srcAccess;
+            barrier.dstStageMask = inStage;
+            barrier.dstAccessMask = inAccess;
+            barrier.oldLayout = oldLayout;
+            barrier.newLayout = inLayout;
+            barrier.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+            barrier.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+            barrier.image = inImage;
+            barrier.subresourceRange.aspectMask = image.Aspect;
+            barrier.subresourceRange.baseMipLevel = mip;
+            barrier.subresourceRange.levelCount = 1;
+            barrier.subresourceRange.baseArrayLayer = 0;
+            barrier.subresourceRange.layerCount = image.LayerCount;
+            m_PendingImageBarriers.push_back(barrier);
+        }
+
+        if(isReadAfterRead)
+        {
+            state.Stage |= inStage;
+            state.Access |= inAccess;
+            state.VisibleStage |= inStage;
+            state.VisibleAccess |= inAccess;
+            continue;
+        }
+
+        state.Layout = inLayout;
+        state.Stage = inStage;
+        state.Access = inAccess;
+        state.VisibleStage = inStage;
+        state.VisibleAccess = inAccess;
+    }
+}
+
+void ResourceStateTracker::BufferAccess(VkBuffer inBuffer, VkPipelineStageFlags2 inStage, VkAccessFlags2 inAccess)
+{
+    ++m_Stats.Requested;
+    AccessState& state = m_Buffers[inBuffer];
+    
+    // Untouched buffers and reads the last write is already visible to need no barrier
+    const bool isReadAfterRead = !IsWriteAccess(state.Access) && !IsWriteAccess(inAccess);
+    if(state.Stage == VK_PIPELINE_STAGE_2_NONE || (isReadAfterRead && IsVisible(state, inStage, inAccess)))
+    {
+        state.Stage |= inStage;
+        state.Access |= inAccess;
+        state.VisibleStage |= inStage;
+        state.VisibleAccess |= inAccess;
+        ++m_Stats.Elided;
+        return;
+    }
+
+    for(VkBufferMemoryBarrier2& pending : m_PendingBufferBarriers)
+    {
+        if(pending.buffer == inBuffer)
+        {
+            // Several consumers in the same pass, widen the destination scope of the pending barrier
+            pending.dstStageMask |= inStage;
+            pending.dstAccessMask |= inAccess;
+            state.Stage |= inStage;
+            state.Access |= inAccess;
+            state.VisibleStage |= inStage;
+            state.VisibleAccess |= inAccess;
+            ++m_Stats.Merged;
+            return;
+        }
+    }
+
+    // Write after read only needs an execution dependency. A reader in a new stage chains after the barrier that made
+    // the last write visible to the earlier readers.
+    VkBufferMemoryBarrier2 barrier{};
+    barrier.sType = VK_STRUCTURE_TYPE_BUFFER_MEMORY_BARRIER_2;
+    barrier.srcStageMask = isReadAfterRead && state.VisibleStage != VK_PIPELINE_STAGE_2_NONE ? state.VisibleStage : state.Stage;
+    barrier.srcAccessMask = IsWriteAccess(state.Access) ? state.Access : VK_ACCESS_2_NONE;
+    barrier.dstStageMask = inStage;
+    barrier.dstAccessMask = inAccess;
+    barrier.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+    barrier.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+    barrier.buffer = inBuffer;
+    barrier.offset = 0;
+    barrier.size = VK_WHOLE_SIZE;
+    m_PendingBufferBarriers.push_back(barrier);
+
+    if(isReadAfterRead)
+    {
+        state.Stage |= inStage;
+        state.Access |= inAccess;
+        state.VisibleStage |= inStage;
+        state.VisibleAccess |= inAccess;
+        return;
+    }
+    state.Stage = inStage;
+    state.Access = inAccess;
+    state.VisibleStage = inStage;
+    state.VisibleAccess = inAccess;
+}
+
+void ResourceStateTracker::Flush(VkCommandBuffer inCmdBuffer)
+{
+    if(m_PendingImageBarriers.empty() && m_PendingBufferBarriers.empty())
+        return;
+
+    if(m_Synchronization2)
+    {
+        VkDependencyInfo dependencyInfo{};
+        dependencyInfo.sType = VK_STRUCTURE_TYPE_DEPENDENCY_INFO;
+        dependencyInfo.imageMemoryBarrierCount = static_cast<uint32_t>(m_PendingImageBarriers.size());
+        dependencyInfo.pImageMemoryBarriers = m_PendingImageBarriers.data();
+        dependencyInfo.bufferMemoryBarrierCount = static_cast<uint32_t>(m_PendingBufferBarriers.size());
+        dependencyInfo.pBufferMemoryBarriers = m_PendingBufferBarriers.data();
+        vkCmdPipelineBarrier2(inCmdBuffer, &dependencyInfo);
+    }
+    else
+    {
+        // Legacy path, the stage and access bits below 32 match VkPipelineStageFlags / VkAccessFlags
+        VkPipelineStageFlags srcStage = 0;
+        VkPipelineStageFlags dstStage = 0;
+        std::vector<VkImageMemoryBarrier> imageBarriers(m_PendingImageBarriers.size());
+        for(size_t i = 0; i < m_PendingImageBarriers.size(); ++i)
+        {
+            const VkImageMemoryBarrier2& src = m_PendingImageBarriers[i];
+            VkImageMemoryBarrier& dst = imageBarriers[i];
+            dst = {};
+            dst.sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER;
+            dst.srcAccessMask = static_cast<VkAccessFlags>(src.srcAccessMask);
+            dst.dstAccessMask = static_cast<VkAccessFlags>(src.dstAccessMask);
+            dst.oldLayout = src.oldLayout;
+            dst.newLayout = src.newLayout;
+            dst.srcQueueFamilyIndex = src.srcQueueFamilyIndex;
+            dst.dstQueueFamilyIndex = src.dstQueueFamilyIndex;
+            dst.image = src.image;
+            dst.subresourceRange = src.subresourceRange;
+            srcStage |= static_cast<VkPipelineStageFlags>(src.srcStageMask);
+            dstStage |= static_cast<VkPipelineStageFlags>(src.dstStageMask);
+        }
+
+        std::vector<VkBufferMemoryBarrier> bufferBarriers(m_PendingBufferBarriers.size());
+        for(size_t i = 0; i < m_PendingBufferBarriers.size(); ++i)
+        {
+            const VkBufferMemoryBarrier2& src = m_PendingBufferBarriers[i];
+            VkBufferMemoryBarrier& dst = bufferBarriers[i];
+            dst = {};
+            dst.sType = VK_STRUCTURE_TYPE_BUFFER_MEMORY_BARRIER;
+            dst.srcAccessMask = static_cast<VkAccessFlags>(src.srcAccessMask);
+            dst.dstAccessMask = static_cast<VkAccessFlags>(src.dstAccessMask);
+            dst.srcQueueFamilyIndex = src.srcQueueFamilyIndex;
+            dst.dstQueueFamilyIndex = src.dstQueueFamilyIndex;
+            dst.buffer = src.buffer;
+            dst.offset = src.offset;
+            dst.size = src.size;
+            srcStage |= static_cast<VkPipelineStageFlags>(src.srcStageMask);
+            dstStage |= static_cast<VkPipelineStageFlags>(src.dstStageMask);
+        }
+
+        vkCmdPipelineBarrier(inCmdBuffer
+            , srcStage != 0 ? srcStage : VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT
+            , dstStage != 0 ? dstStage : VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT
+            , 0
+            , 0
+            , nullptr
+            , static_cast<uint32_t>(bufferBarriers.size())
+            , bufferBarriers.data()
+            , static_cast<uint32_t>(imageBarriers.size())
+            , imageBarriers.data());
+    }
+
+    m_Stats.Emitted += static_cast<uint32_t>(m_PendingImageBarriers.size() + m_PendingBufferBarriers.size());
+    ++m_Stats.Batches;
+    m_PendingImageBarriers.clear();
+    m_PendingBufferBarriers.clear();
+}
+
+void ResourceStateTracker::EndFrame()
+{
+    PROFILE_COUNTER("Barriers emitted", m_Stats.Emitted);
+    if(m_StatsHook)
+        m_StatsHook(m_Stats);
+    m_Stats = {};
+}
+
+static VkPipelineStageFlags2 GetRenderGraphShaderStage(ERenderGraphPassType inPassType)
+{
+    switch (inPassType)
+    {
+    case ERenderGraphPassType::Compute:     return VK_PIPELINE_STAGE_2_COMPUTE_SHADER_BIT;
+    case ERenderGraphPassType::RayTracing:  return VK_PIPELINE_STAGE_2_RAY_TRACING_SHADER_BIT_KHR;
+    case ERenderGraphPassType::Copy:        return VK_PIPELINE_STAGE_2_TRANSFER_BIT;
+    default:                                return VK_PIPELINE_STAGE_2_VERTEX_SHADER_BIT | VK_PIPELINE_STAGE_2_FRAGMENT_SHADER_BIT;
+    }
+}
+
+static void GetRenderGraphAccessVk(ERenderGraphAccess inAccess
+    , ERenderGraphPassType inPassType
+    , VkImageLayout& outLayout
+    , VkPipelineStageFlags2& outStage
+    , VkAccessFlags2& outAccess)
+{
+    switch (inAccess)
+    {
+    case ERenderGraphAccess::ShaderRead:
+        outLayout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL;
+        outStage = GetRenderGraphShaderStage(inPassType);
+        outAccess = VK_ACCESS_2_SHADER_READ_BIT;
+        break;
+    case ERenderGraphAccess::UnorderedAccess:
+        outLayout = VK_IMAGE_LAYOUT_GENERAL;
+        outStage = GetRenderGraphShaderStage(inPassType);
+        outAccess = VK_ACCESS_2_SHADER_READ_BIT | VK_ACCESS_2_SHADER_WRITE_BIT;
+        break;
+    case ERenderGraphAccess::RenderTarget:
+        outLayout = VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL;
+        outStage = VK_PIPELINE_STAGE_2_COLOR_ATTACHMENT_OUTPUT_BIT;
+        outAccess = VK_ACCESS_2_COLOR_ATTACHMENT_READ_BIT | VK_ACCESS_2_COLOR_ATTACHMENT_WRITE_BIT;
+        break;
+    case ERenderGraphAccess::DepthWrite:
+        outLayout = VK_IMAGE_LAYOUT_DEPTH_STENCIL_ATTACHMENT_OPTIMAL;
+        outStage = VK_PIPELINE_STAGE_2_EARLY_FRAGMENT_TESTS_BIT | VK_PIPELINE_STAGE_2_LATE_FRAGMENT_TESTS_BIT;
+        outAccess = VK_ACCESS_2_DEPTH_STENCIL_ATTACHMENT_READ_BIT | VK_ACCESS_2_DEPTH_STENCIL_ATTACHMENT_WRITE_BIT;
+        break;
+    case ERenderGraphAccess::DepthRead:
+        outLayout = VK_IMAGE_LAYOUT_DEPTH_STENCIL_READ_ONLY_OPTIMAL;
+        outStage = VK_PIPELINE_STAGE_2_EARLY_FRAGMENT_TESTS_BIT | VK_PIPELINE_STAGE_2_LATE_FRAGMENT_TESTS_BIT | GetRenderGraphShaderStage(inPassType);
+        outAccess = VK_ACCESS_2_DEPTH_STENCIL_ATTACHMENT_READ_BIT | VK_ACCESS_2_SHADER_READ_BIT;
+        break;
+    case ERenderGraphAccess::CopySrc:
+        outLayout = VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL;
+        outStage = VK_PIPELINE_STAGE_2_TRANSFER_BIT;
+        outAccess = VK_ACCESS_2_TRANSFER_READ_BIT;
+        break;
+    case ERenderGraphAccess::CopyDst:
+        outLayout = VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL;
+        outStage = VK_PIPELINE_STAGE_2_TRANSFER_BIT;
+        outAccess = VK_ACCESS_2_TRANSFER_WRITE_BIT;
+        break;
+    case ERenderGraphAccess::IndirectArgument:
+        outLayout = VK_IMAGE_LAYOUT_UNDEFINED;
+        outStage = VK_PIPELINE_STAGE_2_DRAW_INDIRECT_BIT;
+        outAccess = VK_ACCESS_2_INDIRECT_COMMAND_READ_BIT;
+        break;
+    case ERenderGraphAccess::Present:
+        outLayout = VK_IMAGE_LAYOUT_PRESENT_SRC_KHR;
+        outStage = VK_PIPELINE_STAGE_2_NONE;
+        outAccess = VK_ACCESS_2_NONE;
+        break;
+    default:
+        outLayout = VK_IMAGE_LAYOUT_UNDEFINED;
+        outStage = VK_PIPELINE_STAGE_2_NONE;
+        outAccess = VK_ACCESS_2_NONE;
+        break;
+    }
+}
+
+static bool HasRenderGraphAccess(uint32_t inAccessMask, ERenderGraphAccess inAccess)
+{
+    return (inAccessMask & (1u << static_cast<uint32_t>(inAccess))) != 0;
+}
+
+static VkImageAspectFlags GetFormatAspect(VkFormat inFormat)
+{
+    switch (inFormat)
+    {
+    case VK_FORMAT_D16_UNORM:
+    case VK_FORMAT_D32_SFLOAT:
+    case VK_FORMAT_X8_D24_UNORM_PACK32:
+        return VK_IMAGE_ASPECT_DEPTH_BIT;
+    case VK_FORMAT_D16_UNORM_S8_UINT:
+    case VK_FORMAT_D24_UNORM_S8_UINT:
+    case VK_FORMAT_D32_SFLOAT_S8_UINT:
+        return VK_IMAGE_ASPECT_DEPTH_BIT | VK_IMAGE_ASPECT_STENCIL_BIT;
+    default:
+        return VK_IMAGE_ASPECT_COLOR_BIT;
+    }
+}
+
+bool AppBaseVk::CompileRenderGraph(RenderGraph& inGraph)
+{
+    DestroyRenderGraphResources();
+    m_RenderGraphResources.resize(inGraph.GetResourceCount());
+
+    // Images and buffers may share the allocation, keep them bufferImageGranularity apart
+    const VkDeviceSize granularity = m_GpuProperties.limits.bufferImageGranularity;
+    uint32_t memoryTypeBits = UINT32_MAX;
+    auto queryMemory = [this, &inGraph, granularity, &memoryTypeBits](RenderGraphHandle inHandle, const RenderGraphResourceDesc& inDesc, uint64_t& outSize, uint64_t& outAlignment)
+    {
+        const uint32_t accessMask = inGraph.GetResource(inHandle).AccessMask;
+        RenderGraphResourceVk& resource = m_RenderGraphResources[inHandle];
+        resource.Transient = true;
+        VkMemoryRequirements requirements;
+
+        if(inDesc.Type == ERenderGraphResourceType::Texture)
+        {
+            const VkFormat format = static_cast<VkFormat>(inDesc.Format);
+            resource.Aspect = GetFormatAspect(format);
+
+            VkImageUsageFlags usage = 0;
+            if(HasRenderGraphAccess(accessMask, ERenderGraphAccess::ShaderRead) || HasRenderGraphAccess(accessMask, ERenderGraphAccess::DepthRead))
+                usage |= VK_IMAGE_USAGE_SAMPLED_BIT;
+            if(HasRenderGraphAccess(accessMask, ERenderGraphAccess::UnorderedAccess))
+                usage |= VK_IMAGE_USAGE_STORAGE_BIT;
+            if(HasRenderGraphAccess(accessMask, ERenderGraphAccess::RenderTarget))
+                usage |= VK_IMAGE_USAGE_COLOR_ATTACHMENT_BIT;
+            if(HasRenderGraphAccess(accessMask, ERenderGraphAccess::DepthWrite) || HasRenderGraphAccess(accessMask, ERenderGraphAccess::DepthRead))
+                usage |= VK_IMAGE_USAGE_DEPTH_STENCIL_ATTACHMENT_BIT;
+            if(HasRenderGraphAccess(accessMask, ERenderGraphAccess::CopySrc))
+                usage |= VK_IMAGE_USAGE_TRANSFER_SRC_BIT;
+            if(HasRenderGraphAccess(accessMask, ERenderGraphAccess::CopyDst))
+                usage |= VK_IMAGE_USAGE_TRANSFER_DST_BIT;
+
+            VkImageCreateInfo imageInfo{};
+            imageInfo.sType = VK_STRUCTURE_TYPE_IMAGE_CREATE_INFO;
+            imageInfo.imageType = VK_IMAGE_TYPE_2D;
+            imageInfo.extent.width = inDesc.Width;
+            imageInfo.extent.height = inDesc.Height;
+            imageInfo.extent.depth = 1;
+            imageInfo.mipLevels = inDesc.MipLevels;
+            imageInfo.arrayLayers = 1;
+            imageInfo.format = format;
+            imageInfo.tiling = VK_IMAGE_TILING_OPTIMAL;
+            imageInfo.initialLayout = VK_IMAGE_LAYOUT_UNDEFINED;
+            imageInfo.usage = usage;
+            imageInfo.samples = VK_SAMPLE_COUNT_1_BIT;
+            imageInfo.sharingMode = VK_SHARING_MODE_EXCLUSIVE;
+            if(vkCreateImage(m_DeviceHandle, &imageInfo, nullptr, &resource.Image) != VK_SUCCESS)
+            {
+                LOG_ERROR("[Vulkan] Failed to create render graph image %s", inGraph.GetResource(inHandle).Name.c_str());
+                return false;
+            }
+            vkGetImageMemoryRequirements(m_DeviceHandle, resource.Image, &requirements);
+        }
+        else
+        {
+            VkBufferUsageFlags usage = 0;
+            if(HasRenderGraphAccess(accessMask, ERenderGraphAccess::ShaderRead) || HasRenderGraphAccess(accessMask, ERenderGraphAccess::UnorderedAccess))
+                usage |= VK_BUFFER_USAGE_STORAGE_BUFFER_BIT;
+            if(HasRenderGraphAccess(accessMask, ERenderGraphAccess::IndirectArgument))
+                usage |= VK_BUFFER_USAGE_INDIRECT_BUFFER_BIT;
+            if(HasRenderGraphAccess(accessMask, ERenderGraphAccess::CopySrc))
+                usage |= VK_BUFFER_USAGE_TRANSFER_SRC_BIT;
+            if(HasRenderGraphAccess(accessMask, ERenderGraphAccess::CopyDst))
+                usage |= VK_BUFFER_USAGE_TRANSFER_DST_BIT;
+
+            VkBufferCreateInfo bufferInfo{};
+            bufferInfo.sType = VK_STRUCTURE_TYPE_BUFFER_CREATE_INFO;
+            bufferInfo.size = inDesc.Width;
+            bufferInfo.usage = usage;
+            bufferInfo.sharingMode = VK_SHARING_MODE_EXCLUSIVE;
+            if(vkCreateBuffer(m_DeviceHandle, &bufferInfo, nullptr, &resource.Buffer) != VK_SUCCESS)
+            {
+                LOG_ERROR("[Vulkan] Failed to create render graph buffer %s", inGraph.GetResource(inHandle).Name.c_str());
+                return false;
+            }
+            vkGetBufferMemoryRequirements(m_DeviceHandle, resource.Buffer, &requirements);
+        }
+
+        memoryTypeBits &= requirements.memoryTypeBits;
+        outSize = requirements.size;
+        outAlignment = std::max(requirements.alignment, granularity);
+        return true;
+    };
+
+    if(!inGraph.Compile(queryMemory))
+    {
+        LOG_ERROR("[Vulkan] Failed to compile the render graph");
+        return false;
+    }
+
+    const uint64_t allocationSize = inGraph.GetAliasedAllocationSize();
+    if(allocationSize > 0)
+    {
+        const int memoryType = FindMemoryType(memoryTypeBits, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT);
+        if(memoryType < 0)
+        {
+            LOG_ERROR("[Vulkan] No memory type fits every transient resource of the render graph");
+            return false;
+        }
+
+        VkMemoryAllocateInfo allocInfo{};
+        allocInfo.sType = VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_INFO;
+        allocInfo.allocationSize = allocationSize;
+        allocInfo.memoryTypeIndex = static_cast<uint32_t>(memoryType);
+        if(vkAllocateMemory(m_DeviceHandle, &allocInfo, nullptr, &m_RenderGraphMemory) != VK_SUCCESS)
+        {
+            LOG_ERROR("[Vulkan] Failed to allocate the render graph memory");
+            return false;
+        }
+    }
+
+    for(RenderGraphHandle handle = 0; handle < inGraph.GetResourceCount(); ++handle)
+    {
+        const RenderGraph::ResourceNode& node = inGraph.GetResource(handle);
+        RenderGraphResourceVk& resource = m_RenderGraphResources[handle];
+        if(!resource.Transient)
+            continue;
+
+        if(resource.Image != VK_NULL_HANDLE)
+        {
+            const VkFormat format = static_cast<VkFormat>(node.Desc.Format);
+            if(vkBindImageMemory(m_DeviceHandle, resource.Image, m_RenderGraphMemory, node.Offset) != VK_SUCCESS
+                || !CreateImageView(resource.Image, format, resource.Aspect, resource.View))
+            {
+                LOG_ERROR("[Vulkan] Failed to place render graph image %s", node.Name.c_str());
+                return false;
+            }
+            m_StateTracker.TrackImage(resource.Image, resource.Aspect, VK_IMAGE_LAYOUT_UNDEFINED, node.Desc.MipLevels);
+        }
+        else if(vkBindBufferMemory(m_DeviceHandle, resource.Buffer, m_RenderGraphMemory, node.Offset) != VK_SUCCESS)
+        {
+            LOG_ERROR("[Vulkan] Failed to place render graph buffer %s", node.Name.c_str());
+            return false;
+        }
+    }
+
+    inGraph.LogReport();
+    return true;
+}
+
+void AppBaseVk::DestroyRenderGraphResources()
+{
+    for(RenderGraphResourceVk& resource : m_RenderGraphResources)
+    {
+        if(!resource.Transient)
+            continue;
+        if(resource.View != VK_NULL_HANDLE)
+            vkDestroyImageView(m_DeviceHandle, resource.View, nullptr);
+        if(resource.Image != VK_NULL_HANDLE)
+        {
+            m_StateTracker.ForgetImage(resource.Image);
+            vkDestroyImage(m_DeviceHandle, resource.Image, nullptr);
+        }
+        if(resource.Buffer != VK_NULL_HANDLE)
+            vkDestroyBuffer(m_DeviceHandle, resource.Buffer, nullptr);
+    }
+    m_RenderGraphResources.clear();
+
+    if(m_RenderGraphMemory != VK_NULL_HANDLE)
+    {
+        vkFreeMemory(m_DeviceHandle, m_RenderGraphMemory, nullptr);
+        m_RenderGraphMemory = VK_NULL_HANDLE;
+    }
+}
+
+void AppBaseVk::BindRenderGraphImage(RenderGraphHandle inResource, VkImage inImage, VkImageAspectFlags inAspect)
+{
+    if(inResource >= m_RenderGraphResources.size() || m_RenderGraphResources[inResource].Transient)
+    {
+        LOG_ERROR("[Vulkan] Only imported render graph resources can be bound, compile the graph first");
+        return;
+    }
+    m_RenderGraphResources[inResource].Image = inImage;
+    m_RenderGraphResources[inResource].Aspect = inAspect;
+}
+
+void AppBaseVk::BindRenderGraphBuffer(RenderGraphHandle inResource, VkBuffer inBuffer)
+{
+    if(inResource >= m_RenderGraphResources.size() || m_RenderGraphResources[inResource].Transient)
+    {
+        LOG_ERROR("[Vulkan] Only imported render graph resources can be bound, compile the graph first");
+        return;
+    }
+    m_RenderGraphResources[inResource].Buffer = inBuffer;
+}
+
+VkImage AppBaseVk::GetRenderGraphImage(RenderGraphHandle inResource) const
+{
+    return inResource < m_RenderGraphResources.size() ? m_RenderGraphResources[inResource].Image : VK_NULL_HANDLE;
+}
+
+VkImageView AppBaseVk::GetRenderGraphImageView(RenderGraphHandle inResource) const
+{
+    return inResource < m_RenderGraphResources.size() ? m_RenderGraphResources[inResource].View : VK_NULL_HANDLE;
+}
+
+VkBuffer AppBaseVk::GetRenderGraphBuffer(RenderGraphHandle inResource) const
+{
+    return inResource < m_RenderGraphResources.size() ? m_RenderGraphResources[inResource].Buffer : VK_NULL_HANDLE;
+}
+
+void AppBaseVk::ExecuteRenderGraph(const RenderGraph& inGraph)
+{
+    PROFILE_ZONE("RecordRenderGraph");
+    inGraph.Execute([this, &inGraph](const std::vector<RenderGraphTransition>& inTransitions)
+    {
+        for(const RenderGraphTransition& transition : inTransitions)
+        {
+            const RenderGraphResourceVk& resource = m_RenderGraphResources[transition.Resource];
+            VkImageLayout layout;
+            VkPipelineStageFlags2 stage;
+            VkAccessFlags2 access;
+            GetRenderGraphAccessVk(transition.After, transition.PassType, layout, stage, access);
+
+            // Memory taken over from another transient, wait until the last pass using it is done
+            if(transition.Discard && resource.Transient)
+            {
+                VkPipelineStageFlags2 waitStage = VK_PIPELINE_STAGE_2_NONE;
+                for(RenderGraphHandle predecessor : inGraph.GetResource(transition.Resource).AliasPredecessors)
+                {
+                    const RenderGraph::ResourceNode& node = inGraph.GetResource(predecessor);
+                    VkImageLayout predecessorLayout;
+                    VkPipelineStageFlags2 predecessorStage;
+                    VkAccessFlags2 predecessorAccess;
+                    GetRenderGraphAccessVk(node.LastAccess, node.LastPassType, predecessorLayout, predecessorStage, predecessorAccess);
+                    waitStage |= predecessorStage;
+                }
+                if(resource.Image != VK_NULL_HANDLE)
+                    m_StateTracker.DiscardImage(resource.Image, waitStage);
+                else
+                    m_StateTracker.DiscardBuffer(resource.Buffer, waitStage);
+            }
+
+            if(resource.Image != VK_NULL_HANDLE)
+                m_StateTracker.TransitionImage(resource.Image, layout, stage, access, transition.Discard);
+            else if(resource.Buffer != VK_NULL_HANDLE)
+                m_StateTracker.BufferAccess(resource.Buffer, stage, access);
+            else
+                LOG_WARNING("[Vulkan] Render graph resource %s is not bound", inGraph.GetResource(transition.Resource).Name.c_str());
+        }
+        m_StateTracker.Flush(m_CmdBufferHandle);
+    });
 }
\ No newline at end of file
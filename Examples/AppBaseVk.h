@@ -3,8 +3,16 @@
 #include "Win32Base.h"
 #include "Log.h"
 #include "AssetsManager.h"
+#include "BarrierStats.h"
+#include "RenderGraph.h"
+#include "GpuProfiler.h"
+#ifdef _WIN32
 #define VK_USE_PLATFORM_WIN32_KHR
+#endif
 #include <vulkan/vulkan.h>
+#include <functional>
+#include <unordered_map>
+#include <array>
 
 class StagingBuffer
 {
@@ -36,6 +44,120 @@ private:
     VkDeviceMemory  m_Memory;
 };
 
+// Hands out descriptor sets from a list of pools, a new pool is created whenever the current one runs out.
+// Reset() recycles every pool at once, so it suits sets that live for a single frame.
+class DescriptorAllocator
+{
+public:
+    static constexpr uint32_t s_SetsPerPool = 128;
+
+    void Init(VkDevice inDevice, VkDescriptorPoolCreateFlags inFlags = 0);
+    void Destroy();
+    void Reset();
+    bool Allocate(VkDescriptorSetLayout inLayout, VkDescriptorSet& outSet, uint32_t inVariableDescriptorCount = 0);
+    uint32_t GetPoolCount() const { return static_cast<uint32_t>(m_UsedPools.size() + m_FreePools.size()); }
+
+private:
+    VkDescriptorPool GrabPool();
+
+    VkDevice                        m_Device {VK_NULL_HANDLE};
+    VkDescriptorPoolCreateFlags     m_Flags {0};
+    VkDescriptorPool                m_CurrentPool {VK_NULL_HANDLE};
+    std::vector<VkDescriptorPool>   m_UsedPools;
+    std::vector<VkDescriptorPool>   m_FreePools;
+};
+
+// Deduplicates descriptor set layouts by their bindings, the cache owns every layout it returns
+class DescriptorSetLayoutCache
+{
+public:
+    void Init(VkDevice inDevice);
+    void Destroy();
+    VkDescriptorSetLayout GetLayout(const std::vector<VkDescriptorSetLayoutBinding>& inBindings
+        , const std::vector<VkDescriptorBindingFlags>& inBindingFlags = {}
+        , VkDescriptorSetLayoutCreateFlags inFlags = 0);
+
+private:
+    struct LayoutKey
+    {
+        std::vector<VkDescriptorSetLayoutBinding>   Bindings;
+        std::vector<VkDescriptorBindingFlags>       BindingFlags;
+        VkDescriptorSetLayoutCreateFlags            Flags;
+        bool operator==(const LayoutKey& inOther) const;
+    };
+
+    struct LayoutKeyHash
+    {
+        size_t operator()(const LayoutKey& inKey) const;
+    };
+
+    VkDevice                                                            m_Device {VK_NULL_HANDLE};
+    std::unordered_map<LayoutKey, VkDescriptorSetLayout, LayoutKeyHash> m_Layouts;
+};
+
+// Remembers the last layout, stage and access of every tracked image mip and buffer, turns declared accesses into
+// the minimal set of barriers and records them as one batch per Flush(). Accesses declared between two Flush()
+// calls are assumed to belong to the same pass. Uses vkCmdPipelineBarrier2 when synchronization2 is enabled,
+// otherwise only the legacy (32 bit) stage and access bits may be passed in.
+class ResourceStateTracker
+{
+public:
+    void SetSynchronization2(bool inEnabled) { m_Synchronization2 = inEnabled; }
+    void SetStatsHook(BarrierStatsHook inHook) { m_StatsHook = std::move(inHook); }
+    const BarrierStats& GetStats() const { return m_Stats; }
+
+    void TrackImage(VkImage inImage, VkImageAspectFlags inAspect, VkImageLayout inLayout, uint32_t inMipCount = 1, uint32_t inLayerCount = 1);
+    void ForgetImage(VkImage inImage);
+    // inDiscard transitions from VK_IMAGE_LAYOUT_UNDEFINED, the previous contents are not needed
+    void TransitionImage(VkImage inImage
+        , VkImageLayout inLayout
+        , VkPipelineStageFlags2 inStage
+        , VkAccessFlags2 inAccess
+        , bool inDiscard = false
+        , uint32_t inBaseMip = 0
+        , uint32_t inMipCount = VK_REMAINING_MIP_LEVELS);
+    void BufferAccess(VkBuffer inBuffer, VkPipelineStageFlags2 inStage, VkAccessFlags2 inAccess);
+    // Contents are dropped and the next barrier waits for inWaitStage, used for acquired swap chain images
+    // and for resources taking over aliased memory
+    void DiscardImage(VkImage inImage, VkPipelineStageFlags2 inWaitStage);
+    void DiscardBuffer(VkBuffer inBuffer, VkPipelineStageFlags2 inWaitStage);
+    // Records an access made outside the tracker, e.g. the final layout transition of a render pass
+    void SetImageState(VkImage inImage, VkImageLayout inLayout, VkPipelineStageFlags2 inStage, VkAccessFlags2 inAccess);
+    void Flush(VkCommandBuffer inCmdBuffer);
+    // Reports the stats of the frame to the hook and starts counting again
+    void EndFrame();
+
+private:
+    struct AccessState
+    {
+        VkImageLayout           Layout {VK_IMAGE_LAYOUT_UNDEFINED};
+        VkPipelineStageFlags2   Stage {VK_PIPELINE_STAGE_2_NONE};           // a later write waits on these
+        VkAccessFlags2          Access {VK_ACCESS_2_NONE};
+        VkPipelineStageFlags2   VisibleStage {VK_PIPELINE_STAGE_2_NONE};    // already synchronized with the last write
+        VkAccessFlags2          VisibleAccess {VK_ACCESS_2_NONE};
+    };
+
+    // A read can skip its barrier when the last write is already visible to its stages and accesses
+    static bool IsVisible(const AccessState& inState, VkPipelineStageFlags2 inStage, VkAccessFlags2 inAccess);
+
+    struct ImageState
+    {
+        VkImageAspectFlags          Aspect;
+        uint32_t                    LayerCount;
+        std::vector<AccessState>    Mips;
+    };
+
+    static bool IsWriteAccess(VkAccessFlags2 inAccess);
+
+    bool                                        m_Synchronization2 = false;
+    std::unordered_map<VkImage, ImageState>     m_Images;
+    std::unordered_map<VkBuffer, AccessState>   m_Buffers;
+    std::vector<VkImageMemoryBarrier2>          m_PendingImageBarriers;
+    std::vector<VkBufferMemoryBarrier2>         m_PendingBufferBarriers;
+    BarrierStats                                m_Stats;
+    BarrierStatsHook                            m_StatsHook;
+};
+
 enum class ERegisterType : uint8_t
 {
     ConstantBuffer, // b
@@ -57,16 +179,19 @@ public:
     using Win32Base::Win32Base;
 
     static constexpr VkFormat s_BackBufferFormat = VK_FORMAT_R8G8B8A8_UNORM;
+    static constexpr uint32_t s_AsyncComputeSlotCount = 2; // compute for the next frame records into one slot while the current frame uses the other
     static constexpr uint32_t s_BackBufferCount = 3; // greater than VkSurfaceCapabilitiesKHR::minImageCount, less than or equal to VkSurfaceCapabilitiesKHR::maxImageCount
 
     void BeginCommandList();
     void EndCommandList();
     int  FindMemoryType(uint32_t typeFilter, VkMemoryPropertyFlags properties) const;
+    // inShareWithAsyncQueues creates the buffer concurrent between the graphics, compute and transfer queue families
     bool CreateBuffer(size_t inSize
             , VkBufferUsageFlags inUsage
             , VkMemoryPropertyFlags inProperties
             , VkBuffer& outBuffer
-            , VkDeviceMemory& outBufferMemory);
+            , VkDeviceMemory& outBufferMemory
+            , bool inShareWithAsyncQueues = false);
     bool CreateTexture(size_t inWidth
             , size_t inHeight
             , VkFormat inFormat
@@ -91,6 +216,30 @@ public:
         , VkAccessFlagBits inSrcAccessMask
         , VkAccessFlagBits inDstAccessMask
         , VkImageAspectFlags inAspectMask);
+
+    VkDescriptorSetLayout GetDescriptorSetLayout(const std::vector<VkDescriptorSetLayoutBinding>& inBindings
+        , const std::vector<VkDescriptorBindingFlags>& inBindingFlags = {}
+        , VkDescriptorSetLayoutCreateFlags inFlags = 0);
+    bool AllocatePersistentDescriptorSet(VkDescriptorSetLayout inLayout, VkDescriptorSet& outSet, uint32_t inVariableDescriptorCount = 0);
+    // Only valid until the next BeginCommandList, which recycles every set allocated this way
+    bool AllocateFrameDescriptorSet(VkDescriptorSetLayout inLayout, VkDescriptorSet& outSet, uint32_t inVariableDescriptorCount = 0);
+    // Returns the index to use with _MainTex[] in space1, or UINT32_MAX when the bindless table is full
+    uint32_t RegisterBindlessTexture(VkImageView inImageView);
+
+    // Runs the pipeline creation tasks on worker threads and the calling one, VkPipelineCache is internally synchronized
+    bool CreatePipelinesParallel(const std::vector<std::function<bool()>>& inTasks);
+
+    // Imported render graph resources have to be bound before ExecuteRenderGraph, e.g. the current back buffer
+    void BindRenderGraphImage(RenderGraphHandle inResource, VkImage inImage, VkImageAspectFlags inAspect = VK_IMAGE_ASPECT_COLOR_BIT);
+    void BindRenderGraphBuffer(RenderGraphHandle inResource, VkBuffer inBuffer);
+    VkImage GetRenderGraphImage(RenderGraphHandle inResource) const;
+    VkImageView GetRenderGraphImageView(RenderGraphHandle inResource) const;
+    VkBuffer GetRenderGraphBuffer(RenderGraphHandle inResource) const;
+
+    // Timestamps around the commands recorded in between on m_CmdBufferHandle, scopes nest. Does nothing until
+    // CreateGpuProfiler succeeded, the results arrive GpuProfiler::s_FrameLatency command lists later.
+    void BeginGpuScope(const char* inName);
+    void EndGpuScope();
     
 protected:
     virtual bool CreateDevice() = 0;
@@ -102,32 +251,109 @@ protected:
     void DestroyCommandList();
     bool CreateDescriptorSetPool();
     void DestroyDescriptorSetPool();
+    // Adds the surface extensions the instance needs to present, none in headless mode
+    void AddSurfaceExtensions(std::vector<const char*>& inOutExtensions) const;
+    bool CreateSurface();
+    bool IsPresentSupported(uint32_t inQueueFamily) const;
+    // Creates offscreen images in place of the swap chain images in headless mode, m_BackBuffers is filled either way
     bool CreateSwapChain();
     void DestroySwapChain();
+    bool SaveScreenshot(const std::string& inPath) override;
+    bool CreateBindlessDescriptorSet(uint32_t inMaxTextures);
+    void DestroyBindlessDescriptorSet();
+    bool CreatePipelineCache(const char* inCacheName);
+    void DestroyPipelineCache();
     void ExecuteCommandBuffer(VkSemaphore inWaitSemaphore = VK_NULL_HANDLE);
+    // ExecuteCommandBuffer in two halves, work submitted in between overlaps with this command buffer.
+    // A non-zero inWaitComputeValue makes the indirect and compute stages wait for that async compute submission.
+    void SubmitCommandBuffer(VkSemaphore inWaitSemaphore = VK_NULL_HANDLE, uint64_t inWaitComputeValue = 0);
+    void WaitForCommandBuffer();
     void Present();
+
+    // Picks queue families without graphics for async compute and for copies, call before creating the device
+    void FindAsyncQueueFamilies(const std::vector<VkQueueFamilyProperties>& inQueueFamilies);
+    void GetQueueCreateInfos(std::vector<VkDeviceQueueCreateInfo>& outCreateInfos) const;
+    // Falls back to the graphics queue for any family FindAsyncQueueFamilies did not find
+    void GetAsyncQueues();
+    // Needs timeline semaphores and a dedicated compute queue family, without them IsAsyncComputeEnabled() stays false and compute work belongs in the graphics command buffer
+    bool CreateAsyncCompute();
+    void DestroyAsyncCompute();
+    bool IsAsyncComputeEnabled() const { return m_AsyncComputeEnabled; }
+    VkCommandBuffer BeginComputeCommandList(uint32_t inSlot);
+    // Returns the value the compute timeline reaches once the command buffer has executed
+    uint64_t SubmitComputeCommandList(uint32_t inSlot);
+    // Compiles the graph and places its transient resources in one aliased allocation
+    bool CompileRenderGraph(RenderGraph& inGraph);
+    void DestroyRenderGraphResources();
+    // Records the passes of a compiled graph, the access changes between them go through m_StateTracker
+    void ExecuteRenderGraph(const RenderGraph& inGraph);
+    // Every BeginCommandList starts a profiler frame, call after CreateFence and CreateCommandList. Succeeds without
+    // profiling when the graphics queue has no timestamps.
+    bool CreateGpuProfiler();
+    void DestroyGpuProfiler();
+    // inWait blocks until the results are available, otherwise a frame that is not ready yet is dropped
+    void ReadBackGpuProfiler(uint32_t inSlot, bool inWait);
+    void CollectTraceEvents(std::vector<TraceEvent>& outEvents) override;
     
     VkInstance                  m_InstanceHandle;
     VkDebugUtilsMessengerEXT    m_DebugMessenger;
-    VkPhysicalDevice            m_GpuHandle;
+    VkPhysicalDevice            m_GpuHandle {VK_NULL_HANDLE};
     VkPhysicalDeviceProperties  m_GpuProperties;
     VkPhysicalDeviceFeatures    m_GpuFeatures;
     VkPhysicalDeviceMemoryProperties m_GpuMemoryProperties;
-    VkSurfaceKHR                m_SurfaceHandle;
+    VkSurfaceKHR                m_SurfaceHandle {VK_NULL_HANDLE};
     VkDevice                    m_DeviceHandle;
     int                         m_QueueIndex {-1};
     VkQueue                     m_QueueHandle;
+    int                         m_ComputeQueueIndex {-1}; // -1 when the device has no compute family without graphics
+    int                         m_TransferQueueIndex {-1};
+    VkQueue                     m_ComputeQueueHandle {VK_NULL_HANDLE};
+    VkQueue                     m_TransferQueueHandle {VK_NULL_HANDLE};
+    bool                        m_TimelineSemaphoreSupported = false; // set by CreateDevice when the feature is enabled
+    bool                        m_AsyncComputeEnabled = false;
+    VkCommandPool               m_ComputeCmdPoolHandle {VK_NULL_HANDLE};
+    std::array<VkCommandBuffer, s_AsyncComputeSlotCount> m_ComputeCmdBuffers {};
+    VkSemaphore                 m_ComputeTimeline {VK_NULL_HANDLE};
+    uint64_t                    m_ComputeTimelineValue {0};
     VkCommandPool               m_CmdPoolHandle;
     VkCommandBuffer             m_CmdBufferHandle;
     bool                        m_CmdBufferIsClosed = true;
     VkDescriptorPool            m_DescriptorPoolHandle;
+    DescriptorSetLayoutCache    m_DescriptorLayoutCache;
+    DescriptorAllocator         m_PersistentDescriptorAllocator;
+    DescriptorAllocator         m_FrameDescriptorAllocator;
+    VkDescriptorPool            m_BindlessPoolHandle {VK_NULL_HANDLE};
+    VkDescriptorSetLayout       m_BindlessLayout {VK_NULL_HANDLE}; // owned by m_DescriptorLayoutCache
+    VkDescriptorSet             m_BindlessSet {VK_NULL_HANDLE};
+    uint32_t                    m_BindlessCapacity {0};
+    uint32_t                    m_BindlessTextureCount {0};
     VkFence                     m_FenceHandle;
     VkSemaphore                 m_ImageAvailableSemaphore;
+    ResourceStateTracker        m_StateTracker;
+    GpuProfiler                 m_GpuProfiler;
+    VkQueryPool                 m_TimestampQueryPool {VK_NULL_HANDLE}; // GpuProfiler::s_QueriesPerFrame per frame slot
+    uint64_t                    m_TimestampMask {UINT64_MAX}; // timestampValidBits of the graphics queue family
+
+    struct RenderGraphResourceVk
+    {
+        VkImage             Image {VK_NULL_HANDLE};
+        VkImageView         View {VK_NULL_HANDLE};
+        VkBuffer            Buffer {VK_NULL_HANDLE};
+        VkImageAspectFlags  Aspect {VK_IMAGE_ASPECT_COLOR_BIT};
+        bool                Transient = false;
+    };
+    std::vector<RenderGraphResourceVk> m_RenderGraphResources; // indexed by RenderGraphHandle
+    VkDeviceMemory              m_RenderGraphMemory {VK_NULL_HANDLE};
+    VkPipelineCache             m_PipelineCacheHandle {VK_NULL_HANDLE};
+    std::filesystem::path       m_PipelineCachePath;
+    bool                        m_PipelineCacheIsWarm = false;
 
     VkSurfaceCapabilitiesKHR    m_Capabilities{};
-    VkSwapchainKHR              m_SwapChainHandle;
+    VkSwapchainKHR              m_SwapChainHandle {VK_NULL_HANDLE};
     std::vector<VkImage>        m_BackBuffers;
     std::vector<VkImageView>    m_BackBufferViews;
+    std::vector<VkDeviceMemory> m_OffscreenBackBufferMemories; // headless only, the swap chain owns its images
     uint32_t                    m_CurrentIndex{0};
+    uint32_t                    m_PresentedIndex{0};
 };
 
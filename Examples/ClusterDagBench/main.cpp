@@ -0,0 +1,405 @@
+#include "AssetsManager.h"
+#include "Benchmark.h"
+#include "Camera.h"
+#include "ClusterDag.h"
+#include "Log.h"
+#include "MeshSimplifier.h"
+#include <glm/gtc/constants.hpp>
+#include <algorithm>
+#include <chrono>
+#include <cstdlib>
+#include <cstring>
+#include <iterator>
+#include <random>
+#include <string>
+
+// Builds the cluster DAG of a bumpy procedural sphere, or of a model of Assets/Models, without a device, times the
+// build, the baked file round trip, the cut selection and the normal cone culling, then checks the DAG: cluster
+// limits, parent bounds and errors that contain their children, cuts from several distances and directions that are
+// within their error of the full mesh and closed when it is, and cones that only reject triangles facing away.
+// Last it emulates the culling of the mesh pipeline examples over their grid of instances, down to the triangle tests
+// of the mesh shader, and reports how many triangles each of them removes.
+//
+//   ClusterDagBench [--mesh model] [--iterations N] [--report path.json|path.csv] [--baseline path.json] [--tolerance percent]
+
+static constexpr uint32_t s_Rings = 128;
+static constexpr uint32_t s_Segments = 256;
+// 60 degrees vertical field of view on a 1080 pixel high target, one pixel of error
+static constexpr float s_ErrorScale = 1.7320508f * 1080.0f * 0.5f;
+
+// The scene of the mesh pipeline examples: a 1280x720 target with a one pixel cut error, 8x8x8 instances spread over
+// [-20, 20) with random rotations
+static constexpr uint32_t s_GridSize = 8;
+static constexpr float s_GridExtent = 20.0f;
+static constexpr float s_ViewportWidth = 1280.0f;
+static constexpr float s_ViewportHeight = 720.0f;
+
+enum class PrimitiveTest
+{
+    Crossing,           // crosses the camera plane, always kept
+    BackFacing,
+    ZeroArea,
+    BetweenSamples,
+    Visible,
+};
+
+static double MillisecondsSince(std::chrono::steady_clock::time_point inStart)
+{
+    return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - inStart).count();
+}
+
+// Closed latitude longitude sphere of radius 1 plus bumps, a single vertex per position so a cut with a crack shows up
+// as an edge used once
+static void BuildSphere(std::vector<glm::vec3>& outPositions, std::vector<uint32_t>& outIndices)
+{
+    outPositions.push_back(glm::vec3(0.0f, 1.0f, 0.0f));
+    for(uint32_t ring = 1; ring < s_Rings; ++ring)
+    {
+        const float theta = glm::pi<float>() * ring / s_Rings;
+        for(uint32_t segment = 0; segment < s_Segments; ++segment)
+        {
+            const float phi = glm::two_pi<float>() * segment / s_Segments;
+            const float radius = 1.0f + 0.05f * std::sin(theta * 12.0f) * std::sin(phi * 12.0f);
+            outPositions.push_back(radius * glm::vec3(std::sin(theta) * std::cos(phi), std::cos(theta), std::sin(theta) * std::sin(phi)));
+        }
+    }
+    outPositions.push_back(glm::vec3(0.0f, -1.0f, 0.0f));
+
+    const uint32_t bottom = static_cast<uint32_t>(outPositions.size()) - 1;
+    auto vertex = [](uint32_t inRing, uint32_t inSegment) { return 1 + (inRing - 1) * s_Segments + inSegment % s_Segments; };
+    for(uint32_t segment = 0; segment < s_Segments; ++segment)
+    {
+        outIndices.insert(outIndices.end(), {0u, vertex(1, segment + 1), vertex(1, segment)});
+        outIndices.insert(outIndices.end(), {bottom, vertex(s_Rings - 1, segment), vertex(s_Rings - 1, segment + 1)});
+        for(uint32_t ring = 1; ring + 1 < s_Rings; ++ring)
+        {
+            outIndices.insert(outIndices.end(), {vertex(ring, segment), vertex(ring, segment + 1), vertex(ring + 1, segment + 1)});
+            outIndices.insert(outIndices.end(), {vertex(ring, segment), vertex(ring + 1, segment + 1), vertex(ring + 1, segment)});
+        }
+    }
+}
+
+static bool ValidateDag(const ClusterDag& inDag)
+{
+    const std::vector<ClusterDag::ClusterLod>& lods = inDag.GetLods();
+    for(uint32_t c = 0; c < inDag.GetClusterCount(); ++c)
+    {
+        const ClusterDag::Cluster& cluster = inDag.GetClusters()[c];
+        if(cluster.VertCount > ClusterDag::s_MaxVertices || cluster.PrimCount > ClusterDag::s_MaxPrimitives || cluster.PrimCount == 0)
+        {
+            LOG_ERROR("[ClusterDag] Cluster %u has %u vertices and %u primitives", c, cluster.VertCount, cluster.PrimCount);
+            return false;
+        }
+        const glm::vec4& lod = lods[c].LodSphere;
+        const glm::vec4& parent = lods[c].ParentSphere;
+        if(lods[c].LodError > lods[c].ParentError || glm::length(glm::vec3(lod) - glm::vec3(parent)) + lod.w > parent.w * 1.0001f + 1e-5f)
+        {
+            LOG_ERROR("[ClusterDag] Cluster %u is not contained by its parent group", c);
+            return false;
+        }
+    }
+    return true;
+}
+
+// Every edge of a closed cut is shared by exactly two of its triangles
+static bool IsClosed(const std::vector<uint32_t>& inIndices)
+{
+    std::vector<uint64_t> edges;
+    for(size_t t = 0; t < inIndices.size(); t += 3)
+    {
+        for(uint32_t k = 0; k < 3; ++k)
+        {
+            const uint32_t a = inIndices[t + k], b = inIndices[t + (k + 1) % 3];
+            edges.push_back(static_cast<uint64_t>(std::min(a, b)) << 32 | std::max(a, b));
+        }
+    }
+    std::sort(edges.begin(), edges.end());
+    for(size_t first = 0, last = 0; first < edges.size(); first = last)
+    {
+        while(last < edges.size() && edges[last] == edges[first])
+            ++last;
+        if(last - first != 2)
+            return false;
+    }
+    return true;
+}
+
+// Every triangle of a back facing cluster has the camera behind its plane, the culling of the rasterizer
+static bool IsBackFacing(const std::vector<glm::vec3>& inPositions, const std::vector<uint32_t>& inIndices, size_t inFirst
+    , const glm::vec3& inCameraPosition)
+{
+    for(size_t t = inFirst; t < inIndices.size(); t += 3)
+    {
+        const glm::vec3& a = inPositions[inIndices[t]];
+        const glm::vec3 normal = glm::cross(inPositions[inIndices[t + 1]] - a, inPositions[inIndices[t + 2]] - a);
+        if(glm::dot(normal, a - inCameraPosition) < 0.0f)
+            return false;
+    }
+    return true;
+}
+
+// Same tests as IsPrimitiveCulled of MeshPipelinePass.hlsl, split by the one that removes the triangle
+static PrimitiveTest TestPrimitive(const glm::vec4& inClipA, const glm::vec4& inClipB, const glm::vec4& inClipC)
+{
+    if(inClipA.w <= 0.0f || inClipB.w <= 0.0f || inClipC.w <= 0.0f)
+        return PrimitiveTest::Crossing;
+    const glm::vec2 viewportSize(s_ViewportWidth, s_ViewportHeight);
+    const glm::vec2 a = (glm::vec2(inClipA) / inClipA.w * 0.5f + 0.5f) * viewportSize;
+    const glm::vec2 b = (glm::vec2(inClipB) / inClipB.w * 0.5f + 0.5f) * viewportSize;
+    const glm::vec2 c = (glm::vec2(inClipC) / inClipC.w * 0.5f + 0.5f) * viewportSize;
+
+    const float area = (b.x - a.x) * (c.y - a.y) - (b.y - a.y) * (c.x - a.x);
+    if(area > 0.0f)
+        return PrimitiveTest::BackFacing;
+    if(area == 0.0f)
+        return PrimitiveTest::ZeroArea;
+
+    // HLSL round goes to the even integer on halves
+    const glm::vec2 boundsMin = glm::roundEven(glm::min(a, glm::min(b, c)));
+    const glm::vec2 boundsMax = glm::roundEven(glm::max(a, glm::max(b, c)));
+    return boundsMin.x == boundsMax.x || boundsMin.y == boundsMax.y ? PrimitiveTest::BetweenSamples : PrimitiveTest::Visible;
+}
+
+// Instance and meshlet culling of the amplification shader, then the triangle tests of the mesh shader, for one view
+// of the grid. Counts the instances and meshlets drawn and the triangles of those per PrimitiveTest.
+static void CullGrid(const ClusterDag& inDag, const std::vector<glm::vec3>& inPositions, const std::vector<glm::mat4>& inLocalToWorld
+    , const CameraPerspective& inCamera, uint32_t& outInstances, uint32_t& outMeshlets, uint32_t (&outTriangles)[5])
+{
+    ViewFrustumPlanes frustum;
+    inCamera.GetViewFrustumPlanesWorldSpace(frustum);
+    const glm::mat4 viewProjection = inCamera.GetViewProjectionMatrix();
+    const float errorScale = s_ViewportHeight * 0.5f * inCamera.GetProjectionMatrix()[1][1];
+    const glm::vec4 bounds = inDag.ComputeBoundingSphere();
+    const glm::vec3 cameraPosition = inCamera.Transform.GetWorldPosition();
+
+    outInstances = outMeshlets = 0;
+    std::fill(std::begin(outTriangles), std::end(outTriangles), 0u);
+    std::vector<uint32_t> triangles;
+    std::vector<glm::vec4> clipPositions(inPositions.size());
+    for(const glm::mat4& localToWorld : inLocalToWorld)
+    {
+        // Rotated and moved only, radii stay the same in world space
+        if(!CameraBase::IsSphereInFrustum(frustum, glm::vec3(localToWorld * glm::vec4(glm::vec3(bounds), 1.0f)), bounds.w))
+            continue;
+        ++outInstances;
+        const glm::vec3 cameraPositionLS = glm::vec3(glm::inverse(localToWorld) * glm::vec4(cameraPosition, 1.0f));
+        const glm::mat4 localToClip = viewProjection * localToWorld;
+        for(uint32_t c = 0; c < inDag.GetClusterCount(); ++c)
+        {
+            const ClusterDag::CullData& cullData = inDag.GetCullData()[c];
+            if(!ClusterDag::IsInCut(inDag.GetLods()[c], cameraPositionLS, errorScale)
+                || !CameraBase::IsSphereInFrustum(frustum, glm::vec3(localToWorld * glm::vec4(glm::vec3(cullData.BoundingSphere), 1.0f)), cullData.BoundingSphere.w)
+                || ClusterDag::IsBackFacing(cullData, cameraPositionLS))
+                continue;
+            ++outMeshlets;
+            triangles.clear();
+            inDag.AppendTriangles(c, triangles);
+            for(size_t t = 0; t < triangles.size(); t += 3)
+            {
+                const glm::vec4 a = localToClip * glm::vec4(inPositions[triangles[t]], 1.0f);
+                const glm::vec4 b = localToClip * glm::vec4(inPositions[triangles[t + 1]], 1.0f);
+                const glm::vec4 d = localToClip * glm::vec4(inPositions[triangles[t + 2]], 1.0f);
+                ++outTriangles[static_cast<uint32_t>(TestPrimitive(a, b, d))];
+            }
+        }
+    }
+}
+
+int main(int argc, char** argv)
+{
+    uint32_t iterations = 3;
+    std::string meshName;
+    std::string reportPath;
+    std::string baselinePath;
+    double tolerancePercent = 10.0;
+    for(int i = 1; i < argc; ++i)
+    {
+        const bool hasValue = i + 1 < argc;
+        if(strcmp(argv[i], "--mesh") == 0 && hasValue)
+            meshName = argv[++i];
+        else if(strcmp(argv[i], "--iterations") == 0 && hasValue)
+            iterations = std::max(1, atoi(argv[++i]));
+        else if(strcmp(argv[i], "--report") == 0 && hasValue)
+            reportPath = argv[++i];
+        else if(strcmp(argv[i], "--baseline") == 0 && hasValue)
+            baselinePath = argv[++i];
+        else if(strcmp(argv[i], "--tolerance") == 0 && hasValue)
+            tolerancePercent = atof(argv[++i]);
+        else
+            LOG_WARNING("Unknown argument %s", argv[i]);
+    }
+
+    std::vector<glm::vec3> positions;
+    std::vector<uint32_t> indices;
+    if(meshName.empty())
+    {
+        BuildSphere(positions, indices);
+    }
+    else
+    {
+        std::shared_ptr<AssetsManager::Mesh> mesh = AssetsManager::LoadMeshImmediately(meshName.c_str());
+        if(!mesh || mesh->IsEmpty())
+            return 1;
+        std::vector<glm::vec4> meshPositions;
+        mesh->GetPositionData(meshPositions);
+        for(const glm::vec4& position : meshPositions)
+            positions.push_back(glm::vec3(position));
+        const uint32_t* meshIndices = static_cast<const uint32_t*>(mesh->GetIndicesData());
+        indices.assign(meshIndices, meshIndices + mesh->GetIndicesCount());
+    }
+    // Models split their vertices along attribute seams, their cuts only close when the mesh does
+    const bool closed = IsClosed(indices);
+
+    Benchmark benchmark;
+    ClusterDag dag;
+    for(uint32_t i = 0; i < iterations; ++i)
+    {
+        const auto start = std::chrono::steady_clock::now();
+        dag.Build(positions, indices);
+        benchmark.AddSample("Build DAG", MillisecondsSince(start));
+    }
+    Log::Info("[ClusterDag] %u triangles into %u clusters over %u levels", static_cast<uint32_t>(indices.size() / 3)
+        , dag.GetClusterCount(), dag.GetLevelCount());
+
+    int exitCode = ValidateDag(dag) ? 0 : 1;
+
+    const std::filesystem::path bakedPath = std::filesystem::temp_directory_path() / "ClusterDagBench.cdag";
+    ClusterDag baked;
+    if(dag.Save(bakedPath))
+    {
+        const auto start = std::chrono::steady_clock::now();
+        const bool loaded = baked.Load(bakedPath, static_cast<uint32_t>(positions.size()), static_cast<uint32_t>(indices.size()));
+        benchmark.AddSample("Load baked DAG", MillisecondsSince(start));
+        if(!loaded || baked.GetPrimitives() != dag.GetPrimitives() || baked.GetVertexIndices() != dag.GetVertexIndices()
+            || memcmp(baked.GetLods().data(), dag.GetLods().data(), dag.GetLods().size() * sizeof(ClusterDag::ClusterLod)) != 0
+            || memcmp(baked.GetCullData().data(), dag.GetCullData().data(), dag.GetCullData().size() * sizeof(ClusterDag::CullData)) != 0)
+        {
+            LOG_ERROR("[ClusterDag] The baked DAG differs from the built one");
+            exitCode = 1;
+        }
+        std::filesystem::remove(bakedPath);
+    }
+
+    // Distances are in radii of the DAG bounds, a few directions around the mesh and one from above
+    const glm::vec4 bounds = dag.ComputeBoundingSphere();
+    const glm::vec3 directions[] = {glm::vec3(0.0f, 0.3f, 1.0f), glm::vec3(1.0f, 0.3f, 0.0f), glm::vec3(0.0f, 0.3f, -1.0f)
+        , glm::vec3(-1.0f, 0.3f, 0.0f), glm::vec3(0.0f, 1.0f, 0.0f)};
+    std::vector<uint32_t> cut;
+    for(float distance : {1.5f, 3.0f, 6.0f, 12.0f, 24.0f, 48.0f, 96.0f})
+    {
+        uint32_t cutClusters = 0, culledClusters = 0, cutTriangles = 0, culledTriangles = 0;
+        float cutError = 0.0f, maxError = 0.0f, meanError = 0.0f;
+        for(const glm::vec3& direction : directions)
+        {
+            const glm::vec3 cameraPosition = glm::vec3(bounds) + glm::normalize(direction) * (bounds.w * distance);
+            auto start = std::chrono::steady_clock::now();
+            float viewError = 0.0f;
+            cut.clear();
+            for(uint32_t c = 0; c < dag.GetClusterCount(); ++c)
+            {
+                if(ClusterDag::IsInCut(dag.GetLods()[c], cameraPosition, s_ErrorScale))
+                {
+                    dag.AppendTriangles(c, cut);
+                    viewError = std::max(viewError, dag.GetLods()[c].LodError);
+                }
+            }
+            benchmark.AddSample("Select cut", MillisecondsSince(start));
+
+            float viewMaxError, viewMeanError;
+            MeshSimplifier::MeasureError(positions, indices, cut.data(), static_cast<uint32_t>(cut.size()), viewMaxError, viewMeanError);
+            if(closed && !IsClosed(cut))
+            {
+                LOG_ERROR("[ClusterDag] The cut at distance %.1f has cracks", distance);
+                exitCode = 1;
+            }
+            if(viewMaxError > viewError * 1.01f + 1e-5f)
+            {
+                LOG_ERROR("[ClusterDag] The cut at distance %.1f moved the surface by %.5f, more than its error %.5f", distance, viewMaxError, viewError);
+                exitCode = 1;
+            }
+            cutError = std::max(cutError, viewError);
+            maxError = std::max(maxError, viewMaxError);
+            meanError += viewMeanError / static_cast<float>(std::size(directions));
+
+            // On the procedural sphere the cones reject 24-31% of the cut clusters and 9-22% of the triangles, less
+            // than half of the back faces. Clusters of up to 124 triangles on a curved surface keep cones of about 40
+            // degrees at every level, which only cull from views within 50 degrees of their back, and from level 3 on
+            // 8-30% of the clusters have no cone at all. The clusters that do cull tend to be the smaller ones, so
+            // the triangle share falls behind the cluster share with distance.
+            start = std::chrono::steady_clock::now();
+            for(uint32_t c = 0; c < dag.GetClusterCount(); ++c)
+            {
+                if(ClusterDag::IsInCut(dag.GetLods()[c], cameraPosition, s_ErrorScale))
+                    culledClusters += ClusterDag::IsBackFacing(dag.GetCullData()[c], cameraPosition) ? 1 : 0;
+            }
+            benchmark.AddSample("Cone cull", MillisecondsSince(start));
+
+            // Rejections again, against the triangles they stand for
+            cut.clear();
+            for(uint32_t c = 0; c < dag.GetClusterCount(); ++c)
+            {
+                if(!ClusterDag::IsInCut(dag.GetLods()[c], cameraPosition, s_ErrorScale))
+                    continue;
+                const size_t first = cut.size();
+                dag.AppendTriangles(c, cut);
+                ++cutClusters;
+                if(!ClusterDag::IsBackFacing(dag.GetCullData()[c], cameraPosition))
+                    continue;
+                culledTriangles += static_cast<uint32_t>((cut.size() - first) / 3);
+                if(!IsBackFacing(positions, cut, first, cameraPosition))
+                {
+                    LOG_ERROR("[ClusterDag] The cone of cluster %u rejects triangles facing the camera at distance %.1f", c, distance);
+                    exitCode = 1;
+                }
+            }
+            cutTriangles += static_cast<uint32_t>(cut.size() / 3);
+        }
+
+        const uint32_t viewCount = static_cast<uint32_t>(std::size(directions));
+        Log::Info("[ClusterDag] Distance %.1f: %u triangles, error %.5f, measured max %.5f mean %.5f, cones reject %.1f%% of the clusters and %.1f%% of the triangles"
+            , distance, cutTriangles / viewCount, cutError, maxError, meanError
+            , 100.0 * culledClusters / std::max(1u, cutClusters), 100.0 * culledTriangles / std::max(1u, cutTriangles));
+    }
+
+    std::mt19937 random(1);
+    std::uniform_real_distribution<float> dis11(-1.0f, 1.0f);
+    std::vector<glm::mat4> localToWorld;
+    for(uint32_t i = 0; i < s_GridSize * s_GridSize * s_GridSize; ++i)
+    {
+        const glm::vec3 cell(static_cast<float>(i / (s_GridSize * s_GridSize)), static_cast<float>(i / s_GridSize % s_GridSize), static_cast<float>(i % s_GridSize));
+        Transform transform;
+        transform.SetWorldPosition(glm::mix(glm::vec3(-s_GridExtent), glm::vec3(s_GridExtent), cell / static_cast<float>(s_GridSize)));
+        transform.SetLocalRotation(glm::vec3(dis11(random), dis11(random), dis11(random)));
+        localToWorld.push_back(transform.GetLocalToWorldMatrix());
+    }
+
+    // Where the examples start, then further out so the instances shrink to a few pixels
+    const std::pair<const char*, glm::vec3> views[] = {{"start", glm::vec3(0.0f, 20.0f, 0.0f)}
+        , {"near", glm::vec3(0.0f, 40.0f, -60.0f)}, {"far", glm::vec3(0.0f, 120.0f, -240.0f)}};
+    for(const auto& [name, position] : views)
+    {
+        CameraPerspective camera;
+        camera.AspectRatio = s_ViewportWidth / s_ViewportHeight;
+        camera.Transform.SetWorldPosition(position);
+        camera.Transform.LookAt(glm::vec3(0.0f));
+
+        uint32_t instances, meshlets, triangles[5];
+        const auto start = std::chrono::steady_clock::now();
+        CullGrid(dag, positions, localToWorld, camera, instances, meshlets, triangles);
+        benchmark.AddSample("Cull grid", MillisecondsSince(start));
+
+        const uint32_t total = std::max(1u, triangles[0] + triangles[1] + triangles[2] + triangles[3] + triangles[4]);
+        auto percent = [&](PrimitiveTest inTest) { return 100.0 * triangles[static_cast<uint32_t>(inTest)] / total; };
+        Log::Info("[ClusterDag] Grid %s view: %u instances, %u meshlets, %u triangles, removed %.1f%% back facing, %.1f%% zero area, %.1f%% between samples, %.1f%% emitted"
+            , name, instances, meshlets, total, percent(PrimitiveTest::BackFacing), percent(PrimitiveTest::ZeroArea)
+            , percent(PrimitiveTest::BetweenSamples), percent(PrimitiveTest::Visible) + percent(PrimitiveTest::Crossing));
+    }
+
+    benchmark.LogReport();
+    if(!reportPath.empty())
+        benchmark.WriteReport(reportPath, "ClusterDagBench", 0);
+    if(!baselinePath.empty() && !benchmark.CompareWithBaseline(baselinePath, tolerancePercent))
+        exitCode = 1;
+    Log::Flush();
+    return exitCode;
+}
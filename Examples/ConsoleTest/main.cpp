@@ -6,6 +6,6 @@ int main()
 
     uint8_t* ptr = a;
 
-    Log::Info("%d", *(ptr + 4));
+    LOG_INFO("%d", *(ptr + 4));
     return 0;
 }
\ No newline at end of file
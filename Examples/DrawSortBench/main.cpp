@@ -0,0 +1,179 @@
+#include "Benchmark.h"
+#include "DrawSort.h"
+#include "Log.h"
+#include <glm/gtc/matrix_transform.hpp>
+#include <algorithm>
+#include <cfloat>
+#include <chrono>
+#include <cstdlib>
+#include <cstring>
+#include <numeric>
+#include <random>
+#include <string>
+
+// Sorts 1M random draw keys with DrawSorter on one and on every thread against std::stable_sort, then measures the
+// overdraw of the sphere grid of IndirectDraw in grid order and in draw key orders, without a device.
+//
+//   DrawSortBench [--iterations N] [--report path.json|path.csv] [--baseline path.json] [--tolerance percent]
+
+static constexpr uint32_t s_KeyCount = 1024 * 1024;
+static constexpr uint32_t s_GridSize = 16;
+static constexpr uint32_t s_TexturesCount = 5;
+static constexpr uint32_t s_OverdrawWidth = 320, s_OverdrawHeight = 180;
+
+static double MillisecondsSince(std::chrono::steady_clock::time_point inStart)
+{
+    return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - inStart).count();
+}
+
+struct SphereDraw
+{
+    glm::vec3 CenterVS;
+    float     Radius;
+    uint32_t  Material;
+};
+
+// Rasterizes every sphere as a screen space disc at the depth of its center with early depth test, returns the
+// fragments shaded per covered pixel
+static double MeasureOverdraw(const std::vector<SphereDraw>& inDraws, const std::vector<uint32_t>& inOrder, const glm::mat4& inProjection)
+{
+    std::vector<float> depth(s_OverdrawWidth * s_OverdrawHeight, FLT_MAX);
+    uint64_t shaded = 0;
+    for(uint32_t draw : inOrder)
+    {
+        const SphereDraw& sphere = inDraws[draw];
+        if(sphere.CenterVS.z <= sphere.Radius)
+            continue;
+        const glm::vec4 clip = inProjection * glm::vec4(sphere.CenterVS, 1.0f);
+        const glm::vec2 center((clip.x / clip.w * 0.5f + 0.5f) * s_OverdrawWidth, (0.5f - clip.y / clip.w * 0.5f) * s_OverdrawHeight);
+        const float radius = sphere.Radius * inProjection[1][1] / sphere.CenterVS.z * 0.5f * s_OverdrawHeight;
+        const int minX = std::max(static_cast<int>(center.x - radius), 0), maxX = std::min(static_cast<int>(center.x + radius), static_cast<int>(s_OverdrawWidth) - 1);
+        const int minY = std::max(static_cast<int>(center.y - radius), 0), maxY = std::min(static_cast<int>(center.y + radius), static_cast<int>(s_OverdrawHeight) - 1);
+        for(int y = minY; y <= maxY; ++y)
+        {
+            for(int x = minX; x <= maxX; ++x)
+            {
+                const glm::vec2 offset(x + 0.5f - center.x, y + 0.5f - center.y);
+                float& pixel = depth[y * s_OverdrawWidth + x];
+                if(glm::dot(offset, offset) > radius * radius || sphere.CenterVS.z >= pixel)
+                    continue;
+                pixel = sphere.CenterVS.z;
+                ++shaded;
+            }
+        }
+    }
+    const uint64_t covered = std::count_if(depth.begin(), depth.end(), [](float inDepth) { return inDepth != FLT_MAX; });
+    return covered > 0 ? static_cast<double>(shaded) / covered : 0.0;
+}
+
+int main(int argc, char** argv)
+{
+    uint32_t iterations = 20;
+    std::string reportPath;
+    std::string baselinePath;
+    double tolerancePercent = 10.0;
+    for(int i = 1; i < argc; ++i)
+    {
+        const bool hasValue = i + 1 < argc;
+        if(strcmp(argv[i], "--iterations") == 0 && hasValue)
+            iterations = std::max(1, atoi(argv[++i]));
+        else if(strcmp(argv[i], "--report") == 0 && hasValue)
+            reportPath = argv[++i];
+        else if(strcmp(argv[i], "--baseline") == 0 && hasValue)
+            baselinePath = argv[++i];
+        else if(strcmp(argv[i], "--tolerance") == 0 && hasValue)
+            tolerancePercent = atof(argv[++i]);
+        else
+            LOG_WARNING("Unknown argument %s", argv[i]);
+    }
+
+    std::mt19937 gen(42);
+    std::uniform_real_distribution<float> dis01(0.0f, 1.0f);
+
+    // Random opaque keys over a few passes, pipelines and materials, as a scene would produce them
+    std::vector<uint64_t> sourceKeys(s_KeyCount);
+    for(uint64_t& key : sourceKeys)
+        key = DrawKey::Opaque(gen() % 2, gen() % 16, gen() % 1024, dis01(gen) * 1000.0f);
+
+    Benchmark benchmark;
+    DrawSorter sorter;
+    std::vector<uint64_t> keys;
+    std::vector<uint32_t> values;
+    std::vector<std::pair<uint64_t, uint32_t>> pairs(s_KeyCount);
+    for(uint32_t i = 0; i < iterations; ++i)
+    {
+        for(uint32_t j = 0; j < s_KeyCount; ++j)
+            pairs[j] = {sourceKeys[j], j};
+        auto start = std::chrono::steady_clock::now();
+        std::stable_sort(pairs.begin(), pairs.end(), [](const auto& inLhs, const auto& inRhs) { return inLhs.first < inRhs.first; });
+        benchmark.AddSample("std::stable_sort 1M", MillisecondsSince(start));
+
+        for(uint32_t threads : {1u, 0u})
+        {
+            keys = sourceKeys;
+            values.resize(s_KeyCount);
+            std::iota(values.begin(), values.end(), 0u);
+            start = std::chrono::steady_clock::now();
+            sorter.Sort(keys, values, threads);
+            benchmark.AddSample(threads == 1 ? "Radix 1M 1 thread" : "Radix 1M all threads", MillisecondsSince(start));
+        }
+    }
+    for(uint32_t j = 0; j < s_KeyCount; ++j)
+    {
+        if(keys[j] != pairs[j].first || values[j] != pairs[j].second)
+        {
+            LOG_ERROR("[DrawSort] Radix sort differs from std::stable_sort at %u", j);
+            Log::Flush();
+            return 1;
+        }
+    }
+    Log::Info("[DrawSort] %u of 8 radix passes ran, the others had a single digit", sorter.GetLastPassCount());
+
+    // The grid of IndirectDraw seen from its last corner, so grid order is mostly back to front, materials cycle over
+    // the instances
+    const glm::mat4 view = glm::lookAtLH(glm::vec3(60.0f, 30.0f, 60.0f), glm::vec3(0.0f), glm::vec3(0.0f, 1.0f, 0.0f));
+    const glm::mat4 projection = glm::perspectiveLH_ZO(glm::radians(60.0f), 16.0f / 9.0f, 0.1f, 1000.0f);
+    const glm::vec3 zoom(s_GridSize * 2.5f);
+    std::vector<SphereDraw> draws;
+    for(uint32_t x = 0; x < s_GridSize; ++x)
+    {
+        for(uint32_t y = 0; y < s_GridSize; ++y)
+        {
+            for(uint32_t z = 0; z < s_GridSize; ++z)
+            {
+                const glm::vec3 position = glm::mix(-zoom, zoom, glm::vec3(x, y, z) / static_cast<float>(s_GridSize));
+                const uint32_t i = static_cast<uint32_t>(draws.size());
+                draws.push_back({glm::vec3(view * glm::vec4(position, 1.0f)), 1.0f, i % s_TexturesCount});
+            }
+        }
+    }
+
+    std::vector<uint32_t> gridOrder(draws.size());
+    std::iota(gridOrder.begin(), gridOrder.end(), 0u);
+    keys.resize(draws.size());
+    for(uint32_t i = 0; i < draws.size(); ++i)
+        keys[i] = DrawKey::Opaque(0, 0, draws[i].Material, draws[i].CenterVS.z);
+    std::vector<uint32_t> keyOrder = gridOrder;
+    sorter.Sort(keys, keyOrder);
+    for(uint32_t i = 0; i < draws.size(); ++i)
+        keys[i] = DrawKey::Opaque(0, 0, 0, draws[i].CenterVS.z);
+    std::vector<uint32_t> frontToBackOrder = gridOrder;
+    sorter.Sort(keys, frontToBackOrder);
+    for(uint32_t i = 0; i < draws.size(); ++i)
+        keys[i] = DrawKey::Transparent(0, 0, draws[i].Material, draws[i].CenterVS.z);
+    std::vector<uint32_t> backToFrontOrder = gridOrder;
+    sorter.Sort(keys, backToFrontOrder);
+
+    Log::Info("[DrawSort] Overdraw of %zu spheres: %.2f in grid order, %.2f by material then depth, %.2f front to back, %.2f back to front"
+        , draws.size(), MeasureOverdraw(draws, gridOrder, projection), MeasureOverdraw(draws, keyOrder, projection)
+        , MeasureOverdraw(draws, frontToBackOrder, projection), MeasureOverdraw(draws, backToFrontOrder, projection));
+
+    benchmark.LogReport();
+    if(!reportPath.empty())
+        benchmark.WriteReport(reportPath, "DrawSortBench", 0);
+    int exitCode = 0;
+    if(!baselinePath.empty() && !benchmark.CompareWithBaseline(baselinePath, tolerancePercent))
+        exitCode = 1;
+    Log::Flush();
+    return exitCode;
+}
@@ -0,0 +1,241 @@
+#include "Benchmark.h"
+#include "GeometryPool.h"
+#include "Log.h"
+#include <algorithm>
+#include <chrono>
+#include <cstdlib>
+#include <cstring>
+#include <random>
+#include <string>
+
+// Churns a GeometryPool with random adds and removes without a device and runs Validate() after every round. Both
+// buffers are mirrored with one tag per element, the moves of Compact() are replayed on the mirrors and every live
+// mesh has to find its own elements at its new ranges. Times the churn and the compaction.
+//
+//   GeometryPoolBench [--iterations N] [--report path.json|path.csv] [--baseline path.json] [--tolerance percent]
+
+static constexpr uint32_t s_VertexCapacity = 256 * 1024;
+static constexpr uint32_t s_IndexCapacity = 768 * 1024;
+static constexpr uint32_t s_MaxMeshVertices = 4096;
+static constexpr uint32_t s_RoundCount = 32;
+static constexpr uint32_t s_CompactInterval = 8;
+static constexpr uint64_t s_NoTag = UINT64_MAX;
+
+static double MillisecondsSince(std::chrono::steady_clock::time_point inStart)
+{
+    return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - inStart).count();
+}
+
+// What the owner would upload: the serial of the AddMesh call and the element index inside the mesh
+static uint64_t Tag(uint32_t inSerial, uint32_t inElement)
+{
+    return static_cast<uint64_t>(inSerial) << 32 | inElement;
+}
+
+struct PoolMirror
+{
+    std::vector<uint64_t> Vertices;
+    std::vector<uint64_t> Indices;
+    std::vector<uint32_t> Serials;      // per mesh id
+};
+
+static void Upload(const GeometryPool& inPool, uint32_t inMesh, uint32_t inSerial, PoolMirror& ioMirror)
+{
+    const GeometryPool::MeshRange& range = inPool.GetMesh(inMesh);
+    for(uint32_t i = 0; i < range.VertexCount; ++i)
+        ioMirror.Vertices[range.FirstVertex + i] = Tag(inSerial, i);
+    for(uint32_t i = 0; i < range.IndexCount; ++i)
+        ioMirror.Indices[range.FirstIndex + i] = Tag(inSerial, i);
+    if(inMesh >= ioMirror.Serials.size())
+        ioMirror.Serials.resize(inMesh + 1);
+    ioMirror.Serials[inMesh] = inSerial;
+}
+
+// Copies from the old buffer into a new one as the owner would, and checks the list on the way: sources and
+// destinations inside the buffer, destinations packed from 0 in order, contiguous moves merged
+static bool ReplayMoves(const char* inName, const std::vector<GeometryPool::Move>& inMoves, uint32_t inUsed, std::vector<uint64_t>& ioBuffer)
+{
+    std::vector<uint64_t> packed(ioBuffer.size(), s_NoTag);
+    uint32_t end = 0;
+    for(size_t i = 0; i < inMoves.size(); ++i)
+    {
+        const GeometryPool::Move& move = inMoves[i];
+        if(move.Count == 0 || move.SrcOffset + move.Count > ioBuffer.size() || move.DstOffset != end)
+        {
+            LOG_ERROR("[GeometryPool] %s move %zu copies %u from %u to %u, expected destination %u", inName, i, move.Count, move.SrcOffset, move.DstOffset, end);
+            return false;
+        }
+        if(i > 0 && inMoves[i - 1].SrcOffset + inMoves[i - 1].Count == move.SrcOffset)
+        {
+            LOG_ERROR("[GeometryPool] %s moves %zu and %zu are contiguous and were not merged", inName, i - 1, i);
+            return false;
+        }
+        std::copy_n(ioBuffer.begin() + move.SrcOffset, move.Count, packed.begin() + move.DstOffset);
+        end += move.Count;
+    }
+    if(end != inUsed)
+    {
+        LOG_ERROR("[GeometryPool] %s moves pack %u elements, %u are used", inName, end, inUsed);
+        return false;
+    }
+    ioBuffer.swap(packed);
+    return true;
+}
+
+static bool CheckContents(const GeometryPool& inPool, const std::vector<uint32_t>& inLive, const PoolMirror& inMirror)
+{
+    for(uint32_t mesh : inLive)
+    {
+        const GeometryPool::MeshRange& range = inPool.GetMesh(mesh);
+        const uint32_t serial = inMirror.Serials[mesh];
+        for(uint32_t i = 0; i < range.VertexCount; ++i)
+        {
+            if(inMirror.Vertices[range.FirstVertex + i] != Tag(serial, i))
+            {
+                LOG_ERROR("[GeometryPool] Mesh %u lost vertex %u at %u", mesh, i, range.FirstVertex + i);
+                return false;
+            }
+        }
+        for(uint32_t i = 0; i < range.IndexCount; ++i)
+        {
+            if(inMirror.Indices[range.FirstIndex + i] != Tag(serial, i))
+            {
+                LOG_ERROR("[GeometryPool] Mesh %u lost index %u at %u", mesh, i, range.FirstIndex + i);
+                return false;
+            }
+        }
+    }
+    return true;
+}
+
+int main(int argc, char** argv)
+{
+    uint32_t iterations = 20;
+    std::string reportPath;
+    std::string baselinePath;
+    double tolerancePercent = 10.0;
+    for(int i = 1; i < argc; ++i)
+    {
+        const bool hasValue = i + 1 < argc;
+        if(strcmp(argv[i], "--iterations") == 0 && hasValue)
+            iterations = std::max(1, atoi(argv[++i]));
+        else if(strcmp(argv[i], "--report") == 0 && hasValue)
+            reportPath = argv[++i];
+        else if(strcmp(argv[i], "--baseline") == 0 && hasValue)
+            baselinePath = argv[++i];
+        else if(strcmp(argv[i], "--tolerance") == 0 && hasValue)
+            tolerancePercent = atof(argv[++i]);
+        else
+            LOG_WARNING("Unknown argument %s", argv[i]);
+    }
+
+    std::mt19937 gen(42);
+    Benchmark benchmark;
+    GeometryPool pool;
+    PoolMirror mirror;
+    std::vector<uint32_t> live;
+    std::vector<GeometryPool::Move> vertexMoves, indexMoves;
+    uint32_t serial = 0;
+    uint64_t addedCount = 0, removedCount = 0, compactionCount = 0, moveCount = 0, movedVertices = 0;
+    double largestFreeRatio = 0.0;
+    for(uint32_t iteration = 0; iteration < iterations; ++iteration)
+    {
+        pool.Init(s_VertexCapacity, s_IndexCapacity);
+        mirror.Vertices.assign(s_VertexCapacity, s_NoTag);
+        mirror.Indices.assign(s_IndexCapacity, s_NoTag);
+        live.clear();
+        for(uint32_t round = 1; round <= s_RoundCount; ++round)
+        {
+            // Fill until a random mesh does not fit any more, then drop about half of the live meshes
+            auto start = std::chrono::steady_clock::now();
+            for(;;)
+            {
+                const uint32_t vertexCount = gen() % 32 == 0 ? 0 : 1 + gen() % s_MaxMeshVertices;
+                const uint32_t indexCount = vertexCount * (1 + gen() % 6);
+                if(vertexCount > pool.GetLargestFreeVertices() || indexCount > pool.GetLargestFreeIndices())
+                    break;
+                const uint32_t mesh = pool.AddMesh(vertexCount, indexCount);
+                if(mesh == GeometryPool::s_InvalidMesh)
+                {
+                    LOG_ERROR("[GeometryPool] AddMesh(%u, %u) failed with a large enough free range", vertexCount, indexCount);
+                    Log::Flush();
+                    return 1;
+                }
+                Upload(pool, mesh, serial++, mirror);
+                live.push_back(mesh);
+                ++addedCount;
+            }
+            std::shuffle(live.begin(), live.end(), gen);
+            const size_t keepCount = live.size() / 2;
+            for(size_t i = keepCount; i < live.size(); ++i)
+                pool.RemoveMesh(live[i]);
+            removedCount += live.size() - keepCount;
+            live.resize(keepCount);
+            benchmark.AddSample("Add and remove round", MillisecondsSince(start));
+
+            if(!pool.Validate() || pool.GetMeshCount() != live.size())
+            {
+                LOG_ERROR("[GeometryPool] Pool is inconsistent after round %u of iteration %u", round, iteration);
+                Log::Flush();
+                return 1;
+            }
+            if(round % s_CompactInterval != 0)
+                continue;
+
+            const uint32_t freeVertices = s_VertexCapacity - pool.GetUsedVertices();
+            largestFreeRatio += freeVertices > 0 ? static_cast<double>(pool.GetLargestFreeVertices()) / freeVertices : 1.0;
+            start = std::chrono::steady_clock::now();
+            pool.Compact(vertexMoves, indexMoves);
+            benchmark.AddSample("Compact", MillisecondsSince(start));
+            ++compactionCount;
+            moveCount += vertexMoves.size() + indexMoves.size();
+            for(const GeometryPool::Move& move : vertexMoves)
+                movedVertices += move.SrcOffset != move.DstOffset ? move.Count : 0;
+
+            if(!pool.Validate()
+                || !ReplayMoves("Vertex", vertexMoves, pool.GetUsedVertices(), mirror.Vertices)
+                || !ReplayMoves("Index", indexMoves, pool.GetUsedIndices(), mirror.Indices)
+                || !CheckContents(pool, live, mirror))
+            {
+                LOG_ERROR("[GeometryPool] Compaction %u of iteration %u is wrong", round / s_CompactInterval, iteration);
+                Log::Flush();
+                return 1;
+            }
+            // Everything that is free now has to be one range at the end, exactly filled by one more mesh
+            const uint32_t tailVertices = s_VertexCapacity - pool.GetUsedVertices();
+            const uint32_t tailIndices = s_IndexCapacity - pool.GetUsedIndices();
+            if(pool.GetLargestFreeVertices() != tailVertices || pool.GetLargestFreeIndices() != tailIndices)
+            {
+                LOG_ERROR("[GeometryPool] Largest free ranges after compaction are %u and %u, expected %u and %u"
+                    , pool.GetLargestFreeVertices(), pool.GetLargestFreeIndices(), tailVertices, tailIndices);
+                Log::Flush();
+                return 1;
+            }
+        }
+
+        const uint32_t tailVertices = s_VertexCapacity - pool.GetUsedVertices();
+        const uint32_t tailIndices = s_IndexCapacity - pool.GetUsedIndices();
+        const uint32_t tail = pool.AddMesh(tailVertices, tailIndices);
+        if(tail == GeometryPool::s_InvalidMesh || !pool.Validate() || pool.GetUsedVertices() != s_VertexCapacity || pool.GetUsedIndices() != s_IndexCapacity)
+        {
+            LOG_ERROR("[GeometryPool] A mesh of the whole free space did not fill the pool after compaction");
+            Log::Flush();
+            return 1;
+        }
+    }
+
+    Log::Info("[GeometryPool] %llu meshes added, %llu removed, %llu compactions with %.1f moves and %.0f vertices moved on average"
+        , static_cast<unsigned long long>(addedCount), static_cast<unsigned long long>(removedCount), static_cast<unsigned long long>(compactionCount)
+        , static_cast<double>(moveCount) / compactionCount, static_cast<double>(movedVertices) / compactionCount);
+    Log::Info("[GeometryPool] Before compaction the largest free vertex range held %.0f%% of the free vertices on average"
+        , largestFreeRatio / compactionCount * 100.0);
+
+    benchmark.LogReport();
+    if(!reportPath.empty())
+        benchmark.WriteReport(reportPath, "GeometryPoolBench", 0);
+    int exitCode = 0;
+    if(!baselinePath.empty() && !benchmark.CompareWithBaseline(baselinePath, tolerancePercent))
+        exitCode = 1;
+    Log::Flush();
+    return exitCode;
+}
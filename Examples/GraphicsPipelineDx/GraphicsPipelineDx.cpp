@@ -4,6 +4,9 @@ bool GraphicsPipelineDx::Init()
 {
     if(!CreateDevice())
         return false;
+
+    if(!CreatePipelineLibrary("GraphicsPipelineDx"))
+        return false;
     
     if(!CreateCommandQueue())
         return false;
@@ -38,6 +41,7 @@ bool GraphicsPipelineDx::Init()
 void GraphicsPipelineDx::Shutdown()
 {
     FlushCommandQueue();
+    DestroyPipelineLibrary();
 }
 
 bool GraphicsPipelineDx::CreateDevice()
@@ -50,7 +54,7 @@ bool GraphicsPipelineDx::CreateDevice()
     if (SUCCEEDED(D3D12GetDebugInterface(IID_PPV_ARGS(&debugController))))
         debugController->EnableDebugLayer();
     else
-        Log::Warning("Failed to enable the D3D12 debug layer");
+        LOG_WARNING("Failed to enable the D3D12 debug layer");
 #endif
     
     const uint32_t factoryFlags = allowDebugging ? DXGI_CREATE_FACTORY_DEBUG : 0;
@@ -78,7 +82,7 @@ bool GraphicsPipelineDx::CreateDevice()
                 m_DeviceHandle = TempDevice;
                 std::wstring adapterDesc(Desc.Description);
                 std::string name(adapterDesc.begin(), adapterDesc.end());
-                Log::Info("[D3D12] Using adapter: %s", name.c_str());
+                LOG_INFO("[D3D12] Using adapter: %s", name.c_str());
                 break;
             }
         }
@@ -86,7 +90,7 @@ bool GraphicsPipelineDx::CreateDevice()
 
     if(m_DeviceHandle.Get() == nullptr)
     {
-        Log::Error("Failed to find a device supporting Mesh Shaders");
+        LOG_ERROR("Failed to find a device supporting Mesh Shaders");
         return false;
     }
     
@@ -23,7 +23,7 @@ bool GraphicsPipelineDx::CreateRootSignature()
     if(FAILED(hr))
     {
         OUTPUT_D3D12_FAILED_RESULT(hr)
-        Log::Error("[D3D12] Failed to serialize the root signature: %s", static_cast<const char*>(errorBlob->GetBufferPointer()));
+        LOG_ERROR("[D3D12] Failed to serialize the root signature: %s", static_cast<const char*>(errorBlob->GetBufferPointer()));
         return false;
     }
 
@@ -35,7 +35,7 @@ bool GraphicsPipelineDx::CreateRootSignature()
     if(FAILED(hr))
     {
         OUTPUT_D3D12_FAILED_RESULT(hr)
-        Log::Error("[D3D12] Failed to create the root signature");
+        LOG_ERROR("[D3D12] Failed to create the root signature");
         return false;
     }
     
@@ -47,13 +47,13 @@ bool GraphicsPipelineDx::CreateShader()
     m_VertexShaderBlob = AssetsManager::LoadShaderImmediately("Graphics.vs.bin");
     if(!m_VertexShaderBlob || m_VertexShaderBlob->IsEmpty())
     {
-        Log::Error("Failed to load vertex shader");
+        LOG_ERROR("Failed to load vertex shader");
         return false;
     }
     m_PixelShaderBlob = AssetsManager::LoadShaderImmediately("Graphics.ps.bin");
     if(!m_PixelShaderBlob || m_PixelShaderBlob->IsEmpty())
     {
-        Log::Error("Failed to load pixel shader");
+        LOG_ERROR("Failed to load pixel shader");
         return false;
     }
     
@@ -83,11 +83,14 @@ bool GraphicsPipelineDx::CreatePipelineState()
     pipelineDesc.PrimitiveTopologyType = D3D12_PRIMITIVE_TOPOLOGY_TYPE_TRIANGLE;
     pipelineDesc.NodeMask              = GetNodeMask();
 
-    const HRESULT hr = m_DeviceHandle->CreateGraphicsPipelineState(&pipelineDesc, IID_PPV_ARGS(&m_PipelineState));
-    if(FAILED(hr))
+    const bool succeeded = CreatePipelinesParallel({ [&]()
     {
-        OUTPUT_D3D12_FAILED_RESULT(hr)
-        Log::Error("[D3D12] Failed to create the pipeline state");
+        m_PipelineState = LoadGraphicsPipeline(L"GraphicsPipelineDx", pipelineDesc);
+        return m_PipelineState != nullptr;
+    } });
+    if(!succeeded)
+    {
+        LOG_ERROR("[D3D12] Failed to create the pipeline state");
         return false;
     }
     
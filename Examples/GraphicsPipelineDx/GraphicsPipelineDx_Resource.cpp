@@ -17,7 +17,7 @@ bool GraphicsPipelineDx::CreateDepthStencilBuffer()
 
     if(m_DeviceHandle == nullptr)
     {
-        Log::Error("[D3D12] Failed to create depth stencil buffer");
+        LOG_ERROR("[D3D12] Failed to create depth stencil buffer");
         return false;
     }
 
@@ -6,9 +6,8 @@ static const std::vector<const char*> s_ValidationLayerNames = {
     "VK_LAYER_KHRONOS_validation"
 };
 
+// The surface extensions are added by AddSurfaceExtensions unless running headless
 static const std::vector<const char*> s_InstanceExtensions = {
-    VK_KHR_SURFACE_EXTENSION_NAME,
-    VK_KHR_WIN32_SURFACE_EXTENSION_NAME,
     VK_KHR_GET_PHYSICAL_DEVICE_PROPERTIES_2_EXTENSION_NAME,
 #if _DEBUG || DEBUG
     VK_EXT_DEBUG_UTILS_EXTENSION_NAME
@@ -27,27 +26,27 @@ static VKAPI_ATTR VkBool32 VKAPI_CALL DebugCallback(VkDebugUtilsMessageSeverityF
 {
     if(messageSeverity & VK_DEBUG_UTILS_MESSAGE_SEVERITY_ERROR_BIT_EXT)
     {
-        Log::Error(TEXT("Validation layer: %s"), pCallbackData->pMessage);
+        LOG_ERROR(TEXT("Validation layer: %s"), pCallbackData->pMessage);
         return VK_FALSE;
     }
     else if(messageSeverity & VK_DEBUG_UTILS_MESSAGE_SEVERITY_WARNING_BIT_EXT)
     {
-        Log::Warning(TEXT("Validation layer: %s"), pCallbackData->pMessage);
+        LOG_WARNING(TEXT("Validation layer: %s"), pCallbackData->pMessage);
         return VK_SUCCESS;
     }
     else
     {
-        Log::Info(TEXT("Validation layer: %s"), pCallbackData->pMessage);
+        LOG_INFO(TEXT("Validation layer: %s"), pCallbackData->pMessage);
         return VK_SUCCESS;
     }
 }
 
 static void LogGpuProperties(const VkPhysicalDeviceProperties& inProperties)
 {
-    Log::Info("----------------------------------------------------------------");
-    Log::Info("GPU Name: %s", inProperties.deviceName);
-    Log::Info("API Version: %d.%d.%d", VK_VERSION_MAJOR(inProperties.apiVersion), VK_VERSION_MINOR(inProperties.apiVersion), VK_VERSION_PATCH(inProperties.apiVersion));
-    Log::Info("----------------------------------------------------------------");
+    LOG_INFO("----------------------------------------------------------------");
+    LOG_INFO("GPU Name: %s", inProperties.deviceName);
+    LOG_INFO("API Version: %d.%d.%d", VK_VERSION_MAJOR(inProperties.apiVersion), VK_VERSION_MINOR(inProperties.apiVersion), VK_VERSION_PATCH(inProperties.apiVersion));
+    LOG_INFO("----------------------------------------------------------------");
 }
 
 bool GraphicsPipelineVk::Init()
@@ -55,6 +54,9 @@ bool GraphicsPipelineVk::Init()
     if(!CreateDevice())
         return false;
 
+    if(!CreatePipelineCache("GraphicsPipelineVk"))
+        return false;
+
     if(!CreateFence())
         return false;
 
@@ -107,6 +109,7 @@ void GraphicsPipelineVk::Shutdown()
     DestroyDescriptorSetPool();
     DestroyCommandList();
     DestroyFence();
+    DestroyPipelineCache();
     DestroyDevice();
 }
 
@@ -122,8 +125,10 @@ bool GraphicsPipelineVk::CreateDevice()
     VkInstanceCreateInfo insCreateInfo{};
     insCreateInfo.sType = VK_STRUCTURE_TYPE_INSTANCE_CREATE_INFO;
     insCreateInfo.pApplicationInfo = &appInfo;
-    insCreateInfo.enabledExtensionCount = static_cast<uint32_t>(s_InstanceExtensions.size());
-    insCreateInfo.ppEnabledExtensionNames = s_InstanceExtensions.data();
+    std::vector<const char*> instanceExtensions = s_InstanceExtensions;
+    AddSurfaceExtensions(instanceExtensions);
+    insCreateInfo.enabledExtensionCount = static_cast<uint32_t>(instanceExtensions.size());
+    insCreateInfo.ppEnabledExtensionNames = instanceExtensions.data();
 
 #if _DEBUG || DEBUG
     VkDebugUtilsMessengerCreateInfoEXT debugCreateInfo{};
@@ -143,7 +148,7 @@ bool GraphicsPipelineVk::CreateDevice()
     VkResult result = vkCreateInstance(&insCreateInfo, nullptr, &m_InstanceHandle);
     if(result != VK_SUCCESS)
     {
-        Log::Error("Failed to create Vulkan instance");
+        LOG_ERROR("Failed to create Vulkan instance");
         return false;
     }
 
@@ -153,7 +158,7 @@ bool GraphicsPipelineVk::CreateDevice()
     {
         result = vkCreateDebugUtilsMessengerEXT(m_InstanceHandle, &debugCreateInfo, nullptr, &m_DebugMessenger);
         if(result != VK_SUCCESS)
-            Log::Warning("Failed to create debug messenger");
+            LOG_WARNING("Failed to create debug messenger");
     }
 #endif
 
@@ -162,7 +167,7 @@ bool GraphicsPipelineVk::CreateDevice()
     vkEnumeratePhysicalDevices(m_InstanceHandle, &gpuCount, nullptr);
     if( gpuCount == 0)
     {
-        Log::Error("No GPU found");
+        LOG_ERROR("No GPU found");
         return false;
     }
     
@@ -178,14 +183,22 @@ bool GraphicsPipelineVk::CreateDevice()
         {
             m_GpuHandle = tempPhysicalDevices[i];
             m_GpuProperties = gpuProperties;
-            Log::Info("[Vulkan] Using gpu: %s", gpuProperties.deviceName);
+            LOG_INFO("[Vulkan] Using gpu: %s", gpuProperties.deviceName);
             break;
         }
     }
 
+    // Headless runs also accept integrated and CPU devices, e.g. lavapipe or SwiftShader on a Linux build machine
+    if(m_GpuHandle == VK_NULL_HANDLE && IsHeadless())
+    {
+        m_GpuHandle = tempPhysicalDevices[0];
+        vkGetPhysicalDeviceProperties(m_GpuHandle, &m_GpuProperties);
+        LOG_INFO("[Vulkan] Using gpu: %s", m_GpuProperties.deviceName);
+    }
+
     if(m_GpuHandle == VK_NULL_HANDLE)
     {
-        Log::Error("Failed to find a discrete GPU");
+        LOG_ERROR("Failed to find a discrete GPU");
         return false;
     }
 
@@ -199,7 +212,7 @@ bool GraphicsPipelineVk::CreateDevice()
     vkEnumerateDeviceExtensionProperties(m_GpuHandle, nullptr, &extensionCount, extensions.data());
     for(const auto& extension : extensions)
     {
-        Log::Info("[Vulkan] GPU supports extension: %s", extension.extensionName);
+        LOG_INFO("[Vulkan] GPU supports extension: %s", extension.extensionName);
     }
 
     // Enumerate all layers
@@ -209,16 +222,13 @@ bool GraphicsPipelineVk::CreateDevice()
     vkEnumerateDeviceLayerProperties(m_GpuHandle, &layerCount, layers.data());
     for(const auto& layer : layers)
     {
-        Log::Info("[Vulkan] GPU supports layer: %s", layer.layerName);
+        LOG_INFO("[Vulkan] GPU supports layer: %s", layer.layerName);
     }
 
-    // Create Win23 surface
-    VkWin32SurfaceCreateInfoKHR surfaceCreateInfo{};
-    surfaceCreateInfo.sType = VK_STRUCTURE_TYPE_WIN32_SURFACE_CREATE_INFO_KHR;
-    surfaceCreateInfo.hwnd = m_hWnd;
-    surfaceCreateInfo.hinstance = m_hInstance;
-
-    result = vkCreateWin32SurfaceKHR(m_InstanceHandle, &surfaceCreateInfo, nullptr, &m_SurfaceHandle);
+    if(!CreateSurface())
+    {
+        return false;
+    }
 
     // Enumerate all queue families
     uint32_t queueFamilyCount = 0;
@@ -233,9 +243,7 @@ bool GraphicsPipelineVk::CreateDevice()
         if((queueFamilies[i].queueFlags & queueFlags) > 0)
         {
             // Check if the queue family supports present
-            VkBool32 presentSupport = false;
-            vkGetPhysicalDeviceSurfaceSupportKHR(m_GpuHandle, i, m_SurfaceHandle, &presentSupport);
-            if(presentSupport)
+            if(IsPresentSupported(i))
             {
                 m_QueueIndex = static_cast<int>(i);
                 break;
@@ -245,7 +253,7 @@ bool GraphicsPipelineVk::CreateDevice()
 
     if(m_QueueIndex < 0)
     {
-        Log::Error("Failed to find a queue family that supports present, graphics, copy and compute");
+        LOG_ERROR("Failed to find a queue family that supports present, graphics, copy and compute");
         return false;
     }
 
@@ -291,7 +299,7 @@ bool GraphicsPipelineVk::CreateDevice()
     result = vkCreateDevice(m_GpuHandle, &deviceCreateInfo, nullptr, &m_DeviceHandle);
     if(result != VK_SUCCESS)
     {
-        Log::Error("Failed to create logical device");
+        LOG_ERROR("Failed to create logical device");
         return false;
     }
 
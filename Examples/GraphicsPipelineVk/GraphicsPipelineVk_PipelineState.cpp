@@ -19,7 +19,7 @@ bool GraphicsPipelineVk::CreateDescriptorLayout()
     VkResult result = vkCreateDescriptorSetLayout(m_DeviceHandle, &layoutInfo, nullptr, &m_DescriptorLayoutSpace0);
     if(result != VK_SUCCESS)
     {
-        Log::Error("Failed to create descriptor set 0 layout");
+        LOG_ERROR("Failed to create descriptor set 0 layout");
         return false;
     }
 
@@ -44,7 +44,7 @@ bool GraphicsPipelineVk::CreateDescriptorLayout()
 	result = vkCreateDescriptorSetLayout(m_DeviceHandle, &layoutInfo1, nullptr, &m_DescriptorLayoutSpace1);
 	if(result != VK_SUCCESS)
 	{
-		Log::Error("Failed to create descriptor set 1 layout");
+		LOG_ERROR("Failed to create descriptor set 1 layout");
 		return false;
 	}
     
@@ -71,13 +71,13 @@ bool GraphicsPipelineVk::CreateShader()
     m_VertexShaderBlob = AssetsManager::LoadShaderImmediately("Graphics.vs.spv");
     if(!m_VertexShaderBlob || m_VertexShaderBlob->IsEmpty())
     {
-        Log::Error("Failed to load vertex shader");
+        LOG_ERROR("Failed to load vertex shader");
         return false;
     }
     m_PixelShaderBlob = AssetsManager::LoadShaderImmediately("Graphics.ps.spv");
     if(!m_PixelShaderBlob || m_PixelShaderBlob->IsEmpty())
     {
-        Log::Error("Failed to load pixel shader");
+        LOG_ERROR("Failed to load pixel shader");
         return false;
     }
 
@@ -88,7 +88,7 @@ bool GraphicsPipelineVk::CreateShader()
     VkResult result = vkCreateShaderModule(m_DeviceHandle, &shaderInfo, nullptr, &m_VertexShaderModule);
 	if(result != VK_SUCCESS)
 	{
-		Log::Error("Failed to create vertex shader");
+		LOG_ERROR("Failed to create vertex shader");
 		return false;
 	}
 
@@ -97,7 +97,7 @@ bool GraphicsPipelineVk::CreateShader()
     result = vkCreateShaderModule(m_DeviceHandle, &shaderInfo, nullptr, &m_PixelShaderModule);
 	if(result != VK_SUCCESS)
 	{
-		Log::Error("Failed to create pixel shader");
+		LOG_ERROR("Failed to create pixel shader");
 		return false;
 	}
 	
@@ -176,7 +176,7 @@ bool GraphicsPipelineVk::CreateRenderPass()
 	VkResult result = vkCreateRenderPass(m_DeviceHandle, &renderPassInfo, nullptr, &m_RenderPassHandle);
 	if(result != VK_SUCCESS)
 	{
-		Log::Error("Failed to create render pass");
+		LOG_ERROR("Failed to create render pass");
 		return false;
 	}
 	
@@ -203,7 +203,7 @@ bool GraphicsPipelineVk::CreatePipelineState()
 	VkResult result = vkCreatePipelineLayout(m_DeviceHandle, &pipelineLayoutInfo, nullptr, &m_PipelineLayout);
 	if(result != VK_SUCCESS)
 	{
-		Log::Error("Failed to create pipeline layout");
+		LOG_ERROR("Failed to create pipeline layout");
 		return false;
 	}
 
@@ -308,10 +308,12 @@ bool GraphicsPipelineVk::CreatePipelineState()
 	pipelineInfo.basePipelineHandle = VK_NULL_HANDLE;
 	pipelineInfo.basePipelineIndex = -1;
 
-	result = vkCreateGraphicsPipelines(m_DeviceHandle, VK_NULL_HANDLE, 1, &pipelineInfo, nullptr, &m_PipelineState);
-	if(result != VK_SUCCESS)
+	const bool succeeded = CreatePipelinesParallel({
+		[&]() { return vkCreateGraphicsPipelines(m_DeviceHandle, m_PipelineCacheHandle, 1, &pipelineInfo, nullptr, &m_PipelineState) == VK_SUCCESS; }
+	});
+	if(!succeeded)
 	{
-		Log::Error("Failed to create pipeline");
+		LOG_ERROR("Failed to create pipeline");
 		return false;
 	}
 	
@@ -12,7 +12,7 @@ bool GraphicsPipelineVk::CreateDepthStencilBuffer()
         , m_DepthStencilTexture
         , m_DepthStencilMemory))
     {
-        Log::Error("Failed to create depth stencil texture");
+        LOG_ERROR("Failed to create depth stencil texture");
         return false;
     }
 
@@ -21,7 +21,7 @@ bool GraphicsPipelineVk::CreateDepthStencilBuffer()
         , VK_IMAGE_ASPECT_DEPTH_BIT
         , m_Dsv))
     {
-        Log::Error("Failed to create depth stencil view");
+        LOG_ERROR("Failed to create depth stencil view");
         return false;
     }
     
@@ -69,7 +69,7 @@ bool GraphicsPipelineVk::CreateFrameBuffer()
 
         if(vkCreateFramebuffer(m_DeviceHandle, &frameBufferInfo, nullptr, &m_FrameBuffers[i]) != VK_SUCCESS)
         {
-            Log::Error("Failed to create frame buffer");
+            LOG_ERROR("Failed to create frame buffer");
             return false;
         }
     }
@@ -153,7 +153,7 @@ bool GraphicsPipelineVk::CreateResources()
         , m_CameraDataBuffer
         , m_CameraBufferMemory))
     {
-        Log::Error("Failed to create camera data buffer");
+        LOG_ERROR("Failed to create camera data buffer");
         return false;
     }
 
@@ -163,7 +163,7 @@ bool GraphicsPipelineVk::CreateResources()
         , m_LightDataBuffer
         , m_LightDataMemory))
     {
-        Log::Error("Failed to create light data buffer");
+        LOG_ERROR("Failed to create light data buffer");
         return false;
     }
 
@@ -174,7 +174,7 @@ bool GraphicsPipelineVk::CreateResources()
         , m_VerticesBuffer
         , m_VerticesBufferMemory))
     {
-        Log::Error("Failed to create vertex buffer");
+        LOG_ERROR("Failed to create vertex buffer");
         return false;
     }
 
@@ -184,7 +184,7 @@ bool GraphicsPipelineVk::CreateResources()
         , m_IndicesBuffer
         , m_IndicesBufferMemory))
     {
-        Log::Error("Failed to create index buffer");
+        LOG_ERROR("Failed to create index buffer");
         return false;
     }
 
@@ -195,7 +195,7 @@ bool GraphicsPipelineVk::CreateResources()
         , m_InstanceBuffer
         , m_InstanceBufferMemory))
     {
-        Log::Error("Failed to create instance buffer");
+        LOG_ERROR("Failed to create instance buffer");
         return false;
     }
 
@@ -206,7 +206,7 @@ bool GraphicsPipelineVk::CreateResources()
         , m_MaterialsBuffer
         , m_MaterialsBufferMemory))
     {
-        Log::Error("Failed to create materials buffer");
+        LOG_ERROR("Failed to create materials buffer");
         return false;
     }
 
@@ -222,7 +222,7 @@ bool GraphicsPipelineVk::CreateResources()
             , m_MainTextures[i]
             , m_MainTextureMemories[i]))
         {
-            Log::Error("Failed to create texture");
+            LOG_ERROR("Failed to create texture");
             return false;
         }
 
@@ -231,13 +231,13 @@ bool GraphicsPipelineVk::CreateResources()
             , VK_IMAGE_ASPECT_COLOR_BIT
             , m_MainTextureViews[i]))
         {
-            Log::Error("Failed to create image view");
+            LOG_ERROR("Failed to create image view");
             return false;
         }
 
         if(!CreateSampler(m_MainTextureSamplers[i]))
         {
-            Log::Error("Failed to create sampler");
+            LOG_ERROR("Failed to create sampler");
             return false;
         }
     }
@@ -270,7 +270,7 @@ bool GraphicsPipelineVk::CreateResources()
     descriptorSetAllocInfo.descriptorSetCount = 1;
     if(vkAllocateDescriptorSets(m_DeviceHandle, &descriptorSetAllocInfo, &m_DescriptorSetSpace0) != VK_SUCCESS)
     {
-        Log::Error("Failed to allocate descriptor set 0");
+        LOG_ERROR("Failed to allocate descriptor set 0");
         return false;
     }
     
@@ -315,7 +315,7 @@ bool GraphicsPipelineVk::CreateResources()
     descriptorSetAllocInfo1.pNext = &variableDescriptorCountAllocInfo;
     if(vkAllocateDescriptorSets(m_DeviceHandle, &descriptorSetAllocInfo1, &m_DescriptorSetSpace1) != VK_SUCCESS)
     {
-        Log::Error("Failed to allocate descriptor set 1");
+        LOG_ERROR("Failed to allocate descriptor set 1");
         return false;
     }
     
@@ -66,6 +66,8 @@ void GraphicsPipelineVk::Tick()
         vkCmdDrawIndexed(m_CmdBufferHandle, m_Mesh->GetIndicesCount(), s_InstancesCount, 0, 0, 0);
     }
     vkCmdEndRenderPass(m_CmdBufferHandle);
+    // The render pass moved the back buffer to its final layout, SaveScreenshot transitions from there
+    m_StateTracker.SetImageState(m_BackBuffers[m_CurrentIndex], VK_IMAGE_LAYOUT_PRESENT_SRC_KHR, VK_PIPELINE_STAGE_2_COLOR_ATTACHMENT_OUTPUT_BIT, VK_ACCESS_2_COLOR_ATTACHMENT_WRITE_BIT);
     EndCommandList();
     
     ExecuteCommandBuffer(m_ImageAvailableSemaphore);
@@ -4,6 +4,9 @@ bool IndirectDrawDx::Init()
 {
     if(!CreateDevice())
         return false;
+
+    if(!CreatePipelineLibrary("IndirectDrawDx"))
+        return false;
     
     if(!CreateCommandQueue())
         return false;
@@ -11,7 +14,7 @@ bool IndirectDrawDx::Init()
     if(!CreateCommandList())
         return false;
 
-    if(!CreateDescriptorHeaps())
+    if(!CreateDescriptorHeaps(m_HiZBaseSlot + GetHiZDescriptorCount()))
         return false;
 
     if(!CreateSwapChain())
@@ -31,6 +34,16 @@ bool IndirectDrawDx::Init()
     
     if(!CreateResources())
         return false;
+
+    m_StateTracker.SetStatsHook([lastStats = BarrierStats()](const BarrierStats& inStats) mutable
+    {
+        if(inStats != lastStats)
+        {
+            LOG_INFO("[D3D12] Barriers: %u requested, %u elided, %u merged, %u split, %u emitted in %u batch(es), %u stall(s) avoided"
+                , inStats.Requested, inStats.Elided, inStats.Merged, inStats.SplitBarriers, inStats.Emitted, inStats.Batches, inStats.GetStallsAvoided());
+            lastStats = inStats;
+        }
+    });
     
     return true;
 }
@@ -38,6 +51,7 @@ bool IndirectDrawDx::Init()
 void IndirectDrawDx::Shutdown()
 {
     FlushCommandQueue();
+    DestroyPipelineLibrary();
 }
 
 bool IndirectDrawDx::CreateDevice()
@@ -50,7 +64,7 @@ bool IndirectDrawDx::CreateDevice()
     if (SUCCEEDED(D3D12GetDebugInterface(IID_PPV_ARGS(&debugController))))
         debugController->EnableDebugLayer();
     else
-        Log::Warning("Failed to enable the D3D12 debug layer");
+        LOG_WARNING("Failed to enable the D3D12 debug layer");
 #endif
     
     const uint32_t factoryFlags = allowDebugging ? DXGI_CREATE_FACTORY_DEBUG : 0;
@@ -78,7 +92,7 @@ bool IndirectDrawDx::CreateDevice()
                 m_DeviceHandle = TempDevice;
                 std::wstring adapterDesc(Desc.Description);
                 std::string name(adapterDesc.begin(), adapterDesc.end());
-                Log::Info("[D3D12] Using adapter: %s", name.c_str());
+                LOG_INFO("[D3D12] Using adapter: %s", name.c_str());
                 break;
             }
         }
@@ -86,7 +100,7 @@ bool IndirectDrawDx::CreateDevice()
 
     if(m_DeviceHandle.Get() == nullptr)
     {
-        Log::Error("Failed to find a device supporting Mesh Shaders");
+        LOG_ERROR("Failed to find a device supporting Mesh Shaders");
         return false;
     }
     
@@ -16,6 +16,26 @@ struct IndirectCommand
     uint32_t Padding;
 };
 
+struct AABB
+{
+    glm::vec3 Min;
+    float     Padding0;
+    glm::vec3 Max;
+    float     Padding1;
+};
+
+struct InstanceData
+{
+    glm::mat4 LocalToWorld;
+    glm::mat4 WorldToLocal;
+    AABB      AABB;
+    uint32_t  MaterialIndex;
+    
+    // Constant buffers are 256-byte aligned. Add padding in the struct to allow multiple buffers
+    // to be array-indexed.
+    uint32_t Padding[23];
+};
+
 struct ViewFrustumCB
 {
     glm::vec4 Corners[8];
@@ -31,6 +51,7 @@ public:
     using AppBaseDx::AppBaseDx;
 
     static constexpr DXGI_FORMAT        s_DepthStencilBufferFormat = DXGI_FORMAT_D32_FLOAT;
+    static constexpr DXGI_FORMAT        s_DepthStencilResourceFormat = DXGI_FORMAT_R32_TYPELESS;  // read by the Hi-Z build
     static constexpr uint32_t           s_InstancesCount = 128;
     static constexpr uint32_t           s_ThreadGroupSize = 128;
     static constexpr uint32_t           s_TexturesCount = 5;
@@ -39,15 +60,24 @@ protected:
     bool Init() override;
     void Tick() override;
     void Shutdown() override;
+    CameraBase* GetBenchmarkCamera() override { return &m_Camera; }
 
 private:
     bool CreateDevice();
     bool CreateRootSignature();
     bool CreateShader();
     bool CreatePipelineState();
+    bool CreateCullingPassPipeline();
+    bool CreateGraphicsPassPipeline();
     bool CreateDepthStencilBuffer();
     bool CreateResources();
     void UpdateConstants();
+    // Phase 0 culls the instances visible last frame into m_ProcessedCommandsBuffer, phase 1 the newly visible ones
+    // into m_LateCommandsBuffer
+    void RecordCullingPass(uint32_t inPhase);
+    void RecordDrawPass(ID3D12Resource* inCommands);
+    // Compares the visibility of phase 1 with HiZPyramid run on the depth the GPU built its pyramid from
+    void ValidateCulling();
     
     Microsoft::WRL::ComPtr<ID3D12RootSignature>         m_CullingPassRS;
     Microsoft::WRL::ComPtr<ID3D12RootSignature>         m_IndirectDrawPassRS;
@@ -74,7 +104,13 @@ private:
     Microsoft::WRL::ComPtr<ID3D12Resource>              m_InstancesBuffer;
     Microsoft::WRL::ComPtr<ID3D12Resource>              m_IndirectCommandsBuffer;  // All indirect draw commands
     Microsoft::WRL::ComPtr<ID3D12Resource>              m_ProcessedCommandsBuffer; // remaining indirect draw commands after culling + count of remaining indirect draw commands
+    Microsoft::WRL::ComPtr<ID3D12Resource>              m_LateCommandsBuffer;      // commands of the second culling phase + their count
     Microsoft::WRL::ComPtr<ID3D12Resource>              m_ProcessedCommandsResetBuffer; // reset the processed commands buffer
+    Microsoft::WRL::ComPtr<ID3D12Resource>              m_VisibilityBuffer;        // one uint per instance, written by phase 1
+    Microsoft::WRL::ComPtr<ID3D12Resource>              m_DepthReadback;           // --validate-culling only
+    Microsoft::WRL::ComPtr<ID3D12Resource>              m_VisibilityReadback;
+    D3D12_PLACED_SUBRESOURCE_FOOTPRINT                  m_DepthReadbackFootprint{};
+    std::array<InstanceData, s_InstancesCount>          m_InstancesData;
     Microsoft::WRL::ComPtr<ID3D12Resource>              m_MaterialsBuffer;
     std::array<Microsoft::WRL::ComPtr<ID3D12Resource>, s_TexturesCount> m_MainTextures;
     size_t                                              m_CommandBufferCounterOffset{0};
@@ -84,5 +120,7 @@ private:
 
     const uint32_t m_OutputCommandsUavSlot{0};      // The slot of _OutputCommands uav in the descriptor heap
     const uint32_t m_MainTextureSrvBaseSlot{1};          // The slot of _MainTex in the descriptor heap
+    const uint32_t m_LateCommandsUavSlot{6};        // _OutputCommands of the second culling phase
+    const uint32_t m_HiZBaseSlot{7};                // AppBaseDx::GetHiZDescriptorCount() descriptors of the Hi-Z pyramid
     const uint32_t m_SamplerSlot {0};                // The slot of _MainTex_Sampler in the descriptor heap 
 };
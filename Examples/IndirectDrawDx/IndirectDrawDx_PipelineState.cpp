@@ -6,13 +6,17 @@ bool IndirectDrawDx::CreateRootSignature()
     Microsoft::WRL::ComPtr<ID3DBlob> signatureBlob;
 
     // create culling pass root signature
-    std::array<CD3DX12_ROOT_PARAMETER1, 5> cullingPassRP;
+    std::array<CD3DX12_ROOT_PARAMETER1, 8> cullingPassRP;
     cullingPassRP[0].InitAsConstantBufferView(0, 0); // _CameraData
     cullingPassRP[1].InitAsConstantBufferView(1, 0); // _ViewFrustum
     cullingPassRP[2].InitAsShaderResourceView(0, 0); // _InstancesData
     cullingPassRP[3].InitAsShaderResourceView(1, 0); // _InputCommands
     CD3DX12_DESCRIPTOR_RANGE1 range(D3D12_DESCRIPTOR_RANGE_TYPE_UAV, 1, 0);
     cullingPassRP[4].InitAsDescriptorTable(1, &range); // _OutputCommands
+    cullingPassRP[5].InitAsConstants(sizeof(HiZCullingConstants) / sizeof(uint32_t), 2, 0); // _CullingConstants
+    cullingPassRP[6].InitAsUnorderedAccessView(1, 0); // _Visibility
+    CD3DX12_DESCRIPTOR_RANGE1 hiZRange(D3D12_DESCRIPTOR_RANGE_TYPE_SRV, 1, 2, 0, D3D12_DESCRIPTOR_RANGE_FLAG_DESCRIPTORS_VOLATILE);
+    cullingPassRP[7].InitAsDescriptorTable(1, &hiZRange); // _HiZ
 
     CD3DX12_VERSIONED_ROOT_SIGNATURE_DESC cullingPassRSDesc;
     cullingPassRSDesc.Init_1_1(static_cast<uint32_t>(cullingPassRP.size()), cullingPassRP.data());
@@ -21,7 +25,7 @@ bool IndirectDrawDx::CreateRootSignature()
     if(FAILED(hr))
     {
         OUTPUT_D3D12_FAILED_RESULT(hr)
-        Log::Error("[D3D12] Failed to serialize the culling pass root signature: %s", static_cast<const char*>(errorBlob->GetBufferPointer()));
+        LOG_ERROR("[D3D12] Failed to serialize the culling pass root signature: %s", static_cast<const char*>(errorBlob->GetBufferPointer()));
         return false;
     }
 
@@ -33,7 +37,7 @@ bool IndirectDrawDx::CreateRootSignature()
     if(FAILED(hr))
     {
         OUTPUT_D3D12_FAILED_RESULT(hr)
-        Log::Error("[D3D12] Failed to create the culling pass root signature");
+        LOG_ERROR("[D3D12] Failed to create the culling pass root signature");
         return false;
     }
 
@@ -55,7 +59,7 @@ bool IndirectDrawDx::CreateRootSignature()
     if(FAILED(hr))
     {
         OUTPUT_D3D12_FAILED_RESULT(hr)
-        Log::Error("[D3D12] Failed to serialize the graphcis pass root signature: %s", static_cast<const char*>(errorBlob->GetBufferPointer()));
+        LOG_ERROR("[D3D12] Failed to serialize the graphcis pass root signature: %s", static_cast<const char*>(errorBlob->GetBufferPointer()));
         return false;
     }
 
@@ -67,7 +71,7 @@ bool IndirectDrawDx::CreateRootSignature()
     if(FAILED(hr))
     {
         OUTPUT_D3D12_FAILED_RESULT(hr)
-        Log::Error("[D3D12] Failed to create the graphics pass root signature");
+        LOG_ERROR("[D3D12] Failed to create the graphics pass root signature");
         return false;
     }
 
@@ -87,7 +91,7 @@ bool IndirectDrawDx::CreateRootSignature()
     if(FAILED(hr))
     {
         OUTPUT_D3D12_FAILED_RESULT(hr)
-        Log::Error("[D3D12] Failed to create the indirect command signature");
+        LOG_ERROR("[D3D12] Failed to create the indirect command signature");
         return false;
     }
     
@@ -99,21 +103,21 @@ bool IndirectDrawDx::CreateShader()
     m_VertexShaderBlob = AssetsManager::LoadShaderImmediately("IndirectDraw.vs.bin");
     if(!m_VertexShaderBlob || m_VertexShaderBlob->IsEmpty())
     {
-        Log::Error("Failed to load vertex shader");
+        LOG_ERROR("Failed to load vertex shader");
         return false;
     }
     
     m_PixelShaderBlob = AssetsManager::LoadShaderImmediately("IndirectDraw.ps.bin");
     if(!m_PixelShaderBlob || m_PixelShaderBlob->IsEmpty())
     {
-        Log::Error("Failed to load pixel shader");
+        LOG_ERROR("Failed to load pixel shader");
         return false;
     }
 
     m_ComputeShaderBlob = AssetsManager::LoadShaderImmediately("VisibleCullingDx.cs.bin");
     if(!m_ComputeShaderBlob || m_ComputeShaderBlob->IsEmpty())
     {
-        Log::Error("Failed to load compute shader");
+        LOG_ERROR("Failed to load compute shader");
         return false;
     }
     
@@ -122,26 +126,35 @@ bool IndirectDrawDx::CreateShader()
 
 bool IndirectDrawDx::CreatePipelineState()
 {
-    // culling pass pso
+    return CreatePipelinesParallel({
+        [this]() { return CreateCullingPassPipeline(); },
+        [this]() { return CreateGraphicsPassPipeline(); }
+    });
+}
+
+bool IndirectDrawDx::CreateCullingPassPipeline()
+{
     D3D12_COMPUTE_PIPELINE_STATE_DESC computePsoDesc{};
     computePsoDesc.pRootSignature = m_CullingPassRS.Get();
     computePsoDesc.NodeMask = GetNodeMask();
     computePsoDesc.CS = CD3DX12_SHADER_BYTECODE(m_ComputeShaderBlob->GetData(), m_ComputeShaderBlob->GetSize());
     
-    HRESULT hr = m_DeviceHandle->CreateComputePipelineState(&computePsoDesc, IID_PPV_ARGS(&m_CullingPassPSO));
-    if(FAILED(hr))
+    m_CullingPassPSO = LoadComputePipeline(L"CullingPass", computePsoDesc);
+    if(m_CullingPassPSO == nullptr)
     {
-        OUTPUT_D3D12_FAILED_RESULT(hr)
-        Log::Error("[D3D12] Failed to create the compute pipeline state");
+        LOG_ERROR("[D3D12] Failed to create the compute pipeline state");
         return false;
     }
+    return true;
+}
 
+bool IndirectDrawDx::CreateGraphicsPassPipeline()
+{
     std::array<D3D12_INPUT_ELEMENT_DESC, 3> inputElements;
     inputElements[0] = { "POSITION", 0, DXGI_FORMAT_R32G32B32_FLOAT, 0, 0, D3D12_INPUT_CLASSIFICATION_PER_VERTEX_DATA, 0 };
     inputElements[1] = { "NORMAL", 0, DXGI_FORMAT_R32G32B32_FLOAT, 0, 12, D3D12_INPUT_CLASSIFICATION_PER_VERTEX_DATA, 0 };
     inputElements[2] = { "TEXCOORD", 0, DXGI_FORMAT_R32G32_FLOAT, 0, 24, D3D12_INPUT_CLASSIFICATION_PER_VERTEX_DATA, 0 };
 
-    // graphics pass pso
     D3D12_GRAPHICS_PIPELINE_STATE_DESC graphicsPsoDesc{};
     graphicsPsoDesc.InputLayout = {inputElements.data(), static_cast<uint32_t>(inputElements.size())};
     graphicsPsoDesc.pRootSignature = m_IndirectDrawPassRS.Get();
@@ -158,13 +171,11 @@ bool IndirectDrawDx::CreatePipelineState()
     graphicsPsoDesc.PrimitiveTopologyType = D3D12_PRIMITIVE_TOPOLOGY_TYPE_TRIANGLE;
     graphicsPsoDesc.NodeMask              = GetNodeMask();
 
-    hr = m_DeviceHandle->CreateGraphicsPipelineState(&graphicsPsoDesc, IID_PPV_ARGS(&m_IndirectDrawPassPSO));
-    if(FAILED(hr))
+    m_IndirectDrawPassPSO = LoadGraphicsPipeline(L"IndirectDrawPass", graphicsPsoDesc);
+    if(m_IndirectDrawPassPSO == nullptr)
     {
-        OUTPUT_D3D12_FAILED_RESULT(hr)
-        Log::Error("[D3D12] Failed to create the graphics pipeline state");
+        LOG_ERROR("[D3D12] Failed to create the graphics pipeline state");
         return false;
     }
-    
     return true;
-}
+}
\ No newline at end of file
@@ -13,7 +13,7 @@ bool IndirectDrawDx::CreateDepthStencilBuffer()
     optClear.Format = s_DepthStencilBufferFormat;
     optClear.DepthStencil.Depth = 1.0f;
     optClear.DepthStencil.Stencil = 0;
-    m_DepthStencilBuffer = CreateTexture(s_DepthStencilBufferFormat
+    m_DepthStencilBuffer = CreateTexture(s_DepthStencilResourceFormat
         , m_Width
         , m_Height
         , D3D12_RESOURCE_STATE_DEPTH_WRITE
@@ -21,9 +21,9 @@ bool IndirectDrawDx::CreateDepthStencilBuffer()
         , D3D12_RESOURCE_FLAG_ALLOW_DEPTH_STENCIL
         , &optClear);
 
-    if(m_DeviceHandle == nullptr)
+    if(m_DepthStencilBuffer == nullptr)
     {
-        Log::Error("[D3D12] Failed to create depth stencil buffer");
+        LOG_ERROR("[D3D12] Failed to create depth stencil buffer");
         return false;
     }
 
@@ -38,26 +38,6 @@ bool IndirectDrawDx::CreateDepthStencilBuffer()
     return true;
 }
 
-struct AABB
-{
-    glm::vec3 Min;
-    float     Padding0;
-    glm::vec3 Max;
-    float     Padding1;
-};
-
-struct InstanceData
-{
-    glm::mat4 LocalToWorld;
-    glm::mat4 WorldToLocal;
-    AABB      AABB;
-    uint32_t  MaterialIndex;
-    
-    // Constant buffers are 256-byte aligned. Add padding in the struct to allow multiple buffers
-    // to be array-indexed.
-    uint32_t Padding[23];
-};
-
 struct MaterialData
 {
     glm::vec4 Color;
@@ -135,7 +115,7 @@ bool IndirectDrawDx::CreateResources()
         materialsData[i].TexIndex = static_cast<uint32_t>(s_TexturesCount * dis01(gen));
     }
     
-    std::array<InstanceData, s_InstancesCount> instancesData;
+    std::array<InstanceData, s_InstancesCount>& instancesData = m_InstancesData;
     for(uint32_t i = 0; i < s_InstancesCount; ++i)
     {
         // random generate instance data
@@ -159,7 +139,7 @@ bool IndirectDrawDx::CreateResources()
         ViewFrustumPlanes planes = CameraBase::Corners2Planes(frustum);
         bool inter = CameraBase::IsAABBInFrustum(planes, instancesData[i].AABB.Min, instancesData[i].AABB.Max);
         const char* str = inter ? "true" : "false";
-        Log::Info(str);
+        LOG_INFO("%s", str);
     }
     
     m_CameraDataBuffer = CreateBuffer(CameraData::GetAlignedByteSizes()
@@ -232,6 +212,39 @@ bool IndirectDrawDx::CreateResources()
         , D3D12_HEAP_TYPE_DEFAULT
         , D3D12_RESOURCE_FLAG_ALLOW_UNORDERED_ACCESS);
     if(m_ProcessedCommandsBuffer.Get() == nullptr) return false;
+    m_StateTracker.TrackResource(m_ProcessedCommandsBuffer.Get(), D3D12_RESOURCE_STATE_COPY_DEST);
+
+    m_LateCommandsBuffer = CreateBuffer(processedCommandsBufferBytesSize
+        , D3D12_RESOURCE_STATE_COPY_DEST
+        , D3D12_HEAP_TYPE_DEFAULT
+        , D3D12_RESOURCE_FLAG_ALLOW_UNORDERED_ACCESS);
+    if(m_LateCommandsBuffer.Get() == nullptr) return false;
+    m_StateTracker.TrackResource(m_LateCommandsBuffer.Get(), D3D12_RESOURCE_STATE_COPY_DEST);
+
+    // Nothing was visible before the first frame, its first phase draws nothing and the second one everything in view
+    const std::vector<uint32_t> visibilityData(s_InstancesCount, 0);
+    m_VisibilityBuffer = CreateBuffer(s_InstancesCount * sizeof(uint32_t)
+        , D3D12_RESOURCE_STATE_COPY_DEST
+        , D3D12_HEAP_TYPE_DEFAULT
+        , D3D12_RESOURCE_FLAG_ALLOW_UNORDERED_ACCESS);
+    if(m_VisibilityBuffer.Get() == nullptr) return false;
+    m_StateTracker.TrackResource(m_VisibilityBuffer.Get(), D3D12_RESOURCE_STATE_UNORDERED_ACCESS);
+
+    if(m_Options.ValidateCulling)
+    {
+        D3D12_RESOURCE_DESC depthDesc = m_DepthStencilBuffer->GetDesc();
+        uint64_t depthReadbackSize = 0;
+        m_DeviceHandle->GetCopyableFootprints(&depthDesc, 0, 1, 0, &m_DepthReadbackFootprint, nullptr, nullptr, &depthReadbackSize);
+        m_DepthReadback = CreateBuffer(depthReadbackSize
+            , D3D12_RESOURCE_STATE_COPY_DEST
+            , D3D12_HEAP_TYPE_READBACK
+            , D3D12_RESOURCE_FLAG_NONE);
+        m_VisibilityReadback = CreateBuffer(s_InstancesCount * sizeof(uint32_t)
+            , D3D12_RESOURCE_STATE_COPY_DEST
+            , D3D12_HEAP_TYPE_READBACK
+            , D3D12_RESOURCE_FLAG_NONE);
+        if(m_DepthReadback == nullptr || m_VisibilityReadback == nullptr) return false;
+    }
 
     m_ProcessedCommandsResetBuffer = CreateBuffer(sizeof(uint32_t)
         , D3D12_RESOURCE_STATE_GENERIC_READ
@@ -264,9 +277,10 @@ bool IndirectDrawDx::CreateResources()
     auto stagingBuffer8 = UploadTexture(m_MainTextures[3].Get(), m_Textures[3]->GetScratchImage());
     auto stagingBuffer9 = UploadTexture(m_MainTextures[4].Get(), m_Textures[4]->GetScratchImage());
     auto stagingBuffer10 = UploadBuffer(m_IndirectCommandsBuffer.Get(), indirectCommands.data(), commandBufferByteSize);
+    auto stagingBuffer11 = UploadBuffer(m_VisibilityBuffer.Get(), visibilityData.data(), visibilityData.size() * sizeof(uint32_t));
 
 
-    std::array<CD3DX12_RESOURCE_BARRIER, 10> barriers;
+    std::array<CD3DX12_RESOURCE_BARRIER, 11> barriers;
     barriers[0] = CD3DX12_RESOURCE_BARRIER::Transition(m_VerticesBuffer.Get(), D3D12_RESOURCE_STATE_COPY_DEST, D3D12_RESOURCE_STATE_ALL_SHADER_RESOURCE);
     barriers[1] = CD3DX12_RESOURCE_BARRIER::Transition(m_IndicesBuffer.Get(), D3D12_RESOURCE_STATE_COPY_DEST, D3D12_RESOURCE_STATE_ALL_SHADER_RESOURCE);
     barriers[2] = CD3DX12_RESOURCE_BARRIER::Transition(m_InstancesBuffer.Get(), D3D12_RESOURCE_STATE_COPY_DEST, D3D12_RESOURCE_STATE_ALL_SHADER_RESOURCE);
@@ -277,6 +291,7 @@ bool IndirectDrawDx::CreateResources()
     barriers[7] = CD3DX12_RESOURCE_BARRIER::Transition(m_MainTextures[3].Get(), D3D12_RESOURCE_STATE_COPY_DEST, D3D12_RESOURCE_STATE_ALL_SHADER_RESOURCE);
     barriers[8] = CD3DX12_RESOURCE_BARRIER::Transition(m_MainTextures[4].Get(), D3D12_RESOURCE_STATE_COPY_DEST, D3D12_RESOURCE_STATE_ALL_SHADER_RESOURCE);
     barriers[9] = CD3DX12_RESOURCE_BARRIER::Transition(m_IndirectCommandsBuffer.Get(), D3D12_RESOURCE_STATE_COPY_DEST, D3D12_RESOURCE_STATE_UNORDERED_ACCESS);
+    barriers[10] = CD3DX12_RESOURCE_BARRIER::Transition(m_VisibilityBuffer.Get(), D3D12_RESOURCE_STATE_COPY_DEST, D3D12_RESOURCE_STATE_UNORDERED_ACCESS);
     m_CommandList->ResourceBarrier((uint32_t)barriers.size(), barriers.data());
     
     EndCommandList();
@@ -296,6 +311,9 @@ bool IndirectDrawDx::CreateResources()
     D3D12_CPU_DESCRIPTOR_HANDLE heapHandle = m_ShaderBoundViewHeap->GetCPUDescriptorHandleForHeapStart();
     heapHandle.ptr += m_OutputCommandsUavSlot * m_DeviceHandle->GetDescriptorHandleIncrementSize(D3D12_DESCRIPTOR_HEAP_TYPE_CBV_SRV_UAV);
     m_DeviceHandle->CreateUnorderedAccessView(m_ProcessedCommandsBuffer.Get(), m_ProcessedCommandsBuffer.Get(), &uavDesc, heapHandle);
+    heapHandle = m_ShaderBoundViewHeap->GetCPUDescriptorHandleForHeapStart();
+    heapHandle.ptr += m_LateCommandsUavSlot * m_DeviceHandle->GetDescriptorHandleIncrementSize(D3D12_DESCRIPTOR_HEAP_TYPE_CBV_SRV_UAV);
+    m_DeviceHandle->CreateUnorderedAccessView(m_LateCommandsBuffer.Get(), m_LateCommandsBuffer.Get(), &uavDesc, heapHandle);
     
     // Create Texture SRVs
     for(uint32_t i = 0; i < s_TexturesCount; ++i)
@@ -334,6 +352,9 @@ bool IndirectDrawDx::CreateResources()
     heapHandle = m_SamplerHeap->GetCPUDescriptorHandleForHeapStart();
     heapHandle.ptr += m_SamplerSlot * m_DeviceHandle->GetDescriptorHandleIncrementSize(D3D12_DESCRIPTOR_HEAP_TYPE_SAMPLER);
     m_DeviceHandle->CreateSampler(&samplerDesc, heapHandle);
+
+    if(!CreateHiZPyramid(m_DepthStencilBuffer.Get(), m_HiZBaseSlot))
+        return false;
     
     return true;
 }
\ No newline at end of file
@@ -1,7 +1,9 @@
 #include "IndirectDrawDx.h"
+#include "CpuProfiler.h"
 
 void IndirectDrawDx::UpdateConstants()
 {
+    PROFILE_ZONE("UpdateConstants");
     CameraData cameraData;
     m_Camera.GetCameraData(cameraData);
     WriteBufferData(m_CameraDataBuffer.Get(), &cameraData, CameraData::GetAlignedByteSizes());
@@ -22,20 +24,12 @@ void IndirectDrawDx::UpdateConstants()
     WriteBufferData(m_LightDataBuffer.Get(), &lightData, DirectionalLightData::GetAlignedByteSizes());
 }
 
-void IndirectDrawDx::Tick()
+void IndirectDrawDx::RecordCullingPass(uint32_t inPhase)
 {
-    if(!m_IsRunning)
-    {
-        return;
-    }
-
-    BeginCommandList();
-    UpdateConstants();
+    PROFILE_ZONE(inPhase == 0 ? "CullingPass0" : "CullingPass1");
+    ID3D12Resource* outputCommands = inPhase == 0 ? m_ProcessedCommandsBuffer.Get() : m_LateCommandsBuffer.Get();
+    const uint32_t descriptorSize = m_DeviceHandle->GetDescriptorHandleIncrementSize(D3D12_DESCRIPTOR_HEAP_TYPE_CBV_SRV_UAV);
 
-    ID3D12DescriptorHeap* descriptorHeaps[] = { m_ShaderBoundViewHeap.Get(), m_SamplerHeap.Get() };
-    m_CommandList->SetDescriptorHeaps(2, descriptorHeaps);
-    
-    // Culling Compute Pass
     m_CommandList->SetPipelineState(m_CullingPassPSO.Get());
     m_CommandList->SetComputeRootSignature(m_CullingPassRS.Get());
     m_CommandList->SetComputeRootConstantBufferView(0, m_CameraDataBuffer->GetGPUVirtualAddress());
@@ -43,33 +37,126 @@ void IndirectDrawDx::Tick()
     m_CommandList->SetComputeRootShaderResourceView(2, m_InstancesBuffer->GetGPUVirtualAddress());
     m_CommandList->SetComputeRootShaderResourceView(3, m_IndirectCommandsBuffer->GetGPUVirtualAddress());
     D3D12_GPU_DESCRIPTOR_HANDLE outputCommandsUavHanle = m_ShaderBoundViewHeap->GetGPUDescriptorHandleForHeapStart();
-    outputCommandsUavHanle.ptr += m_OutputCommandsUavSlot * m_DeviceHandle->GetDescriptorHandleIncrementSize(D3D12_DESCRIPTOR_HEAP_TYPE_CBV_SRV_UAV);
+    outputCommandsUavHanle.ptr += (inPhase == 0 ? m_OutputCommandsUavSlot : m_LateCommandsUavSlot) * descriptorSize;
     m_CommandList->SetComputeRootDescriptorTable(4, outputCommandsUavHanle);
-    
-    // reset the counter in m_ProcessedCommandsBuffer
-    m_CommandList->CopyBufferRegion(m_ProcessedCommandsBuffer.Get()
-        , sizeof(IndirectCommand) * s_InstancesCount
-        , m_ProcessedCommandsResetBuffer.Get()
+    const HiZCullingConstants constants = GetHiZCullingConstants(inPhase, s_InstancesCount);
+    m_CommandList->SetComputeRoot32BitConstants(5, sizeof(HiZCullingConstants) / sizeof(uint32_t), &constants, 0);
+    m_CommandList->SetComputeRootUnorderedAccessView(6, m_VisibilityBuffer->GetGPUVirtualAddress());
+    // Phase 0 does not read the pyramid, it still needs a valid descriptor
+    m_CommandList->SetComputeRootDescriptorTable(7, GetHiZPyramidSrv());
+
+    m_StateTracker.Transition(outputCommands, D3D12_RESOURCE_STATE_UNORDERED_ACCESS);
+    m_StateTracker.UAVBarrier(m_VisibilityBuffer.Get());
+    m_StateTracker.Flush(m_CommandList.Get());
+    m_CommandList->Dispatch((s_InstancesCount + s_ThreadGroupSize - 1) / s_ThreadGroupSize, 1, 1);
+    m_StateTracker.Transition(outputCommands, D3D12_RESOURCE_STATE_INDIRECT_ARGUMENT);
+}
+
+void IndirectDrawDx::RecordDrawPass(ID3D12Resource* inCommands)
+{
+    m_CommandList->SetGraphicsRootSignature(m_IndirectDrawPassRS.Get());
+    m_CommandList->SetPipelineState(m_IndirectDrawPassPSO.Get());
+
+    m_CommandList->SetGraphicsRootConstantBufferView(0, m_CameraDataBuffer->GetGPUVirtualAddress());
+    m_CommandList->SetGraphicsRootConstantBufferView(1, m_LightDataBuffer->GetGPUVirtualAddress());
+
+    D3D12_GPU_DESCRIPTOR_HANDLE mainTextureSrvHandle = m_ShaderBoundViewHeap->GetGPUDescriptorHandleForHeapStart();
+    mainTextureSrvHandle.ptr += m_MainTextureSrvBaseSlot * m_DeviceHandle->GetDescriptorHandleIncrementSize(D3D12_DESCRIPTOR_HEAP_TYPE_CBV_SRV_UAV);
+    m_CommandList->SetGraphicsRootDescriptorTable(3, mainTextureSrvHandle);
+    m_CommandList->SetGraphicsRootShaderResourceView(4, m_MaterialsBuffer->GetGPUVirtualAddress());
+
+    D3D12_GPU_DESCRIPTOR_HANDLE samplerHandle = m_SamplerHeap->GetGPUDescriptorHandleForHeapStart();
+    samplerHandle.ptr += m_SamplerSlot * m_DeviceHandle->GetDescriptorHandleIncrementSize(D3D12_DESCRIPTOR_HEAP_TYPE_SAMPLER);
+    m_CommandList->SetGraphicsRootDescriptorTable(5, samplerHandle);
+
+    m_CommandList->IASetPrimitiveTopology(D3D_PRIMITIVE_TOPOLOGY_TRIANGLELIST);
+    m_CommandList->IASetVertexBuffers(0, 1, &m_VertexBufferView);
+    m_CommandList->IASetIndexBuffer(&m_IndexBufferView);
+
+    m_CommandList->ExecuteIndirect(m_IndirectCommandSignature.Get()
+        , s_InstancesCount
+        , inCommands
         , 0
-        , sizeof(uint32_t));
+        , inCommands
+        , m_CommandBufferCounterOffset);
+}
+
+void IndirectDrawDx::ValidateCulling()
+{
+    PROFILE_ZONE("ValidateCulling");
+    const D3D12_RESOURCE_DESC depthDesc = m_DepthStencilBuffer->GetDesc();
+    const uint32_t width = static_cast<uint32_t>(depthDesc.Width);
+    const uint32_t height = depthDesc.Height;
+
+    HiZPyramid pyramid;
+    float* depth = nullptr;
+    m_DepthReadback->Map(0, nullptr, reinterpret_cast<void**>(&depth));
+    pyramid.Build(depth, width, height, m_DepthReadbackFootprint.Footprint.RowPitch / sizeof(float));
+    m_DepthReadback->Unmap(0, nullptr);
+
+    uint32_t* gpuVisibility = nullptr;
+    m_VisibilityReadback->Map(0, nullptr, reinterpret_cast<void**>(&gpuVisibility));
+
+    CameraData cameraData;
+    m_Camera.GetCameraData(cameraData);
+    ViewFrustum frustumWS;
+    m_Camera.GetViewFrustumWorldSpace(frustumWS);
+    uint32_t visibleCount = 0;
+    uint32_t mismatchCount = 0;
+    for(uint32_t i = 0; i < s_InstancesCount; ++i)
+    {
+        const InstanceData& instance = m_InstancesData[i];
+        ViewFrustum frustumLS;
+        for(uint32_t j = 0; j < 8; ++j)
+            frustumLS.Corners[j] = glm::vec3(instance.WorldToLocal * glm::vec4(frustumWS.Corners[j], 1.0f));
+        const bool visible = CameraBase::IsAABBInFrustum(CameraBase::Corners2Planes(frustumLS), instance.AABB.Min, instance.AABB.Max)
+            && pyramid.IsVisible(cameraData.ViewProjection * instance.LocalToWorld, instance.AABB.Min, instance.AABB.Max);
+        visibleCount += visible ? 1 : 0;
+        mismatchCount += visible != (gpuVisibility[i] != 0) ? 1 : 0;
+    }
+    m_VisibilityReadback->Unmap(0, nullptr);
 
-    D3D12_RESOURCE_BARRIER preCullingBarrier = CD3DX12_RESOURCE_BARRIER::Transition(m_ProcessedCommandsBuffer.Get()
-        , D3D12_RESOURCE_STATE_COPY_DEST
-        , D3D12_RESOURCE_STATE_UNORDERED_ACCESS);
+    if(mismatchCount > 0)
+        LOG_WARNING("[Culling] %u of %u instances differ from the CPU reference, %u visible on the CPU", mismatchCount, s_InstancesCount, visibleCount);
+    else
+        LOG_INFO("[Culling] GPU matches the CPU reference, %u of %u instances visible", visibleCount, s_InstancesCount);
+}
 
-    m_CommandList->ResourceBarrier(1, &preCullingBarrier);
-    m_CommandList->Dispatch(s_InstancesCount / s_ThreadGroupSize, 1, 1);
+void IndirectDrawDx::Tick()
+{
+    if(!m_IsRunning)
+    {
+        return;
+    }
 
-    D3D12_RESOURCE_BARRIER afterCullingBarrier = CD3DX12_RESOURCE_BARRIER::Transition(m_ProcessedCommandsBuffer.Get()
-        , D3D12_RESOURCE_STATE_UNORDERED_ACCESS
-        , D3D12_RESOURCE_STATE_INDIRECT_ARGUMENT);
+    // Covers the submit as well, the GPU wait shows up as its own zone
+    PROFILE_ZONE("RecordCommands");
+    BeginCommandList();
+    UpdateConstants();
 
-    m_CommandList->ResourceBarrier(1, &afterCullingBarrier);
+    // The back buffer is not needed until the graphics pass, let its transition overlap with the culling pass
+    m_StateTracker.BeginSplitTransition(m_BackBuffers[m_CurrentIndex].Get(), D3D12_RESOURCE_STATE_RENDER_TARGET);
+    m_StateTracker.Flush(m_CommandList.Get());
 
-    // Graphics Pass
-    D3D12_RESOURCE_BARRIER preBarriers;
-    preBarriers = CD3DX12_RESOURCE_BARRIER::Transition(m_BackBuffers[m_CurrentIndex].Get(), D3D12_RESOURCE_STATE_PRESENT, D3D12_RESOURCE_STATE_RENDER_TARGET);
-    m_CommandList->ResourceBarrier(1, &preBarriers);
+    ID3D12DescriptorHeap* descriptorHeaps[] = { m_ShaderBoundViewHeap.Get(), m_SamplerHeap.Get() };
+    m_CommandList->SetDescriptorHeaps(2, descriptorHeaps);
+    
+    // reset the counters in m_ProcessedCommandsBuffer and m_LateCommandsBuffer
+    for(ID3D12Resource* commands : {m_ProcessedCommandsBuffer.Get(), m_LateCommandsBuffer.Get()})
+    {
+        m_CommandList->CopyBufferRegion(commands
+            , m_CommandBufferCounterOffset
+            , m_ProcessedCommandsResetBuffer.Get()
+            , 0
+            , sizeof(uint32_t));
+    }
+
+    // First phase, the instances visible last frame
+    RecordCullingPass(0);
+
+    // Graphics Pass, the indirect arguments and the end of the back buffer split barrier go out in one batch
+    m_StateTracker.Transition(m_BackBuffers[m_CurrentIndex].Get(), D3D12_RESOURCE_STATE_RENDER_TARGET);
+    m_StateTracker.Flush(m_CommandList.Get());
     D3D12_VIEWPORT screenViewport;
     screenViewport.TopLeftX = 0;
     screenViewport.TopLeftY = 0;
@@ -89,42 +176,43 @@ void IndirectDrawDx::Tick()
     const float clearColor[] = { 0.0f, 0.2f, 0.4f, 1.0f };
     m_CommandList->ClearRenderTargetView(rtvHandle[0], clearColor, 0, nullptr);
     m_CommandList->ClearDepthStencilView(dsvHandle, D3D12_CLEAR_FLAG_DEPTH, 1.0f, 0, 0, nullptr);
+    RecordDrawPass(m_ProcessedCommandsBuffer.Get());
 
-    m_CommandList->SetGraphicsRootSignature(m_IndirectDrawPassRS.Get());
-    m_CommandList->SetPipelineState(m_IndirectDrawPassPSO.Get());
-
-    m_CommandList->SetGraphicsRootConstantBufferView(0, m_CameraDataBuffer->GetGPUVirtualAddress());
-    m_CommandList->SetGraphicsRootConstantBufferView(1, m_LightDataBuffer->GetGPUVirtualAddress());
-
-    D3D12_GPU_DESCRIPTOR_HANDLE mainTextureSrvHandle = m_ShaderBoundViewHeap->GetGPUDescriptorHandleForHeapStart();
-    mainTextureSrvHandle.ptr += m_MainTextureSrvBaseSlot * m_DeviceHandle->GetDescriptorHandleIncrementSize(D3D12_DESCRIPTOR_HEAP_TYPE_CBV_SRV_UAV);
-    m_CommandList->SetGraphicsRootDescriptorTable(3, mainTextureSrvHandle);
-    m_CommandList->SetGraphicsRootShaderResourceView(4, m_MaterialsBuffer->GetGPUVirtualAddress());
-
-    D3D12_GPU_DESCRIPTOR_HANDLE samplerHandle = m_SamplerHeap->GetGPUDescriptorHandleForHeapStart();
-    samplerHandle.ptr += m_SamplerSlot * m_DeviceHandle->GetDescriptorHandleIncrementSize(D3D12_DESCRIPTOR_HEAP_TYPE_SAMPLER);
-    m_CommandList->SetGraphicsRootDescriptorTable(5, samplerHandle);
-
-    m_CommandList->IASetPrimitiveTopology(D3D_PRIMITIVE_TOPOLOGY_TRIANGLELIST);
-    m_CommandList->IASetVertexBuffers(0, 1, &m_VertexBufferView);
-    m_CommandList->IASetIndexBuffer(&m_IndexBufferView);
+    // Second phase, tests everything against the depth of the first one and draws what it missed
+    BuildHiZPyramid();
+    if(m_Options.ValidateCulling)
+    {
+        m_StateTracker.Transition(m_DepthStencilBuffer.Get(), D3D12_RESOURCE_STATE_COPY_SOURCE);
+        m_StateTracker.Flush(m_CommandList.Get());
+        CD3DX12_TEXTURE_COPY_LOCATION dst(m_DepthReadback.Get(), m_DepthReadbackFootprint);
+        CD3DX12_TEXTURE_COPY_LOCATION src(m_DepthStencilBuffer.Get(), 0);
+        m_CommandList->CopyTextureRegion(&dst, 0, 0, 0, &src, nullptr);
+        m_StateTracker.Transition(m_DepthStencilBuffer.Get(), D3D12_RESOURCE_STATE_DEPTH_WRITE);
+    }
+    RecordCullingPass(1);
+    m_StateTracker.Flush(m_CommandList.Get());
+    m_CommandList->OMSetRenderTargets(1, rtvHandle, false, &dsvHandle);
+    RecordDrawPass(m_LateCommandsBuffer.Get());
 
-    m_CommandList->ExecuteIndirect(m_IndirectCommandSignature.Get()
-        , s_InstancesCount
-        , m_ProcessedCommandsBuffer.Get()
-        , 0
-        , m_ProcessedCommandsBuffer.Get()
-        , m_CommandBufferCounterOffset);
+    if(m_Options.ValidateCulling)
+    {
+        m_StateTracker.Transition(m_VisibilityBuffer.Get(), D3D12_RESOURCE_STATE_COPY_SOURCE);
+        m_StateTracker.Flush(m_CommandList.Get());
+        m_CommandList->CopyResource(m_VisibilityReadback.Get(), m_VisibilityBuffer.Get());
+        m_StateTracker.Transition(m_VisibilityBuffer.Get(), D3D12_RESOURCE_STATE_UNORDERED_ACCESS);
+    }
     
-    D3D12_RESOURCE_BARRIER postBarriers[2];
-    postBarriers[0] = CD3DX12_RESOURCE_BARRIER::Transition(m_BackBuffers[m_CurrentIndex].Get(), D3D12_RESOURCE_STATE_RENDER_TARGET, D3D12_RESOURCE_STATE_PRESENT);
-    postBarriers[1] = CD3DX12_RESOURCE_BARRIER::Transition(m_ProcessedCommandsBuffer.Get(), D3D12_RESOURCE_STATE_INDIRECT_ARGUMENT, D3D12_RESOURCE_STATE_COPY_DEST);
-    m_CommandList->ResourceBarrier(2, postBarriers);
+    m_StateTracker.Transition(m_BackBuffers[m_CurrentIndex].Get(), D3D12_RESOURCE_STATE_PRESENT);
+    m_StateTracker.Transition(m_ProcessedCommandsBuffer.Get(), D3D12_RESOURCE_STATE_COPY_DEST);
+    m_StateTracker.Transition(m_LateCommandsBuffer.Get(), D3D12_RESOURCE_STATE_COPY_DEST);
     EndCommandList();    
 
     ID3D12CommandList* commandLists[] = {m_CommandList.Get()};
     m_CommandQueueHandle->ExecuteCommandLists(1, commandLists);
     FlushCommandQueue();
+    if(m_Options.ValidateCulling)
+        ValidateCulling();
     m_SwapChainHandle->Present(0, 0);
+    m_StateTracker.EndFrame();
     m_CurrentIndex = (m_CurrentIndex + 1) % s_BackBufferCount;
 }
@@ -6,9 +6,8 @@ static const std::vector<const char*> s_ValidationLayerNames = {
     "VK_LAYER_KHRONOS_validation"
 };
 
+// The surface extensions are added by AddSurfaceExtensions unless running headless
 static const std::vector<const char*> s_InstanceExtensions = {
-    VK_KHR_SURFACE_EXTENSION_NAME,
-    VK_KHR_WIN32_SURFACE_EXTENSION_NAME,
     VK_KHR_GET_PHYSICAL_DEVICE_PROPERTIES_2_EXTENSION_NAME,
 #if _DEBUG || DEBUG
     VK_EXT_DEBUG_UTILS_EXTENSION_NAME
@@ -27,27 +26,27 @@ static VKAPI_ATTR VkBool32 VKAPI_CALL DebugCallback(VkDebugUtilsMessageSeverityF
 {
     if(messageSeverity & VK_DEBUG_UTILS_MESSAGE_SEVERITY_ERROR_BIT_EXT)
     {
-        Log::Error(TEXT("Validation layer: %s"), pCallbackData->pMessage);
+        LOG_ERROR(TEXT("Validation layer: %s"), pCallbackData->pMessage);
         return VK_FALSE;
     }
     else if(messageSeverity & VK_DEBUG_UTILS_MESSAGE_SEVERITY_WARNING_BIT_EXT)
     {
-        Log::Warning(TEXT("Validation layer: %s"), pCallbackData->pMessage);
+        LOG_WARNING(TEXT("Validation layer: %s"), pCallbackData->pMessage);
         return VK_SUCCESS;
     }
     else
     {
-        Log::Info(TEXT("Validation layer: %s"), pCallbackData->pMessage);
+        LOG_INFO(TEXT("Validation layer: %s"), pCallbackData->pMessage);
         return VK_SUCCESS;
     }
 }
 
 static void LogGpuProperties(const VkPhysicalDeviceProperties& inProperties)
 {
-    Log::Info("----------------------------------------------------------------");
-    Log::Info("GPU Name: %s", inProperties.deviceName);
-    Log::Info("API Version: %d.%d.%d", VK_VERSION_MAJOR(inProperties.apiVersion), VK_VERSION_MINOR(inProperties.apiVersion), VK_VERSION_PATCH(inProperties.apiVersion));
-    Log::Info("----------------------------------------------------------------");
+    LOG_INFO("----------------------------------------------------------------");
+    LOG_INFO("GPU Name: %s", inProperties.deviceName);
+    LOG_INFO("API Version: %d.%d.%d", VK_VERSION_MAJOR(inProperties.apiVersion), VK_VERSION_MINOR(inProperties.apiVersion), VK_VERSION_PATCH(inProperties.apiVersion));
+    LOG_INFO("----------------------------------------------------------------");
 }
 
 bool IndirectDrawVk::Init()
@@ -55,15 +54,27 @@ bool IndirectDrawVk::Init()
     if(!CreateDevice())
         return false;
 
+    if(!CreatePipelineCache("IndirectDrawVk"))
+        return false;
+
     if(!CreateFence())
         return false;
 
     if(!CreateCommandList())
         return false;
 
+    if(!CreateAsyncCompute())
+        return false;
+
+    if(!CreateGpuProfiler())
+        return false;
+
     if(!CreateDescriptorSetPool())
         return false;
 
+    if(!CreateBindlessDescriptorSet(s_MaxBindlessTextures))
+        return false;
+
     if(!CreateSwapChain())
         return false;
     
@@ -79,7 +90,7 @@ bool IndirectDrawVk::Init()
     if(!CreatePipelineState())
         return false;
 
-    if(!CreateDepthStencilBuffer())
+    if(!CreateRenderGraph())
         return false;
 
     if(!CreateFrameBuffer())
@@ -93,24 +104,39 @@ bool IndirectDrawVk::Init()
 
     if(!CreateDescriptorSet())
         return false;
+
+    m_StateTracker.SetStatsHook([lastStats = BarrierStats()](const BarrierStats& inStats) mutable
+    {
+        if(inStats != lastStats)
+        {
+            LOG_INFO("[Vulkan] Barriers: %u requested, %u elided, %u merged, %u emitted in %u batch(es), %u stall(s) avoided"
+                , inStats.Requested, inStats.Elided, inStats.Merged, inStats.Emitted, inStats.Batches, inStats.GetStallsAvoided());
+            lastStats = inStats;
+        }
+    });
     
     return true;    
 }
 
 void IndirectDrawVk::Shutdown()
 {
-    DestroyDescriptorSet();
+    // The culling of the next frame may still be running on the compute queue
+    if(IsAsyncComputeEnabled())
+        vkDeviceWaitIdle(m_DeviceHandle);
+
     DestroyResources();
     DestroyFrameBuffer();
-    DestroyDepthStencilBuffer();
+    DestroyRenderGraphResources();
     DestroyPipelineState();
     DestroyRenderPass();
     DestroyShader();
-    DestroyDescriptorLayout();
     DestroySwapChain();
     DestroyDescriptorSetPool();
+    DestroyAsyncCompute();
+    DestroyGpuProfiler();
     DestroyCommandList();
     DestroyFence();
+    DestroyPipelineCache();
     DestroyDevice();
 }
 
@@ -126,8 +152,10 @@ bool IndirectDrawVk::CreateDevice()
     VkInstanceCreateInfo insCreateInfo{};
     insCreateInfo.sType = VK_STRUCTURE_TYPE_INSTANCE_CREATE_INFO;
     insCreateInfo.pApplicationInfo = &appInfo;
-    insCreateInfo.enabledExtensionCount = static_cast<uint32_t>(s_InstanceExtensions.size());
-    insCreateInfo.ppEnabledExtensionNames = s_InstanceExtensions.data();
+    std::vector<const char*> instanceExtensions = s_InstanceExtensions;
+    AddSurfaceExtensions(instanceExtensions);
+    insCreateInfo.enabledExtensionCount = static_cast<uint32_t>(instanceExtensions.size());
+    insCreateInfo.ppEnabledExtensionNames = instanceExtensions.data();
 
 #if _DEBUG || DEBUG
     VkDebugUtilsMessengerCreateInfoEXT debugCreateInfo{};
@@ -147,7 +175,7 @@ bool IndirectDrawVk::CreateDevice()
     VkResult result = vkCreateInstance(&insCreateInfo, nullptr, &m_InstanceHandle);
     if(result != VK_SUCCESS)
     {
-        Log::Error("Failed to create Vulkan instance");
+        LOG_ERROR("Failed to create Vulkan instance");
         return false;
     }
 
@@ -157,7 +185,7 @@ bool IndirectDrawVk::CreateDevice()
     {
         result = vkCreateDebugUtilsMessengerEXT(m_InstanceHandle, &debugCreateInfo, nullptr, &m_DebugMessenger);
         if(result != VK_SUCCESS)
-            Log::Warning("Failed to create debug messenger");
+            LOG_WARNING("Failed to create debug messenger");
     }
 #endif
 
@@ -166,7 +194,7 @@ bool IndirectDrawVk::CreateDevice()
     vkEnumeratePhysicalDevices(m_InstanceHandle, &gpuCount, nullptr);
     if( gpuCount == 0)
     {
-        Log::Error("No GPU found");
+        LOG_ERROR("No GPU found");
         return false;
     }
     
@@ -182,14 +210,22 @@ bool IndirectDrawVk::CreateDevice()
         {
             m_GpuHandle = tempPhysicalDevices[i];
             m_GpuProperties = gpuProperties;
-            Log::Info("[Vulkan] Using gpu: %s", gpuProperties.deviceName);
+            LOG_INFO("[Vulkan] Using gpu: %s", gpuProperties.deviceName);
             break;
         }
     }
 
+    // Headless runs also accept integrated and CPU devices, e.g. lavapipe or SwiftShader on a Linux build machine
+    if(m_GpuHandle == VK_NULL_HANDLE && IsHeadless())
+    {
+        m_GpuHandle = tempPhysicalDevices[0];
+        vkGetPhysicalDeviceProperties(m_GpuHandle, &m_GpuProperties);
+        LOG_INFO("[Vulkan] Using gpu: %s", m_GpuProperties.deviceName);
+    }
+
     if(m_GpuHandle == VK_NULL_HANDLE)
     {
-        Log::Error("Failed to find a discrete GPU");
+        LOG_ERROR("Failed to find a discrete GPU");
         return false;
     }
 
@@ -203,7 +239,9 @@ bool IndirectDrawVk::CreateDevice()
     vkEnumerateDeviceExtensionProperties(m_GpuHandle, nullptr, &extensionCount, extensions.data());
     for(const auto& extension : extensions)
     {
-        Log::Info("[Vulkan] GPU supports extension: %s", extension.extensionName);
+        LOG_INFO("[Vulkan] GPU supports extension: %s", extension.extensionName);
+        if(strcmp(extension.extensionName, VK_KHR_DRAW_INDIRECT_COUNT_EXTENSION_NAME) == 0)
+            m_DrawIndirectCountSupported = true;
     }
 
     // Enumerate all layers
@@ -213,16 +251,13 @@ bool IndirectDrawVk::CreateDevice()
     vkEnumerateDeviceLayerProperties(m_GpuHandle, &layerCount, layers.data());
     for(const auto& layer : layers)
     {
-        Log::Info("[Vulkan] GPU supports layer: %s", layer.layerName);
+        LOG_INFO("[Vulkan] GPU supports layer: %s", layer.layerName);
     }
 
-    // Create Win23 surface
-    VkWin32SurfaceCreateInfoKHR surfaceCreateInfo{};
-    surfaceCreateInfo.sType = VK_STRUCTURE_TYPE_WIN32_SURFACE_CREATE_INFO_KHR;
-    surfaceCreateInfo.hwnd = m_hWnd;
-    surfaceCreateInfo.hinstance = m_hInstance;
-
-    result = vkCreateWin32SurfaceKHR(m_InstanceHandle, &surfaceCreateInfo, nullptr, &m_SurfaceHandle);
+    if(!CreateSurface())
+    {
+        return false;
+    }
 
     // Enumerate all queue families
     uint32_t queueFamilyCount = 0;
@@ -237,9 +272,7 @@ bool IndirectDrawVk::CreateDevice()
         if((queueFamilies[i].queueFlags & queueFlags) > 0)
         {
             // Check if the queue family supports present
-            VkBool32 presentSupport = false;
-            vkGetPhysicalDeviceSurfaceSupportKHR(m_GpuHandle, i, m_SurfaceHandle, &presentSupport);
-            if(presentSupport)
+            if(IsPresentSupported(i))
             {
                 m_QueueIndex = static_cast<int>(i);
                 break;
@@ -249,17 +282,14 @@ bool IndirectDrawVk::CreateDevice()
 
     if(m_QueueIndex < 0)
     {
-        Log::Error("Failed to find a queue family that supports present, graphics, copy and compute");
+        LOG_ERROR("Failed to find a queue family that supports present, graphics, copy and compute");
         return false;
     }
 
-    float queuePriority[1] {1.0f};
-    
-    VkDeviceQueueCreateInfo queueCreateInfo{};
-    queueCreateInfo.sType = VK_STRUCTURE_TYPE_DEVICE_QUEUE_CREATE_INFO;
-    queueCreateInfo.queueFamilyIndex = m_QueueIndex;
-    queueCreateInfo.queueCount = 1;
-    queueCreateInfo.pQueuePriorities = queuePriority;
+    // The culling pass runs on a dedicated compute family when there is one
+    FindAsyncQueueFamilies(queueFamilies);
+    std::vector<VkDeviceQueueCreateInfo> queueCreateInfos;
+    GetQueueCreateInfos(queueCreateInfos);
 
     // Enable descriptor indexing feature
     VkPhysicalDeviceDescriptorIndexingFeaturesEXT physicalDeviceDescriptorIndexingFeatures{};
@@ -270,6 +300,29 @@ bool IndirectDrawVk::CreateDevice()
     physicalDeviceDescriptorIndexingFeatures.shaderUniformBufferArrayNonUniformIndexing = VK_TRUE;
     physicalDeviceDescriptorIndexingFeatures.runtimeDescriptorArray = VK_TRUE;
     physicalDeviceDescriptorIndexingFeatures.descriptorBindingVariableDescriptorCount = VK_TRUE;
+    physicalDeviceDescriptorIndexingFeatures.descriptorBindingPartiallyBound = VK_TRUE;
+    physicalDeviceDescriptorIndexingFeatures.descriptorBindingSampledImageUpdateAfterBind = VK_TRUE;
+
+    // Enable synchronization2 for the barrier batches of the state tracker and timeline semaphores for async compute
+    // when the device supports them
+    VkPhysicalDeviceTimelineSemaphoreFeatures timelineSemaphoreFeatures{};
+    timelineSemaphoreFeatures.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_TIMELINE_SEMAPHORE_FEATURES;
+    VkPhysicalDeviceSynchronization2Features synchronization2Features{};
+    synchronization2Features.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_SYNCHRONIZATION_2_FEATURES;
+    synchronization2Features.pNext = &timelineSemaphoreFeatures;
+    VkPhysicalDeviceFeatures2 supportedFeatures2{};
+    supportedFeatures2.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_FEATURES_2;
+    supportedFeatures2.pNext = &synchronization2Features;
+    vkGetPhysicalDeviceFeatures2(m_GpuHandle, &supportedFeatures2);
+    const bool synchronization2 = synchronization2Features.synchronization2 == VK_TRUE && m_GpuProperties.apiVersion >= VK_API_VERSION_1_3;
+    m_TimelineSemaphoreSupported = timelineSemaphoreFeatures.timelineSemaphore == VK_TRUE && m_GpuProperties.apiVersion >= VK_API_VERSION_1_2;
+    timelineSemaphoreFeatures.pNext = nullptr;
+    synchronization2Features.pNext = m_TimelineSemaphoreSupported ? &timelineSemaphoreFeatures : nullptr;
+    if(synchronization2)
+        physicalDeviceDescriptorIndexingFeatures.pNext = &synchronization2Features;
+    else if(m_TimelineSemaphoreSupported)
+        physicalDeviceDescriptorIndexingFeatures.pNext = &timelineSemaphoreFeatures;
+    m_StateTracker.SetSynchronization2(synchronization2);
 
     // Create logical device
     VkPhysicalDeviceFeatures2 deviceFeatures2{};
@@ -279,12 +332,17 @@ bool IndirectDrawVk::CreateDevice()
     
     VkDeviceCreateInfo deviceCreateInfo{};
     deviceCreateInfo.sType = VK_STRUCTURE_TYPE_DEVICE_CREATE_INFO;
-    deviceCreateInfo.pQueueCreateInfos = &queueCreateInfo;
-    deviceCreateInfo.queueCreateInfoCount = 1;
+    deviceCreateInfo.pQueueCreateInfos = queueCreateInfos.data();
+    deviceCreateInfo.queueCreateInfoCount = static_cast<uint32_t>(queueCreateInfos.size());
     deviceCreateInfo.pEnabledFeatures = nullptr;
     deviceCreateInfo.pNext = &deviceFeatures2;
-    deviceCreateInfo.enabledExtensionCount = static_cast<uint32_t>(s_DeviceExtensions.size());
-    deviceCreateInfo.ppEnabledExtensionNames = s_DeviceExtensions.data();
+    std::vector<const char*> deviceExtensions = s_DeviceExtensions;
+    if(m_DrawIndirectCountSupported)
+        deviceExtensions.push_back(VK_KHR_DRAW_INDIRECT_COUNT_EXTENSION_NAME);
+    else
+        LOG_WARNING("[Vulkan] VK_KHR_draw_indirect_count is not supported, every bucket is drawn and the empty ones draw nothing");
+    deviceCreateInfo.enabledExtensionCount = static_cast<uint32_t>(deviceExtensions.size());
+    deviceCreateInfo.ppEnabledExtensionNames = deviceExtensions.data();
     deviceCreateInfo.enabledLayerCount = 0;
 
 #if _DEBUG || DEBUG
@@ -295,11 +353,22 @@ bool IndirectDrawVk::CreateDevice()
     result = vkCreateDevice(m_GpuHandle, &deviceCreateInfo, nullptr, &m_DeviceHandle);
     if(result != VK_SUCCESS)
     {
-        Log::Error("Failed to create logical device");
+        LOG_ERROR("Failed to create logical device");
         return false;
     }
 
     vkGetDeviceQueue(m_DeviceHandle, m_QueueIndex, 0, &m_QueueHandle);
+    GetAsyncQueues();
+
+    if(m_DrawIndirectCountSupported)
+    {
+        vkCmdDrawIndexedIndirectCountKHR = reinterpret_cast<PFN_vkCmdDrawIndexedIndirectCountKHR>(vkGetDeviceProcAddr(m_DeviceHandle, "vkCmdDrawIndexedIndirectCountKHR"));
+        if(vkCmdDrawIndexedIndirectCountKHR == nullptr)
+        {
+            LOG_ERROR("Failed to load vkCmdDrawIndexedIndirectCountKHR");
+            return false;
+        }
+    }
     
     return true;
 }
@@ -5,6 +5,8 @@
 #include "Camera.h"
 #include "Light.h"
 #include "AssetsManager.h"
+#include "GeometryPool.h"
+#include "DrawSort.h"
 #include <array>
 
 struct InstanceData
@@ -12,8 +14,8 @@ struct InstanceData
     glm::mat4 LocalToWorld;
     glm::mat4 WorldToLocal;
     uint32_t MaterialIndex;
-    uint32_t Padding0;
-    uint32_t Padding1;
+    uint32_t DrawBucket;    // index of the indirect command of its (mesh, pipeline) pair, of its finest LOD
+    uint32_t LodCount;      // buckets from DrawBucket on, one per LOD of the mesh
     uint32_t Padding2;
 };
 
@@ -61,38 +63,63 @@ public:
     static constexpr uint32_t s_InstanceCountX = 8, s_InstanceCountY = 8, s_InstanceCountZ = 8;
     static constexpr uint32_t s_InstancesCount = s_InstanceCountX * s_InstanceCountY * s_InstanceCountZ;
     static constexpr uint32_t s_ThreadGroupSize = 128;
-    static constexpr uint32_t s_MaterialCount = 100;
+    // The sphere of the assets and a box around it, both suballocated from the geometry pool
+    static constexpr uint32_t s_MeshCount = 2;
+    static constexpr uint32_t s_GeometryPoolVertexCapacity = 256 * 1024;
+    static constexpr uint32_t s_GeometryPoolIndexCapacity = 1024 * 1024;
+    // The sphere is simplified into LODs keeping half of the triangles each, the box has a single one
+    static constexpr uint32_t s_SphereLodCount = 5;
+    static constexpr float s_LodRatio = 0.5f;
+    // Culling picks the coarsest LOD whose error projects to at most this many pixels
+    static constexpr float s_LodPixelError = 1.0f;
+    // Async culling runs one frame ahead with the camera of the frame before, its frustum is widened by this many
+    // degrees so what turns into view during that frame is not popped in late
+    static constexpr float s_AsyncCullingFovMargin = 10.0f;
+    // One instanced draw per (mesh, LOD, pipeline), every mesh is drawn by the same pipeline. Culling handles up to
+    // MAX_DRAW_BUCKETS of VisibleCullingVk.cs.hlsl.
+    static constexpr uint32_t s_DrawBucketCount = s_SphereLodCount + 1;
+    static_assert(s_DrawBucketCount <= 16, "VisibleCullingVk.cs.hlsl counts at most MAX_DRAW_BUCKETS buckets");
+    // Each LOD bucket has room for every instance of its mesh
+    static constexpr uint32_t s_VisibleInstanceCapacity = s_InstancesCount * s_SphereLodCount;
+    static constexpr uint32_t s_MaterialCount = s_InstancesCount; // not bounded by the texture count, materials index the bindless table
+    static constexpr uint32_t s_MaxBindlessTextures = 4096;
     static constexpr VkFormat s_DepthStencilFormat = VK_FORMAT_D32_SFLOAT;
 
 protected:
     bool Init() override;
     void Tick() override;
     void Shutdown() override;
+    CameraBase* GetBenchmarkCamera() override { return &m_Camera; }
 
 private:
     bool CreateDevice() override;
     void DestroyDevice() override;
     bool CreateDescriptorLayout();
-    void DestroyDescriptorLayout();
     bool CreateShader();
     void DestroyShader();
     bool CreateRenderPass();
     void DestroyRenderPass();
     bool CreatePipelineState();
+    bool CreateGraphicsPassPipeline();
+    bool CreateCullingPassPipeline();
     void DestroyPipelineState();
-    bool CreateDepthStencilBuffer();
-    void DestroyDepthStencilBuffer();
+    bool CreateRenderGraph();
+    void CullingPass(VkCommandBuffer inCmdBuffer, uint32_t inSlot);
+    void GraphicsPass();
+    void SubmitCulling(uint32_t inSlot);
     bool CreateFrameBuffer();
     void DestroyFrameBuffer();
     bool CreateScene();
     bool CreateResources();
     void DestroyResources();
     bool CreateDescriptorSet();
-    void DestroyDescriptorSet();
     void UpdateConstants();
+    // inOneFrameAhead culls for the frame after the current camera, see s_AsyncCullingFovMargin
+    void UpdateCullingConstants(uint32_t inSlot, bool inOneFrameAhead);
+    // Sorts the instances by draw key for the camera of the slot, culling visits them in that order
+    void UpdateDrawOrder(uint32_t inSlot);
     
-    VkDescriptorSetLayout                   m_DescriptorLayoutSpace0;
-    VkDescriptorSetLayout                   m_DescriptorLayoutSpace1;
+    VkDescriptorSetLayout                   m_DescriptorLayoutSpace0; // owned by the layout cache, space1 is the bindless table
     VkDescriptorSetLayout                   m_CullingPassDescriptorSetLayout;
     std::shared_ptr<AssetsManager::Blob>    m_VertexShaderBlob;
     std::shared_ptr<AssetsManager::Blob>    m_PixelShaderBlob;
@@ -106,9 +133,12 @@ private:
     VkPipeline                              m_PipelineState;
     VkPipeline                              m_CullingPassPipelineState;
 
-    VkDeviceMemory              m_DepthStencilMemory;
-    VkImage                     m_DepthStencilTexture;
-    VkImageView                 m_Dsv;
+    RenderGraph                 m_RenderGraph;
+    RenderGraphHandle           m_BackBufferHandle {s_InvalidRenderGraphHandle};
+    RenderGraphHandle           m_DepthStencilHandle {s_InvalidRenderGraphHandle}; // transient, lives in the render graph allocation
+    RenderGraphHandle           m_IndirectCommandsHandle {s_InvalidRenderGraphHandle};
+    RenderGraphHandle           m_DrawCountHandle {s_InvalidRenderGraphHandle};
+    RenderGraphHandle           m_VisibleInstancesHandle {s_InvalidRenderGraphHandle};
 
     std::vector<VkFramebuffer>  m_FrameBuffers;
 
@@ -116,37 +146,67 @@ private:
     Light                                               m_Light;    
     std::shared_ptr<AssetsManager::Mesh>                m_Mesh;
     std::array<std::shared_ptr<AssetsManager::Texture>, s_TexturesCount>  m_Textures;
-    std::vector<VertexData>     m_VerticesData;
+    std::array<std::vector<VertexData>, s_MeshCount>    m_MeshVertices;
+    std::array<std::vector<uint32_t>, s_MeshCount>      m_MeshIndices;     // mesh local, vertexOffset of the command rebases them
+    GeometryPool                                        m_GeometryPool;
+    std::array<uint32_t, s_MeshCount>                   m_PoolMeshes;
+    std::array<std::vector<MeshLod>, s_MeshCount>       m_MeshLods;        // index ranges inside m_MeshIndices
+    std::array<float, s_DrawBucketCount>                m_BucketLodErrors; // object space error over s_LodPixelError
     std::array<InstanceData, s_InstancesCount> m_InstancesData;
     std::array<MaterialData, s_MaterialCount> m_MaterialsData;
 
     VkBuffer                    m_CameraDataBuffer;
     VkDeviceMemory              m_CameraBufferMemory;
-    VkBuffer                    m_ViewFrustumBuffer;
-    VkDeviceMemory              m_ViewFrustumBufferMemory;
     VkBuffer                    m_LightDataBuffer;
     VkDeviceMemory              m_LightDataMemory;
     VkBuffer                    m_InstanceBuffer;
     VkDeviceMemory              m_InstanceBufferMemory;
     VkBuffer                    m_MaterialsBuffer;
     VkDeviceMemory              m_MaterialsBufferMemory;
-    VkBuffer                    m_VerticesBuffer;
+    VkBuffer                    m_VerticesBuffer;           // geometry pool, every mesh at its FirstVertex
     VkDeviceMemory              m_VerticesBufferMemory;
-    VkBuffer                    m_IndicesBuffer;
+    VkBuffer                    m_IndicesBuffer;            // geometry pool, every mesh at its FirstIndex
     VkDeviceMemory              m_IndicesBufferMemory;
     VkBuffer                    m_AABBBuffer;
     VkDeviceMemory              m_AABBBufferMemory;
-    VkBuffer                    m_IndirectCommandsBuffer;
-    VkDeviceMemory              m_IndirectCommandsBufferMemory;
+    VkBuffer                    m_LodErrorsBuffer {VK_NULL_HANDLE};
+    VkDeviceMemory              m_LodErrorsBufferMemory {VK_NULL_HANDLE};
+    VkBuffer                    m_InputCommandsBuffer {VK_NULL_HANDLE};       // bucket templates with no instance
+    VkDeviceMemory              m_InputCommandsBufferMemory {VK_NULL_HANDLE};
+
+    // One set of culling inputs and outputs per async compute slot, culling for the next frame
+    // writes one slot while the graphics pass of the current frame reads the other
+    std::array<VkBuffer, s_AsyncComputeSlotCount>           m_CullingCameraBuffers;
+    std::array<VkDeviceMemory, s_AsyncComputeSlotCount>     m_CullingCameraBufferMemories;
+    std::array<VkBuffer, s_AsyncComputeSlotCount>           m_ViewFrustumBuffers;
+    std::array<VkDeviceMemory, s_AsyncComputeSlotCount>     m_ViewFrustumBufferMemories;
+    std::array<VkBuffer, s_AsyncComputeSlotCount>           m_BucketCommandsBuffers {};  // one per bucket, reset before culling
+    std::array<VkDeviceMemory, s_AsyncComputeSlotCount>     m_BucketCommandsBufferMemories {};
+    std::array<VkBuffer, s_AsyncComputeSlotCount>           m_IndirectCommandsBuffers;   // the non-empty buckets packed at the front
+    std::array<VkDeviceMemory, s_AsyncComputeSlotCount>     m_IndirectCommandsBufferMemories;
+    std::array<VkBuffer, s_AsyncComputeSlotCount>           m_DrawCountBuffers {};       // draw count and finished groups, cleared before culling
+    std::array<VkDeviceMemory, s_AsyncComputeSlotCount>     m_DrawCountBufferMemories {};
+    std::array<VkBuffer, s_AsyncComputeSlotCount>           m_VisibleInstancesBuffers {}; // visible instance indices grouped by bucket
+    std::array<VkDeviceMemory, s_AsyncComputeSlotCount>     m_VisibleInstancesBufferMemories {};
+    std::array<VkBuffer, s_AsyncComputeSlotCount>           m_DrawOrderBuffers {};      // instance indices in draw key order
+    std::array<VkDeviceMemory, s_AsyncComputeSlotCount>     m_DrawOrderBufferMemories {};
+    std::array<uint64_t, s_AsyncComputeSlotCount>           m_CullingTimelineValues {}; // 0 until the slot is culled
+    uint32_t                                                m_CullingSlot = 0;
     
     std::array<VkImage,  s_TexturesCount>           m_MainTextures;
     std::array<VkImageView, s_TexturesCount>        m_MainTextureViews;
     std::array<VkDeviceMemory, s_TexturesCount>     m_MainTextureMemories;
     std::array<VkSampler, s_TexturesCount>     m_MainTextureSamplers;
+    std::array<uint32_t, s_TexturesCount>      m_MainTextureBindlessIndices;
 
-    std::array<VkDrawIndexedIndirectCommand, s_InstancesCount> m_IndirectDrawCommands;
+    std::array<VkDrawIndexedIndirectCommand, s_DrawBucketCount> m_IndirectDrawCommands;
+    DrawSorter                  m_DrawSorter;
+    std::vector<uint64_t>       m_DrawKeys;
+    std::vector<uint32_t>       m_DrawOrder;
     
-    VkDescriptorSet             m_DescriptorSetSpace0;
-    VkDescriptorSet             m_DescriptorSetSpace1;
-    VkDescriptorSet             m_CullingPassDescriptorSet;
+    std::array<VkDescriptorSet, s_AsyncComputeSlotCount> m_DescriptorSetsSpace0; // the visible instances of the slot differ
+    std::array<VkDescriptorSet, s_AsyncComputeSlotCount> m_CullingPassDescriptorSets;
+
+    bool                                    m_DrawIndirectCountSupported = false;
+    PFN_vkCmdDrawIndexedIndirectCountKHR    vkCmdDrawIndexedIndirectCountKHR = nullptr;
 };
\ No newline at end of file
@@ -4,50 +4,21 @@
 bool IndirectDrawVk::CreateDescriptorLayout()
 {
 	// Create descriptor set layout for graphics pass ---------------------
-	// Descriptor Set 0 Layout
+	// Descriptor Set 0 Layout, set 1 is the bindless texture table owned by AppBaseVk
     std::vector<VkDescriptorSetLayoutBinding> bindings;
     bindings.push_back({GetBindingSlot(ERegisterType::ConstantBuffer, 0), VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER, 1, VK_SHADER_STAGE_VERTEX_BIT, nullptr}); // _CameraData
     bindings.push_back({GetBindingSlot(ERegisterType::ConstantBuffer, 1), VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER, 1, VK_SHADER_STAGE_FRAGMENT_BIT, nullptr}); // _LightData
     bindings.push_back({GetBindingSlot(ERegisterType::ShaderResource, 0), VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, 1, VK_SHADER_STAGE_VERTEX_BIT, nullptr}); // _InstanceData
     bindings.push_back({GetBindingSlot(ERegisterType::ShaderResource, 1), VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, 1, VK_SHADER_STAGE_FRAGMENT_BIT, nullptr}); // _MaterialData
 	bindings.push_back({GetBindingSlot(ERegisterType::Sampler, 0), VK_DESCRIPTOR_TYPE_SAMPLER, 1, VK_SHADER_STAGE_FRAGMENT_BIT, nullptr}); // _MainTex_Sampler
+    bindings.push_back({GetBindingSlot(ERegisterType::ShaderResource, 2), VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, 1, VK_SHADER_STAGE_VERTEX_BIT, nullptr}); // _VisibleInstances
 
-    VkDescriptorSetLayoutCreateInfo layoutInfo{};
-    layoutInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_LAYOUT_CREATE_INFO;
-    layoutInfo.bindingCount = static_cast<uint32_t>(bindings.size());
-    layoutInfo.pBindings = bindings.data();
-
-    VkResult result = vkCreateDescriptorSetLayout(m_DeviceHandle, &layoutInfo, nullptr, &m_DescriptorLayoutSpace0);
-    if(result != VK_SUCCESS)
+    m_DescriptorLayoutSpace0 = GetDescriptorSetLayout(bindings);
+    if(m_DescriptorLayoutSpace0 == VK_NULL_HANDLE)
     {
-        Log::Error("Failed to create descriptor set 0 layout");
+        LOG_ERROR("Failed to create descriptor set 0 layout");
         return false;
     }
-
-	// Descriptor Set 1 Layout
-	std::vector<VkDescriptorSetLayoutBinding> bindings2;
-	bindings2.push_back({GetBindingSlot(ERegisterType::ShaderResource, 0), VK_DESCRIPTOR_TYPE_SAMPLED_IMAGE, s_TexturesCount, VK_SHADER_STAGE_FRAGMENT_BIT, nullptr}); // _MainTex
-	
-	VkDescriptorSetLayoutBindingFlagsCreateInfoEXT bindingFlagsInfo{};
-	bindingFlagsInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_LAYOUT_BINDING_FLAGS_CREATE_INFO_EXT;
-	bindingFlagsInfo.bindingCount = static_cast<uint32_t>(bindings2.size());
-	VkDescriptorBindingFlagsEXT bindingFlagsData[1] = {
-		VK_DESCRIPTOR_BINDING_VARIABLE_DESCRIPTOR_COUNT_BIT // for _MainTex
-	};
-	bindingFlagsInfo.pBindingFlags = bindingFlagsData;
-
-	VkDescriptorSetLayoutCreateInfo layoutInfo1{};
-	layoutInfo1.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_LAYOUT_CREATE_INFO;
-	layoutInfo1.bindingCount = static_cast<uint32_t>(bindings2.size());
-	layoutInfo1.pBindings = bindings2.data();
-	layoutInfo1.pNext = &bindingFlagsInfo;
-
-	result = vkCreateDescriptorSetLayout(m_DeviceHandle, &layoutInfo1, nullptr, &m_DescriptorLayoutSpace1);
-	if(result != VK_SUCCESS)
-	{
-		Log::Error("Failed to create descriptor set 1 layout");
-		return false;
-	}
 	
 	// Create descriptor layout for culling pass ------------------------
 	std::vector<VkDescriptorSetLayoutBinding> cullingPassBindings;
@@ -55,60 +26,42 @@ bool IndirectDrawVk::CreateDescriptorLayout()
 	cullingPassBindings.push_back({GetBindingSlot(ERegisterType::ConstantBuffer, 1), VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER, 1, VK_SHADER_STAGE_COMPUTE_BIT, nullptr}); // _ViewFrustum
 	cullingPassBindings.push_back({GetBindingSlot(ERegisterType::ConstantBuffer, 2), VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER, 1, VK_SHADER_STAGE_COMPUTE_BIT, nullptr}); // _AABB
 	cullingPassBindings.push_back({GetBindingSlot(ERegisterType::ShaderResource, 0), VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, 1, VK_SHADER_STAGE_COMPUTE_BIT, nullptr}); // _InstancesData
-	cullingPassBindings.push_back({GetBindingSlot(ERegisterType::UnorderedAccess, 0), VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, 1, VK_SHADER_STAGE_COMPUTE_BIT, nullptr}); // _IndirectCommands
-	
-	layoutInfo.bindingCount = static_cast<uint32_t>(cullingPassBindings.size());
-	layoutInfo.pBindings = cullingPassBindings.data();
-	
-
-	result = vkCreateDescriptorSetLayout(m_DeviceHandle, &layoutInfo, nullptr, &m_CullingPassDescriptorSetLayout);
-	if(result != VK_SUCCESS)
+	cullingPassBindings.push_back({GetBindingSlot(ERegisterType::ShaderResource, 1), VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, 1, VK_SHADER_STAGE_COMPUTE_BIT, nullptr}); // _InputCommands
+	cullingPassBindings.push_back({GetBindingSlot(ERegisterType::ShaderResource, 2), VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, 1, VK_SHADER_STAGE_COMPUTE_BIT, nullptr}); // _DrawOrder
+	cullingPassBindings.push_back({GetBindingSlot(ERegisterType::ShaderResource, 3), VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, 1, VK_SHADER_STAGE_COMPUTE_BIT, nullptr}); // _LodErrors
+	cullingPassBindings.push_back({GetBindingSlot(ERegisterType::UnorderedAccess, 0), VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, 1, VK_SHADER_STAGE_COMPUTE_BIT, nullptr}); // _BucketCommands
+	cullingPassBindings.push_back({GetBindingSlot(ERegisterType::UnorderedAccess, 1), VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, 1, VK_SHADER_STAGE_COMPUTE_BIT, nullptr}); // _VisibleInstances
+	cullingPassBindings.push_back({GetBindingSlot(ERegisterType::UnorderedAccess, 2), VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, 1, VK_SHADER_STAGE_COMPUTE_BIT, nullptr}); // _DrawCommands
+	cullingPassBindings.push_back({GetBindingSlot(ERegisterType::UnorderedAccess, 3), VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, 1, VK_SHADER_STAGE_COMPUTE_BIT, nullptr}); // _DrawCount
+
+	m_CullingPassDescriptorSetLayout = GetDescriptorSetLayout(cullingPassBindings);
+	if(m_CullingPassDescriptorSetLayout == VK_NULL_HANDLE)
 	{
-		Log::Error("Failed to create descriptor set layout  for culling pass");
+		LOG_ERROR("Failed to create descriptor set layout  for culling pass");
 		return false;
 	}
 	
     return true;
 }
 
-void IndirectDrawVk::DestroyDescriptorLayout()
-{
-	if(m_CullingPassDescriptorSetLayout != VK_NULL_HANDLE)
-	{
-		vkDestroyDescriptorSetLayout(m_DeviceHandle, m_CullingPassDescriptorSetLayout, nullptr);
-		m_CullingPassDescriptorSetLayout = VK_NULL_HANDLE;
-	}
-	if(m_DescriptorLayoutSpace1 != VK_NULL_HANDLE)
-	{
-		vkDestroyDescriptorSetLayout(m_DeviceHandle, m_DescriptorLayoutSpace1, nullptr);
-		m_DescriptorLayoutSpace1 = VK_NULL_HANDLE;
-	}
-	
-	if(m_DescriptorLayoutSpace0 != VK_NULL_HANDLE)
-	{
-		vkDestroyDescriptorSetLayout(m_DeviceHandle, m_DescriptorLayoutSpace0, nullptr);
-		m_DescriptorLayoutSpace0 = VK_NULL_HANDLE;
-	}
-}
-
 bool IndirectDrawVk::CreateShader()
 {
-    m_VertexShaderBlob = AssetsManager::LoadShaderImmediately("Graphics.vs.spv");
+    m_VertexShaderBlob = AssetsManager::LoadShaderImmediately("IndirectBatchedVk.vs.spv");
     if(!m_VertexShaderBlob || m_VertexShaderBlob->IsEmpty())
     {
-        Log::Error("Failed to load vertex shader");
+        LOG_ERROR("Failed to load vertex shader");
         return false;
     }
     m_PixelShaderBlob = AssetsManager::LoadShaderImmediately("Graphics.ps.spv");
     if(!m_PixelShaderBlob || m_PixelShaderBlob->IsEmpty())
     {
-        Log::Error("Failed to load pixel shader");
+        LOG_ERROR("Failed to load pixel shader");
         return false;
     }
 	m_ComputeShaderBlob = AssetsManager::LoadShaderImmediately("VisibleCullingVk.cs.spv");
 	if(!m_ComputeShaderBlob || m_ComputeShaderBlob->IsEmpty())
 	{
-		Log::Error("Failed to load compute shader");
+		LOG_ERROR("Failed to load compute shader");
 		return false;
 	}
 
@@ -119,7 +72,7 @@ bool IndirectDrawVk::CreateShader()
     VkResult result = vkCreateShaderModule(m_DeviceHandle, &shaderInfo, nullptr, &m_VertexShaderModule);
 	if(result != VK_SUCCESS)
 	{
-		Log::Error("Failed to create vertex shader");
+		LOG_ERROR("Failed to create vertex shader");
 		return false;
 	}
 
@@ -128,7 +81,7 @@ bool IndirectDrawVk::CreateShader()
     result = vkCreateShaderModule(m_DeviceHandle, &shaderInfo, nullptr, &m_PixelShaderModule);
 	if(result != VK_SUCCESS)
 	{
-		Log::Error("Failed to create pixel shader");
+		LOG_ERROR("Failed to create pixel shader");
 		return false;
 	}
 
@@ -137,7 +90,7 @@ bool IndirectDrawVk::CreateShader()
 	result = vkCreateShaderModule(m_DeviceHandle, &shaderInfo, nullptr, &m_ComputeShaderModule);
 	if(result != VK_SUCCESS)
 	{
-		Log::Error("Failed to create compute shader");
+		LOG_ERROR("Failed to create compute shader");
 		return false;
 	}
 	
@@ -174,8 +127,9 @@ bool IndirectDrawVk::CreateRenderPass()
 	colorAttachment.storeOp = VK_ATTACHMENT_STORE_OP_STORE;
 	colorAttachment.stencilLoadOp = VK_ATTACHMENT_LOAD_OP_DONT_CARE;
 	colorAttachment.stencilStoreOp = VK_ATTACHMENT_STORE_OP_DONT_CARE;
-	colorAttachment.initialLayout = VK_IMAGE_LAYOUT_UNDEFINED;
-	colorAttachment.finalLayout = VK_IMAGE_LAYOUT_PRESENT_SRC_KHR;
+	// Layout transitions are done by the render graph before and after the pass
+	colorAttachment.initialLayout = VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL;
+	colorAttachment.finalLayout = VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL;
 
 	VkAttachmentDescription depthAttachment{};
 	depthAttachment.format = s_DepthStencilFormat;
@@ -184,7 +138,7 @@ bool IndirectDrawVk::CreateRenderPass()
 	depthAttachment.storeOp = VK_ATTACHMENT_STORE_OP_DONT_CARE;
 	depthAttachment.stencilLoadOp = VK_ATTACHMENT_LOAD_OP_DONT_CARE;
 	depthAttachment.stencilStoreOp = VK_ATTACHMENT_STORE_OP_DONT_CARE;
-	depthAttachment.initialLayout = VK_IMAGE_LAYOUT_UNDEFINED;
+	depthAttachment.initialLayout = VK_IMAGE_LAYOUT_DEPTH_STENCIL_ATTACHMENT_OPTIMAL;
 	depthAttachment.finalLayout = VK_IMAGE_LAYOUT_DEPTH_STENCIL_ATTACHMENT_OPTIMAL;
 
 	VkAttachmentReference colorAttachmentRef{};
@@ -222,7 +176,7 @@ bool IndirectDrawVk::CreateRenderPass()
 	VkResult result = vkCreateRenderPass(m_DeviceHandle, &renderPassInfo, nullptr, &m_RenderPassHandle);
 	if(result != VK_SUCCESS)
 	{
-		Log::Error("Failed to create render pass");
+		LOG_ERROR("Failed to create render pass");
 		return false;
 	}
 	
@@ -240,8 +194,7 @@ void IndirectDrawVk::DestroyRenderPass()
 
 bool IndirectDrawVk::CreatePipelineState()
 {
-	// Create pipeline state for graphics pass --------------------------
-	VkDescriptorSetLayout layouts[2] = {m_DescriptorLayoutSpace0, m_DescriptorLayoutSpace1};
+	VkDescriptorSetLayout layouts[2] = {m_DescriptorLayoutSpace0, m_BindlessLayout};
 	VkPipelineLayoutCreateInfo pipelineLayoutInfo{};
 	pipelineLayoutInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_LAYOUT_CREATE_INFO;
 	pipelineLayoutInfo.setLayoutCount = 2;
@@ -249,10 +202,28 @@ bool IndirectDrawVk::CreatePipelineState()
 	VkResult result = vkCreatePipelineLayout(m_DeviceHandle, &pipelineLayoutInfo, nullptr, &m_PipelineLayout);
 	if(result != VK_SUCCESS)
 	{
-		Log::Error("Failed to create pipeline layout");
+		LOG_ERROR("Failed to create pipeline layout");
 		return false;
 	}
 
+	pipelineLayoutInfo.setLayoutCount = 1;
+	pipelineLayoutInfo.pSetLayouts = &m_CullingPassDescriptorSetLayout;
+	result = vkCreatePipelineLayout(m_DeviceHandle, &pipelineLayoutInfo, nullptr, &m_CullingPassPipelineLayout);
+	if(result != VK_SUCCESS)
+	{
+		LOG_ERROR("Failed to create culling pass pipeline layout");
+		return false;
+	}
+
+	// The graphics and culling pipelines are independent, compile them on worker threads
+	return CreatePipelinesParallel({
+		[this]() { return CreateGraphicsPassPipeline(); },
+		[this]() { return CreateCullingPassPipeline(); }
+	});
+}
+
+bool IndirectDrawVk::CreateGraphicsPassPipeline()
+{
 	std::vector<VkPipelineShaderStageCreateInfo> shaderStages
 	{
 		{VK_STRUCTURE_TYPE_PIPELINE_SHADER_STAGE_CREATE_INFO, nullptr, 0, VK_SHADER_STAGE_VERTEX_BIT, m_VertexShaderModule, "main", nullptr},
@@ -354,23 +325,18 @@ bool IndirectDrawVk::CreatePipelineState()
 	pipelineInfo.basePipelineHandle = VK_NULL_HANDLE;
 	pipelineInfo.basePipelineIndex = -1;
 
-	result = vkCreateGraphicsPipelines(m_DeviceHandle, VK_NULL_HANDLE, 1, &pipelineInfo, nullptr, &m_PipelineState);
+	VkResult result = vkCreateGraphicsPipelines(m_DeviceHandle, m_PipelineCacheHandle, 1, &pipelineInfo, nullptr, &m_PipelineState);
 	if(result != VK_SUCCESS)
 	{
-		Log::Error("Failed to create pipeline");
+		LOG_ERROR("Failed to create pipeline");
 		return false;
 	}
 
-	// Create pipeline state for culling pass ---------------------------
-	pipelineLayoutInfo.setLayoutCount = 1;
-	pipelineLayoutInfo.pSetLayouts = &m_CullingPassDescriptorSetLayout;
-	result = vkCreatePipelineLayout(m_DeviceHandle, &pipelineLayoutInfo, nullptr, &m_CullingPassPipelineLayout);
-	if(result != VK_SUCCESS)
-	{
-		Log::Error("Failed to create culling pass pipeline layout");
-		return false;
-	}
+	return true;
+}
 
+bool IndirectDrawVk::CreateCullingPassPipeline()
+{
 	VkComputePipelineCreateInfo computePipelineInfo{};
 	computePipelineInfo.sType = VK_STRUCTURE_TYPE_COMPUTE_PIPELINE_CREATE_INFO;
 	computePipelineInfo.stage.sType = VK_STRUCTURE_TYPE_PIPELINE_SHADER_STAGE_CREATE_INFO;
@@ -383,10 +349,10 @@ bool IndirectDrawVk::CreatePipelineState()
 	computePipelineInfo.layout = m_CullingPassPipelineLayout;
 	computePipelineInfo.basePipelineHandle = VK_NULL_HANDLE;
 	computePipelineInfo.basePipelineIndex = -1;
-	result = vkCreateComputePipelines(m_DeviceHandle, VK_NULL_HANDLE, 1,  &computePipelineInfo, nullptr, &m_CullingPassPipelineState);
+	VkResult result = vkCreateComputePipelines(m_DeviceHandle, m_PipelineCacheHandle, 1,  &computePipelineInfo, nullptr, &m_CullingPassPipelineState);
 	if(result != VK_SUCCESS)
 	{
-		Log::Error("Failed to create culling pass pipeline");
+		LOG_ERROR("Failed to create culling pass pipeline");
 		return false;
 	}
 	
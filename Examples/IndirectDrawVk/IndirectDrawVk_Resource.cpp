@@ -1,53 +1,63 @@
 #include "IndirectDrawVk.h"
 #include <random>
 
-bool IndirectDrawVk::CreateDepthStencilBuffer()
+bool IndirectDrawVk::CreateRenderGraph()
 {
-    if(!CreateTexture(m_Width
-        , m_Height
-        , s_DepthStencilFormat
-        , VK_IMAGE_USAGE_DEPTH_STENCIL_ATTACHMENT_BIT
-        , VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT
-        , VK_IMAGE_LAYOUT_UNDEFINED
-        , m_DepthStencilTexture
-        , m_DepthStencilMemory))
-    {
-        Log::Error("Failed to create depth stencil texture");
-        return false;
-    }
-
-    if(!CreateImageView(m_DepthStencilTexture
-        , s_DepthStencilFormat
-        , VK_IMAGE_ASPECT_DEPTH_BIT
-        , m_Dsv))
-    {
-        Log::Error("Failed to create depth stencil view");
-        return false;
-    }
-    
-    return true;
-}
-
-void IndirectDrawVk::DestroyDepthStencilBuffer()
-{
-    if(m_Dsv != VK_NULL_HANDLE)
-    {
-        vkDestroyImageView(m_DeviceHandle, m_Dsv, nullptr);
-        m_Dsv = VK_NULL_HANDLE;
-    }
-
-    if(m_DepthStencilMemory != VK_NULL_HANDLE)
-    {
-        
-        vkFreeMemory(m_DeviceHandle, m_DepthStencilMemory, nullptr);
-        m_DepthStencilMemory = VK_NULL_HANDLE;
-    }
-    
-    if(m_DepthStencilTexture != VK_NULL_HANDLE)
-    {
-        vkDestroyImage(m_DeviceHandle, m_DepthStencilTexture, nullptr);
-        m_DepthStencilTexture = VK_NULL_HANDLE;
-    }
+    m_RenderGraph.Reset();
+
+    RenderGraphResourceDesc backBufferDesc;
+    backBufferDesc.Width = m_Width;
+    backBufferDesc.Height = m_Height;
+    backBufferDesc.Format = s_BackBufferFormat;
+    m_BackBufferHandle = m_RenderGraph.ImportResource("BackBuffer", backBufferDesc, false);
+    m_RenderGraph.SetFinalAccess(m_BackBufferHandle, ERenderGraphAccess::Present);
+
+    RenderGraphResourceDesc indirectCommandsDesc;
+    indirectCommandsDesc.Type = ERenderGraphResourceType::Buffer;
+    indirectCommandsDesc.Width = sizeof(VkDrawIndexedIndirectCommand) * s_DrawBucketCount;
+    m_IndirectCommandsHandle = m_RenderGraph.ImportResource("IndirectCommands", indirectCommandsDesc);
+
+    RenderGraphResourceDesc drawCountDesc;
+    drawCountDesc.Type = ERenderGraphResourceType::Buffer;
+    drawCountDesc.Width = sizeof(uint32_t) * 2;
+    m_DrawCountHandle = m_RenderGraph.ImportResource("DrawCount", drawCountDesc);
+
+    RenderGraphResourceDesc visibleInstancesDesc;
+    visibleInstancesDesc.Type = ERenderGraphResourceType::Buffer;
+    visibleInstancesDesc.Width = sizeof(uint32_t) * s_VisibleInstanceCapacity;
+    m_VisibleInstancesHandle = m_RenderGraph.ImportResource("VisibleInstances", visibleInstancesDesc);
+
+    RenderGraphResourceDesc depthStencilDesc;
+    depthStencilDesc.Width = m_Width;
+    depthStencilDesc.Height = m_Height;
+    depthStencilDesc.Format = s_DepthStencilFormat;
+    m_DepthStencilHandle = m_RenderGraph.CreateResource("DepthStencil", depthStencilDesc);
+
+    // With async compute the culling pass is submitted to the compute queue outside of the graph
+    if(!IsAsyncComputeEnabled())
+    {
+        const uint32_t cullingPass = m_RenderGraph.AddPass("Culling", ERenderGraphPassType::Compute, [this]()
+        {
+            ScopedGpuProfile<AppBaseVk> scope(*this, "Culling");
+            CullingPass(m_CmdBufferHandle, m_CullingSlot);
+        });
+        m_RenderGraph.Write(cullingPass, m_IndirectCommandsHandle, ERenderGraphAccess::UnorderedAccess);
+        m_RenderGraph.Write(cullingPass, m_DrawCountHandle, ERenderGraphAccess::UnorderedAccess);
+        m_RenderGraph.Write(cullingPass, m_VisibleInstancesHandle, ERenderGraphAccess::UnorderedAccess);
+    }
+
+    const uint32_t graphicsPass = m_RenderGraph.AddPass("Graphics", ERenderGraphPassType::Graphics, [this]()
+    {
+        ScopedGpuProfile<AppBaseVk> scope(*this, "Graphics");
+        GraphicsPass();
+    });
+    m_RenderGraph.Read(graphicsPass, m_IndirectCommandsHandle, ERenderGraphAccess::IndirectArgument);
+    m_RenderGraph.Read(graphicsPass, m_DrawCountHandle, ERenderGraphAccess::IndirectArgument);
+    m_RenderGraph.Read(graphicsPass, m_VisibleInstancesHandle, ERenderGraphAccess::ShaderRead);
+    m_RenderGraph.Write(graphicsPass, m_DepthStencilHandle, ERenderGraphAccess::DepthWrite);
+    m_RenderGraph.Write(graphicsPass, m_BackBufferHandle, ERenderGraphAccess::RenderTarget);
+
+    return CompileRenderGraph(m_RenderGraph);
 }
 
 bool IndirectDrawVk::CreateFrameBuffer()
@@ -56,7 +66,7 @@ bool IndirectDrawVk::CreateFrameBuffer()
 
     for(uint32_t i = 0; i < s_BackBufferCount; ++i)
     {
-        VkImageView attachments[] = { m_BackBufferViews[i], m_Dsv };
+        VkImageView attachments[] = { m_BackBufferViews[i], GetRenderGraphImageView(m_DepthStencilHandle) };
 
         VkFramebufferCreateInfo frameBufferInfo = {};
         frameBufferInfo.sType = VK_STRUCTURE_TYPE_FRAMEBUFFER_CREATE_INFO;
@@ -69,7 +79,7 @@ bool IndirectDrawVk::CreateFrameBuffer()
 
         if(vkCreateFramebuffer(m_DeviceHandle, &frameBufferInfo, nullptr, &m_FrameBuffers[i]) != VK_SUCCESS)
         {
-            Log::Error("Failed to create frame buffer");
+            LOG_ERROR("Failed to create frame buffer");
             return false;
         }
     }
@@ -101,13 +111,64 @@ bool IndirectDrawVk::CreateScene()
     if(m_Mesh == nullptr || m_Mesh->IsEmpty())
         return false;
 
-    m_VerticesData.resize(m_Mesh->GetVerticesCount());
+    std::vector<VertexData>& sphereVertices = m_MeshVertices[0];
+    sphereVertices.resize(m_Mesh->GetVerticesCount());
     const aiMesh* mesh = m_Mesh->GetMesh();
     for(uint32_t i = 0; i < m_Mesh->GetVerticesCount(); ++i)
     {
-        m_VerticesData[i].Position = glm::vec3(mesh->mVertices[i].x, mesh->mVertices[i].y, mesh->mVertices[i].z);
-        m_VerticesData[i].Normal = glm::vec3(mesh->mNormals[i].x, mesh->mNormals[i].y, mesh->mNormals[i].z);
-        m_VerticesData[i].TexCoord = glm::vec2(mesh->mTextureCoords[0][i].x, mesh->mTextureCoords[0][i].y);
+        sphereVertices[i].Position = glm::vec3(mesh->mVertices[i].x, mesh->mVertices[i].y, mesh->mVertices[i].z);
+        sphereVertices[i].Normal = glm::vec3(mesh->mNormals[i].x, mesh->mNormals[i].y, mesh->mNormals[i].z);
+        sphereVertices[i].TexCoord = glm::vec2(mesh->mTextureCoords[0][i].x, mesh->mTextureCoords[0][i].y);
+    }
+    // Every LOD indexes the vertices of the full sphere, they only take more room in the index buffer
+    if(!m_Mesh->ComputeLods(s_SphereLodCount, s_LodRatio, m_MeshIndices[0], m_MeshLods[0]))
+        return false;
+    while(m_MeshLods[0].size() < s_SphereLodCount)
+    {
+        m_MeshLods[0].push_back(m_MeshLods[0].back());
+    }
+
+    // The box fills the bounds of the sphere, so the single AABB the culling pass tests is exact for both meshes
+    const glm::vec3 boxMin(mesh->mAABB.mMin.x, mesh->mAABB.mMin.y, mesh->mAABB.mMin.z);
+    const glm::vec3 boxMax(mesh->mAABB.mMax.x, mesh->mAABB.mMax.y, mesh->mAABB.mMax.z);
+    for(uint32_t face = 0; face < 6; ++face)
+    {
+        const uint32_t axis = face / 2;
+        glm::vec3 normal(0.0f);
+        normal[axis] = face % 2 == 0 ? -1.0f : 1.0f;
+        const uint32_t axisU = (axis + 1) % 3, axisV = (axis + 2) % 3;
+        const uint32_t first = static_cast<uint32_t>(m_MeshVertices[1].size());
+        for(uint32_t corner = 0; corner < 4; ++corner)
+        {
+            const glm::vec2 uv(corner == 1 || corner == 2 ? 1.0f : 0.0f, corner >= 2 ? 1.0f : 0.0f);
+            VertexData vertex;
+            vertex.Position[axis] = face % 2 == 0 ? boxMin[axis] : boxMax[axis];
+            vertex.Position[axisU] = glm::mix(boxMin[axisU], boxMax[axisU], uv.x);
+            vertex.Position[axisV] = glm::mix(boxMin[axisV], boxMax[axisV], uv.y);
+            vertex.Normal = normal;
+            vertex.TexCoord = uv;
+            m_MeshVertices[1].push_back(vertex);
+        }
+        // Same winding as the sphere, the face normal is the cross product of the first two edges
+        const glm::vec3 edge0 = m_MeshVertices[1][first + 1].Position - m_MeshVertices[1][first].Position;
+        const glm::vec3 edge1 = m_MeshVertices[1][first + 2].Position - m_MeshVertices[1][first].Position;
+        const bool flip = glm::dot(glm::cross(edge0, edge1), normal) < 0.0f;
+        for(uint32_t index : {0u, 1u, 2u, 0u, 2u, 3u})
+        {
+            m_MeshIndices[1].push_back(first + (flip && index > 0 ? 4 - index : index));
+        }
+    }
+    m_MeshLods[1] = { MeshLod{0, static_cast<uint32_t>(m_MeshIndices[1].size()), 0.0f} };
+
+    m_GeometryPool.Init(s_GeometryPoolVertexCapacity, s_GeometryPoolIndexCapacity);
+    for(uint32_t i = 0; i < s_MeshCount; ++i)
+    {
+        m_PoolMeshes[i] = m_GeometryPool.AddMesh(static_cast<uint32_t>(m_MeshVertices[i].size()), static_cast<uint32_t>(m_MeshIndices[i].size()));
+        if(m_PoolMeshes[i] == GeometryPool::s_InvalidMesh)
+        {
+            LOG_ERROR("Failed to add mesh %u to the geometry pool", i);
+            return false;
+        }
     }
     
     m_Textures[0] = AssetsManager::LoadTextureImmediately("3DLABbg_UV_Map_Checker_01_1024x1024.jpg");
@@ -146,12 +207,8 @@ bool IndirectDrawVk::CreateScene()
                 m_InstancesData[i].LocalToWorld = transform.GetLocalToWorldMatrix();
                 m_InstancesData[i].WorldToLocal = transform.GetWorldToLocalMatrix();
                 m_InstancesData[i].MaterialIndex = i % s_MaterialCount;
-
-                m_IndirectDrawCommands[i].indexCount = m_Mesh->GetIndicesCount();
-                m_IndirectDrawCommands[i].instanceCount = 1;
-                m_IndirectDrawCommands[i].firstIndex = 0;
-                m_IndirectDrawCommands[i].vertexOffset = 0;
-                m_IndirectDrawCommands[i].firstInstance = i;
+                m_InstancesData[i].DrawBucket = i % s_MeshCount == 0 ? 0 : s_SphereLodCount;
+                m_InstancesData[i].LodCount = i % s_MeshCount == 0 ? s_SphereLodCount : 1;
 
 #if DEBUG || _DEBUG
                 glm::vec3 min(mesh->mAABB.mMin.x, mesh->mAABB.mMin.y, mesh->mAABB.mMin.z);
@@ -167,13 +224,41 @@ bool IndirectDrawVk::CreateScene()
                 ViewFrustumPlanes planes = CameraBase::Corners2Planes(frustum);
         
                 bool inter = CameraBase::IsAABBInFrustum(planes, min, max);
-                const char* str = inter ? "%d:true" : "%d:false";
-                Log::Info(str, i);
+                LOG_INFO("%d:%s", i, inter ? "true" : "false");
 #endif
             }
         }
     }
 
+    // Culling fills instanceCount, the visible instances of bucket b are packed from firstInstance on. The buckets of
+    // a mesh are its LODs in order, any instance of the mesh may land in any of them.
+    std::array<uint32_t, s_DrawBucketCount> bucketSizes {};
+    for(const InstanceData& instance : m_InstancesData)
+    {
+        for(uint32_t lod = 0; lod < instance.LodCount; ++lod)
+        {
+            ++bucketSizes[instance.DrawBucket + lod];
+        }
+    }
+    uint32_t bucket = 0;
+    uint32_t firstInstance = 0;
+    for(uint32_t m = 0; m < s_MeshCount; ++m)
+    {
+        const GeometryPool::MeshRange& range = m_GeometryPool.GetMesh(m_PoolMeshes[m]);
+        for(const MeshLod& lod : m_MeshLods[m])
+        {
+            m_IndirectDrawCommands[bucket].indexCount = lod.IndexCount;
+            m_IndirectDrawCommands[bucket].instanceCount = 0;
+            m_IndirectDrawCommands[bucket].firstIndex = range.FirstIndex + lod.FirstIndex;
+            m_IndirectDrawCommands[bucket].vertexOffset = static_cast<int32_t>(range.FirstVertex);
+            m_IndirectDrawCommands[bucket].firstInstance = firstInstance;
+            // Pixels per world unit at distance 1 are Projection[1][1] * height / 2
+            m_BucketLodErrors[bucket] = lod.Error * m_Height * 0.5f / s_LodPixelError;
+            firstInstance += bucketSizes[bucket];
+            ++bucket;
+        }
+    }
+
     return true;
 }
 
@@ -185,7 +270,7 @@ bool IndirectDrawVk::CreateResources()
         , m_CameraDataBuffer
         , m_CameraBufferMemory))
     {
-        Log::Error("Failed to create camera data buffer");
+        LOG_ERROR("Failed to create camera data buffer");
         return false;
     }
 
@@ -195,38 +280,50 @@ bool IndirectDrawVk::CreateResources()
         , m_LightDataBuffer
         , m_LightDataMemory))
     {
-        Log::Error("Failed to create light data buffer");
+        LOG_ERROR("Failed to create light data buffer");
         return false;
     }
 
-    if(!CreateBuffer(ViewFrustumCB::GetAlignedByteSizes()
-        , VK_BUFFER_USAGE_UNIFORM_BUFFER_BIT
-        , VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT
-        , m_ViewFrustumBuffer
-        , m_ViewFrustumBufferMemory))
+    for(uint32_t i = 0; i < s_AsyncComputeSlotCount; ++i)
     {
-        Log::Error("Failed to create view frustum buffer");
-        return false;
+        if(!CreateBuffer(CameraData::GetAlignedByteSizes()
+            , VK_BUFFER_USAGE_UNIFORM_BUFFER_BIT
+            , VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT
+            , m_CullingCameraBuffers[i]
+            , m_CullingCameraBufferMemories[i]))
+        {
+            LOG_ERROR("Failed to create culling camera data buffer");
+            return false;
+        }
+
+        if(!CreateBuffer(ViewFrustumCB::GetAlignedByteSizes()
+            , VK_BUFFER_USAGE_UNIFORM_BUFFER_BIT
+            , VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT
+            , m_ViewFrustumBuffers[i]
+            , m_ViewFrustumBufferMemories[i]))
+        {
+            LOG_ERROR("Failed to create view frustum buffer");
+            return false;
+        }
     }
 
-    const size_t vertexBufferSize = m_Mesh->GetVerticesCount() * sizeof(VertexData);
-    if(!CreateBuffer(vertexBufferSize
+    if(!CreateBuffer(m_GeometryPool.GetVertexCapacity() * sizeof(VertexData)
         , VK_BUFFER_USAGE_VERTEX_BUFFER_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT
         , VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT
         , m_VerticesBuffer
         , m_VerticesBufferMemory))
     {
-        Log::Error("Failed to create vertex buffer");
+        LOG_ERROR("Failed to create vertex buffer");
         return false;
     }
 
-    if(!CreateBuffer(m_Mesh->GetIndicesDataByteSize()
+    if(!CreateBuffer(m_GeometryPool.GetIndexCapacity() * sizeof(uint32_t)
         , VK_BUFFER_USAGE_INDEX_BUFFER_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT
         , VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT
         , m_IndicesBuffer
         , m_IndicesBufferMemory))
     {
-        Log::Error("Failed to create index buffer");
+        LOG_ERROR("Failed to create index buffer");
         return false;
     }
 
@@ -236,7 +333,7 @@ bool IndirectDrawVk::CreateResources()
         , m_AABBBuffer
         , m_AABBBufferMemory))
     {
-        Log::Error("Failed to create AABB buffer");
+        LOG_ERROR("Failed to create AABB buffer");
         return false;
     }
 
@@ -250,9 +347,10 @@ bool IndirectDrawVk::CreateResources()
         , VK_BUFFER_USAGE_STORAGE_BUFFER_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT
         , VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT
         , m_InstanceBuffer
-        , m_InstanceBufferMemory))
+        , m_InstanceBufferMemory
+        , true))
     {
-        Log::Error("Failed to create instance buffer");
+        LOG_ERROR("Failed to create instance buffer");
         return false;
     }
 
@@ -263,21 +361,93 @@ bool IndirectDrawVk::CreateResources()
         , m_MaterialsBuffer
         , m_MaterialsBufferMemory))
     {
-        Log::Error("Failed to create materials buffer");
+        LOG_ERROR("Failed to create materials buffer");
         return false;
     }
 
-    const size_t indirectCommandsBufferBytesSize = s_InstancesCount * sizeof(VkDrawIndexedIndirectCommand);
+    const size_t indirectCommandsBufferBytesSize = s_DrawBucketCount * sizeof(VkDrawIndexedIndirectCommand);
     if(!CreateBuffer(indirectCommandsBufferBytesSize
-        , VK_BUFFER_USAGE_INDIRECT_BUFFER_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT | VK_BUFFER_USAGE_STORAGE_BUFFER_BIT
+        , VK_BUFFER_USAGE_STORAGE_BUFFER_BIT | VK_BUFFER_USAGE_TRANSFER_SRC_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT
         , VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT
-        , m_IndirectCommandsBuffer
-        , m_IndirectCommandsBufferMemory))
+        , m_InputCommandsBuffer
+        , m_InputCommandsBufferMemory
+        , true))
     {
-        Log::Error("Failed to create indirect commands buffer");
+        LOG_ERROR("Failed to create input commands buffer");
         return false;
     }
 
+    if(!CreateBuffer(s_DrawBucketCount * sizeof(float)
+        , VK_BUFFER_USAGE_STORAGE_BUFFER_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT
+        , VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT
+        , m_LodErrorsBuffer
+        , m_LodErrorsBufferMemory
+        , true))
+    {
+        LOG_ERROR("Failed to create LOD errors buffer");
+        return false;
+    }
+
+    for(uint32_t i = 0; i < s_AsyncComputeSlotCount; ++i)
+    {
+        // Only culling reads and writes the per bucket counts
+        if(!CreateBuffer(indirectCommandsBufferBytesSize
+            , VK_BUFFER_USAGE_STORAGE_BUFFER_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT
+            , VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT
+            , m_BucketCommandsBuffers[i]
+            , m_BucketCommandsBufferMemories[i]
+            , true))
+        {
+            LOG_ERROR("Failed to create bucket commands buffer");
+            return false;
+        }
+
+        // Written by the compute queue, read by the graphics queue
+        if(!CreateBuffer(indirectCommandsBufferBytesSize
+            , VK_BUFFER_USAGE_INDIRECT_BUFFER_BIT | VK_BUFFER_USAGE_STORAGE_BUFFER_BIT
+            , VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT
+            , m_IndirectCommandsBuffers[i]
+            , m_IndirectCommandsBufferMemories[i]
+            , true))
+        {
+            LOG_ERROR("Failed to create indirect commands buffer");
+            return false;
+        }
+
+        if(!CreateBuffer(sizeof(uint32_t) * 2
+            , VK_BUFFER_USAGE_INDIRECT_BUFFER_BIT | VK_BUFFER_USAGE_STORAGE_BUFFER_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT
+            , VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT
+            , m_DrawCountBuffers[i]
+            , m_DrawCountBufferMemories[i]
+            , true))
+        {
+            LOG_ERROR("Failed to create draw count buffer");
+            return false;
+        }
+
+        if(!CreateBuffer(s_VisibleInstanceCapacity * sizeof(uint32_t)
+            , VK_BUFFER_USAGE_STORAGE_BUFFER_BIT
+            , VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT
+            , m_VisibleInstancesBuffers[i]
+            , m_VisibleInstancesBufferMemories[i]
+            , true))
+        {
+            LOG_ERROR("Failed to create visible instances buffer");
+            return false;
+        }
+
+        // Rewritten by the CPU every time the slot is culled
+        if(!CreateBuffer(s_InstancesCount * sizeof(uint32_t)
+            , VK_BUFFER_USAGE_STORAGE_BUFFER_BIT
+            , VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT
+            , m_DrawOrderBuffers[i]
+            , m_DrawOrderBufferMemories[i]))
+        {
+            LOG_ERROR("Failed to create draw order buffer");
+            return false;
+        }
+    }
+
     for(uint32_t i = 0; i < s_TexturesCount; ++i)
     {
         const DirectX::TexMetadata& metadata = m_Textures[i]->GetTextureDesc();
@@ -290,7 +460,7 @@ bool IndirectDrawVk::CreateResources()
             , m_MainTextures[i]
             , m_MainTextureMemories[i]))
         {
-            Log::Error("Failed to create texture");
+            LOG_ERROR("Failed to create texture");
             return false;
         }
 
@@ -299,34 +469,51 @@ bool IndirectDrawVk::CreateResources()
             , VK_IMAGE_ASPECT_COLOR_BIT
             , m_MainTextureViews[i]))
         {
-            Log::Error("Failed to create image view");
+            LOG_ERROR("Failed to create image view");
             return false;
         }
 
         if(!CreateSampler(m_MainTextureSamplers[i]))
         {
-            Log::Error("Failed to create sampler");
+            LOG_ERROR("Failed to create sampler");
             return false;
         }
+
+        m_MainTextureBindlessIndices[i] = RegisterBindlessTexture(m_MainTextureViews[i]);
+        if(m_MainTextureBindlessIndices[i] == UINT32_MAX)
+            return false;
     }
 
-    std::vector<std::shared_ptr<StagingBuffer>> stagingBuffers(10);
+    // CreateScene picks a texture per material, translate it to the slot in the bindless table
+    for(auto& material : m_MaterialsData)
+    {
+        material.TexIndex = m_MainTextureBindlessIndices[material.TexIndex];
+    }
+
+    std::vector<std::shared_ptr<StagingBuffer>> stagingBuffers(9 + s_MeshCount * 2);
 
     BeginCommandList();
 
-    stagingBuffers[0] = UploadBuffer(m_VerticesBuffer, m_VerticesData.data(), vertexBufferSize);
-    stagingBuffers[1] = UploadBuffer(m_IndicesBuffer, m_Mesh->GetIndicesData(), m_Mesh->GetIndicesDataByteSize());
-    stagingBuffers[2] = UploadBuffer(m_InstanceBuffer, m_InstancesData.data(), instanceBufferBytesSize);
-    stagingBuffers[3] = UploadBuffer(m_MaterialsBuffer, m_MaterialsData.data(), materialsBufferBytesSize);
+    stagingBuffers[0] = UploadBuffer(m_InstanceBuffer, m_InstancesData.data(), instanceBufferBytesSize);
+    stagingBuffers[1] = UploadBuffer(m_MaterialsBuffer, m_MaterialsData.data(), materialsBufferBytesSize);
 
     for(uint32_t i = 0; i < s_TexturesCount; ++i)
     {
         const DirectX::ScratchImage& scratchImage = m_Textures[i]->GetScratchImage();
         const DirectX::TexMetadata& metadata = scratchImage.GetMetadata();
-        stagingBuffers[4 + i] = UploadTexture(m_MainTextures[i], scratchImage.GetPixels(), metadata.width, metadata.height, 4);
+        stagingBuffers[2 + i] = UploadTexture(m_MainTextures[i], scratchImage.GetPixels(), metadata.width, metadata.height, 4);
     }
 
-    stagingBuffers[9] = UploadBuffer(m_IndirectCommandsBuffer, m_IndirectDrawCommands.data(), indirectCommandsBufferBytesSize);
+    stagingBuffers[7] = UploadBuffer(m_InputCommandsBuffer, m_IndirectDrawCommands.data(), indirectCommandsBufferBytesSize);
+    stagingBuffers[8] = UploadBuffer(m_LodErrorsBuffer, m_BucketLodErrors.data(), s_DrawBucketCount * sizeof(float));
+
+    // Every mesh goes to its range of the geometry pool
+    for(uint32_t i = 0; i < s_MeshCount; ++i)
+    {
+        const GeometryPool::MeshRange& range = m_GeometryPool.GetMesh(m_PoolMeshes[i]);
+        stagingBuffers[9 + i * 2] = UploadBuffer(m_VerticesBuffer, m_MeshVertices[i].data(), m_MeshVertices[i].size() * sizeof(VertexData), range.FirstVertex * sizeof(VertexData));
+        stagingBuffers[10 + i * 2] = UploadBuffer(m_IndicesBuffer, m_MeshIndices[i].data(), m_MeshIndices[i].size() * sizeof(uint32_t), range.FirstIndex * sizeof(uint32_t));
+    }
     
     EndCommandList();
 
@@ -338,16 +525,71 @@ bool IndirectDrawVk::CreateResources()
 void IndirectDrawVk::DestroyResources()
 {
     
-    if(m_IndirectCommandsBuffer != VK_NULL_HANDLE)
-    {
-        vkDestroyBuffer(m_DeviceHandle, m_IndirectCommandsBuffer, nullptr);
-        m_IndirectCommandsBuffer = VK_NULL_HANDLE;
-    }
-    
-    if(m_IndirectCommandsBufferMemory != VK_NULL_HANDLE)
-    {
-        vkFreeMemory(m_DeviceHandle, m_IndirectCommandsBufferMemory, nullptr);
-        m_IndirectCommandsBufferMemory = VK_NULL_HANDLE;
+    if(m_LodErrorsBufferMemory != VK_NULL_HANDLE)
+    {
+        vkFreeMemory(m_DeviceHandle, m_LodErrorsBufferMemory, nullptr);
+        m_LodErrorsBufferMemory = VK_NULL_HANDLE;
+    }
+    if(m_LodErrorsBuffer != VK_NULL_HANDLE)
+    {
+        vkDestroyBuffer(m_DeviceHandle, m_LodErrorsBuffer, nullptr);
+        m_LodErrorsBuffer = VK_NULL_HANDLE;
+    }
+    if(m_InputCommandsBufferMemory != VK_NULL_HANDLE)
+    {
+        vkFreeMemory(m_DeviceHandle, m_InputCommandsBufferMemory, nullptr);
+        m_InputCommandsBufferMemory = VK_NULL_HANDLE;
+    }
+    if(m_InputCommandsBuffer != VK_NULL_HANDLE)
+    {
+        vkDestroyBuffer(m_DeviceHandle, m_InputCommandsBuffer, nullptr);
+        m_InputCommandsBuffer = VK_NULL_HANDLE;
+    }
+
+    for(uint32_t i = 0; i < s_AsyncComputeSlotCount; ++i)
+    {
+        if(m_DrawOrderBuffers[i] != VK_NULL_HANDLE)
+            vkDestroyBuffer(m_DeviceHandle, m_DrawOrderBuffers[i], nullptr);
+        if(m_DrawOrderBufferMemories[i] != VK_NULL_HANDLE)
+            vkFreeMemory(m_DeviceHandle, m_DrawOrderBufferMemories[i], nullptr);
+        if(m_VisibleInstancesBuffers[i] != VK_NULL_HANDLE)
+            vkDestroyBuffer(m_DeviceHandle, m_VisibleInstancesBuffers[i], nullptr);
+        if(m_VisibleInstancesBufferMemories[i] != VK_NULL_HANDLE)
+            vkFreeMemory(m_DeviceHandle, m_VisibleInstancesBufferMemories[i], nullptr);
+        if(m_DrawCountBuffers[i] != VK_NULL_HANDLE)
+            vkDestroyBuffer(m_DeviceHandle, m_DrawCountBuffers[i], nullptr);
+        if(m_DrawCountBufferMemories[i] != VK_NULL_HANDLE)
+            vkFreeMemory(m_DeviceHandle, m_DrawCountBufferMemories[i], nullptr);
+        if(m_IndirectCommandsBuffers[i] != VK_NULL_HANDLE)
+            vkDestroyBuffer(m_DeviceHandle, m_IndirectCommandsBuffers[i], nullptr);
+        if(m_IndirectCommandsBufferMemories[i] != VK_NULL_HANDLE)
+            vkFreeMemory(m_DeviceHandle, m_IndirectCommandsBufferMemories[i], nullptr);
+        if(m_BucketCommandsBuffers[i] != VK_NULL_HANDLE)
+            vkDestroyBuffer(m_DeviceHandle, m_BucketCommandsBuffers[i], nullptr);
+        if(m_BucketCommandsBufferMemories[i] != VK_NULL_HANDLE)
+            vkFreeMemory(m_DeviceHandle, m_BucketCommandsBufferMemories[i], nullptr);
+        if(m_ViewFrustumBufferMemories[i] != VK_NULL_HANDLE)
+            vkFreeMemory(m_DeviceHandle, m_ViewFrustumBufferMemories[i], nullptr);
+        if(m_ViewFrustumBuffers[i] != VK_NULL_HANDLE)
+            vkDestroyBuffer(m_DeviceHandle, m_ViewFrustumBuffers[i], nullptr);
+        if(m_CullingCameraBufferMemories[i] != VK_NULL_HANDLE)
+            vkFreeMemory(m_DeviceHandle, m_CullingCameraBufferMemories[i], nullptr);
+        if(m_CullingCameraBuffers[i] != VK_NULL_HANDLE)
+            vkDestroyBuffer(m_DeviceHandle, m_CullingCameraBuffers[i], nullptr);
+        m_DrawOrderBuffers[i] = VK_NULL_HANDLE;
+        m_DrawOrderBufferMemories[i] = VK_NULL_HANDLE;
+        m_VisibleInstancesBuffers[i] = VK_NULL_HANDLE;
+        m_VisibleInstancesBufferMemories[i] = VK_NULL_HANDLE;
+        m_DrawCountBuffers[i] = VK_NULL_HANDLE;
+        m_DrawCountBufferMemories[i] = VK_NULL_HANDLE;
+        m_IndirectCommandsBuffers[i] = VK_NULL_HANDLE;
+        m_IndirectCommandsBufferMemories[i] = VK_NULL_HANDLE;
+        m_BucketCommandsBuffers[i] = VK_NULL_HANDLE;
+        m_BucketCommandsBufferMemories[i] = VK_NULL_HANDLE;
+        m_ViewFrustumBuffers[i] = VK_NULL_HANDLE;
+        m_ViewFrustumBufferMemories[i] = VK_NULL_HANDLE;
+        m_CullingCameraBuffers[i] = VK_NULL_HANDLE;
+        m_CullingCameraBufferMemories[i] = VK_NULL_HANDLE;
     }
     
     for(uint32_t i = 0; i < s_TexturesCount; ++i)
@@ -425,18 +667,6 @@ void IndirectDrawVk::DestroyResources()
         m_LightDataBuffer = VK_NULL_HANDLE;
     }
 
-    if(m_ViewFrustumBufferMemory != VK_NULL_HANDLE)
-    {
-        vkFreeMemory(m_DeviceHandle, m_ViewFrustumBufferMemory, nullptr);
-        m_ViewFrustumBufferMemory = VK_NULL_HANDLE;
-    }
-
-    if(m_ViewFrustumBuffer != VK_NULL_HANDLE)
-    {
-        vkDestroyBuffer(m_DeviceHandle, m_ViewFrustumBuffer, nullptr);
-        m_ViewFrustumBuffer = VK_NULL_HANDLE;
-    }
-    
     if(m_CameraBufferMemory != VK_NULL_HANDLE)
     {
         vkFreeMemory(m_DeviceHandle, m_CameraBufferMemory, nullptr);
@@ -451,125 +681,88 @@ void IndirectDrawVk::DestroyResources()
 
 bool IndirectDrawVk::CreateDescriptorSet()
 {
-    // Allocate descriptor set for graphics pass
-    // Allocate descriptor set 0
-    VkDescriptorSetAllocateInfo descriptorSetAllocInfo {};
-    descriptorSetAllocInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_ALLOCATE_INFO;
-    descriptorSetAllocInfo.descriptorPool = m_DescriptorPoolHandle;
-    descriptorSetAllocInfo.pSetLayouts = &m_DescriptorLayoutSpace0;
-    descriptorSetAllocInfo.descriptorSetCount = 1;
-    if(vkAllocateDescriptorSets(m_DeviceHandle, &descriptorSetAllocInfo, &m_DescriptorSetSpace0) != VK_SUCCESS)
-    {
-        Log::Error("Failed to allocate descriptor set 0");
-        return false;
-    }
-    
-    std::array<VkWriteDescriptorSet, 6> descriptorWrites{};
+    // Allocate descriptor sets for graphics pass, one per slot for its visible instances, set 1 is the bindless table bound as is
     VkDescriptorBufferInfo cameraBufferInfo = CreateDescriptorBufferInfo(m_CameraDataBuffer, CameraData::GetAlignedByteSizes());
-    UpdateBufferDescriptor(descriptorWrites[0], m_DescriptorSetSpace0, VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER, &cameraBufferInfo, GetBindingSlot(ERegisterType::ConstantBuffer, 0)); // _CameraData 
-    
     VkDescriptorBufferInfo lightBufferInfo = CreateDescriptorBufferInfo(m_LightDataBuffer, DirectionalLightData::GetAlignedByteSizes());
-    UpdateBufferDescriptor(descriptorWrites[1], m_DescriptorSetSpace0, VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER, &lightBufferInfo, GetBindingSlot(ERegisterType::ConstantBuffer, 1)); // _LightData
-
     const size_t instanceBufferBytesSize = s_InstancesCount * sizeof(InstanceData);
     VkDescriptorBufferInfo instanceBufferInfo = CreateDescriptorBufferInfo(m_InstanceBuffer, instanceBufferBytesSize);
-    UpdateBufferDescriptor(descriptorWrites[2], m_DescriptorSetSpace0, VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, &instanceBufferInfo, GetBindingSlot(ERegisterType::ShaderResource, 0)); // _InstancesBuffer
-
     const size_t materialsBufferBytesSize = s_MaterialCount * sizeof(MaterialData);
     VkDescriptorBufferInfo materialsBufferInfo = CreateDescriptorBufferInfo(m_MaterialsBuffer, materialsBufferBytesSize);
-    UpdateBufferDescriptor(descriptorWrites[4]
-        , m_DescriptorSetSpace0
-        , VK_DESCRIPTOR_TYPE_STORAGE_BUFFER
-        , &materialsBufferInfo
-        , GetBindingSlot(ERegisterType::ShaderResource, 1)); // _MaterialsBuffer
-
     VkDescriptorImageInfo samplerDescriptorInfo = CreateDescriptorImageInfo(VK_NULL_HANDLE, m_MainTextureSamplers[0]);
-    UpdateImageDescriptor(descriptorWrites[5]
-        , m_DescriptorSetSpace0
-        , VK_DESCRIPTOR_TYPE_SAMPLER
-        , &samplerDescriptorInfo
-        , 1
-        , GetBindingSlot(ERegisterType::Sampler, 0)); // _MainTexSampler
-    
-    // Allocate descriptor set 1
-    uint32_t descriptorCounts[2] = {s_TexturesCount, 1};
-    VkDescriptorSetVariableDescriptorCountAllocateInfoEXT variableDescriptorCountAllocInfo = {};
-    variableDescriptorCountAllocInfo.sType              = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_VARIABLE_DESCRIPTOR_COUNT_ALLOCATE_INFO_EXT;
-    variableDescriptorCountAllocInfo.descriptorSetCount = 1;
-    variableDescriptorCountAllocInfo.pDescriptorCounts  = descriptorCounts;
-
-    VkDescriptorSetAllocateInfo descriptorSetAllocInfo1 {};
-    descriptorSetAllocInfo1.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_ALLOCATE_INFO;
-    descriptorSetAllocInfo1.descriptorPool = m_DescriptorPoolHandle;
-    descriptorSetAllocInfo1.pSetLayouts = &m_DescriptorLayoutSpace1;
-    descriptorSetAllocInfo1.descriptorSetCount = 1;
-    descriptorSetAllocInfo1.pNext = &variableDescriptorCountAllocInfo;
-    if(vkAllocateDescriptorSets(m_DeviceHandle, &descriptorSetAllocInfo1, &m_DescriptorSetSpace1) != VK_SUCCESS)
-    {
-        Log::Error("Failed to allocate descriptor set 1");
-        return false;
-    }
-    
-    std::array<VkDescriptorImageInfo, s_TexturesCount> imageDescriptorInfos;
-    for(uint32_t i = 0; i < s_TexturesCount; ++i)
+    for(uint32_t i = 0; i < s_AsyncComputeSlotCount; ++i)
     {
-        imageDescriptorInfos[i] = CreateDescriptorImageInfo(m_MainTextureViews[i], VK_NULL_HANDLE);
-    }
+        if(!AllocatePersistentDescriptorSet(m_DescriptorLayoutSpace0, m_DescriptorSetsSpace0[i]))
+        {
+            LOG_ERROR("Failed to allocate descriptor set 0");
+            return false;
+        }
 
-    UpdateImageDescriptor(descriptorWrites[3]
-        , m_DescriptorSetSpace1
-        , VK_DESCRIPTOR_TYPE_SAMPLED_IMAGE
-        , imageDescriptorInfos.data()
-        , (uint32_t)imageDescriptorInfos.size()
-        , GetBindingSlot(ERegisterType::ShaderResource, 0)); // _MainTex[]
-    
-    vkUpdateDescriptorSets(m_DeviceHandle, (uint32_t)descriptorWrites.size(), descriptorWrites.data(), 0, nullptr);
+        std::array<VkWriteDescriptorSet, 6> descriptorWrites{};
+        UpdateBufferDescriptor(descriptorWrites[0], m_DescriptorSetsSpace0[i], VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER, &cameraBufferInfo, GetBindingSlot(ERegisterType::ConstantBuffer, 0)); // _CameraData 
+        UpdateBufferDescriptor(descriptorWrites[1], m_DescriptorSetsSpace0[i], VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER, &lightBufferInfo, GetBindingSlot(ERegisterType::ConstantBuffer, 1)); // _LightData
+        UpdateBufferDescriptor(descriptorWrites[2], m_DescriptorSetsSpace0[i], VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, &instanceBufferInfo, GetBindingSlot(ERegisterType::ShaderResource, 0)); // _InstancesBuffer
+        UpdateBufferDescriptor(descriptorWrites[3]
+            , m_DescriptorSetsSpace0[i]
+            , VK_DESCRIPTOR_TYPE_STORAGE_BUFFER
+            , &materialsBufferInfo
+            , GetBindingSlot(ERegisterType::ShaderResource, 1)); // _MaterialsBuffer
+        UpdateImageDescriptor(descriptorWrites[4]
+            , m_DescriptorSetsSpace0[i]
+            , VK_DESCRIPTOR_TYPE_SAMPLER
+            , &samplerDescriptorInfo
+            , 1
+            , GetBindingSlot(ERegisterType::Sampler, 0)); // _MainTexSampler
+
+        VkDescriptorBufferInfo visibleInstancesBufferInfo = CreateDescriptorBufferInfo(m_VisibleInstancesBuffers[i], s_VisibleInstanceCapacity * sizeof(uint32_t));
+        UpdateBufferDescriptor(descriptorWrites[5], m_DescriptorSetsSpace0[i], VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, &visibleInstancesBufferInfo, GetBindingSlot(ERegisterType::ShaderResource, 2)); // _VisibleInstances
+        
+        vkUpdateDescriptorSets(m_DeviceHandle, (uint32_t)descriptorWrites.size(), descriptorWrites.data(), 0, nullptr);
+    }
     
-    // Allocate descriptor set for culling pass
-    descriptorSetAllocInfo.pSetLayouts = &m_CullingPassDescriptorSetLayout;
-    descriptorSetAllocInfo.descriptorSetCount = 1;
-    if(vkAllocateDescriptorSets(m_DeviceHandle, &descriptorSetAllocInfo, &m_CullingPassDescriptorSet) != VK_SUCCESS)
+    // Allocate descriptor sets for culling pass, one per slot
+    VkDescriptorBufferInfo aabbBufferInfo = CreateDescriptorBufferInfo(m_AABBBuffer, AABB::GetAlignedByteSizes());
+    VkDescriptorBufferInfo lodErrorsBufferInfo = CreateDescriptorBufferInfo(m_LodErrorsBuffer, s_DrawBucketCount * sizeof(float));
+    VkDescriptorBufferInfo inputCommandsBufferInfo = CreateDescriptorBufferInfo(m_InputCommandsBuffer, s_DrawBucketCount * sizeof(VkDrawIndexedIndirectCommand));
+    for(uint32_t i = 0; i < s_AsyncComputeSlotCount; ++i)
     {
-        Log::Error("Failed to allocate descriptor set");
-        return false;
-    }
+        if(!AllocatePersistentDescriptorSet(m_CullingPassDescriptorSetLayout, m_CullingPassDescriptorSets[i]))
+        {
+            LOG_ERROR("Failed to allocate descriptor set");
+            return false;
+        }
 
-    std::array<VkWriteDescriptorSet, 5> cullingPassDescriptorWrites{};
-    UpdateBufferDescriptor(cullingPassDescriptorWrites[0], m_CullingPassDescriptorSet, VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER, &cameraBufferInfo, GetBindingSlot(ERegisterType::ConstantBuffer, 0)); // _CameraData
-    
-    VkDescriptorBufferInfo viewFrustumBufferInfo = CreateDescriptorBufferInfo(m_ViewFrustumBuffer, DirectionalLightData::GetAlignedByteSizes());
-    UpdateBufferDescriptor(cullingPassDescriptorWrites[1], m_CullingPassDescriptorSet, VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER, &viewFrustumBufferInfo, GetBindingSlot(ERegisterType::ConstantBuffer, 1)); // _ViewFrustum
+        std::array<VkWriteDescriptorSet, 11> cullingPassDescriptorWrites{};
+        VkDescriptorBufferInfo cullingCameraBufferInfo = CreateDescriptorBufferInfo(m_CullingCameraBuffers[i], CameraData::GetAlignedByteSizes());
+        UpdateBufferDescriptor(cullingPassDescriptorWrites[0], m_CullingPassDescriptorSets[i], VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER, &cullingCameraBufferInfo, GetBindingSlot(ERegisterType::ConstantBuffer, 0)); // _CameraData
+        
+        VkDescriptorBufferInfo viewFrustumBufferInfo = CreateDescriptorBufferInfo(m_ViewFrustumBuffers[i], ViewFrustumCB::GetAlignedByteSizes());
+        UpdateBufferDescriptor(cullingPassDescriptorWrites[1], m_CullingPassDescriptorSets[i], VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER, &viewFrustumBufferInfo, GetBindingSlot(ERegisterType::ConstantBuffer, 1)); // _ViewFrustum
 
-    VkDescriptorBufferInfo aabbBufferInfo = CreateDescriptorBufferInfo(m_AABBBuffer, AABB::GetAlignedByteSizes());
-    UpdateBufferDescriptor(cullingPassDescriptorWrites[2], m_CullingPassDescriptorSet, VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER, &aabbBufferInfo, GetBindingSlot(ERegisterType::ConstantBuffer, 2)); // _AABB
-    
-    UpdateBufferDescriptor(cullingPassDescriptorWrites[3], m_CullingPassDescriptorSet, VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, &instanceBufferInfo, GetBindingSlot(ERegisterType::ShaderResource, 0)); // _InstancesBuffer
+        UpdateBufferDescriptor(cullingPassDescriptorWrites[2], m_CullingPassDescriptorSets[i], VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER, &aabbBufferInfo, GetBindingSlot(ERegisterType::ConstantBuffer, 2)); // _AABB
+        
+        UpdateBufferDescriptor(cullingPassDescriptorWrites[3], m_CullingPassDescriptorSets[i], VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, &instanceBufferInfo, GetBindingSlot(ERegisterType::ShaderResource, 0)); // _InstancesBuffer
 
-    VkDescriptorBufferInfo indirectCommandsBufferInfo = CreateDescriptorBufferInfo(m_IndirectCommandsBuffer, s_InstancesCount * sizeof(VkDrawIndexedIndirectCommand));
-    UpdateBufferDescriptor(cullingPassDescriptorWrites[4], m_CullingPassDescriptorSet, VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, &indirectCommandsBufferInfo, GetBindingSlot(ERegisterType::UnorderedAccess, 0)); // _IndirectCommands
+        UpdateBufferDescriptor(cullingPassDescriptorWrites[4], m_CullingPassDescriptorSets[i], VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, &inputCommandsBufferInfo, GetBindingSlot(ERegisterType::ShaderResource, 1)); // _InputCommands
 
-    vkUpdateDescriptorSets(m_DeviceHandle, (uint32_t)cullingPassDescriptorWrites.size(), cullingPassDescriptorWrites.data(), 0, nullptr);
+        VkDescriptorBufferInfo drawOrderBufferInfo = CreateDescriptorBufferInfo(m_DrawOrderBuffers[i], s_InstancesCount * sizeof(uint32_t));
+        UpdateBufferDescriptor(cullingPassDescriptorWrites[7], m_CullingPassDescriptorSets[i], VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, &drawOrderBufferInfo, GetBindingSlot(ERegisterType::ShaderResource, 2)); // _DrawOrder
 
-    return true;
-}
+        UpdateBufferDescriptor(cullingPassDescriptorWrites[8], m_CullingPassDescriptorSets[i], VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, &lodErrorsBufferInfo, GetBindingSlot(ERegisterType::ShaderResource, 3)); // _LodErrors
 
-void IndirectDrawVk::DestroyDescriptorSet()
-{
-    if(m_CullingPassDescriptorSet != VK_NULL_HANDLE)
-    {
-        vkFreeDescriptorSets(m_DeviceHandle, m_DescriptorPoolHandle, 1, &m_CullingPassDescriptorSet);
-        m_CullingPassDescriptorSet = VK_NULL_HANDLE;
-    }
-    
-    if(m_DescriptorSetSpace1 != VK_NULL_HANDLE)
-    {
-        vkFreeDescriptorSets(m_DeviceHandle, m_DescriptorPoolHandle, 1, &m_DescriptorSetSpace1);
-        m_DescriptorSetSpace1 = VK_NULL_HANDLE;
-    }
-    
-    if(m_DescriptorSetSpace0 != VK_NULL_HANDLE)
-    {
-        vkFreeDescriptorSets(m_DeviceHandle, m_DescriptorPoolHandle, 1, &m_DescriptorSetSpace0);
-        m_DescriptorSetSpace0 = VK_NULL_HANDLE;
+        VkDescriptorBufferInfo bucketCommandsBufferInfo = CreateDescriptorBufferInfo(m_BucketCommandsBuffers[i], s_DrawBucketCount * sizeof(VkDrawIndexedIndirectCommand));
+        UpdateBufferDescriptor(cullingPassDescriptorWrites[5], m_CullingPassDescriptorSets[i], VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, &bucketCommandsBufferInfo, GetBindingSlot(ERegisterType::UnorderedAccess, 0)); // _BucketCommands
+
+        VkDescriptorBufferInfo visibleInstancesBufferInfo = CreateDescriptorBufferInfo(m_VisibleInstancesBuffers[i], s_VisibleInstanceCapacity * sizeof(uint32_t));
+        UpdateBufferDescriptor(cullingPassDescriptorWrites[6], m_CullingPassDescriptorSets[i], VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, &visibleInstancesBufferInfo, GetBindingSlot(ERegisterType::UnorderedAccess, 1)); // _VisibleInstances
+
+        VkDescriptorBufferInfo indirectCommandsBufferInfo = CreateDescriptorBufferInfo(m_IndirectCommandsBuffers[i], s_DrawBucketCount * sizeof(VkDrawIndexedIndirectCommand));
+        UpdateBufferDescriptor(cullingPassDescriptorWrites[9], m_CullingPassDescriptorSets[i], VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, &indirectCommandsBufferInfo, GetBindingSlot(ERegisterType::UnorderedAccess, 2)); // _DrawCommands
+
+        VkDescriptorBufferInfo drawCountBufferInfo = CreateDescriptorBufferInfo(m_DrawCountBuffers[i], sizeof(uint32_t) * 2);
+        UpdateBufferDescriptor(cullingPassDescriptorWrites[10], m_CullingPassDescriptorSets[i], VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, &drawCountBufferInfo, GetBindingSlot(ERegisterType::UnorderedAccess, 3)); // _DrawCount
+
+        vkUpdateDescriptorSets(m_DeviceHandle, (uint32_t)cullingPassDescriptorWrites.size(), cullingPassDescriptorWrites.data(), 0, nullptr);
     }
-}
\ No newline at end of file
+
+    return true;
+}
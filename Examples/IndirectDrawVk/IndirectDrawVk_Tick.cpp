@@ -1,4 +1,5 @@
 #include "IndirectDrawVk.h"
+#include "CpuProfiler.h"
 #include <array>
 
 void IndirectDrawVk::UpdateConstants()
@@ -6,40 +7,93 @@ void IndirectDrawVk::UpdateConstants()
     CameraData cameraData;
     m_Camera.GetCameraData(cameraData);
     WriteBufferData(m_DeviceHandle, m_CameraBufferMemory, &cameraData, CameraData::GetAlignedByteSizes());
+    
+    DirectionalLightData lightData;
+    lightData.LightColor = m_Light.Color;
+    lightData.LightDirection = m_Light.Transform.GetWorldForward();
+    lightData.LightIntensity = m_Light.Intensity;
+    WriteBufferData(m_DeviceHandle, m_LightDataMemory, &lightData, DirectionalLightData::GetAlignedByteSizes());
+}
 
+void IndirectDrawVk::UpdateCullingConstants(uint32_t inSlot, bool inOneFrameAhead)
+{
+    PROFILE_ZONE("UpdateCullingConstants");
+    CameraData cameraData;
+    m_Camera.GetCameraData(cameraData);
+    WriteBufferData(m_DeviceHandle, m_CullingCameraBufferMemories[inSlot], &cameraData, CameraData::GetAlignedByteSizes());
+
+    // LOD selection and the draw order keep the current camera, they are one frame late at worst
+    CameraPerspective cullingCamera = m_Camera;
+    if(inOneFrameAhead)
+        cullingCamera.Fov = std::min(cullingCamera.Fov + s_AsyncCullingFovMargin, 170.0f);
     ViewFrustum viewFrustum;
-    m_Camera.GetViewFrustumWorldSpace(viewFrustum);
+    cullingCamera.GetViewFrustumWorldSpace(viewFrustum);
     ViewFrustumCB viewFrustumCB;
     for(uint32_t i = 0; i < 8; ++i)
     {
         viewFrustumCB.Corners[i] = glm::vec4(viewFrustum.Corners[i], 1.0f);
     }
-    WriteBufferData(m_DeviceHandle, m_ViewFrustumBufferMemory, &viewFrustumCB, ViewFrustumCB::GetAlignedByteSizes());
-    
-    
-    DirectionalLightData lightData;
-    lightData.LightColor = m_Light.Color;
-    lightData.LightDirection = m_Light.Transform.GetWorldForward();
-    lightData.LightIntensity = m_Light.Intensity;
-    WriteBufferData(m_DeviceHandle, m_LightDataMemory, &lightData, DirectionalLightData::GetAlignedByteSizes());
+    WriteBufferData(m_DeviceHandle, m_ViewFrustumBufferMemories[inSlot], &viewFrustumCB, ViewFrustumCB::GetAlignedByteSizes());
+
+    UpdateDrawOrder(inSlot);
 }
 
-void IndirectDrawVk::Tick()
+void IndirectDrawVk::UpdateDrawOrder(uint32_t inSlot)
 {
-    if(!m_IsRunning)
+    PROFILE_ZONE("UpdateDrawOrder");
+    // Materials only pick a texture inside the instanced draw of a bucket, grouping by texture and then front to back
+    // keeps the texture locality and lets early depth reject most of the hidden fragments
+    const glm::vec3 cameraPosition = m_Camera.Transform.GetWorldPosition();
+    const glm::vec3 cameraForward = m_Camera.Transform.GetWorldForward();
+    m_DrawKeys.resize(s_InstancesCount);
+    m_DrawOrder.resize(s_InstancesCount);
+    for(uint32_t i = 0; i < s_InstancesCount; ++i)
     {
-        return;
+        const InstanceData& instance = m_InstancesData[i];
+        const float depth = glm::dot(glm::vec3(instance.LocalToWorld[3]) - cameraPosition, cameraForward);
+        m_DrawKeys[i] = DrawKey::Opaque(0, instance.DrawBucket, m_MaterialsData[instance.MaterialIndex].TexIndex, depth);
+        m_DrawOrder[i] = i;
     }
+    m_DrawSorter.Sort(m_DrawKeys, m_DrawOrder);
+    WriteBufferData(m_DeviceHandle, m_DrawOrderBufferMemories[inSlot], m_DrawOrder.data(), s_InstancesCount * sizeof(uint32_t));
+}
 
-    BeginCommandList();
-    UpdateConstants();
+void IndirectDrawVk::CullingPass(VkCommandBuffer inCmdBuffer, uint32_t inSlot)
+{
+    // Every bucket restarts with no instance and the draws are packed from 0, the last culling of the slot wrote the
+    // buckets and the last graphics pass of the slot read the draw count
+    VkMemoryBarrier reuseBarrier{};
+    reuseBarrier.sType = VK_STRUCTURE_TYPE_MEMORY_BARRIER;
+    reuseBarrier.srcAccessMask = VK_ACCESS_SHADER_WRITE_BIT;
+    reuseBarrier.dstAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+    vkCmdPipelineBarrier(inCmdBuffer, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT | VK_PIPELINE_STAGE_DRAW_INDIRECT_BIT, VK_PIPELINE_STAGE_TRANSFER_BIT, 0, 1, &reuseBarrier, 0, nullptr, 0, nullptr);
+    VkBufferCopy commandsCopy{};
+    commandsCopy.size = s_DrawBucketCount * sizeof(VkDrawIndexedIndirectCommand);
+    vkCmdCopyBuffer(inCmdBuffer, m_InputCommandsBuffer, m_BucketCommandsBuffers[inSlot], 1, &commandsCopy);
+    vkCmdFillBuffer(inCmdBuffer, m_DrawCountBuffers[inSlot], 0, sizeof(uint32_t) * 2, 0);
+    VkMemoryBarrier resetBarrier{};
+    resetBarrier.sType = VK_STRUCTURE_TYPE_MEMORY_BARRIER;
+    resetBarrier.srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+    resetBarrier.dstAccessMask = VK_ACCESS_SHADER_READ_BIT | VK_ACCESS_SHADER_WRITE_BIT;
+    vkCmdPipelineBarrier(inCmdBuffer, VK_PIPELINE_STAGE_TRANSFER_BIT, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, 0, 1, &resetBarrier, 0, nullptr, 0, nullptr);
 
-    // culling pass
-    vkCmdBindPipeline(m_CmdBufferHandle, VK_PIPELINE_BIND_POINT_COMPUTE, m_CullingPassPipelineState);
-    vkCmdBindDescriptorSets(m_CmdBufferHandle, VK_PIPELINE_BIND_POINT_COMPUTE, m_CullingPassPipelineLayout, 0, 1, &m_CullingPassDescriptorSet, 0, nullptr);
-    vkCmdDispatch(m_CmdBufferHandle, s_InstancesCount / s_ThreadGroupSize, 1, 1);
-    
-    // graphics pass
+    vkCmdBindPipeline(inCmdBuffer, VK_PIPELINE_BIND_POINT_COMPUTE, m_CullingPassPipelineState);
+    vkCmdBindDescriptorSets(inCmdBuffer, VK_PIPELINE_BIND_POINT_COMPUTE, m_CullingPassPipelineLayout, 0, 1, &m_CullingPassDescriptorSets[inSlot], 0, nullptr);
+    vkCmdDispatch(inCmdBuffer, (s_InstancesCount + s_ThreadGroupSize - 1) / s_ThreadGroupSize, 1, 1);
+}
+
+void IndirectDrawVk::SubmitCulling(uint32_t inSlot)
+{
+    PROFILE_ZONE("SubmitCulling");
+    // The slot was last drawn from by the previous frame, whose graphics submission has already been waited on
+    UpdateCullingConstants(inSlot, true);
+    CullingPass(BeginComputeCommandList(inSlot), inSlot);
+    m_CullingTimelineValues[inSlot] = SubmitComputeCommandList(inSlot);
+}
+
+void IndirectDrawVk::GraphicsPass()
+{
+    PROFILE_ZONE("RecordGraphicsPass");
     VkRenderPassBeginInfo renderPassInfo{};
     renderPassInfo.sType = VK_STRUCTURE_TYPE_RENDER_PASS_BEGIN_INFO;
     renderPassInfo.renderPass = m_RenderPassHandle;
@@ -70,7 +124,7 @@ void IndirectDrawVk::Tick()
         scissor.extent = m_Capabilities.currentExtent;
         vkCmdSetScissor(m_CmdBufferHandle, 0, 1, &scissor);
 
-        VkDescriptorSet descriptorSets[2] = { m_DescriptorSetSpace0, m_DescriptorSetSpace1 };
+        VkDescriptorSet descriptorSets[2] = { m_DescriptorSetsSpace0[m_CullingSlot], m_BindlessSet };
         vkCmdBindPipeline(m_CmdBufferHandle, VK_PIPELINE_BIND_POINT_GRAPHICS, m_PipelineState);
         vkCmdBindDescriptorSets(m_CmdBufferHandle, VK_PIPELINE_BIND_POINT_GRAPHICS, m_PipelineLayout, 0, 2, descriptorSets, 0, nullptr);
 
@@ -79,12 +133,68 @@ void IndirectDrawVk::Tick()
         vkCmdBindVertexBuffers(m_CmdBufferHandle, 0, 1, vertexBuffers, offsets);
         vkCmdBindIndexBuffer(m_CmdBufferHandle, m_IndicesBuffer, 0, VK_INDEX_TYPE_UINT32);
 
-        // vkCmdDrawIndexed(m_CmdBufferHandle, m_Mesh->GetIndicesCount(), s_InstancesCount, 0, 0, 0);
-        vkCmdDrawIndexedIndirect(m_CmdBufferHandle, m_IndirectCommandsBuffer, 0, s_InstancesCount, sizeof(VkDrawIndexedIndirectCommand));
+        // One instanced draw per bucket with a visible instance, culling packed them and wrote their count. Without
+        // the count every bucket is submitted, the packed tail has no instance.
+        if(m_DrawIndirectCountSupported)
+        {
+            vkCmdDrawIndexedIndirectCountKHR(m_CmdBufferHandle
+                , m_IndirectCommandsBuffers[m_CullingSlot], 0
+                , m_DrawCountBuffers[m_CullingSlot], 0
+                , s_DrawBucketCount, sizeof(VkDrawIndexedIndirectCommand));
+        }
+        else
+        {
+            vkCmdDrawIndexedIndirect(m_CmdBufferHandle, m_IndirectCommandsBuffers[m_CullingSlot], 0, s_DrawBucketCount, sizeof(VkDrawIndexedIndirectCommand));
+        }
     }
     vkCmdEndRenderPass(m_CmdBufferHandle);
-    EndCommandList();
-    
-    ExecuteCommandBuffer(m_ImageAvailableSemaphore);
+}
+
+void IndirectDrawVk::Tick()
+{
+    if(!m_IsRunning)
+    {
+        return;
+    }
+
+    if(!IsAsyncComputeEnabled())
+    {
+        BeginCommandList();
+        UpdateConstants();
+        UpdateCullingConstants(m_CullingSlot, false);
+
+        // Culling writes the indirect commands, the graphics pass draws them into the back buffer
+        BindRenderGraphImage(m_BackBufferHandle, m_BackBuffers[m_CurrentIndex]);
+        BindRenderGraphBuffer(m_IndirectCommandsHandle, m_IndirectCommandsBuffers[m_CullingSlot]);
+        BindRenderGraphBuffer(m_DrawCountHandle, m_DrawCountBuffers[m_CullingSlot]);
+        BindRenderGraphBuffer(m_VisibleInstancesHandle, m_VisibleInstancesBuffers[m_CullingSlot]);
+        ExecuteRenderGraph(m_RenderGraph);
+        EndCommandList();
+        
+        ExecuteCommandBuffer(m_ImageAvailableSemaphore);
+        Present();
+        return;
+    }
+
+    // The culling of this frame was submitted during the previous one, except on the very first frame
+    if(m_CullingTimelineValues[m_CullingSlot] == 0)
+        SubmitCulling(m_CullingSlot);
+
+    BeginCommandList();
+    UpdateConstants();
+    BindRenderGraphImage(m_BackBufferHandle, m_BackBuffers[m_CurrentIndex]);
+    BindRenderGraphBuffer(m_IndirectCommandsHandle, m_IndirectCommandsBuffers[m_CullingSlot]);
+    BindRenderGraphBuffer(m_DrawCountHandle, m_DrawCountBuffers[m_CullingSlot]);
+    BindRenderGraphBuffer(m_VisibleInstancesHandle, m_VisibleInstancesBuffers[m_CullingSlot]);
+    ExecuteRenderGraph(m_RenderGraph);
+    SubmitCommandBuffer(m_ImageAvailableSemaphore, m_CullingTimelineValues[m_CullingSlot]);
+
+    // Cull the next frame on the compute queue while the graphics queue draws this one. It is culled with the camera
+    // of this frame, the widened frustum covers the camera moving in between.
+    const uint32_t nextSlot = (m_CullingSlot + 1) % s_AsyncComputeSlotCount;
+    SubmitCulling(nextSlot);
+
+    WaitForCommandBuffer();
     Present();
+    m_CullingSlot = nextSlot;
 }
\ No newline at end of file
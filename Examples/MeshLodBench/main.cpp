@@ -0,0 +1,120 @@
+#include "Benchmark.h"
+#include "Log.h"
+#include "MeshSimplifier.h"
+#include <glm/gtc/constants.hpp>
+#include <algorithm>
+#include <chrono>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+
+// Builds LOD chains with MeshSimplifier for a smooth and a bumpy procedural sphere without a device, times the
+// simplification and checks the error every level reports against the measured distance to the full mesh.
+//
+//   MeshLodBench [--iterations N] [--report path.json|path.csv] [--baseline path.json] [--tolerance percent]
+
+static constexpr uint32_t s_Rings = 128;
+static constexpr uint32_t s_Segments = 256;
+static constexpr uint32_t s_LodCount = 6;
+static constexpr float s_LodRatio = 0.5f;
+
+static double MillisecondsSince(std::chrono::steady_clock::time_point inStart)
+{
+    return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - inStart).count();
+}
+
+// Closed latitude longitude sphere of radius 1 plus inBumps, a single vertex per position so only the geometry limits
+// the simplification
+static void BuildSphere(float inBumps, std::vector<glm::vec3>& outPositions, std::vector<uint32_t>& outIndices)
+{
+    outPositions.clear();
+    outIndices.clear();
+    outPositions.push_back(glm::vec3(0.0f, 1.0f, 0.0f));
+    for(uint32_t ring = 1; ring < s_Rings; ++ring)
+    {
+        const float theta = glm::pi<float>() * ring / s_Rings;
+        for(uint32_t segment = 0; segment < s_Segments; ++segment)
+        {
+            const float phi = glm::two_pi<float>() * segment / s_Segments;
+            const float radius = 1.0f + inBumps * std::sin(theta * 12.0f) * std::sin(phi * 12.0f);
+            outPositions.push_back(radius * glm::vec3(std::sin(theta) * std::cos(phi), std::cos(theta), std::sin(theta) * std::sin(phi)));
+        }
+    }
+    outPositions.push_back(glm::vec3(0.0f, -1.0f, 0.0f));
+
+    const uint32_t bottom = static_cast<uint32_t>(outPositions.size()) - 1;
+    auto vertex = [](uint32_t inRing, uint32_t inSegment) { return 1 + (inRing - 1) * s_Segments + inSegment % s_Segments; };
+    for(uint32_t segment = 0; segment < s_Segments; ++segment)
+    {
+        outIndices.insert(outIndices.end(), {0u, vertex(1, segment + 1), vertex(1, segment)});
+        outIndices.insert(outIndices.end(), {bottom, vertex(s_Rings - 1, segment), vertex(s_Rings - 1, segment + 1)});
+        for(uint32_t ring = 1; ring + 1 < s_Rings; ++ring)
+        {
+            outIndices.insert(outIndices.end(), {vertex(ring, segment), vertex(ring, segment + 1), vertex(ring + 1, segment + 1)});
+            outIndices.insert(outIndices.end(), {vertex(ring, segment), vertex(ring + 1, segment + 1), vertex(ring + 1, segment)});
+        }
+    }
+}
+
+int main(int argc, char** argv)
+{
+    uint32_t iterations = 5;
+    std::string reportPath;
+    std::string baselinePath;
+    double tolerancePercent = 10.0;
+    for(int i = 1; i < argc; ++i)
+    {
+        const bool hasValue = i + 1 < argc;
+        if(strcmp(argv[i], "--iterations") == 0 && hasValue)
+            iterations = std::max(1, atoi(argv[++i]));
+        else if(strcmp(argv[i], "--report") == 0 && hasValue)
+            reportPath = argv[++i];
+        else if(strcmp(argv[i], "--baseline") == 0 && hasValue)
+            baselinePath = argv[++i];
+        else if(strcmp(argv[i], "--tolerance") == 0 && hasValue)
+            tolerancePercent = atof(argv[++i]);
+        else
+            LOG_WARNING("Unknown argument %s", argv[i]);
+    }
+
+    Benchmark benchmark;
+    int exitCode = 0;
+    for(float bumps : {0.0f, 0.05f})
+    {
+        const std::string name = bumps > 0.0f ? "bumpy sphere" : "sphere";
+        std::vector<glm::vec3> positions;
+        std::vector<uint32_t> indices;
+        BuildSphere(bumps, positions, indices);
+
+        std::vector<uint32_t> lodIndices;
+        std::vector<MeshLod> lods;
+        for(uint32_t i = 0; i < iterations; ++i)
+        {
+            const auto start = std::chrono::steady_clock::now();
+            MeshSimplifier::BuildLodChain(positions, indices, s_LodCount, s_LodRatio, lodIndices, lods);
+            benchmark.AddSample("LOD chain " + name, MillisecondsSince(start));
+        }
+
+        for(uint32_t lod = 0; lod < lods.size(); ++lod)
+        {
+            float maxError, meanError;
+            MeshSimplifier::MeasureError(positions, indices, &lodIndices[lods[lod].FirstIndex], lods[lod].IndexCount, maxError, meanError);
+            Log::Info("[MeshLod] %s LOD %u: %u triangles, error %.5f, measured max %.5f mean %.5f", name.c_str(), lod
+                , lods[lod].IndexCount / 3, lods[lod].Error, maxError, meanError);
+            // The quadric error sums the squared distances to several planes, it must bound the real distance
+            if(maxError > lods[lod].Error * 1.01f + 1e-5f)
+            {
+                LOG_ERROR("[MeshLod] %s LOD %u moved the surface by %.5f, more than its error %.5f", name.c_str(), lod, maxError, lods[lod].Error);
+                exitCode = 1;
+            }
+        }
+    }
+
+    benchmark.LogReport();
+    if(!reportPath.empty())
+        benchmark.WriteReport(reportPath, "MeshLodBench", 0);
+    if(!baselinePath.empty() && !benchmark.CompareWithBaseline(baselinePath, tolerancePercent))
+        exitCode = 1;
+    Log::Flush();
+    return exitCode;
+}
@@ -4,6 +4,9 @@ bool MeshPipelineDx::Init()
 {
     if(!CreateDevice())
         return false;
+
+    if(!CreatePipelineLibrary("MeshPipelineDx"))
+        return false;
     
     if(!CreateCommandQueue())
         return false;
@@ -11,7 +14,7 @@ bool MeshPipelineDx::Init()
     if(!CreateCommandList())
         return false;
 
-    if(!CreateDescriptorHeaps())
+    if(!CreateDescriptorHeaps(GetHiZDescriptorCount()))
         return false;
 
     if(!CreateSwapChain())
@@ -41,6 +44,7 @@ bool MeshPipelineDx::Init()
 void MeshPipelineDx::Shutdown()
 {
     FlushCommandQueue();
+    DestroyPipelineLibrary();
 }
 
 bool MeshPipelineDx::CreateDevice()
@@ -53,7 +57,7 @@ bool MeshPipelineDx::CreateDevice()
     if (SUCCEEDED(D3D12GetDebugInterface(IID_PPV_ARGS(&debugController))))
         debugController->EnableDebugLayer();
     else
-        Log::Warning("Failed to enable the D3D12 debug layer");
+        LOG_WARNING("Failed to enable the D3D12 debug layer");
 #endif
     
     const uint32_t factoryFlags = allowDebugging ? DXGI_CREATE_FACTORY_DEBUG : 0;
@@ -86,7 +90,7 @@ bool MeshPipelineDx::CreateDevice()
                         m_DeviceHandle = TempDevice;
                         std::wstring adapterDesc(Desc.Description);
                         std::string name(adapterDesc.begin(), adapterDesc.end());
-                        Log::Info("[D3D12] Using adapter: %s", name.c_str());
+                        LOG_INFO("[D3D12] Using adapter: %s", name.c_str());
                         break;
                     }
                 }
@@ -96,7 +100,7 @@ bool MeshPipelineDx::CreateDevice()
 
     if(m_DeviceHandle.Get() == nullptr)
     {
-        Log::Error("Failed to find a device supporting Mesh Shaders");
+        LOG_ERROR("Failed to find a device supporting Mesh Shaders");
         return false;
     }
     
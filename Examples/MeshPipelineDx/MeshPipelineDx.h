@@ -2,6 +2,7 @@
 
 #include "AssetsManager.h"
 #include "Camera.h"
+#include "GpuScene.h"
 #include "Transform.h"
 #include "../AppBaseDx.h"
 
@@ -11,6 +12,10 @@ struct MeshInfo
     uint32_t IndexCount;
     uint32_t MeshletCount;
     uint32_t InstanceCount;
+    float    LodErrorScale;     // half the target height over s_ClusterPixelError
+    uint32_t Padding;
+    glm::vec2 ViewportSize;     // in pixels, for the small triangle test of the mesh shader
+    glm::vec4 BoundingSphere;   // of every level of the DAG, tested once per instance
 
     static uint64_t GetAlignedByteSizes()
     {
@@ -24,6 +29,23 @@ struct InstanceData
     glm::mat4 WorldToLocal;
 };
 
+// VisibleInstance of MeshPipelinePass.hlsl, one per instance the instance pass keeps
+struct VisibleInstance
+{
+    glm::vec4 FrustumPlanes[6];     // in the space of the mesh
+    glm::vec3 CameraPosition;
+    uint32_t  InstanceIndex;
+};
+
+// D3D12_DISPATCH_MESH_ARGUMENTS followed by the count of visible instances the amplification shader reads
+struct TaskArguments
+{
+    uint32_t GroupCountX;
+    uint32_t GroupCountY;
+    uint32_t GroupCountZ;
+    uint32_t VisibleInstanceCount;
+};
+
 struct ViewFrustumCB
 {
     glm::vec4 Corners[8];
@@ -40,13 +62,19 @@ public:
     static constexpr uint32_t       s_InstanceCountX = 8, s_InstanceCountY = 8, s_InstanceCountZ = 8;
     static constexpr uint32_t       s_InstancesCount = s_InstanceCountX * s_InstanceCountY * s_InstanceCountZ;
     static constexpr uint32_t       s_ASThreadGroupSize = 32;
+    static constexpr uint32_t       s_InstanceCullingGroupSize = 64;
+    static constexpr uint32_t       s_MovingInstanceCount = 16;     // bob up and down, only their records go up again
     static constexpr uint32_t       s_MaterialCount = 100;
+    static constexpr float          s_ClusterPixelError = 1.0f;     // the cut keeps the error of the DAG under it
     static constexpr DXGI_FORMAT    s_DepthStencilBufferFormat = DXGI_FORMAT_D32_FLOAT;
+    static constexpr DXGI_FORMAT    s_DepthStencilResourceFormat = DXGI_FORMAT_R32_TYPELESS;  // read by the Hi-Z build
 
 protected:
     bool Init() override;
+    void FixedUpdate(float inDeltaTime) override;
     void Tick() override;
     void Shutdown() override;
+    CameraBase* GetBenchmarkCamera() override { return &m_Camera; }
     
     bool CreateDevice();
     bool CreateRootSignature();
@@ -56,12 +84,24 @@ protected:
     bool CreateScene();
     bool CreateResources();
     void UpdateConstants();
+    void UpdateInstance(uint32_t inInstance);
+    // Scatters the records of the instances that changed since the last frame into the instance buffer
+    void RecordSceneUpdatePass();
+    // Compacts the instances in view and writes the indirect arguments of both mesh passes
+    void RecordInstanceCullingPass();
+    // Phase 0 draws the meshlets visible last frame, phase 1 the ones the Hi-Z pyramid of phase 0 shows are new
+    void RecordMeshPass(uint32_t inPhase);
     
     Microsoft::WRL::ComPtr<ID3D12RootSignature>         m_RootSignature;
     std::shared_ptr<AssetsManager::Blob>                m_AmplificationShaderBlob;
     std::shared_ptr<AssetsManager::Blob>                m_MeshShaderBlob;
     std::shared_ptr<AssetsManager::Blob>                m_PixelShaderBlob;
     Microsoft::WRL::ComPtr<ID3D12PipelineState>         m_PipelineState;
+    std::shared_ptr<AssetsManager::Blob>                m_InstanceCullingShaderBlob;
+    Microsoft::WRL::ComPtr<ID3D12PipelineState>         m_InstanceCullingPipelineState;
+    std::shared_ptr<AssetsManager::Blob>                m_SceneScatterShaderBlob;
+    Microsoft::WRL::ComPtr<ID3D12PipelineState>         m_SceneScatterPipelineState;
+    Microsoft::WRL::ComPtr<ID3D12CommandSignature>      m_TaskCommandSignature;
 
     Microsoft::WRL::ComPtr<ID3D12Resource>              m_DepthStencilBuffer;
     D3D12_CPU_DESCRIPTOR_HANDLE                         m_DsvHandle;
@@ -71,12 +111,12 @@ protected:
     std::vector<glm::vec4>                              m_PositionData;
     std::vector<glm::vec2>                              m_TexCoord0Data;
     std::shared_ptr<AssetsManager::Mesh>                m_Mesh;
-    std::vector<DirectX::Meshlet>                       m_Meshlets;
-    std::vector<uint8_t>                                m_UniqueVertexIndices;
-    std::vector<DirectX::MeshletTriangle>               m_PackedPrimitiveIndices;
-    std::vector<glm::vec4>                              m_MeshletCullData;
-    std::array<InstanceData, s_InstancesCount>          m_InstancesData;
-    uint32_t                                            m_GroupCount;
+    std::shared_ptr<ClusterDag>                         m_ClusterDag;   // every level, the amplification shader picks the cut
+    GpuScene                                            m_Scene;        // one InstanceData record per instance
+    std::array<Transform, s_InstancesCount>             m_InstanceTransforms;
+    std::array<uint32_t, s_InstancesCount>              m_InstanceSlots;
+    std::vector<uint32_t>                               m_SceneUpload;
+    float                                               m_AnimationTime = 0.0f;
     
     Microsoft::WRL::ComPtr<ID3D12Resource>              m_CameraDataBuffer;
     Microsoft::WRL::ComPtr<ID3D12Resource>              m_ViewFrustumBuffer;
@@ -87,5 +127,11 @@ protected:
     Microsoft::WRL::ComPtr<ID3D12Resource>              m_PackedPrimitiveIndicesBuffer;
     Microsoft::WRL::ComPtr<ID3D12Resource>              m_UniqueVertexIndicesBuffer;
     Microsoft::WRL::ComPtr<ID3D12Resource>              m_MeshletCullDataBuffer;
-    Microsoft::WRL::ComPtr<ID3D12Resource>              m_InstanceBuffer;
+    Microsoft::WRL::ComPtr<ID3D12Resource>              m_ClusterLodBuffer;
+    Microsoft::WRL::ComPtr<ID3D12Resource>              m_InstanceBuffer;      // persistent, written by the scatter pass only
+    Microsoft::WRL::ComPtr<ID3D12Resource>              m_SceneUploadBuffer;
+    Microsoft::WRL::ComPtr<ID3D12Resource>              m_MeshletVisibilityBuffer; // one uint per instanced meshlet
+    Microsoft::WRL::ComPtr<ID3D12Resource>              m_VisibleInstanceBuffer;
+    Microsoft::WRL::ComPtr<ID3D12Resource>              m_TaskArgumentsBuffer;
+    Microsoft::WRL::ComPtr<ID3D12Resource>              m_TaskArgumentsResetBuffer;
 };
@@ -5,7 +5,7 @@ bool MeshPipelineDx::CreateRootSignature()
 {
     Microsoft::WRL::ComPtr<ID3DBlob> errorBlob;
     Microsoft::WRL::ComPtr<ID3DBlob> signatureBlob;
-    std::array<CD3DX12_ROOT_PARAMETER, 10> rootParameters;
+    std::array<CD3DX12_ROOT_PARAMETER, 20> rootParameters;
     rootParameters[0].InitAsConstantBufferView(0, 0, D3D12_SHADER_VISIBILITY_ALL); // _CameraData
     rootParameters[1].InitAsConstantBufferView(1, 0, D3D12_SHADER_VISIBILITY_ALL); // _ViewFrustum
     rootParameters[2].InitAsConstantBufferView(2, 0, D3D12_SHADER_VISIBILITY_ALL); // _MeshInfo
@@ -16,6 +16,19 @@ bool MeshPipelineDx::CreateRootSignature()
     rootParameters[7].InitAsShaderResourceView(4, 0, D3D12_SHADER_VISIBILITY_ALL); // _UniqueVertexIndices
     rootParameters[8].InitAsShaderResourceView(5, 0, D3D12_SHADER_VISIBILITY_ALL); // _MeshletCullData
     rootParameters[9].InitAsShaderResourceView(6, 0, D3D12_SHADER_VISIBILITY_ALL); // _InstanceData
+    rootParameters[10].InitAsConstants(sizeof(HiZCullingConstants) / sizeof(uint32_t), 3, 0, D3D12_SHADER_VISIBILITY_ALL); // _CullingConstants
+    rootParameters[11].InitAsUnorderedAccessView(0, 0, D3D12_SHADER_VISIBILITY_ALL); // _MeshletVisibility
+    CD3DX12_DESCRIPTOR_RANGE hiZRange(D3D12_DESCRIPTOR_RANGE_TYPE_SRV, 1, 7);
+    rootParameters[12].InitAsDescriptorTable(1, &hiZRange, D3D12_SHADER_VISIBILITY_ALL); // _HiZ
+    rootParameters[13].InitAsShaderResourceView(8, 0, D3D12_SHADER_VISIBILITY_ALL); // _ClusterLods
+    // The instance pass shares the root signature, it writes what the amplification shader reads
+    rootParameters[14].InitAsUnorderedAccessView(1, 0, D3D12_SHADER_VISIBILITY_ALL); // _VisibleInstancesOut
+    rootParameters[15].InitAsUnorderedAccessView(2, 0, D3D12_SHADER_VISIBILITY_ALL); // _TaskArgumentsOut
+    rootParameters[16].InitAsShaderResourceView(9, 0, D3D12_SHADER_VISIBILITY_ALL); // _VisibleInstances
+    rootParameters[17].InitAsShaderResourceView(10, 0, D3D12_SHADER_VISIBILITY_ALL); // _TaskArguments
+    // So does the scatter pass of the scene, it writes the instance buffer the others read as _InstanceData
+    rootParameters[18].InitAsShaderResourceView(11, 0, D3D12_SHADER_VISIBILITY_ALL); // _SceneUpdates
+    rootParameters[19].InitAsUnorderedAccessView(3, 0, D3D12_SHADER_VISIBILITY_ALL); // _SceneRecords
     
     CD3DX12_ROOT_SIGNATURE_DESC rootSignatureDesc;
     rootSignatureDesc.Init(static_cast<uint32_t>(rootParameters.size()), rootParameters.data(), 0, nullptr, D3D12_ROOT_SIGNATURE_FLAG_NONE);
@@ -24,7 +37,7 @@ bool MeshPipelineDx::CreateRootSignature()
     if(FAILED(hr))
     {
         OUTPUT_D3D12_FAILED_RESULT(hr)
-        Log::Error("[D3D12] Failed to serialize the root signature: %s", static_cast<const char*>(errorBlob->GetBufferPointer()));
+        LOG_ERROR("[D3D12] Failed to serialize the root signature: %s", static_cast<const char*>(errorBlob->GetBufferPointer()));
         return false;
     }
 
@@ -36,7 +49,25 @@ bool MeshPipelineDx::CreateRootSignature()
     if(FAILED(hr))
     {
         OUTPUT_D3D12_FAILED_RESULT(hr)
-        Log::Error("[D3D12] Failed to create the root signature");
+        LOG_ERROR("[D3D12] Failed to create the root signature");
+        return false;
+    }
+
+    // TaskArguments, the count of visible instances after the DispatchMesh arguments is only read by the shader
+    D3D12_INDIRECT_ARGUMENT_DESC argumentDesc{};
+    argumentDesc.Type = D3D12_INDIRECT_ARGUMENT_TYPE_DISPATCH_MESH;
+
+    D3D12_COMMAND_SIGNATURE_DESC commandSignatureDesc{};
+    commandSignatureDesc.ByteStride = sizeof(TaskArguments);
+    commandSignatureDesc.NumArgumentDescs = 1;
+    commandSignatureDesc.pArgumentDescs = &argumentDesc;
+    commandSignatureDesc.NodeMask = GetNodeMask();
+
+    hr = m_DeviceHandle->CreateCommandSignature(&commandSignatureDesc, nullptr, IID_PPV_ARGS(&m_TaskCommandSignature));
+    if(FAILED(hr))
+    {
+        OUTPUT_D3D12_FAILED_RESULT(hr)
+        LOG_ERROR("[D3D12] Failed to create the task command signature");
         return false;
     }
     
@@ -49,19 +80,31 @@ bool MeshPipelineDx::CreateShader()
     m_AmplificationShaderBlob = AssetsManager::LoadShaderImmediately("VisibleCulling.as.bin");
     if(!m_AmplificationShaderBlob || m_AmplificationShaderBlob->IsEmpty())
     {
-        Log::Error("Failed to load task shader");
+        LOG_ERROR("Failed to load task shader");
         return false;
     }
     m_MeshShaderBlob = AssetsManager::LoadShaderImmediately("MeshletViewer.ms.bin");
     if(!m_MeshShaderBlob || m_MeshShaderBlob->IsEmpty())
     {
-        Log::Error("Failed to load mesh shader");
+        LOG_ERROR("Failed to load mesh shader");
         return false;
     }
     m_PixelShaderBlob = AssetsManager::LoadShaderImmediately("SolidColor.ps.bin");
     if(!m_PixelShaderBlob || m_PixelShaderBlob->IsEmpty())
     {
-        Log::Error("Failed to load pixel shader");
+        LOG_ERROR("Failed to load pixel shader");
+        return false;
+    }
+    m_InstanceCullingShaderBlob = AssetsManager::LoadShaderImmediately("InstanceCulling.cs.bin");
+    if(!m_InstanceCullingShaderBlob || m_InstanceCullingShaderBlob->IsEmpty())
+    {
+        LOG_ERROR("Failed to load instance culling shader");
+        return false;
+    }
+    m_SceneScatterShaderBlob = AssetsManager::LoadShaderImmediately("SceneScatter.cs.bin");
+    if(!m_SceneScatterShaderBlob || m_SceneScatterShaderBlob->IsEmpty())
+    {
+        LOG_ERROR("Failed to load scene scatter shader");
         return false;
     }
     return true;
@@ -89,11 +132,29 @@ bool MeshPipelineDx::CreatePipelineState()
     D3D12_PIPELINE_STATE_STREAM_DESC streamDesc;
     streamDesc.pPipelineStateSubobjectStream = &psoStream;
     streamDesc.SizeInBytes                   = sizeof(psoStream);
-    const HRESULT hr = m_DeviceHandle->CreatePipelineState(&streamDesc, IID_PPV_ARGS(&m_PipelineState));
-    if(FAILED(hr))
+    D3D12_COMPUTE_PIPELINE_STATE_DESC computePsoDesc{};
+    computePsoDesc.pRootSignature = m_RootSignature.Get();
+    computePsoDesc.NodeMask = GetNodeMask();
+    computePsoDesc.CS = CD3DX12_SHADER_BYTECODE(m_InstanceCullingShaderBlob->GetData(), m_InstanceCullingShaderBlob->GetSize());
+    D3D12_COMPUTE_PIPELINE_STATE_DESC scatterPsoDesc = computePsoDesc;
+    scatterPsoDesc.CS = CD3DX12_SHADER_BYTECODE(m_SceneScatterShaderBlob->GetData(), m_SceneScatterShaderBlob->GetSize());
+
+    const bool succeeded = CreatePipelinesParallel({ [&]()
     {
-        OUTPUT_D3D12_FAILED_RESULT(hr)
-        Log::Error("[D3D12] Failed to create the pipeline state");
+        m_PipelineState = LoadPipeline(L"MeshPipelineDx", streamDesc);
+        return m_PipelineState != nullptr;
+    }, [&]()
+    {
+        m_InstanceCullingPipelineState = LoadComputePipeline(L"InstanceCulling", computePsoDesc);
+        return m_InstanceCullingPipelineState != nullptr;
+    }, [&]()
+    {
+        m_SceneScatterPipelineState = LoadComputePipeline(L"SceneScatter", scatterPsoDesc);
+        return m_SceneScatterPipelineState != nullptr;
+    } });
+    if(!succeeded)
+    {
+        LOG_ERROR("[D3D12] Failed to create the pipeline state");
         return false;
     }
     return true;
@@ -8,7 +8,7 @@ bool MeshPipelineDx::CreateDepthStencilBuffer()
     optClear.Format = s_DepthStencilBufferFormat;
     optClear.DepthStencil.Depth = 1.0f;
     optClear.DepthStencil.Stencil = 0;
-    m_DepthStencilBuffer = CreateTexture(s_DepthStencilBufferFormat
+    m_DepthStencilBuffer = CreateTexture(s_DepthStencilResourceFormat
         , m_Width
         , m_Height
         , D3D12_RESOURCE_STATE_DEPTH_WRITE
@@ -16,9 +16,9 @@ bool MeshPipelineDx::CreateDepthStencilBuffer()
         , D3D12_RESOURCE_FLAG_ALLOW_DEPTH_STENCIL
         , &optClear);
 
-    if(m_DeviceHandle == nullptr)
+    if(m_DepthStencilBuffer == nullptr)
     {
-        Log::Error("[D3D12] Failed to create depth stencil buffer");
+        LOG_ERROR("[D3D12] Failed to create depth stencil buffer");
         return false;
     }
 
@@ -43,19 +43,9 @@ bool MeshPipelineDx::CreateScene()
     if(m_Mesh == nullptr || m_Mesh->IsEmpty())
         return false;
 
-    std::vector<DirectX::CullData> cullData;
-    if(!m_Mesh->ComputeMeshlets(m_Meshlets
-        , m_UniqueVertexIndices
-        , m_PackedPrimitiveIndices
-        , cullData))
-    {
+    m_ClusterDag = AssetsManager::LoadClusterDagImmediately("sphere.fbx", *m_Mesh);
+    if(m_ClusterDag == nullptr)
         return false;
-    }
-
-    for(auto i : cullData)
-    {
-        m_MeshletCullData.push_back(glm::vec4(i.BoundingSphere.Center.x, i.BoundingSphere.Center.y, i.BoundingSphere.Center.z, i.BoundingSphere.Radius));
-    }
 
     m_Mesh->GetPositionData(m_PositionData);
     m_Mesh->GetTexCoord0Data(m_TexCoord0Data);
@@ -67,6 +57,7 @@ bool MeshPipelineDx::CreateScene()
 
     glm::vec3 zoom(s_InstanceCountX * 2.5f, s_InstanceCountY * 2.5f, s_InstanceCountZ * 2.5f) ;
     
+    m_Scene.Init(s_InstancesCount, sizeof(InstanceData));
     for(uint32_t x = 0; x < s_InstanceCountX; x++)
     {
         for(uint32_t y = 0; y < s_InstanceCountY; y++)
@@ -74,33 +65,37 @@ bool MeshPipelineDx::CreateScene()
             for(uint32_t z = 0; z < s_InstanceCountZ; z++)
             {
                 uint32_t i = x * s_InstanceCountY * s_InstanceCountZ + y * s_InstanceCountZ + z;
-                Transform transform;
+                Transform& transform = m_InstanceTransforms[i];
                 glm::vec3 pos((float)x / (float)s_InstanceCountX, (float)y / (float)s_InstanceCountY, (float)z / (float)s_InstanceCountZ);
                 transform.SetWorldPosition(glm::mix(-zoom, zoom, pos));
                 transform.SetLocalRotation(glm::vec3(dis11(rd), dis11(rd), dis11(rd)));
-                
-                m_InstancesData[i].LocalToWorld = transform.GetLocalToWorldMatrix();
-                m_InstancesData[i].WorldToLocal = transform.GetWorldToLocalMatrix();
+
+                m_InstanceSlots[i] = m_Scene.Allocate();
+                UpdateInstance(i);
             }
         }
     }
 
-    uint32_t totalMeshletCount = s_InstancesCount * (uint32_t)m_Meshlets.size();
-    m_GroupCount = totalMeshletCount / s_ASThreadGroupSize;
-    if(totalMeshletCount % s_ASThreadGroupSize != 0)
-    {
-        m_GroupCount += 1;;
-    }
-
     m_MeshInfo.IndexCount = m_Mesh->GetIndicesCount();
     m_MeshInfo.VertexCount = m_Mesh->GetVerticesCount();
-    m_MeshInfo.MeshletCount = (uint32_t)m_Meshlets.size();
-    m_MeshInfo.InstanceCount = s_InstancesCount;
+    m_MeshInfo.MeshletCount = m_ClusterDag->GetClusterCount();
+    m_MeshInfo.InstanceCount = m_Scene.GetSlotCount();
+    m_MeshInfo.LodErrorScale = static_cast<float>(m_Height) * 0.5f / s_ClusterPixelError;
+    m_MeshInfo.ViewportSize = glm::vec2(static_cast<float>(m_Width), static_cast<float>(m_Height));
+    m_MeshInfo.BoundingSphere = m_ClusterDag->ComputeBoundingSphere();
 
     return true;
 }
 
 
+void MeshPipelineDx::UpdateInstance(uint32_t inInstance)
+{
+    InstanceData instanceData;
+    instanceData.LocalToWorld = m_InstanceTransforms[inInstance].GetLocalToWorldMatrix();
+    instanceData.WorldToLocal = m_InstanceTransforms[inInstance].GetWorldToLocalMatrix();
+    m_Scene.Update(m_InstanceSlots[inInstance], &instanceData);
+}
+
 bool MeshPipelineDx::CreateResources()
 {
     m_CameraDataBuffer = CreateBuffer(CameraData::GetAlignedByteSizes()
@@ -138,60 +133,113 @@ bool MeshPipelineDx::CreateResources()
 
     if(!m_TexCoordsBuffer.Get()) return false;
 
-    m_MeshletDataBuffer = CreateBuffer(m_Meshlets.size() * sizeof(DirectX::Meshlet)
+    m_MeshletDataBuffer = CreateBuffer(m_ClusterDag->GetClusters().size() * sizeof(ClusterDag::Cluster)
         , D3D12_RESOURCE_STATE_COPY_DEST
         , D3D12_HEAP_TYPE_DEFAULT
         , D3D12_RESOURCE_FLAG_NONE);
 
     if(!m_MeshletDataBuffer.Get()) return false;
 
-    m_PackedPrimitiveIndicesBuffer = CreateBuffer(m_PackedPrimitiveIndices.size() * sizeof(DirectX::MeshletTriangle)
+    m_PackedPrimitiveIndicesBuffer = CreateBuffer(m_ClusterDag->GetPrimitives().size() * sizeof(uint32_t)
         , D3D12_RESOURCE_STATE_COPY_DEST
         , D3D12_HEAP_TYPE_DEFAULT
         , D3D12_RESOURCE_FLAG_NONE);
 
     if(!m_PackedPrimitiveIndicesBuffer.Get()) return false;
 
-    m_UniqueVertexIndicesBuffer = CreateBuffer(m_UniqueVertexIndices.size() * sizeof(uint8_t)
+    m_UniqueVertexIndicesBuffer = CreateBuffer(m_ClusterDag->GetVertexIndices().size() * sizeof(uint32_t)
         , D3D12_RESOURCE_STATE_COPY_DEST
         , D3D12_HEAP_TYPE_DEFAULT
         , D3D12_RESOURCE_FLAG_NONE);
 
     if(!m_UniqueVertexIndicesBuffer.Get()) return false;
 
-    m_MeshletCullDataBuffer = CreateBuffer(m_MeshletCullData.size() * sizeof(glm::vec4)
+    m_MeshletCullDataBuffer = CreateBuffer(m_ClusterDag->GetCullData().size() * sizeof(ClusterDag::CullData)
         , D3D12_RESOURCE_STATE_COPY_DEST
         , D3D12_HEAP_TYPE_DEFAULT
         , D3D12_RESOURCE_FLAG_NONE);
 
     if(!m_MeshletCullDataBuffer.Get()) return false;
 
-    const size_t instanceBufferBytesSize = s_InstancesCount * sizeof(InstanceData);
-    m_InstanceBuffer = CreateBuffer(instanceBufferBytesSize
+    m_ClusterLodBuffer = CreateBuffer(m_ClusterDag->GetLods().size() * sizeof(ClusterDag::ClusterLod)
         , D3D12_RESOURCE_STATE_COPY_DEST
         , D3D12_HEAP_TYPE_DEFAULT
         , D3D12_RESOURCE_FLAG_NONE);
+
+    if(!m_ClusterLodBuffer.Get()) return false;
+
+    // Filled by the scatter pass of the first frame, every instance starts dirty
+    m_InstanceBuffer = CreateBuffer(m_Scene.GetCapacity() * m_Scene.GetRecordByteSize()
+        , D3D12_RESOURCE_STATE_UNORDERED_ACCESS
+        , D3D12_HEAP_TYPE_DEFAULT
+        , D3D12_RESOURCE_FLAG_ALLOW_UNORDERED_ACCESS);
     
     if(!m_InstanceBuffer.Get()) return false;
+    m_StateTracker.TrackResource(m_InstanceBuffer.Get(), D3D12_RESOURCE_STATE_UNORDERED_ACCESS);
+
+    m_SceneUploadBuffer = CreateBuffer(m_Scene.GetMaxUploadWords() * sizeof(uint32_t)
+        , D3D12_RESOURCE_STATE_GENERIC_READ
+        , D3D12_HEAP_TYPE_UPLOAD
+        , D3D12_RESOURCE_FLAG_NONE);
+
+    if(!m_SceneUploadBuffer.Get()) return false;
+
+    // Nothing was visible before the first frame, its second phase draws everything in view
+    const std::vector<uint32_t> meshletVisibilityData(s_InstancesCount * m_ClusterDag->GetClusterCount(), 0);
+    m_MeshletVisibilityBuffer = CreateBuffer(meshletVisibilityData.size() * sizeof(uint32_t)
+        , D3D12_RESOURCE_STATE_COPY_DEST
+        , D3D12_HEAP_TYPE_DEFAULT
+        , D3D12_RESOURCE_FLAG_ALLOW_UNORDERED_ACCESS);
+
+    if(!m_MeshletVisibilityBuffer.Get()) return false;
+    m_StateTracker.TrackResource(m_MeshletVisibilityBuffer.Get(), D3D12_RESOURCE_STATE_UNORDERED_ACCESS);
+
+    m_VisibleInstanceBuffer = CreateBuffer(s_InstancesCount * sizeof(VisibleInstance)
+        , D3D12_RESOURCE_STATE_UNORDERED_ACCESS
+        , D3D12_HEAP_TYPE_DEFAULT
+        , D3D12_RESOURCE_FLAG_ALLOW_UNORDERED_ACCESS);
+
+    if(!m_VisibleInstanceBuffer.Get()) return false;
+    m_StateTracker.TrackResource(m_VisibleInstanceBuffer.Get(), D3D12_RESOURCE_STATE_UNORDERED_ACCESS);
+
+    m_TaskArgumentsBuffer = CreateBuffer(sizeof(TaskArguments)
+        , D3D12_RESOURCE_STATE_COPY_DEST
+        , D3D12_HEAP_TYPE_DEFAULT
+        , D3D12_RESOURCE_FLAG_ALLOW_UNORDERED_ACCESS);
+
+    if(!m_TaskArgumentsBuffer.Get()) return false;
+    m_StateTracker.TrackResource(m_TaskArgumentsBuffer.Get(), D3D12_RESOURCE_STATE_COPY_DEST);
+
+    // No group and no visible instance, the instance pass grows both
+    m_TaskArgumentsResetBuffer = CreateBuffer(sizeof(TaskArguments)
+        , D3D12_RESOURCE_STATE_GENERIC_READ
+        , D3D12_HEAP_TYPE_UPLOAD
+        , D3D12_RESOURCE_FLAG_NONE);
+
+    if(!m_TaskArgumentsResetBuffer.Get()) return false;
+    const TaskArguments taskArgumentsReset = {0, 1, 1, 0};
+    WriteBufferData(m_TaskArgumentsResetBuffer.Get(), &taskArgumentsReset, sizeof(TaskArguments));
 
     BeginCommandList();
     auto stagingBuffer1 = UploadBuffer(m_VerticesBuffer.Get(), m_PositionData.data(), m_PositionData.size() * sizeof(glm::vec4));
     auto stagingBuffer2 = UploadBuffer(m_TexCoordsBuffer.Get(), m_TexCoord0Data.data(), m_TexCoord0Data.size() * sizeof(glm::vec2));
-    auto stagingBuffer3 = UploadBuffer(m_MeshletDataBuffer.Get(), m_Meshlets.data(), m_Meshlets.size() * sizeof(DirectX::Meshlet));
-    auto stagingBuffer4 = UploadBuffer(m_PackedPrimitiveIndicesBuffer.Get(), m_PackedPrimitiveIndices.data(), m_PackedPrimitiveIndices.size() * sizeof(DirectX::MeshletTriangle));
-    auto stagingBuffer5 = UploadBuffer(m_UniqueVertexIndicesBuffer.Get(), m_UniqueVertexIndices.data(), m_UniqueVertexIndices.size() * sizeof(uint8_t));
-    auto stagingBuffer6 = UploadBuffer(m_MeshletCullDataBuffer.Get(), m_MeshletCullData.data(), m_MeshletCullData.size() * sizeof(glm::vec4));
-    auto stagingBuffer7 = UploadBuffer(m_InstanceBuffer.Get(), m_InstancesData.data(), instanceBufferBytesSize);
+    auto stagingBuffer3 = UploadBuffer(m_MeshletDataBuffer.Get(), m_ClusterDag->GetClusters().data(), m_ClusterDag->GetClusters().size() * sizeof(ClusterDag::Cluster));
+    auto stagingBuffer4 = UploadBuffer(m_PackedPrimitiveIndicesBuffer.Get(), m_ClusterDag->GetPrimitives().data(), m_ClusterDag->GetPrimitives().size() * sizeof(uint32_t));
+    auto stagingBuffer5 = UploadBuffer(m_UniqueVertexIndicesBuffer.Get(), m_ClusterDag->GetVertexIndices().data(), m_ClusterDag->GetVertexIndices().size() * sizeof(uint32_t));
+    auto stagingBuffer6 = UploadBuffer(m_MeshletCullDataBuffer.Get(), m_ClusterDag->GetCullData().data(), m_ClusterDag->GetCullData().size() * sizeof(ClusterDag::CullData));
+    auto stagingBuffer7 = UploadBuffer(m_MeshletVisibilityBuffer.Get(), meshletVisibilityData.data(), meshletVisibilityData.size() * sizeof(uint32_t));
+    auto stagingBuffer8 = UploadBuffer(m_ClusterLodBuffer.Get(), m_ClusterDag->GetLods().data(), m_ClusterDag->GetLods().size() * sizeof(ClusterDag::ClusterLod));
 
     
-    std::array<CD3DX12_RESOURCE_BARRIER, 7> barriers;
+    std::array<CD3DX12_RESOURCE_BARRIER, 8> barriers;
     barriers[0] = CD3DX12_RESOURCE_BARRIER::Transition(m_VerticesBuffer.Get(), D3D12_RESOURCE_STATE_COPY_DEST, D3D12_RESOURCE_STATE_ALL_SHADER_RESOURCE);
     barriers[1] = CD3DX12_RESOURCE_BARRIER::Transition(m_TexCoordsBuffer.Get(), D3D12_RESOURCE_STATE_COPY_DEST, D3D12_RESOURCE_STATE_ALL_SHADER_RESOURCE);
     barriers[2] = CD3DX12_RESOURCE_BARRIER::Transition(m_MeshletDataBuffer.Get(), D3D12_RESOURCE_STATE_COPY_DEST, D3D12_RESOURCE_STATE_ALL_SHADER_RESOURCE);
     barriers[3] = CD3DX12_RESOURCE_BARRIER::Transition(m_PackedPrimitiveIndicesBuffer.Get(), D3D12_RESOURCE_STATE_COPY_DEST, D3D12_RESOURCE_STATE_ALL_SHADER_RESOURCE);
     barriers[4] = CD3DX12_RESOURCE_BARRIER::Transition(m_UniqueVertexIndicesBuffer.Get(), D3D12_RESOURCE_STATE_COPY_DEST, D3D12_RESOURCE_STATE_ALL_SHADER_RESOURCE);
     barriers[5] = CD3DX12_RESOURCE_BARRIER::Transition(m_MeshletCullDataBuffer.Get(), D3D12_RESOURCE_STATE_COPY_DEST, D3D12_RESOURCE_STATE_ALL_SHADER_RESOURCE);
-    barriers[6] = CD3DX12_RESOURCE_BARRIER::Transition(m_InstanceBuffer.Get(), D3D12_RESOURCE_STATE_COPY_DEST, D3D12_RESOURCE_STATE_ALL_SHADER_RESOURCE);
+    barriers[6] = CD3DX12_RESOURCE_BARRIER::Transition(m_MeshletVisibilityBuffer.Get(), D3D12_RESOURCE_STATE_COPY_DEST, D3D12_RESOURCE_STATE_UNORDERED_ACCESS);
+    barriers[7] = CD3DX12_RESOURCE_BARRIER::Transition(m_ClusterLodBuffer.Get(), D3D12_RESOURCE_STATE_COPY_DEST, D3D12_RESOURCE_STATE_ALL_SHADER_RESOURCE);
     
     m_CommandList->ResourceBarrier((uint32_t)barriers.size(), barriers.data());
     
@@ -199,6 +247,9 @@ bool MeshPipelineDx::CreateResources()
     ID3D12CommandList* commandLists[] = {m_CommandList.Get()};
     m_CommandQueueHandle->ExecuteCommandLists(1, commandLists);
     FlushCommandQueue();
+
+    if(!CreateHiZPyramid(m_DepthStencilBuffer.Get(), 0))
+        return false;
     
     return true;
 }
@@ -1,4 +1,5 @@
 #include "MeshPipelineDx.h"
+#include "CpuProfiler.h"
 
 void MeshPipelineDx::UpdateConstants()
 {
@@ -16,6 +17,92 @@ void MeshPipelineDx::UpdateConstants()
     WriteBufferData(m_ViewFrustumBuffer.Get(), &viewFrustumCB, ViewFrustumCB::GetAlignedByteSizes());
 }
 
+void MeshPipelineDx::FixedUpdate(float inDeltaTime)
+{
+    // A few instances spread over the grid bob up and down, the rest of the scene is never uploaded again
+    m_AnimationTime += inDeltaTime;
+    for(uint32_t i = 0; i < s_MovingInstanceCount; ++i)
+    {
+        const uint32_t instance = i * (s_InstancesCount / s_MovingInstanceCount);
+        Transform& transform = m_InstanceTransforms[instance];
+        const float speed = std::cos(m_AnimationTime * 2.0f + static_cast<float>(i)) * 4.0f;
+        transform.SetWorldPosition(transform.GetWorldPosition() + glm::vec3(0.0f, speed * inDeltaTime, 0.0f));
+        UpdateInstance(instance);
+    }
+}
+
+void MeshPipelineDx::RecordSceneUpdatePass()
+{
+    const uint32_t updateCount = m_Scene.GatherUpdates(m_SceneUpload);
+    PROFILE_COUNTER("Scene upload bytes", m_SceneUpload.size() * sizeof(uint32_t));
+    if(updateCount == 0)
+        return;
+    // The previous frame is done with the upload buffer, Tick waits for the queue
+    WriteBufferData(m_SceneUploadBuffer.Get(), m_SceneUpload.data(), m_SceneUpload.size() * sizeof(uint32_t));
+
+    m_CommandList->SetPipelineState(m_SceneScatterPipelineState.Get());
+    m_CommandList->SetComputeRootSignature(m_RootSignature.Get());
+    m_CommandList->SetComputeRootShaderResourceView(18, m_SceneUploadBuffer->GetGPUVirtualAddress());
+    m_CommandList->SetComputeRootUnorderedAccessView(19, m_InstanceBuffer->GetGPUVirtualAddress());
+
+    m_StateTracker.Transition(m_InstanceBuffer.Get(), D3D12_RESOURCE_STATE_UNORDERED_ACCESS);
+    m_StateTracker.Flush(m_CommandList.Get());
+    m_CommandList->Dispatch(m_Scene.GetScatterGroupCount(updateCount), 1, 1);
+}
+
+void MeshPipelineDx::RecordInstanceCullingPass()
+{
+    m_CommandList->CopyBufferRegion(m_TaskArgumentsBuffer.Get(), 0, m_TaskArgumentsResetBuffer.Get(), 0, sizeof(TaskArguments));
+
+    m_CommandList->SetPipelineState(m_InstanceCullingPipelineState.Get());
+    m_CommandList->SetComputeRootSignature(m_RootSignature.Get());
+    m_CommandList->SetComputeRootConstantBufferView(0, m_CameraDataBuffer->GetGPUVirtualAddress());
+    m_CommandList->SetComputeRootConstantBufferView(1, m_ViewFrustumBuffer->GetGPUVirtualAddress());
+    m_CommandList->SetComputeRootConstantBufferView(2, m_MeshInfoBuffer->GetGPUVirtualAddress());
+    m_CommandList->SetComputeRootShaderResourceView(9, m_InstanceBuffer->GetGPUVirtualAddress());
+    m_CommandList->SetComputeRootUnorderedAccessView(14, m_VisibleInstanceBuffer->GetGPUVirtualAddress());
+    m_CommandList->SetComputeRootUnorderedAccessView(15, m_TaskArgumentsBuffer->GetGPUVirtualAddress());
+
+    m_StateTracker.Transition(m_TaskArgumentsBuffer.Get(), D3D12_RESOURCE_STATE_UNORDERED_ACCESS);
+    m_StateTracker.Transition(m_VisibleInstanceBuffer.Get(), D3D12_RESOURCE_STATE_UNORDERED_ACCESS);
+    m_StateTracker.Transition(m_InstanceBuffer.Get(), D3D12_RESOURCE_STATE_NON_PIXEL_SHADER_RESOURCE);
+    m_StateTracker.Flush(m_CommandList.Get());
+    m_CommandList->Dispatch((s_InstancesCount + s_InstanceCullingGroupSize - 1) / s_InstanceCullingGroupSize, 1, 1);
+
+    // Both phases expand the same instances, the amplification shader also reads the count after the arguments
+    m_StateTracker.Transition(m_TaskArgumentsBuffer.Get(), D3D12_RESOURCE_STATE_INDIRECT_ARGUMENT | D3D12_RESOURCE_STATE_NON_PIXEL_SHADER_RESOURCE);
+    m_StateTracker.Transition(m_VisibleInstanceBuffer.Get(), D3D12_RESOURCE_STATE_NON_PIXEL_SHADER_RESOURCE);
+}
+
+void MeshPipelineDx::RecordMeshPass(uint32_t inPhase)
+{
+    m_CommandList->SetPipelineState(m_PipelineState.Get());
+    m_CommandList->SetGraphicsRootSignature(m_RootSignature.Get());
+    m_CommandList->SetGraphicsRootConstantBufferView(0, m_CameraDataBuffer->GetGPUVirtualAddress());
+    m_CommandList->SetGraphicsRootConstantBufferView(1, m_ViewFrustumBuffer->GetGPUVirtualAddress());
+    m_CommandList->SetGraphicsRootConstantBufferView(2, m_MeshInfoBuffer->GetGPUVirtualAddress());
+    m_CommandList->SetGraphicsRootShaderResourceView(3, m_VerticesBuffer->GetGPUVirtualAddress());
+    m_CommandList->SetGraphicsRootShaderResourceView(4, m_TexCoordsBuffer->GetGPUVirtualAddress());
+    m_CommandList->SetGraphicsRootShaderResourceView(5, m_MeshletDataBuffer->GetGPUVirtualAddress());
+    m_CommandList->SetGraphicsRootShaderResourceView(6, m_PackedPrimitiveIndicesBuffer->GetGPUVirtualAddress());
+    m_CommandList->SetGraphicsRootShaderResourceView(7, m_UniqueVertexIndicesBuffer->GetGPUVirtualAddress());
+    m_CommandList->SetGraphicsRootShaderResourceView(8, m_MeshletCullDataBuffer->GetGPUVirtualAddress());
+    m_CommandList->SetGraphicsRootShaderResourceView(9, m_InstanceBuffer->GetGPUVirtualAddress());
+    const HiZCullingConstants constants = GetHiZCullingConstants(inPhase, s_InstancesCount * m_MeshInfo.MeshletCount);
+    m_CommandList->SetGraphicsRoot32BitConstants(10, sizeof(HiZCullingConstants) / sizeof(uint32_t), &constants, 0);
+    m_CommandList->SetGraphicsRootUnorderedAccessView(11, m_MeshletVisibilityBuffer->GetGPUVirtualAddress());
+    // Phase 0 does not read the pyramid, it still needs a valid descriptor
+    m_CommandList->SetGraphicsRootDescriptorTable(12, GetHiZPyramidSrv());
+    m_CommandList->SetGraphicsRootShaderResourceView(13, m_ClusterLodBuffer->GetGPUVirtualAddress());
+    m_CommandList->SetGraphicsRootShaderResourceView(16, m_VisibleInstanceBuffer->GetGPUVirtualAddress());
+    m_CommandList->SetGraphicsRootShaderResourceView(17, m_TaskArgumentsBuffer->GetGPUVirtualAddress());
+
+    // Phase 1 overwrites what phase 0 read
+    m_StateTracker.UAVBarrier(m_MeshletVisibilityBuffer.Get());
+    m_StateTracker.Flush(m_CommandList.Get());
+    m_CommandList->ExecuteIndirect(m_TaskCommandSignature.Get(), 1, m_TaskArgumentsBuffer.Get(), 0, nullptr, 0);
+}
+
 void MeshPipelineDx::Tick()
 {
     if(!m_IsRunning)
@@ -51,24 +138,18 @@ void MeshPipelineDx::Tick()
     
     ID3D12DescriptorHeap* descriptorHeaps[] = { m_ShaderBoundViewHeap.Get(), m_SamplerHeap.Get() };
     m_CommandList->SetDescriptorHeaps(2, descriptorHeaps);
-    m_CommandList->SetPipelineState(m_PipelineState.Get());
-    m_CommandList->SetGraphicsRootSignature(m_RootSignature.Get());
-    m_CommandList->SetGraphicsRootConstantBufferView(0, m_CameraDataBuffer->GetGPUVirtualAddress());
-    m_CommandList->SetGraphicsRootConstantBufferView(1, m_ViewFrustumBuffer->GetGPUVirtualAddress());
-    m_CommandList->SetGraphicsRootConstantBufferView(2, m_MeshInfoBuffer->GetGPUVirtualAddress());
-    m_CommandList->SetGraphicsRootShaderResourceView(3, m_VerticesBuffer->GetGPUVirtualAddress());
-    m_CommandList->SetGraphicsRootShaderResourceView(4, m_TexCoordsBuffer->GetGPUVirtualAddress());
-    m_CommandList->SetGraphicsRootShaderResourceView(5, m_MeshletDataBuffer->GetGPUVirtualAddress());
-    m_CommandList->SetGraphicsRootShaderResourceView(6, m_PackedPrimitiveIndicesBuffer->GetGPUVirtualAddress());
-    m_CommandList->SetGraphicsRootShaderResourceView(7, m_UniqueVertexIndicesBuffer->GetGPUVirtualAddress());
-    m_CommandList->SetGraphicsRootShaderResourceView(8, m_MeshletCullDataBuffer->GetGPUVirtualAddress());
-    m_CommandList->SetGraphicsRootShaderResourceView(9, m_InstanceBuffer->GetGPUVirtualAddress());
-    
-    m_CommandList->DispatchMesh(m_GroupCount, 1, 1);
+    RecordSceneUpdatePass();
+    RecordInstanceCullingPass();
+    RecordMeshPass(0);
+
+    BuildHiZPyramid();
+    m_CommandList->OMSetRenderTargets(1, rtvHandle, false, &dsvHandle);
+    RecordMeshPass(1);
 
     D3D12_RESOURCE_BARRIER postBarriers;
     postBarriers = CD3DX12_RESOURCE_BARRIER::Transition(m_BackBuffers[m_CurrentIndex].Get(), D3D12_RESOURCE_STATE_RENDER_TARGET, D3D12_RESOURCE_STATE_PRESENT);
     m_CommandList->ResourceBarrier(1, &postBarriers);
+    m_StateTracker.Transition(m_TaskArgumentsBuffer.Get(), D3D12_RESOURCE_STATE_COPY_DEST);
     EndCommandList();    
 
     ID3D12CommandList* commandLists[] = {m_CommandList.Get()};
@@ -2,15 +2,16 @@
 
 int WINAPI WinMain(HINSTANCE hInstance, HINSTANCE hPrevInstance, LPSTR lpCmdLine, int nCmdShow)
 {
+    const RunOptions options = RunOptions::FromCommandLine(__argc, __argv);
     try
     {
-        std::unique_ptr<MeshPipelineDx> app = std::make_unique<MeshPipelineDx>(1280, 720, hInstance, TEXT("D3D12 Mesh Pipeline"));
+        std::unique_ptr<MeshPipelineDx> app = std::make_unique<MeshPipelineDx>(1280, 720, hInstance, TEXT("D3D12 Mesh Pipeline"), options);
         app->Run();
-        return 0;
+        return app->GetExitCode();
     }
     catch (std::runtime_error& err)
     {
-        Log::Error(err.what());
+        LOG_ERROR("%s", err.what());
         return -1;
     }
 }
\ No newline at end of file
@@ -3,6 +3,7 @@
 #include "../AppBaseVk.h"
 #include "Transform.h"
 #include "Camera.h"
+#include "GpuScene.h"
 #include "AssetsManager.h"
 #include <array>
 
@@ -12,6 +13,10 @@ struct MeshInfo
     uint32_t IndexCount;
     uint32_t MeshletCount;
     uint32_t InstanceCount;
+    float    LodErrorScale;     // half the target height over s_ClusterPixelError
+    uint32_t Padding;
+    glm::vec2 ViewportSize;     // in pixels, for the small triangle test of the mesh shader
+    glm::vec4 BoundingSphere;   // of every level of the DAG, tested once per instance
 
     static uint64_t GetAlignedByteSizes()
     {
@@ -25,6 +30,23 @@ struct InstanceData
     glm::mat4 WorldToLocal;
 };
 
+// VisibleInstance of MeshPipelinePass.hlsl, one per instance the instance pass keeps
+struct VisibleInstance
+{
+    glm::vec4 FrustumPlanes[6];     // in the space of the mesh
+    glm::vec3 CameraPosition;
+    uint32_t  InstanceIndex;
+};
+
+// VkDrawMeshTasksIndirectCommandEXT followed by the count of visible instances the task shader reads
+struct TaskArguments
+{
+    uint32_t GroupCountX;
+    uint32_t GroupCountY;
+    uint32_t GroupCountZ;
+    uint32_t VisibleInstanceCount;
+};
+
 struct ViewFrustumCB
 {
     glm::vec4 Corners[8];
@@ -41,13 +63,18 @@ public:
     static constexpr uint32_t s_InstanceCountX = 8, s_InstanceCountY = 8, s_InstanceCountZ = 8;
     static constexpr uint32_t s_InstancesCount = s_InstanceCountX * s_InstanceCountY * s_InstanceCountZ;
     static constexpr uint32_t s_ASThreadGroupSize = 32;
+    static constexpr uint32_t s_InstanceCullingGroupSize = 64;
+    static constexpr uint32_t s_MovingInstanceCount = 16;     // bob up and down, only their records go up again
     static constexpr uint32_t s_MaterialCount = 100;
+    static constexpr float s_ClusterPixelError = 1.0f;     // the cut keeps the error of the DAG under it
     static constexpr VkFormat s_DepthStencilFormat = VK_FORMAT_D32_SFLOAT;
 
 protected:
     bool Init() override;
+    void FixedUpdate(float inDeltaTime) override;
     void Tick() override;
     void Shutdown() override;
+    CameraBase* GetBenchmarkCamera() override { return &m_Camera; }
 
 private:
     bool CreateDevice() override;
@@ -70,19 +97,30 @@ private:
     bool CreateDescriptorSet();
     void DestroyDescriptorSet();
     void UpdateConstants();
+    void UpdateInstance(uint32_t inInstance);
+    // Scatters the records of the instances that changed since the last frame into the instance buffer
+    void SceneUpdatePass();
+    // Compacts the instances in view and writes the indirect arguments of the mesh pass
+    void InstanceCullingPass();
 
-    PFN_vkCmdDrawMeshTasksEXT               vkCmdDrawMeshTasksEXT;
+    PFN_vkCmdDrawMeshTasksIndirectEXT       vkCmdDrawMeshTasksIndirectEXT;
     
     VkDescriptorSetLayout                   m_DescriptorLayout;
     std::shared_ptr<AssetsManager::Blob>    m_ASBlob;
     std::shared_ptr<AssetsManager::Blob>    m_MSBlob;
     std::shared_ptr<AssetsManager::Blob>    m_PSBlob;
+    std::shared_ptr<AssetsManager::Blob>    m_InstanceCullingBlob;
+    std::shared_ptr<AssetsManager::Blob>    m_SceneScatterBlob;
     VkShaderModule                          m_ASModule;
     VkShaderModule                          m_MSModule;
     VkShaderModule                          m_PSModule;
+    VkShaderModule                          m_InstanceCullingModule;
+    VkShaderModule                          m_SceneScatterModule;
     VkRenderPass                            m_RenderPassHandle;
     VkPipelineLayout                        m_PipelineLayout;
     VkPipeline                              m_PipelineState;
+    VkPipeline                              m_InstanceCullingPipelineState;   // shares the layout of the mesh pass
+    VkPipeline                              m_SceneScatterPipelineState;      // so does this one
 
     VkDeviceMemory                          m_DepthStencilMemory;
     VkImage                                 m_DepthStencilTexture;
@@ -94,12 +132,12 @@ private:
     std::vector<glm::vec4>                              m_PositionData;
     std::vector<glm::vec2>                              m_TexCoord0Data;
     std::shared_ptr<AssetsManager::Mesh>                m_Mesh;
-    std::vector<DirectX::Meshlet>                       m_Meshlets;
-    std::vector<uint8_t>                                m_UniqueVertexIndices;
-    std::vector<DirectX::MeshletTriangle>               m_PackedPrimitiveIndices;
-    std::vector<glm::vec4>                              m_MeshletCullData;
-    std::array<InstanceData, s_InstancesCount>          m_InstancesData;
-    uint32_t                                            m_GroupCount;
+    std::shared_ptr<ClusterDag>                         m_ClusterDag;   // every level, the amplification shader picks the cut
+    GpuScene                                            m_Scene;        // one InstanceData record per instance
+    std::array<Transform, s_InstancesCount>             m_InstanceTransforms;
+    std::array<uint32_t, s_InstancesCount>              m_InstanceSlots;
+    std::vector<uint32_t>                               m_SceneUpload;
+    float                                               m_AnimationTime = 0.0f;
     
     VkBuffer                    m_CameraDataBuffer;
     VkDeviceMemory              m_CameraBufferMemory;
@@ -120,8 +158,18 @@ private:
     VkDeviceMemory              m_UniqueVertexIndicesBufferMemory;
     VkBuffer                    m_MeshletCullDataBuffer;
     VkDeviceMemory              m_MeshletCullDataBufferMemory;
-    VkBuffer                    m_InstanceBuffer;
+    VkBuffer                    m_ClusterLodBuffer;
+    VkDeviceMemory              m_ClusterLodBufferMemory;
+    VkBuffer                    m_InstanceBuffer;           // persistent, written by the scatter pass only
     VkDeviceMemory              m_InstanceBufferMemory;
+    VkBuffer                    m_SceneUploadBuffer;
+    VkDeviceMemory              m_SceneUploadBufferMemory;
+    VkBuffer                    m_VisibleInstanceBuffer;
+    VkDeviceMemory              m_VisibleInstanceBufferMemory;
+    VkBuffer                    m_TaskArgumentsBuffer;
+    VkDeviceMemory              m_TaskArgumentsBufferMemory;
+    VkBuffer                    m_TaskArgumentsResetBuffer;
+    VkDeviceMemory              m_TaskArgumentsResetBufferMemory;
 
     VkDescriptorSet             m_DescriptorSet;
 };
\ No newline at end of file
@@ -4,16 +4,23 @@
 bool MeshPipelineVk::CreateDescriptorLayout()
 {
     std::vector<VkDescriptorSetLayoutBinding> bindings;
-	bindings.push_back({GetBindingSlot(ERegisterType::ConstantBuffer, 0), VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER, 1, VK_SHADER_STAGE_TASK_BIT_EXT | VK_SHADER_STAGE_MESH_BIT_EXT, nullptr}); // _CameraData
-	bindings.push_back({GetBindingSlot(ERegisterType::ConstantBuffer, 1), VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER, 1, VK_SHADER_STAGE_TASK_BIT_EXT | VK_SHADER_STAGE_MESH_BIT_EXT, nullptr}); // _ViewFrustum
-	bindings.push_back({GetBindingSlot(ERegisterType::ConstantBuffer, 2), VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER, 1, VK_SHADER_STAGE_TASK_BIT_EXT | VK_SHADER_STAGE_MESH_BIT_EXT, nullptr}); // _MeshInfo
+	bindings.push_back({GetBindingSlot(ERegisterType::ConstantBuffer, 0), VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER, 1, VK_SHADER_STAGE_TASK_BIT_EXT | VK_SHADER_STAGE_MESH_BIT_EXT | VK_SHADER_STAGE_COMPUTE_BIT, nullptr}); // _CameraData
+	bindings.push_back({GetBindingSlot(ERegisterType::ConstantBuffer, 1), VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER, 1, VK_SHADER_STAGE_TASK_BIT_EXT | VK_SHADER_STAGE_MESH_BIT_EXT | VK_SHADER_STAGE_COMPUTE_BIT, nullptr}); // _ViewFrustum
+	bindings.push_back({GetBindingSlot(ERegisterType::ConstantBuffer, 2), VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER, 1, VK_SHADER_STAGE_TASK_BIT_EXT | VK_SHADER_STAGE_MESH_BIT_EXT | VK_SHADER_STAGE_COMPUTE_BIT, nullptr}); // _MeshInfo
 	bindings.push_back({GetBindingSlot(ERegisterType::ShaderResource, 0), VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, 1, VK_SHADER_STAGE_TASK_BIT_EXT | VK_SHADER_STAGE_MESH_BIT_EXT, nullptr}); // _Vertices
 	bindings.push_back({GetBindingSlot(ERegisterType::ShaderResource, 1), VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, 1, VK_SHADER_STAGE_TASK_BIT_EXT | VK_SHADER_STAGE_MESH_BIT_EXT, nullptr}); // _TexCoords
 	bindings.push_back({GetBindingSlot(ERegisterType::ShaderResource, 2), VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, 1, VK_SHADER_STAGE_TASK_BIT_EXT | VK_SHADER_STAGE_MESH_BIT_EXT, nullptr}); // _Meshlets
 	bindings.push_back({GetBindingSlot(ERegisterType::ShaderResource, 3), VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, 1, VK_SHADER_STAGE_TASK_BIT_EXT | VK_SHADER_STAGE_MESH_BIT_EXT, nullptr}); // _PackedPrimitiveIndices
 	bindings.push_back({GetBindingSlot(ERegisterType::ShaderResource, 4), VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, 1, VK_SHADER_STAGE_TASK_BIT_EXT | VK_SHADER_STAGE_MESH_BIT_EXT, nullptr}); // _UniqueVertexIndices
 	bindings.push_back({GetBindingSlot(ERegisterType::ShaderResource, 5), VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, 1, VK_SHADER_STAGE_TASK_BIT_EXT | VK_SHADER_STAGE_MESH_BIT_EXT, nullptr}); // _MeshletCullData
-	bindings.push_back({GetBindingSlot(ERegisterType::ShaderResource, 6), VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, 1, VK_SHADER_STAGE_TASK_BIT_EXT | VK_SHADER_STAGE_MESH_BIT_EXT, nullptr}); // _InstanceData
+	bindings.push_back({GetBindingSlot(ERegisterType::ShaderResource, 6), VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, 1, VK_SHADER_STAGE_TASK_BIT_EXT | VK_SHADER_STAGE_MESH_BIT_EXT | VK_SHADER_STAGE_COMPUTE_BIT, nullptr}); // _InstanceData
+	bindings.push_back({GetBindingSlot(ERegisterType::ShaderResource, 8), VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, 1, VK_SHADER_STAGE_TASK_BIT_EXT, nullptr}); // _ClusterLods
+	bindings.push_back({GetBindingSlot(ERegisterType::ShaderResource, 9), VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, 1, VK_SHADER_STAGE_TASK_BIT_EXT, nullptr}); // _VisibleInstances
+	bindings.push_back({GetBindingSlot(ERegisterType::ShaderResource, 10), VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, 1, VK_SHADER_STAGE_TASK_BIT_EXT, nullptr}); // _TaskArguments
+	bindings.push_back({GetBindingSlot(ERegisterType::UnorderedAccess, 1), VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, 1, VK_SHADER_STAGE_COMPUTE_BIT, nullptr}); // _VisibleInstancesOut
+	bindings.push_back({GetBindingSlot(ERegisterType::UnorderedAccess, 2), VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, 1, VK_SHADER_STAGE_COMPUTE_BIT, nullptr}); // _TaskArgumentsOut
+	bindings.push_back({GetBindingSlot(ERegisterType::ShaderResource, 11), VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, 1, VK_SHADER_STAGE_COMPUTE_BIT, nullptr}); // _SceneUpdates
+	bindings.push_back({GetBindingSlot(ERegisterType::UnorderedAccess, 3), VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, 1, VK_SHADER_STAGE_COMPUTE_BIT, nullptr}); // _SceneRecords
 
     VkDescriptorSetLayoutCreateInfo layoutInfo{};
     layoutInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_LAYOUT_CREATE_INFO;
@@ -23,7 +30,7 @@ bool MeshPipelineVk::CreateDescriptorLayout()
     VkResult result = vkCreateDescriptorSetLayout(m_DeviceHandle, &layoutInfo, nullptr, &m_DescriptorLayout);
     if(result != VK_SUCCESS)
     {
-        Log::Error("Failed to create descriptor set layout");
+        LOG_ERROR("Failed to create descriptor set layout");
         return false;
     }
 	
@@ -44,19 +51,31 @@ bool MeshPipelineVk::CreateShader()
     m_ASBlob = AssetsManager::LoadShaderImmediately("VisibleCulling.as.spv");
     if(!m_ASBlob || m_ASBlob->IsEmpty())
     {
-        Log::Error("Failed to load task shader");
+        LOG_ERROR("Failed to load task shader");
         return false;
     }
     m_MSBlob = AssetsManager::LoadShaderImmediately("MeshletViewer.ms.spv");
     if(!m_MSBlob || m_MSBlob->IsEmpty())
     {
-        Log::Error("Failed to load mesh shader");
+        LOG_ERROR("Failed to load mesh shader");
         return false;
     }
 	m_PSBlob = AssetsManager::LoadShaderImmediately("SolidColor.ps.spv");
 	if(!m_PSBlob || m_PSBlob->IsEmpty())
 	{
-		Log::Error("Failed to load pixel shader");
+		LOG_ERROR("Failed to load pixel shader");
+		return false;
+	}
+	m_InstanceCullingBlob = AssetsManager::LoadShaderImmediately("InstanceCulling.cs.spv");
+	if(!m_InstanceCullingBlob || m_InstanceCullingBlob->IsEmpty())
+	{
+		LOG_ERROR("Failed to load instance culling shader");
+		return false;
+	}
+	m_SceneScatterBlob = AssetsManager::LoadShaderImmediately("SceneScatter.cs.spv");
+	if(!m_SceneScatterBlob || m_SceneScatterBlob->IsEmpty())
+	{
+		LOG_ERROR("Failed to load scene scatter shader");
 		return false;
 	}
 
@@ -67,7 +86,7 @@ bool MeshPipelineVk::CreateShader()
     VkResult result = vkCreateShaderModule(m_DeviceHandle, &shaderInfo, nullptr, &m_ASModule);
 	if(result != VK_SUCCESS)
 	{
-		Log::Error("Failed to create task shader");
+		LOG_ERROR("Failed to create task shader");
 		return false;
 	}
 
@@ -76,7 +95,7 @@ bool MeshPipelineVk::CreateShader()
 	result = vkCreateShaderModule(m_DeviceHandle, &shaderInfo, nullptr, &m_MSModule);
 	if(result != VK_SUCCESS)
 	{
-		Log::Error("Failed to create mesh shader");
+		LOG_ERROR("Failed to create mesh shader");
 		return false;
 	}
 
@@ -85,7 +104,25 @@ bool MeshPipelineVk::CreateShader()
     result = vkCreateShaderModule(m_DeviceHandle, &shaderInfo, nullptr, &m_PSModule);
 	if(result != VK_SUCCESS)
 	{
-		Log::Error("Failed to create pixel shader");
+		LOG_ERROR("Failed to create pixel shader");
+		return false;
+	}
+
+    shaderInfo.codeSize = m_InstanceCullingBlob->GetSize();
+    shaderInfo.pCode = reinterpret_cast<const uint32_t*>(m_InstanceCullingBlob->GetData());
+    result = vkCreateShaderModule(m_DeviceHandle, &shaderInfo, nullptr, &m_InstanceCullingModule);
+	if(result != VK_SUCCESS)
+	{
+		LOG_ERROR("Failed to create instance culling shader");
+		return false;
+	}
+
+    shaderInfo.codeSize = m_SceneScatterBlob->GetSize();
+    shaderInfo.pCode = reinterpret_cast<const uint32_t*>(m_SceneScatterBlob->GetData());
+    result = vkCreateShaderModule(m_DeviceHandle, &shaderInfo, nullptr, &m_SceneScatterModule);
+	if(result != VK_SUCCESS)
+	{
+		LOG_ERROR("Failed to create scene scatter shader");
 		return false;
 	}
 	
@@ -111,6 +148,18 @@ void MeshPipelineVk::DestroyShader()
         vkDestroyShaderModule(m_DeviceHandle, m_PSModule, nullptr);
         m_PSModule = VK_NULL_HANDLE;
     }
+
+    if(m_InstanceCullingModule != VK_NULL_HANDLE)
+    {
+        vkDestroyShaderModule(m_DeviceHandle, m_InstanceCullingModule, nullptr);
+        m_InstanceCullingModule = VK_NULL_HANDLE;
+    }
+
+    if(m_SceneScatterModule != VK_NULL_HANDLE)
+    {
+        vkDestroyShaderModule(m_DeviceHandle, m_SceneScatterModule, nullptr);
+        m_SceneScatterModule = VK_NULL_HANDLE;
+    }
 }
 
 bool MeshPipelineVk::CreateRenderPass()
@@ -170,7 +219,7 @@ bool MeshPipelineVk::CreateRenderPass()
 	VkResult result = vkCreateRenderPass(m_DeviceHandle, &renderPassInfo, nullptr, &m_RenderPassHandle);
 	if(result != VK_SUCCESS)
 	{
-		Log::Error("Failed to create render pass");
+		LOG_ERROR("Failed to create render pass");
 		return false;
 	}
 	
@@ -196,7 +245,7 @@ bool MeshPipelineVk::CreatePipelineState()
 	VkResult result = vkCreatePipelineLayout(m_DeviceHandle, &pipelineLayoutInfo, nullptr, &m_PipelineLayout);
 	if(result != VK_SUCCESS)
 	{
-		Log::Error("Failed to create pipeline layout");
+		LOG_ERROR("Failed to create pipeline layout");
 		return false;
 	}
 
@@ -278,10 +327,24 @@ bool MeshPipelineVk::CreatePipelineState()
 	pipelineInfo.basePipelineHandle = VK_NULL_HANDLE;
 	pipelineInfo.basePipelineIndex = -1;
 
-	result = vkCreateGraphicsPipelines(m_DeviceHandle, VK_NULL_HANDLE, 1, &pipelineInfo, nullptr, &m_PipelineState);
-	if(result != VK_SUCCESS)
+	VkComputePipelineCreateInfo computePipelineInfo{};
+	computePipelineInfo.sType = VK_STRUCTURE_TYPE_COMPUTE_PIPELINE_CREATE_INFO;
+	computePipelineInfo.stage = {VK_STRUCTURE_TYPE_PIPELINE_SHADER_STAGE_CREATE_INFO, nullptr, 0, VK_SHADER_STAGE_COMPUTE_BIT, m_InstanceCullingModule, "main", nullptr};
+	computePipelineInfo.layout = m_PipelineLayout;
+	computePipelineInfo.basePipelineHandle = VK_NULL_HANDLE;
+	computePipelineInfo.basePipelineIndex = -1;
+
+	VkComputePipelineCreateInfo scatterPipelineInfo = computePipelineInfo;
+	scatterPipelineInfo.stage.module = m_SceneScatterModule;
+
+	const bool succeeded = CreatePipelinesParallel({
+		[&]() { return vkCreateGraphicsPipelines(m_DeviceHandle, m_PipelineCacheHandle, 1, &pipelineInfo, nullptr, &m_PipelineState) == VK_SUCCESS; },
+		[&]() { return vkCreateComputePipelines(m_DeviceHandle, m_PipelineCacheHandle, 1, &computePipelineInfo, nullptr, &m_InstanceCullingPipelineState) == VK_SUCCESS; },
+		[&]() { return vkCreateComputePipelines(m_DeviceHandle, m_PipelineCacheHandle, 1, &scatterPipelineInfo, nullptr, &m_SceneScatterPipelineState) == VK_SUCCESS; }
+	});
+	if(!succeeded)
 	{
-		Log::Error("Failed to create pipeline");
+		LOG_ERROR("Failed to create pipeline");
 		return false;
 	}
 	
@@ -295,6 +358,18 @@ void MeshPipelineVk::DestroyPipelineState()
 		vkDestroyPipeline(m_DeviceHandle, m_PipelineState, nullptr);
 		m_PipelineState = VK_NULL_HANDLE;
 	}
+
+	if(m_InstanceCullingPipelineState != VK_NULL_HANDLE)
+	{
+		vkDestroyPipeline(m_DeviceHandle, m_InstanceCullingPipelineState, nullptr);
+		m_InstanceCullingPipelineState = VK_NULL_HANDLE;
+	}
+
+	if(m_SceneScatterPipelineState != VK_NULL_HANDLE)
+	{
+		vkDestroyPipeline(m_DeviceHandle, m_SceneScatterPipelineState, nullptr);
+		m_SceneScatterPipelineState = VK_NULL_HANDLE;
+	}
 	
     if(m_PipelineLayout != VK_NULL_HANDLE)
 	{
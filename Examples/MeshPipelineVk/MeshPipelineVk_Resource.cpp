@@ -12,7 +12,7 @@ bool MeshPipelineVk::CreateDepthStencilBuffer()
         , m_DepthStencilTexture
         , m_DepthStencilMemory))
     {
-        Log::Error("Failed to create depth stencil texture");
+        LOG_ERROR("Failed to create depth stencil texture");
         return false;
     }
 
@@ -21,7 +21,7 @@ bool MeshPipelineVk::CreateDepthStencilBuffer()
         , VK_IMAGE_ASPECT_DEPTH_BIT
         , m_Dsv))
     {
-        Log::Error("Failed to create depth stencil view");
+        LOG_ERROR("Failed to create depth stencil view");
         return false;
     }
     
@@ -68,7 +68,7 @@ bool MeshPipelineVk::CreateFrameBuffer()
 
         if(vkCreateFramebuffer(m_DeviceHandle, &frameBufferInfo, nullptr, &m_FrameBuffers[i]) != VK_SUCCESS)
         {
-            Log::Error("Failed to create frame buffer");
+            LOG_ERROR("Failed to create frame buffer");
             return false;
         }
     }
@@ -96,19 +96,9 @@ bool MeshPipelineVk::CreateScene()
     if(m_Mesh == nullptr || m_Mesh->IsEmpty())
         return false;
 
-    std::vector<DirectX::CullData> cullData;
-    if(!m_Mesh->ComputeMeshlets(m_Meshlets
-        , m_UniqueVertexIndices
-        , m_PackedPrimitiveIndices
-        , cullData))
-    {
+    m_ClusterDag = AssetsManager::LoadClusterDagImmediately("sphere.fbx", *m_Mesh);
+    if(m_ClusterDag == nullptr)
         return false;
-    }
-
-    for(auto i : cullData)
-    {
-        m_MeshletCullData.push_back(glm::vec4(i.BoundingSphere.Center.x, i.BoundingSphere.Center.y, i.BoundingSphere.Center.z, i.BoundingSphere.Radius));
-    }
 
     m_Mesh->GetPositionData(m_PositionData);
     m_Mesh->GetTexCoord0Data(m_TexCoord0Data);
@@ -120,6 +110,7 @@ bool MeshPipelineVk::CreateScene()
 
     glm::vec3 zoom(s_InstanceCountX * 2.5f, s_InstanceCountY * 2.5f, s_InstanceCountZ * 2.5f) ;
     
+    m_Scene.Init(s_InstancesCount, sizeof(InstanceData));
     for(uint32_t x = 0; x < s_InstanceCountX; x++)
     {
         for(uint32_t y = 0; y < s_InstanceCountY; y++)
@@ -127,32 +118,36 @@ bool MeshPipelineVk::CreateScene()
             for(uint32_t z = 0; z < s_InstanceCountZ; z++)
             {
                 uint32_t i = x * s_InstanceCountY * s_InstanceCountZ + y * s_InstanceCountZ + z;
-                Transform transform;
+                Transform& transform = m_InstanceTransforms[i];
                 glm::vec3 pos((float)x / (float)s_InstanceCountX, (float)y / (float)s_InstanceCountY, (float)z / (float)s_InstanceCountZ);
                 transform.SetWorldPosition(glm::mix(-zoom, zoom, pos));
                 transform.SetLocalRotation(glm::vec3(dis11(rd), dis11(rd), dis11(rd)));
-                
-                m_InstancesData[i].LocalToWorld = transform.GetLocalToWorldMatrix();
-                m_InstancesData[i].WorldToLocal = transform.GetWorldToLocalMatrix();
+
+                m_InstanceSlots[i] = m_Scene.Allocate();
+                UpdateInstance(i);
             }
         }
     }
 
-    uint32_t totalMeshletCount = s_InstancesCount * (uint32_t)m_Meshlets.size();
-    m_GroupCount = totalMeshletCount / s_ASThreadGroupSize;
-    if(totalMeshletCount % s_ASThreadGroupSize != 0)
-    {
-        m_GroupCount += 1;;
-    }
-
     m_MeshInfo.IndexCount = m_Mesh->GetIndicesCount();
     m_MeshInfo.VertexCount = m_Mesh->GetVerticesCount();
-    m_MeshInfo.MeshletCount = (uint32_t)m_Meshlets.size();
-    m_MeshInfo.InstanceCount = s_InstancesCount;
+    m_MeshInfo.MeshletCount = m_ClusterDag->GetClusterCount();
+    m_MeshInfo.InstanceCount = m_Scene.GetSlotCount();
+    m_MeshInfo.LodErrorScale = static_cast<float>(m_Height) * 0.5f / s_ClusterPixelError;
+    m_MeshInfo.ViewportSize = glm::vec2(static_cast<float>(m_Width), static_cast<float>(m_Height));
+    m_MeshInfo.BoundingSphere = m_ClusterDag->ComputeBoundingSphere();
 
     return true;
 }
 
+void MeshPipelineVk::UpdateInstance(uint32_t inInstance)
+{
+    InstanceData instanceData;
+    instanceData.LocalToWorld = m_InstanceTransforms[inInstance].GetLocalToWorldMatrix();
+    instanceData.WorldToLocal = m_InstanceTransforms[inInstance].GetWorldToLocalMatrix();
+    m_Scene.Update(m_InstanceSlots[inInstance], &instanceData);
+}
+
 bool MeshPipelineVk::CreateResources()
 {
     if(!CreateBuffer(CameraData::GetAlignedByteSizes()
@@ -161,7 +156,7 @@ bool MeshPipelineVk::CreateResources()
         , m_CameraDataBuffer
         , m_CameraBufferMemory))
     {
-        Log::Error("Failed to create camera data buffer");
+        LOG_ERROR("Failed to create camera data buffer");
         return false;
     }
 
@@ -171,7 +166,7 @@ bool MeshPipelineVk::CreateResources()
         , m_ViewFrustumBuffer
         , m_ViewFrustumBufferMemory))
     {
-        Log::Error("Failed to create view frustum buffer");
+        LOG_ERROR("Failed to create view frustum buffer");
         return false;
     }
 
@@ -181,7 +176,7 @@ bool MeshPipelineVk::CreateResources()
         , m_MeshInfoBuffer
         , m_MeshInfoBufferMemory))
     {
-        Log::Error("Failed to create mesh info buffer");
+        LOG_ERROR("Failed to create mesh info buffer");
         return false;
     }
 
@@ -193,7 +188,7 @@ bool MeshPipelineVk::CreateResources()
         , m_VerticesBuffer
         , m_VerticesBufferMemory))
     {
-        Log::Error("Failed to create vertex buffer");
+        LOG_ERROR("Failed to create vertex buffer");
         return false;
     }
 
@@ -203,60 +198,113 @@ bool MeshPipelineVk::CreateResources()
         , m_TexCoordsBuffer
         , m_TexCoordsBufferMemory))
     {
-        Log::Error("Failed to create index buffer");
+        LOG_ERROR("Failed to create index buffer");
         return false;
     }
 
-    if(!CreateBuffer(m_Meshlets.size() * sizeof(DirectX::Meshlet)
+    if(!CreateBuffer(m_ClusterDag->GetClusters().size() * sizeof(ClusterDag::Cluster)
         , VK_BUFFER_USAGE_STORAGE_BUFFER_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT
         , VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT
         , m_MeshletsBuffer
         , m_MeshletsBufferMemory))
     {
-        Log::Error("Failed to create meshlets buffer");
+        LOG_ERROR("Failed to create meshlets buffer");
         return false;
     }
 
-    if(!CreateBuffer(m_PackedPrimitiveIndices.size() * sizeof(DirectX::MeshletTriangle)
+    if(!CreateBuffer(m_ClusterDag->GetPrimitives().size() * sizeof(uint32_t)
         , VK_BUFFER_USAGE_STORAGE_BUFFER_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT
         , VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT
         , m_PackedPrimitiveIndicesBuffer
         , m_PackedPrimitiveIndicesBufferMemory))
     {
-        Log::Error("Failed to create packed primitive indices buffer");
+        LOG_ERROR("Failed to create packed primitive indices buffer");
         return false;
     }
 
-    if(!CreateBuffer(m_UniqueVertexIndices.size() * sizeof(uint8_t)
+    if(!CreateBuffer(m_ClusterDag->GetVertexIndices().size() * sizeof(uint32_t)
         , VK_BUFFER_USAGE_STORAGE_BUFFER_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT
         , VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT
         , m_UniqueVertexIndicesBuffer
         , m_UniqueVertexIndicesBufferMemory))
     {
-        Log::Error("Failed to create unique vertex indices buffer");
+        LOG_ERROR("Failed to create unique vertex indices buffer");
         return false;
     }
 
-    if(!CreateBuffer(m_MeshletCullData.size() * sizeof(glm::vec4)
+    if(!CreateBuffer(m_ClusterDag->GetCullData().size() * sizeof(ClusterDag::CullData)
         , VK_BUFFER_USAGE_STORAGE_BUFFER_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT
         , VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT
         , m_MeshletCullDataBuffer
         , m_MeshletCullDataBufferMemory))
     {
-        Log::Error("Failed to create meshlet cull data buffer");
+        LOG_ERROR("Failed to create meshlet cull data buffer");
         return false;
     }
-    
-    const size_t instanceBufferBytesSize = s_InstancesCount * sizeof(InstanceData);
-    if(!CreateBuffer(instanceBufferBytesSize
+
+    if(!CreateBuffer(m_ClusterDag->GetLods().size() * sizeof(ClusterDag::ClusterLod)
         , VK_BUFFER_USAGE_STORAGE_BUFFER_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT
         , VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT
+        , m_ClusterLodBuffer
+        , m_ClusterLodBufferMemory))
+    {
+        LOG_ERROR("Failed to create cluster LOD buffer");
+        return false;
+    }
+    
+    // Filled by the scatter pass of the first frame, every instance starts dirty
+    if(!CreateBuffer(m_Scene.GetCapacity() * m_Scene.GetRecordByteSize()
+        , VK_BUFFER_USAGE_STORAGE_BUFFER_BIT
+        , VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT
         , m_InstanceBuffer
         , m_InstanceBufferMemory))
     {
-        Log::Error("Failed to create instance buffer");
+        LOG_ERROR("Failed to create instance buffer");
+        return false;
+    }
+
+    if(!CreateBuffer(m_Scene.GetMaxUploadWords() * sizeof(uint32_t)
+        , VK_BUFFER_USAGE_STORAGE_BUFFER_BIT
+        , VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT
+        , m_SceneUploadBuffer
+        , m_SceneUploadBufferMemory))
+    {
+        LOG_ERROR("Failed to create scene upload buffer");
+        return false;
+    }
+
+    if(!CreateBuffer(s_InstancesCount * sizeof(VisibleInstance)
+        , VK_BUFFER_USAGE_STORAGE_BUFFER_BIT
+        , VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT
+        , m_VisibleInstanceBuffer
+        , m_VisibleInstanceBufferMemory))
+    {
+        LOG_ERROR("Failed to create visible instance buffer");
+        return false;
+    }
+
+    if(!CreateBuffer(sizeof(TaskArguments)
+        , VK_BUFFER_USAGE_STORAGE_BUFFER_BIT | VK_BUFFER_USAGE_INDIRECT_BUFFER_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT
+        , VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT
+        , m_TaskArgumentsBuffer
+        , m_TaskArgumentsBufferMemory))
+    {
+        LOG_ERROR("Failed to create task arguments buffer");
         return false;
     }
+
+    // No group and no visible instance, the instance pass grows both
+    if(!CreateBuffer(sizeof(TaskArguments)
+        , VK_BUFFER_USAGE_TRANSFER_SRC_BIT
+        , VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT
+        , m_TaskArgumentsResetBuffer
+        , m_TaskArgumentsResetBufferMemory))
+    {
+        LOG_ERROR("Failed to create task arguments reset buffer");
+        return false;
+    }
+    const TaskArguments taskArgumentsReset = {0, 1, 1, 0};
+    WriteBufferData(m_DeviceHandle, m_TaskArgumentsResetBufferMemory, &taskArgumentsReset, sizeof(TaskArguments));
     
 
     std::vector<std::shared_ptr<StagingBuffer>> stagingBuffers(7);
@@ -265,11 +313,11 @@ bool MeshPipelineVk::CreateResources()
 
     stagingBuffers[0] = UploadBuffer(m_VerticesBuffer, m_PositionData.data(), m_PositionData.size() * sizeof(glm::vec4));
     stagingBuffers[1] = UploadBuffer(m_TexCoordsBuffer, m_TexCoord0Data.data(), m_TexCoord0Data.size() * sizeof(glm::vec2));
-    stagingBuffers[2] = UploadBuffer(m_MeshletsBuffer, m_Meshlets.data(), m_Meshlets.size() * sizeof(DirectX::Meshlet));
-    stagingBuffers[3] = UploadBuffer(m_PackedPrimitiveIndicesBuffer, m_PackedPrimitiveIndices.data(), m_PackedPrimitiveIndices.size() * sizeof(DirectX::MeshletTriangle));
-    stagingBuffers[4] = UploadBuffer(m_UniqueVertexIndicesBuffer, m_UniqueVertexIndices.data(), m_UniqueVertexIndices.size() * sizeof(uint8_t));
-    stagingBuffers[5] = UploadBuffer(m_MeshletCullDataBuffer, m_MeshletCullData.data(), m_MeshletCullData.size() * sizeof(glm::vec4));
-    stagingBuffers[6] = UploadBuffer(m_InstanceBuffer, m_InstancesData.data(), instanceBufferBytesSize);
+    stagingBuffers[2] = UploadBuffer(m_MeshletsBuffer, m_ClusterDag->GetClusters().data(), m_ClusterDag->GetClusters().size() * sizeof(ClusterDag::Cluster));
+    stagingBuffers[3] = UploadBuffer(m_PackedPrimitiveIndicesBuffer, m_ClusterDag->GetPrimitives().data(), m_ClusterDag->GetPrimitives().size() * sizeof(uint32_t));
+    stagingBuffers[4] = UploadBuffer(m_UniqueVertexIndicesBuffer, m_ClusterDag->GetVertexIndices().data(), m_ClusterDag->GetVertexIndices().size() * sizeof(uint32_t));
+    stagingBuffers[5] = UploadBuffer(m_MeshletCullDataBuffer, m_ClusterDag->GetCullData().data(), m_ClusterDag->GetCullData().size() * sizeof(ClusterDag::CullData));
+    stagingBuffers[6] = UploadBuffer(m_ClusterLodBuffer, m_ClusterDag->GetLods().data(), m_ClusterDag->GetLods().size() * sizeof(ClusterDag::ClusterLod));
     
     EndCommandList();
 
@@ -280,6 +328,50 @@ bool MeshPipelineVk::CreateResources()
 
 void MeshPipelineVk::DestroyResources()
 {
+    if(m_TaskArgumentsResetBufferMemory != VK_NULL_HANDLE)
+    {
+        vkFreeMemory(m_DeviceHandle, m_TaskArgumentsResetBufferMemory, nullptr);
+        m_TaskArgumentsResetBufferMemory = VK_NULL_HANDLE;
+    }
+    if(m_TaskArgumentsResetBuffer != VK_NULL_HANDLE)
+    {
+        vkDestroyBuffer(m_DeviceHandle, m_TaskArgumentsResetBuffer, nullptr);
+        m_TaskArgumentsResetBuffer = VK_NULL_HANDLE;
+    }
+
+    if(m_TaskArgumentsBufferMemory != VK_NULL_HANDLE)
+    {
+        vkFreeMemory(m_DeviceHandle, m_TaskArgumentsBufferMemory, nullptr);
+        m_TaskArgumentsBufferMemory = VK_NULL_HANDLE;
+    }
+    if(m_TaskArgumentsBuffer != VK_NULL_HANDLE)
+    {
+        vkDestroyBuffer(m_DeviceHandle, m_TaskArgumentsBuffer, nullptr);
+        m_TaskArgumentsBuffer = VK_NULL_HANDLE;
+    }
+
+    if(m_VisibleInstanceBufferMemory != VK_NULL_HANDLE)
+    {
+        vkFreeMemory(m_DeviceHandle, m_VisibleInstanceBufferMemory, nullptr);
+        m_VisibleInstanceBufferMemory = VK_NULL_HANDLE;
+    }
+    if(m_VisibleInstanceBuffer != VK_NULL_HANDLE)
+    {
+        vkDestroyBuffer(m_DeviceHandle, m_VisibleInstanceBuffer, nullptr);
+        m_VisibleInstanceBuffer = VK_NULL_HANDLE;
+    }
+
+    if(m_SceneUploadBufferMemory != VK_NULL_HANDLE)
+    {
+        vkFreeMemory(m_DeviceHandle, m_SceneUploadBufferMemory, nullptr);
+        m_SceneUploadBufferMemory = VK_NULL_HANDLE;
+    }
+    if(m_SceneUploadBuffer != VK_NULL_HANDLE)
+    {
+        vkDestroyBuffer(m_DeviceHandle, m_SceneUploadBuffer, nullptr);
+        m_SceneUploadBuffer = VK_NULL_HANDLE;
+    }
+
     if(m_InstanceBufferMemory != VK_NULL_HANDLE)
     {
         vkFreeMemory(m_DeviceHandle, m_InstanceBufferMemory, nullptr);
@@ -291,6 +383,17 @@ void MeshPipelineVk::DestroyResources()
         m_InstanceBuffer = VK_NULL_HANDLE;
     }
 
+    if(m_ClusterLodBufferMemory != VK_NULL_HANDLE)
+    {
+        vkFreeMemory(m_DeviceHandle, m_ClusterLodBufferMemory, nullptr);
+        m_ClusterLodBufferMemory = VK_NULL_HANDLE;
+    }
+    if(m_ClusterLodBuffer != VK_NULL_HANDLE)
+    {
+        vkDestroyBuffer(m_DeviceHandle, m_ClusterLodBuffer, nullptr);
+        m_ClusterLodBuffer = VK_NULL_HANDLE;
+    }
+
     if(m_MeshletCullDataBufferMemory != VK_NULL_HANDLE)
     {
         vkFreeMemory(m_DeviceHandle, m_MeshletCullDataBufferMemory, nullptr);
@@ -400,11 +503,11 @@ bool MeshPipelineVk::CreateDescriptorSet()
     descriptorSetAllocInfo.descriptorSetCount = 1;
     if(vkAllocateDescriptorSets(m_DeviceHandle, &descriptorSetAllocInfo, &m_DescriptorSet) != VK_SUCCESS)
     {
-        Log::Error("Failed to allocate descriptor set");
+        LOG_ERROR("Failed to allocate descriptor set");
         return false;
     }
 
-    std::array<VkWriteDescriptorSet, 10> descriptorWrites{};
+    std::array<VkWriteDescriptorSet, 17> descriptorWrites{};
     VkDescriptorBufferInfo cameraBufferInfo = CreateDescriptorBufferInfo(m_CameraDataBuffer, CameraData::GetAlignedByteSizes());
     UpdateBufferDescriptor(descriptorWrites[0], m_DescriptorSet, VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER, &cameraBufferInfo, GetBindingSlot(ERegisterType::ConstantBuffer, 0)); // _CameraData 
     
@@ -421,20 +524,36 @@ bool MeshPipelineVk::CreateDescriptorSet()
     VkDescriptorBufferInfo texCoordsBufferInfo = CreateDescriptorBufferInfo(m_TexCoordsBuffer, m_TexCoord0Data.size() * sizeof(glm::vec2));
     UpdateBufferDescriptor(descriptorWrites[4], m_DescriptorSet, VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, &texCoordsBufferInfo, GetBindingSlot(ERegisterType::ShaderResource, 1)); // _TexCoords
 
-    VkDescriptorBufferInfo meshletsBufferInfo = CreateDescriptorBufferInfo(m_MeshletsBuffer, m_Meshlets.size() * sizeof(DirectX::Meshlet));
+    VkDescriptorBufferInfo meshletsBufferInfo = CreateDescriptorBufferInfo(m_MeshletsBuffer, m_ClusterDag->GetClusters().size() * sizeof(ClusterDag::Cluster));
     UpdateBufferDescriptor(descriptorWrites[5], m_DescriptorSet, VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, &meshletsBufferInfo, GetBindingSlot(ERegisterType::ShaderResource, 2)); // _Meshlets
 
-    VkDescriptorBufferInfo packedPrimitiveIndicesBufferInfo = CreateDescriptorBufferInfo(m_PackedPrimitiveIndicesBuffer, m_PackedPrimitiveIndices.size() * sizeof(DirectX::MeshletTriangle));
+    VkDescriptorBufferInfo packedPrimitiveIndicesBufferInfo = CreateDescriptorBufferInfo(m_PackedPrimitiveIndicesBuffer, m_ClusterDag->GetPrimitives().size() * sizeof(uint32_t));
     UpdateBufferDescriptor(descriptorWrites[6], m_DescriptorSet, VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, &packedPrimitiveIndicesBufferInfo, GetBindingSlot(ERegisterType::ShaderResource, 3)); // _PackedPrimitiveIndices
 
-    VkDescriptorBufferInfo uniqueVertexIndicesBufferInfo = CreateDescriptorBufferInfo(m_UniqueVertexIndicesBuffer, m_UniqueVertexIndices.size() * sizeof(uint8_t));
+    VkDescriptorBufferInfo uniqueVertexIndicesBufferInfo = CreateDescriptorBufferInfo(m_UniqueVertexIndicesBuffer, m_ClusterDag->GetVertexIndices().size() * sizeof(uint32_t));
     UpdateBufferDescriptor(descriptorWrites[7], m_DescriptorSet, VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, &uniqueVertexIndicesBufferInfo, GetBindingSlot(ERegisterType::ShaderResource, 4)); // _UniqueVertexIndices
 
-    VkDescriptorBufferInfo meshletCullDataBufferInfo = CreateDescriptorBufferInfo(m_MeshletCullDataBuffer, m_MeshletCullData.size() * sizeof(glm::vec4));
+    VkDescriptorBufferInfo meshletCullDataBufferInfo = CreateDescriptorBufferInfo(m_MeshletCullDataBuffer, m_ClusterDag->GetCullData().size() * sizeof(ClusterDag::CullData));
     UpdateBufferDescriptor(descriptorWrites[8], m_DescriptorSet, VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, &meshletCullDataBufferInfo, GetBindingSlot(ERegisterType::ShaderResource, 5)); // _MeshletCullData
 
-    VkDescriptorBufferInfo instanceBufferInfo = CreateDescriptorBufferInfo(m_InstanceBuffer, s_InstancesCount * sizeof(InstanceData));
+    VkDescriptorBufferInfo instanceBufferInfo = CreateDescriptorBufferInfo(m_InstanceBuffer, m_Scene.GetCapacity() * m_Scene.GetRecordByteSize());
     UpdateBufferDescriptor(descriptorWrites[9], m_DescriptorSet, VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, &instanceBufferInfo, GetBindingSlot(ERegisterType::ShaderResource, 6)); // _InstanceData
+    UpdateBufferDescriptor(descriptorWrites[15], m_DescriptorSet, VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, &instanceBufferInfo, GetBindingSlot(ERegisterType::UnorderedAccess, 3)); // _SceneRecords
+
+    VkDescriptorBufferInfo clusterLodBufferInfo = CreateDescriptorBufferInfo(m_ClusterLodBuffer, m_ClusterDag->GetLods().size() * sizeof(ClusterDag::ClusterLod));
+    UpdateBufferDescriptor(descriptorWrites[10], m_DescriptorSet, VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, &clusterLodBufferInfo, GetBindingSlot(ERegisterType::ShaderResource, 8)); // _ClusterLods
+
+    // The instance pass writes the same buffers the task shader reads
+    VkDescriptorBufferInfo visibleInstanceBufferInfo = CreateDescriptorBufferInfo(m_VisibleInstanceBuffer, s_InstancesCount * sizeof(VisibleInstance));
+    UpdateBufferDescriptor(descriptorWrites[11], m_DescriptorSet, VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, &visibleInstanceBufferInfo, GetBindingSlot(ERegisterType::ShaderResource, 9)); // _VisibleInstances
+    UpdateBufferDescriptor(descriptorWrites[12], m_DescriptorSet, VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, &visibleInstanceBufferInfo, GetBindingSlot(ERegisterType::UnorderedAccess, 1)); // _VisibleInstancesOut
+
+    VkDescriptorBufferInfo taskArgumentsBufferInfo = CreateDescriptorBufferInfo(m_TaskArgumentsBuffer, sizeof(TaskArguments));
+    UpdateBufferDescriptor(descriptorWrites[13], m_DescriptorSet, VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, &taskArgumentsBufferInfo, GetBindingSlot(ERegisterType::ShaderResource, 10)); // _TaskArguments
+    UpdateBufferDescriptor(descriptorWrites[14], m_DescriptorSet, VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, &taskArgumentsBufferInfo, GetBindingSlot(ERegisterType::UnorderedAccess, 2)); // _TaskArgumentsOut
+
+    VkDescriptorBufferInfo sceneUploadBufferInfo = CreateDescriptorBufferInfo(m_SceneUploadBuffer, m_Scene.GetMaxUploadWords() * sizeof(uint32_t));
+    UpdateBufferDescriptor(descriptorWrites[16], m_DescriptorSet, VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, &sceneUploadBufferInfo, GetBindingSlot(ERegisterType::ShaderResource, 11)); // _SceneUpdates
     
     vkUpdateDescriptorSets(m_DeviceHandle, (uint32_t)descriptorWrites.size(), descriptorWrites.data(), 0, nullptr);
     
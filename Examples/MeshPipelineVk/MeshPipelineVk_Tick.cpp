@@ -1,4 +1,5 @@
 #include "MeshPipelineVk.h"
+#include "CpuProfiler.h"
 #include <array>
 
 void MeshPipelineVk::UpdateConstants()
@@ -17,6 +18,64 @@ void MeshPipelineVk::UpdateConstants()
     WriteBufferData(m_DeviceHandle, m_ViewFrustumBufferMemory, &viewFrustumCB, ViewFrustumCB::GetAlignedByteSizes());
 }
 
+void MeshPipelineVk::FixedUpdate(float inDeltaTime)
+{
+    // A few instances spread over the grid bob up and down, the rest of the scene is never uploaded again
+    m_AnimationTime += inDeltaTime;
+    for(uint32_t i = 0; i < s_MovingInstanceCount; ++i)
+    {
+        const uint32_t instance = i * (s_InstancesCount / s_MovingInstanceCount);
+        Transform& transform = m_InstanceTransforms[instance];
+        const float speed = std::cos(m_AnimationTime * 2.0f + static_cast<float>(i)) * 4.0f;
+        transform.SetWorldPosition(transform.GetWorldPosition() + glm::vec3(0.0f, speed * inDeltaTime, 0.0f));
+        UpdateInstance(instance);
+    }
+}
+
+void MeshPipelineVk::SceneUpdatePass()
+{
+    const uint32_t updateCount = m_Scene.GatherUpdates(m_SceneUpload);
+    PROFILE_COUNTER("Scene upload bytes", m_SceneUpload.size() * sizeof(uint32_t));
+    if(updateCount == 0)
+        return;
+    // The previous frame is done with the upload buffer, Tick waits for the command buffer
+    WriteBufferData(m_DeviceHandle, m_SceneUploadBufferMemory, m_SceneUpload.data(), m_SceneUpload.size() * sizeof(uint32_t));
+
+    vkCmdBindPipeline(m_CmdBufferHandle, VK_PIPELINE_BIND_POINT_COMPUTE, m_SceneScatterPipelineState);
+    vkCmdBindDescriptorSets(m_CmdBufferHandle, VK_PIPELINE_BIND_POINT_COMPUTE, m_PipelineLayout, 0, 1, &m_DescriptorSet, 0, nullptr);
+    vkCmdDispatch(m_CmdBufferHandle, m_Scene.GetScatterGroupCount(updateCount), 1, 1);
+
+    // Instance culling, the task and the mesh shader read the scattered records
+    VkMemoryBarrier scatterBarrier{};
+    scatterBarrier.sType = VK_STRUCTURE_TYPE_MEMORY_BARRIER;
+    scatterBarrier.srcAccessMask = VK_ACCESS_SHADER_WRITE_BIT;
+    scatterBarrier.dstAccessMask = VK_ACCESS_SHADER_READ_BIT;
+    vkCmdPipelineBarrier(m_CmdBufferHandle, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT | VK_PIPELINE_STAGE_TASK_SHADER_BIT_EXT | VK_PIPELINE_STAGE_MESH_SHADER_BIT_EXT, 0, 1, &scatterBarrier, 0, nullptr, 0, nullptr);
+}
+
+void MeshPipelineVk::InstanceCullingPass()
+{
+    VkBufferCopy argumentsCopy{};
+    argumentsCopy.size = sizeof(TaskArguments);
+    vkCmdCopyBuffer(m_CmdBufferHandle, m_TaskArgumentsResetBuffer, m_TaskArgumentsBuffer, 1, &argumentsCopy);
+    VkMemoryBarrier resetBarrier{};
+    resetBarrier.sType = VK_STRUCTURE_TYPE_MEMORY_BARRIER;
+    resetBarrier.srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+    resetBarrier.dstAccessMask = VK_ACCESS_SHADER_READ_BIT | VK_ACCESS_SHADER_WRITE_BIT;
+    vkCmdPipelineBarrier(m_CmdBufferHandle, VK_PIPELINE_STAGE_TRANSFER_BIT, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, 0, 1, &resetBarrier, 0, nullptr, 0, nullptr);
+
+    vkCmdBindPipeline(m_CmdBufferHandle, VK_PIPELINE_BIND_POINT_COMPUTE, m_InstanceCullingPipelineState);
+    vkCmdBindDescriptorSets(m_CmdBufferHandle, VK_PIPELINE_BIND_POINT_COMPUTE, m_PipelineLayout, 0, 1, &m_DescriptorSet, 0, nullptr);
+    vkCmdDispatch(m_CmdBufferHandle, (s_InstancesCount + s_InstanceCullingGroupSize - 1) / s_InstanceCullingGroupSize, 1, 1);
+
+    // The task shader reads the visible instances and their count, the draw its group count
+    VkMemoryBarrier cullingBarrier{};
+    cullingBarrier.sType = VK_STRUCTURE_TYPE_MEMORY_BARRIER;
+    cullingBarrier.srcAccessMask = VK_ACCESS_SHADER_WRITE_BIT;
+    cullingBarrier.dstAccessMask = VK_ACCESS_INDIRECT_COMMAND_READ_BIT | VK_ACCESS_SHADER_READ_BIT;
+    vkCmdPipelineBarrier(m_CmdBufferHandle, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, VK_PIPELINE_STAGE_DRAW_INDIRECT_BIT | VK_PIPELINE_STAGE_TASK_SHADER_BIT_EXT, 0, 1, &cullingBarrier, 0, nullptr, 0, nullptr);
+}
+
 void MeshPipelineVk::Tick()
 {
     if(!m_IsRunning)
@@ -26,6 +85,8 @@ void MeshPipelineVk::Tick()
 
     BeginCommandList();
     UpdateConstants();
+    SceneUpdatePass();
+    InstanceCullingPass();
     
     VkRenderPassBeginInfo renderPassInfo{};
     renderPassInfo.sType = VK_STRUCTURE_TYPE_RENDER_PASS_BEGIN_INFO;
@@ -60,9 +121,11 @@ void MeshPipelineVk::Tick()
         vkCmdBindPipeline(m_CmdBufferHandle, VK_PIPELINE_BIND_POINT_GRAPHICS, m_PipelineState);
         vkCmdBindDescriptorSets(m_CmdBufferHandle, VK_PIPELINE_BIND_POINT_GRAPHICS, m_PipelineLayout, 0, 1, &m_DescriptorSet, 0, nullptr);
 
-        vkCmdDrawMeshTasksEXT(m_CmdBufferHandle, m_GroupCount, 1, 1);
+        vkCmdDrawMeshTasksIndirectEXT(m_CmdBufferHandle, m_TaskArgumentsBuffer, 0, 1, sizeof(TaskArguments));
     }
     vkCmdEndRenderPass(m_CmdBufferHandle);
+    // The render pass moved the back buffer to its final layout, SaveScreenshot transitions from there
+    m_StateTracker.SetImageState(m_BackBuffers[m_CurrentIndex], VK_IMAGE_LAYOUT_PRESENT_SRC_KHR, VK_PIPELINE_STAGE_2_COLOR_ATTACHMENT_OUTPUT_BIT, VK_ACCESS_2_COLOR_ATTACHMENT_WRITE_BIT);
     EndCommandList();
     
     ExecuteCommandBuffer(m_ImageAvailableSemaphore);
@@ -1,17 +1,25 @@
 #include "MeshPipelineVk.h"
 #include <iostream>
 
+#ifdef _WIN32
 int WINAPI WinMain(HINSTANCE hInstance, HINSTANCE hPrevInstance, LPSTR lpCmdLine, int nCmdShow)
 {
+    const RunOptions options = RunOptions::FromCommandLine(__argc, __argv);
+#else
+int main(int argc, char** argv)
+{
+    HINSTANCE hInstance = nullptr;
+    const RunOptions options = RunOptions::FromCommandLine(argc, argv);
+#endif
     try
     {
-        std::unique_ptr<MeshPipelineVk> app = std::make_unique<MeshPipelineVk>(1280, 720, hInstance, TEXT("Vulkan Indirect Draw"));
+        std::unique_ptr<MeshPipelineVk> app = std::make_unique<MeshPipelineVk>(1280, 720, hInstance, TEXT("Vulkan Indirect Draw"), options);
         app->Run();
-        return 0;
+        return app->GetExitCode();
     }
     catch (std::runtime_error& err)
     {
-        Log::Error(err.what());
+        LOG_ERROR("%s", err.what());
         return -1;
     }
 }
\ No newline at end of file
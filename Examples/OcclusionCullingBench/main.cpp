@@ -0,0 +1,137 @@
+#include "Benchmark.h"
+#include "Log.h"
+#include "SoftwareOcclusion.h"
+#include <glm/gtc/matrix_transform.hpp>
+#include <algorithm>
+#include <chrono>
+#include <cstdlib>
+#include <cstring>
+#include <random>
+#include <string>
+
+// Runs the CPU occlusion culling of SoftwareOcclusion on a procedural city without a device: a grid of buildings is
+// rasterized as occluders and 1k to 100k small boxes scattered between them are tested, with and without AVX2.
+//
+//   OcclusionCullingBench [--iterations N] [--report path.json|path.csv] [--baseline path.json] [--tolerance percent]
+
+static constexpr uint32_t s_BuildingsPerSide = 16;
+static constexpr float s_CitySize = 400.0f;
+
+// Unit cube, clockwise front faces seen from outside with the left handed camera of the examples
+static const float s_CubePositions[] =
+{
+    0, 0, 0,  1, 0, 0,  1, 1, 0,  0, 1, 0,
+    0, 0, 1,  1, 0, 1,  1, 1, 1,  0, 1, 1,
+};
+static const uint32_t s_CubeIndices[] =
+{
+    0, 2, 1,  0, 3, 2,      // -z
+    4, 5, 6,  4, 6, 7,      // +z
+    0, 1, 5,  0, 5, 4,      // -y
+    3, 7, 6,  3, 6, 2,      // +y
+    0, 4, 7,  0, 7, 3,      // -x
+    1, 2, 6,  1, 6, 5,      // +x
+};
+
+static double MillisecondsSince(std::chrono::steady_clock::time_point inStart)
+{
+    return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - inStart).count();
+}
+
+int main(int argc, char** argv)
+{
+    uint32_t iterations = 50;
+    std::string reportPath;
+    std::string baselinePath;
+    double tolerancePercent = 10.0;
+    for(int i = 1; i < argc; ++i)
+    {
+        const bool hasValue = i + 1 < argc;
+        if(strcmp(argv[i], "--iterations") == 0 && hasValue)
+            iterations = std::max(1, atoi(argv[++i]));
+        else if(strcmp(argv[i], "--report") == 0 && hasValue)
+            reportPath = argv[++i];
+        else if(strcmp(argv[i], "--baseline") == 0 && hasValue)
+            baselinePath = argv[++i];
+        else if(strcmp(argv[i], "--tolerance") == 0 && hasValue)
+            tolerancePercent = atof(argv[++i]);
+        else
+            LOG_WARNING("Unknown argument %s", argv[i]);
+    }
+
+    const glm::mat4 view = glm::lookAtLH(glm::vec3(0.0f, 20.0f, -s_CitySize * 0.5f), glm::vec3(0.0f, 0.0f, 0.0f), glm::vec3(0.0f, 1.0f, 0.0f));
+    const glm::mat4 worldToClip = glm::perspectiveLH_ZO(glm::radians(60.0f), 16.0f / 9.0f, 0.1f, 1000.0f) * view;
+
+    std::mt19937 gen(42);
+    std::uniform_real_distribution<float> dis01(0.0f, 1.0f);
+
+    const float cellSize = s_CitySize / s_BuildingsPerSide;
+    std::vector<glm::mat4> occluders;
+    for(uint32_t z = 0; z < s_BuildingsPerSide; ++z)
+    {
+        for(uint32_t x = 0; x < s_BuildingsPerSide; ++x)
+        {
+            const glm::vec3 corner((x + 0.2f) * cellSize - s_CitySize * 0.5f, 0.0f, (z + 0.2f) * cellSize - s_CitySize * 0.5f);
+            const glm::vec3 size(cellSize * 0.6f, 10.0f + dis01(gen) * 40.0f, cellSize * 0.6f);
+            occluders.push_back(worldToClip * glm::scale(glm::translate(glm::mat4(1.0f), corner), size));
+        }
+    }
+
+    Benchmark benchmark;
+    for(uint32_t count : {1000u, 10000u, 100000u})
+    {
+        std::vector<OcclusionBox> boxes(count);
+        for(OcclusionBox& box : boxes)
+        {
+            const glm::vec3 center((dis01(gen) - 0.5f) * s_CitySize, dis01(gen) * 8.0f, (dis01(gen) - 0.5f) * s_CitySize);
+            box.Min = center - glm::vec3(1.0f);
+            box.Max = center + glm::vec3(1.0f);
+        }
+
+        for(bool useAvx2 : {false, true})
+        {
+            SoftwareOcclusion occlusion;
+            occlusion.Init(512, 256);
+            occlusion.SetAvx2Enabled(useAvx2);
+            if(useAvx2 && !occlusion.IsAvx2Enabled())
+            {
+                Log::Info("[Occlusion] AVX2 is not available, skipped");
+                continue;
+            }
+
+            const std::string suffix = std::to_string(count) + (useAvx2 ? " AVX2" : " scalar");
+            std::vector<uint32_t> visible;
+            visible.reserve(count);
+            for(uint32_t i = 0; i < iterations; ++i)
+            {
+                const auto start = std::chrono::steady_clock::now();
+                occlusion.Clear();
+                for(const glm::mat4& localToClip : occluders)
+                    occlusion.RenderOccluder(s_CubePositions, 3 * sizeof(float), s_CubeIndices, 36, localToClip);
+                const double rasterMs = MillisecondsSince(start);
+
+                const auto testStart = std::chrono::steady_clock::now();
+                visible.clear();
+                occlusion.TestBoxes(boxes.data(), count, worldToClip, visible);
+                const double testMs = MillisecondsSince(testStart);
+
+                benchmark.AddSample("Raster " + suffix, rasterMs);
+                benchmark.AddSample("Test " + suffix, testMs);
+                benchmark.AddSample("Total " + suffix, rasterMs + testMs);
+            }
+
+            const SoftwareOcclusion::Stats& stats = occlusion.GetStats();
+            Log::Info("[Occlusion] %s: %u of %u occluder triangles rasterized, %u of %u boxes visible", suffix.c_str()
+                , stats.RasterizedTriangles, stats.OccluderTriangles, stats.VisibleBoxes, stats.TestedBoxes);
+        }
+    }
+
+    benchmark.LogReport();
+    if(!reportPath.empty())
+        benchmark.WriteReport(reportPath, "OcclusionCullingBench", 0);
+    int exitCode = 0;
+    if(!baselinePath.empty() && !benchmark.CompareWithBaseline(baselinePath, tolerancePercent))
+        exitCode = 1;
+    Log::Flush();
+    return exitCode;
+}
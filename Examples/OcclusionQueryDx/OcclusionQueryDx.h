@@ -1,77 +1,67 @@
 #pragma once
-#include "Win32Base.h"
-#include "Log.h"
-#include <d3dx12.h>
-#include <dxgi1_6.h>
-#include <d3dcompiler.h>
-#include <wrl/client.h>
-#include <string>
-#include <iostream>
 
+#include "../AppBaseDx.h"
 #include "AssetsManager.h"
 #include "Camera.h"
 #include "Transform.h"
 #include "Light.h"
-#include <array>
+#include "SoftwareOcclusion.h"
+#include "OcclusionQueryGroups.h"
 
-#define OUTPUT_D3D12_FAILED_RESULT(Re)  if(FAILED(Re))\
-	{\
-		std::string message = std::system_category().message(Re);\
-		Log::Error("[D3D12] Error: %s, In File: %s line %d", message.c_str(), __FILE__, __LINE__);\
-	}
-
-void WriteBufferData(ID3D12Resource* inBuffer, const void* inData, size_t inSize);
-void ReadBackBufferData(ID3D12Resource* inBuffer, void* outData, size_t inSize, size_t inOffset = 0);
-
-static Microsoft::WRL::ComPtr<ID3D12Resource> CreateBufferHelper(ID3D12Device* inDevice
-	, size_t inSize
-	, D3D12_RESOURCE_STATES initState
-	, D3D12_HEAP_TYPE inHeapType
-	, D3D12_RESOURCE_FLAGS inFlags);
-
-Microsoft::WRL::ComPtr<ID3D12Resource> CreateTextureHelper(ID3D12Device* inDevice
-	, DXGI_FORMAT inFormat
-	, uint32_t inWidth
-	, uint32_t inHeight
-	, D3D12_RESOURCE_STATES initState
-	, D3D12_HEAP_TYPE inHeapType
-	, D3D12_RESOURCE_FLAGS inFlags
-	, const D3D12_CLEAR_VALUE* inClearValue);
+struct ProxyBox
+{
+	glm::vec3 Min;
+	float     Padding0;
+	glm::vec3 Max;
+	float     Padding1;
+};
 
-class OcclusionQueryDx : public Win32Base
+struct InstanceData
+{
+	glm::mat4 LocalToWorld;
+	glm::mat4 WorldToLocal;
+	uint32_t MaterialIndex;
+	uint32_t Padding0;
+	uint32_t Padding1;
+	uint32_t Padding2;
+};
+
+class OcclusionQueryDx : public AppBaseDx
 {
 public:
-	using Win32Base::Win32Base;
-
-	static constexpr D3D_FEATURE_LEVEL  s_FeatureLevel = D3D_FEATURE_LEVEL_12_1;
-	static constexpr DXGI_FORMAT        s_BackBufferFormat = DXGI_FORMAT_R8G8B8A8_UNORM;
+	using AppBaseDx::AppBaseDx;
 	static constexpr DXGI_FORMAT        s_DepthStencilBufferFormat = DXGI_FORMAT_D32_FLOAT;
-	static constexpr uint32_t           s_BackBufferCount = 2;
 	// static constexpr uint32_t           s_InstancesCount = 4096;
 	static constexpr uint32_t           s_InstancesCount = 1024;
 	static constexpr uint32_t           s_TexturesCount = 5;
-
+	// The instances covering most of the screen are rasterized as occluders
+	static constexpr uint32_t           s_OccluderCount = 32;
+	static constexpr uint32_t           s_OcclusionBufferWidth = 512;
+	static constexpr uint32_t           s_OcclusionBufferHeight = 256;
+	// Instances sharing one hardware occlusion query
+	static constexpr uint32_t           s_QueryGroupSize = 16;
+	static constexpr uint32_t           s_QueryGroupCount = (s_InstancesCount + s_QueryGroupSize - 1) / s_QueryGroupSize;
+	// Ring of query readbacks, the CPU reads the results s_QueryReadbackCount - 1 frames after they were written so it
+	// never waits for them
+	static constexpr uint32_t           s_QueryReadbackCount = 2;
+
+	enum class OcclusionMode
+	{
+		None,
+		Software,           // SoftwareOcclusion on the CPU
+		QueryPredication,   // the queries of the last frame predicate the draws of their group on the GPU
+		QueryTemporal,      // the CPU skips the groups whose queries read back as hidden, with hysteresis
+	};
+	OcclusionMode Occlusion = OcclusionMode::QueryTemporal;
+
+protected:
 	bool Init() override;
 	void Tick() override;
 	void Shutdown() override;
-
-	void BeginCommandList();
-	void EndCommandList();
-    
-	// not support mGPU so far
-	static uint32_t GetNodeMask() { return 0; }
-	static uint32_t GetCreationNodeMask() { return 1; }
-	static uint32_t GetVisibleNodeMask() { return 1; }
-
-	bool IsOcclusionCulling = true;
-	uint32_t TimeQueryCount = 2;
+	CameraBase* GetBenchmarkCamera() override { return &m_Camera; }
 	
 private:
 	bool CreateDevice();
-	bool CreateCommandQueue();
-	bool CreateCommandList();
-	bool CreateDescriptorHeaps();
-	bool CreateSwapChain();
 	bool CreateRootSignature();
 	bool CreateShader();
 	bool CreatePipelineState();
@@ -80,29 +70,18 @@ private:
 	bool CreateResources();
 	bool CreateQueryResultResources();
 	void UpdateConstants();
-	void FlushCommandQueue();
-
-	Microsoft::WRL::ComPtr<IDXGIFactory2>               m_FactoryHandle;
-	Microsoft::WRL::ComPtr<IDXGIAdapter1>               m_AdapterHandle;
-	Microsoft::WRL::ComPtr<ID3D12Device5>               m_DeviceHandle;
-	Microsoft::WRL::ComPtr<ID3D12CommandQueue>          m_CommandQueueHandle;
-	Microsoft::WRL::ComPtr<ID3D12Fence>                 m_Fence;
-	Microsoft::WRL::ComPtr<ID3D12CommandAllocator>      m_CommandAllocator;
-	Microsoft::WRL::ComPtr<ID3D12GraphicsCommandList6>  m_CommandList;
-	bool                                                m_CommandListIsClosed = false;         
-
-	Microsoft::WRL::ComPtr<ID3D12DescriptorHeap>        m_RtvHeap;
-	Microsoft::WRL::ComPtr<ID3D12DescriptorHeap>        m_DsvHeap;
-	Microsoft::WRL::ComPtr<ID3D12DescriptorHeap>        m_ShaderBoundViewHeap; // CBV, SRV, UAV
-	Microsoft::WRL::ComPtr<ID3D12DescriptorHeap>        m_SamplerHeap;
-    
-	Microsoft::WRL::ComPtr<IDXGISwapChain1>             m_SwapChainHandle;
-	std::vector<D3D12_CPU_DESCRIPTOR_HANDLE>            m_RtvHandles;
-	std::vector<Microsoft::WRL::ComPtr<ID3D12Resource>> m_BackBuffers;
-	uint32_t                                            m_CurrentIndex{0};
+	// Writes the visible instances to m_VisibleInstancesBuffer, returns how many there are
+	uint32_t CullInstances();
+	void DrawQueryGroups();
+	// Bounding boxes of every group with an occlusion query each, then the results go to the predication buffer and
+	// the readback of this frame
+	void DrawQueryProxies();
 
 	Microsoft::WRL::ComPtr<ID3D12RootSignature>			m_RootSignature;
 	Microsoft::WRL::ComPtr<ID3D12PipelineState>			m_PipelineState;
+	Microsoft::WRL::ComPtr<ID3D12RootSignature>			m_ProxyRootSignature;
+	Microsoft::WRL::ComPtr<ID3D12PipelineState>			m_ProxyPipelineState;
+	std::shared_ptr<AssetsManager::Blob>                m_ProxyVertexShaderBlob;
 	std::shared_ptr<AssetsManager::Blob>                m_VertexShaderBlob;
 	std::shared_ptr<AssetsManager::Blob>                m_PixelShaderBlob;
 
@@ -120,16 +99,24 @@ private:
 	Microsoft::WRL::ComPtr<ID3D12Resource>              m_IndicesBuffer;
 	Microsoft::WRL::ComPtr<ID3D12Resource>              m_InstancesBuffer;
 	Microsoft::WRL::ComPtr<ID3D12Resource>              m_MaterialsBuffer;
+	Microsoft::WRL::ComPtr<ID3D12Resource>              m_VisibleInstancesBuffer;   // upload heap, rewritten every frame
 	std::array<Microsoft::WRL::ComPtr<ID3D12Resource>, s_TexturesCount> m_MainTextures;
 	
 	Microsoft::WRL::ComPtr<ID3D12QueryHeap>				m_OcclusionQueryHeap;
-	Microsoft::WRL::ComPtr<ID3D12QueryHeap>				m_TimestampQueryHeap;
 	Microsoft::WRL::ComPtr<ID3D12QueryHeap>				m_PipelineStatisticsQueryHeap;
 	
-	Microsoft::WRL::ComPtr<ID3D12Resource>				m_OcclusionQueryResult;
-	Microsoft::WRL::ComPtr<ID3D12Resource>				m_TimestampQueryResult;
+	Microsoft::WRL::ComPtr<ID3D12Resource>				m_OcclusionQueryResult;     // one uint64 per group, read by SetPredication
+	std::array<Microsoft::WRL::ComPtr<ID3D12Resource>, s_QueryReadbackCount> m_OcclusionQueryReadback;
+	uint64_t                                            m_QueryFrame = 0;           // frames that resolved their queries
 	Microsoft::WRL::ComPtr<ID3D12Resource>				m_PipelineStatisticsQueryResult;
 
 	D3D12_VERTEX_BUFFER_VIEW                            m_VertexBufferView;
 	D3D12_INDEX_BUFFER_VIEW                             m_IndexBufferView;
+
+	SoftwareOcclusion                                   m_SoftwareOcclusion;
+	std::vector<InstanceData>                           m_InstancesData;
+	std::vector<OcclusionBox>                           m_InstanceBounds;   // world space
+	std::vector<uint32_t>                               m_OccluderIndices;
+	std::vector<uint32_t>                               m_VisibleInstances;
+	OcclusionQueryGroups                                m_QueryGroups;
 };
\ No newline at end of file
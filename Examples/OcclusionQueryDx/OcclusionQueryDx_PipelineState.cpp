@@ -22,7 +22,7 @@ bool OcclusionQueryDx::CreateRootSignature()
     if(FAILED(hr))
     {
         OUTPUT_D3D12_FAILED_RESULT(hr)
-        Log::Error("[D3D12] Failed to serialize the root signature: %s", static_cast<const char*>(errorBlob->GetBufferPointer()));
+        LOG_ERROR("[D3D12] Failed to serialize the root signature: %s", static_cast<const char*>(errorBlob->GetBufferPointer()));
         return false;
     }
 
@@ -34,7 +34,33 @@ bool OcclusionQueryDx::CreateRootSignature()
     if(FAILED(hr))
     {
         OUTPUT_D3D12_FAILED_RESULT(hr)
-        Log::Error("[D3D12] Failed to create the root signature");
+        LOG_ERROR("[D3D12] Failed to create the root signature");
+        return false;
+    }
+
+    std::array<CD3DX12_ROOT_PARAMETER, 2> proxyParameters;
+    proxyParameters[0].InitAsConstantBufferView(0, 0, D3D12_SHADER_VISIBILITY_VERTEX); // _CameraData
+    proxyParameters[1].InitAsConstants(sizeof(ProxyBox) / sizeof(uint32_t), 1, 0, D3D12_SHADER_VISIBILITY_VERTEX); // _Box
+    CD3DX12_ROOT_SIGNATURE_DESC proxyRootSignatureDesc;
+    proxyRootSignatureDesc.Init(static_cast<uint32_t>(proxyParameters.size()), proxyParameters.data(), 0, nullptr, D3D12_ROOT_SIGNATURE_FLAG_NONE);
+
+    hr = D3D12SerializeRootSignature(&proxyRootSignatureDesc, D3D_ROOT_SIGNATURE_VERSION_1, &signatureBlob, &errorBlob);
+    if(FAILED(hr))
+    {
+        OUTPUT_D3D12_FAILED_RESULT(hr)
+        LOG_ERROR("[D3D12] Failed to serialize the proxy root signature: %s", static_cast<const char*>(errorBlob->GetBufferPointer()));
+        return false;
+    }
+
+    hr = m_DeviceHandle->CreateRootSignature(GetNodeMask(),
+    signatureBlob->GetBufferPointer()
+        , signatureBlob->GetBufferSize()
+        , IID_PPV_ARGS(&m_ProxyRootSignature));
+
+    if(FAILED(hr))
+    {
+        OUTPUT_D3D12_FAILED_RESULT(hr)
+        LOG_ERROR("[D3D12] Failed to create the proxy root signature");
         return false;
     }
     
@@ -46,13 +72,19 @@ bool OcclusionQueryDx::CreateShader()
     m_VertexShaderBlob = AssetsManager::LoadShaderImmediately("Graphics.vs.bin");
     if(!m_VertexShaderBlob || m_VertexShaderBlob->IsEmpty())
     {
-        Log::Error("Failed to load vertex shader");
+        LOG_ERROR("Failed to load vertex shader");
         return false;
     }
     m_PixelShaderBlob = AssetsManager::LoadShaderImmediately("Graphics.ps.bin");
     if(!m_PixelShaderBlob || m_PixelShaderBlob->IsEmpty())
     {
-        Log::Error("Failed to load pixel shader");
+        LOG_ERROR("Failed to load pixel shader");
+        return false;
+    }
+    m_ProxyVertexShaderBlob = AssetsManager::LoadShaderImmediately("OcclusionProxy.vs.bin");
+    if(!m_ProxyVertexShaderBlob || m_ProxyVertexShaderBlob->IsEmpty())
+    {
+        LOG_ERROR("Failed to load the occlusion proxy vertex shader");
         return false;
     }
     
@@ -82,11 +114,28 @@ bool OcclusionQueryDx::CreatePipelineState()
     pipelineDesc.PrimitiveTopologyType = D3D12_PRIMITIVE_TOPOLOGY_TYPE_TRIANGLE;
     pipelineDesc.NodeMask              = GetNodeMask();
 
-    const HRESULT hr = m_DeviceHandle->CreateGraphicsPipelineState(&pipelineDesc, IID_PPV_ARGS(&m_PipelineState));
-    if(FAILED(hr))
+    // Depth tested boxes without color or depth writes, both faces so that a box is not lost when the camera gets close
+    D3D12_GRAPHICS_PIPELINE_STATE_DESC proxyPipelineDesc = pipelineDesc;
+    proxyPipelineDesc.InputLayout = {};
+    proxyPipelineDesc.pRootSignature = m_ProxyRootSignature.Get();
+    proxyPipelineDesc.VS = CD3DX12_SHADER_BYTECODE(m_ProxyVertexShaderBlob->GetData(), m_ProxyVertexShaderBlob->GetSize());
+    proxyPipelineDesc.PS = {};
+    proxyPipelineDesc.RasterizerState.CullMode = D3D12_CULL_MODE_NONE;
+    proxyPipelineDesc.BlendState.RenderTarget[0].RenderTargetWriteMask = 0;
+    proxyPipelineDesc.DepthStencilState.DepthWriteMask = D3D12_DEPTH_WRITE_MASK_ZERO;
+
+    const bool succeeded = CreatePipelinesParallel({ [&]()
     {
-        OUTPUT_D3D12_FAILED_RESULT(hr)
-        Log::Error("[D3D12] Failed to create the pipeline state");
+        m_PipelineState = LoadGraphicsPipeline(L"OcclusionQueryDx", pipelineDesc);
+        return m_PipelineState != nullptr;
+    }, [&]()
+    {
+        m_ProxyPipelineState = LoadGraphicsPipeline(L"OcclusionQueryProxyDx", proxyPipelineDesc);
+        return m_ProxyPipelineState != nullptr;
+    } });
+    if(!succeeded)
+    {
+        LOG_ERROR("[D3D12] Failed to create the pipeline state");
         return false;
     }
     
@@ -97,23 +146,13 @@ bool OcclusionQueryDx::CreateQueryHeaps()
 {
     D3D12_QUERY_HEAP_DESC queryHeapDesc{};
     queryHeapDesc.NodeMask = GetNodeMask();
-    queryHeapDesc.Count = TimeQueryCount;
-    queryHeapDesc.Type = D3D12_QUERY_HEAP_TYPE_TIMESTAMP;
-    HRESULT hr = m_DeviceHandle->CreateQueryHeap(&queryHeapDesc, IID_PPV_ARGS(&m_TimestampQueryHeap));
-    if(FAILED(hr))
-    {
-        OUTPUT_D3D12_FAILED_RESULT(hr)
-        Log::Error("[D3D12] Failed to create the timestamp query heap");
-        return false;
-    }
-
-    queryHeapDesc.Count = 1;
+    queryHeapDesc.Count = s_QueryGroupCount;
     queryHeapDesc.Type = D3D12_QUERY_HEAP_TYPE_OCCLUSION;
-    hr = m_DeviceHandle->CreateQueryHeap(&queryHeapDesc, IID_PPV_ARGS(&m_OcclusionQueryHeap));
+    HRESULT hr = m_DeviceHandle->CreateQueryHeap(&queryHeapDesc, IID_PPV_ARGS(&m_OcclusionQueryHeap));
     if(FAILED(hr))
     {
         OUTPUT_D3D12_FAILED_RESULT(hr)
-        Log::Error("[D3D12] Failed to create the occlusion query heap");
+        LOG_ERROR("[D3D12] Failed to create the occlusion query heap");
         return false;
     }
 
@@ -123,7 +162,7 @@ bool OcclusionQueryDx::CreateQueryHeaps()
     if(FAILED(hr))
     {
         OUTPUT_D3D12_FAILED_RESULT(hr)
-        Log::Error("[D3D12] Failed to create the pipeline statistics query heap");
+        LOG_ERROR("[D3D12] Failed to create the pipeline statistics query heap");
         return false;
     }
     
@@ -1,160 +1,14 @@
 #include "OcclusionQueryDx.h"
+#include <cfloat>
 #include <random>
 
-Microsoft::WRL::ComPtr<ID3D12Resource> CreateBufferHelper(ID3D12Device* inDevice
-    , size_t inSize
-    , D3D12_RESOURCE_STATES initState
-    , D3D12_HEAP_TYPE inHeapType
-    , D3D12_RESOURCE_FLAGS inFlags)
-{
-    D3D12_RESOURCE_DESC resourceDesc{};
-    resourceDesc.Width = inSize;
-    resourceDesc.Height = 1;
-    resourceDesc.DepthOrArraySize = 1;
-    resourceDesc.Dimension = D3D12_RESOURCE_DIMENSION_BUFFER;
-    resourceDesc.Format = DXGI_FORMAT_UNKNOWN;
-    resourceDesc.Layout = D3D12_TEXTURE_LAYOUT_ROW_MAJOR;
-    resourceDesc.MipLevels = 1;
-    resourceDesc.SampleDesc.Count = 1;
-    resourceDesc.SampleDesc.Quality = 0;
-    resourceDesc.Flags = inFlags;
-    const CD3DX12_HEAP_PROPERTIES heapProperties(inHeapType);
-
-    Microsoft::WRL::ComPtr<ID3D12Resource> buffer;
-    const HRESULT hr = inDevice->CreateCommittedResource(&heapProperties
-        , D3D12_HEAP_FLAG_NONE
-        , &resourceDesc
-        , initState
-        , nullptr
-        , IID_PPV_ARGS(&buffer));
-
-    if(FAILED(hr))
-    {
-        OUTPUT_D3D12_FAILED_RESULT(hr)
-        Log::Error("[D3D12] Failed to create buffer");
-        return nullptr;
-    }
-    
-    return buffer;
-}
-
-void WriteBufferData(ID3D12Resource* inBuffer, const void* inData, size_t inSize)
-{
-    if(inBuffer == nullptr)
-    {
-        Log::Error("[D3D12] Invalid buffer");
-        return;
-    }
-    uint8_t* mappedData = nullptr;
-    const D3D12_RANGE range = {0, inSize};
-    inBuffer->Map(0, &range, reinterpret_cast<void**>(&mappedData));
-    memcpy(mappedData, inData, inSize);
-    inBuffer->Unmap(0, nullptr);
-}
-
-void ReadBackBufferData(ID3D12Resource* inBuffer, void* outData, size_t inSize, size_t inOffset)
-{
-    if(inBuffer == nullptr)
-    {
-        Log::Error("[D3D12] Invalid buffer");
-        return;
-    }
-    uint8_t* mappedData = nullptr;
-    const D3D12_RANGE range = {inOffset, inSize};
-    inBuffer->Map(0, &range, reinterpret_cast<void**>(&mappedData));
-    memcpy(outData, mappedData, inSize);
-    inBuffer->Unmap(0, nullptr);
-}
-
-Microsoft::WRL::ComPtr<ID3D12Resource> CreateTextureHelper(ID3D12Device* inDevice
-    , DXGI_FORMAT inFormat
-    , uint32_t inWidth
-    , uint32_t inHeight
-    , D3D12_RESOURCE_STATES initState
-    , D3D12_HEAP_TYPE inHeapType
-    , D3D12_RESOURCE_FLAGS inFlags
-    , const D3D12_CLEAR_VALUE* inClearValue)
-{
-    D3D12_RESOURCE_DESC textureDesc = {};
-    textureDesc.MipLevels = 1;
-    textureDesc.Format = inFormat;
-    textureDesc.Width = inWidth;
-    textureDesc.Height = inHeight;
-    textureDesc.Flags = inFlags;
-    textureDesc.DepthOrArraySize = 1;
-    textureDesc.SampleDesc.Count = 1;
-    textureDesc.SampleDesc.Quality = 0;
-    textureDesc.Dimension = D3D12_RESOURCE_DIMENSION_TEXTURE2D;
-
-    const CD3DX12_HEAP_PROPERTIES heapProperties(inHeapType);
-
-    Microsoft::WRL::ComPtr<ID3D12Resource> texture;
-    HRESULT hr = inDevice->CreateCommittedResource(&heapProperties
-        , D3D12_HEAP_FLAG_NONE
-        , &textureDesc
-        , initState
-        , inClearValue
-        , IID_PPV_ARGS(&texture));
-    
-    if(FAILED(hr))
-    {
-        OUTPUT_D3D12_FAILED_RESULT(hr)
-        Log::Error("[D3D12] Failed to create texture");
-        return nullptr;
-    }
-
-    return texture;
-}
-
-static Microsoft::WRL::ComPtr<ID3D12Resource> UploadBuffer(ID3D12Device* inDevice, ID3D12GraphicsCommandList* inCmdList, ID3D12Resource* dstBuffer, const void* inData, size_t inSize)
-{
-    Microsoft::WRL::ComPtr<ID3D12Resource> stagingBuffer = CreateBufferHelper(inDevice
-        , inSize
-        , D3D12_RESOURCE_STATE_GENERIC_READ
-        , D3D12_HEAP_TYPE_UPLOAD
-        , D3D12_RESOURCE_FLAG_NONE);
-
-    WriteBufferData(stagingBuffer.Get(), inData, inSize);
-
-    inCmdList->CopyBufferRegion(dstBuffer, 0, stagingBuffer.Get(), 0, inSize);
-
-    return stagingBuffer;
-}
-
-static Microsoft::WRL::ComPtr<ID3D12Resource> UploadTexture(ID3D12Device* inDevice, ID3D12GraphicsCommandList* inCmdList, ID3D12Resource* dstTexture, const DirectX::ScratchImage& inImage)
-{
-    D3D12_RESOURCE_DESC texDesc = dstTexture->GetDesc();
-    const size_t numSubresources = inImage.GetImageCount();
-    size_t requiredSize;
-    inDevice->GetCopyableFootprints(&texDesc, 0, numSubresources, 0, nullptr, nullptr, nullptr, &requiredSize);
-
-    Microsoft::WRL::ComPtr<ID3D12Resource> stagingBuffer = CreateBufferHelper(inDevice
-        , requiredSize
-        , D3D12_RESOURCE_STATE_GENERIC_READ
-        , D3D12_HEAP_TYPE_UPLOAD
-        , D3D12_RESOURCE_FLAG_NONE);
-    
-    std::vector<D3D12_SUBRESOURCE_DATA> subresources(numSubresources);
-    const DirectX::Image* images = inImage.GetImages();
-    for(uint32_t i = 0; i < numSubresources; ++i)
-    {
-        subresources[i].pData = images[i].pixels;
-        subresources[i].RowPitch = images[i].rowPitch;
-        subresources[i].SlicePitch = images[i].slicePitch;
-    }
-    constexpr uint32_t maxSubresourceNum = 1;
-    UpdateSubresources<maxSubresourceNum>(inCmdList, dstTexture, stagingBuffer.Get(), 0, 0, subresources.size(), subresources.data());
-    return stagingBuffer;
-}
-
 bool OcclusionQueryDx::CreateDepthStencilBuffer()
 {
     D3D12_CLEAR_VALUE optClear;
     optClear.Format = s_DepthStencilBufferFormat;
     optClear.DepthStencil.Depth = 1.0f;
     optClear.DepthStencil.Stencil = 0;
-    m_DepthStencilBuffer = CreateTextureHelper(m_DeviceHandle.Get()
-        , s_DepthStencilBufferFormat
+    m_DepthStencilBuffer = CreateTexture(s_DepthStencilBufferFormat
         , m_Width
         , m_Height
         , D3D12_RESOURCE_STATE_DEPTH_WRITE
@@ -164,7 +18,7 @@ bool OcclusionQueryDx::CreateDepthStencilBuffer()
 
     if(m_DeviceHandle == nullptr)
     {
-        Log::Error("[D3D12] Failed to create depth stencil buffer");
+        LOG_ERROR("[D3D12] Failed to create depth stencil buffer");
         return false;
     }
 
@@ -179,16 +33,6 @@ bool OcclusionQueryDx::CreateDepthStencilBuffer()
     return true;
 }
 
-struct InstanceData
-{
-    glm::mat4 LocalToWorld;
-    glm::mat4 WorldToLocal;
-    uint32_t MaterialIndex;
-    uint32_t Padding0;
-    uint32_t Padding1;
-    uint32_t Padding2;
-};
-
 struct MaterialData
 {
     glm::vec4 Color;
@@ -229,8 +73,7 @@ bool OcclusionQueryDx::CreateResources()
             return false;
 
         const DirectX::TexMetadata& metadata = m_Textures[i]->GetTextureDesc();
-        m_MainTextures[i] = CreateTextureHelper(m_DeviceHandle.Get()
-            , metadata.format
+        m_MainTextures[i] = CreateTexture(metadata.format
             , metadata.width
             , metadata.height
             , D3D12_RESOURCE_STATE_COPY_DEST
@@ -258,7 +101,20 @@ bool OcclusionQueryDx::CreateResources()
         materialsData[i].TexIndex = static_cast<uint32_t>(s_TexturesCount * dis01(gen));
 
     }
-    std::array<InstanceData, s_InstancesCount> instancesData;
+    const aiMesh* mesh = m_Mesh->GetMesh();
+    glm::vec3 meshMin(FLT_MAX), meshMax(-FLT_MAX);
+    for(uint32_t i = 0; i < m_Mesh->GetVerticesCount(); ++i)
+    {
+        const glm::vec3 position(mesh->mVertices[i].x, mesh->mVertices[i].y, mesh->mVertices[i].z);
+        meshMin = glm::min(meshMin, position);
+        meshMax = glm::max(meshMax, position);
+    }
+    const glm::vec3 meshCenter = (meshMin + meshMax) * 0.5f;
+    const glm::vec3 meshExtents = (meshMax - meshMin) * 0.5f;
+
+    std::vector<InstanceData>& instancesData = m_InstancesData;
+    instancesData.resize(s_InstancesCount);
+    m_InstanceBounds.resize(s_InstancesCount);
     for(uint32_t i = 0; i < s_InstancesCount; ++i)
     {
         // random generate instance data
@@ -271,10 +127,29 @@ bool OcclusionQueryDx::CreateResources()
         instancesData[i].LocalToWorld = transform.GetLocalToWorldMatrix();
         instancesData[i].WorldToLocal = transform.GetWorldToLocalMatrix();
         instancesData[i].MaterialIndex = i % materialCount;
+
+        // World bounds of the transformed local box
+        const glm::mat4& localToWorld = instancesData[i].LocalToWorld;
+        const glm::vec3 center = glm::vec3(localToWorld * glm::vec4(meshCenter, 1.0f));
+        glm::vec3 extents(0.0f);
+        for(uint32_t axis = 0; axis < 3; ++axis)
+            extents += glm::abs(glm::vec3(localToWorld[axis])) * meshExtents[axis];
+        m_InstanceBounds[i].Min = center - extents;
+        m_InstanceBounds[i].Max = center + extents;
+    }
+
+    // Instances of one query group have to be next to each other in the instance buffer
+    std::vector<uint32_t> groupOrder;
+    m_QueryGroups.Build(m_InstanceBounds.data(), s_InstancesCount, s_QueryGroupSize, groupOrder);
+    const std::vector<InstanceData> unorderedInstances = instancesData;
+    const std::vector<OcclusionBox> unorderedBounds = m_InstanceBounds;
+    for(uint32_t i = 0; i < s_InstancesCount; ++i)
+    {
+        instancesData[i] = unorderedInstances[groupOrder[i]];
+        m_InstanceBounds[i] = unorderedBounds[groupOrder[i]];
     }
 
     std::vector<VertexData> verticesData(m_Mesh->GetVerticesCount());
-    const aiMesh* mesh = m_Mesh->GetMesh();
     for(uint32_t i = 0; i < m_Mesh->GetVerticesCount(); ++i)
     {
         verticesData[i].Position = glm::vec3(mesh->mVertices[i].x, mesh->mVertices[i].y, mesh->mVertices[i].z);
@@ -282,16 +157,14 @@ bool OcclusionQueryDx::CreateResources()
         verticesData[i].TexCoord = glm::vec2(mesh->mTextureCoords[0][i].x, mesh->mTextureCoords[0][i].y);
     }
 
-    m_CameraDataBuffer = CreateBufferHelper(m_DeviceHandle.Get()
-        , CameraData::GetAlignedByteSizes()
+    m_CameraDataBuffer = CreateBuffer(CameraData::GetAlignedByteSizes()
         , D3D12_RESOURCE_STATE_GENERIC_READ
         , D3D12_HEAP_TYPE_UPLOAD
         , D3D12_RESOURCE_FLAG_NONE);
 
     if(!m_CameraDataBuffer.Get()) return false;
 
-    m_LightDataBuffer = CreateBufferHelper(m_DeviceHandle.Get()
-        , DirectionalLightData::GetAlignedByteSizes()
+    m_LightDataBuffer = CreateBuffer(DirectionalLightData::GetAlignedByteSizes()
         , D3D12_RESOURCE_STATE_GENERIC_READ
         , D3D12_HEAP_TYPE_UPLOAD
         , D3D12_RESOURCE_FLAG_NONE);
@@ -299,16 +172,14 @@ bool OcclusionQueryDx::CreateResources()
     if(!m_LightDataBuffer.Get()) return false;
 
     const size_t vertexBufferSize = m_Mesh->GetVerticesCount() * sizeof(VertexData);
-    m_VerticesBuffer = CreateBufferHelper(m_DeviceHandle.Get()
-        , vertexBufferSize
+    m_VerticesBuffer = CreateBuffer(vertexBufferSize
         , D3D12_RESOURCE_STATE_COPY_DEST
         , D3D12_HEAP_TYPE_DEFAULT
         , D3D12_RESOURCE_FLAG_NONE);
 
     if(!m_VerticesBuffer.Get()) return false;
 
-    m_IndicesBuffer = CreateBufferHelper(m_DeviceHandle.Get()
-        , m_Mesh->GetIndicesDataByteSize()
+    m_IndicesBuffer = CreateBuffer(m_Mesh->GetIndicesDataByteSize()
         , D3D12_RESOURCE_STATE_COPY_DEST
         , D3D12_HEAP_TYPE_DEFAULT
         , D3D12_RESOURCE_FLAG_NONE);
@@ -316,8 +187,7 @@ bool OcclusionQueryDx::CreateResources()
     if(!m_IndicesBuffer.Get()) return false;
 
     const size_t instanceBufferBytesSize = s_InstancesCount * sizeof(InstanceData);
-    m_InstancesBuffer = CreateBufferHelper(m_DeviceHandle.Get()
-        , instanceBufferBytesSize
+    m_InstancesBuffer = CreateBuffer(instanceBufferBytesSize
         , D3D12_RESOURCE_STATE_COPY_DEST
         , D3D12_HEAP_TYPE_DEFAULT
         , D3D12_RESOURCE_FLAG_NONE);
@@ -325,25 +195,35 @@ bool OcclusionQueryDx::CreateResources()
     if(!m_InstancesBuffer.Get()) return false;
 
     const size_t materialsBufferBytesSize = materialCount * sizeof(MaterialData);
-    m_MaterialsBuffer = CreateBufferHelper(m_DeviceHandle.Get()
-        , materialsBufferBytesSize
+    m_MaterialsBuffer = CreateBuffer(materialsBufferBytesSize
         , D3D12_RESOURCE_STATE_COPY_DEST
         , D3D12_HEAP_TYPE_DEFAULT
         , D3D12_RESOURCE_FLAG_NONE);
 
     if(!m_MaterialsBuffer.Get()) return false;
 
+    m_VisibleInstancesBuffer = CreateBuffer(instanceBufferBytesSize
+        , D3D12_RESOURCE_STATE_GENERIC_READ
+        , D3D12_HEAP_TYPE_UPLOAD
+        , D3D12_RESOURCE_FLAG_NONE);
+
+    if(!m_VisibleInstancesBuffer.Get()) return false;
+
+    m_SoftwareOcclusion.Init(s_OcclusionBufferWidth, s_OcclusionBufferHeight);
+    LOG_INFO("[Occlusion] %ux%u software occlusion buffer, AVX2 %s", m_SoftwareOcclusion.GetWidth(), m_SoftwareOcclusion.GetHeight()
+        , m_SoftwareOcclusion.IsAvx2Enabled() ? "on" : "off");
+
     BeginCommandList();
 
-    auto stagingBuffer1 = UploadBuffer(m_DeviceHandle.Get(), m_CommandList.Get(), m_VerticesBuffer.Get(), verticesData.data(), vertexBufferSize);
-    auto stagingBuffer2 = UploadBuffer(m_DeviceHandle.Get(), m_CommandList.Get(), m_IndicesBuffer.Get(), m_Mesh->GetIndicesData(), m_Mesh->GetIndicesDataByteSize());
-    auto stagingBuffer3 = UploadBuffer(m_DeviceHandle.Get(), m_CommandList.Get(), m_InstancesBuffer.Get(), instancesData.data(), instanceBufferBytesSize);
-    auto stagingBuffer4 = UploadBuffer(m_DeviceHandle.Get(), m_CommandList.Get(), m_MaterialsBuffer.Get(), materialsData.data(), materialsBufferBytesSize);
-    auto stagingBuffer5 = UploadTexture(m_DeviceHandle.Get(), m_CommandList.Get(), m_MainTextures[0].Get(), m_Textures[0]->GetScratchImage());
-    auto stagingBuffer6 = UploadTexture(m_DeviceHandle.Get(), m_CommandList.Get(), m_MainTextures[1].Get(), m_Textures[1]->GetScratchImage());
-    auto stagingBuffer7 = UploadTexture(m_DeviceHandle.Get(), m_CommandList.Get(), m_MainTextures[2].Get(), m_Textures[2]->GetScratchImage());
-    auto stagingBuffer8 = UploadTexture(m_DeviceHandle.Get(), m_CommandList.Get(), m_MainTextures[3].Get(), m_Textures[3]->GetScratchImage());
-    auto stagingBuffer9 = UploadTexture(m_DeviceHandle.Get(), m_CommandList.Get(), m_MainTextures[4].Get(), m_Textures[4]->GetScratchImage());
+    auto stagingBuffer1 = UploadBuffer(m_VerticesBuffer.Get(), verticesData.data(), vertexBufferSize);
+    auto stagingBuffer2 = UploadBuffer(m_IndicesBuffer.Get(), m_Mesh->GetIndicesData(), m_Mesh->GetIndicesDataByteSize());
+    auto stagingBuffer3 = UploadBuffer(m_InstancesBuffer.Get(), instancesData.data(), instanceBufferBytesSize);
+    auto stagingBuffer4 = UploadBuffer(m_MaterialsBuffer.Get(), materialsData.data(), materialsBufferBytesSize);
+    auto stagingBuffer5 = UploadTexture(m_MainTextures[0].Get(), m_Textures[0]->GetScratchImage());
+    auto stagingBuffer6 = UploadTexture(m_MainTextures[1].Get(), m_Textures[1]->GetScratchImage());
+    auto stagingBuffer7 = UploadTexture(m_MainTextures[2].Get(), m_Textures[2]->GetScratchImage());
+    auto stagingBuffer8 = UploadTexture(m_MainTextures[3].Get(), m_Textures[3]->GetScratchImage());
+    auto stagingBuffer9 = UploadTexture(m_MainTextures[4].Get(), m_Textures[4]->GetScratchImage());
 
 
     std::array<CD3DX12_RESOURCE_BARRIER, 9> barriers;
@@ -402,20 +282,23 @@ bool OcclusionQueryDx::CreateResources()
 
 bool OcclusionQueryDx::CreateQueryResultResources()
 {
-    m_OcclusionQueryResult = CreateBufferHelper(m_DeviceHandle.Get()
-        , 8
+    m_OcclusionQueryResult = CreateBuffer(s_QueryGroupCount * sizeof(uint64_t)
         , D3D12_RESOURCE_STATE_PREDICATION
         , D3D12_HEAP_TYPE_DEFAULT
         , D3D12_RESOURCE_FLAG_NONE);
+    if(m_OcclusionQueryResult == nullptr) return false;
+    m_StateTracker.TrackResource(m_OcclusionQueryResult.Get(), D3D12_RESOURCE_STATE_PREDICATION);
 
-    m_TimestampQueryResult = CreateBufferHelper(m_DeviceHandle.Get()
-        , sizeof(uint64_t) * TimeQueryCount
-        , D3D12_RESOURCE_STATE_COPY_DEST
-        , D3D12_HEAP_TYPE_READBACK
-        , D3D12_RESOURCE_FLAG_NONE);
+    for(Microsoft::WRL::ComPtr<ID3D12Resource>& readback : m_OcclusionQueryReadback)
+    {
+        readback = CreateBuffer(s_QueryGroupCount * sizeof(uint64_t)
+            , D3D12_RESOURCE_STATE_COPY_DEST
+            , D3D12_HEAP_TYPE_READBACK
+            , D3D12_RESOURCE_FLAG_NONE);
+        if(readback == nullptr) return false;
+    }
 
-    m_PipelineStatisticsQueryResult = CreateBufferHelper(m_DeviceHandle.Get()
-        , 8
+    m_PipelineStatisticsQueryResult = CreateBuffer(8
         , D3D12_RESOURCE_STATE_COPY_DEST
         , D3D12_HEAP_TYPE_READBACK
         , D3D12_RESOURCE_FLAG_NONE);
@@ -1,4 +1,7 @@
 #include "OcclusionQueryDx.h"
+#include "CpuProfiler.h"
+#include <algorithm>
+#include <numeric>
 
 void OcclusionQueryDx::UpdateConstants()
 {
@@ -13,6 +16,131 @@ void OcclusionQueryDx::UpdateConstants()
     WriteBufferData(m_LightDataBuffer.Get(), &lightData, DirectionalLightData::GetAlignedByteSizes());
 }
 
+uint32_t OcclusionQueryDx::CullInstances()
+{
+    PROFILE_ZONE("CullInstances");
+    const glm::mat4 worldToClip = m_Camera.GetViewProjectionMatrix();
+    const glm::vec3 cameraPosition = m_Camera.Transform.GetWorldPosition();
+
+    // Bounding radius over distance ranks the instances by how much of the screen they cover
+    auto screenSize = [&](uint32_t inIndex)
+    {
+        const OcclusionBox& box = m_InstanceBounds[inIndex];
+        const float distance = glm::length((box.Min + box.Max) * 0.5f - cameraPosition);
+        return glm::length(box.Max - box.Min) / std::max(distance, 0.001f);
+    };
+    m_OccluderIndices.resize(s_InstancesCount);
+    std::iota(m_OccluderIndices.begin(), m_OccluderIndices.end(), 0u);
+    const uint32_t occluderCount = std::min(s_OccluderCount, s_InstancesCount);
+    std::partial_sort(m_OccluderIndices.begin(), m_OccluderIndices.begin() + occluderCount, m_OccluderIndices.end()
+        , [&](uint32_t inLhs, uint32_t inRhs) { return screenSize(inLhs) > screenSize(inRhs); });
+
+    m_SoftwareOcclusion.Clear();
+    const aiMesh* mesh = m_Mesh->GetMesh();
+    const uint32_t* indices = static_cast<const uint32_t*>(m_Mesh->GetIndicesData());
+    for(uint32_t i = 0; i < occluderCount; ++i)
+    {
+        const glm::mat4 localToClip = worldToClip * m_InstancesData[m_OccluderIndices[i]].LocalToWorld;
+        m_SoftwareOcclusion.RenderOccluder(&mesh->mVertices[0].x, sizeof(aiVector3D), indices, m_Mesh->GetIndicesCount(), localToClip);
+    }
+
+    m_VisibleInstances.clear();
+    m_SoftwareOcclusion.TestBoxes(m_InstanceBounds.data(), s_InstancesCount, worldToClip, m_VisibleInstances);
+
+    uint8_t* mappedData = nullptr;
+    const D3D12_RANGE readRange = {0, 0};
+    m_VisibleInstancesBuffer->Map(0, &readRange, reinterpret_cast<void**>(&mappedData));
+    InstanceData* visibleInstances = reinterpret_cast<InstanceData*>(mappedData);
+    for(uint32_t i = 0; i < m_VisibleInstances.size(); ++i)
+        visibleInstances[i] = m_InstancesData[m_VisibleInstances[i]];
+    m_VisibleInstancesBuffer->Unmap(0, nullptr);
+
+    PROFILE_COUNTER("Visible instances", m_VisibleInstances.size());
+    return static_cast<uint32_t>(m_VisibleInstances.size());
+}
+
+void OcclusionQueryDx::DrawQueryGroups()
+{
+    PROFILE_ZONE("DrawQueryGroups");
+    if(m_QueryFrame >= s_QueryReadbackCount - 1)
+    {
+        // The frame that wrote this slot has been waited for, frames never overlap by more than the ring size
+        const uint32_t slot = static_cast<uint32_t>((m_QueryFrame - (s_QueryReadbackCount - 1)) % s_QueryReadbackCount);
+        uint64_t* results = nullptr;
+        const D3D12_RANGE readRange = {0, s_QueryGroupCount * sizeof(uint64_t)};
+        m_OcclusionQueryReadback[slot]->Map(0, &readRange, reinterpret_cast<void**>(&results));
+        m_QueryGroups.UpdateVisibility(results);
+        const D3D12_RANGE writeRange = {0, 0};
+        m_OcclusionQueryReadback[slot]->Unmap(0, &writeRange);
+    }
+
+    const glm::vec3 cameraPosition = m_Camera.Transform.GetWorldPosition();
+    const bool hasResults = m_QueryFrame > 0;
+    uint32_t skippedGroups = 0;
+    uint32_t skippedInstances = 0;
+    for(uint32_t i = 0; i < m_QueryGroups.GetGroupCount(); ++i)
+    {
+        const OcclusionQueryGroups::Group& group = m_QueryGroups.GetGroups()[i];
+        const bool cameraInside = OcclusionQueryGroups::IsCameraInside(group.Bounds, cameraPosition, m_Camera.Near);
+        bool predicated = false;
+        if(Occlusion == OcclusionMode::QueryTemporal && !cameraInside && !m_QueryGroups.IsVisible(i))
+        {
+            ++skippedGroups;
+            skippedInstances += group.InstanceCount;
+            continue;
+        }
+        if(Occlusion == OcclusionMode::QueryPredication && !cameraInside && hasResults)
+        {
+            // The GPU skips the draw when the query of the last frame found no sample, the readback of the same
+            // results only counts it
+            m_CommandList->SetPredication(m_OcclusionQueryResult.Get(), i * sizeof(uint64_t), D3D12_PREDICATION_OP_EQUAL_ZERO);
+            predicated = true;
+            if(!m_QueryGroups.HasPassed(i))
+            {
+                ++skippedGroups;
+                skippedInstances += group.InstanceCount;
+            }
+        }
+
+        m_CommandList->SetGraphicsRootShaderResourceView(2, m_InstancesBuffer->GetGPUVirtualAddress() + group.FirstInstance * sizeof(InstanceData));
+        m_CommandList->DrawIndexedInstanced(m_Mesh->GetIndicesCount(), group.InstanceCount, 0, 0, 0);
+        if(predicated)
+            m_CommandList->SetPredication(nullptr, 0, D3D12_PREDICATION_OP_EQUAL_ZERO);
+    }
+
+    m_QueryGroups.AddFrameStats(skippedGroups, skippedInstances);
+    PROFILE_COUNTER("Skipped draws", skippedGroups);
+    PROFILE_COUNTER("Skipped instances", skippedInstances);
+}
+
+void OcclusionQueryDx::DrawQueryProxies()
+{
+    PROFILE_ZONE("DrawQueryProxies");
+    BeginGpuScope("Occlusion queries");
+    m_CommandList->SetGraphicsRootSignature(m_ProxyRootSignature.Get());
+    m_CommandList->SetPipelineState(m_ProxyPipelineState.Get());
+    m_CommandList->SetGraphicsRootConstantBufferView(0, m_CameraDataBuffer->GetGPUVirtualAddress());
+    for(uint32_t i = 0; i < m_QueryGroups.GetGroupCount(); ++i)
+    {
+        const OcclusionBox& bounds = m_QueryGroups.GetGroups()[i].Bounds;
+        ProxyBox box{bounds.Min, 0.0f, bounds.Max, 0.0f};
+        m_CommandList->SetGraphicsRoot32BitConstants(1, sizeof(ProxyBox) / sizeof(uint32_t), &box, 0);
+        m_CommandList->BeginQuery(m_OcclusionQueryHeap.Get(), D3D12_QUERY_TYPE_BINARY_OCCLUSION, i);
+        m_CommandList->DrawInstanced(36, 1, 0, 0);
+        m_CommandList->EndQuery(m_OcclusionQueryHeap.Get(), D3D12_QUERY_TYPE_BINARY_OCCLUSION, i);
+    }
+
+    const uint32_t slot = static_cast<uint32_t>(m_QueryFrame % s_QueryReadbackCount);
+    m_StateTracker.Transition(m_OcclusionQueryResult.Get(), D3D12_RESOURCE_STATE_COPY_DEST);
+    m_StateTracker.Flush(m_CommandList.Get());
+    m_CommandList->ResolveQueryData(m_OcclusionQueryHeap.Get(), D3D12_QUERY_TYPE_BINARY_OCCLUSION, 0, s_QueryGroupCount, m_OcclusionQueryResult.Get(), 0);
+    m_CommandList->ResolveQueryData(m_OcclusionQueryHeap.Get(), D3D12_QUERY_TYPE_BINARY_OCCLUSION, 0, s_QueryGroupCount, m_OcclusionQueryReadback[slot].Get(), 0);
+    m_StateTracker.Transition(m_OcclusionQueryResult.Get(), D3D12_RESOURCE_STATE_PREDICATION);
+    m_StateTracker.Flush(m_CommandList.Get());
+    ++m_QueryFrame;
+    EndGpuScope();
+}
+
 void OcclusionQueryDx::Tick()
 {
     if(!m_IsRunning)
@@ -22,8 +150,7 @@ void OcclusionQueryDx::Tick()
 
     BeginCommandList();
     UpdateConstants();
-    
-    m_CommandList->EndQuery(m_TimestampQueryHeap.Get(), D3D12_QUERY_TYPE_TIMESTAMP, 0);
+    BeginGpuScope("Draw");
 
     D3D12_RESOURCE_BARRIER preBarriers;
     preBarriers = CD3DX12_RESOURCE_BARRIER::Transition(m_BackBuffers[m_CurrentIndex].Get(), D3D12_RESOURCE_STATE_PRESENT, D3D12_RESOURCE_STATE_RENDER_TARGET);
@@ -59,30 +186,37 @@ void OcclusionQueryDx::Tick()
     
     m_CommandList->SetGraphicsRootConstantBufferView(0, m_CameraDataBuffer->GetGPUVirtualAddress());
     m_CommandList->SetGraphicsRootConstantBufferView(1, m_LightDataBuffer->GetGPUVirtualAddress());
-    m_CommandList->SetGraphicsRootShaderResourceView(2, m_InstancesBuffer->GetGPUVirtualAddress());
     m_CommandList->SetGraphicsRootDescriptorTable(3, m_ShaderBoundViewHeap->GetGPUDescriptorHandleForHeapStart());
     m_CommandList->SetGraphicsRootShaderResourceView(4, m_MaterialsBuffer->GetGPUVirtualAddress());
     m_CommandList->SetGraphicsRootDescriptorTable(5, m_SamplerHeap->GetGPUDescriptorHandleForHeapStart());
     
-    if(IsOcclusionCulling)
+    if(Occlusion == OcclusionMode::QueryPredication || Occlusion == OcclusionMode::QueryTemporal)
     {
-        
+        DrawQueryGroups();
+        DrawQueryProxies();
     }
     else
     {
-        
-    }
+        uint32_t instanceCount = s_InstancesCount;
+        if(Occlusion == OcclusionMode::Software)
+        {
+            // Every frame is flushed before the next one starts, the upload buffer is free to rewrite
+            instanceCount = CullInstances();
+            m_CommandList->SetGraphicsRootShaderResourceView(2, m_VisibleInstancesBuffer->GetGPUVirtualAddress());
+        }
+        else
+        {
+            m_CommandList->SetGraphicsRootShaderResourceView(2, m_InstancesBuffer->GetGPUVirtualAddress());
+        }
 
-    m_CommandList->DrawIndexedInstanced(m_Mesh->GetIndicesCount(), s_InstancesCount, 0, 0, 0);
-    
-    m_CommandList->EndQuery(m_TimestampQueryHeap.Get(), D3D12_QUERY_TYPE_TIMESTAMP, 1);
+        if(instanceCount > 0)
+            m_CommandList->DrawIndexedInstanced(m_Mesh->GetIndicesCount(), instanceCount, 0, 0, 0);
+    }
+    EndGpuScope();
     
     D3D12_RESOURCE_BARRIER postBarriers;
     postBarriers = CD3DX12_RESOURCE_BARRIER::Transition(m_BackBuffers[m_CurrentIndex].Get(), D3D12_RESOURCE_STATE_RENDER_TARGET, D3D12_RESOURCE_STATE_PRESENT);
     m_CommandList->ResourceBarrier(1, &postBarriers);
-
-    m_CommandList->ResolveQueryData(m_TimestampQueryHeap.Get(), D3D12_QUERY_TYPE_TIMESTAMP, 0, 2, m_TimestampQueryResult.Get(), 0);
-    
     EndCommandList();    
 
     ID3D12CommandList* commandLists[] = {m_CommandList.Get()};
@@ -90,10 +224,4 @@ void OcclusionQueryDx::Tick()
     FlushCommandQueue();
     m_SwapChainHandle->Present(0, 0);
     m_CurrentIndex = (m_CurrentIndex + 1) % s_BackBufferCount;
-  
-    uint64_t time[2];
-    ReadBackBufferData(m_TimestampQueryResult.Get(), time, sizeof(uint64_t) * 2, 0);
-    // ReadBackBufferData(m_TimestampQueryResult.Get(), &endTime, sizeof(uint64_t), sizeof(uint64_t));
-    Log::Info("startTime: %lu, endTime: %lu, deltaTime: %lu", time[0], time[1], time[1] - time[0]);
-    
 }
\ No newline at end of file
@@ -0,0 +1,163 @@
+#pragma once
+
+#include "../AppBaseVk.h"
+
+#include "Transform.h"
+#include "Camera.h"
+#include "Light.h"
+#include "AssetsManager.h"
+#include "OcclusionQueryGroups.h"
+#include <array>
+
+struct ProxyBox
+{
+    glm::vec3 Min;
+    float     Padding0;
+    glm::vec3 Max;
+    float     Padding1;
+};
+
+struct InstanceData
+{
+    glm::mat4 LocalToWorld;
+    glm::mat4 WorldToLocal;
+    uint32_t MaterialIndex;
+    uint32_t Padding0;
+    uint32_t Padding1;
+    uint32_t Padding2;
+};
+
+struct MaterialData
+{
+    glm::vec4 Color;
+    float Smooth;
+    uint32_t TexIndex;
+    uint32_t Padding0;
+    uint32_t Padding1;
+};
+
+struct VertexData
+{
+    glm::vec3 Position;
+    glm::vec3 Normal;
+    glm::vec2 TexCoord;
+};
+
+class OcclusionQueryVk : public AppBaseVk
+{
+public:
+    using AppBaseVk::AppBaseVk;
+    static constexpr uint32_t s_TexturesCount = 5;
+    static constexpr uint32_t s_InstancesCount = 1024;
+    static constexpr uint32_t s_MaterialCount = 100;
+    static constexpr VkFormat s_DepthStencilFormat = VK_FORMAT_D32_SFLOAT;
+    // Instances sharing one occlusion query
+    static constexpr uint32_t s_QueryGroupSize = 16;
+    static constexpr uint32_t s_QueryGroupCount = (s_InstancesCount + s_QueryGroupSize - 1) / s_QueryGroupSize;
+    // Ring of query readbacks, the CPU reads the results s_QueryReadbackCount - 1 frames after they were written
+    static constexpr uint32_t s_QueryReadbackCount = 2;
+
+    enum class OcclusionMode
+    {
+        None,
+        QueryPredication,   // VK_EXT_conditional_rendering skips the draws of a group whose last query found no sample
+        QueryTemporal,      // the CPU skips the groups whose queries read back as hidden, with hysteresis
+    };
+    OcclusionMode Occlusion = OcclusionMode::QueryTemporal;
+
+protected:
+    bool Init() override;
+    void Tick() override;
+    void Shutdown() override;
+    CameraBase* GetBenchmarkCamera() override { return &m_Camera; }
+
+private:
+    bool CreateDevice() override;
+    void DestroyDevice() override;
+    bool CreateDescriptorLayout();
+    void DestroyDescriptorLayout();
+    bool CreateShader();
+    void DestroyShader();
+    bool CreateRenderPass();
+    void DestroyRenderPass();
+    bool CreatePipelineState();
+    void DestroyPipelineState();
+    bool CreateDepthStencilBuffer();
+    void DestroyDepthStencilBuffer();
+    bool CreateFrameBuffer();
+    void DestroyFrameBuffer();
+    bool CreateScene();
+    bool CreateResources();
+    void DestroyResources();
+    bool CreateQueryResources();
+    void DestroyQueryResources();
+    void UpdateConstants();
+    void DrawQueryGroups();
+    // Bounding boxes of every group with an occlusion query each
+    void DrawQueryProxies();
+    // Outside of the render pass, the results of this frame go to the conditional rendering buffer and the readback
+    void CopyQueryResults();
+
+    VkDescriptorSetLayout       m_DescriptorLayoutSpace0;
+    VkDescriptorSetLayout       m_DescriptorLayoutSpace1;
+    VkDescriptorSetLayout       m_ProxyDescriptorLayout {VK_NULL_HANDLE};
+    std::shared_ptr<AssetsManager::Blob> m_VertexShaderBlob;
+    std::shared_ptr<AssetsManager::Blob> m_PixelShaderBlob;
+    std::shared_ptr<AssetsManager::Blob> m_ProxyVertexShaderBlob;
+    VkShaderModule              m_VertexShaderModule;
+    VkShaderModule              m_PixelShaderModule;
+    VkShaderModule              m_ProxyVertexShaderModule {VK_NULL_HANDLE};
+    VkRenderPass                m_RenderPassHandle;
+    VkPipelineLayout            m_PipelineLayout;
+    VkPipeline                  m_PipelineState;
+    VkPipelineLayout            m_ProxyPipelineLayout {VK_NULL_HANDLE};
+    VkPipeline                  m_ProxyPipelineState {VK_NULL_HANDLE};
+
+    VkDeviceMemory              m_DepthStencilMemory;
+    VkImage                     m_DepthStencilTexture;
+    VkImageView                 m_Dsv;
+
+    std::vector<VkFramebuffer>  m_FrameBuffers;
+
+    CameraPerspective                                   m_Camera;
+    Light                                               m_Light;
+    std::shared_ptr<AssetsManager::Mesh>                m_Mesh;
+    std::array<std::shared_ptr<AssetsManager::Texture>, s_TexturesCount>  m_Textures;
+    std::vector<VertexData>     m_VerticesData;
+    std::array<InstanceData, s_InstancesCount> m_InstancesData;
+    std::array<MaterialData, s_MaterialCount> m_MaterialsData;
+
+    VkBuffer                    m_CameraDataBuffer;
+    VkDeviceMemory              m_CameraBufferMemory;
+    VkBuffer                    m_LightDataBuffer;
+    VkDeviceMemory              m_LightDataMemory;
+    VkBuffer                    m_InstanceBuffer;
+    VkDeviceMemory              m_InstanceBufferMemory;
+    VkBuffer                    m_MaterialsBuffer;
+    VkDeviceMemory              m_MaterialsBufferMemory;
+    VkBuffer                    m_VerticesBuffer;
+    VkDeviceMemory              m_VerticesBufferMemory;
+    VkBuffer                    m_IndicesBuffer;
+    VkDeviceMemory              m_IndicesBufferMemory;
+    std::array<VkImage,  s_TexturesCount>           m_MainTextures;
+    std::array<VkImageView, s_TexturesCount>        m_MainTextureViews;
+    std::array<VkDeviceMemory, s_TexturesCount>     m_MainTextureMemories;
+    std::array<VkSampler, s_TexturesCount>     m_MainTextureSamplers;
+
+    VkDescriptorSet             m_DescriptorSetSpace0;
+    VkDescriptorSet             m_DescriptorSetSpace1;
+    VkDescriptorSet             m_ProxyDescriptorSet {VK_NULL_HANDLE};
+
+    VkQueryPool                 m_OcclusionQueryPool {VK_NULL_HANDLE};
+    VkBuffer                    m_ConditionalRenderingBuffer {VK_NULL_HANDLE};      // one uint32 per group
+    VkDeviceMemory              m_ConditionalRenderingMemory {VK_NULL_HANDLE};
+    std::array<VkBuffer, s_QueryReadbackCount>          m_QueryReadbackBuffers {};  // one uint64 per group
+    std::array<VkDeviceMemory, s_QueryReadbackCount>    m_QueryReadbackMemories {};
+    uint64_t                    m_QueryFrame = 0;                                   // frames that copied their queries
+    bool                        m_ConditionalRenderingSupported = false;
+    PFN_vkCmdBeginConditionalRenderingEXT               vkCmdBeginConditionalRenderingEXT = nullptr;
+    PFN_vkCmdEndConditionalRenderingEXT                 vkCmdEndConditionalRenderingEXT = nullptr;
+
+    std::array<OcclusionBox, s_InstancesCount>          m_InstanceBounds;   // world space
+    OcclusionQueryGroups                                m_QueryGroups;
+};
@@ -0,0 +1,191 @@
+#include "OcclusionQueryVk.h"
+#include "CpuProfiler.h"
+#include <array>
+
+void OcclusionQueryVk::UpdateConstants()
+{
+    CameraData cameraData;
+    m_Camera.GetCameraData(cameraData);
+    WriteBufferData(m_DeviceHandle, m_CameraBufferMemory, &cameraData, CameraData::GetAlignedByteSizes());
+
+    DirectionalLightData lightData;
+    lightData.LightColor = m_Light.Color;
+    lightData.LightDirection = m_Light.Transform.GetWorldForward();
+    lightData.LightIntensity = m_Light.Intensity;
+    WriteBufferData(m_DeviceHandle, m_LightDataMemory, &lightData, DirectionalLightData::GetAlignedByteSizes());
+}
+
+void OcclusionQueryVk::DrawQueryGroups()
+{
+    PROFILE_ZONE("DrawQueryGroups");
+    if(m_QueryFrame >= s_QueryReadbackCount - 1)
+    {
+        // Every frame is waited for before the next one starts, the slot written s_QueryReadbackCount - 1 frames ago
+        // holds complete results
+        const uint32_t slot = static_cast<uint32_t>((m_QueryFrame - (s_QueryReadbackCount - 1)) % s_QueryReadbackCount);
+        void* results = nullptr;
+        if(vkMapMemory(m_DeviceHandle, m_QueryReadbackMemories[slot], 0, s_QueryGroupCount * sizeof(uint64_t), 0, &results) == VK_SUCCESS)
+        {
+            m_QueryGroups.UpdateVisibility(static_cast<const uint64_t*>(results));
+            vkUnmapMemory(m_DeviceHandle, m_QueryReadbackMemories[slot]);
+        }
+    }
+
+    const glm::vec3 cameraPosition = m_Camera.Transform.GetWorldPosition();
+    const bool hasResults = m_QueryFrame > 0;
+    uint32_t skippedGroups = 0;
+    uint32_t skippedInstances = 0;
+    for(uint32_t i = 0; i < m_QueryGroups.GetGroupCount(); ++i)
+    {
+        const OcclusionQueryGroups::Group& group = m_QueryGroups.GetGroups()[i];
+        const bool cameraInside = OcclusionQueryGroups::IsCameraInside(group.Bounds, cameraPosition, m_Camera.Near);
+        bool predicated = false;
+        if(Occlusion == OcclusionMode::QueryTemporal && !cameraInside && !m_QueryGroups.IsVisible(i))
+        {
+            ++skippedGroups;
+            skippedInstances += group.InstanceCount;
+            continue;
+        }
+        if(Occlusion == OcclusionMode::QueryPredication && !cameraInside && hasResults)
+        {
+            // The GPU discards the draw when the query of the last frame found no sample, the readback of the same
+            // results only counts it
+            VkConditionalRenderingBeginInfoEXT conditionalInfo{};
+            conditionalInfo.sType = VK_STRUCTURE_TYPE_CONDITIONAL_RENDERING_BEGIN_INFO_EXT;
+            conditionalInfo.buffer = m_ConditionalRenderingBuffer;
+            conditionalInfo.offset = i * sizeof(uint32_t);
+            vkCmdBeginConditionalRenderingEXT(m_CmdBufferHandle, &conditionalInfo);
+            predicated = true;
+            if(!m_QueryGroups.HasPassed(i))
+            {
+                ++skippedGroups;
+                skippedInstances += group.InstanceCount;
+            }
+        }
+
+        // The shaders are compiled without -fvk-support-nonzero-base-instance, SV_InstanceID starts at firstInstance
+        vkCmdDrawIndexed(m_CmdBufferHandle, m_Mesh->GetIndicesCount(), group.InstanceCount, 0, 0, group.FirstInstance);
+        if(predicated)
+            vkCmdEndConditionalRenderingEXT(m_CmdBufferHandle);
+    }
+
+    m_QueryGroups.AddFrameStats(skippedGroups, skippedInstances);
+    PROFILE_COUNTER("Skipped draws", skippedGroups);
+    PROFILE_COUNTER("Skipped instances", skippedInstances);
+}
+
+void OcclusionQueryVk::DrawQueryProxies()
+{
+    PROFILE_ZONE("DrawQueryProxies");
+    vkCmdBindPipeline(m_CmdBufferHandle, VK_PIPELINE_BIND_POINT_GRAPHICS, m_ProxyPipelineState);
+    vkCmdBindDescriptorSets(m_CmdBufferHandle, VK_PIPELINE_BIND_POINT_GRAPHICS, m_ProxyPipelineLayout, 0, 1, &m_ProxyDescriptorSet, 0, nullptr);
+    for(uint32_t i = 0; i < m_QueryGroups.GetGroupCount(); ++i)
+    {
+        const OcclusionBox& bounds = m_QueryGroups.GetGroups()[i].Bounds;
+        ProxyBox box{bounds.Min, 0.0f, bounds.Max, 0.0f};
+        vkCmdPushConstants(m_CmdBufferHandle, m_ProxyPipelineLayout, VK_SHADER_STAGE_VERTEX_BIT, 0, sizeof(ProxyBox), &box);
+        vkCmdBeginQuery(m_CmdBufferHandle, m_OcclusionQueryPool, i, 0);
+        vkCmdDraw(m_CmdBufferHandle, 36, 1, 0, 0);
+        vkCmdEndQuery(m_CmdBufferHandle, m_OcclusionQueryPool, i);
+    }
+}
+
+void OcclusionQueryVk::CopyQueryResults()
+{
+    VkPipelineStageFlags dstStages = VK_PIPELINE_STAGE_HOST_BIT;
+    VkAccessFlags dstAccess = VK_ACCESS_HOST_READ_BIT;
+    if(m_ConditionalRenderingBuffer != VK_NULL_HANDLE)
+    {
+        // The conditional draws of this pass read the predicates, the copy must not overwrite them before they are done
+        vkCmdPipelineBarrier(m_CmdBufferHandle, VK_PIPELINE_STAGE_CONDITIONAL_RENDERING_BIT_EXT, VK_PIPELINE_STAGE_TRANSFER_BIT, 0, 0, nullptr, 0, nullptr, 0, nullptr);
+        vkCmdCopyQueryPoolResults(m_CmdBufferHandle, m_OcclusionQueryPool, 0, s_QueryGroupCount, m_ConditionalRenderingBuffer
+            , 0, sizeof(uint32_t), VK_QUERY_RESULT_WAIT_BIT);
+        dstStages |= VK_PIPELINE_STAGE_CONDITIONAL_RENDERING_BIT_EXT;
+        dstAccess |= VK_ACCESS_CONDITIONAL_RENDERING_READ_BIT_EXT;
+    }
+
+    const uint32_t slot = static_cast<uint32_t>(m_QueryFrame % s_QueryReadbackCount);
+    vkCmdCopyQueryPoolResults(m_CmdBufferHandle, m_OcclusionQueryPool, 0, s_QueryGroupCount, m_QueryReadbackBuffers[slot]
+        , 0, sizeof(uint64_t), VK_QUERY_RESULT_64_BIT | VK_QUERY_RESULT_WAIT_BIT);
+
+    VkMemoryBarrier barrier{};
+    barrier.sType = VK_STRUCTURE_TYPE_MEMORY_BARRIER;
+    barrier.srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+    barrier.dstAccessMask = dstAccess;
+    vkCmdPipelineBarrier(m_CmdBufferHandle, VK_PIPELINE_STAGE_TRANSFER_BIT, dstStages, 0, 1, &barrier, 0, nullptr, 0, nullptr);
+    ++m_QueryFrame;
+}
+
+void OcclusionQueryVk::Tick()
+{
+    if(!m_IsRunning)
+    {
+        return;
+    }
+
+    BeginCommandList();
+    UpdateConstants();
+
+    const bool useQueries = Occlusion == OcclusionMode::QueryPredication || Occlusion == OcclusionMode::QueryTemporal;
+    if(useQueries)
+        vkCmdResetQueryPool(m_CmdBufferHandle, m_OcclusionQueryPool, 0, s_QueryGroupCount);
+    
+    VkRenderPassBeginInfo renderPassInfo{};
+    renderPassInfo.sType = VK_STRUCTURE_TYPE_RENDER_PASS_BEGIN_INFO;
+    renderPassInfo.renderPass = m_RenderPassHandle;
+    renderPassInfo.framebuffer = m_FrameBuffers[m_CurrentIndex];
+    renderPassInfo.renderArea.offset = { 0, 0 };
+    renderPassInfo.renderArea.extent = m_Capabilities.currentExtent;
+
+    std::array<VkClearValue, 2> clearValues{};
+    clearValues[0].color = { {0.0f, 0.0f, 0.0f, 1.0f} };
+    clearValues[1].depthStencil = { 1.0f, 0 };
+
+    renderPassInfo.clearValueCount = static_cast<uint32_t>(clearValues.size());
+    renderPassInfo.pClearValues = clearValues.data();
+
+    vkCmdBeginRenderPass(m_CmdBufferHandle, &renderPassInfo, VK_SUBPASS_CONTENTS_INLINE);
+    {
+        VkViewport viewport{};
+        viewport.x = 0.0f;
+        viewport.y = 0.0f;
+        viewport.width = static_cast<float>(m_Capabilities.currentExtent.width);
+        viewport.height = static_cast<float>(m_Capabilities.currentExtent.height);
+        viewport.minDepth = 0.0f;
+        viewport.maxDepth = 1.0f;
+        vkCmdSetViewport(m_CmdBufferHandle, 0, 1, &viewport);
+
+        VkRect2D scissor{};
+        scissor.offset = { 0, 0 };
+        scissor.extent = m_Capabilities.currentExtent;
+        vkCmdSetScissor(m_CmdBufferHandle, 0, 1, &scissor);
+
+        VkDescriptorSet descriptorSets[2] = { m_DescriptorSetSpace0, m_DescriptorSetSpace1 };
+        vkCmdBindPipeline(m_CmdBufferHandle, VK_PIPELINE_BIND_POINT_GRAPHICS, m_PipelineState);
+        vkCmdBindDescriptorSets(m_CmdBufferHandle, VK_PIPELINE_BIND_POINT_GRAPHICS, m_PipelineLayout, 0, 2, descriptorSets, 0, nullptr);
+
+        VkBuffer vertexBuffers[] = { m_VerticesBuffer };
+        VkDeviceSize offsets[] = { 0 };
+        vkCmdBindVertexBuffers(m_CmdBufferHandle, 0, 1, vertexBuffers, offsets);
+        vkCmdBindIndexBuffer(m_CmdBufferHandle, m_IndicesBuffer, 0, VK_INDEX_TYPE_UINT32);
+
+        if(useQueries)
+        {
+            DrawQueryGroups();
+            DrawQueryProxies();
+        }
+        else
+        {
+            vkCmdDrawIndexed(m_CmdBufferHandle, m_Mesh->GetIndicesCount(), s_InstancesCount, 0, 0, 0);
+        }
+    }
+    vkCmdEndRenderPass(m_CmdBufferHandle);
+    // The render pass moved the back buffer to its final layout, SaveScreenshot transitions from there
+    m_StateTracker.SetImageState(m_BackBuffers[m_CurrentIndex], VK_IMAGE_LAYOUT_PRESENT_SRC_KHR, VK_PIPELINE_STAGE_2_COLOR_ATTACHMENT_OUTPUT_BIT, VK_ACCESS_2_COLOR_ATTACHMENT_WRITE_BIT);
+    if(useQueries)
+        CopyQueryResults();
+    EndCommandList();
+    
+    ExecuteCommandBuffer(m_ImageAvailableSemaphore);
+    Present();
+}
\ No newline at end of file
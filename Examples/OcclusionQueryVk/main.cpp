@@ -1,14 +1,25 @@
-#include <Windows.h>
+#include "OcclusionQueryVk.h"
 #include <iostream>
+
+#ifdef _WIN32
 int WINAPI WinMain(HINSTANCE hInstance, HINSTANCE hPrevInstance, LPSTR lpCmdLine, int nCmdShow)
 {
+    const RunOptions options = RunOptions::FromCommandLine(__argc, __argv);
+#else
+int main(int argc, char** argv)
+{
+    HINSTANCE hInstance = nullptr;
+    const RunOptions options = RunOptions::FromCommandLine(argc, argv);
+#endif
     try
     {
-        
-        return 0;
+        OcclusionQueryVk app(1280, 720, hInstance, TEXT("Vulkan Occlusion Query"), options);
+        app.Run();
+        return app.GetExitCode();
     }
     catch (std::runtime_error& err)
     {
+        LOG_ERROR("%s", err.what());
         return -1;
     }
-}
\ No newline at end of file
+}
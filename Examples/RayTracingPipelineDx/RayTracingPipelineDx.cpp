@@ -59,7 +59,7 @@ bool RayTracingPipelineDx::CreateDevice()
     if (SUCCEEDED(D3D12GetDebugInterface(IID_PPV_ARGS(&debugController))))
         debugController->EnableDebugLayer();
     else
-        Log::Warning("Failed to enable the D3D12 debug layer");
+        LOG_WARNING("Failed to enable the D3D12 debug layer");
 #endif
     
     const uint32_t factoryFlags = allowDebugging ? DXGI_CREATE_FACTORY_DEBUG : 0;
@@ -92,7 +92,7 @@ bool RayTracingPipelineDx::CreateDevice()
                         m_DeviceHandle = TempDevice;
                         std::wstring adapterDesc(Desc.Description);
                         std::string name(adapterDesc.begin(), adapterDesc.end());
-                        Log::Info("[D3D12] Using adapter: %s", name.c_str());
+                        LOG_INFO("[D3D12] Using adapter: %s", name.c_str());
                         break;
                     }
                 }
@@ -102,7 +102,7 @@ bool RayTracingPipelineDx::CreateDevice()
 
     if(m_DeviceHandle.Get() == nullptr)
     {
-        Log::Error("Failed to find a device supporting ray tracing pipeline");
+        LOG_ERROR("Failed to find a device supporting ray tracing pipeline");
         return false;
     }
     
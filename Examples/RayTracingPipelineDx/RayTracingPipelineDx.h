@@ -39,6 +39,7 @@ protected:
     bool Init() override;
     void Tick() override;
     void Shutdown() override;
+    CameraBase* GetBenchmarkCamera() override { return &m_Camera; }
 
 
     bool CreateDevice();
@@ -34,7 +34,7 @@ bool RayTracingPipelineDx::CreateRootSignature()
     if(FAILED(hr))
     {
         OUTPUT_D3D12_FAILED_RESULT(hr)
-        Log::Error("[D3D12] Failed to serialize the global root signature: %s", static_cast<const char*>(errorBlob->GetBufferPointer()));
+        LOG_ERROR("[D3D12] Failed to serialize the global root signature: %s", static_cast<const char*>(errorBlob->GetBufferPointer()));
         return false;
     }
 
@@ -46,7 +46,7 @@ bool RayTracingPipelineDx::CreateRootSignature()
     if(FAILED(hr))
     {
         OUTPUT_D3D12_FAILED_RESULT(hr)
-        Log::Error("[D3D12] Failed to create the global root signature");
+        LOG_ERROR("[D3D12] Failed to create the global root signature");
         return false;
     }
     
@@ -58,14 +58,14 @@ bool RayTracingPipelineDx::CreateShader()
     m_RayGenShaderBlob = AssetsManager::LoadShaderImmediately("RayTracing.rgen.bin");
     if(!m_RayGenShaderBlob || m_RayGenShaderBlob->IsEmpty())
     {
-        Log::Error("Failed to load ray generation shader");
+        LOG_ERROR("Failed to load ray generation shader");
         return false;
     }
     
     m_MissShadersBlob = AssetsManager::LoadShaderImmediately("RayTracing.rmis.bin");
     if(!m_MissShadersBlob || m_MissShadersBlob->IsEmpty())
     {
-        Log::Error("Failed to miss shader");
+        LOG_ERROR("Failed to miss shader");
         return false;
     }
     
@@ -73,7 +73,7 @@ bool RayTracingPipelineDx::CreateShader()
     m_HitGroupShadersBlob = AssetsManager::LoadShaderImmediately("RayTracing.rhit.bin");
     if(!m_HitGroupShadersBlob || m_HitGroupShadersBlob->IsEmpty())
     {
-        Log::Error("Failed to hit group shaders");
+        LOG_ERROR("Failed to hit group shaders");
         return false;
     }
     return true;
@@ -128,7 +128,7 @@ bool RayTracingPipelineDx::CreatePipelineState()
     if(FAILED(hr))
     {
         OUTPUT_D3D12_FAILED_RESULT(hr)
-        Log::Error("[D3D12] Failed to create the pipeline state");
+        LOG_ERROR("[D3D12] Failed to create the pipeline state");
         return false;
     }
 
@@ -47,7 +47,7 @@ bool RayTracingPipelineDx::CreateScene()
     
     if(m_Mesh == nullptr || m_Mesh->GetMesh() == nullptr)
     {
-        Log::Error("Failed to load mesh");
+        LOG_ERROR("Failed to load mesh");
         return false;
     }
 
@@ -155,7 +155,7 @@ bool RayTracingPipelineDx::CreateBottomLevelAccelStructure()
     m_DeviceHandle->GetRaytracingAccelerationStructurePrebuildInfo(&bottomLevelInputs, &bottomLevelPrebuildInfo);
     if(bottomLevelPrebuildInfo.ResultDataMaxSizeInBytes == 0)
     {
-        Log::Error("Failed to get triangle mesh geometry bottom level prebuild info");
+        LOG_ERROR("Failed to get triangle mesh geometry bottom level prebuild info");
         return false;
     }
 
@@ -182,7 +182,7 @@ bool RayTracingPipelineDx::CreateBottomLevelAccelStructure()
     m_DeviceHandle->GetRaytracingAccelerationStructurePrebuildInfo(&proceduralGeomertryBottomLevelInputs, &bottomLevelPrebuildInfo);
     if(bottomLevelPrebuildInfo.ResultDataMaxSizeInBytes == 0)
     {
-        Log::Error("Failed to get procedural geometry bottom level prebuild info");
+        LOG_ERROR("Failed to get procedural geometry bottom level prebuild info");
         return false;
     }
     
@@ -257,7 +257,7 @@ bool RayTracingPipelineDx::CreateTopLevelAccelStructure()
     m_DeviceHandle->GetRaytracingAccelerationStructurePrebuildInfo(&topLevelInputs, &topLevelPrebuildInfo);
     if(topLevelPrebuildInfo.ResultDataMaxSizeInBytes == 0)
     {
-        Log::Error("Failed to get top level prebuild info");
+        LOG_ERROR("Failed to get top level prebuild info");
         return false;
     }
 
@@ -2,15 +2,16 @@
 
 int WINAPI WinMain(HINSTANCE hInstance, HINSTANCE hPrevInstance, LPSTR lpCmdLine, int nCmdShow)
 {
+    const RunOptions options = RunOptions::FromCommandLine(__argc, __argv);
     try
     {
-        RayTracingPipelineDx app(1280, 720, hInstance, TEXT("D3D12 Ray Tracing Pipeline"));
+        RayTracingPipelineDx app(1280, 720, hInstance, TEXT("D3D12 Ray Tracing Pipeline"), options);
         app.Run();
-        return 0;
+        return app.GetExitCode();
     }
     catch (std::runtime_error& err)
     {
-        Log::Error(err.what());
+        LOG_ERROR("%s", err.what());
         return -1;
     }
 }
\ No newline at end of file
@@ -52,6 +52,7 @@ protected:
     bool Init() override;
     void Tick() override;
     void Shutdown() override;
+    CameraBase* GetBenchmarkCamera() override { return &m_Camera; }
 
 private:
     PFN_vkGetBufferDeviceAddressKHR                 vkGetBufferDeviceAddressKHR;
@@ -22,7 +22,7 @@ bool RayTracingPipelineVk::CreateDescriptorLayout()
     VkResult result = vkCreateDescriptorSetLayout(m_DeviceHandle, &layoutInfo, nullptr, &m_DescriptorLayout);
     if(result != VK_SUCCESS)
     {
-        Log::Error("Failed to create descriptor set layout");
+        LOG_ERROR("Failed to create descriptor set layout");
         return false;
     }
     
@@ -43,19 +43,19 @@ bool RayTracingPipelineVk::CreateShader()
     m_RayGenShaderBlob = AssetsManager::LoadShaderImmediately("RayTracing.rgen.spv");
     if(!m_RayGenShaderBlob || m_RayGenShaderBlob->IsEmpty())
     {
-        Log::Error("Failed to load the ray generation shader");
+        LOG_ERROR("Failed to load the ray generation shader");
         return false;
     }
     m_MissShadersBlob = AssetsManager::LoadShaderImmediately("RayTracing.rmis.spv");
     if(!m_MissShadersBlob || m_MissShadersBlob->IsEmpty())
     {
-        Log::Error("Failed to load the miss shader");
+        LOG_ERROR("Failed to load the miss shader");
         return false;
     }
     m_HitGroupShadersBlob = AssetsManager::LoadShaderImmediately("RayTracing.rhit.spv");
     if(!m_HitGroupShadersBlob || m_HitGroupShadersBlob->IsEmpty())
     {
-        Log::Error("Failed to load the hit group shader");
+        LOG_ERROR("Failed to load the hit group shader");
         return false;
     }
 
@@ -67,7 +67,7 @@ bool RayTracingPipelineVk::CreateShader()
     VkResult result = vkCreateShaderModule(m_DeviceHandle, &createInfo, nullptr, &m_RayGenShaderModule);
     if(result != VK_SUCCESS)
     {
-        Log::Error("Failed to create ray gen shader");
+        LOG_ERROR("Failed to create ray gen shader");
         return false;
     }
 
@@ -77,7 +77,7 @@ bool RayTracingPipelineVk::CreateShader()
     result = vkCreateShaderModule(m_DeviceHandle, &createInfo, nullptr, &m_MissShaderModule);
     if(result != VK_SUCCESS)
     {
-        Log::Error("Failed to create miss shader");
+        LOG_ERROR("Failed to create miss shader");
         return false;
     }
 
@@ -87,7 +87,7 @@ bool RayTracingPipelineVk::CreateShader()
     result = vkCreateShaderModule(m_DeviceHandle, &createInfo, nullptr, &m_ClosestHitShaderModule);
     if(result != VK_SUCCESS)
     {
-        Log::Error("Failed to create hit group shader");
+        LOG_ERROR("Failed to create hit group shader");
         return false;
     }
     
@@ -122,7 +122,7 @@ bool RayTracingPipelineVk::CreatePipelineState()
     VkResult result = vkCreatePipelineLayout(m_DeviceHandle, &pipelineLayoutInfo, nullptr, &m_PipelineLayout);
     if(result != VK_SUCCESS)
     {
-        Log::Error("Failed to create pipeline layout");
+        LOG_ERROR("Failed to create pipeline layout");
         return false;
     }
     
@@ -202,10 +202,12 @@ bool RayTracingPipelineVk::CreatePipelineState()
     pipelineInfo.maxPipelineRayRecursionDepth = s_MaxRayRecursionDepth;
     pipelineInfo.layout = m_PipelineLayout;
     
-    result = vkCreateRayTracingPipelinesKHR(m_DeviceHandle, VK_NULL_HANDLE, VK_NULL_HANDLE, 1, &pipelineInfo, nullptr, &m_PipelineState);
-    if(result != VK_SUCCESS)
+    const bool succeeded = CreatePipelinesParallel({
+        [&]() { return vkCreateRayTracingPipelinesKHR(m_DeviceHandle, VK_NULL_HANDLE, m_PipelineCacheHandle, 1, &pipelineInfo, nullptr, &m_PipelineState) == VK_SUCCESS; }
+    });
+    if(!succeeded)
     {
-        Log::Error("Failed to create ray tracing pipeline");
+        LOG_ERROR("Failed to create ray tracing pipeline");
         return false;
     }
 	
@@ -252,7 +254,7 @@ bool RayTracingPipelineVk::CreateShaderTable()
     VkResult result = vkGetRayTracingShaderGroupHandlesKHR(m_DeviceHandle, m_PipelineState, 0, groupCount, shaderGroupHandlesSize, shaderHandleStorage.data());
     if(result != VK_SUCCESS)
     {
-        Log::Error("Failed to get ray tracing shader group handles");
+        LOG_ERROR("Failed to get ray tracing shader group handles");
         return false;
     }
 
@@ -262,7 +264,7 @@ bool RayTracingPipelineVk::CreateShaderTable()
         , m_ShaderTableBuffer
         , m_ShaderTableBufferMemory))
     {
-        Log::Error("Failed to create shader table buffer");
+        LOG_ERROR("Failed to create shader table buffer");
         return false;
     }
 
@@ -49,7 +49,7 @@ bool RayTracingPipelineVk::CreateScene()
     
     if(m_Mesh == nullptr || m_Mesh->GetMesh() == nullptr)
     {
-        Log::Error("Failed to load mesh");
+        LOG_ERROR("Failed to load mesh");
         return false;
     }
     
@@ -69,13 +69,13 @@ bool RayTracingPipelineVk::CreateResources()
         , m_OutputImage
         , m_OutputImageMemory))
     {
-        Log::Error("Failed to create output image");
+        LOG_ERROR("Failed to create output image");
         return false;
     }
 
     if(!CreateImageView(m_OutputImage, s_BackBufferFormat, VK_IMAGE_ASPECT_COLOR_BIT,m_OutputImageView))
     {
-        Log::Error("Failed to create output image view");
+        LOG_ERROR("Failed to create output image view");
         return false;
     }
     
@@ -85,7 +85,7 @@ bool RayTracingPipelineVk::CreateResources()
         , m_CameraDataBuffer
         , m_CameraBufferMemory))
     {
-        Log::Error("Failed to create camera data buffer");
+        LOG_ERROR("Failed to create camera data buffer");
         return false;
     }
 
@@ -95,7 +95,7 @@ bool RayTracingPipelineVk::CreateResources()
         , m_LightDataBuffer
         , m_LightDataMemory))
     {
-        Log::Error("Failed to create light data buffer");
+        LOG_ERROR("Failed to create light data buffer");
         return false;
     }
 
@@ -106,7 +106,7 @@ bool RayTracingPipelineVk::CreateResources()
         , m_InstanceBuffer
         , m_InstanceBufferMemory))
     {
-        Log::Error("Failed to create instance buffer");
+        LOG_ERROR("Failed to create instance buffer");
         return false;
     }
 
@@ -117,7 +117,7 @@ bool RayTracingPipelineVk::CreateResources()
         , m_MaterialsBuffer
         , m_MaterialsBufferMemory))
     {
-        Log::Error("Failed to create materials buffer");
+        LOG_ERROR("Failed to create materials buffer");
         return false;
     }
 
@@ -127,7 +127,7 @@ bool RayTracingPipelineVk::CreateResources()
         , m_VerticesBuffer
         , m_VerticesBufferMemory))
     {
-        Log::Error("Failed to create vertex buffer");
+        LOG_ERROR("Failed to create vertex buffer");
         return false;
     }
 
@@ -137,7 +137,7 @@ bool RayTracingPipelineVk::CreateResources()
         , m_IndicesBuffer
         , m_IndicesBufferMemory))
     {
-        Log::Error("Failed to create index buffer");
+        LOG_ERROR("Failed to create index buffer");
         return false;
     }
 
@@ -147,7 +147,7 @@ bool RayTracingPipelineVk::CreateResources()
         , m_TexcoordsBuffer
         , m_TexcoordsBufferMemory))
     {
-        Log::Error("Failed to create index buffer");
+        LOG_ERROR("Failed to create index buffer");
         return false;
     }
 
@@ -157,7 +157,7 @@ bool RayTracingPipelineVk::CreateResources()
         , m_NormalsBuffer
         , m_NormalsBufferMemory))
     {
-        Log::Error("Failed to create index buffer");
+        LOG_ERROR("Failed to create index buffer");
         return false;
     }
 
@@ -167,7 +167,7 @@ bool RayTracingPipelineVk::CreateResources()
         , m_AABBBuffer
         , m_AABBBufferMemory))
     {
-        Log::Error("Failed to create AABB buffer");
+        LOG_ERROR("Failed to create AABB buffer");
         return false;
     }
     
@@ -184,23 +184,12 @@ bool RayTracingPipelineVk::CreateResources()
     stagingBuffers[5] = UploadBuffer(m_NormalsBuffer, m_NormalData.data(), m_NormalData.size() * sizeof(glm::vec4));
     stagingBuffers[6] = UploadBuffer(m_AABBBuffer, m_AABB.data(), m_AABB.size() * sizeof(AABB));
 
-    VkImageMemoryBarrier imageBarrier  = ImageMemoryBarrier(m_OutputImage
-        , VK_IMAGE_LAYOUT_UNDEFINED
+    m_StateTracker.TrackImage(m_OutputImage, VK_IMAGE_ASPECT_COLOR_BIT, VK_IMAGE_LAYOUT_UNDEFINED);
+    m_StateTracker.TransitionImage(m_OutputImage
         , VK_IMAGE_LAYOUT_GENERAL
-        , VK_ACCESS_NONE
-        , VK_ACCESS_TRANSFER_WRITE_BIT
-        , VK_IMAGE_ASPECT_COLOR_BIT);
-
-    vkCmdPipelineBarrier(m_CmdBufferHandle
-        , VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT
-        , VK_PIPELINE_STAGE_TRANSFER_BIT
-        , 0
-        , 0
-        , nullptr
-        , 0
-        , nullptr
-        , 1
-        , &imageBarrier);
+        , VK_PIPELINE_STAGE_2_RAY_TRACING_SHADER_BIT_KHR
+        , VK_ACCESS_2_SHADER_WRITE_BIT
+        , true);
     
     EndCommandList();
 
@@ -362,7 +351,7 @@ bool RayTracingPipelineVk::CreateBottomLevelAccelStructure()
         , m_BLASBuffer
         , m_BLASBufferMemory))
     {
-        Log::Error("Failed to create BLAS buffer");
+        LOG_ERROR("Failed to create BLAS buffer");
         return false;
     }
     
@@ -374,7 +363,7 @@ bool RayTracingPipelineVk::CreateBottomLevelAccelStructure()
     VkResult result = vkCreateAccelerationStructureKHR(m_DeviceHandle, &accelerationStructureCreateInfo, nullptr, &m_BLAS);
     if(result != VK_SUCCESS)
     {
-        Log::Error("Failed to create BLAS");
+        LOG_ERROR("Failed to create BLAS");
         return false;
     }
 
@@ -387,7 +376,7 @@ bool RayTracingPipelineVk::CreateBottomLevelAccelStructure()
         , scratchBuffer
         , scratchBufferMemory))
     {
-        Log::Error("Failed to create BLAS scratch buffer");
+        LOG_ERROR("Failed to create BLAS scratch buffer");
         return false;
     }
 
@@ -417,7 +406,7 @@ bool RayTracingPipelineVk::CreateBottomLevelAccelStructure()
         , m_ProceduralGeoBLASBuffer
         , m_ProceduralGeoBLASBufferMemory))
     {
-        Log::Error("Failed to create procedural geometry BLAS buffer");
+        LOG_ERROR("Failed to create procedural geometry BLAS buffer");
         return false;
     }
     
@@ -429,7 +418,7 @@ bool RayTracingPipelineVk::CreateBottomLevelAccelStructure()
     result = vkCreateAccelerationStructureKHR(m_DeviceHandle, &accelerationStructureCreateInfo, nullptr, &m_ProceduralGeoBLAS);
     if(result != VK_SUCCESS)
     {
-        Log::Error("Failed to create procedural geometry BLAS");
+        LOG_ERROR("Failed to create procedural geometry BLAS");
         return false;
     }
 
@@ -442,7 +431,7 @@ bool RayTracingPipelineVk::CreateBottomLevelAccelStructure()
         , proceduralGeoScratchBuffer
         , proceduralGeoScratchBufferMemory))
     {
-        Log::Error("Failed to create procedural geometry BLAS scratch buffer");
+        LOG_ERROR("Failed to create procedural geometry BLAS scratch buffer");
         return false;
     }
     
@@ -517,7 +506,7 @@ bool RayTracingPipelineVk::CreateTopLevelAccelStructure()
         , instanceBuffer
         , instanceBufferMemory))
     {
-        Log::Error("Failed to create instance buffer");
+        LOG_ERROR("Failed to create instance buffer");
         return false;
     }
 
@@ -554,7 +543,7 @@ bool RayTracingPipelineVk::CreateTopLevelAccelStructure()
         , m_TLASBuffer
         , m_TLASBufferMemory))
     {
-        Log::Error("Failed to create TLAS buffer");
+        LOG_ERROR("Failed to create TLAS buffer");
         return false;
     }
     
@@ -566,7 +555,7 @@ bool RayTracingPipelineVk::CreateTopLevelAccelStructure()
     VkResult result = vkCreateAccelerationStructureKHR(m_DeviceHandle, &accelerationStructureCreateInfo, nullptr, &m_TLAS);
     if(result != VK_SUCCESS)
     {
-        Log::Error("Failed to create TLAS");
+        LOG_ERROR("Failed to create TLAS");
         return false;
     }
 
@@ -579,7 +568,7 @@ bool RayTracingPipelineVk::CreateTopLevelAccelStructure()
         , scratchBuffer
         , scratchBufferMemory))
     {
-        Log::Error("Failed to create TLAS scratch buffer");
+        LOG_ERROR("Failed to create TLAS scratch buffer");
         return false;
     }
 
@@ -635,7 +624,7 @@ bool RayTracingPipelineVk::CreateDescriptorSet()
     descriptorSetAllocInfo.descriptorSetCount = 1;
     if(vkAllocateDescriptorSets(m_DeviceHandle, &descriptorSetAllocInfo, &m_DescriptorSet) != VK_SUCCESS)
     {
-        Log::Error("Failed to allocate descriptor set");
+        LOG_ERROR("Failed to allocate descriptor set");
         return false;
     }
     
@@ -25,15 +25,16 @@ void RayTracingPipelineVk::Tick()
     UpdateConstants();
 
     // Ray tracing
+    m_StateTracker.TransitionImage(m_OutputImage, VK_IMAGE_LAYOUT_GENERAL, VK_PIPELINE_STAGE_2_RAY_TRACING_SHADER_BIT_KHR, VK_ACCESS_2_SHADER_WRITE_BIT);
+    m_StateTracker.Flush(m_CmdBufferHandle);
     vkCmdBindPipeline(m_CmdBufferHandle, VK_PIPELINE_BIND_POINT_RAY_TRACING_KHR, m_PipelineState);
     vkCmdBindDescriptorSets(m_CmdBufferHandle, VK_PIPELINE_BIND_POINT_RAY_TRACING_KHR, m_PipelineLayout, 0, 1, &m_DescriptorSet, 0, nullptr);
     vkCmdTraceRaysKHR(m_CmdBufferHandle, &m_RaygenShaderSbtEntry, &m_MissShaderSbtEntry, &m_HitShaderSbtEntry, &m_CallableShaderSbtEntry, m_Capabilities.currentExtent.width, m_Capabilities.currentExtent.height, 1);
     
     // Copy the output image to the back buffer
-    std::array<VkImageMemoryBarrier, 2> preCopyBarriers;
-    preCopyBarriers[0] = ImageMemoryBarrier(m_OutputImage, VK_IMAGE_LAYOUT_GENERAL, VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL, VK_ACCESS_SHADER_WRITE_BIT, VK_ACCESS_TRANSFER_READ_BIT, VK_IMAGE_ASPECT_COLOR_BIT);
-    preCopyBarriers[1] = ImageMemoryBarrier(m_BackBuffers[m_CurrentIndex], VK_IMAGE_LAYOUT_UNDEFINED, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, VK_ACCESS_NONE, VK_ACCESS_TRANSFER_WRITE_BIT, VK_IMAGE_ASPECT_COLOR_BIT);
-    vkCmdPipelineBarrier(m_CmdBufferHandle, VK_PIPELINE_STAGE_ALL_COMMANDS_BIT, VK_PIPELINE_STAGE_TRANSFER_BIT, 0, 0, nullptr, 0, nullptr, static_cast<uint32_t>(preCopyBarriers.size()), preCopyBarriers.data());
+    m_StateTracker.TransitionImage(m_OutputImage, VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL, VK_PIPELINE_STAGE_2_TRANSFER_BIT, VK_ACCESS_2_TRANSFER_READ_BIT);
+    m_StateTracker.TransitionImage(m_BackBuffers[m_CurrentIndex], VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, VK_PIPELINE_STAGE_2_TRANSFER_BIT, VK_ACCESS_2_TRANSFER_WRITE_BIT, true);
+    m_StateTracker.Flush(m_CmdBufferHandle);
     
     VkImageCopy copyRegion{};
     copyRegion.srcSubresource = { VK_IMAGE_ASPECT_COLOR_BIT, 0, 0, 1 };
@@ -43,10 +44,8 @@ void RayTracingPipelineVk::Tick()
     copyRegion.extent = { m_Capabilities.currentExtent.width, m_Capabilities.currentExtent.height, 1 };
     vkCmdCopyImage(m_CmdBufferHandle, m_OutputImage, VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL, m_BackBuffers[m_CurrentIndex], VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, 1, &copyRegion);
     
-    std::array<VkImageMemoryBarrier, 2> postCopyBarriers;
-    postCopyBarriers[0] = ImageMemoryBarrier(m_OutputImage, VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL, VK_IMAGE_LAYOUT_GENERAL, VK_ACCESS_TRANSFER_READ_BIT, VK_ACCESS_SHADER_WRITE_BIT, VK_IMAGE_ASPECT_COLOR_BIT);
-    postCopyBarriers[1] = ImageMemoryBarrier(m_BackBuffers[m_CurrentIndex], VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, VK_IMAGE_LAYOUT_PRESENT_SRC_KHR, VK_ACCESS_TRANSFER_WRITE_BIT, VK_ACCESS_NONE, VK_IMAGE_ASPECT_COLOR_BIT);
-    vkCmdPipelineBarrier(m_CmdBufferHandle, VK_PIPELINE_STAGE_TRANSFER_BIT, VK_PIPELINE_STAGE_ALL_COMMANDS_BIT, 0, 0, nullptr, 0, nullptr, static_cast<uint32_t>(postCopyBarriers.size()), postCopyBarriers.data());
+    // Flushed by EndCommandList, the output image goes back to GENERAL when the next frame declares its use
+    m_StateTracker.TransitionImage(m_BackBuffers[m_CurrentIndex], VK_IMAGE_LAYOUT_PRESENT_SRC_KHR, VK_PIPELINE_STAGE_2_NONE, VK_ACCESS_2_NONE);
     
     EndCommandList();
     ExecuteCommandBuffer(m_ImageAvailableSemaphore);
@@ -0,0 +1,302 @@
+#include "Benchmark.h"
+#include "Log.h"
+#include "RenderGraph.h"
+#include <algorithm>
+#include <chrono>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+
+// Compiles a few render graphs without a device and checks what Compile() decides: the schedule keeps every read
+// after write, write after write and write after read of the declared order, passes nobody consumes are culled, and
+// transients alive at the same time never share memory. Reports the aliasing savings and times Compile().
+//
+//   RenderGraphBench [--iterations N] [--report path.json|path.csv] [--baseline path.json] [--tolerance percent]
+
+static constexpr uint32_t s_Width = 1920, s_Height = 1080;
+static constexpr uint64_t s_PlacementAlignment = 64 * 1024;
+
+static double MillisecondsSince(std::chrono::steady_clock::time_point inStart)
+{
+    return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - inStart).count();
+}
+
+// Format holds the bytes per texel here, the backends store a VkFormat or DXGI_FORMAT in it
+static RenderGraphResourceDesc TextureDesc(uint32_t inWidth, uint32_t inHeight, uint32_t inBytesPerTexel)
+{
+    RenderGraphResourceDesc desc;
+    desc.Type = ERenderGraphResourceType::Texture;
+    desc.Width = inWidth;
+    desc.Height = inHeight;
+    desc.Format = inBytesPerTexel;
+    return desc;
+}
+
+static bool QueryMemory(RenderGraphHandle, const RenderGraphResourceDesc& inDesc, uint64_t& outSize, uint64_t& outAlignment)
+{
+    outSize = inDesc.Type == ERenderGraphResourceType::Buffer
+        ? inDesc.Width
+        : static_cast<uint64_t>(inDesc.Width) * inDesc.Height * inDesc.Format;
+    outAlignment = s_PlacementAlignment;
+    return outSize > 0;
+}
+
+// Every pair of alive passes touching the same resource with at least one write keeps its declared order
+static bool CheckSchedule(const RenderGraph& inGraph, const char* inName)
+{
+    const std::vector<uint32_t>& schedule = inGraph.GetSchedule();
+    for(uint32_t first = 0; first < schedule.size(); ++first)
+    {
+        for(uint32_t second = first + 1; second < schedule.size(); ++second)
+        {
+            const uint32_t early = schedule[first], late = schedule[second];
+            if(early < late)
+                continue;
+            for(const RenderGraph::PassNode::Access& lateAccess : inGraph.GetPass(late).Accesses)
+            {
+                for(const RenderGraph::PassNode::Access& earlyAccess : inGraph.GetPass(early).Accesses)
+                {
+                    if(lateAccess.Resource == earlyAccess.Resource && (lateAccess.Write || earlyAccess.Write))
+                    {
+                        LOG_ERROR("[RenderGraph] %s: %s is scheduled before %s it depends on", inName
+                            , inGraph.GetPass(early).Name.c_str(), inGraph.GetPass(late).Name.c_str());
+                        return false;
+                    }
+                }
+            }
+        }
+    }
+    return true;
+}
+
+// Transients alive in the same pass never overlap in the aliased allocation, and every one of them fits in it
+static bool CheckAliasing(const RenderGraph& inGraph, const char* inName)
+{
+    for(RenderGraphHandle left = 0; left < inGraph.GetResourceCount(); ++left)
+    {
+        const RenderGraph::ResourceNode& leftResource = inGraph.GetResource(left);
+        if(leftResource.Imported || !inGraph.IsResourceUsed(left))
+            continue;
+        if(leftResource.Offset % s_PlacementAlignment != 0 || leftResource.Offset + leftResource.Size > inGraph.GetAliasedAllocationSize())
+        {
+            LOG_ERROR("[RenderGraph] %s: %s is misplaced in the aliased allocation", inName, leftResource.Name.c_str());
+            return false;
+        }
+        for(RenderGraphHandle right = left + 1; right < inGraph.GetResourceCount(); ++right)
+        {
+            const RenderGraph::ResourceNode& rightResource = inGraph.GetResource(right);
+            if(rightResource.Imported || !inGraph.IsResourceUsed(right))
+                continue;
+            const bool lifetimesOverlap = leftResource.FirstUse <= rightResource.LastUse && rightResource.FirstUse <= leftResource.LastUse;
+            const bool memoryOverlaps = leftResource.Offset < rightResource.Offset + rightResource.Size && rightResource.Offset < leftResource.Offset + leftResource.Size;
+            if(lifetimesOverlap && memoryOverlaps)
+            {
+                LOG_ERROR("[RenderGraph] %s: %s and %s are alive at the same time in the same memory", inName
+                    , leftResource.Name.c_str(), rightResource.Name.c_str());
+                return false;
+            }
+            const RenderGraph::ResourceNode& later = leftResource.FirstUse > rightResource.FirstUse ? leftResource : rightResource;
+            const RenderGraphHandle earlier = &later == &leftResource ? right : left;
+            const bool isPredecessor = std::find(later.AliasPredecessors.begin(), later.AliasPredecessors.end(), earlier) != later.AliasPredecessors.end();
+            if(memoryOverlaps && !lifetimesOverlap && !isPredecessor)
+            {
+                LOG_ERROR("[RenderGraph] %s: %s reuses the memory of %s without waiting for it", inName
+                    , later.Name.c_str(), inGraph.GetResource(earlier).Name.c_str());
+                return false;
+            }
+        }
+    }
+    return true;
+}
+
+static bool CheckCulled(const RenderGraph& inGraph, const char* inName, const std::vector<uint32_t>& inExpectedCulled)
+{
+    const std::vector<uint32_t>& schedule = inGraph.GetSchedule();
+    for(uint32_t pass : inExpectedCulled)
+    {
+        if(std::find(schedule.begin(), schedule.end(), pass) != schedule.end())
+        {
+            LOG_ERROR("[RenderGraph] %s: %s is scheduled but nothing consumes it", inName, inGraph.GetPass(pass).Name.c_str());
+            return false;
+        }
+    }
+    if(inGraph.GetMemoryReport().CulledPasses != inExpectedCulled.size())
+    {
+        LOG_ERROR("[RenderGraph] %s: %u passes culled, expected %zu", inName, inGraph.GetMemoryReport().CulledPasses, inExpectedCulled.size());
+        return false;
+    }
+    return true;
+}
+
+// Deferred frame: the G-buffer dies after lighting so the bloom chain can take its memory, the debug view is never
+// presented and is culled with the pass that only feeds it
+static void BuildDeferredFrame(RenderGraph& outGraph, std::vector<uint32_t>& outCulled)
+{
+    outGraph.Reset();
+    const RenderGraphHandle backBuffer = outGraph.ImportResource("BackBuffer", TextureDesc(s_Width, s_Height, 4), false);
+    outGraph.SetFinalAccess(backBuffer, ERenderGraphAccess::Present);
+    const RenderGraphHandle depth = outGraph.CreateResource("Depth", TextureDesc(s_Width, s_Height, 4));
+    const RenderGraphHandle albedo = outGraph.CreateResource("GBufferAlbedo", TextureDesc(s_Width, s_Height, 4));
+    const RenderGraphHandle normals = outGraph.CreateResource("GBufferNormals", TextureDesc(s_Width, s_Height, 8));
+    const RenderGraphHandle lighting = outGraph.CreateResource("Lighting", TextureDesc(s_Width, s_Height, 8));
+    const RenderGraphHandle bloomDown = outGraph.CreateResource("BloomDown", TextureDesc(s_Width / 2, s_Height / 2, 8));
+    const RenderGraphHandle bloomBlur = outGraph.CreateResource("BloomBlur", TextureDesc(s_Width / 2, s_Height / 2, 8));
+    const RenderGraphHandle overdraw = outGraph.CreateResource("Overdraw", TextureDesc(s_Width, s_Height, 4));
+    const RenderGraphHandle debugView = outGraph.CreateResource("DebugView", TextureDesc(s_Width, s_Height, 4));
+
+    uint32_t pass = outGraph.AddPass("DepthPrepass", ERenderGraphPassType::Graphics, nullptr);
+    outGraph.Write(pass, depth, ERenderGraphAccess::DepthWrite);
+    pass = outGraph.AddPass("GBuffer", ERenderGraphPassType::Graphics, nullptr);
+    outGraph.Read(pass, depth, ERenderGraphAccess::DepthRead);
+    outGraph.Write(pass, albedo, ERenderGraphAccess::RenderTarget);
+    outGraph.Write(pass, normals, ERenderGraphAccess::RenderTarget);
+    pass = outGraph.AddPass("Overdraw", ERenderGraphPassType::Graphics, nullptr);
+    outGraph.Read(pass, depth, ERenderGraphAccess::DepthRead);
+    outGraph.Write(pass, overdraw, ERenderGraphAccess::RenderTarget);
+    outCulled.push_back(pass);
+    pass = outGraph.AddPass("DebugView", ERenderGraphPassType::Compute, nullptr);
+    outGraph.Read(pass, overdraw, ERenderGraphAccess::ShaderRead);
+    outGraph.Write(pass, debugView, ERenderGraphAccess::UnorderedAccess);
+    outCulled.push_back(pass);
+    pass = outGraph.AddPass("Lighting", ERenderGraphPassType::Compute, nullptr);
+    outGraph.Read(pass, depth, ERenderGraphAccess::ShaderRead);
+    outGraph.Read(pass, albedo, ERenderGraphAccess::ShaderRead);
+    outGraph.Read(pass, normals, ERenderGraphAccess::ShaderRead);
+    outGraph.Write(pass, lighting, ERenderGraphAccess::UnorderedAccess);
+    pass = outGraph.AddPass("BloomDownsample", ERenderGraphPassType::Compute, nullptr);
+    outGraph.Read(pass, lighting, ERenderGraphAccess::ShaderRead);
+    outGraph.Write(pass, bloomDown, ERenderGraphAccess::UnorderedAccess);
+    pass = outGraph.AddPass("BloomBlur", ERenderGraphPassType::Compute, nullptr);
+    outGraph.Read(pass, bloomDown, ERenderGraphAccess::ShaderRead);
+    outGraph.Write(pass, bloomBlur, ERenderGraphAccess::UnorderedAccess);
+    pass = outGraph.AddPass("Tonemap", ERenderGraphPassType::Graphics, nullptr);
+    outGraph.Read(pass, lighting, ERenderGraphAccess::ShaderRead);
+    outGraph.Read(pass, bloomBlur, ERenderGraphAccess::ShaderRead);
+    outGraph.Write(pass, backBuffer, ERenderGraphAccess::RenderTarget);
+}
+
+// Ping pong over two transients: the second blur writes what the first one read, so it has to wait for that read
+// (write after read) and for the first write of the same texture (write after write). The luminance pass only feeds a
+// transient nobody reads and is culled even though it reads a live resource
+static void BuildPingPong(RenderGraph& outGraph, std::vector<uint32_t>& outCulled)
+{
+    outGraph.Reset();
+    const RenderGraphHandle output = outGraph.ImportResource("Output", TextureDesc(s_Width, s_Height, 4));
+    const RenderGraphHandle ping = outGraph.CreateResource("Ping", TextureDesc(s_Width, s_Height, 8));
+    const RenderGraphHandle pong = outGraph.CreateResource("Pong", TextureDesc(s_Width, s_Height, 8));
+    const RenderGraphHandle history = outGraph.CreateResource("History", TextureDesc(s_Width, s_Height, 8));
+    const RenderGraphHandle luminance = outGraph.CreateResource("Luminance", TextureDesc(s_Width / 4, s_Height / 4, 4));
+
+    uint32_t pass = outGraph.AddPass("Source", ERenderGraphPassType::Compute, nullptr);
+    outGraph.Write(pass, ping, ERenderGraphAccess::UnorderedAccess);
+    pass = outGraph.AddPass("BlurH", ERenderGraphPassType::Compute, nullptr);
+    outGraph.Read(pass, ping, ERenderGraphAccess::ShaderRead);
+    outGraph.Write(pass, pong, ERenderGraphAccess::UnorderedAccess);
+    pass = outGraph.AddPass("BlurV", ERenderGraphPassType::Compute, nullptr);
+    outGraph.Read(pass, pong, ERenderGraphAccess::ShaderRead);
+    outGraph.Write(pass, ping, ERenderGraphAccess::UnorderedAccess);
+    pass = outGraph.AddPass("Luminance", ERenderGraphPassType::Compute, nullptr);
+    outGraph.Read(pass, ping, ERenderGraphAccess::ShaderRead);
+    outGraph.Write(pass, luminance, ERenderGraphAccess::UnorderedAccess);
+    outCulled.push_back(pass);
+    // HistoryUpdate writes History again, write after write keeps the clear in front of it
+    pass = outGraph.AddPass("HistoryClear", ERenderGraphPassType::Copy, nullptr);
+    outGraph.Write(pass, history, ERenderGraphAccess::CopyDst);
+    pass = outGraph.AddPass("HistoryUpdate", ERenderGraphPassType::Compute, nullptr);
+    outGraph.Read(pass, ping, ERenderGraphAccess::ShaderRead);
+    outGraph.Write(pass, history, ERenderGraphAccess::UnorderedAccess);
+    pass = outGraph.AddPass("Resolve", ERenderGraphPassType::Compute, nullptr);
+    outGraph.Read(pass, history, ERenderGraphAccess::ShaderRead);
+    outGraph.Write(pass, output, ERenderGraphAccess::UnorderedAccess);
+    // Only feeds a readback, kept alive by its side effects
+    pass = outGraph.AddPass("Statistics", ERenderGraphPassType::Compute, nullptr);
+    outGraph.Read(pass, pong, ERenderGraphAccess::ShaderRead);
+    outGraph.SetSideEffects(pass);
+}
+
+static bool RunChecks(RenderGraph& ioGraph, const char* inName, const std::vector<uint32_t>& inExpectedCulled)
+{
+    if(!ioGraph.Compile(QueryMemory))
+    {
+        LOG_ERROR("[RenderGraph] %s: Compile failed", inName);
+        return false;
+    }
+    if(!CheckSchedule(ioGraph, inName) || !CheckCulled(ioGraph, inName, inExpectedCulled) || !CheckAliasing(ioGraph, inName))
+        return false;
+
+    const RenderGraphMemoryReport& report = ioGraph.GetMemoryReport();
+    Log::Info("[RenderGraph] %s: %u of %u passes scheduled, %u transients aliased from %llu KB into %llu KB, %.1f%% saved"
+        , inName
+        , static_cast<uint32_t>(ioGraph.GetSchedule().size())
+        , report.DeclaredPasses
+        , report.TransientResources
+        , static_cast<unsigned long long>(report.TransientBytes / 1024)
+        , static_cast<unsigned long long>(report.AliasedBytes / 1024)
+        , report.GetSavedPercent());
+    return true;
+}
+
+int main(int argc, char** argv)
+{
+    uint32_t iterations = 1000;
+    std::string reportPath;
+    std::string baselinePath;
+    double tolerancePercent = 10.0;
+    for(int i = 1; i < argc; ++i)
+    {
+        const bool hasValue = i + 1 < argc;
+        if(strcmp(argv[i], "--iterations") == 0 && hasValue)
+            iterations = std::max(1, atoi(argv[++i]));
+        else if(strcmp(argv[i], "--report") == 0 && hasValue)
+            reportPath = argv[++i];
+        else if(strcmp(argv[i], "--baseline") == 0 && hasValue)
+            baselinePath = argv[++i];
+        else if(strcmp(argv[i], "--tolerance") == 0 && hasValue)
+            tolerancePercent = atof(argv[++i]);
+        else
+            LOG_WARNING("Unknown argument %s", argv[i]);
+    }
+
+    RenderGraph graph;
+    std::vector<uint32_t> culled;
+    BuildDeferredFrame(graph, culled);
+    if(!RunChecks(graph, "Deferred", culled))
+    {
+        Log::Flush();
+        return 1;
+    }
+    // The G-buffer is dead once lighting ran, the bloom chain must have been placed in its memory
+    if(graph.GetMemoryReport().AliasedBytes >= graph.GetMemoryReport().TransientBytes)
+    {
+        LOG_ERROR("[RenderGraph] Deferred: nothing was aliased");
+        Log::Flush();
+        return 1;
+    }
+
+    culled.clear();
+    BuildPingPong(graph, culled);
+    if(!RunChecks(graph, "PingPong", culled))
+    {
+        Log::Flush();
+        return 1;
+    }
+
+    Benchmark benchmark;
+    for(uint32_t i = 0; i < iterations; ++i)
+    {
+        culled.clear();
+        const auto start = std::chrono::steady_clock::now();
+        BuildDeferredFrame(graph, culled);
+        graph.Compile(QueryMemory);
+        benchmark.AddSample("Deferred build and compile", MillisecondsSince(start));
+    }
+
+    benchmark.LogReport();
+    if(!reportPath.empty())
+        benchmark.WriteReport(reportPath, "RenderGraphBench", 0);
+    int exitCode = 0;
+    if(!baselinePath.empty() && !benchmark.CompareWithBaseline(baselinePath, tolerancePercent))
+        exitCode = 1;
+    Log::Flush();
+    return exitCode;
+}
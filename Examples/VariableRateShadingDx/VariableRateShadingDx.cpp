@@ -4,18 +4,21 @@ static void LogAdapterDesc(const DXGI_ADAPTER_DESC1& inDesc)
 {
     std::wstring adapterDesc(inDesc.Description);
     std::string name(adapterDesc.begin(), adapterDesc.end());
-    Log::Info("----------------------------------------------------------------", name.c_str());
-    Log::Info("[D3D12] Adapter Description: %s", name.c_str());
-    Log::Info("[D3D12] Adapter Dedicated Video Memory: %d MB", inDesc.DedicatedVideoMemory >> 20);
-    Log::Info("[D3D12] Adapter Dedicated System Memory: %d MB", inDesc.DedicatedSystemMemory >> 20);
-    Log::Info("[D3D12] Adapter Shared System Memory: %d MB", inDesc.SharedSystemMemory >> 20);
-    Log::Info("----------------------------------------------------------------", name.c_str());
+    LOG_INFO("----------------------------------------------------------------", name.c_str());
+    LOG_INFO("[D3D12] Adapter Description: %s", name.c_str());
+    LOG_INFO("[D3D12] Adapter Dedicated Video Memory: %d MB", inDesc.DedicatedVideoMemory >> 20);
+    LOG_INFO("[D3D12] Adapter Dedicated System Memory: %d MB", inDesc.DedicatedSystemMemory >> 20);
+    LOG_INFO("[D3D12] Adapter Shared System Memory: %d MB", inDesc.SharedSystemMemory >> 20);
+    LOG_INFO("----------------------------------------------------------------", name.c_str());
 }
 
 bool VariableRateShadingDx::Init()
 {
     if(!CreateDevice())
         return false;
+
+    if(!CreatePipelineLibrary("VariableRateShadingDx"))
+        return false;
     
     if(!CreateCommandQueue())
         return false;
@@ -56,6 +59,7 @@ bool VariableRateShadingDx::Init()
 void VariableRateShadingDx::Shutdown()
 {
     FlushCommandQueue();
+    DestroyPipelineLibrary();
 }
 
 bool VariableRateShadingDx::CreateDevice()
@@ -68,7 +72,7 @@ bool VariableRateShadingDx::CreateDevice()
     if (SUCCEEDED(D3D12GetDebugInterface(IID_PPV_ARGS(&debugController))))
         debugController->EnableDebugLayer();
     else
-        Log::Warning("Failed to enable the D3D12 debug layer");
+        LOG_WARNING("Failed to enable the D3D12 debug layer");
 #endif
     
     const uint32_t factoryFlags = allowDebugging ? DXGI_CREATE_FACTORY_DEBUG : 0;
@@ -96,7 +100,7 @@ bool VariableRateShadingDx::CreateDevice()
                 m_DeviceHandle = TempDevice;
                 std::wstring adapterDesc(Desc.Description);
                 std::string name(adapterDesc.begin(), adapterDesc.end());
-                Log::Info("[D3D12] Using adapter: %s", name.c_str());
+                LOG_INFO("[D3D12] Using adapter: %s", name.c_str());
                 break;
             }
         }
@@ -104,7 +108,7 @@ bool VariableRateShadingDx::CreateDevice()
 
     if(m_DeviceHandle.Get() == nullptr)
     {
-        Log::Error("Failed to find a device supporting Mesh Shaders");
+        LOG_ERROR("Failed to find a device supporting Mesh Shaders");
         return false;
     }
     
@@ -122,7 +126,7 @@ bool VariableRateShadingDx::CreateCommandQueue()
     if(FAILED(hr))
     {
         OUTPUT_D3D12_FAILED_RESULT(hr)
-        Log::Error("[D3D12] Failed to create the command queue");
+        LOG_ERROR("[D3D12] Failed to create the command queue");
         return false;
     }
     
@@ -130,7 +134,7 @@ bool VariableRateShadingDx::CreateCommandQueue()
     if(FAILED(hr))
     {
         OUTPUT_D3D12_FAILED_RESULT(hr)
-        Log::Error("[D3D12] Failed to create the fence");
+        LOG_ERROR("[D3D12] Failed to create the fence");
         return false;
     }
     return true;
@@ -142,7 +146,7 @@ bool VariableRateShadingDx::CreateCommandList()
     if(FAILED(hr))
     {
         OUTPUT_D3D12_FAILED_RESULT(hr)
-        Log::Error("[D3D12] Failed to create the command allocator");
+        LOG_ERROR("[D3D12] Failed to create the command allocator");
         return false;
     }
 
@@ -150,7 +154,7 @@ bool VariableRateShadingDx::CreateCommandList()
     if(FAILED(hr))
     {
         OUTPUT_D3D12_FAILED_RESULT(hr)
-        Log::Error("[D3D12] Failed to create the command list");
+        LOG_ERROR("[D3D12] Failed to create the command list");
         return false;
     }
     m_CommandListIsClosed = false;
@@ -189,7 +193,7 @@ bool VariableRateShadingDx::CreateDescriptorHeaps()
     if(FAILED(hr))
     {
         OUTPUT_D3D12_FAILED_RESULT(hr)
-        Log::Error("[D3D12] Failed to create the RTV descriptor heap");
+        LOG_ERROR("[D3D12] Failed to create the RTV descriptor heap");
         return false;
     }
 
@@ -202,7 +206,7 @@ bool VariableRateShadingDx::CreateDescriptorHeaps()
     if(FAILED(hr))
     {
         OUTPUT_D3D12_FAILED_RESULT(hr)
-        Log::Error("[D3D12] Failed to create the DSV descriptor heap");
+        LOG_ERROR("[D3D12] Failed to create the DSV descriptor heap");
         return false;
     }
 
@@ -215,7 +219,7 @@ bool VariableRateShadingDx::CreateDescriptorHeaps()
     if(FAILED(hr))
     {
         OUTPUT_D3D12_FAILED_RESULT(hr)
-        Log::Error("[D3D12] Failed to create the CBV, SRV, UAV descriptor heap");
+        LOG_ERROR("[D3D12] Failed to create the CBV, SRV, UAV descriptor heap");
         return false;
     }
 
@@ -228,7 +232,7 @@ bool VariableRateShadingDx::CreateDescriptorHeaps()
     if(FAILED(hr))
     {
         OUTPUT_D3D12_FAILED_RESULT(hr)
-        Log::Error("[D3D12] Failed to create the sampler descriptor heap");
+        LOG_ERROR("[D3D12] Failed to create the sampler descriptor heap");
         return false;
     }
 
@@ -260,7 +264,7 @@ bool VariableRateShadingDx::CreateSwapChain()
     if(FAILED(hr))
     {
         OUTPUT_D3D12_FAILED_RESULT(hr)
-        Log::Error("[D3D12] Failed to create the swap chain");
+        LOG_ERROR("[D3D12] Failed to create the swap chain");
         return false;
     }
 
@@ -282,7 +286,7 @@ bool VariableRateShadingDx::CreateSwapChain()
         if(FAILED(hr))
         {
             OUTPUT_D3D12_FAILED_RESULT(hr)
-            Log::Error("[D3D12] Failed to get the swap chain buffer");
+            LOG_ERROR("[D3D12] Failed to get the swap chain buffer");
             return false;
         }
         m_BackBuffers[i] = backBuffer;
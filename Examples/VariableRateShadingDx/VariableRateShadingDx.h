@@ -17,7 +17,7 @@
 #define OUTPUT_D3D12_FAILED_RESULT(Re)  if(FAILED(Re))\
 	{\
 		std::string message = std::system_category().message(Re);\
-		Log::Error("[D3D12] Error: %s, In File: %s line %d", message.c_str(), __FILE__, __LINE__);\
+		LOG_ERROR("[D3D12] Error: %s, In File: %s line %d", message.c_str(), __FILE__, __LINE__);\
 	}
 
 void WriteBufferData(ID3D12Resource* inBuffer, const void* inData, size_t inSize);
@@ -54,6 +54,7 @@ public:
 	bool Init() override;
 	void Tick() override;
 	void Shutdown() override;
+	CameraBase* GetBenchmarkCamera() override { return &m_Camera; }
 
 	void BeginCommandList();
 	void EndCommandList();
@@ -22,7 +22,7 @@ bool VariableRateShadingDx::CreateRootSignature()
     if(FAILED(hr))
     {
         OUTPUT_D3D12_FAILED_RESULT(hr)
-        Log::Error("[D3D12] Failed to serialize the root signature: %s", static_cast<const char*>(errorBlob->GetBufferPointer()));
+        LOG_ERROR("[D3D12] Failed to serialize the root signature: %s", static_cast<const char*>(errorBlob->GetBufferPointer()));
         return false;
     }
 
@@ -34,7 +34,7 @@ bool VariableRateShadingDx::CreateRootSignature()
     if(FAILED(hr))
     {
         OUTPUT_D3D12_FAILED_RESULT(hr)
-        Log::Error("[D3D12] Failed to create the root signature");
+        LOG_ERROR("[D3D12] Failed to create the root signature");
         return false;
     }
     
@@ -46,13 +46,13 @@ bool VariableRateShadingDx::CreateShader()
     m_VertexShaderBlob = AssetsManager::LoadShaderImmediately("Graphics.vs.bin");
     if(!m_VertexShaderBlob || m_VertexShaderBlob->IsEmpty())
     {
-        Log::Error("Failed to load vertex shader");
+        LOG_ERROR("Failed to load vertex shader");
         return false;
     }
     m_PixelShaderBlob = AssetsManager::LoadShaderImmediately("Graphics.ps.bin");
     if(!m_PixelShaderBlob || m_PixelShaderBlob->IsEmpty())
     {
-        Log::Error("Failed to load pixel shader");
+        LOG_ERROR("Failed to load pixel shader");
         return false;
     }
     
@@ -82,11 +82,14 @@ bool VariableRateShadingDx::CreatePipelineState()
     pipelineDesc.PrimitiveTopologyType = D3D12_PRIMITIVE_TOPOLOGY_TYPE_TRIANGLE;
     pipelineDesc.NodeMask              = GetNodeMask();
 
-    const HRESULT hr = m_DeviceHandle->CreateGraphicsPipelineState(&pipelineDesc, IID_PPV_ARGS(&m_PipelineState));
-    if(FAILED(hr))
+    const bool succeeded = CreatePipelinesParallel({ [&]()
     {
-        OUTPUT_D3D12_FAILED_RESULT(hr)
-        Log::Error("[D3D12] Failed to create the pipeline state");
+        m_PipelineState = LoadGraphicsPipeline(L"VariableRateShadingDx", pipelineDesc);
+        return m_PipelineState != nullptr;
+    } });
+    if(!succeeded)
+    {
+        LOG_ERROR("[D3D12] Failed to create the pipeline state");
         return false;
     }
     
@@ -103,7 +106,7 @@ bool VariableRateShadingDx::CreateQueryHeaps()
     if(FAILED(hr))
     {
         OUTPUT_D3D12_FAILED_RESULT(hr)
-        Log::Error("[D3D12] Failed to create the timestamp query heap");
+        LOG_ERROR("[D3D12] Failed to create the timestamp query heap");
         return false;
     }
 
@@ -113,7 +116,7 @@ bool VariableRateShadingDx::CreateQueryHeaps()
     if(FAILED(hr))
     {
         OUTPUT_D3D12_FAILED_RESULT(hr)
-        Log::Error("[D3D12] Failed to create the occlusion query heap");
+        LOG_ERROR("[D3D12] Failed to create the occlusion query heap");
         return false;
     }
 
@@ -123,7 +126,7 @@ bool VariableRateShadingDx::CreateQueryHeaps()
     if(FAILED(hr))
     {
         OUTPUT_D3D12_FAILED_RESULT(hr)
-        Log::Error("[D3D12] Failed to create the pipeline statistics query heap");
+        LOG_ERROR("[D3D12] Failed to create the pipeline statistics query heap");
         return false;
     }
     
@@ -31,7 +31,7 @@ Microsoft::WRL::ComPtr<ID3D12Resource> CreateBufferHelper(ID3D12Device* inDevice
     if(FAILED(hr))
     {
         OUTPUT_D3D12_FAILED_RESULT(hr)
-        Log::Error("[D3D12] Failed to create buffer");
+        LOG_ERROR("[D3D12] Failed to create buffer");
         return nullptr;
     }
     
@@ -42,7 +42,7 @@ void WriteBufferData(ID3D12Resource* inBuffer, const void* inData, size_t inSize
 {
     if(inBuffer == nullptr)
     {
-        Log::Error("[D3D12] Invalid buffer");
+        LOG_ERROR("[D3D12] Invalid buffer");
         return;
     }
     uint8_t* mappedData = nullptr;
@@ -56,7 +56,7 @@ void ReadBackBufferData(ID3D12Resource* inBuffer, void* outData, size_t inSize,
 {
     if(inBuffer == nullptr)
     {
-        Log::Error("[D3D12] Invalid buffer");
+        LOG_ERROR("[D3D12] Invalid buffer");
         return;
     }
     uint8_t* mappedData = nullptr;
@@ -99,7 +99,7 @@ Microsoft::WRL::ComPtr<ID3D12Resource> CreateTextureHelper(ID3D12Device* inDevic
     if(FAILED(hr))
     {
         OUTPUT_D3D12_FAILED_RESULT(hr)
-        Log::Error("[D3D12] Failed to create texture");
+        LOG_ERROR("[D3D12] Failed to create texture");
         return nullptr;
     }
 
@@ -164,7 +164,7 @@ bool VariableRateShadingDx::CreateDepthStencilBuffer()
 
     if(m_DeviceHandle == nullptr)
     {
-        Log::Error("[D3D12] Failed to create depth stencil buffer");
+        LOG_ERROR("[D3D12] Failed to create depth stencil buffer");
         return false;
     }
 
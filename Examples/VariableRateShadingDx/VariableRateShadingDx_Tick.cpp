@@ -96,6 +96,6 @@ void VariableRateShadingDx::Tick()
     uint64_t time[2];
     ReadBackBufferData(m_TimestampQueryResult.Get(), time, sizeof(uint64_t) * 2, 0);
     // ReadBackBufferData(m_TimestampQueryResult.Get(), &endTime, sizeof(uint64_t), sizeof(uint64_t));
-    Log::Info("startTime: %lu, endTime: %lu, deltaTime: %lu", time[0], time[1], time[1] - time[0]);
+    LOG_INFO("startTime: %llu, endTime: %llu, deltaTime: %llu", static_cast<unsigned long long>(time[0]), static_cast<unsigned long long>(time[1]), static_cast<unsigned long long>(time[1] - time[0]));
     
 }
\ No newline at end of file
@@ -1,4 +1,4 @@
-#include "Passes\GraphicsPipelinePass.hlsl"
+#include "Passes/GraphicsPipelinePass.hlsl"
 
 VertexOutput main(VertexInput input, uint instanceID : SV_InstanceID)
 {
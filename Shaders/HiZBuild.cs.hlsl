@@ -0,0 +1,33 @@
+// One level of the Hi-Z pyramid per dispatch. Level 0 reads the depth buffer, every other level the level before.
+// Sizes are rounded up, the texels past the edge of the source repeat its last row and column, so each texel holds
+// the farthest depth of everything below it.
+struct HiZBuildConstants
+{
+    uint2 SrcSize;
+    uint2 DstSize;
+    uint  DstMip;
+};
+
+ConstantBuffer<HiZBuildConstants>   _Constants  : register(b0);
+Texture2D<float>                    _Depth      : register(t0);
+RWTexture2D<float>                  _HiZMips[]  : register(u0);
+
+float LoadSource(int2 pixel)
+{
+    pixel = min(pixel, int2(_Constants.SrcSize) - 1);
+    if(_Constants.DstMip == 0)
+        return _Depth.Load(int3(pixel, 0));
+    return _HiZMips[_Constants.DstMip - 1][pixel];
+}
+
+[numthreads(8, 8, 1)]
+void main(uint2 dispatchThreadID : SV_DispatchThreadID)
+{
+    if(any(dispatchThreadID >= _Constants.DstSize))
+        return;
+
+    int2 pixel = int2(dispatchThreadID) * 2;
+    float depth = max(max(LoadSource(pixel), LoadSource(pixel + int2(1, 0)))
+        , max(LoadSource(pixel + int2(0, 1)), LoadSource(pixel + int2(1, 1))));
+    _HiZMips[_Constants.DstMip][dispatchThreadID] = depth;
+}
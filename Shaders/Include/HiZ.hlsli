@@ -0,0 +1,51 @@
+#ifndef HIZ_HLSLI
+#define HIZ_HLSLI
+
+// Two phase occlusion culling against a Hi-Z pyramid built by HiZBuild.cs.hlsl, Common/HiZPyramid.cpp is the CPU
+// reference of the test. Phase 0 draws what was visible last frame, phase 1 tests everything against the pyramid of
+// the depth phase 0 left behind, remembers the result for the next frame and draws what phase 0 missed.
+struct HiZCullingConstants
+{
+    uint    Phase;
+    uint    HiZMipCount;
+    uint2   ScreenSize;     // of the depth buffer the pyramid was built from
+    uint    ObjectCount;
+};
+
+// False when the box is hidden behind the depth in the pyramid. Boxes crossing the near plane are visible, the
+// frustum test is left to the caller.
+bool IsBoxVisibleHiZ(Texture2D<float> hiZ, HiZCullingConstants constants, float4x4 localToClip, float3 boxMin, float3 boxMax)
+{
+    float2 minNdc = 1e30f;
+    float2 maxNdc = -1e30f;
+    float minZ = 1.0f;
+    for(uint i = 0; i < 8; ++i)
+    {
+        float3 corner = float3((i & 1) ? boxMax.x : boxMin.x, (i & 2) ? boxMax.y : boxMin.y, (i & 4) ? boxMax.z : boxMin.z);
+        float4 clip = mul(localToClip, float4(corner, 1.0f));
+        if(clip.w <= 1e-5f)
+            return true;
+        float3 ndc = clip.xyz / clip.w;
+        minNdc = min(minNdc, ndc.xy);
+        maxNdc = max(maxNdc, ndc.xy);
+        minZ = min(minZ, ndc.z);
+    }
+
+    // Pixels of the depth buffer, y points down
+    float2 minUv = saturate(float2(minNdc.x, -maxNdc.y) * 0.5f + 0.5f);
+    float2 maxUv = saturate(float2(maxNdc.x, -minNdc.y) * 0.5f + 0.5f);
+    int2 minPixel = int2(minUv * constants.ScreenSize);
+    int2 maxPixel = min(int2(maxUv * constants.ScreenSize), int2(constants.ScreenSize) - 1);
+
+    // The finest level where the rectangle covers at most 2x2 texels, texels of level L cover 2^(L + 1) pixels
+    uint level = 0;
+    while(level + 1 < constants.HiZMipCount && any((maxPixel >> (level + 1)) - (minPixel >> (level + 1)) > 1))
+        ++level;
+    int2 texelMin = minPixel >> (level + 1);
+    int2 texelMax = maxPixel >> (level + 1);
+    float maxDepth = max(max(hiZ.Load(int3(texelMin, level)), hiZ.Load(int3(texelMax.x, texelMin.y, level)))
+        , max(hiZ.Load(int3(texelMin.x, texelMax.y, level)), hiZ.Load(int3(texelMax, level))));
+    return minZ <= maxDepth;
+}
+
+#endif // HIZ_HLSLI
@@ -3,6 +3,8 @@
 
 #define AS_GROUP_SIZE 32
 #define MS_GROUP_SIZE 128
+#define INSTANCE_CULLING_GROUP_SIZE 64
+#define CLUSTER_ROOT_ERROR 3.402823466e+38f // ClusterDag::s_RootError, FLT_MAX
 
 struct MeshInfo
 {
@@ -10,6 +12,10 @@ struct MeshInfo
     uint IndexCount;
     uint MeshletCount;
     uint InstanceCount;
+    float LodErrorScale;    // half the target height over the pixel error threshold
+    uint Padding;           // keeps ViewportSize 8 byte aligned for the Vulkan layout
+    float2 ViewportSize;    // in pixels, for the small triangle test of the mesh shader
+    float4 BoundingSphere;  // of every level of the DAG, tested once per instance
 };
 
 struct Meshlet
@@ -23,6 +29,28 @@ struct Meshlet
 struct MeshletCullData
 {
     float4 BoundingSphere; // xyz = center, w = radius
+    float4 NormalCone;     // xyz = mean triangle normal, w = cosine of the cone half angle, 0 never culls
+};
+
+// Position of a cluster in the LOD DAG, see ClusterDag.h
+struct ClusterLod
+{
+    float4 LodSphere;       // bounds of the group the cluster was built from
+    float4 ParentSphere;    // bounds of the group the cluster was simplified in
+    float  LodError;
+    float  ParentError;     // CLUSTER_ROOT_ERROR for roots
+    uint   Level;
+    uint   Padding;
+};
+
+// Arguments of the indirect amplification shader dispatch, the group counts are the ones of DispatchMesh. The
+// instance pass resets them to (0, 1, 1) and no visible instance.
+struct TaskArguments
+{
+    uint GroupCountX;
+    uint GroupCountY;
+    uint GroupCountZ;
+    uint VisibleInstanceCount;
 };
 
 uint3 UnpackPrimitive(uint primitive)
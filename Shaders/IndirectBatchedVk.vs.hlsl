@@ -0,0 +1,19 @@
+#include "Passes/GraphicsPipelinePass.hlsl"
+
+// Instanced draws of the GPU batching pass: instance i of a bucket's draw is the i-th visible instance of the bucket
+StructuredBuffer<uint>                  _VisibleInstances : register(t2);
+
+VertexOutput main(VertexInput input, uint instanceID : SV_InstanceID)
+{
+    VertexOutput output;
+    // In SPIR-V SV_InstanceID is gl_InstanceIndex, it includes StartInstanceLocation: the start of the bucket in
+    // _VisibleInstances
+    InstanceData instanceData = _InstanceData[_VisibleInstances[instanceID]];
+    float3 posWS = TransformLocalToWorld(instanceData.Transform, input.Position);
+    float4 posHS = TransformWorldToClip(_CameraData, posWS);
+    output.Position = posHS;
+    output.TexCoord = input.TexCoord;
+    output.WorldNormal = TransformLocalToWorldNormal(instanceData.Transform, input.Normal);
+    output.MatIndex = instanceData.MatIndex;
+    return output;
+}
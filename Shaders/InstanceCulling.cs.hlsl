@@ -0,0 +1,38 @@
+#include "Passes/MeshPipelinePass.hlsl"
+
+RWStructuredBuffer<VisibleInstance> _VisibleInstancesOut    : register(u1);
+RWStructuredBuffer<TaskArguments>   _TaskArgumentsOut       : register(u2); // reset to (0, 1, 1) and no instance before the dispatch
+
+// First level of the mesh pipeline culling, one thread per instance. Instances whose DAG bounds are outside of the
+// frustum are dropped, the others take a slot of the compacted list with their view in the space of the mesh and grow
+// the amplification shader dispatch to cover their meshlets, so its thread count follows the visible instances only.
+// The meshlets of a dropped instance keep the occlusion result of the last frame it was in view, at worst phase 0
+// draws a few hidden ones the frame it comes back.
+[numthreads(INSTANCE_CULLING_GROUP_SIZE, 1, 1)]
+void main(uint dispatchThreadID : SV_DispatchThreadID)
+{
+    if(dispatchThreadID >= _MeshInfo.InstanceCount)
+        return;
+
+    InstanceData instanceData = _InstanceData[dispatchThreadID];
+    ViewFrustum viewFrustumLS;
+    for(uint i = 0; i < 8; ++i)
+    {
+        viewFrustumLS.Corners[i].xyz = TransformWorldToLocal(instanceData.Transform, _ViewFrustum.Corners[i].xyz);
+    }
+
+    VisibleInstance instance;
+    instance.Frustum = GetViewFrustumPlanes(viewFrustumLS);
+    if(!IsSphereInFrustum(instance.Frustum, _MeshInfo.BoundingSphere.xyz, _MeshInfo.BoundingSphere.w))
+        return;
+    instance.CameraPosition = TransformWorldToLocal(instanceData.Transform, _CameraData.Position);
+    instance.InstanceIndex = dispatchThreadID;
+
+    uint slot;
+    InterlockedAdd(_TaskArgumentsOut[0].VisibleInstanceCount, 1, slot);
+    _VisibleInstancesOut[slot] = instance;
+
+    // Slots are dense, the largest one sizes the dispatch to the meshlets of every visible instance
+    uint taskCount = (slot + 1) * _MeshInfo.MeshletCount;
+    InterlockedMax(_TaskArgumentsOut[0].GroupCountX, (taskCount + AS_GROUP_SIZE - 1) / AS_GROUP_SIZE);
+}
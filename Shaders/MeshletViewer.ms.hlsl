@@ -1,12 +1,15 @@
 #include "Passes/MeshPipelinePass.hlsl"
 
+groupshared float4 s_ClipPositions[MS_GROUP_SIZE];
+groupshared uint s_VisiblePrimCount;
+
 [NumThreads(MS_GROUP_SIZE, 1, 1)]
 [OutputTopology("triangle")]
 void main(
     uint gtid : SV_GroupThreadID,
     uint gid : SV_GroupID,
     in payload Payload payload,
-    out indices uint3 tris[68],
+    out indices uint3 tris[MS_GROUP_SIZE],
     out vertices VertexOutput verts[MS_GROUP_SIZE]
 )
 {
@@ -23,15 +26,39 @@ void main(
     InstanceData instanceData = _InstanceData[instanceIndex];
     Meshlet m = _Meshlets[meshletIndex];
     
-    SetMeshOutputCounts(m.VertCount, m.PrimCount);
-    
-    if(gtid < m.PrimCount)
+    if (gtid == 0)
+        s_VisiblePrimCount = 0;
+
+    VertexOutput vertex = (VertexOutput)0;
+    if (gtid < m.VertCount)
     {
-        tris[gtid] = GetPrimitive(m, gtid);
+        uint vertexIndex = GetVertexIndex(m, gtid);
+        vertex = GetVertexAttributes(instanceData.Transform, meshletIndex, vertexIndex);
+        s_ClipPositions[gtid] = vertex.Position;
     }
-    if(gtid < m.VertCount)
+    GroupMemoryBarrierWithGroupSync();
+
+    // Surviving primitives take the first slots, in any order
+    uint3 tri = uint3(0, 0, 0);
+    uint slot = 0;
+    bool visible = false;
+    if (gtid < m.PrimCount)
     {
-        uint vertexIndex = GetVertexIndex(m, gtid);
-        verts[gtid] = GetVertexAttributes(instanceData.Transform, meshletIndex, vertexIndex);
+        tri = GetPrimitive(m, gtid);
+        visible = !IsPrimitiveCulled(s_ClipPositions[tri.x], s_ClipPositions[tri.y], s_ClipPositions[tri.z]);
+        if (visible)
+            InterlockedAdd(s_VisiblePrimCount, 1, slot);
+    }
+    GroupMemoryBarrierWithGroupSync();
+
+    SetMeshOutputCounts(m.VertCount, s_VisiblePrimCount);
+
+    if (visible)
+    {
+        tris[slot] = tri;
+    }
+    if (gtid < m.VertCount)
+    {
+        verts[gtid] = vertex;
     }
-}
+}
\ No newline at end of file
@@ -0,0 +1,37 @@
+#include "Include/CameraData.hlsli"
+
+// Bounding box of an occlusion query group, drawn without a vertex buffer as 12 triangles
+struct ProxyBox
+{
+    float3 Min;
+    float  Padding0;
+    float3 Max;
+    float  Padding1;
+};
+
+ConstantBuffer<CameraData>  _CameraData : register(b0);
+#ifdef SPIRV
+[[vk::push_constant]] ProxyBox _Box;
+#else
+ConstantBuffer<ProxyBox>    _Box        : register(b1);
+#endif
+
+// Corner i of the box takes Max on the axes of its set bits x = 1, y = 2, z = 4
+static const uint s_CubeIndices[36] =
+{
+    0, 2, 1,  1, 2, 3,      // -z
+    4, 5, 6,  5, 7, 6,      // +z
+    0, 1, 4,  1, 5, 4,      // -y
+    2, 6, 3,  3, 6, 7,      // +y
+    0, 4, 2,  2, 4, 6,      // -x
+    1, 3, 5,  3, 7, 5,      // +x
+};
+
+float4 main(uint vertexID : SV_VertexID) : SV_POSITION
+{
+    uint corner = s_CubeIndices[vertexID];
+    float3 posWS = float3((corner & 1) ? _Box.Max.x : _Box.Min.x
+        , (corner & 2) ? _Box.Max.y : _Box.Min.y
+        , (corner & 4) ? _Box.Max.z : _Box.Min.z);
+    return TransformWorldToClip(_CameraData, posWS);
+}
@@ -4,6 +4,7 @@
 #include "../Include/Meshlet.hlsli"
 #include "../Include/CameraData.hlsli"
 #include "../Include/TransformData.hlsli"
+#include "../Include/HiZ.hlsli"
 
 struct Payload
 {
@@ -22,6 +23,15 @@ struct InstanceData
     TransformData	Transform;
 };
 
+// An instance the instance pass kept, with the view already in the space of its mesh so the meshlet tasks of the
+// amplification shader do not transform it again
+struct VisibleInstance
+{
+    ViewFrustumPlane Frustum;
+    float3           CameraPosition;
+    uint             InstanceIndex;
+};
+
 ConstantBuffer<CameraData>          _CameraData             : register(b0);
 ConstantBuffer<ViewFrustum>         _ViewFrustum            : register(b1);
 ConstantBuffer<MeshInfo>            _MeshInfo               : register(b2);
@@ -36,22 +46,69 @@ StructuredBuffer<MeshletCullData>	_MeshletCullData	    : register(t5);
 
 // Instance data
 StructuredBuffer<InstanceData>		_InstanceData	        : register(t6);
+StructuredBuffer<ClusterLod>        _ClusterLods            : register(t8);
+StructuredBuffer<VisibleInstance>   _VisibleInstances       : register(t9);     // written by InstanceCulling.cs.hlsl
+StructuredBuffer<TaskArguments>     _TaskArguments          : register(t10);
 
-bool InstancedMeshletIsVisible(uint instanceIndex, uint meshletIndex, ViewFrustum viewFrustumWS)
+// Occlusion culling, the Vulkan mesh pipeline only culls against the frustum so far
+#ifndef SPIRV
+ConstantBuffer<HiZCullingConstants> _CullingConstants       : register(b3);
+Texture2D<float>                    _HiZ                    : register(t7);
+RWStructuredBuffer<uint>            _MeshletVisibility      : register(u0); // per instanced meshlet, non zero when visible last frame
+#endif
+
+bool InstancedMeshletIsVisible(VisibleInstance instance, uint meshletIndex)
 {
-    InstanceData instanceData = _InstanceData[instanceIndex];
     MeshletCullData cullDataInstance = _MeshletCullData[meshletIndex];
+    return IsSphereInFrustum(instance.Frustum, cullDataInstance.BoundingSphere.xyz, cullDataInstance.BoundingSphere.w);
+}
 
-    ViewFrustum viewFrustumLS;
-    for(uint i = 0; i < 8; ++i)
-    {
-        viewFrustumLS.Corners[i].xyz = TransformWorldToLocal(instanceData.Transform, viewFrustumWS.Corners[i].xyz);
-    }
+// Same test as ClusterDag::IsBackFacing. Facing is a plane side test, so the camera in the space of the mesh gives
+// the same answer as in world space whatever the scale of the instance.
+bool InstancedMeshletIsBackFacing(VisibleInstance instance, uint meshletIndex)
+{
+    MeshletCullData cullData = _MeshletCullData[meshletIndex];
+    float3 offset = cullData.BoundingSphere.xyz - instance.CameraPosition;
+    float distance = length(offset);
+    if (cullData.NormalCone.w <= 0.0f || distance <= cullData.BoundingSphere.w)
+        return false;
+    float cosCenter = dot(offset, cullData.NormalCone.xyz) / distance;
+    float sinCenter = sqrt(saturate(1.0f - cosCenter * cosCenter));
+    float sinCone = sqrt(saturate(1.0f - cullData.NormalCone.w * cullData.NormalCone.w));
+    return distance * (cosCenter * cullData.NormalCone.w - sinCenter * sinCone) > cullData.BoundingSphere.w;
+}
 
-    ViewFrustumPlane planes = GetViewFrustumPlanes(viewFrustumLS);
-    return IsSphereInFrustum(planes, cullDataInstance.BoundingSphere.xyz, cullDataInstance.BoundingSphere.w);
+// Pixels the error of a sphere of the DAG covers at its closest point, in the space of the mesh where the distance and
+// the error scale alike
+float ProjectClusterError(float4 sphere, float error, float3 cameraPositionLS)
+{
+    if (error == 0.0f)
+        return 0.0f;
+    if (error == CLUSTER_ROOT_ERROR)
+        return CLUSTER_ROOT_ERROR;
+    float distance = length(sphere.xyz - cameraPositionLS) - sphere.w;
+    return distance > 0.0f ? error * _MeshInfo.LodErrorScale * _CameraData.Projection[1][1] / distance : CLUSTER_ROOT_ERROR;
 }
 
+// Each cluster decides alone, parents always project a larger error than their children so exactly one cluster of
+// every path of the DAG is drawn
+bool InstancedMeshletIsInCut(VisibleInstance instance, uint meshletIndex)
+{
+    ClusterLod lod = _ClusterLods[meshletIndex];
+    return ProjectClusterError(lod.LodSphere, lod.LodError, instance.CameraPosition) <= 1.0f
+        && ProjectClusterError(lod.ParentSphere, lod.ParentError, instance.CameraPosition) > 1.0f;
+}
+
+#ifndef SPIRV
+// The bounding sphere is tested as the box around it
+bool InstancedMeshletIsUnoccluded(uint instanceIndex, uint meshletIndex)
+{
+    float4 sphere = _MeshletCullData[meshletIndex].BoundingSphere;
+    float4x4 localToClip = mul(_CameraData.ViewProjection, _InstanceData[instanceIndex].Transform.LocalToWorld);
+    return IsBoxVisibleHiZ(_HiZ, _CullingConstants, localToClip, sphere.xyz - sphere.w, sphere.xyz + sphere.w);
+}
+#endif
+
 uint3 GetPrimitive(Meshlet m, uint localIndex)
 {
     return UnpackPrimitive(_PackedPrimitiveIndices[m.PrimOffset + localIndex]);
@@ -64,6 +121,28 @@ uint GetVertexIndex(Meshlet m, uint localIndex)
     return index;
 }
 
+// Triangles the rasterizer would drop anyway: facing away, of zero area, or with bounds that fall between pixel
+// centers on one axis. Triangles crossing the camera plane are kept, their projection is not a triangle.
+// ClusterDagBench runs the same tests on the CPU.
+bool IsPrimitiveCulled(float4 clipA, float4 clipB, float4 clipC)
+{
+    if (clipA.w <= 0.0f || clipB.w <= 0.0f || clipC.w <= 0.0f)
+        return false;
+    float2 a = (clipA.xy / clipA.w * 0.5f + 0.5f) * _MeshInfo.ViewportSize;
+    float2 b = (clipB.xy / clipB.w * 0.5f + 0.5f) * _MeshInfo.ViewportSize;
+    float2 c = (clipC.xy / clipC.w * 0.5f + 0.5f) * _MeshInfo.ViewportSize;
+
+    // Front faces wind clockwise with y up, the side ClusterDag::IsBackFacing treats as facing the camera
+    float area = (b.x - a.x) * (c.y - a.y) - (b.y - a.y) * (c.x - a.x);
+    if (area >= 0.0f)
+        return true;
+
+    // Pixel centers are at half integers, bounds that round to the same integer hold none of them
+    float2 boundsMin = min(a, min(b, c));
+    float2 boundsMax = max(a, max(b, c));
+    return any(round(boundsMin) == round(boundsMax));
+}
+
 VertexOutput GetVertexAttributes(TransformData transform, uint meshletIndex, uint vertexIndex)
 {
     VertexOutput output;
@@ -1,4 +1,4 @@
-#include "Passes\RayTracingPass.hlsl"
+#include "Passes/RayTracingPass.hlsl"
 
 [shader("closesthit")]
 void ClosestHitTriangle(inout Payload payload, in TrianglePrimitiveAttributes attribs)
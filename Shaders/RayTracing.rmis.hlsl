@@ -1,4 +1,4 @@
-#include "Passes\RayTracingPass.hlsl"
+#include "Passes/RayTracingPass.hlsl"
 
 [shader("miss")]
 void RayMiss(inout Payload p)
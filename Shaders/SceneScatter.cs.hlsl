@@ -0,0 +1,21 @@
+#define SCENE_SCATTER_GROUP_SIZE 64 // GpuScene::s_ScatterGroupSize
+
+// Written by GpuScene::GatherUpdates: update count, record size in words, the slot of every update then the records
+StructuredBuffer<uint>      _SceneUpdates   : register(t11);
+RWStructuredBuffer<uint>    _SceneRecords   : register(u3);
+
+// Copies the changed records of a GPU scene into their slots of the persistent record buffer, one thread per word so
+// consecutive threads write consecutive words of a record
+[numthreads(SCENE_SCATTER_GROUP_SIZE, 1, 1)]
+void main(uint dispatchThreadID : SV_DispatchThreadID)
+{
+    uint updateCount = _SceneUpdates[0];
+    uint recordWords = _SceneUpdates[1];
+    uint update = dispatchThreadID / recordWords;
+    if (update >= updateCount)
+        return;
+
+    uint slot = _SceneUpdates[2 + update];
+    uint word = dispatchThreadID % recordWords;
+    _SceneRecords[slot * recordWords + word] = _SceneUpdates[2 + updateCount + dispatchThreadID];
+}
@@ -6,20 +6,41 @@ groupshared Payload s_Payload;
 void main(uint groupId : SV_GroupID, uint groupThreadID : SV_GroupThreadID, uint dispatchThreadID : SV_DispatchThreadID)
 {
     bool visible = false;
+    uint instancedMeshletIndex = 0;
 
-    // Check bounds of meshlet cull data resource
-    if(dispatchThreadID < _MeshInfo.MeshletCount * _MeshInfo.InstanceCount)
+    // The dispatch only covers the meshlets of the instances InstanceCulling.cs.hlsl kept, a thread finds its instance
+    // from the slot of the compacted list it falls in
+    if(dispatchThreadID < _TaskArguments[0].VisibleInstanceCount * _MeshInfo.MeshletCount)
     {
-        uint instanceIndex = dispatchThreadID / _MeshInfo.MeshletCount;
+        VisibleInstance instance = _VisibleInstances[dispatchThreadID / _MeshInfo.MeshletCount];
         uint meshletIndex = dispatchThreadID % _MeshInfo.MeshletCount;
-        visible = InstancedMeshletIsVisible(instanceIndex, meshletIndex, _ViewFrustum);  
+        instancedMeshletIndex = instance.InstanceIndex * _MeshInfo.MeshletCount + meshletIndex;
+        bool inFrustum = InstancedMeshletIsInCut(instance, meshletIndex)
+            && InstancedMeshletIsVisible(instance, meshletIndex)
+            && !InstancedMeshletIsBackFacing(instance, meshletIndex);
+#ifdef SPIRV
+        visible = inFrustum;
+#else
+        bool wasVisible = _MeshletVisibility[instancedMeshletIndex] != 0;
+        if(_CullingConstants.Phase == 0)
+        {
+            visible = inFrustum && wasVisible;
+        }
+        else
+        {
+            // Phase 0 drew the meshlets that stayed visible, only the newly visible ones are left
+            bool unoccluded = inFrustum && InstancedMeshletIsUnoccluded(instance.InstanceIndex, meshletIndex);
+            _MeshletVisibility[instancedMeshletIndex] = unoccluded ? 1 : 0;
+            visible = unoccluded && !wasVisible;
+        }
+#endif
     }
 
     // Compact visible meshlets into the export payload array
     if (visible)
     {
         uint index = WavePrefixCountBits(visible);
-        s_Payload.InstancedMeshletIndices[index] = dispatchThreadID;
+        s_Payload.InstancedMeshletIndices[index] = instancedMeshletIndex;
     }
     
     // Dispatch the required number of MS threadgroups to render the visible meshlets
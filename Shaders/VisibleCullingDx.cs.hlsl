@@ -1,5 +1,6 @@
 #include "Include/CameraData.hlsli"
 #include "Include/TransformData.hlsli"
+#include "Include/HiZ.hlsli"
 
 struct InstanceData
 {
@@ -29,15 +30,18 @@ struct IndirectCommand
 
 ConstantBuffer<CameraData>              _CameraData     : register(b0);
 ConstantBuffer<ViewFrustum>             _ViewFrustum    : register(b1);
+ConstantBuffer<HiZCullingConstants>     _CullingConstants : register(b2);
 StructuredBuffer<InstanceData>          _InstancesData  : register(t0);
 StructuredBuffer<IndirectCommand>       _InputCommands  : register(t1);    //  All indirect draw commands
+Texture2D<float>                        _HiZ            : register(t2);
 AppendStructuredBuffer<IndirectCommand> _OutputCommands : register(u0);      // Remaining indirect commands and its count
+RWStructuredBuffer<uint>                _Visibility     : register(u1);      // per instance, non zero when visible last frame
 
 [numthreads(128, 1, 1)]
 void main(uint groupId : SV_GroupID, uint groupThreadID : SV_GroupThreadID)
 {
     uint index = groupId * 128 + groupThreadID;
-    if (index >= 4096)
+    if (index >= _CullingConstants.ObjectCount)
         return;
 
     IndirectCommand cmd = _InputCommands[index];
@@ -48,8 +52,22 @@ void main(uint groupId : SV_GroupID, uint groupThreadID : SV_GroupThreadID)
         viewFrustumLS.Corners[i].xyz = TransformWorldToLocal(instanceData.Transform, _ViewFrustum.Corners[i].xyz);
     }
     ViewFrustumPlane planes = GetViewFrustumPlanes(viewFrustumLS);
-    if (IsAABBInFrustum(planes, instanceData.Min, instanceData.Max))
+    bool inFrustum = IsAABBInFrustum(planes, instanceData.Min, instanceData.Max);
+    bool wasVisible = _Visibility[index] != 0;
+    if (_CullingConstants.Phase == 0)
     {
-        _OutputCommands.Append(cmd);
+        if (inFrustum && wasVisible)
+            _OutputCommands.Append(cmd);
+        return;
+    }
+
+    bool visible = false;
+    if (inFrustum)
+    {
+        float4x4 localToClip = mul(_CameraData.ViewProjection, instanceData.Transform.LocalToWorld);
+        visible = IsBoxVisibleHiZ(_HiZ, _CullingConstants, localToClip, instanceData.Min, instanceData.Max);
     }
+    _Visibility[index] = visible ? 1 : 0;
+    if (visible && !wasVisible)
+        _OutputCommands.Append(cmd);
 }
\ No newline at end of file
@@ -2,6 +2,8 @@
 #include "Include/TransformData.hlsli"
 #include "Include/Common.hlsli"
 
+#define MAX_DRAW_BUCKETS 16
+
 struct AABB
 {
     float4 Min;
@@ -12,8 +14,8 @@ struct InstanceData
 {
     TransformData	Transform;
     uint			MatIndex;
-    uint			Padding0;
-    uint			Padding1;
+    uint			DrawBucket;     // index of the draw command of its (mesh, pipeline) pair, of its finest LOD
+    uint			LodCount;       // buckets from DrawBucket on, one per LOD of the mesh
     uint			Padding2;
 };
 
@@ -21,24 +23,112 @@ ConstantBuffer<CameraData>                          _CameraData     : register(b
 ConstantBuffer<ViewFrustum>                         _ViewFrustum    : register(b1);
 ConstantBuffer<AABB>                                _AABB           : register(b2);
 StructuredBuffer<InstanceData>                      _InstancesData  : register(t0);
-RWStructuredBuffer<IndexedIndirectDrawCommand>     _IndirectCommands : register(u0); //  All indirect draw commands
+StructuredBuffer<IndexedIndirectDrawCommand>        _InputCommands  : register(t1); //  One per bucket, InstanceCount is 0
+StructuredBuffer<uint>                              _DrawOrder      : register(t2); //  Instance indices sorted by draw key
+StructuredBuffer<float>                             _LodErrors      : register(t3); //  Per bucket, object space error over the pixel threshold
+globallycoherent RWStructuredBuffer<IndexedIndirectDrawCommand> _BucketCommands : register(u0); //  Copied from _InputCommands before the dispatch
+RWStructuredBuffer<uint>                            _VisibleInstances : register(u1); //  Bucket b owns [StartInstanceLocation, + its instance count)
+RWStructuredBuffer<IndexedIndirectDrawCommand>      _DrawCommands   : register(u2); //  Non-empty buckets packed at the front, then the empty ones
+globallycoherent RWStructuredBuffer<uint>           _DrawCount      : register(u3); //  [0] draws, [1] finished groups, cleared before the dispatch
+
+groupshared uint s_BucketCounts[MAX_DRAW_BUCKETS];
+groupshared uint s_BucketFirstSlots[MAX_DRAW_BUCKETS];
+groupshared bool s_IsLastGroup;
+
+// Coarsest LOD whose error, projected at the closest point of the bounding sphere, stays under the pixel threshold
+uint SelectLod(InstanceData instanceData)
+{
+    float3 centerWS = TransformLocalToWorld(instanceData.Transform, (_AABB.Min.xyz + _AABB.Max.xyz) * 0.5f);
+    float3x3 localToWorld = (float3x3)instanceData.Transform.LocalToWorld;
+    float scale = sqrt(max(dot(localToWorld._11_21_31, localToWorld._11_21_31)
+        , max(dot(localToWorld._12_22_32, localToWorld._12_22_32), dot(localToWorld._13_23_33, localToWorld._13_23_33))));
+    float radius = length(_AABB.Max.xyz - _AABB.Min.xyz) * 0.5f * scale;
+    float depth = mul(_CameraData.View, float4(centerWS, 1.0f)).z - radius;
+    if (depth <= 0.0f)
+        return 0;
+
+    uint lod = 0;
+    for (uint l = 1; l < instanceData.LodCount; ++l)
+    {
+        if (_LodErrors[instanceData.DrawBucket + l] * scale * _CameraData.Projection[1][1] / depth <= 1.0f)
+            lod = l;
+    }
+    return lod;
+}
 
 [numthreads(128, 1, 1)]
 void main(uint groupId : SV_GroupID, uint groupThreadID : SV_GroupThreadID)
 {
-    uint index = groupId * 128 + groupThreadID;
-    if (index >= 4096)
-        return;
-    
-    InstanceData instanceData = _InstancesData[index];
-    ViewFrustum viewFrustumLS;
-    for(uint i = 0; i < 8; ++i)
+    uint bucketCount;
+    uint stride;
+    _InputCommands.GetDimensions(bucketCount, stride);
+    bucketCount = min(bucketCount, MAX_DRAW_BUCKETS);
+    if (groupThreadID < bucketCount)
+        s_BucketCounts[groupThreadID] = 0;
+    GroupMemoryBarrierWithGroupSync();
+
+    uint instanceCount;
+    _InstancesData.GetDimensions(instanceCount, stride);
+    // Threads visit the instances in draw key order, the visible ones keep it up to the order of the groups and of the
+    // slots within a group
+    uint drawIndex = groupId * 128 + groupThreadID;
+    uint index = 0;
+    bool visible = false;
+    uint bucket = 0;
+    if (drawIndex < instanceCount)
     {
-        viewFrustumLS.Corners[i].xyz = TransformWorldToLocal(instanceData.Transform, _ViewFrustum.Corners[i].xyz);
+        index = _DrawOrder[drawIndex];
+        InstanceData instanceData = _InstancesData[index];
+        ViewFrustum viewFrustumLS;
+        for(uint i = 0; i < 8; ++i)
+        {
+            viewFrustumLS.Corners[i].xyz = TransformWorldToLocal(instanceData.Transform, _ViewFrustum.Corners[i].xyz);
+        }
+        ViewFrustumPlane planes = GetViewFrustumPlanes(viewFrustumLS);
+        visible = IsAABBInFrustum(planes, _AABB.Min.xyz, _AABB.Max.xyz);
+        bucket = instanceData.DrawBucket;
+        if (visible && instanceData.LodCount > 1)
+            bucket += SelectLod(instanceData);
+        // Buckets past MAX_DRAW_BUCKETS have no group counter, their instances are not drawn
+        visible = visible && bucket < bucketCount;
     }
-    ViewFrustumPlane planes = GetViewFrustumPlanes(viewFrustumLS);
-    if (!IsAABBInFrustum(planes, _AABB.Min.xyz, _AABB.Max.xyz))
+
+    // Visible instances take a slot in the group's share of their bucket, then one atomic per bucket and group adds
+    // that share to the instance count of the bucket's draw
+    uint groupSlot = 0;
+    if (visible)
+        InterlockedAdd(s_BucketCounts[bucket], 1, groupSlot);
+    GroupMemoryBarrierWithGroupSync();
+    if (groupThreadID < bucketCount && s_BucketCounts[groupThreadID] > 0)
+        InterlockedAdd(_BucketCommands[groupThreadID].InstanceCount, s_BucketCounts[groupThreadID], s_BucketFirstSlots[groupThreadID]);
+
+    // The group that finishes last sees the final instance counts and packs the non-empty buckets behind the draw count
+    DeviceMemoryBarrierWithGroupSync();
+    if (groupThreadID == 0)
+    {
+        uint groupCount = (instanceCount + 127) / 128;
+        uint finishedGroups;
+        InterlockedAdd(_DrawCount[1], 1, finishedGroups);
+        s_IsLastGroup = finishedGroups + 1 == groupCount;
+    }
+    GroupMemoryBarrierWithGroupSync();
+
+    if (visible)
+        _VisibleInstances[_InputCommands[bucket].StartInstanceLocation + s_BucketFirstSlots[bucket] + groupSlot] = index;
+
+    // The empty buckets follow the packed ones, so drawing every bucket without the count stays correct
+    if (s_IsLastGroup && groupThreadID == 0)
     {
-        _IndirectCommands[index].InstanceCount = 0;
+        uint drawCount = 0;
+        uint emptyCount = 0;
+        for (uint b = 0; b < bucketCount; ++b)
+        {
+            IndexedIndirectDrawCommand command = _BucketCommands[b];
+            if (command.InstanceCount > 0)
+                _DrawCommands[drawCount++] = command;
+            else
+                _DrawCommands[bucketCount - ++emptyCount] = command;
+        }
+        _DrawCount[0] = drawCount;
     }
-}
\ No newline at end of file
+}